@@ -0,0 +1,95 @@
+#ifndef CAMERA_CONFIG_H
+#define CAMERA_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rcl/rcl.h>
+
+// Runtime camera settings
+//
+// Defaults come from the CAMERA_* defines in camera_node.h. They can be
+// overridden by ROS parameters (--ros-args -p width:=1280 or a params
+// file) and then by plain command-line flags (--width 1280), so a node
+// started from a launch file can still be tweaked by hand.
+//
+// Parameters / flags:
+//   source  / --source   Where frames come from: v4l2, file or synthetic
+//   device  / --device   V4L2 device path
+//   devices / --devices  Comma-separated cameras for one node: V4L2 devices,
+//                        files for source file, any names for synthetic
+//   sync_ms / --sync-ms  Group frames of all cameras captured within this
+//                        many ms of each other into sets, 0 = off
+//   file    / --file     Raw, Y4M or MJPEG recording for source file
+//   replay  / --replay   File/synthetic pacing: realtime (at fps) or fast
+//   frames  / --frames   Stop after this many frames, 0 = never
+//   record  / --record   Also write captured frames to this file (frame_record.h)
+//   width   / --width    Requested frame width
+//   height  / --height   Requested frame height
+//   fps     / --fps      Requested frame rate
+//   format  / --format   Pixel format name (see camera_format_t) or "auto"
+//   jpeg_quality   / --jpeg-quality    Quality of /camera/image_raw/compressed (1-100)
+//   compressed_fps / --compressed-fps  Max rate of /camera/image_raw/compressed
+
+#define CAMERA_CONFIG_DEVICE_MAX 256
+#define CAMERA_CONFIG_MAX_CAMERAS 4  // Entries in devices
+
+typedef enum {
+    CAMERA_SOURCE_V4L2 = 0,     // Camera device
+    CAMERA_SOURCE_FILE,         // Recording replayed from a mapped file
+    CAMERA_SOURCE_SYNTHETIC     // Generated test pattern
+} camera_source_t;
+
+typedef struct {
+    camera_source_t source;
+    char device[CAMERA_CONFIG_DEVICE_MAX];
+    char devices[CAMERA_CONFIG_DEVICE_MAX]; // Multi-camera list, empty = device only
+    uint32_t sync_ms;           // Frame set tolerance, 0 = no sets
+    char file[CAMERA_CONFIG_DEVICE_MAX];
+    bool realtime;              // File/synthetic frames at fps, else as fast as consumed
+    uint32_t max_frames;        // 0 = unlimited
+    char record[CAMERA_CONFIG_DEVICE_MAX]; // Recording path, empty = off
+    uint32_t width;
+    uint32_t height;
+    uint32_t fps;
+    uint32_t pixel_format;      // V4L2 fourcc, 0 = pick automatically
+    uint32_t jpeg_quality;
+    uint32_t compressed_fps;
+} camera_config_t;
+
+// Capture formats the camera node knows about
+typedef struct {
+    uint32_t fourcc;            // V4L2_PIX_FMT_*
+    const char* name;           // Parameter / flag value
+    const char* encoding;       // sensor_msgs/Image encoding, NULL if compressed
+} camera_format_t;
+
+void camera_config_init(camera_config_t* config, const char* device,
+                        uint32_t width, uint32_t height, uint32_t fps,
+                        uint32_t jpeg_quality, uint32_t compressed_fps);
+
+// Apply ROS parameter overrides for node_name (and the /** wildcard)
+int camera_config_load_params(camera_config_t* config, const rcl_arguments_t* arguments,
+                              const char* node_name);
+
+// Apply --flag value pairs; arguments inside --ros-args ... -- are skipped
+int camera_config_parse_args(camera_config_t* config, int argc, char* argv[]);
+
+void camera_config_log(const camera_config_t* config);
+
+// One config per entry of devices: the entry becomes device (or file for
+// the file source) and a recording path gets a .<index> suffix. Returns
+// the number of cameras, 1 (a copy of config) without a list, -1 if the
+// list is malformed or longer than max_cameras.
+int camera_config_split(const camera_config_t* config, camera_config_t* cameras, int max_cameras);
+
+// Format table lookups, NULL if unknown
+const camera_format_t* camera_format_find(uint32_t fourcc);
+const camera_format_t* camera_format_find_by_name(const char* name);
+
+// Printable fourcc ("YUYV"), buf must hold 5 bytes
+const char* camera_fourcc_str(uint32_t fourcc, char* buf);
+
+const char* camera_source_name(camera_source_t source);
+
+#endif // CAMERA_CONFIG_H
@@ -4,57 +4,196 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-// V4L2 includes
-#include <linux/videodev2.h>
-#include <sys/ioctl.h>
-#include <fcntl.h>
+// System includes
 #include <unistd.h>
-#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
 
 // ROS2 includes
 #include <rcl/rcl.h>
 #include <sensor_msgs/msg/image.h>
+#include <sensor_msgs/msg/compressed_image.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
 
-// Camera configuration
+#include "camera_config/camera_config.h"
+#include "frame_pool/frame_pool.h"
+#include "frame_queue/frame_queue.h"
+#include "frame_record/frame_record.h"
+#include "frame_ring/frame_ring.h"
+#include "frame_source/frame_source.h"
+#include "image_message/image_message.h"
+#include "jpeg_encoder/jpeg_encode_pool.h"
+#include "latency_diagnostics/latency_diagnostics.h"
+#include "mjpeg_decoder/mjpeg_decoder.h"
+#include "motion_gate/motion_gate.h"
+
+// Camera configuration (device, size, rate and format are defaults that
+// ROS parameters and command-line flags override, see camera_config.h;
+// the V4L2 buffer count is FRAME_SOURCE_V4L2_BUFFERS in frame_source.h)
 #define CAMERA_DEVICE "/dev/video0"
+#define CAMERA_FRAME_ID "camera"     // header.frame_id of everything published ("camera<N>" per camera)
+#define CAMERA_IMAGE_TOPIC "/camera/image_raw"
 #define CAMERA_WIDTH 640
 #define CAMERA_HEIGHT 480
 #define CAMERA_FPS 30
-#define CAMERA_BUFFER_COUNT 4
+#define CAMERA_WAIT_TIMEOUT_MS 2000  // Warn if the source delivers nothing for this long
+#define CAMERA_STATS_INTERVAL 300    // Log copy statistics every N published frames
+#define CAMERA_USE_FRAME_RING 1      // Share frames with local consumers via shared memory
+#define CAMERA_FRAME_RING_NAME "/camera_frames"
+#define CAMERA_FRAME_RING_SLOTS 8
+#define CAMERA_DESCRIPTOR_TOPIC "/camera/frame_descriptor"
+#define CAMERA_QUEUE_DEPTH 3         // Frames buffered between capture and publish threads
+#define CAMERA_QUEUE_POLICY FRAME_QUEUE_DROP_OLDEST // Or FRAME_QUEUE_DROP_NEWEST; unpaced sources wait
+#define CAMERA_MJPEG_OUTPUT MJPEG_OUTPUT_YUYV // What MJPEG frames are decoded to
+#define CAMERA_MJPEG_SCALE 1         // Decode MJPEG at 1/1, 1/2, 1/4 or 1/8 size
+#define CAMERA_COMPRESSED_TOPIC "/camera/image_raw/compressed"
+#define CAMERA_JPEG_QUALITY 80       // Default for the compressed topic
+#define CAMERA_COMPRESSED_FPS 15     // Default max rate of the compressed topic
+#define CAMERA_JPEG_THREADS 2        // Encoder threads for the compressed topic
+#define CAMERA_MOTION_GATE 1         // Mark still frames and dirty regions in frame descriptors
+#define CAMERA_MOTION_DECIMATION 2   // Motion gate reads every Nth luma sample and row (1, 2, 4)
+#define CAMERA_RECORD_QUEUE_DEPTH 16 // Captured frames that can wait for the disk when recording
+#define CAMERA_POOL_FRAMES 8         // Frames in flight to in-process sinks (composed pipeline)
+#define CAMERA_MAX_SINKS 2           // In-process consumers per camera
+#define CAMERA_NAME_MAX 64           // Topic, ring and frame_id buffers
 
-// Camera buffer structure
+// Geometry of the frames camera_node publishes: the capture mode itself
+// for raw formats, the decoder's output for MJPEG
 typedef struct {
-    void* start;
-    size_t length;
-} camera_buffer_t;
+    const char* encoding;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    size_t size;                // Max bytes per frame
+} camera_output_t;
+
+// In-process consumer of published frames, called on the publish thread.
+// The frame is only valid during the call unless the sink takes its own
+// reference with frame_pool_ref.
+typedef void (*camera_frame_sink_t)(void* ctx, frame_pool_frame_t* frame);
 
-// Camera node structure
+// Camera node structure: one camera, on its own (camera_node_init) or as
+// one of several in a multi-camera node (camera_rig.h)
 typedef struct {
-    int fd;                     // V4L2 device file descriptor
-    camera_buffer_t* buffers;   // Mapped buffers
-    int buffer_count;           // Number of buffers
-    bool is_streaming;          // Streaming state
+    int index;                  // Camera number in a multi-camera node, -1 alone
+    char frame_id[CAMERA_NAME_MAX];
+    char image_topic[CAMERA_NAME_MAX];
+    char descriptor_topic[CAMERA_NAME_MAX];
+    char compressed_topic[CAMERA_NAME_MAX];
+    char ring_name[CAMERA_NAME_MAX];
     
-    // ROS2 components
-    rcl_node_t node;
+    frame_source_t source;      // V4L2 device, file replay or test pattern
+    bool source_ready;
+    int epoll_fd;               // Capture thread: source fd (or queue space) + shutdown eventfd
+    int publish_epoll_fd;       // Publish thread: capture queue eventfd + shutdown eventfd
+    int shutdown_fd;            // eventfd signalled on SIGINT/SIGTERM
+    camera_config_t config;     // Requested settings
+    camera_output_t output;     // Published frames (source.mode is what is captured)
+    
+    // ROS2 components; several cameras share their node's
+    rcl_node_t* node;
+    rcl_node_t own_node;
     rcl_publisher_t publisher;
     rcl_wait_set_t wait_set;
     
     // Image message
     sensor_msgs__msg__Image* image_msg;
+    
+    // Shared-memory frame ring for same-host consumers
+    bool use_frame_ring;
+    frame_ring_t frame_ring;
+    rcl_publisher_t descriptor_publisher;
+    embedded_object_detection_pi5__msg__FrameDescriptor* descriptor_msg;
+    
+    // Motion gate over YUYV frames shared through the ring: descriptors
+    // say whether a frame is still and which region changed
+    bool use_motion_gate;
+    motion_gate_t motion_gate;
+    uint64_t still_frames;
+    
+    // Capture thread: only dequeues, copies into capture_queue and requeues,
+    // so a slow publish never holds on to driver buffers. Mapped sources
+    // queue pointers instead of copies.
+    frame_queue_t capture_queue;
+    bool capture_queue_ready;
+    pthread_t capture_thread;
+    int capture_result;         // -1 if the capture thread stopped on an error
+    bool capture_finished;      // Stopped after config.max_frames
+    uint64_t frames_captured;   // Written by the capture thread only
+    int64_t first_capture_ns;   // Throughput is measured from here
+    
+    // MJPEG decode stage, run on the publish thread so the capture queue
+    // only ever holds compressed frames
+    bool decode_mjpeg;
+    mjpeg_decoder_t decoder;
+    uint8_t* decode_buffer;     // output.size bytes
+    
+    // JPEG topic for remote viewers and bags. Encoding runs on its own
+    // threads and only while someone subscribes; a busy encoder drops
+    // frames instead of holding up the publish thread
+    bool use_compressed;
+    bool jpeg_passthrough;      // Camera delivers MJPEG: publish its bytes as is
+    rcl_publisher_t compressed_publisher;
+    sensor_msgs__msg__CompressedImage* compressed_msg;
+    pthread_mutex_t compressed_lock; // Encoder threads publish one at a time
+    jpeg_encode_pool_t encode_pool;
+    bool encode_pool_ready;
+    int64_t compressed_last_ns; // Capture stamp of the last frame sent for encoding
+    uint64_t compressed_last_sequence;
+    uint64_t compressed_published;
+    uint64_t compressed_stale;  // Finished after a newer frame and dropped
+    
+    // Publishing path. sensor_msgs/Image has a string and an unbounded
+    // pixel sequence, so a middleware loan could not hold the frame without
+    // heap allocations inside it: raw images always go through rcl_publish,
+    // and the frame ring is the single-copy path.
+    uint64_t frames_published;  // Frames taken from the capture queue and handed on
+    uint64_t bytes_copied;      // Frame bytes copied in user space (incl. serialization)
+    uint64_t ring_drops;        // Frames not shared because readers held every slot
+    
+    // Components in the same process get frames by pointer from a
+    // reference-counted pool; the ring and descriptors are then only
+    // written for subscribers outside the process
+    frame_pool_t pool;
+    bool pool_ready;
+    camera_frame_sink_t sinks[CAMERA_MAX_SINKS];
+    void* sink_contexts[CAMERA_MAX_SINKS];
+    int sink_count;
+    
+    // Raw recording of captured frames (config.record), written on the
+    // recorder's own thread
+    bool recording;
+    frame_recorder_t recorder;
+    
+    // Capture -> dequeue -> publish latency histograms on /diagnostics
+    latency_diagnostics_t latency;
+    bool latency_ready;
 } camera_node_t;
 
 // Function declarations
-int camera_node_init(camera_node_t* camera, rcl_context_t* context);
+int camera_node_init(camera_node_t* camera, rcl_context_t* context, const camera_config_t* config);
+
+// Camera index of a multi-camera node on node: publishers only, under
+// /camera<index>. The caller waits on the source and the capture queue
+// itself, then starts the source.
+int camera_node_init_member(camera_node_t* camera, rcl_node_t* node, const camera_config_t* config,
+                            int index);
 void camera_node_fini(camera_node_t* camera);
 int camera_node_spin(camera_node_t* camera);
+void camera_node_request_shutdown(void);
+int camera_node_capture_frame(camera_node_t* camera);
+
+// Hand every published frame to sink as well (before camera_node_spin)
+int camera_node_add_sink(camera_node_t* camera, camera_frame_sink_t sink, void* ctx);
+int camera_node_publish_frame(camera_node_t* camera, const frame_queue_frame_t* frame);
+
+// Publish a frame popped from the capture queue and account for it
+// (latency, statistics). 0 if it went out, -1 if it was skipped.
+int camera_node_publish_queued(camera_node_t* camera, const frame_queue_frame_t* frame);
 
-// V4L2 helper functions
-int v4l2_open_device(camera_node_t* camera, const char* device);
-int v4l2_init_device(camera_node_t* camera);
-int v4l2_start_capture(camera_node_t* camera);
-int v4l2_stop_capture(camera_node_t* camera);
-int v4l2_read_frame(camera_node_t* camera);
-void v4l2_close_device(camera_node_t* camera);
+// Single-threaded path: take one frame from the source straight into
+// image_msg. Returns 1 if a frame was read, 0 if none was ready, -1 on error.
+int camera_node_read_frame(camera_node_t* camera);
 
 #endif // CAMERA_NODE_H 
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef CAMERA_RIG_H
+#define CAMERA_RIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <rcl/rcl.h>
+#include <embedded_object_detection_pi5/msg/frame_set.h>
+
+#include "camera_config/camera_config.h"
+#include "camera_node/camera_node.h"
+#include "frame_sync/frame_sync.h"
+
+// Several cameras in one camera_node (config.devices)
+//
+// Every camera is a camera_node_t on the rig's node, publishing under
+// /camera<N> with frame_id camera<N>. One capture thread waits on all
+// sources with a single epoll and only moves frames into each camera's
+// capture queue; each camera has its own publish thread, so MJPEG
+// decoding and publishing of different cameras run on different cores.
+// A camera whose device fails is dropped and the others carry on.
+//
+// With config.sync_ms set, frames whose capture times lie within that
+// tolerance are grouped (frame_sync.h) and announced as a FrameSet on
+// CAMERA_RIG_SET_TOPIC.
+
+#define CAMERA_RIG_SET_TOPIC "/camera/frame_sets"
+#define CAMERA_RIG_STATS_INTERVAL_MS 5000 // Per-camera rates and drops
+
+typedef struct camera_rig camera_rig_t;
+
+// One camera's publish thread
+typedef struct {
+    camera_rig_t* rig;
+    int index;
+    int epoll_fd;               // Capture queue eventfd + shutdown eventfd
+    pthread_t thread;
+    bool thread_running;
+} camera_rig_worker_t;
+
+struct camera_rig {
+    rcl_node_t node;
+    bool node_ready;
+    camera_node_t cameras[CAMERA_CONFIG_MAX_CAMERAS];
+    int count;                  // Cameras initialized
+
+    // Capture thread: every source (or queue space) fd, data.ptr the camera
+    int epoll_fd;
+    int shutdown_fd;            // eventfd signalled on SIGINT/SIGTERM
+    bool capturing[CAMERA_CONFIG_MAX_CAMERAS];
+    int active;                 // Cameras still capturing
+    int result;
+    camera_rig_worker_t workers[CAMERA_CONFIG_MAX_CAMERAS];
+
+    // Frame sets, fed by every publish thread under sync_lock
+    bool use_sync;
+    frame_sync_t sync;
+    pthread_mutex_t sync_lock;
+    rcl_publisher_t set_publisher;
+    embedded_object_detection_pi5__msg__FrameSet* set_msg;
+
+    // Counters at the last statistics line
+    int64_t stats_ns;
+    uint64_t stats_captured[CAMERA_CONFIG_MAX_CAMERAS];
+    uint64_t stats_published[CAMERA_CONFIG_MAX_CAMERAS];
+};
+
+// cameras from camera_config_split, count of them (2 or more)
+int camera_rig_init(camera_rig_t* rig, rcl_context_t* context, const camera_config_t* cameras,
+                    int count);
+void camera_rig_fini(camera_rig_t* rig);
+int camera_rig_spin(camera_rig_t* rig);
+void camera_rig_request_shutdown(void);
+
+#endif // CAMERA_RIG_H
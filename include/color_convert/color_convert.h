@@ -0,0 +1,71 @@
+#ifndef COLOR_CONVERT_H
+#define COLOR_CONVERT_H
+
+#include <stdint.h>
+
+// Color conversion kernels
+//
+// All YUYV -> RGB24 kernels implement the same BT.601 limited-range
+// fixed-point math and produce byte-identical output:
+//
+//   R = clamp((298 * (Y - 16) + 409 * (V - 128) + 128) >> 8)
+//   G = clamp((298 * (Y - 16) - 100 * (U - 128) - 208 * (V - 128) + 128) >> 8)
+//   B = clamp((298 * (Y - 16) + 516 * (U - 128) + 128) >> 8)
+//
+// Strides are in bytes. Odd widths are supported: the last macropixel of
+// a row then only yields its first pixel.
+
+// Instruction set used by a kernel
+typedef enum {
+    COLOR_CONVERT_ISA_SCALAR = 0,
+    COLOR_CONVERT_ISA_SSE2,
+    COLOR_CONVERT_ISA_AVX2,
+    COLOR_CONVERT_ISA_NEON,
+    COLOR_CONVERT_ISA_COUNT
+} color_convert_isa_t;
+
+typedef void (*yuyv_to_rgb24_fn)(const uint8_t* src, int src_stride,
+                                 uint8_t* dst, int dst_stride,
+                                 int width, int height);
+
+// Dispatched conversion, uses the best kernel the CPU supports
+void yuyv_to_rgb24_strided(const uint8_t* src, int src_stride,
+                           uint8_t* dst, int dst_stride,
+                           int width, int height);
+
+// Tightly packed convenience wrapper (stride = width * 2 / width * 3)
+void yuyv_to_rgb24(const uint8_t* yuyv_data, uint8_t* rgb_data, int width, int height);
+
+// Band-parallel variant: splits the frame into L2-sized row bands on a
+// persistent worker pool. A 1-thread pool converts inline.
+struct worker_pool;
+void yuyv_to_rgb24_parallel(struct worker_pool* pool,
+                            const uint8_t* src, int src_stride,
+                            uint8_t* dst, int dst_stride,
+                            int width, int height);
+
+// Kernel selection
+color_convert_isa_t color_convert_detect_isa(void);
+color_convert_isa_t color_convert_active_isa(void);
+int color_convert_set_isa(color_convert_isa_t isa);
+yuyv_to_rgb24_fn color_convert_get_yuyv_to_rgb24(color_convert_isa_t isa);
+const char* color_convert_isa_name(color_convert_isa_t isa);
+
+// Individual kernels (NULL-safe access via color_convert_get_yuyv_to_rgb24)
+void yuyv_to_rgb24_scalar(const uint8_t* src, int src_stride,
+                          uint8_t* dst, int dst_stride, int width, int height);
+void yuyv_to_rgb24_row_scalar(const uint8_t* src, uint8_t* dst, int x_begin, int width);
+
+#if defined(__x86_64__) || defined(__i386__)
+void yuyv_to_rgb24_sse2(const uint8_t* src, int src_stride,
+                        uint8_t* dst, int dst_stride, int width, int height);
+void yuyv_to_rgb24_avx2(const uint8_t* src, int src_stride,
+                        uint8_t* dst, int dst_stride, int width, int height);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+void yuyv_to_rgb24_neon(const uint8_t* src, int src_stride,
+                        uint8_t* dst, int dst_stride, int width, int height);
+#endif
+
+#endif // COLOR_CONVERT_H
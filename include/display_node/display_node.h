@@ -3,33 +3,120 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 // SDL2 includes
 #include <SDL2/SDL.h>
 
 // ROS2 includes
 #include <rcl/rcl.h>
+#include <rmw/serialized_message.h>
 #include <sensor_msgs/msg/image.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
+
+#include "color_convert/color_convert.h"
+#include "display_render/display_render.h"
+#include "frame_mailbox/frame_mailbox.h"
+#include "frame_pool/frame_pool.h"
+#include "frame_ring/frame_ring.h"
+#include "latency_diagnostics/latency_diagnostics.h"
+#include "worker_pool/worker_pool.h"
 
 // Display configuration
 #define DISPLAY_WIDTH 640
 #define DISPLAY_HEIGHT 480
 #define DISPLAY_TITLE "Camera View"
+#define DISPLAY_USE_FRAME_RING 1     // Read frames from the camera's shared-memory ring
+#define DISPLAY_IMAGE_TOPIC "/camera/image_raw"
+#define DISPLAY_DESCRIPTOR_TOPIC "/camera/frame_descriptor"
+#define DISPLAY_RING_REOPEN_AFTER 30 // Remap the ring after this many stale descriptors
+#define DISPLAY_CONVERT_THREADS 2    // Threads for CPU color conversion (1 = inline)
+#define DISPLAY_VSYNC 1              // Present in step with the display refresh
+#define DISPLAY_EVENT_POLL_MS 10     // Max time between SDL event checks while idle
+#define DISPLAY_STATS_INTERVAL 300   // Log frame statistics every N displayed frames
+#define DISPLAY_STILL_REFRESH 30     // Show every Nth still frame; the others are skipped
+#define DISPLAY_FRAME_RESERVE (DISPLAY_WIDTH * DISPLAY_HEIGHT * 2) // Bytes per frame buffer reserved at startup
+#define DISPLAY_DESCRIPTOR_RESERVE 256 // Bytes reserved for a serialized frame descriptor
+#define DISPLAY_MOSAIC_GAP 2         // Pixels between mosaic tiles
+#define DISPLAY_TOPIC_MAX 128        // Topic name buffers
+
+// One image topic and the tile it is drawn in. Every stream has its own
+// subscriptions, mailbox and streaming texture, so a frame only touches
+// its own stream's texture.
+typedef struct {
+    int index;
+    char image_topic[DISPLAY_TOPIC_MAX];
+    char descriptor_topic[DISPLAY_TOPIC_MAX]; // Empty: raw images only
+    
+    SDL_Texture* texture;       // Created lazily to match the incoming frames
+    Uint32 texture_format;
+    int texture_width;
+    int texture_height;
+    
+    // Raw images (serialized) or descriptors into the camera's frame ring
+    rcl_subscription_t subscription;
+    bool raw_subscribed;        // subscription is active
+    bool ring_subscribed;       // descriptor_subscription is active
+    rcl_subscription_t descriptor_subscription;
+    embedded_object_detection_pi5__msg__FrameDescriptor* descriptor_msg;
+    rmw_serialized_message_t descriptor_serialized;
+    frame_ring_t frame_ring;
+    bool ring_open;
+    uint64_t ring_frames;       // Frames received from the ring
+    uint64_t ring_stale;        // Descriptors whose slot was already recycled
+    uint64_t intake_index;      // Frames handed to the mailbox (intake thread)
+    int still_run;              // Still frames skipped in a row
+    uint64_t still_skipped;
+    
+    // Intake thread (ROS) -> latest-frame-wins mailbox -> render loop (SDL)
+    frame_mailbox_t mailbox;
+    bool mailbox_ready;
+    display_frame_t frames[FRAME_MAILBOX_BUFFERS];
+} display_stream_t;
 
 // Display node structure
 typedef struct {
     // SDL2 components
     SDL_Window* window;
     SDL_Renderer* renderer;
-    SDL_Texture* texture;
+    SDL_RendererInfo renderer_info; // Natively supported texture formats
+    
+    bool vsync;                     // SDL_RenderPresent waits for the refresh
+    int64_t refresh_interval_ns;    // Display refresh period, paces presents without vsync
+    
+    // Band-parallel CPU color conversion (only used without GPU support)
+    worker_pool_t convert_pool;
+    bool convert_pool_ready;
     
-    // ROS2 components
+    // ROS2 components: one wait set over every stream's subscriptions
     rcl_node_t node;
-    rcl_subscription_t subscription;
     rcl_wait_set_t wait_set;
+    pthread_t intake_thread;
+    
+    // Streams in mosaic order (one unless display_node_init_mosaic). Their
+    // mailboxes share a group, so the render loop sleeps until any has a frame.
+    display_stream_t streams[DISPLAY_MAX_STREAMS];
+    int stream_count;
+    frame_mailbox_group_t group;
+    bool group_ready;
+    
+    // Frame selection and upload state per stream (render loop only)
+    display_render_t render;
+    
+    // Render statistics (render loop only)
+    uint64_t frames_displayed;  // Over all streams
+    uint64_t presents;          // One per refresh that showed a new frame
+    int64_t latency_sum_ns;     // Receive-to-present, since the last report
+    int64_t latency_max_ns;
+    uint64_t latency_count;
     
-    // Image message
-    sensor_msgs__msg__Image* image_msg;
+    // Capture -> take -> convert -> present histograms on /diagnostics
+    latency_diagnostics_t latency;
+    bool latency_ready;
+    
+    // In-process mode: frames arrive through display_node_post_frame
+    // instead of subscriptions, and there is no intake thread
+    bool local;
     
     // State
     bool is_running;
@@ -39,14 +126,40 @@ typedef struct {
 int display_node_init(display_node_t* display, rcl_context_t* context);
 void display_node_fini(display_node_t* display);
 int display_node_spin(display_node_t* display);
+void display_node_request_shutdown(void);
+
+// Mosaic mode: topics is a comma-separated list of up to
+// DISPLAY_MAX_STREAMS image topics, drawn as a grid in one window. A topic
+// ending in /image_raw reads frames through the camera's shared ring via
+// the matching /frame_descriptor topic, like the single-stream display.
+int display_node_init_mosaic(display_node_t* display, rcl_context_t* context, const char* topics);
+
+// In-process mode, for a camera in the same process: no subscriptions,
+// frames are posted by pointer with display_node_post_frame
+int display_node_init_local(display_node_t* display, rcl_context_t* context);
+
+// Frame sink (camera_frame_sink_t): keep a reference to frame and hand it
+// to the render loop, replacing a frame it has not picked up yet (stream 0)
+void display_node_post_frame(void* ctx, frame_pool_frame_t* frame);
 
 // SDL2 helper functions
 int sdl2_init_window(display_node_t* display);
 void sdl2_cleanup_window(display_node_t* display);
-int sdl2_update_display(display_node_t* display, const sensor_msgs__msg__Image* msg);
+int sdl2_update_stream(display_node_t* display, display_stream_t* stream,
+                       const sensor_msgs__msg__Image* msg);
+// Upload only rows [dirty_y, dirty_y + dirty_height) into the stream's
+// texture, which must hold the previous frame; the rest is kept. Uploads
+// the whole frame when the texture is recreated or the format has several
+// planes. Nothing is shown until sdl2_present.
+int sdl2_update_stream_rows(display_node_t* display, display_stream_t* stream,
+                            const sensor_msgs__msg__Image* msg, int dirty_y, int dirty_height);
+// Draw every stream's texture into its tile and present once
+void sdl2_present(display_node_t* display);
 void sdl2_handle_events(display_node_t* display);
 
-// Color conversion functions
-void yuyv_to_rgb24(const uint8_t* yuyv_data, uint8_t* rgb_data, int width, int height);
+// Frame ring helpers
+int display_node_handle_descriptor(display_node_t* display, display_stream_t* stream,
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc,
+    display_frame_t* frame);
 
 #endif // DISPLAY_NODE_H 
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef DISPLAY_INTAKE_H
+#define DISPLAY_INTAKE_H
+
+#include <rcl/rcl.h>
+#include <rmw/serialized_message.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
+
+#include "display_render/display_render.h"
+#include "frame_pool/frame_pool.h"
+#include "frame_ring/frame_ring.h"
+
+// Filling display frames from each transport, without SDL
+//
+// The display's intake thread and its in-process sink put every frame into
+// a mailbox buffer with one of these; the benchmarks call the same ones.
+// Each sets the frame's image or view, capture_ns (0 if the publisher left
+// the stamp at zero) and dirty rows. receive_ns and index are the
+// caller's, as is publishing the mailbox.
+
+// Take the serialized image waiting on subscription into frame and read
+// it in place: no deserialization, no allocation. Returns
+// RCL_RET_SUBSCRIPTION_TAKE_FAILED if nothing was waiting or the message
+// is malformed.
+rcl_ret_t display_intake_take_image(display_frame_t* frame, rcl_subscription_t* subscription);
+
+// Take the serialized frame descriptor waiting on subscription into
+// serialized and decode it into desc, as above
+rcl_ret_t display_intake_take_descriptor(rcl_subscription_t* subscription,
+    rmw_serialized_message_t* serialized,
+    embedded_object_detection_pi5__msg__FrameDescriptor* desc);
+
+// Copy the ring slot desc names into frame; -1 if it was already recycled.
+// The slot is released right away: holding it until the renderer gets to
+// the frame would leave the camera short of free slots whenever
+// presentation falls behind.
+int display_intake_copy_ring(display_frame_t* frame, frame_ring_t* ring,
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc);
+
+// Show an in-process frame through frame by pointer, holding a reference
+// until it is uploaded. Any frame the buffer still held is released.
+void display_intake_pool(display_frame_t* frame, frame_pool_frame_t* pooled);
+
+#endif // DISPLAY_INTAKE_H
@@ -0,0 +1,77 @@
+#ifndef DISPLAY_RENDER_H
+#define DISPLAY_RENDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rmw/serialized_message.h>
+#include <sensor_msgs/msg/image.h>
+
+#include "frame_mailbox/frame_mailbox.h"
+#include "frame_pool/frame_pool.h"
+
+// The display's per-refresh frame selection, without SDL
+//
+// Each refresh takes the newest frame of every stream that has one and
+// decides how much of it to upload: only the dirty rows when it directly
+// follows the frame in the stream's texture, the whole frame otherwise.
+// The upload itself is a callback (SDL textures in display_node, plain
+// buffers in the benchmarks), so both run the same selection.
+
+#define DISPLAY_MAX_STREAMS 4        // Image topics in one mosaic window
+#define DISPLAY_FULL_REFRESH 30      // Full texture upload at least every N frames
+
+// One received frame, owned by the intake thread, the mailbox or the renderer.
+// Its buffers are reserved at startup and reused for the life of the node,
+// so receiving a frame allocates nothing once they fit.
+typedef struct {
+    sensor_msgs__msg__Image image; // Copy of a ring slot
+    rmw_serialized_message_t serialized; // Raw topic, taken without deserializing
+    sensor_msgs__msg__Image view;  // Borrows serialized or pooled; never finalized
+    bool use_view;              // view, not image, holds the frame
+    int64_t receive_ns;         // CLOCK_MONOTONIC when the intake thread got it
+    int64_t capture_ns;         // Camera capture time, CLOCK_MONOTONIC (0 = unknown)
+    uint64_t index;             // Count of frames handed to the mailbox, from 1
+    int dirty_y;                // Rows that differ from the previous frame
+    int dirty_height;           // handed over (whole frame if unknown)
+    frame_pool_frame_t* pooled; // In-process frame shown instead of image, one reference held
+} display_frame_t;
+
+// Upload image into stream's texture. If partial, the texture holds the
+// previous frame and only rows [dirty_y, dirty_y + dirty_height) changed.
+typedef int (*display_render_upload_t)(void* ctx, int stream, const sensor_msgs__msg__Image* image,
+                                       bool partial, int dirty_y, int dirty_height);
+
+// Render loop state of one stream
+typedef struct {
+    frame_mailbox_t* mailbox;   // Frames from the intake thread
+    uint64_t frames_displayed;
+    uint64_t shown_index;       // index of the frame in the texture
+    int shown_dirty_y;          // Its own dirty rows: the next partial upload
+    int shown_dirty_height;     // redraws them too, to clear what moved away
+    int partial_run;            // Partial uploads since the last full one
+    uint64_t partial_uploads;
+} display_render_stream_t;
+
+typedef struct {
+    display_render_stream_t streams[DISPLAY_MAX_STREAMS];
+    int stream_count;
+    display_render_upload_t upload;
+    void* ctx;
+} display_render_t;
+
+void display_render_init(display_render_t* render, display_render_upload_t upload, void* ctx);
+// Add a stream drawn from mailbox; returns its index, -1 if full
+int display_render_add_stream(display_render_t* render, frame_mailbox_t* mailbox);
+
+// One refresh: take and upload the newest frame of every stream that has
+// one. The uploaded frames go to shown (DISPLAY_MAX_STREAMS entries) and
+// stay valid until their stream's next take. Returns how many there are;
+// 0 means nothing to present.
+int display_render_take(display_render_t* render, display_frame_t* shown[]);
+
+// The message a frame shows: its own copy of a ring slot, or the view
+// into its serialized buffer or pool frame
+const sensor_msgs__msg__Image* display_frame_image(const display_frame_t* frame);
+
+#endif // DISPLAY_RENDER_H
@@ -0,0 +1,79 @@
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// One-slot, latest-frame-wins mailbox between two threads
+//
+// A triple buffer over three caller-owned frames: the writer fills its own
+// buffer and swaps it into the mailbox, the reader swaps the mailbox
+// buffer out for the one it finished with. Publishing while the previous
+// frame is still unread replaces it (counted as overwritten), so the
+// reader always gets the newest frame and never works through a backlog.
+// Only the index swap happens under the mutex; frames are never copied.
+//
+// One reader can serve several mailboxes (the display's mosaic) by joining
+// them to a group: every publish is also counted there, so the reader
+// sleeps until any of them has a frame instead of polling each one.
+
+#define FRAME_MAILBOX_BUFFERS 3
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;            // Signalled on every publish and on close
+    uint64_t published;             // Publishes into any member mailbox
+    bool closed;
+} frame_mailbox_group_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;            // Signalled on publish and close
+    void* buffers[FRAME_MAILBOX_BUFFERS];
+    int write_index;                // Owned by the writer
+    int ready_index;                // In the mailbox
+    int read_index;                 // Owned by the reader
+    bool fresh;                     // ready_index holds an unread frame
+    bool closed;
+    frame_mailbox_group_t* group;   // Also counts publishes here, NULL if none
+
+    uint64_t published;
+    uint64_t taken;
+    uint64_t overwritten;           // Published frames the reader never saw
+} frame_mailbox_t;
+
+int frame_mailbox_init(frame_mailbox_t* mailbox, void* buffers[FRAME_MAILBOX_BUFFERS]);
+void frame_mailbox_fini(frame_mailbox_t* mailbox);
+
+// Writer: buffer to fill next, then hand it over
+void* frame_mailbox_write_buffer(frame_mailbox_t* mailbox);
+void frame_mailbox_publish(frame_mailbox_t* mailbox);
+
+// Reader: newest unread frame, or NULL after timeout_ms or once closed.
+// The frame stays valid until the next call.
+void* frame_mailbox_take(frame_mailbox_t* mailbox, int timeout_ms);
+
+// Wake a waiting reader for good
+void frame_mailbox_close(frame_mailbox_t* mailbox);
+
+void frame_mailbox_get_counts(frame_mailbox_t* mailbox, uint64_t* published,
+                              uint64_t* taken, uint64_t* overwritten);
+
+int frame_mailbox_group_init(frame_mailbox_group_t* group);
+void frame_mailbox_group_fini(frame_mailbox_group_t* group);
+
+// Count mailbox's publishes in group too; before either side uses it
+void frame_mailbox_join(frame_mailbox_t* mailbox, frame_mailbox_group_t* group);
+
+// Reader: note the count, take from every mailbox with timeout 0, and if
+// none had a frame, wait until the count moves past seen. A frame
+// published in between is never missed. Returns false on timeout or once
+// the group is closed.
+uint64_t frame_mailbox_group_count(frame_mailbox_group_t* group);
+bool frame_mailbox_group_wait(frame_mailbox_group_t* group, uint64_t seen, int timeout_ms);
+
+// Wake a waiting reader for good
+void frame_mailbox_group_close(frame_mailbox_group_t* group);
+
+#endif // FRAME_MAILBOX_H
@@ -0,0 +1,69 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Reference-counted frames for components in one process
+//
+// A fixed set of equally sized frames allocated up front. A producer
+// acquires a free frame (reference count 0 -> 1), fills it and passes the
+// pointer to its consumers, each of which takes its own reference and
+// drops it when done; the frame is free again once the last reference is
+// gone. Nothing is allocated, serialized or copied on the way. When every
+// frame is still held the producer gets NULL and the frame is counted as
+// dropped: a slow consumer costs frames, never capture time.
+//
+// Reference counts are atomics, so acquire, ref and release are lock-free
+// and safe from any thread.
+
+typedef struct frame_pool frame_pool_t;
+
+typedef struct {
+    uint8_t* data;              // capacity bytes, 64-byte aligned
+    size_t capacity;
+    size_t size;                // Bytes in use
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    const char* encoding;       // Static string, never freed
+    uint32_t sequence;          // Capture sequence
+    int64_t stamp_ns;           // Capture time (CLOCK_MONOTONIC)
+
+    // Motion gate verdict, as in the frame descriptor
+    bool still;
+    float motion_score;
+    uint32_t dirty_x;
+    uint32_t dirty_y;
+    uint32_t dirty_width;
+    uint32_t dirty_height;
+
+    int refs;                   // Atomic; 0 while free
+    frame_pool_t* pool;
+} frame_pool_frame_t;
+
+struct frame_pool {
+    frame_pool_frame_t* frames;
+    int count;
+    uint8_t* memory;            // Backing store of every frame
+    unsigned int cursor;        // Atomic; where the next acquire starts looking
+    uint64_t acquired;          // Atomic counters
+    uint64_t exhausted;         // Acquires that found every frame in use
+};
+
+int frame_pool_init(frame_pool_t* pool, int count, size_t frame_size);
+void frame_pool_fini(frame_pool_t* pool);
+
+// A free frame with one reference, or NULL if every frame is held
+frame_pool_frame_t* frame_pool_acquire(frame_pool_t* pool);
+
+// Take another reference to a frame that is already held
+void frame_pool_ref(frame_pool_frame_t* frame);
+
+// Drop a reference; the frame goes back to the pool with the last one
+void frame_pool_release(frame_pool_frame_t* frame);
+
+void frame_pool_get_counts(const frame_pool_t* pool, uint64_t* acquired, uint64_t* exhausted);
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,116 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Lock-free single-producer/single-consumer frame queue
+//
+// Hands captured frames from the capture thread to the publish thread.
+// The queue owns capacity + 2 preallocated frame buffers: up to capacity
+// queued, one held by the consumer and one spare the producer fills next.
+// Buffers travel by index through two SPSC index rings (queued frames one
+// way, released buffers back), so frame data is never copied in the queue
+// and neither side ever blocks or allocates.
+//
+// When the queue is full the overflow policy decides which frame is lost:
+// DROP_NEWEST discards the incoming frame, DROP_OLDEST makes the producer
+// take the oldest queued frame back (a CAS on the consumer index, which
+// the consumer also uses to pop) and queue the new one in its place. WAIT
+// loses nothing: the producer checks frame_queue_full and sleeps on a
+// second eventfd, signalled on every pop, until there is room again.
+//
+// Every push signals an eventfd so the consumer can sleep in epoll.
+//
+// A producer whose frames stay valid for the life of the queue (e.g. a
+// mapped file) can point data at them instead of copying into buffer.
+
+typedef enum {
+    FRAME_QUEUE_DROP_OLDEST = 0,  // Keep the latest frames (lowest latency)
+    FRAME_QUEUE_DROP_NEWEST,      // Keep the queued frames (no gaps in a burst)
+    FRAME_QUEUE_WAIT              // Producer waits for room (paced by the consumer)
+} frame_queue_policy_t;
+
+// One frame buffer
+typedef struct {
+    uint8_t* buffer;            // Queue-owned storage
+    const uint8_t* data;        // Frame bytes: buffer, or producer memory
+    size_t capacity;            // Allocated bytes in buffer
+    size_t size;                // Valid bytes
+    uint32_t sequence;          // Driver frame sequence
+    int64_t stamp_ns;           // Capture time (CLOCK_MONOTONIC)
+    int64_t dequeue_ns;         // CLOCK_MONOTONIC when the capture thread got it
+} frame_queue_frame_t;
+
+// Counters, readable from either thread
+typedef struct {
+    uint64_t pushed;            // Frames queued
+    uint64_t popped;            // Frames taken by the consumer
+    uint64_t dropped_oldest;    // Queued frames discarded for newer ones
+    uint64_t dropped_newest;    // Incoming frames discarded because the queue was full
+} frame_queue_stats_t;
+
+#define FRAME_QUEUE_CACHE_LINE 64
+
+typedef struct {
+    frame_queue_policy_t policy;
+    int capacity;               // Frames that can be queued
+    int buffer_count;           // capacity + 2
+    uint8_t* storage;
+    frame_queue_frame_t* frames;
+    int* entries;               // Queued buffer indices, capacity entries
+    int* free_entries;          // Released buffer indices, buffer_count entries
+    int event_fd;               // Readable while frames may be pending
+    int space_fd;               // WAIT only: readable after a pop, else -1
+
+    // Producer side
+    uint64_t head;              // Next queue entry to write
+    uint64_t free_tail;         // Next released buffer to take back
+    int spare;                  // Buffer the producer fills next
+    uint64_t pushed;
+    uint64_t dropped_oldest;
+    uint64_t dropped_newest;
+    char pad0[FRAME_QUEUE_CACHE_LINE];
+
+    // Shared: advanced by the consumer (pop) and the producer (drop-oldest)
+    uint64_t tail;
+    char pad1[FRAME_QUEUE_CACHE_LINE];
+
+    // Consumer side
+    uint64_t free_head;         // Next released-buffer entry to write
+    uint64_t popped;
+} frame_queue_t;
+
+int frame_queue_init(frame_queue_t* queue, int capacity, size_t frame_size,
+                     frame_queue_policy_t policy);
+void frame_queue_fini(frame_queue_t* queue);
+
+// Producer: get the buffer to fill. Returns NULL if the queue is full and
+// the policy is DROP_NEWEST (counted as a drop) or WAIT.
+frame_queue_frame_t* frame_queue_begin_push(frame_queue_t* queue);
+// Producer: queue the buffer returned by frame_queue_begin_push.
+// Returns 1 if the oldest queued frame was dropped to make room, else 0.
+int frame_queue_push(frame_queue_t* queue);
+
+// Producer: true if a push now would drop a frame or, with WAIT, block
+bool frame_queue_full(const frame_queue_t* queue);
+
+// Producer, WAIT only: eventfd that becomes readable when the consumer
+// makes room; reset it before checking frame_queue_full again
+int frame_queue_space_fd(const frame_queue_t* queue);
+void frame_queue_clear_space(frame_queue_t* queue);
+
+// Consumer: take the oldest queued frame, NULL if empty. The frame stays
+// valid until frame_queue_release.
+frame_queue_frame_t* frame_queue_pop(frame_queue_t* queue);
+void frame_queue_release(frame_queue_t* queue, frame_queue_frame_t* frame);
+
+// Consumer: eventfd to wait on, and reset it before draining the queue
+int frame_queue_event_fd(const frame_queue_t* queue);
+void frame_queue_clear_event(frame_queue_t* queue);
+
+void frame_queue_get_stats(const frame_queue_t* queue, frame_queue_stats_t* stats);
+const char* frame_queue_policy_name(frame_queue_policy_t policy);
+
+#endif // FRAME_QUEUE_H
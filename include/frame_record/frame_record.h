@@ -0,0 +1,171 @@
+#ifndef FRAME_RECORD_H
+#define FRAME_RECORD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "frame_queue/frame_queue.h"
+
+// Raw frame recordings
+//
+// File layout (host byte order, every offset a multiple of 64):
+//   0                       frame_record_header_t, padded to FRAME_RECORD_ALIGN
+//   header_size             frames: frame_record_frame_t + bytes, padded to 64
+//   index_offset            frame_record_entry_t per frame, sorted by stamp
+// The header is written first with no index and rewritten when the
+// recording is closed. A file that was never closed (crash, power loss)
+// still plays: the frame headers are scanned to rebuild the index.
+//
+// The recorder takes frames on the capture thread and copies them into a
+// bounded queue; a writer thread packs them into FRAME_RECORD_CHUNK_SIZE
+// chunks and writes each with one aligned O_DIRECT pwrite, so nothing is
+// serialized per frame and the page cache is not filled with frames that
+// will never be read back. Space is preallocated FRAME_RECORD_PREALLOC at
+// a time so the filesystem does not allocate block by block; the file size
+// still only grows with written chunks, so a recording cut off by a crash
+// ends where its data does. When the disk stalls the queue fills up and
+// new frames are dropped and counted; capture never waits for the disk.
+//
+// The player maps a recording and finds frames by capture time with a
+// binary search over the index.
+
+#define FRAME_RECORD_MAGIC "EODFRAME"
+#define FRAME_RECORD_VERSION 1
+#define FRAME_RECORD_FRAME_MAGIC 0x314d5246u  // "FRM1"
+#define FRAME_RECORD_ALIGN 4096               // O_DIRECT offset and size alignment
+#define FRAME_RECORD_FRAME_ALIGN 64
+#define FRAME_RECORD_CHUNK_SIZE (4u << 20)    // Bytes per write
+#define FRAME_RECORD_PREALLOC (256ull << 20)  // File growth per fallocate
+
+typedef struct {
+    char magic[8];              // FRAME_RECORD_MAGIC, not terminated
+    uint32_t version;
+    uint32_t header_size;       // First frame starts here
+    uint32_t fourcc;            // V4L2_PIX_FMT_* of every frame
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytesperline;      // 0 for compressed formats
+    double fps;                 // Nominal capture rate
+    int64_t clock_offset_ns;    // CLOCK_REALTIME - CLOCK_MONOTONIC when recording started
+    uint64_t frame_count;       // 0 until closed
+    uint64_t index_offset;      // 0 until closed: scan the frames instead
+    uint64_t data_end;          // End of the last frame
+} frame_record_header_t;
+
+// Precedes every frame's bytes
+typedef struct {
+    uint32_t magic;             // FRAME_RECORD_FRAME_MAGIC
+    uint32_t size;              // Frame bytes that follow
+    uint32_t sequence;          // Capture sequence
+    uint32_t reserved;
+    int64_t stamp_ns;           // Capture time (CLOCK_MONOTONIC)
+    uint64_t pad[5];            // Keeps the frame bytes 64-byte aligned
+} frame_record_frame_t;
+
+typedef struct {
+    int64_t stamp_ns;
+    uint64_t offset;            // Of the frame bytes
+    uint32_t size;
+    uint32_t sequence;
+    uint32_t fourcc;
+    uint32_t reserved;
+} frame_record_entry_t;
+
+// Recorder counters, readable from any thread
+typedef struct {
+    uint64_t frames;            // Frames written
+    uint64_t dropped;           // Frames lost because the queue was full
+    uint64_t bytes;             // Bytes written to the file
+    int64_t write_ns;           // Time spent in pwrite
+    int64_t max_write_ns;       // Longest single pwrite
+    int64_t elapsed_ns;         // Since the recorder was opened
+    bool direct;                // Writes bypass the page cache
+} frame_recorder_stats_t;
+
+typedef struct {
+    int fd;
+    bool direct;                // O_DIRECT accepted by the filesystem
+    bool prealloc;              // fallocate supported
+    frame_record_header_t header;
+    int64_t open_ns;
+
+    // Capture thread -> writer thread
+    frame_queue_t queue;
+    bool queue_ready;
+    pthread_t thread;
+    bool thread_running;
+    int stop_fd;                // eventfd: drain the queue and exit
+    uint64_t lost;              // Capture thread: frames too large, or after a write error
+
+    // Writer thread only
+    uint8_t* chunk;             // FRAME_RECORD_CHUNK_SIZE, FRAME_RECORD_ALIGN aligned
+    size_t chunk_fill;
+    uint64_t chunk_offset;      // File offset of chunk[0]
+    uint64_t allocated;         // Bytes preallocated so far
+    frame_record_entry_t* index;
+    size_t count;
+    size_t capacity;
+    int error;                  // A write failed; later frames are discarded
+
+    // Written by the writer thread, read through frame_recorder_get_stats
+    uint64_t frames;
+    uint64_t bytes;
+    int64_t write_ns;
+    int64_t max_write_ns;
+} frame_recorder_t;
+
+// Index over a mapped recording
+typedef struct {
+    frame_record_header_t header;
+    const frame_record_entry_t* index;
+    size_t count;
+    bool recovered;             // No index in the file: rebuilt by scanning
+    frame_record_entry_t* rebuilt;
+} frame_record_view_t;
+
+typedef struct {
+    int fd;
+    const uint8_t* data;
+    size_t size;
+    frame_record_view_t view;
+} frame_record_player_t;
+
+// Create path and start the writer thread. Frames up to max_frame_size
+// bytes; queue_depth frames can wait for the disk.
+int frame_recorder_open(frame_recorder_t* recorder, const char* path, uint32_t fourcc,
+                        uint32_t width, uint32_t height, uint32_t bytesperline, double fps,
+                        size_t max_frame_size, int queue_depth);
+
+// Capture thread: copy one frame into the queue. Returns 1 if queued, 0
+// if it was dropped (queue full, or the recorder failed).
+int frame_recorder_write(frame_recorder_t* recorder, const uint8_t* data, size_t size,
+                         uint32_t sequence, int64_t stamp_ns);
+
+// Write what is queued, the index and the final header; stats (may be
+// NULL) gets the final counters. -1 if any write failed.
+int frame_recorder_close(frame_recorder_t* recorder, frame_recorder_stats_t* stats);
+
+void frame_recorder_get_stats(const frame_recorder_t* recorder, frame_recorder_stats_t* stats);
+
+// True if data starts with a recording header
+bool frame_record_detect(const uint8_t* data, size_t size);
+
+// Index a recording already in memory; data must stay mapped
+int frame_record_view_init(frame_record_view_t* view, const uint8_t* data, size_t size);
+void frame_record_view_fini(frame_record_view_t* view);
+
+// First frame captured at or after stamp_ns (count if none): O(log n)
+size_t frame_record_view_seek(const frame_record_view_t* view, int64_t stamp_ns);
+
+int frame_record_player_open(frame_record_player_t* player, const char* path);
+void frame_record_player_close(frame_record_player_t* player);
+
+// Bytes of frame i, NULL if out of range; entry gets its index entry
+const uint8_t* frame_record_player_frame(const frame_record_player_t* player, size_t i,
+                                         const frame_record_entry_t** entry);
+
+size_t frame_record_player_seek(const frame_record_player_t* player, int64_t stamp_ns);
+
+#endif // FRAME_RECORD_H
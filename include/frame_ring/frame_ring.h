@@ -0,0 +1,124 @@
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Shared-memory frame ring
+//
+// The camera node copies each captured frame once into a slot of a POSIX
+// shared memory object and publishes only a small FrameDescriptor message.
+// Consumers on the same host map the same object and read the pixels in
+// place, so frame data is never serialized between processes.
+//
+// Every reader takes a lease in the shared header when it opens the ring:
+// its pid and how often it pins each slot. The writer only claims slots no
+// lease pins and never waits: if every slot is held it drops the frame. A
+// reader that arrives after a slot was recycled sees a different sequence
+// number and skips the frame.
+//
+// Pins are per reader so that a consumer killed while it holds a slot
+// cannot take the slot away for good: when no slot is free, and every
+// FRAME_RING_RECLAIM_INTERVAL writes, the writer checks each lease's pid
+// with kill(pid, 0) and clears the pins of readers that are gone. Readers
+// must therefore run in the writer's PID namespace.
+//
+// The writer marks a slot FRAME_RING_WRITING before it checks the pins,
+// a reader pins before it checks the mark (both sequentially consistent),
+// so of a racing pair at least one sees the other and backs off.
+
+#define FRAME_RING_MAGIC 0x46524e47u   // "FRNG"
+#define FRAME_RING_VERSION 2
+#define FRAME_RING_MAX_SLOTS 16
+#define FRAME_RING_MAX_READERS 16      // Leases: reader handles open at once
+#define FRAME_RING_RECLAIM_INTERVAL 64 // Writes between checks for dead readers
+#define FRAME_RING_ENCODING_MAX 32
+#define FRAME_RING_WRITING 0x80000000u
+
+// Per-slot metadata, lives in the shared header
+typedef struct {
+    uint32_t state;             // FRAME_RING_WRITING while the writer fills it
+    uint32_t size;              // Valid bytes in the slot
+    uint64_t sequence;          // Frame sequence, 0 = never written
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    uint32_t reserved;
+    int64_t stamp_ns;           // Capture time
+    char encoding[FRAME_RING_ENCODING_MAX];
+} frame_ring_slot_t;
+
+// One reader's lease, lives in the shared header
+typedef struct {
+    int32_t pid;                // Holder, 0 = free, -1 = being reclaimed
+    uint32_t pins[FRAME_RING_MAX_SLOTS]; // Acquires not yet released, per slot
+} frame_ring_reader_t;
+
+// Start of the shared memory object
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t slot_size;         // Capacity of each slot (page aligned)
+    uint64_t data_offset;       // Offset of slot 0 from the start of the object
+    uint64_t next_sequence;     // Written by the producer only
+    frame_ring_slot_t slots[FRAME_RING_MAX_SLOTS];
+    frame_ring_reader_t readers[FRAME_RING_MAX_READERS];
+} frame_ring_header_t;
+
+// Process-local handle to a ring
+typedef struct {
+    char name[64];              // shm_open name
+    int fd;
+    void* base;                 // Start of the mapping
+    size_t map_size;
+    frame_ring_header_t* header;
+    bool is_owner;              // Created (and unlinks) the object
+    uint32_t stale_count;       // Consecutive failed acquires (reader side)
+    int reader;                 // Lease in header->readers (reader side), -1 = none
+    uint32_t writes;            // Since the last dead-reader check (writer side)
+    uint64_t reclaimed;         // Pins cleared of readers that died (writer side)
+} frame_ring_t;
+
+// Metadata attached to a frame on commit
+typedef struct {
+    uint32_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    int64_t stamp_ns;
+    const char* encoding;
+} frame_ring_frame_info_t;
+
+// Read-only view of an acquired slot
+typedef struct {
+    const uint8_t* data;
+    uint32_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    int64_t stamp_ns;
+    const char* encoding;
+} frame_ring_view_t;
+
+// Producer side
+int frame_ring_create(frame_ring_t* ring, const char* name, uint32_t slot_count, size_t slot_size);
+// Claim a slot; -1 (drop the frame) if every slot is pinned
+int frame_ring_begin_write(frame_ring_t* ring);
+uint8_t* frame_ring_slot_data(frame_ring_t* ring, int slot);
+uint64_t frame_ring_commit_write(frame_ring_t* ring, int slot, const frame_ring_frame_info_t* info);
+void frame_ring_abort_write(frame_ring_t* ring, int slot);
+// Free the leases of readers whose process is gone, with their pins.
+// begin_write calls it as needed. Returns the number of leases freed.
+int frame_ring_reclaim(frame_ring_t* ring);
+
+// Consumer side. Opening takes a lease, closing returns it.
+int frame_ring_open(frame_ring_t* ring, const char* name);
+int frame_ring_acquire(frame_ring_t* ring, uint32_t slot, uint64_t sequence, frame_ring_view_t* view);
+void frame_ring_release(frame_ring_t* ring, uint32_t slot);
+
+// Both
+void frame_ring_close(frame_ring_t* ring);
+
+#endif // FRAME_RING_H
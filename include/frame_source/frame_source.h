@@ -0,0 +1,107 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "camera_config/camera_config.h"
+
+// Where camera_node gets its frames from
+//
+// A source settles on a capture mode when it is opened, then hands out
+// frames one at a time and takes each back once it has been queued:
+//   v4l2       Camera through V4L2 mmap buffers
+//   file       Raw frames, Y4M, MJPEG or a recording replayed from an mmap'd file
+//   synthetic  Scrolling colour bars, no device or file needed
+// File and synthetic frames point into memory that stays mapped until the
+// source is closed (borrowed), so they reach the publish thread without a
+// copy; V4L2 buffers go back to the driver and have to be copied first.
+//
+// Every source has an fd for epoll. V4L2 frames are ready when the driver
+// has filled a buffer. File and synthetic sources either tick a timerfd
+// at the frame rate (realtime; a late tick skips frames like a camera
+// would) or have no fd at all: their next frame is always ready and the
+// consumer sets the pace, which makes the pipeline's maximum throughput
+// directly measurable.
+
+#define FRAME_SOURCE_V4L2_BUFFERS 4      // Driver buffers to request
+#define FRAME_SOURCE_SYNTHETIC_SCROLL 4  // Rows the test pattern moves per frame
+
+// Capture mode the source actually delivers
+typedef struct {
+    const camera_format_t* format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytesperline;      // Row stride (luma for planar), 0 for compressed formats
+    uint32_t sizeimage;         // Max bytes per frame
+    double fps;                 // 0 if the driver does not report it
+} camera_mode_t;
+
+// One frame handed out by frame_source_next
+typedef struct {
+    const uint8_t* data;
+    size_t size;
+    uint32_t sequence;          // Gaps are frames the source dropped
+    int64_t stamp_ns;           // Capture time (CLOCK_MONOTONIC)
+    bool borrowed;              // data stays valid until frame_source_close
+    int index;                  // Backend buffer, for frame_source_release
+} frame_source_frame_t;
+
+struct frame_source;
+
+typedef struct {
+    const char* name;
+    int (*open)(struct frame_source* source, const camera_config_t* config);
+    int (*start)(struct frame_source* source);
+    // 1 with a frame, 0 if none is ready yet, -1 on error
+    int (*next)(struct frame_source* source, frame_source_frame_t* frame);
+    int (*release)(struct frame_source* source, const frame_source_frame_t* frame);
+    void (*close)(struct frame_source* source);
+} frame_source_ops_t;
+
+typedef struct frame_source {
+    const frame_source_ops_t* ops;
+    void* state;                // Backend data
+    camera_mode_t mode;
+    int fd;                     // Readable when a frame may be ready, -1 = always ready
+    bool paced;                 // Delivers at its own rate (camera or timer)
+    int pace_fd;                // timerfd of realtime file/synthetic sources
+    int64_t interval_ns;        // Frame interval of pace_fd
+
+    // Written by the thread calling frame_source_next only
+    uint64_t frames;            // Frames handed out
+    uint32_t last_sequence;
+    uint64_t drops;             // Gaps in the frame sequence
+    uint64_t corrupt;           // Buffers the driver flagged as damaged, skipped
+    uint64_t unstamped;         // V4L2 buffers without a monotonic timestamp
+} frame_source_t;
+
+extern const frame_source_ops_t frame_source_v4l2_ops;
+extern const frame_source_ops_t frame_source_file_ops;
+extern const frame_source_ops_t frame_source_synthetic_ops;
+
+// Open the source config->source names and settle on a mode
+int frame_source_open(frame_source_t* source, const camera_config_t* config);
+int frame_source_start(frame_source_t* source);
+int frame_source_next(frame_source_t* source, frame_source_frame_t* frame);
+int frame_source_release(frame_source_t* source, const frame_source_frame_t* frame);
+void frame_source_close(frame_source_t* source);
+
+const char* frame_source_name(const frame_source_t* source);
+
+// Bytes per row and per frame of an uncompressed format; planar formats
+// report the luma stride. Returns -1 for compressed formats.
+int frame_source_frame_layout(const camera_format_t* format, uint32_t width, uint32_t height,
+                              uint32_t* bytesperline, uint32_t* sizeimage);
+
+// Pacing for backends without a clock of their own. With realtime set, a
+// timerfd fires every 1/fps and becomes source->fd; without it there is
+// no fd. frame_source_pace_take returns the frame periods since the last
+// call (1 when unpaced, 0 if the next frame is not due yet).
+int frame_source_pace_init(frame_source_t* source, bool realtime, double fps);
+int frame_source_pace_start(frame_source_t* source);
+uint64_t frame_source_pace_take(frame_source_t* source);
+void frame_source_pace_fini(frame_source_t* source);
+
+#endif // FRAME_SOURCE_H
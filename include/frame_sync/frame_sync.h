@@ -0,0 +1,53 @@
+#ifndef FRAME_SYNC_H
+#define FRAME_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frame sets across cameras by capture time
+//
+// Each camera's last few frames are kept. When a frame arrives, every
+// other camera's closest frame not yet in a set is looked up; if all of
+// them are within the tolerance of the new frame, they form a set and
+// are used up. Frames that never make it into a set (a camera fell
+// behind, dropped a frame, or is not in step) simply age out. Cameras
+// free-running at the same rate pair up as long as their phase offset is
+// below the tolerance; half a frame interval accepts any offset.
+//
+// Not thread-safe: callers on several threads hold their own lock.
+
+#define FRAME_SYNC_MAX_CAMERAS 4
+#define FRAME_SYNC_HISTORY 4        // Recent frames kept per camera
+
+typedef struct {
+    uint32_t sequence;          // Capture sequence
+    int64_t stamp_ns;           // Capture time (CLOCK_MONOTONIC)
+} frame_sync_frame_t;
+
+// One frame per camera, in camera order
+typedef struct {
+    frame_sync_frame_t frames[FRAME_SYNC_MAX_CAMERAS];
+    int64_t earliest_ns;
+    int64_t spread_ns;          // Latest minus earliest capture
+} frame_sync_set_t;
+
+typedef struct {
+    int cameras;
+    int64_t tolerance_ns;
+    frame_sync_frame_t history[FRAME_SYNC_MAX_CAMERAS][FRAME_SYNC_HISTORY];
+    int filled[FRAME_SYNC_MAX_CAMERAS];
+    int next[FRAME_SYNC_MAX_CAMERAS];
+    int64_t used_ns[FRAME_SYNC_MAX_CAMERAS]; // Frames up to here are in a set or skipped
+
+    uint64_t frames;            // Frames added
+    uint64_t sets;              // Sets formed
+    int64_t max_spread_ns;
+} frame_sync_t;
+
+int frame_sync_init(frame_sync_t* sync, int cameras, int64_t tolerance_ns);
+
+// Add camera's newest frame. Returns 1 and fills set if it completes one.
+int frame_sync_add(frame_sync_t* sync, int camera, uint32_t sequence, int64_t stamp_ns,
+                   frame_sync_set_t* set);
+
+#endif // FRAME_SYNC_H
@@ -0,0 +1,31 @@
+#ifndef IMAGE_MESSAGE_H
+#define IMAGE_MESSAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <rosidl_runtime_c/string.h>
+#include <sensor_msgs/msg/image.h>
+
+// Per-frame preparation of sensor_msgs/Image for rcl_publish
+//
+// The camera node keeps one message and refills it for every frame, and
+// the display keeps one per mailbox buffer. Buffers are reserved from the
+// negotiated format up front and only ever grow, and strings are rewritten
+// in place, so once the first frame fits a fill is one memcpy plus the
+// geometry fields and allocates nothing. Kept apart from the nodes so the
+// benchmarks time (and count allocations in) exactly what the nodes run.
+
+// Size msg for frames of up to size bytes in encoding, before the first
+// frame arrives
+int image_message_reserve(sensor_msgs__msg__Image* msg, size_t size, const char* encoding);
+
+// Copy size bytes of frame data into msg and set its geometry and encoding
+int image_message_fill(sensor_msgs__msg__Image* msg, const void* data, size_t size,
+                       uint32_t width, uint32_t height, uint32_t step, const char* encoding);
+
+// Set str to text, in place unless its buffer is too small. Unlike
+// rosidl_runtime_c__String__assign this does not reallocate every call.
+int image_message_set_string(rosidl_runtime_c__String* str, const char* text);
+
+#endif // IMAGE_MESSAGE_H
@@ -0,0 +1,32 @@
+#ifndef IMAGE_MESSAGE_CDR_H
+#define IMAGE_MESSAGE_CDR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <sensor_msgs/msg/image.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
+
+// Reading frames straight from their serialized (CDR) form
+//
+// rcl_take deserializes into the caller's message, and the typesupport
+// reallocates every string and resizes the data sequence while doing so:
+// several allocations per frame. Taking the serialized message instead
+// (rcl_take_serialized_message into a buffer that is kept) and reading it
+// here allocates nothing, and for images the pixels are not copied a
+// second time: the view points into the serialized buffer.
+//
+// Handles plain CDR and XCDR2 in either byte order, as written by the
+// RMWs for these final types. Returns -1 for anything truncated or
+// malformed.
+
+// Fill view with pointers into buffer (length bytes). The view borrows
+// buffer: it is valid while buffer is and must never be finalized.
+int image_message_cdr_view(const uint8_t* buffer, size_t length, sensor_msgs__msg__Image* view);
+
+// Decode a serialized FrameDescriptor into msg. Its strings are rewritten
+// in place, so once they have held names this long nothing is allocated.
+int image_message_cdr_read_descriptor(const uint8_t* buffer, size_t length,
+                                      embedded_object_detection_pi5__msg__FrameDescriptor* msg);
+
+#endif // IMAGE_MESSAGE_CDR_H
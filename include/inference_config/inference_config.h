@@ -0,0 +1,77 @@
+#ifndef INFERENCE_CONFIG_H
+#define INFERENCE_CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <rcl/rcl.h>
+
+#include "onnx_session/onnx_session.h"
+#include "stage_pipeline/stage_pipeline.h"
+
+// Runtime inference settings
+//
+// Defaults come from the INFERENCE_* defines in inference_node.h and are
+// overridden by ROS parameters, then by command-line flags, like the
+// camera settings.
+//
+// Parameters / flags:
+//   model              / --model               ONNX model path
+//   input_size         / --input-size          Tensor size for models with a dynamic input
+//   intra_op_threads   / --intra-op-threads    Threads per operator, 0 = one per core
+//   inter_op_threads   / --inter-op-threads    Parallel operators (> 1 = parallel mode)
+//   graph_optimization / --graph-optimization  disable, basic, extended or all
+//   cpu_mem_arena      / --cpu-mem-arena       Arena allocator (true/false)
+//   mem_pattern        / --mem-pattern         Preplanned activation memory (true/false)
+//   allow_spinning     / --allow-spinning      Busy-waiting pool threads (true/false)
+//   conf_threshold     / --conf-threshold      Minimum detection score
+//   iou_threshold      / --iou-threshold       NMS overlap limit
+//   max_detections     / --max-detections      Detections per frame
+//   max_in_flight      / --max-in-flight       Frames between intake and publish (1-8)
+//   queue_depth        / --queue-depth         Frames waiting in front of each stage (1-8)
+//   drop_policy        / --drop-policy         Frame to drop when full: oldest or newest
+//   max_frame_age_ms   / --max-frame-age-ms    Skip frames older than this, 0 = never
+//   tracking           / --tracking            Track between detector runs (true/false)
+//   detect_interval_min / --detect-interval-min Fewest frames between detector runs
+//   detect_interval_max / --detect-interval-max Most frames between detector runs
+//   detector_budget    / --detector-budget     Share of the frame time the detector may use
+//   track_confidence   / --track-confidence    Run the detector early below this track score
+//   benchmark          / --benchmark           Run N synthetic frames offline and exit
+//   expect_test_model  / --expect-test-model   Fail the benchmark unless it finds the
+//                                              detections of scripts/make_test_model.py
+
+#define INFERENCE_CONFIG_PATH_MAX 256
+
+typedef struct {
+    char model[INFERENCE_CONFIG_PATH_MAX];
+    uint32_t input_size;
+    onnx_session_options_t session;
+    float conf_threshold;
+    float iou_threshold;
+    uint32_t max_detections;
+    uint32_t max_in_flight;
+    uint32_t queue_depth;
+    stage_pipeline_policy_t drop_policy;
+    uint32_t max_frame_age_ms;
+    bool tracking;
+    uint32_t detect_interval_min;
+    uint32_t detect_interval_max;
+    float detector_budget;
+    float track_confidence;
+    uint32_t benchmark_frames;  // 0 = subscribe to the camera
+    bool expect_test_model;
+} inference_config_t;
+
+void inference_config_init(inference_config_t* config, const char* model, uint32_t input_size,
+                           int intra_op_threads, int inter_op_threads);
+
+// Apply ROS parameter overrides for node_name (and the /** wildcard)
+int inference_config_load_params(inference_config_t* config, const rcl_arguments_t* arguments,
+                                 const char* node_name);
+
+// Apply --flag value pairs; arguments inside --ros-args ... -- are skipped
+int inference_config_parse_args(inference_config_t* config, int argc, char* argv[]);
+
+void inference_config_log(const inference_config_t* config);
+
+#endif // INFERENCE_CONFIG_H
@@ -0,0 +1,178 @@
+#ifndef INFERENCE_NODE_H
+#define INFERENCE_NODE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// ROS2 includes
+#include <rcl/rcl.h>
+#include <sensor_msgs/msg/image.h>
+#include <vision_msgs/msg/detection2_d_array.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
+
+#include "frame_ring/frame_ring.h"
+#include "inference_config/inference_config.h"
+#include "latency_diagnostics/latency_diagnostics.h"
+#include "onnx_session/onnx_session.h"
+#include "postprocess/postprocess.h"
+#include "preprocess/preprocess.h"
+#include "stage_pipeline/stage_pipeline.h"
+#include "tracker/tracker.h"
+
+// Inference configuration (defaults, see inference_config.h for overrides)
+#define INFERENCE_USE_FRAME_RING 1      // Read frames from the camera's shared-memory ring
+#define INFERENCE_IMAGE_TOPIC "/camera/image_raw"
+#define INFERENCE_DESCRIPTOR_TOPIC "/camera/frame_descriptor"
+#define INFERENCE_RING_REOPEN_AFTER 30  // Remap the ring after this many stale descriptors
+#define INFERENCE_DETECTIONS_TOPIC "/detections"
+#define INFERENCE_MODEL_PATH "model.onnx"
+#define INFERENCE_INPUT_SIZE 640        // Tensor size if the model input is dynamic
+#define INFERENCE_INTRA_OP_THREADS 3    // Leave a Pi 5 core for capture and ROS
+#define INFERENCE_INTER_OP_THREADS 1
+#define INFERENCE_PAD_VALUE 114         // Letterbox gray used by YOLO training
+#define INFERENCE_STATS_INTERVAL 100    // Log pipeline statistics every N frames
+#define INFERENCE_BENCHMARK_WIDTH 640   // Synthetic frame size for --benchmark
+#define INFERENCE_BENCHMARK_HEIGHT 480
+#define INFERENCE_TRACK_REQUESTS 16     // Detector frames awaiting their result (tracking)
+#define INFERENCE_TRACK_RESULTS 8       // Detector results awaiting the intake thread
+#define INFERENCE_STILL_INTERVAL 30     // Detect on every Nth frame the camera marks still
+
+typedef enum {
+    INFERENCE_STAGE_PREPROCESS = 0,
+    INFERENCE_STAGE_INFERENCE,
+    INFERENCE_STAGE_POSTPROCESS,
+    INFERENCE_STAGE_COUNT
+} inference_stage_t;
+
+// One pipeline slot: the camera frame and how its tensor maps back onto
+// it. The slot's tensors are session.slots[n] with the same index.
+typedef struct {
+    sensor_msgs__msg__Image image;
+    preprocess_letterbox_t letterbox;
+    uint64_t step;              // Camera frame number (tracking)
+    int64_t take_ns;            // CLOCK_MONOTONIC when intake took the frame
+} inference_frame_t;
+
+// A frame sent to the detector, with the tracker as it was at that frame
+typedef struct {
+    uint64_t step;
+    int64_t submit_ns;
+    tracker_state_t state;
+} inference_request_t;
+
+// Detections the postprocess stage hands back to the intake thread
+typedef struct {
+    uint64_t step;
+    int count;
+    postprocess_detection_t* detections; // max_detections
+} inference_result_t;
+
+// Inference node structure
+//
+// The main thread takes frames and hands them to a three-stage pipeline
+// (preprocess -> inference -> postprocess and publish), each stage on its
+// own thread, so up to max_in_flight frames are processed at once.
+//
+// With tracking, only every detect_interval-th frame goes to the pipeline.
+// The postprocess stage hands its detections back instead of publishing
+// them, and the main thread publishes the tracker's boxes for every camera
+// frame. A result arrives a few frames after its frame was taken: the
+// tracker is rewound to that frame, updated, and predicted forward again.
+typedef struct {
+    inference_config_t config;
+
+    // Model and the stages around it, all sized once at startup. Each is
+    // only used by its own stage thread.
+    onnx_session_t session;
+    bool session_ready;
+    preprocess_t preprocess;
+    bool preprocess_ready;
+    postprocess_t postprocess;
+    bool postprocess_ready;
+    postprocess_detection_t* detections;
+    int detection_count;        // In the last published frame
+
+    // Stage scheduler and its slots
+    stage_pipeline_t pipeline;
+    bool pipeline_ready;
+    inference_frame_t frames[STAGE_PIPELINE_MAX_SLOTS];
+    int frame_count;            // Initialized frames
+
+    // ROS2 components (not used by --benchmark)
+    bool ros_ready;
+    rcl_node_t node;
+    rcl_subscription_t subscription;
+    bool raw_subscribed;        // subscription is active
+    rcl_publisher_t publisher;
+    bool publisher_ready;
+    rcl_wait_set_t wait_set;
+    sensor_msgs__msg__Image discard; // Takes raw frames no slot is free for
+    vision_msgs__msg__Detection2DArray detections_msg;
+    bool messages_ready;
+
+    // Tracking (main thread, apart from the results queue)
+    bool tracking;              // config.tracking, and not --benchmark
+    tracker_t tracker;
+    bool tracker_ready;
+    uint64_t step;              // Camera frames tracked
+    uint64_t last_request_step; // Last frame sent to the detector
+    inference_request_t* requests; // Ring of INFERENCE_TRACK_REQUESTS, oldest first
+    int request_head;
+    int request_count;
+    postprocess_detection_t* track_detections; // Result being applied
+    tracker_output_t track_output[TRACKER_MAX_TRACKS];
+    int detect_interval;        // Current N, adapted to the detector latency
+    double latency_ns;          // Detector latency, moving average
+    double frame_interval_ns;   // Camera frame interval, moving average
+    int64_t last_frame_ns;
+    uint64_t track_frames;      // Since the last tracking statistics
+    uint64_t track_requests;
+    uint64_t track_results;
+
+    pthread_mutex_t results_mutex; // Guards the results queue
+    bool results_ready;
+    inference_result_t results[INFERENCE_TRACK_RESULTS];
+    int result_head;
+    int result_count;
+    uint64_t results_dropped;   // Overwritten before the intake thread got to them
+
+    // Shared-memory frame ring (same-host fast path)
+    bool ring_subscribed;       // descriptor_subscription is active
+    rcl_subscription_t descriptor_subscription;
+    embedded_object_detection_pi5__msg__FrameDescriptor* descriptor_msg;
+    frame_ring_t frame_ring;
+    bool ring_open;
+    uint64_t ring_frames;       // Frames received from the ring
+    uint64_t ring_stale;        // Descriptors whose slot was already recycled
+    int still_run;              // Still frames in a row
+    uint64_t still_skipped;     // Still frames kept from the detector
+
+    // Statistics
+    uint64_t frames_received;
+    uint64_t frames_processed;  // Published (postprocess thread)
+    uint64_t frames_unsupported; // Encodings the preprocessor cannot read
+    uint64_t detections_published;
+
+    // Capture -> take -> publish histograms on /diagnostics
+    latency_diagnostics_t latency;
+    bool latency_ready;
+
+    // State
+    bool is_running;
+} inference_node_t;
+
+// Function declarations; context may be NULL for an offline benchmark
+int inference_node_init(inference_node_t* inference, rcl_context_t* context,
+                        const inference_config_t* config);
+void inference_node_fini(inference_node_t* inference);
+int inference_node_spin(inference_node_t* inference);
+
+// Frame ring helper: copy the frame a descriptor points at into frame
+int inference_node_handle_descriptor(inference_node_t* inference,
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc,
+    inference_frame_t* frame);
+
+// Run config.benchmark_frames synthetic frames and log the statistics
+int inference_node_benchmark(inference_node_t* inference);
+
+#endif // INFERENCE_NODE_H
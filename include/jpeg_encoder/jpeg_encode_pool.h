@@ -0,0 +1,69 @@
+#ifndef JPEG_ENCODE_POOL_H
+#define JPEG_ENCODE_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "jpeg_encoder/jpeg_encoder.h"
+
+// Asynchronous JPEG encoder threads
+//
+// Each worker owns one frame buffer and one encoder. jpeg_encode_pool_submit
+// never blocks: it copies the frame into an idle worker and posts its
+// semaphore, or drops the frame if every worker is still busy. Finished
+// JPEGs are handed to the done callback on the worker thread; with more
+// than one worker, callbacks can arrive out of order (see sequence).
+
+typedef struct {
+    const char* encoding;       // Must outlive the encode (string literal)
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    size_t size;
+    uint64_t sequence;
+    int64_t stamp_ns;
+} jpeg_encode_frame_t;
+
+typedef void (*jpeg_encode_done_fn)(void* ctx, const jpeg_encode_frame_t* frame,
+                                    const uint8_t* jpeg, size_t jpeg_size);
+
+typedef struct jpeg_encode_pool jpeg_encode_pool_t;
+
+typedef struct {
+    jpeg_encode_pool_t* pool;
+    pthread_t thread;
+    sem_t wake;
+    int busy;                   // Atomic: 1 from submit until the callback returned
+    jpeg_encoder_t encoder;
+    uint8_t* data;
+    jpeg_encode_frame_t frame;
+} jpeg_encode_worker_t;
+
+struct jpeg_encode_pool {
+    jpeg_encode_worker_t* workers;
+    int worker_count;
+    size_t frame_capacity;
+    int stop;                   // Atomic
+    jpeg_encode_done_fn done;
+    void* ctx;
+
+    // Statistics (atomic)
+    uint64_t submitted;
+    uint64_t busy_drops;        // Frames dropped because every worker was busy
+    uint64_t encoded;
+    uint64_t failed;
+};
+
+int jpeg_encode_pool_init(jpeg_encode_pool_t* pool, int threads, size_t frame_capacity,
+                          int quality, jpeg_encode_done_fn done, void* ctx);
+void jpeg_encode_pool_fini(jpeg_encode_pool_t* pool);
+
+// Returns 0 if queued, 1 if dropped because all workers are busy, -1 if
+// the frame does not fit
+int jpeg_encode_pool_submit(jpeg_encode_pool_t* pool, const uint8_t* data,
+                            const jpeg_encode_frame_t* frame);
+
+#endif // JPEG_ENCODE_POOL_H
@@ -0,0 +1,35 @@
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// JPEG frame encoder (libjpeg-turbo)
+//
+// YUV inputs (yuv422_yuy2, uyvy, nv12, i420) are handed to libjpeg as raw
+// 4:2:0 Y/Cb/Cr planes, one 16-row strip at a time, so there is no color
+// conversion: 4:2:0 sources are only deinterleaved, 4:2:2 sources also
+// average each pair of chroma rows. rgb8, bgr8 and mono8 go through
+// libjpeg's own conversion.
+
+struct jpeg_encoder_impl;
+
+typedef struct {
+    struct jpeg_encoder_impl* impl;
+    int quality;                // 1-100
+} jpeg_encoder_t;
+
+int jpeg_encoder_init(jpeg_encoder_t* encoder, int quality);
+void jpeg_encoder_fini(jpeg_encoder_t* encoder);
+
+// True if frames in this sensor_msgs/Image encoding can be compressed
+bool jpeg_encoder_supports(const char* encoding);
+
+// Compress one frame. *jpeg points into the encoder's output buffer and
+// stays valid until the next call. Returns 0, or -1 on failure.
+int jpeg_encoder_encode(jpeg_encoder_t* encoder, const uint8_t* data, const char* encoding,
+                        uint32_t width, uint32_t height, uint32_t step,
+                        const uint8_t** jpeg, size_t* jpeg_size);
+
+#endif // JPEG_ENCODER_H
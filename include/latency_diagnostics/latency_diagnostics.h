@@ -0,0 +1,61 @@
+#ifndef LATENCY_DIAGNOSTICS_H
+#define LATENCY_DIAGNOSTICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <rcl/rcl.h>
+#include <diagnostic_msgs/msg/diagnostic_array.h>
+
+#include "latency_trace/latency_trace.h"
+
+// Per-stage latency histograms published as diagnostic_msgs/DiagnosticArray
+//
+// A node names its stages once (e.g. "capture_to_dequeue"), records a
+// latency per frame and stage from any thread, and calls tick from one
+// thread. Every LATENCY_DIAGNOSTICS_PERIOD_MS, tick publishes one status
+// with p50/p95/p99/max in milliseconds and the frame count per stage, then
+// starts a new window. The last stage is the end-to-end one and goes into
+// the status message.
+
+#define LATENCY_DIAGNOSTICS_TOPIC "/diagnostics"
+#define LATENCY_DIAGNOSTICS_PERIOD_MS 5000
+#define LATENCY_DIAGNOSTICS_MAX_STAGES 6
+#define LATENCY_DIAGNOSTICS_VALUES 5    // Key/value pairs per stage
+
+typedef struct {
+    rcl_node_t* node;
+    rcl_publisher_t publisher;
+    diagnostic_msgs__msg__DiagnosticArray msg;
+    bool msg_ready;
+
+    int stage_count;
+    const char* stages[LATENCY_DIAGNOSTICS_MAX_STAGES];
+
+    // Current window, recorded under mutex
+    pthread_mutex_t mutex;
+    latency_histogram_t histograms[LATENCY_DIAGNOSTICS_MAX_STAGES];
+
+    // Copy being published (tick thread only)
+    latency_histogram_t snapshot[LATENCY_DIAGNOSTICS_MAX_STAGES];
+    int64_t window_start_ns;
+    uint64_t published;
+} latency_diagnostics_t;
+
+// name is the status name prefix, usually the node name
+int latency_diagnostics_init(latency_diagnostics_t* diagnostics, rcl_node_t* node,
+                             const char* name, const char* const* stages, int stage_count);
+void latency_diagnostics_fini(latency_diagnostics_t* diagnostics);
+
+void latency_diagnostics_record(latency_diagnostics_t* diagnostics, int stage, int64_t latency_ns);
+
+// Publish and restart the window once the period is over (now_ns is
+// CLOCK_MONOTONIC). Returns 1 if published, 0 if not due, -1 on error.
+int latency_diagnostics_tick(latency_diagnostics_t* diagnostics, int64_t now_ns);
+
+// Header stamps (CLOCK_REALTIME) from and to CLOCK_MONOTONIC nanoseconds
+void latency_stamp_from_monotonic(builtin_interfaces__msg__Time* stamp, int64_t monotonic_ns);
+int64_t latency_stamp_to_monotonic(const builtin_interfaces__msg__Time* stamp);
+
+#endif // LATENCY_DIAGNOSTICS_H
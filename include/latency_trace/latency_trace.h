@@ -0,0 +1,47 @@
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Latency tracing: clock conversion and latency histograms
+//
+// Capture stamps are CLOCK_MONOTONIC, like V4L2 buffer timestamps, while
+// ROS headers carry CLOCK_REALTIME. Stamps are moved between the two with
+// the current offset of the clocks, so any process on the host can turn a
+// header stamp back into monotonic time and measure against its own clock,
+// unaffected by wall clock steps between capture and measurement.
+//
+// Histograms are log-linear over microseconds: exact below 16 us, then 16
+// buckets per power of two, so a percentile is within 1/32 (3%) of the
+// true value. Recording is a few instructions and never allocates.
+
+#define LATENCY_HISTOGRAM_SUB_BITS 4    // 2^4 buckets per power of two
+#define LATENCY_HISTOGRAM_MAX_BITS 32   // Up to 2^32 us (71 minutes)
+#define LATENCY_HISTOGRAM_BUCKETS \
+    ((LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BITS + 1) << LATENCY_HISTOGRAM_SUB_BITS)
+
+typedef struct {
+    uint32_t counts[LATENCY_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    int64_t sum_ns;
+    int64_t max_ns;
+} latency_histogram_t;
+
+int64_t latency_monotonic_ns(void);
+
+// CLOCK_REALTIME - CLOCK_MONOTONIC right now
+int64_t latency_realtime_offset_ns(void);
+
+void latency_histogram_reset(latency_histogram_t* histogram);
+
+// Negative latencies (clock offset jitter) count as 0
+void latency_histogram_record(latency_histogram_t* histogram, int64_t latency_ns);
+
+// Latency below which percentile (0-100) of the samples fall, at the
+// middle of its bucket and never above the maximum; 0 if empty
+int64_t latency_histogram_percentile(const latency_histogram_t* histogram, double percentile);
+
+double latency_histogram_mean_ns(const latency_histogram_t* histogram);
+
+#endif // LATENCY_TRACE_H
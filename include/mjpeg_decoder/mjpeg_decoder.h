@@ -0,0 +1,61 @@
+#ifndef MJPEG_DECODER_H
+#define MJPEG_DECODER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// MJPEG frame decoder (libjpeg-turbo)
+//
+// YUV outputs skip libjpeg's color conversion and upsampling entirely:
+// the Y/Cb/Cr planes are read with raw_data_out and only re-interleaved
+// (YUYV) or resampled (I420) afterwards. Downscaling by 2, 4 or 8 happens
+// in the DCT domain, so a scaled decode is cheaper than a full one.
+//
+// USB cameras regularly deliver truncated or garbled frames. A frame is
+// rejected if it lacks the SOI/EOI markers, has unexpected dimensions, or
+// libjpeg reports any error or warning (e.g. premature end of data);
+// decoding stops at the first problem instead of producing a smeared image.
+
+typedef enum {
+    MJPEG_OUTPUT_YUYV = 0,      // Packed 4:2:2, encoding yuv422_yuy2
+    MJPEG_OUTPUT_I420,          // Planar 4:2:0, encoding i420
+    MJPEG_OUTPUT_RGB24          // Packed RGB, encoding rgb8
+} mjpeg_output_t;
+
+struct mjpeg_decoder_impl;
+
+typedef struct {
+    struct mjpeg_decoder_impl* impl;
+    mjpeg_output_t output;
+    int scale_denom;            // 1, 2, 4 or 8
+    uint64_t decoded;           // Frames decoded
+    uint64_t corrupt;           // Frames rejected
+} mjpeg_decoder_t;
+
+int mjpeg_decoder_init(mjpeg_decoder_t* decoder, mjpeg_output_t output, int scale_denom);
+void mjpeg_decoder_fini(mjpeg_decoder_t* decoder);
+
+// Geometry of decoded frames for a width x height stream
+void mjpeg_decoder_output_size(const mjpeg_decoder_t* decoder, uint32_t width, uint32_t height,
+                               uint32_t* out_width, uint32_t* out_height,
+                               uint32_t* out_step, size_t* out_size);
+
+// Read only the frame header. Returns 0 and the full-size dimensions, or
+// -1 if the header is unreadable.
+int mjpeg_decoder_peek_size(mjpeg_decoder_t* decoder, const uint8_t* jpeg, size_t size,
+                            uint32_t* width, uint32_t* height);
+
+// Decode one frame into dst (out_step bytes per row, see
+// mjpeg_decoder_output_size). expected_width/height of 0 accept any size.
+// Returns 0 on success, -1 if the frame was rejected.
+int mjpeg_decoder_decode(mjpeg_decoder_t* decoder, const uint8_t* jpeg, size_t size,
+                         uint32_t expected_width, uint32_t expected_height,
+                         uint8_t* dst, size_t dst_capacity);
+
+// Cheap structural check: SOI at the start, EOI at the end (padding allowed)
+bool mjpeg_frame_looks_complete(const uint8_t* jpeg, size_t size);
+
+const char* mjpeg_output_encoding(mjpeg_output_t output);
+
+#endif // MJPEG_DECODER_H
@@ -0,0 +1,29 @@
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// File-backed MJPEG stream
+//
+// Maps a file of concatenated JPEG frames (e.g. `ffmpeg -i in.mp4 -c:v
+// mjpeg -f mjpeg out.mjpeg`, or a raw capture dump) and hands out one
+// frame at a time without copying. Frames are split at each SOI marker
+// (FF D8 FF), which cannot occur inside entropy-coded data, so truncated
+// frames without an EOI still come out as separate (corrupt) frames.
+
+typedef struct {
+    int fd;
+    const uint8_t* data;
+    size_t size;
+    size_t offset;              // Start of the next frame
+} mjpeg_stream_t;
+
+int mjpeg_stream_open(mjpeg_stream_t* stream, const char* path);
+void mjpeg_stream_close(mjpeg_stream_t* stream);
+
+// Next frame, valid until mjpeg_stream_close. Returns 1, or 0 at the end.
+int mjpeg_stream_next(mjpeg_stream_t* stream, const uint8_t** frame, size_t* size);
+void mjpeg_stream_rewind(mjpeg_stream_t* stream);
+
+#endif // MJPEG_STREAM_H
@@ -0,0 +1,114 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "color_convert/color_convert.h"
+
+// Motion gate: cheap change detection on the luma of YUYV frames
+//
+// Only the Y samples are read, optionally every Nth sample of every Nth
+// row (decimation). The frame is compared block by block against a running
+// background: a block changed when its sum of absolute differences (SAD)
+// exceeds threshold per sample. The result says whether the frame moved at
+// all, which blocks changed (mask) and their bounding box, so consumers can
+// skip still frames or only redo the dirty region.
+//
+// One pass per row does everything: pick the Y samples out of the YUYV
+// bytes, SAD them against the background 16 samples at a time
+// (psadbw / vabd) and move the background toward them:
+//
+//   background += (y - background + 2^(shift-1)) >> shift
+//
+// All kernels produce identical SADs and backgrounds. Samples past the
+// last full 16 of a row are handled by the scalar tail.
+
+#define MOTION_GATE_CHUNK 16            // Samples per SAD step
+#define MOTION_GATE_BLOCK 16            // Default block edge, in decimated samples
+#define MOTION_GATE_THRESHOLD 10        // Default mean absolute difference of a changed block
+
+typedef struct {
+    int block_size;             // Block edge in decimated samples, multiple of 16
+    int decimation;             // Read every 1st, 2nd or 4th sample and row
+    int threshold;              // Mean absolute difference per sample of a changed block
+    int min_blocks;             // Changed blocks before a frame counts as motion
+    int background_shift;       // Background follows each frame by 1/2^shift (0 = last frame)
+    int hold_frames;            // Frames motion is still reported after it stops
+} motion_gate_config_t;
+
+typedef struct {
+    bool motion;                // Changed blocks, or within hold_frames of some
+    float score;                // Share of blocks that changed, 0-1
+    int changed_blocks;
+    int x, y;                   // Bounding box of the changed blocks plus one
+    int width, height;          // block around, in frame pixels; 0 x 0 if none
+} motion_gate_result_t;
+
+// One row: the Y samples of yuyv (every decimation-th) against background.
+// Adds the SAD of every 16 samples to sad[i / 16] and updates background.
+typedef void (*motion_gate_row_fn)(const uint8_t* yuyv, int decimation, uint8_t* background,
+                                   int samples, int shift, uint32_t* sad);
+
+typedef struct {
+    motion_gate_config_t config;
+
+    // Sized for the current frame geometry
+    int width;
+    int height;
+    int samples;                // Decimated samples per row
+    int rows;                   // Decimated rows
+    int chunks;                 // SAD sums per row, ceil(samples / 16)
+    int blocks_x;
+    int blocks_y;
+    uint8_t* background;        // samples x rows
+    uint32_t* chunk_sad;        // chunks, one block row at a time
+    uint8_t* mask;              // blocks_x x blocks_y, 1 = changed
+    bool primed;                // background holds a frame
+    int hold;                   // Frames left to report motion
+
+    color_convert_isa_t isa;
+    motion_gate_row_fn row;
+} motion_gate_t;
+
+// Defaults: 16x16 blocks, every 2nd sample and row, threshold 10, one
+// block, background shift 3, motion held for 10 frames
+void motion_gate_config_default(motion_gate_config_t* config);
+
+int motion_gate_init(motion_gate_t* gate, const motion_gate_config_t* config);
+void motion_gate_fini(motion_gate_t* gate);
+
+// Compare one YUYV frame (step bytes per row) with the background and
+// update it. The first frame, and the first after a size change, is all
+// motion. Allocates only when the frame size changes.
+int motion_gate_run(motion_gate_t* gate, const uint8_t* yuyv, int step, int width, int height,
+                    motion_gate_result_t* result);
+
+// Forget the background, so the next frame counts as motion
+void motion_gate_reset(motion_gate_t* gate);
+
+// Widen rows [*y, *y + *height) to also cover [other_y, other_y + other_height);
+// an empty band adds nothing. The dirty box is measured against the
+// background, so rows an object just left may not be in the next frame's
+// box: a consumer redrawing only dirty rows has to redraw the union of the
+// previous frame's box and this one's.
+void motion_gate_union_rows(int* y, int* height, int other_y, int other_height);
+
+// Row kernels (NULL if not built for this ISA)
+motion_gate_row_fn motion_gate_get_row(color_convert_isa_t isa);
+
+void motion_gate_row_scalar(const uint8_t* yuyv, int decimation, uint8_t* background,
+                            int samples, int shift, uint32_t* sad);
+
+#if defined(__x86_64__) || defined(__i386__)
+void motion_gate_row_sse2(const uint8_t* yuyv, int decimation, uint8_t* background,
+                          int samples, int shift, uint32_t* sad);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+void motion_gate_row_neon(const uint8_t* yuyv, int decimation, uint8_t* background,
+                          int samples, int shift, uint32_t* sad);
+#endif
+
+#endif // MOTION_GATE_H
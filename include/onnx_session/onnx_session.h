@@ -0,0 +1,89 @@
+#ifndef ONNX_SESSION_H
+#define ONNX_SESSION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <onnxruntime_c_api.h>
+
+// ONNX Runtime session with pre-bound tensors (CPU execution provider)
+//
+// The session, its input tensor and every output tensor are created once
+// in onnx_session_init. Inputs and outputs wrap buffers owned by this
+// struct and are bound through an OrtIoBinding, so onnx_session_run
+// performs no allocation of its own: fill slots[n].input, run slot n, read
+// slots[n].outputs. Outputs with dynamic dimensions are sized by one probe
+// inference at init.
+//
+// Each slot has its own buffers and binding, so a pipeline can fill the
+// input of one frame and decode the outputs of another while a third is
+// being inferred.
+
+#define ONNX_SESSION_MAX_OUTPUTS 4
+#define ONNX_SESSION_MAX_DIMS 8
+#define ONNX_SESSION_MAX_SLOTS 8
+
+typedef struct {
+    int intra_op_threads;       // Threads inside one operator, 0 = ORT default (one per core)
+    int inter_op_threads;       // Threads across independent operators, > 1 enables parallel mode
+    GraphOptimizationLevel graph_optimization;
+    bool cpu_mem_arena;         // Reuse CPU allocations across runs
+    bool mem_pattern;           // Preplan activation memory from the first run
+    bool allow_spinning;        // Let idle pool threads busy-wait for work
+} onnx_session_options_t;
+
+// Name and shape of a model input or output
+typedef struct {
+    char* name;
+    size_t count;               // Elements
+    int64_t dims[ONNX_SESSION_MAX_DIMS];
+    size_t dim_count;
+} onnx_tensor_t;
+
+// One set of bound tensors
+typedef struct {
+    float* input;
+    float* outputs[ONNX_SESSION_MAX_OUTPUTS];
+    OrtValue* input_value;
+    OrtValue* output_values[ONNX_SESSION_MAX_OUTPUTS];
+    OrtIoBinding* binding;
+} onnx_session_slot_t;
+
+typedef struct {
+    const OrtApi* api;
+    OrtEnv* env;
+    OrtSession* session;
+    OrtMemoryInfo* memory_info;
+    OrtRunOptions* run_options;
+
+    onnx_tensor_t input;        // float32 NCHW
+    onnx_tensor_t outputs[ONNX_SESSION_MAX_OUTPUTS];
+    size_t output_count;
+
+    onnx_session_slot_t slots[ONNX_SESSION_MAX_SLOTS];
+    int slot_count;
+} onnx_session_t;
+
+// Defaults: all cores, 1 inter-op thread, all optimizations, arena and
+// memory pattern on, no spinning
+void onnx_session_options_default(onnx_session_options_t* options);
+
+// Parse "disable", "basic", "extended" or "all"; -1 if unknown
+int onnx_session_parse_optimization(const char* name, GraphOptimizationLevel* level);
+
+// Dynamic input height/width are resolved with input_height/input_width;
+// slot_count (1-ONNX_SESSION_MAX_SLOTS) sets of tensors are bound
+int onnx_session_init(onnx_session_t* session, const char* model_path,
+                      const onnx_session_options_t* options,
+                      int input_width, int input_height, int slot_count);
+void onnx_session_fini(onnx_session_t* session);
+
+// Infer slots[slot]; different slots may run from different threads
+int onnx_session_run(onnx_session_t* session, int slot);
+
+// Input tensor height/width (NCHW)
+int onnx_session_input_width(const onnx_session_t* session);
+int onnx_session_input_height(const onnx_session_t* session);
+
+#endif // ONNX_SESSION_H
@@ -0,0 +1,39 @@
+#ifndef PIPELINE_NODE_H
+#define PIPELINE_NODE_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+#include <rcl/rcl.h>
+
+#include "camera_node/camera_node.h"
+#include "display_node/display_node.h"
+
+// Camera and display as components of one process, in one rcl context
+//
+// The display is a sink of the camera: every published frame is handed
+// over by pointer through the camera's reference-counted frame pool, so
+// nothing is serialized or sent through DDS between them. The camera still
+// publishes /camera/image_raw and frame descriptors, but only while
+// subscribers outside the process exist. Further components (inference)
+// attach as more sinks the same way.
+//
+// SDL has to run on the main thread, so the display's render loop runs
+// there and the camera spins on its own thread. Either side stopping
+// stops the other.
+
+typedef struct {
+    camera_node_t camera;
+    display_node_t display;
+    bool camera_ready;
+    bool display_ready;
+    pthread_t camera_thread;
+    int camera_result;
+} pipeline_node_t;
+
+int pipeline_node_init(pipeline_node_t* pipeline, rcl_context_t* context, const camera_config_t* config);
+void pipeline_node_fini(pipeline_node_t* pipeline);
+int pipeline_node_spin(pipeline_node_t* pipeline);
+void pipeline_node_request_shutdown(void);
+
+#endif // PIPELINE_NODE_H
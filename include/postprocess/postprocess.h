@@ -0,0 +1,138 @@
+#ifndef POSTPROCESS_H
+#define POSTPROCESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "color_convert/color_convert.h"
+
+// YOLO output decoding and non-maximum suppression
+//
+// Two output layouts are understood, both with boxes as center x, center y,
+// width, height in tensor pixels:
+//
+//   YOLOV5  [1, candidates, 5 + classes]  cx cy w h objectness class scores
+//   YOLOV8  [1, 4 + classes, candidates]  cx cy w h class scores (no objectness)
+//
+// A candidate's score is its best class score (times objectness for YOLOv5,
+// whose rows are skipped unless objectness alone passes conf_threshold).
+// Candidates whose score passes conf_threshold are kept, the
+// pre_nms_top_k best of them ordered by score (ties: lower candidate index
+// first) and suppressed per class when their IoU with a better box of the
+// same class exceeds iou_threshold.
+//
+// postprocess_run does this without touching the heap:
+//   1. A SIMD pass takes the best class of every candidate and keeps those
+//      over the threshold (YOLOv8 scores are planar, so one vector holds
+//      several candidates; YOLOv5 rows take a vector max of the classes).
+//   2. Quickselect picks the top k, and only those k are sorted.
+//   3. Greedy NMS tests each box only against kept boxes sharing a cell of
+//      a coarse grid over the candidates, instead of every kept box.
+// postprocess_run_reference decodes everything, sorts it all and runs the
+// O(n^2) textbook NMS; both give identical detections.
+
+#define POSTPROCESS_PRE_NMS_TOP_K 1024  // Default candidates entering NMS
+#define POSTPROCESS_GRID 8              // NMS grid is GRID x GRID cells
+
+typedef enum {
+    POSTPROCESS_LAYOUT_AUTO = 0,    // Guess from the tensor shape
+    POSTPROCESS_LAYOUT_YOLOV5,
+    POSTPROCESS_LAYOUT_YOLOV8
+} postprocess_layout_t;
+
+typedef struct {
+    float x1;                   // Corners in tensor pixels
+    float y1;
+    float x2;
+    float y2;
+    float score;
+    int class_id;
+} postprocess_detection_t;
+
+typedef struct {
+    postprocess_layout_t layout;
+    float conf_threshold;
+    float iou_threshold;
+    int max_detections;
+    int pre_nms_top_k;          // Best candidates entering NMS, 0 = all
+    bool class_agnostic;        // Suppress overlapping boxes of any class
+} postprocess_config_t;
+
+// Planar filter: best class of count candidates whose class scores are rows
+// of stride floats; appends candidates scoring >= threshold to index/score/
+// class_id and returns how many. Row max: largest of count floats.
+typedef int (*postprocess_filter_fn)(const float* scores, size_t stride, int classes, int count,
+                                     float threshold, int32_t* index, float* score,
+                                     int32_t* class_id);
+typedef float (*postprocess_row_max_fn)(const float* row, int count);
+
+typedef struct {
+    postprocess_config_t config;
+    postprocess_layout_t layout;    // Resolved layout
+    int candidates;
+    int classes;
+
+    // Candidates over the threshold, filled by the filter pass
+    int32_t* hit_index;
+    float* hit_score;
+    int32_t* hit_class;
+    uint64_t* keys;             // Score bits << 32 | ~index, sorted descending
+    postprocess_detection_t* boxes; // Top k, best first
+
+    // NMS grid: kept detections overlapping each cell
+    int32_t* cell_boxes;        // GRID * GRID lists of max_detections
+    int32_t cell_count[POSTPROCESS_GRID * POSTPROCESS_GRID];
+    int32_t* visited;           // Per kept detection, last box that tested it
+
+    color_convert_isa_t isa;
+    postprocess_filter_fn filter;
+    postprocess_row_max_fn row_max;
+} postprocess_t;
+
+// Defaults: auto layout, confidence 0.25, IoU 0.45, 100 detections,
+// top 1024 candidates into NMS
+void postprocess_config_default(postprocess_config_t* config);
+
+// dims is the output tensor shape ([1, A, B] or [A, B])
+int postprocess_init(postprocess_t* pp, const postprocess_config_t* config,
+                     const int64_t* dims, size_t dim_count);
+void postprocess_fini(postprocess_t* pp);
+
+// Decode one output tensor into at most capacity detections, best first.
+// Returns the number of detections.
+int postprocess_run(postprocess_t* pp, const float* output,
+                    postprocess_detection_t* detections, int capacity);
+
+// The same result from a full decode, full sort and brute-force NMS; the
+// baseline for benchmarks and correctness checks. Allocates per call and
+// returns -1 if that fails.
+int postprocess_run_reference(const postprocess_t* pp, const float* output,
+                              postprocess_detection_t* detections, int capacity);
+
+const char* postprocess_layout_name(postprocess_layout_t layout);
+
+// Filter kernels (NULL if not built for this ISA)
+postprocess_filter_fn postprocess_get_filter(color_convert_isa_t isa);
+postprocess_row_max_fn postprocess_get_row_max(color_convert_isa_t isa);
+
+int postprocess_filter_scalar(const float* scores, size_t stride, int classes, int count,
+                              float threshold, int32_t* index, float* score, int32_t* class_id);
+float postprocess_row_max_scalar(const float* row, int count);
+
+#if defined(__x86_64__) || defined(__i386__)
+int postprocess_filter_sse2(const float* scores, size_t stride, int classes, int count,
+                            float threshold, int32_t* index, float* score, int32_t* class_id);
+float postprocess_row_max_sse2(const float* row, int count);
+int postprocess_filter_avx2(const float* scores, size_t stride, int classes, int count,
+                            float threshold, int32_t* index, float* score, int32_t* class_id);
+float postprocess_row_max_avx2(const float* row, int count);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+int postprocess_filter_neon(const float* scores, size_t stride, int classes, int count,
+                            float threshold, int32_t* index, float* score, int32_t* class_id);
+float postprocess_row_max_neon(const float* row, int count);
+#endif
+
+#endif // POSTPROCESS_H
@@ -0,0 +1,141 @@
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "color_convert/color_convert.h"
+
+// Fused YUYV -> network input tensor preprocessing
+//
+// One pass per output row does what a convert -> resize -> letterbox ->
+// normalize -> HWC-to-NCHW chain does in five:
+//
+//   - each source row that the resize actually samples is converted to
+//     RGB once (with the active color_convert kernel) and resized
+//     horizontally into a small planar row cache,
+//   - two cached rows are blended vertically, rounded to 8 bit and
+//     normalized straight into the R, G and B planes of the tensor,
+//   - letterbox borders are filled with the normalized pad value.
+//
+// Only two source rows and one output row are live at a time, so the
+// working set stays in L1/L2 whatever the frame size.
+//
+// Resizing is bilinear with half-pixel centers (like OpenCV INTER_LINEAR
+// and PyTorch align_corners=False) in 7-bit fixed point, and keeps the
+// aspect ratio. preprocess_yuyv_reference runs the same math as separate
+// full-frame passes; both produce identical results up to float rounding.
+
+typedef enum {
+    PREPROCESS_FLOAT32 = 0,     // (v - mean) / std
+    PREPROCESS_INT8             // clamp(round((v - mean) / std / int8_scale) + int8_zero_point)
+} preprocess_dtype_t;
+
+typedef struct {
+    int width;                  // Tensor width, e.g. 320, 416 or 640
+    int height;                 // Tensor height
+    preprocess_dtype_t dtype;
+    float mean[3];              // Per channel (R, G, B) on the 0-255 scale
+    float std[3];
+    float int8_scale;           // Quantization for PREPROCESS_INT8
+    int int8_zero_point;
+    uint8_t pad_value;          // Letterbox fill before normalization (e.g. 114)
+    bool bgr;                   // Planes in B, G, R order
+} preprocess_config_t;
+
+// Where the source frame ended up inside the tensor
+typedef struct {
+    float scale;                // Tensor pixels per source pixel
+    int pad_x;
+    int pad_y;
+    int resized_width;
+    int resized_height;
+} preprocess_letterbox_t;
+
+typedef void (*preprocess_vblend_f32_fn)(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                         float scale, float bias, float* dst);
+typedef void (*preprocess_vblend_s8_fn)(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                        float scale, float bias, int8_t* dst);
+
+typedef struct {
+    preprocess_config_t config;
+    preprocess_letterbox_t letterbox;
+
+    // Tables for the current source size
+    int src_width;
+    int src_height;
+    int32_t* x_index;           // Left source pixel per resized column
+    int16_t* x_weight;          // Right pixel weight, 0-128
+    int32_t* y_index;           // Top source row per resized row
+    int16_t* y_weight;          // Bottom row weight, 0-128
+
+    // Folded normalization: v * scale + bias (int8: already quantized)
+    float scale[3];
+    float bias[3];
+
+    // Row cache: two horizontally resized source rows, planar int16
+    uint8_t* rgb_row;
+    int16_t* cache[2];
+    int cache_row[2];
+
+    color_convert_isa_t isa;
+    preprocess_vblend_f32_fn vblend_f32;
+    preprocess_vblend_s8_fn vblend_s8;
+} preprocess_t;
+
+// Defaults: 640x640 float32, mean 0 / std 255 (0-1 range), pad 114, RGB
+void preprocess_config_default(preprocess_config_t* config);
+
+int preprocess_init(preprocess_t* pp, const preprocess_config_t* config);
+void preprocess_fini(preprocess_t* pp);
+
+// Bytes of one 1x3xHxW tensor
+size_t preprocess_tensor_size(const preprocess_config_t* config);
+
+// Fused pass over a YUYV frame into dst (preprocess_tensor_size bytes).
+// Updates pp->letterbox. Returns 0, or -1 on bad input.
+int preprocess_yuyv(preprocess_t* pp, const uint8_t* src, int src_stride,
+                    int src_width, int src_height, void* dst);
+
+// The same result as separate passes with full-size intermediates; the
+// baseline for benchmarks and accuracy checks
+int preprocess_yuyv_reference(const preprocess_config_t* config, const uint8_t* src, int src_stride,
+                              int src_width, int src_height, void* dst);
+
+// Letterbox geometry for a source size
+void preprocess_compute_letterbox(const preprocess_config_t* config, int src_width, int src_height,
+                                  preprocess_letterbox_t* letterbox);
+
+// Map a tensor coordinate back to the source frame
+void preprocess_to_source(const preprocess_letterbox_t* letterbox, float x, float y,
+                          float* src_x, float* src_y);
+
+// Vertical blend + normalize kernels (NULL if not built for this ISA)
+preprocess_vblend_f32_fn preprocess_get_vblend_f32(color_convert_isa_t isa);
+preprocess_vblend_s8_fn preprocess_get_vblend_s8(color_convert_isa_t isa);
+
+void preprocess_vblend_f32_scalar(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                  float scale, float bias, float* dst);
+void preprocess_vblend_s8_scalar(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                 float scale, float bias, int8_t* dst);
+
+#if defined(__x86_64__) || defined(__i386__)
+void preprocess_vblend_f32_sse2(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                float scale, float bias, float* dst);
+void preprocess_vblend_s8_sse2(const int16_t* h0, const int16_t* h1, int wy, int count,
+                               float scale, float bias, int8_t* dst);
+void preprocess_vblend_f32_avx2(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                float scale, float bias, float* dst);
+void preprocess_vblend_s8_avx2(const int16_t* h0, const int16_t* h1, int wy, int count,
+                               float scale, float bias, int8_t* dst);
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+void preprocess_vblend_f32_neon(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                float scale, float bias, float* dst);
+void preprocess_vblend_s8_neon(const int16_t* h0, const int16_t* h1, int wy, int count,
+                               float scale, float bias, int8_t* dst);
+#endif
+
+#endif // PREPROCESS_H
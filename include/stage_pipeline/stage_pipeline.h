@@ -0,0 +1,145 @@
+#ifndef STAGE_PIPELINE_H
+#define STAGE_PIPELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// Pipelined stage scheduler over a fixed set of frame slots
+//
+// Each stage runs on its own thread and works on one slot at a time, so
+// while stage 1 handles frame N, stage 0 can already start on frame N + 1.
+// Slots are indices into caller-owned per-frame state (image, tensors,
+// results); the pipeline only moves indices, so nothing is copied or
+// allocated once it is running.
+//
+//   acquire -> fill -> submit -> [queue 0] -> stage 0 -> [queue 1] -> stage 1 ...
+//
+// max_in_flight slots exist, which caps the frames anywhere between
+// submit and the end of the last stage. Every queue holds at most
+// queue_depth frames. A full queue between stages holds the upstream stage
+// back; only the entry is lossy:
+//   - no free slot or a full entry queue: DROP_OLDEST recycles the oldest
+//     frame still waiting for stage 0, DROP_NEWEST refuses the new one.
+//     Frames a stage has started are never dropped.
+//   - max_age_ns: a stage skips a frame that was submitted longer ago than
+//     this, so a stall never turns into a backlog of stale frames.
+// Live sources use stage_pipeline_acquire(..., false) and the drop policy;
+// offline sources pass wait = true to get back-pressure instead.
+
+#define STAGE_PIPELINE_MAX_STAGES 4
+#define STAGE_PIPELINE_MAX_SLOTS 8
+
+typedef enum {
+    STAGE_PIPELINE_DROP_OLDEST = 0,  // Keep the newest frames (lowest latency)
+    STAGE_PIPELINE_DROP_NEWEST       // Keep the frames already waiting
+} stage_pipeline_policy_t;
+
+// Runs one stage on a slot; non-zero ends the frame there
+typedef int (*stage_pipeline_fn)(void* context, int slot);
+
+typedef struct {
+    const char* name;
+    stage_pipeline_fn run;
+} stage_pipeline_stage_t;
+
+typedef struct {
+    int max_in_flight;          // Slots, 1-STAGE_PIPELINE_MAX_SLOTS
+    int queue_depth;            // Frames waiting in front of each stage, >= 1
+    stage_pipeline_policy_t policy;
+    int64_t max_age_ns;         // Skip frames older than this, 0 = never
+} stage_pipeline_config_t;
+
+// Per stage, since the last stage_pipeline_take_stats
+typedef struct {
+    uint64_t frames;            // Frames run
+    uint64_t failed;            // Runs that ended their frame
+    uint64_t stale;             // Frames skipped for age
+    int64_t busy_ns;            // Time spent running
+    int64_t wait_sum_ns;        // Time frames sat in the queue in front of the stage
+    int64_t wait_max_ns;
+    int64_t blocked_ns;         // Time waiting for room in the next queue
+} stage_pipeline_stage_stats_t;
+
+typedef struct {
+    int64_t interval_ns;        // Length of the measured interval
+    uint64_t submitted;
+    uint64_t completed;         // Frames through every stage
+    uint64_t dropped_oldest;
+    uint64_t dropped_newest;
+    int64_t latency_sum_ns;     // Submit to end of the last stage, completed frames
+    int64_t latency_max_ns;
+    int in_flight_max;
+    stage_pipeline_stage_stats_t stages[STAGE_PIPELINE_MAX_STAGES];
+} stage_pipeline_stats_t;
+
+// Frames waiting in front of a stage, oldest first
+typedef struct {
+    int slots[STAGE_PIPELINE_MAX_SLOTS];
+    int head;
+    int count;
+    pthread_cond_t ready;       // A frame was queued (or the pipeline stopped)
+    pthread_cond_t space;       // A frame was taken out
+} stage_pipeline_queue_t;
+
+struct stage_pipeline;
+
+// Start arguments of one stage thread
+typedef struct {
+    struct stage_pipeline* pipeline;
+    int index;
+} stage_pipeline_start_t;
+
+typedef struct stage_pipeline {
+    stage_pipeline_config_t config;
+    stage_pipeline_stage_t stages[STAGE_PIPELINE_MAX_STAGES];
+    int stage_count;
+    void* context;
+
+    pthread_mutex_t mutex;      // Guards everything below
+    pthread_cond_t slot_freed;
+    stage_pipeline_queue_t queues[STAGE_PIPELINE_MAX_STAGES];  // queues[i] feeds stages[i]
+    int free_slots[STAGE_PIPELINE_MAX_SLOTS];
+    int free_count;
+    int64_t submit_ns[STAGE_PIPELINE_MAX_SLOTS];
+    int64_t queued_ns[STAGE_PIPELINE_MAX_SLOTS];
+    bool running;
+
+    stage_pipeline_stats_t stats;
+    int64_t stats_start_ns;
+
+    pthread_t threads[STAGE_PIPELINE_MAX_STAGES];
+    stage_pipeline_start_t starts[STAGE_PIPELINE_MAX_STAGES];
+    int started;                // Stage threads actually running
+} stage_pipeline_t;
+
+// Defaults: 3 frames in flight, queues of 1, drop oldest, no age limit
+void stage_pipeline_config_default(stage_pipeline_config_t* config);
+
+// Starts one thread per stage; context is passed to every stage function
+int stage_pipeline_init(stage_pipeline_t* pipeline, const stage_pipeline_config_t* config,
+                        const stage_pipeline_stage_t* stages, int stage_count, void* context);
+
+// Stops the threads (each finishes the stage it is running) and joins them
+void stage_pipeline_fini(stage_pipeline_t* pipeline);
+
+// Slot to fill with the next frame, or -1. Without wait the drop policy
+// applies when every slot is busy; with wait it blocks until a slot is
+// free and the entry queue has room (-1 only once the pipeline stops).
+int stage_pipeline_acquire(stage_pipeline_t* pipeline, bool wait);
+
+// Queue a filled slot for stage 0, or give back one that was not filled
+void stage_pipeline_submit(stage_pipeline_t* pipeline, int slot);
+void stage_pipeline_cancel(stage_pipeline_t* pipeline, int slot);
+
+// Block until every submitted frame is through or dropped
+void stage_pipeline_wait_idle(stage_pipeline_t* pipeline);
+
+// Copy the statistics and start a new interval
+void stage_pipeline_take_stats(stage_pipeline_t* pipeline, stage_pipeline_stats_t* stats);
+
+// Parse "oldest" or "newest"; -1 if unknown
+int stage_pipeline_parse_policy(const char* name, stage_pipeline_policy_t* policy);
+const char* stage_pipeline_policy_name(stage_pipeline_policy_t policy);
+
+#endif // STAGE_PIPELINE_H
@@ -0,0 +1,134 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "postprocess/postprocess.h"
+
+// SORT-style multi-object tracker
+//
+// Every track runs a constant-velocity Kalman filter on its box center,
+// area and aspect ratio (the SORT state). tracker_predict advances all
+// tracks by one camera frame; tracker_update associates a detector result
+// with the tracks by minimum total (1 - IoU) cost (Hungarian algorithm),
+// corrects the matched tracks, starts tracks for unmatched detections and
+// ends tracks that went unmatched too often.
+//
+// The detector does not have to run every frame: tracks coast on their
+// velocity between detector runs, and their confidence decays with every
+// frame they are not confirmed, so the caller can ask for a detection once
+// it drops too low.
+//
+// SORT's state covariance never couples the coordinates, so each one is
+// filtered as an independent position/velocity pair; the result is the
+// same as the 7-state filter at a fraction of the cost.
+//
+// All tracker state lives in tracker_state_t, a plain value: copying it
+// saves the tracker and assigning it back restores it. A caller whose
+// detections arrive a few frames late can restore the state of the frame
+// that was detected, update, and predict forward again.
+
+#define TRACKER_MAX_TRACKS 64
+#define TRACKER_MAX_DETECTIONS 128  // Per update; the lowest scores beyond are ignored
+#define TRACKER_MAX_LOST 16         // Recently ended tracks, for ID switch counting
+#define TRACKER_SWITCH_WINDOW 90    // Frames a lost track counts for ID switches
+
+typedef struct {
+    float iou_threshold;        // Minimum IoU to associate a detection with a track
+    int min_hits;               // Matched detections before a track is reported
+    int max_missed;             // Detector runs a track may go unmatched before it ends
+    float confidence_decay;     // Confidence factor per frame without a detection
+    bool class_aware;           // Only associate detections of the track's class
+} tracker_config_t;
+
+// One coordinate and its rate of change per frame
+typedef struct {
+    float value;
+    float rate;
+    float p00, p01, p11;        // Covariance
+} tracker_kf_t;
+
+typedef struct {
+    uint32_t id;                // 1, 2, ...; never reused
+    int32_t class_id;
+    tracker_kf_t cx, cy, area;  // Box center and area (pixels)
+    float aspect;               // Width / height, constant model
+    float aspect_var;
+    float confidence;           // Last detection score, decayed per predicted frame
+    uint32_t hits;              // Detections matched
+    uint32_t missed;            // Detector runs in a row without a match
+    uint32_t age;               // Frames since the track started
+} tracker_track_t;
+
+// Last box of an ended track
+typedef struct {
+    float x1, y1, x2, y2;
+    int32_t class_id;
+    uint64_t frame;
+} tracker_lost_t;
+
+typedef struct {
+    tracker_track_t tracks[TRACKER_MAX_TRACKS];
+    int count;
+    tracker_lost_t lost[TRACKER_MAX_LOST];
+    int lost_next;
+    uint64_t frame;             // tracker_predict calls
+    uint32_t next_id;
+
+    // Totals since tracker_init
+    uint64_t started;
+    uint64_t ended;
+    uint64_t id_switches;       // Tracks started where a recently lost track was
+} tracker_state_t;
+
+// A reported track
+typedef struct {
+    float x1, y1, x2, y2;
+    float score;                // Track confidence
+    int32_t class_id;
+    uint32_t id;
+} tracker_output_t;
+
+typedef struct {
+    tracker_config_t config;
+    tracker_state_t state;
+
+    // Assignment workspace for a square matrix of up to
+    // TRACKER_MAX_DETECTIONS rows, allocated once
+    float* cost;
+    double* row_potential;
+    double* col_potential;
+    double* min_slack;
+    int* col_row;               // Row assigned to each column (1-based, 0 = none)
+    int* way;
+    bool* used;
+    int* assignment;
+} tracker_t;
+
+// Defaults: IoU 0.3, reported after 2 hits, ends after 1 missed detector
+// run, confidence x0.95 per frame, class-aware
+void tracker_config_default(tracker_config_t* config);
+
+int tracker_init(tracker_t* tracker, const tracker_config_t* config);
+void tracker_fini(tracker_t* tracker);
+
+// Advance every track by one frame
+void tracker_predict(tracker_t* tracker);
+
+// Associate detections (sorted by score, as postprocess_run returns them)
+// with the tracks of the current frame
+void tracker_update(tracker_t* tracker, const postprocess_detection_t* detections, int count);
+
+// Confirmed tracks matched by the last detector run; returns how many
+// were written (at most max)
+int tracker_output(const tracker_t* tracker, tracker_output_t* out, int max);
+
+// Lowest confidence of the reported tracks, 1 if there are none
+float tracker_min_confidence(const tracker_t* tracker);
+
+// Minimum-cost assignment for a size x size cost matrix (row major).
+// assignment[row] = column. Returns the total cost.
+double tracker_assign(tracker_t* tracker, const float* cost, int size, int* assignment);
+
+#endif // TRACKER_H
@@ -0,0 +1,77 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Persistent worker pool for data-parallel kernels
+//
+// Threads are created once in worker_pool_init and sleep on a condition
+// variable between jobs, so running a job never creates threads. The
+// calling thread takes part in every job. Tasks are handed out through an
+// atomic counter, so faster workers pick up more bands. worker_pool_run
+// returns only after every worker has finished with the job, so the next
+// job can safely reuse the pool.
+//
+// A pool of 1 thread starts no workers and runs every job inline.
+
+#define WORKER_POOL_MAX_THREADS 16
+#define WORKER_POOL_BANDS_PER_THREAD 4
+#define WORKER_POOL_MIN_BAND_ROWS 8
+
+typedef void (*worker_pool_task_fn)(void* ctx, int task_index);
+typedef void (*worker_pool_band_fn)(void* ctx, int row_begin, int row_end);
+
+struct worker_pool;
+
+// Start arguments of one worker thread
+typedef struct {
+    struct worker_pool* pool;
+    int index;
+    bool pin;
+} worker_pool_start_t;
+
+typedef struct worker_pool {
+    int thread_count;               // Including the calling thread
+    pthread_t threads[WORKER_POOL_MAX_THREADS];
+    worker_pool_start_t starts[WORKER_POOL_MAX_THREADS];
+    int started;                    // Worker threads actually running
+
+    pthread_mutex_t mutex;
+    pthread_cond_t job_cond;        // Signalled when a job is posted
+    pthread_cond_t done_cond;       // Signalled when the last worker finishes a job
+    uint64_t generation;            // Incremented per job
+    int workers_done;               // Workers finished with the current job
+    bool shutdown;
+
+    // Current job
+    worker_pool_task_fn fn;
+    void* ctx;
+    int task_count;
+    int next_task;                  // Atomic
+} worker_pool_t;
+
+// thread_count 0 = one per online CPU, 1 = inline
+int worker_pool_init(worker_pool_t* pool, int thread_count, bool pin_threads);
+void worker_pool_fini(worker_pool_t* pool);
+
+// Run fn(ctx, i) for i in [0, task_count) and wait for completion
+void worker_pool_run(worker_pool_t* pool, int task_count, worker_pool_task_fn fn, void* ctx);
+
+int worker_pool_thread_count(const worker_pool_t* pool);
+
+// Per-core L2 size in bytes, used to size row bands (falls back to 512 KiB)
+size_t worker_pool_l2_cache_size(void);
+
+// Rows per band so that one band's input and output fit in half the L2
+int worker_pool_band_rows(size_t bytes_per_row, int height);
+
+// Split [0, height) into L2-sized horizontal bands (at least a few per
+// thread for load balancing) and run fn on each. bytes_per_row counts the
+// input and output bytes one row touches.
+void worker_pool_run_bands(worker_pool_t* pool, int height, size_t bytes_per_row,
+                           worker_pool_band_fn fn, void* ctx);
+
+#endif // WORKER_POOL_H
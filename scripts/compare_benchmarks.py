@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Compare two `benchmarks --json` reports, e.g. from two commits.
+
+Values are matched by case and name. Times (ns, us, ms) are better lower,
+everything else (MPix/s, fps, ratio) better higher. A change beyond the
+threshold in the bad direction is a regression; the exit status is 1 if
+there is any, or if a case that passed in the base run now fails.
+
+Usage: compare_benchmarks.py base.json new.json [--threshold 10] [--all]
+
+  BENCH_LABEL=$(git rev-parse --short HEAD) benchmarks --json new.json
+"""
+
+import argparse
+import json
+import sys
+
+LOWER_IS_BETTER = {"ns", "us", "ms", "s"}
+
+
+def load(path):
+    with open(path) as f:
+        report = json.load(f)
+    values = {}
+    for result in report["results"]:
+        if result["value"] is not None:
+            values[(result["bench"], result["name"])] = (result["value"], result["unit"])
+    return report, values
+
+
+def describe(report):
+    host = report["host"]
+    label = report["label"] or "unlabeled"
+    return f"{label} ({host['machine']}, {host['cpus']} CPUs, {host['isa']}, {report['time']})"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="percent change that counts as a regression")
+    parser.add_argument("--all", action="store_true", help="list unchanged values too")
+    args = parser.parse_args()
+
+    base_report, base = load(args.base)
+    new_report, new = load(args.new)
+    print(f"base: {describe(base_report)}")
+    print(f"new:  {describe(new_report)}")
+    if base_report["host"] != new_report["host"]:
+        print("warning: the runs are from different hosts")
+
+    regressions = 0
+    for case, status in new_report["cases"].items():
+        if status == "failed" and base_report["cases"].get(case) == "ok":
+            print(f"FAILED   {case} (passed in base)")
+            regressions += 1
+
+    print(f"{'':8} {'case':15} {'name':32} {'base':>11} {'new':>11} {'change':>8}")
+    for key in sorted(base.keys() & new.keys()):
+        (old, unit), (value, _) = base[key], new[key]
+        if old == 0:
+            continue
+        change = 100.0 * (value - old) / old
+        worse = change if unit in LOWER_IS_BETTER else -change
+        if worse > args.threshold:
+            verdict = "WORSE"
+            regressions += 1
+        elif worse < -args.threshold:
+            verdict = "better"
+        elif args.all:
+            verdict = ""
+        else:
+            continue
+        print(f"{verdict:8} {key[0]:15} {key[1]:32} {old:11.4g} {value:11.4g} {change:+7.1f}%"
+              f"  {unit}")
+
+    missing = sorted(base.keys() - new.keys())
+    if missing:
+        print(f"{len(missing)} values only in base, e.g. {missing[0][0]} {missing[0][1]}")
+    print(f"{regressions} regressions beyond {args.threshold:g}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Write a tiny YOLO-shaped ONNX model for offline inference_node runs.
+
+The model ignores the picture (its output is a constant, tied to the input
+through a zero-weighted mean so nothing is folded away) and always yields
+the same candidates, so decoding and NMS have a known answer:
+
+  * class 0, score 0.90, centered in the tensor       -> kept
+  * class 0, score 0.80, same box shifted by 2 px     -> suppressed (IoU > 0.45)
+  * class 1, score 0.60, top-left quarter             -> kept
+  * class 1, score 0.20                               -> below the 0.25 threshold
+  * every other candidate scores 0.01
+
+Usage: make_test_model.py [output.onnx] [--size 64] [--layout yolov8|yolov5]
+Needs the onnx and numpy Python packages.
+"""
+
+import argparse
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+
+CLASSES = 2
+CANDIDATES = 64
+
+
+def candidate_table(size):
+    boxes = np.zeros((CANDIDATES, 4 + CLASSES), dtype=np.float32)
+    boxes[:, 0:4] = [size / 2, size / 2, size / 8, size / 8]
+    boxes[:, 4:] = 0.01
+
+    half, quarter = size / 2, size / 4
+    boxes[0] = [half, half, half, half, 0.90, 0.01]
+    boxes[1] = [half + 2, half, half, half, 0.80, 0.01]
+    boxes[2] = [quarter, quarter, quarter, quarter, 0.01, 0.60]
+    boxes[3] = [3 * quarter, quarter, quarter, quarter, 0.01, 0.20]
+    return boxes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("output", nargs="?", default="test_model.onnx")
+    parser.add_argument("--size", type=int, default=64, help="input width and height")
+    parser.add_argument("--layout", choices=("yolov8", "yolov5"), default="yolov8")
+    args = parser.parse_args()
+
+    boxes = candidate_table(args.size)
+    if args.layout == "yolov8":
+        # [1, 4 + classes, candidates]
+        table = boxes.T[np.newaxis]
+    else:
+        # [1, candidates, 5 + classes]: objectness 1, class scores as above
+        table = np.insert(boxes, 4, 1.0, axis=1)[np.newaxis]
+    table = np.ascontiguousarray(table, dtype=np.float32)
+
+    nodes = [
+        helper.make_node("ReduceMean", ["images"], ["mean"], keepdims=0),
+        helper.make_node("Mul", ["mean", "zero"], ["nothing"]),
+        helper.make_node("Add", ["table", "nothing"], ["output0"]),
+    ]
+    graph = helper.make_graph(
+        nodes,
+        "test_detector",
+        [helper.make_tensor_value_info("images", TensorProto.FLOAT, [1, 3, args.size, args.size])],
+        [helper.make_tensor_value_info("output0", TensorProto.FLOAT, list(table.shape))],
+        initializer=[
+            numpy_helper.from_array(table, "table"),
+            numpy_helper.from_array(np.zeros((), dtype=np.float32), "zero"),
+        ],
+    )
+    model = helper.make_model(graph, opset_imports=[helper.make_opsetid("", 13)])
+    model.ir_version = 8
+    onnx.checker.check_model(model)
+    onnx.save(model, args.output)
+    print(f"Wrote {args.output}: {args.layout} output {list(table.shape)}")
+
+
+if __name__ == "__main__":
+    main()
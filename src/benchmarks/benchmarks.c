@@ -0,0 +1,3474 @@
+#include <fcntl.h>
+#include <float.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <jpeglib.h>
+#include <linux/videodev2.h>
+
+#include <rcl/rcl.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <sensor_msgs/msg/image.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
+
+#include "camera_config/camera_config.h"
+#include "camera_node/camera_node.h"
+#include "color_convert/color_convert.h"
+#include "display_render/display_intake.h"
+#include "display_render/display_render.h"
+#include "frame_mailbox/frame_mailbox.h"
+#include "frame_pool/frame_pool.h"
+#include "frame_queue/frame_queue.h"
+#include "frame_record/frame_record.h"
+#include "frame_ring/frame_ring.h"
+#include "frame_source/frame_source.h"
+#include "frame_sync/frame_sync.h"
+#include "image_message/image_message.h"
+#include "image_message/image_message_cdr.h"
+#include "jpeg_encoder/jpeg_encoder.h"
+#include "latency_trace/latency_trace.h"
+#include "mjpeg_decoder/mjpeg_decoder.h"
+#include "mjpeg_decoder/mjpeg_stream.h"
+#include "motion_gate/motion_gate.h"
+#include "postprocess/postprocess.h"
+#include "preprocess/preprocess.h"
+#include "stage_pipeline/stage_pipeline.h"
+#include "tracker/tracker.h"
+#include "worker_pool/worker_pool.h"
+
+// Headless micro-benchmarks for the pipeline's hot kernels.
+//
+// Usage: benchmarks [--json <file>] [filter]
+// Runs every benchmark whose name contains filter (all if omitted).
+// --json also writes every measured value to file, for comparing runs with
+// scripts/compare_benchmarks.py; BENCH_LABEL (e.g. a commit hash) is
+// stored with them.
+// BENCH_MJPEG_FILE=<file.mjpeg> makes mjpeg_decode use recorded frames.
+// BENCH_RECORD_DIR=<dir> puts the record case's files on that disk.
+
+#define BENCH_MIN_TIME_NS 300000000LL  // Measure each case for at least 0.3 s
+#define BENCH_MAX_SAMPLES 1000
+#define BENCH_MAX_RESULTS 1024
+
+typedef struct {
+    int width;
+    int height;
+    const char* name;
+} bench_resolution_t;
+
+static const bench_resolution_t g_resolutions[] = {
+    { 640, 480, "640x480" },
+    { 1280, 720, "1280x720" },
+    { 1920, 1080, "1920x1080" },
+};
+#define BENCH_RESOLUTION_COUNT (sizeof(g_resolutions) / sizeof(g_resolutions[0]))
+
+typedef void (*bench_fn)(void* ctx);
+
+static long long bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void bench_fill_random(uint8_t* data, size_t size, unsigned seed) {
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+static int bench_compare_ll(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Median time of one call in nanoseconds, after one warm-up call
+static long long bench_measure(bench_fn fn, void* ctx) {
+    static long long samples[BENCH_MAX_SAMPLES];
+    int count = 0;
+
+    fn(ctx);
+
+    long long start = bench_now_ns();
+    while (count < BENCH_MAX_SAMPLES && (count < 5 || bench_now_ns() - start < BENCH_MIN_TIME_NS)) {
+        long long t0 = bench_now_ns();
+        fn(ctx);
+        samples[count++] = bench_now_ns() - t0;
+    }
+
+    qsort(samples, (size_t)count, sizeof(samples[0]), bench_compare_ll);
+    return samples[count / 2];
+}
+
+// One measured value for the JSON report
+typedef struct {
+    const char* bench;          // Case that measured it
+    char name[96];              // What was measured, e.g. "neon/640x480"
+    double value;
+    const char* unit;           // "ms", "us", "MPix/s", ...
+} bench_result_t;
+
+static bench_result_t g_results[BENCH_MAX_RESULTS];
+static int g_result_count;
+static const char* g_bench_name;    // Case currently running
+
+static void bench_report(const char* unit, double value, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static void bench_report(const char* unit, double value, const char* format, ...) {
+    if (g_result_count == BENCH_MAX_RESULTS) {
+        return;
+    }
+    bench_result_t* result = &g_results[g_result_count++];
+    result->bench = g_bench_name;
+    result->value = value;
+    result->unit = unit;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(result->name, sizeof(result->name), format, args);
+    va_end(args);
+}
+
+// ---------------------------------------------------------------------------
+// mjpeg_decode: MJPEG -> YUYV/I420/RGB24 at 1/1, 1/2 and 1/4 scale
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    mjpeg_decoder_t* decoder;
+    const uint8_t* jpeg;
+    size_t jpeg_size;
+    uint8_t* dst;
+    size_t dst_size;
+    int failures;
+} bench_mjpeg_ctx_t;
+
+static void bench_mjpeg_decode_one(void* arg) {
+    bench_mjpeg_ctx_t* ctx = (bench_mjpeg_ctx_t*)arg;
+    if (mjpeg_decoder_decode(ctx->decoder, ctx->jpeg, ctx->jpeg_size, 0, 0,
+                             ctx->dst, ctx->dst_size) != 0) {
+        ctx->failures++;
+    }
+}
+
+// A 4:2:2 JPEG like a UVC camera's: smooth gradients plus some noise
+static uint8_t* bench_make_jpeg(int width, int height, size_t* size) {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    unsigned char* out = NULL;
+    unsigned long out_size = 0;
+    uint8_t* row = malloc((size_t)width * 3);
+    if (!row) {
+        return NULL;
+    }
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &out, &out_size);
+    cinfo.image_width = (JDIMENSION)width;
+    cinfo.image_height = (JDIMENSION)height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 80, TRUE);
+    cinfo.comp_info[0].h_samp_factor = 2;
+    cinfo.comp_info[0].v_samp_factor = 1;
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+        int y = (int)cinfo.next_scanline;
+        bench_fill_random(row, (size_t)width * 3, (unsigned)y);
+        for (int x = 0; x < width; ++x) {
+            row[3 * x + 0] = (uint8_t)(x * 255 / width + (row[3 * x + 0] >> 4));
+            row[3 * x + 1] = (uint8_t)(y * 255 / height + (row[3 * x + 1] >> 4));
+            row[3 * x + 2] = (uint8_t)((x + y) & 0xff);
+        }
+        JSAMPROW rows[1] = { row };
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    free(row);
+    *size = out_size;
+    return out;
+}
+
+static int bench_mjpeg_run(const char* name, const uint8_t* jpeg, size_t jpeg_size,
+                           int width, int height) {
+    static const mjpeg_output_t outputs[] = { MJPEG_OUTPUT_YUYV, MJPEG_OUTPUT_I420, MJPEG_OUTPUT_RGB24 };
+    static const int scales[] = { 1, 2, 4 };
+
+    for (size_t o = 0; o < sizeof(outputs) / sizeof(outputs[0]); ++o) {
+        for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); ++s) {
+            mjpeg_decoder_t decoder;
+            if (mjpeg_decoder_init(&decoder, outputs[o], scales[s]) != 0) {
+                return -1;
+            }
+            uint32_t out_width, out_height, out_step;
+            size_t out_size;
+            mjpeg_decoder_output_size(&decoder, (uint32_t)width, (uint32_t)height,
+                                      &out_width, &out_height, &out_step, &out_size);
+            uint8_t* dst = malloc(out_size);
+            if (!dst) {
+                mjpeg_decoder_fini(&decoder);
+                return -1;
+            }
+
+            bench_mjpeg_ctx_t ctx = { &decoder, jpeg, jpeg_size, dst, out_size, 0 };
+            long long ns = bench_measure(bench_mjpeg_decode_one, &ctx);
+            printf("  %-10s %-12s %5s %10.3f %9.1f\n", name, mjpeg_output_encoding(outputs[o]),
+                   s == 0 ? "1/1" : s == 1 ? "1/2" : "1/4", ns / 1e6,
+                   (double)width * height / (ns / 1e3));
+            bench_report("ms", ns / 1e6, "%s/%s/1:%d", name, mjpeg_output_encoding(outputs[o]),
+                         scales[s]);
+
+            free(dst);
+            mjpeg_decoder_fini(&decoder);
+            if (ctx.failures) {
+                fprintf(stderr, "  %d decodes failed\n", ctx.failures);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int bench_mjpeg_file(const char* path) {
+    mjpeg_stream_t stream;
+    if (mjpeg_stream_open(&stream, path) != 0) {
+        return -1;
+    }
+
+    mjpeg_decoder_t decoder;
+    if (mjpeg_decoder_init(&decoder, MJPEG_OUTPUT_YUYV, 1) != 0) {
+        mjpeg_stream_close(&stream);
+        return -1;
+    }
+
+    const uint8_t* frame;
+    size_t frame_size;
+    const uint8_t* good = NULL;
+    size_t good_size = 0;
+    uint32_t width = 0, height = 0;
+    uint8_t* dst = NULL;
+    size_t dst_size = 0;
+    long long start = bench_now_ns();
+
+    while (mjpeg_stream_next(&stream, &frame, &frame_size)) {
+        if (!dst) {
+            // The first readable header fixes the stream's size
+            if (mjpeg_decoder_peek_size(&decoder, frame, frame_size, &width, &height) != 0) {
+                decoder.corrupt++;
+                continue;
+            }
+            uint32_t out_width, out_height, out_step;
+            mjpeg_decoder_output_size(&decoder, width, height,
+                                      &out_width, &out_height, &out_step, &dst_size);
+            dst = malloc(dst_size);
+            if (!dst) {
+                break;
+            }
+        }
+        if (mjpeg_decoder_decode(&decoder, frame, frame_size, width, height, dst, dst_size) == 0 &&
+            !good) {
+            good = frame;
+            good_size = frame_size;
+        }
+    }
+
+    long long ns = bench_now_ns() - start;
+    uint64_t total = decoder.decoded + decoder.corrupt;
+    printf("  %s: %llu frames, %llu corrupt, %.3f ms/frame\n", path,
+           (unsigned long long)total, (unsigned long long)decoder.corrupt,
+           total ? ns / 1e6 / (double)total : 0.0);
+
+    int result = -1;
+    if (good) {
+        char name[24];
+        snprintf(name, sizeof(name), "%ux%u", width, height);
+        result = bench_mjpeg_run(name, good, good_size, (int)width, (int)height);
+    } else {
+        fprintf(stderr, "  no decodable frame in %s\n", path);
+    }
+
+    free(dst);
+    mjpeg_decoder_fini(&decoder);
+    mjpeg_stream_close(&stream);
+    return result;
+}
+
+static int bench_mjpeg_decode(void) {
+    printf("mjpeg_decode (libjpeg %d)\n", JPEG_LIB_VERSION);
+    printf("  %-10s %-12s %5s %10s %9s\n", "resolution", "output", "scale", "ms/frame", "MPix/s");
+
+    const char* path = getenv("BENCH_MJPEG_FILE");
+    if (path) {
+        return bench_mjpeg_file(path);
+    }
+
+    for (size_t r = 0; r < BENCH_RESOLUTION_COUNT; ++r) {
+        const bench_resolution_t* res = &g_resolutions[r];
+        size_t jpeg_size;
+        uint8_t* jpeg = bench_make_jpeg(res->width, res->height, &jpeg_size);
+        if (!jpeg) {
+            return -1;
+        }
+        int result = bench_mjpeg_run(res->name, jpeg, jpeg_size, res->width, res->height);
+        free(jpeg);
+        if (result != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// convert_scaling: band-parallel YUYV -> RGB24 with 1-4 threads
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    worker_pool_t* pool;
+    const uint8_t* src;
+    uint8_t* dst;
+    int width;
+    int height;
+} bench_convert_ctx_t;
+
+static void bench_convert_parallel(void* arg) {
+    bench_convert_ctx_t* ctx = (bench_convert_ctx_t*)arg;
+    yuyv_to_rgb24_parallel(ctx->pool, ctx->src, ctx->width * 2,
+                           ctx->dst, ctx->width * 3, ctx->width, ctx->height);
+}
+
+static int bench_convert_scaling(void) {
+    printf("convert_scaling (kernel: %s, L2: %zu KiB)\n",
+           color_convert_isa_name(color_convert_active_isa()),
+           worker_pool_l2_cache_size() / 1024);
+    printf("  %-10s %7s %10s %9s %8s\n", "resolution", "threads", "ms/frame", "MPix/s", "speedup");
+
+    for (size_t r = 0; r < BENCH_RESOLUTION_COUNT; ++r) {
+        const bench_resolution_t* res = &g_resolutions[r];
+        size_t src_size = (size_t)res->width * res->height * 2;
+        size_t dst_size = (size_t)res->width * res->height * 3;
+        uint8_t* src = malloc(src_size);
+        uint8_t* dst = malloc(dst_size);
+        if (!src || !dst) {
+            free(src);
+            free(dst);
+            return -1;
+        }
+        bench_fill_random(src, src_size, 1);
+
+        long long single = 0;
+        for (int threads = 1; threads <= 4; ++threads) {
+            worker_pool_t pool;
+            if (worker_pool_init(&pool, threads, true) != 0) {
+                free(src);
+                free(dst);
+                return -1;
+            }
+
+            bench_convert_ctx_t ctx = { &pool, src, dst, res->width, res->height };
+            long long ns = bench_measure(bench_convert_parallel, &ctx);
+            if (threads == 1) {
+                single = ns;
+            }
+
+            printf("  %-10s %7d %10.3f %9.1f %7.2fx\n", res->name, threads, ns / 1e6,
+                   (double)res->width * res->height / (ns / 1e3), (double)single / ns);
+            bench_report("ms", ns / 1e6, "%s/%dt", res->name, threads);
+            worker_pool_fini(&pool);
+        }
+
+        free(src);
+        free(dst);
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// jpeg_encode: compressed-topic encoder, raw YUV input vs. RGB input
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    jpeg_encoder_t* encoder;
+    const uint8_t* src;
+    const char* encoding;
+    int width;
+    int height;
+    int step;
+    size_t jpeg_size;
+    int failures;
+} bench_jpeg_ctx_t;
+
+static void bench_jpeg_encode_one(void* arg) {
+    bench_jpeg_ctx_t* ctx = (bench_jpeg_ctx_t*)arg;
+    const uint8_t* jpeg;
+    if (jpeg_encoder_encode(ctx->encoder, ctx->src, ctx->encoding, (uint32_t)ctx->width,
+                            (uint32_t)ctx->height, (uint32_t)ctx->step, &jpeg, &ctx->jpeg_size) != 0) {
+        ctx->failures++;
+    }
+}
+
+// The same picture as rgb8 and as yuv422_yuy2 (BT.601), so only the
+// input path differs
+static void bench_make_rgb_yuyv(uint8_t* rgb, uint8_t* yuyv, int width, int height) {
+    bench_fill_random(rgb, (size_t)width * height * 3, 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = rgb + ((size_t)y * width + x) * 3;
+            p[0] = (uint8_t)(x * 200 / width + (p[0] >> 5));
+            p[1] = (uint8_t)(y * 200 / height + (p[1] >> 5));
+            p[2] = (uint8_t)(((x + y) & 0x7f) + (p[2] >> 5));
+        }
+        for (int x = 0; x + 1 < width; x += 2) {
+            const uint8_t* p = rgb + ((size_t)y * width + x) * 3;
+            uint8_t* d = yuyv + (size_t)y * width * 2 + (size_t)x * 2;
+            int r = p[0], g = p[1], b = p[2];
+            d[0] = (uint8_t)((66 * r + 129 * g + 25 * b + 128) / 256 + 16);
+            d[1] = (uint8_t)((-38 * r - 74 * g + 112 * b + 128) / 256 + 128);
+            d[2] = (uint8_t)((66 * p[3] + 129 * p[4] + 25 * p[5] + 128) / 256 + 16);
+            d[3] = (uint8_t)((112 * r - 94 * g - 18 * b + 128) / 256 + 128);
+        }
+    }
+}
+
+static int bench_jpeg_encode(void) {
+    printf("jpeg_encode (quality 80)\n");
+    printf("  %-10s %-12s %10s %9s %9s\n", "resolution", "input", "ms/frame", "MPix/s", "KiB");
+
+    for (size_t r = 0; r < BENCH_RESOLUTION_COUNT; ++r) {
+        const bench_resolution_t* res = &g_resolutions[r];
+        uint8_t* rgb = malloc((size_t)res->width * res->height * 3);
+        uint8_t* yuyv = malloc((size_t)res->width * res->height * 2);
+        if (!rgb || !yuyv) {
+            free(rgb);
+            free(yuyv);
+            return -1;
+        }
+        bench_make_rgb_yuyv(rgb, yuyv, res->width, res->height);
+
+        const char* encodings[] = { "yuv422_yuy2", "rgb8" };
+        const uint8_t* sources[] = { yuyv, rgb };
+        int result = 0;
+        for (size_t e = 0; e < 2 && result == 0; ++e) {
+            jpeg_encoder_t encoder;
+            if (jpeg_encoder_init(&encoder, 80) != 0) {
+                result = -1;
+                break;
+            }
+            int step = res->width * (e == 0 ? 2 : 3);
+            bench_jpeg_ctx_t ctx = { &encoder, sources[e], encodings[e], res->width, res->height, step, 0, 0 };
+            long long ns = bench_measure(bench_jpeg_encode_one, &ctx);
+            printf("  %-10s %-12s %10.3f %9.1f %9.1f\n", res->name, encodings[e], ns / 1e6,
+                   (double)res->width * res->height / (ns / 1e3), ctx.jpeg_size / 1024.0);
+            bench_report("ms", ns / 1e6, "%s/%s", res->name, encodings[e]);
+            jpeg_encoder_fini(&encoder);
+            result = ctx.failures ? -1 : 0;
+        }
+
+        free(rgb);
+        free(yuyv);
+        if (result != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// preprocess: fused YUYV -> tensor vs. the multi-pass chain
+// ---------------------------------------------------------------------------
+
+static const int g_tensor_sizes[] = { 320, 416, 640 };
+#define BENCH_TENSOR_SIZE_COUNT (sizeof(g_tensor_sizes) / sizeof(g_tensor_sizes[0]))
+
+typedef struct {
+    preprocess_t* pp;
+    const preprocess_config_t* config;
+    const uint8_t* src;
+    void* dst;
+    int width;
+    int height;
+    int failures;
+} bench_preprocess_ctx_t;
+
+static void bench_preprocess_fused(void* arg) {
+    bench_preprocess_ctx_t* ctx = (bench_preprocess_ctx_t*)arg;
+    if (preprocess_yuyv(ctx->pp, ctx->src, ctx->width * 2, ctx->width, ctx->height, ctx->dst) != 0) {
+        ctx->failures++;
+    }
+}
+
+static void bench_preprocess_reference(void* arg) {
+    bench_preprocess_ctx_t* ctx = (bench_preprocess_ctx_t*)arg;
+    if (preprocess_yuyv_reference(ctx->config, ctx->src, ctx->width * 2,
+                                  ctx->width, ctx->height, ctx->dst) != 0) {
+        ctx->failures++;
+    }
+}
+
+// ImageNet normalization, the common case for float32 models
+static void bench_preprocess_config(preprocess_config_t* config, int size, preprocess_dtype_t dtype) {
+    static const float mean[3] = { 123.675f, 116.28f, 103.53f };
+    static const float std[3] = { 58.395f, 57.12f, 57.375f };
+
+    preprocess_config_default(config);
+    config->width = size;
+    config->height = size;
+    config->dtype = dtype;
+    if (dtype == PREPROCESS_FLOAT32) {
+        memcpy(config->mean, mean, sizeof(mean));
+        memcpy(config->std, std, sizeof(std));
+    }
+}
+
+static int bench_preprocess_run(const bench_resolution_t* res, const uint8_t* src, int size,
+                                preprocess_dtype_t dtype) {
+    preprocess_config_t config;
+    bench_preprocess_config(&config, size, dtype);
+
+    preprocess_t pp;
+    void* dst = malloc(preprocess_tensor_size(&config));
+    if (!dst || preprocess_init(&pp, &config) != 0) {
+        free(dst);
+        return -1;
+    }
+
+    bench_preprocess_ctx_t ctx = { &pp, &config, src, dst, res->width, res->height, 0 };
+    long long fused = bench_measure(bench_preprocess_fused, &ctx);
+    long long reference = bench_measure(bench_preprocess_reference, &ctx);
+    printf("  %-10s %6d %-8s %10.3f %12.3f %7.2fx\n", res->name, size,
+           dtype == PREPROCESS_INT8 ? "int8" : "float32",
+           fused / 1e6, reference / 1e6, (double)reference / fused);
+    const char* dtype_name = dtype == PREPROCESS_INT8 ? "int8" : "float32";
+    bench_report("ms", fused / 1e6, "%s/%d/%s/fused", res->name, size, dtype_name);
+    bench_report("ms", reference / 1e6, "%s/%d/%s/multipass", res->name, size, dtype_name);
+
+    preprocess_fini(&pp);
+    free(dst);
+    return ctx.failures ? -1 : 0;
+}
+
+static int bench_preprocess(void) {
+    printf("preprocess (kernel: %s)\n", color_convert_isa_name(color_convert_active_isa()));
+    printf("  %-10s %6s %-8s %10s %12s %8s\n", "resolution", "tensor", "dtype",
+           "fused ms", "multipass ms", "speedup");
+
+    int result = 0;
+    for (size_t r = 0; r < BENCH_RESOLUTION_COUNT && result == 0; ++r) {
+        const bench_resolution_t* res = &g_resolutions[r];
+        uint8_t* rgb = malloc((size_t)res->width * res->height * 3);
+        uint8_t* yuyv = malloc((size_t)res->width * res->height * 2);
+        if (!rgb || !yuyv) {
+            free(rgb);
+            free(yuyv);
+            return -1;
+        }
+        bench_make_rgb_yuyv(rgb, yuyv, res->width, res->height);
+
+        for (size_t s = 0; s < BENCH_TENSOR_SIZE_COUNT && result == 0; ++s) {
+            result = bench_preprocess_run(res, yuyv, g_tensor_sizes[s], PREPROCESS_FLOAT32);
+        }
+        if (result == 0) {
+            result = bench_preprocess_run(res, yuyv, 640, PREPROCESS_INT8);
+        }
+
+        free(rgb);
+        free(yuyv);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// postprocess: YOLO decode + NMS at 1k, 8k and 25k candidates, SIMD and
+// scalar filter vs. the full-sort brute-force reference
+// ---------------------------------------------------------------------------
+
+#define BENCH_POSTPROCESS_CLASSES 80
+#define BENCH_POSTPROCESS_OBJECTS 20        // Objects in a synthetic output
+#define BENCH_POSTPROCESS_OBJECT_SHARE 10   // 1 in N candidates sits on an object
+
+static const int g_candidate_counts[] = { 1000, 8000, 25000 };
+#define BENCH_CANDIDATE_COUNT (sizeof(g_candidate_counts) / sizeof(g_candidate_counts[0]))
+
+// Deployment threshold and the low one used for mAP evaluation, where
+// nearly every candidate passes and the top k selection does the work
+static const float g_conf_thresholds[] = { 0.25f, 0.001f };
+#define BENCH_CONF_THRESHOLD_COUNT (sizeof(g_conf_thresholds) / sizeof(g_conf_thresholds[0]))
+
+typedef struct {
+    postprocess_t* pp;
+    const float* output;
+    postprocess_detection_t* detections;
+    int capacity;
+    int count;
+    int failures;
+} bench_postprocess_ctx_t;
+
+static void bench_postprocess_fast(void* arg) {
+    bench_postprocess_ctx_t* ctx = (bench_postprocess_ctx_t*)arg;
+    ctx->count = postprocess_run(ctx->pp, ctx->output, ctx->detections, ctx->capacity);
+}
+
+static void bench_postprocess_reference(void* arg) {
+    bench_postprocess_ctx_t* ctx = (bench_postprocess_ctx_t*)arg;
+    ctx->count = postprocess_run_reference(ctx->pp, ctx->output, ctx->detections, ctx->capacity);
+    if (ctx->count < 0) {
+        ctx->failures++;
+    }
+}
+
+static float bench_random_unit(unsigned* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (float)((*seed >> 8) & 0xffff) / 65536.0f;
+}
+
+// attribute: 0-3 box, 4 objectness (YOLOv5 only), then classes
+static void bench_yolo_set(postprocess_layout_t layout, float* output, int candidates,
+                           int attributes, int candidate, int attribute, float value) {
+    if (layout == POSTPROCESS_LAYOUT_YOLOV8) {
+        output[(size_t)attribute * candidates + candidate] = value;
+    } else {
+        output[(size_t)candidate * attributes + attribute] = value;
+    }
+}
+
+// Clusters of boxes around a few objects over low-score background, with
+// scores quantized to 1/256 like an int8 model's, so ties are common
+static float* bench_make_yolo_output(postprocess_layout_t layout, int candidates, int classes) {
+    int v5 = layout == POSTPROCESS_LAYOUT_YOLOV5;
+    int first_class = v5 ? 5 : 4;
+    int attributes = first_class + classes;
+    float* output = malloc((size_t)candidates * attributes * sizeof(float));
+    if (!output) {
+        return NULL;
+    }
+
+    unsigned seed = 1234u;
+    float objects[BENCH_POSTPROCESS_OBJECTS][5];     // cx, cy, w, h, class
+    for (int o = 0; o < BENCH_POSTPROCESS_OBJECTS; ++o) {
+        objects[o][0] = bench_random_unit(&seed) * 640.0f;
+        objects[o][1] = bench_random_unit(&seed) * 640.0f;
+        objects[o][2] = 20.0f + bench_random_unit(&seed) * 180.0f;
+        objects[o][3] = 20.0f + bench_random_unit(&seed) * 180.0f;
+        objects[o][4] = (float)(int)(bench_random_unit(&seed) * classes);
+    }
+
+    for (int i = 0; i < candidates; ++i) {
+        bool on_object = (i % BENCH_POSTPROCESS_OBJECT_SHARE) == 0;
+        const float* object = objects[(i / BENCH_POSTPROCESS_OBJECT_SHARE) % BENCH_POSTPROCESS_OBJECTS];
+        float box[4];
+        for (int k = 0; k < 4; ++k) {
+            float jitter = bench_random_unit(&seed) - 0.5f;
+            box[k] = on_object ? object[k] + jitter * 0.2f * object[k < 2 ? k + 2 : k]
+                               : (k < 2 ? 640.0f : 120.0f) * bench_random_unit(&seed) + 4.0f;
+        }
+        for (int k = 0; k < 4; ++k) {
+            bench_yolo_set(layout, output, candidates, attributes, i, k, box[k]);
+        }
+        if (v5) {
+            float objectness = on_object ? 0.5f + 0.5f * bench_random_unit(&seed)
+                                         : 0.1f * bench_random_unit(&seed);
+            bench_yolo_set(layout, output, candidates, attributes, i, 4,
+                           floorf(objectness * 256.0f) / 256.0f);
+        }
+        for (int c = 0; c < classes; ++c) {
+            float value = 0.05f * bench_random_unit(&seed);
+            if (on_object && c == (int)object[4]) {
+                value = 0.3f + 0.7f * bench_random_unit(&seed);
+            }
+            bench_yolo_set(layout, output, candidates, attributes, i, first_class + c,
+                           floorf(value * 256.0f) / 256.0f);
+        }
+    }
+    return output;
+}
+
+static int bench_postprocess_init(postprocess_t* pp, postprocess_layout_t layout, int candidates,
+                                  float threshold, bool class_agnostic, int top_k) {
+    int attributes = BENCH_POSTPROCESS_CLASSES + (layout == POSTPROCESS_LAYOUT_YOLOV5 ? 5 : 4);
+    int64_t dims[3] = { 1, 0, 0 };
+    dims[1] = layout == POSTPROCESS_LAYOUT_YOLOV8 ? attributes : candidates;
+    dims[2] = layout == POSTPROCESS_LAYOUT_YOLOV8 ? candidates : attributes;
+
+    postprocess_config_t config;
+    postprocess_config_default(&config);
+    config.layout = layout;
+    config.conf_threshold = threshold;
+    config.class_agnostic = class_agnostic;
+    config.pre_nms_top_k = top_k;
+    return postprocess_init(pp, &config, dims, 3);
+}
+
+static int bench_postprocess_run(postprocess_layout_t layout, int candidates, float threshold,
+                                 const float* output) {
+    postprocess_t pp;
+    if (bench_postprocess_init(&pp, layout, candidates, threshold, false,
+                               POSTPROCESS_PRE_NMS_TOP_K) != 0) {
+        return -1;
+    }
+    int capacity = pp.config.max_detections;
+    postprocess_detection_t* detections = calloc((size_t)capacity, sizeof(*detections));
+    if (!detections) {
+        postprocess_fini(&pp);
+        return -1;
+    }
+
+    bench_postprocess_ctx_t ctx = { &pp, output, detections, capacity, 0, 0 };
+    long long fast = bench_measure(bench_postprocess_fast, &ctx);
+    int kept = ctx.count;
+    pp.filter = postprocess_filter_scalar;
+    pp.row_max = postprocess_row_max_scalar;
+    long long scalar = bench_measure(bench_postprocess_fast, &ctx);
+    long long reference = bench_measure(bench_postprocess_reference, &ctx);
+    pp.filter = postprocess_get_filter(pp.isa);
+    pp.row_max = postprocess_get_row_max(pp.isa);
+    printf("  %-7s %10d %9.3f %6d %9.1f %10.1f %13.1f %7.2fx\n", postprocess_layout_name(layout),
+           candidates, threshold, kept, fast / 1e3, scalar / 1e3, reference / 1e3,
+           (double)reference / fast);
+    const char* layout_name = postprocess_layout_name(layout);
+    bench_report("us", fast / 1e3, "%s/%d/%g/simd", layout_name, candidates, threshold);
+    bench_report("us", scalar / 1e3, "%s/%d/%g/scalar", layout_name, candidates, threshold);
+    bench_report("us", reference / 1e3, "%s/%d/%g/reference", layout_name, candidates, threshold);
+
+    free(detections);
+    postprocess_fini(&pp);
+    return ctx.failures ? -1 : 0;
+}
+
+static int bench_postprocess(void) {
+    printf("postprocess (kernel: %s, %d classes, top %d into NMS)\n",
+           color_convert_isa_name(color_convert_active_isa()), BENCH_POSTPROCESS_CLASSES,
+           POSTPROCESS_PRE_NMS_TOP_K);
+    printf("  %-7s %10s %9s %6s %9s %10s %13s %8s\n", "layout", "candidates", "threshold",
+           "kept", "simd us", "scalar us", "reference us", "speedup");
+
+    static const postprocess_layout_t layouts[] = { POSTPROCESS_LAYOUT_YOLOV8,
+                                                    POSTPROCESS_LAYOUT_YOLOV5 };
+    int result = 0;
+    for (size_t l = 0; l < 2 && result == 0; ++l) {
+        for (size_t n = 0; n < BENCH_CANDIDATE_COUNT && result == 0; ++n) {
+            float* output = bench_make_yolo_output(layouts[l], g_candidate_counts[n],
+                                                   BENCH_POSTPROCESS_CLASSES);
+            if (!output) {
+                return -1;
+            }
+            for (size_t t = 0; t < BENCH_CONF_THRESHOLD_COUNT && result == 0; ++t) {
+                result = bench_postprocess_run(layouts[l], g_candidate_counts[n],
+                                               g_conf_thresholds[t], output);
+            }
+            free(output);
+        }
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// stage_pipeline: three sleeping stages shaped like preprocess -> inference
+// -> postprocess, run one frame at a time and pipelined, offline and live
+// ---------------------------------------------------------------------------
+
+#define BENCH_PIPELINE_FRAMES 60
+#define BENCH_PIPELINE_STAGES 3
+
+static const int g_pipeline_stage_us[BENCH_PIPELINE_STAGES] = { 4000, 10000, 3000 };
+
+typedef struct {
+    uint32_t sequence[STAGE_PIPELINE_MAX_SLOTS];  // Frame number held by each slot
+    uint32_t last_sequence;                         // Last stage only
+    int out_of_order;
+} bench_pipeline_ctx_t;
+
+static void bench_sleep_us(int us) {
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = (long)us * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+static int bench_pipeline_stage(void* context, int slot, int stage) {
+    bench_pipeline_ctx_t* ctx = (bench_pipeline_ctx_t*)context;
+    bench_sleep_us(g_pipeline_stage_us[stage]);
+    if (stage == BENCH_PIPELINE_STAGES - 1) {
+        if (ctx->sequence[slot] <= ctx->last_sequence) {
+            ctx->out_of_order++;
+        }
+        ctx->last_sequence = ctx->sequence[slot];
+    }
+    return 0;
+}
+
+static int bench_pipeline_stage0(void* context, int slot) {
+    return bench_pipeline_stage(context, slot, 0);
+}
+
+static int bench_pipeline_stage1(void* context, int slot) {
+    return bench_pipeline_stage(context, slot, 1);
+}
+
+static int bench_pipeline_stage2(void* context, int slot) {
+    return bench_pipeline_stage(context, slot, 2);
+}
+
+// Offline (period 0): acquire waits for a slot, nothing may be dropped.
+// Live: one frame every period_us, dropped by policy when the pipeline is full.
+static int bench_pipeline_run(const char* mode, int in_flight, stage_pipeline_policy_t policy,
+                              int period_us, double* fps) {
+    static const stage_pipeline_stage_t stages[BENCH_PIPELINE_STAGES] = {
+        { "preprocess", bench_pipeline_stage0 },
+        { "inference", bench_pipeline_stage1 },
+        { "postprocess", bench_pipeline_stage2 },
+    };
+    bench_pipeline_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    stage_pipeline_config_t config;
+    stage_pipeline_config_default(&config);
+    config.max_in_flight = in_flight;
+    config.policy = policy;
+    stage_pipeline_t pipeline;
+    if (stage_pipeline_init(&pipeline, &config, stages, BENCH_PIPELINE_STAGES, &ctx) != 0) {
+        return -1;
+    }
+
+    bool offline = period_us == 0;
+    long long start = bench_now_ns();
+    for (uint32_t frame = 1; frame <= BENCH_PIPELINE_FRAMES; ++frame) {
+        int slot = stage_pipeline_acquire(&pipeline, offline);
+        if (slot >= 0) {
+            ctx.sequence[slot] = frame;
+            stage_pipeline_submit(&pipeline, slot);
+        }
+        if (!offline) {
+            bench_sleep_us(period_us);
+        }
+    }
+    stage_pipeline_wait_idle(&pipeline);
+    long long elapsed = bench_now_ns() - start;
+
+    stage_pipeline_stats_t stats;
+    stage_pipeline_take_stats(&pipeline, &stats);
+    stage_pipeline_fini(&pipeline);
+
+    *fps = stats.completed / (elapsed / 1e9);
+    printf("  %-8s %9d %-12s %7.1f %5llu %7llu %9.1f %8.1f  %3.0f%% %3.0f%% %3.0f%%\n", mode,
+           in_flight, stage_pipeline_policy_name(policy), *fps,
+           (unsigned long long)stats.completed,
+           (unsigned long long)(stats.dropped_oldest + stats.dropped_newest),
+           stats.completed ? (double)stats.latency_sum_ns / stats.completed / 1e6 : 0.0,
+           stats.latency_max_ns / 1e6,
+           100.0 * stats.stages[0].busy_ns / stats.interval_ns,
+           100.0 * stats.stages[1].busy_ns / stats.interval_ns,
+           100.0 * stats.stages[2].busy_ns / stats.interval_ns);
+    bench_report("fps", *fps, "%s/%d/%s", mode, in_flight, stage_pipeline_policy_name(policy));
+
+    return ctx.out_of_order ? -1 : 0;
+}
+
+static int bench_stage_pipeline(void) {
+    printf("stage_pipeline (%d frames, stages %d/%d/%d ms)\n", BENCH_PIPELINE_FRAMES,
+           g_pipeline_stage_us[0] / 1000, g_pipeline_stage_us[1] / 1000,
+           g_pipeline_stage_us[2] / 1000);
+    printf("  %-8s %9s %-12s %7s %5s %7s %9s %8s  %s\n", "mode", "in flight", "policy", "fps",
+           "done", "dropped", "lat avg", "lat max", "occupancy");
+
+    double sequential = 0.0;
+    double pipelined = 0.0;
+    double live = 0.0;
+    if (bench_pipeline_run("offline", 1, STAGE_PIPELINE_DROP_OLDEST, 0, &sequential) != 0 ||
+        bench_pipeline_run("offline", 3, STAGE_PIPELINE_DROP_OLDEST, 0, &pipelined) != 0 ||
+        bench_pipeline_run("live", 3, STAGE_PIPELINE_DROP_OLDEST, 5000, &live) != 0 ||
+        bench_pipeline_run("live", 3, STAGE_PIPELINE_DROP_NEWEST, 5000, &live) != 0 ||
+        bench_pipeline_run("live", 1, STAGE_PIPELINE_DROP_OLDEST, 5000, &live) != 0) {
+        return -1;
+    }
+    printf("  pipelined speedup %.2fx\n", pipelined / sequential);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// motion_gate: cost per frame at each decimation against a color conversion
+// ---------------------------------------------------------------------------
+
+static const int g_motion_decimations[] = { 1, 2, 4 };
+#define BENCH_MOTION_DECIMATION_COUNT (sizeof(g_motion_decimations) / sizeof(g_motion_decimations[0]))
+
+typedef struct {
+    motion_gate_t* gate;
+    const uint8_t* yuyv;
+    uint8_t* rgb;
+    int width;
+    int height;
+    motion_gate_result_t result;
+} bench_motion_ctx_t;
+
+static void bench_motion_run(void* arg) {
+    bench_motion_ctx_t* ctx = (bench_motion_ctx_t*)arg;
+    motion_gate_run(ctx->gate, ctx->yuyv, ctx->width * 2, ctx->width, ctx->height, &ctx->result);
+}
+
+static void bench_motion_convert(void* arg) {
+    bench_motion_ctx_t* ctx = (bench_motion_ctx_t*)arg;
+    yuyv_to_rgb24_strided(ctx->yuyv, ctx->width * 2, ctx->rgb, ctx->width * 3,
+                          ctx->width, ctx->height);
+}
+
+static int bench_motion_gate(void) {
+    printf("motion_gate (kernel: %s, %dx%d blocks, threshold %d)\n",
+           color_convert_isa_name(color_convert_active_isa()), MOTION_GATE_BLOCK, MOTION_GATE_BLOCK,
+           MOTION_GATE_THRESHOLD);
+    printf("  %-10s %10s %10s %10s %12s\n", "resolution", "1/1 ms", "1/2 ms", "1/4 ms", "to RGB ms");
+    for (size_t r = 0; r < BENCH_RESOLUTION_COUNT; ++r) {
+        const bench_resolution_t* res = &g_resolutions[r];
+        uint8_t* yuyv = malloc((size_t)res->width * res->height * 2);
+        uint8_t* rgb = malloc((size_t)res->width * res->height * 3);
+        if (!yuyv || !rgb) {
+            free(yuyv);
+            free(rgb);
+            return -1;
+        }
+        bench_fill_random(yuyv, (size_t)res->width * res->height * 2, 3);
+
+        bench_motion_ctx_t ctx = { NULL, yuyv, rgb, res->width, res->height, { 0 } };
+        double ms[BENCH_MOTION_DECIMATION_COUNT];
+        for (size_t k = 0; k < BENCH_MOTION_DECIMATION_COUNT; ++k) {
+            motion_gate_config_t config;
+            motion_gate_config_default(&config);
+            config.decimation = g_motion_decimations[k];
+            motion_gate_t gate;
+            if (motion_gate_init(&gate, &config) != 0) {
+                free(yuyv);
+                free(rgb);
+                return -1;
+            }
+            ctx.gate = &gate;
+            ms[k] = bench_measure(bench_motion_run, &ctx) / 1e6;
+            motion_gate_fini(&gate);
+        }
+        double convert_ms = bench_measure(bench_motion_convert, &ctx) / 1e6;
+        printf("  %-10s %10.3f %10.3f %10.3f %12.3f\n", res->name, ms[0], ms[1], ms[2], convert_ms);
+        for (size_t k = 0; k < BENCH_MOTION_DECIMATION_COUNT; ++k) {
+            bench_report("ms", ms[k], "%s/1:%d", res->name, g_motion_decimations[k]);
+        }
+        free(yuyv);
+        free(rgb);
+    }
+
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// tracker: synthetic scene with known identities, detector every N frames
+// ---------------------------------------------------------------------------
+
+#define BENCH_TRACK_OBJECTS 8
+#define BENCH_TRACK_FRAMES 900          // 30 s at 30 fps
+#define BENCH_TRACK_MISS_RATE 0.05f     // Detections the detector misses
+#define BENCH_TRACK_FALSE_RATE 0.05f    // False detections per detector run
+#define BENCH_TRACK_NOISE_PX 2.0f       // Edge jitter of detected boxes
+
+#define BENCH_TRACK_PENDING 16
+
+// Detector every N frames, its result L frames later
+static const struct {
+    int interval;
+    int latency;
+} g_track_runs[] = { { 1, 0 }, { 3, 0 }, { 6, 0 }, { 10, 0 }, { 3, 4 }, { 6, 4 } };
+#define BENCH_TRACK_RUN_COUNT (sizeof(g_track_runs) / sizeof(g_track_runs[0]))
+
+typedef struct {
+    float x, y, w, h;           // Top-left corner and size
+    float vx, vy;               // Pixels per frame
+} bench_object_t;
+
+static float bench_box_iou(float ax1, float ay1, float ax2, float ay2,
+                           float bx1, float by1, float bx2, float by2) {
+    float w = fminf(ax2, bx2) - fmaxf(ax1, bx1);
+    float h = fminf(ay2, by2) - fmaxf(ay1, by1);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = w * h;
+    return inter / ((ax2 - ax1) * (ay2 - ay1) + (bx2 - bx1) * (by2 - by1) - inter);
+}
+
+static int bench_compare_score(const void* a, const void* b) {
+    float x = ((const postprocess_detection_t*)a)->score;
+    float y = ((const postprocess_detection_t*)b)->score;
+    return (x < y) - (x > y);
+}
+
+// Slow objects bouncing inside a 640x480 frame
+static void bench_scene_init(bench_object_t* objects, unsigned* seed) {
+    for (int i = 0; i < BENCH_TRACK_OBJECTS; ++i) {
+        bench_object_t* o = &objects[i];
+        o->w = 40.0f + 80.0f * bench_random_unit(seed);
+        o->h = 40.0f + 80.0f * bench_random_unit(seed);
+        o->x = (640.0f - o->w) * bench_random_unit(seed);
+        o->y = (480.0f - o->h) * bench_random_unit(seed);
+        o->vx = 4.0f * bench_random_unit(seed) - 2.0f;
+        o->vy = 4.0f * bench_random_unit(seed) - 2.0f;
+    }
+}
+
+static void bench_scene_step(bench_object_t* objects) {
+    for (int i = 0; i < BENCH_TRACK_OBJECTS; ++i) {
+        bench_object_t* o = &objects[i];
+        o->x += o->vx;
+        o->y += o->vy;
+        if (o->x < 0.0f || o->x + o->w > 640.0f) {
+            o->vx = -o->vx;
+        }
+        if (o->y < 0.0f || o->y + o->h > 480.0f) {
+            o->vy = -o->vy;
+        }
+    }
+}
+
+static int bench_scene_detect(const bench_object_t* objects, postprocess_detection_t* dets,
+                              unsigned* seed) {
+    int count = 0;
+    for (int i = 0; i < BENCH_TRACK_OBJECTS; ++i) {
+        if (bench_random_unit(seed) < BENCH_TRACK_MISS_RATE) {
+            continue;
+        }
+        const bench_object_t* o = &objects[i];
+        postprocess_detection_t* d = &dets[count++];
+        d->x1 = o->x + BENCH_TRACK_NOISE_PX * (2.0f * bench_random_unit(seed) - 1.0f);
+        d->y1 = o->y + BENCH_TRACK_NOISE_PX * (2.0f * bench_random_unit(seed) - 1.0f);
+        d->x2 = o->x + o->w + BENCH_TRACK_NOISE_PX * (2.0f * bench_random_unit(seed) - 1.0f);
+        d->y2 = o->y + o->h + BENCH_TRACK_NOISE_PX * (2.0f * bench_random_unit(seed) - 1.0f);
+        d->score = 0.5f + 0.45f * bench_random_unit(seed);
+        d->class_id = i % 3;
+    }
+    if (bench_random_unit(seed) < BENCH_TRACK_FALSE_RATE) {
+        postprocess_detection_t* d = &dets[count++];
+        d->x1 = 600.0f * bench_random_unit(seed);
+        d->y1 = 440.0f * bench_random_unit(seed);
+        d->x2 = d->x1 + 40.0f;
+        d->y2 = d->y1 + 40.0f;
+        d->score = 0.3f;
+        d->class_id = 0;
+    }
+    qsort(dets, (size_t)count, sizeof(dets[0]), bench_compare_score);
+    return count;
+}
+
+// A detector run whose result has not arrived yet, as inference_node keeps it
+typedef struct {
+    int frame;
+    tracker_state_t state;
+    postprocess_detection_t dets[BENCH_TRACK_OBJECTS + 1];
+    int count;
+} bench_track_pending_t;
+
+typedef struct {
+    double recall;              // Object-frames covered by a reported track
+    double precision;           // Reported tracks that cover an object
+    double mean_iou;            // Of the covering tracks
+    int id_switches;            // Track id under an object changed
+    uint64_t tracker_switches;  // The tracker's own estimate
+    double us_per_frame;
+} bench_track_result_t;
+
+// Every frame: move, predict, detect on every interval-th frame, then
+// match the reported tracks to the objects (IoU >= 0.5, greedy). A result
+// that arrives latency frames late is applied like inference_node does:
+// rewind to its frame, update, and predict forward again.
+static int bench_track_run(int interval, int latency, bench_track_result_t* result) {
+    tracker_config_t config;
+    tracker_config_default(&config);
+    tracker_t tracker;
+    if (tracker_init(&tracker, &config) != 0) {
+        return -1;
+    }
+
+    unsigned seed = 12345u;
+    bench_object_t objects[BENCH_TRACK_OBJECTS];
+    bench_scene_init(objects, &seed);
+    bench_track_pending_t* pending = calloc(BENCH_TRACK_PENDING, sizeof(*pending));
+    if (!pending) {
+        tracker_fini(&tracker);
+        return -1;
+    }
+    int pending_count = 0;
+    tracker_output_t out[TRACKER_MAX_TRACKS];
+    uint32_t last_id[BENCH_TRACK_OBJECTS] = { 0 };
+
+    long long covered = 0, reported = 0, matched = 0, tracker_ns = 0;
+    double iou_sum = 0.0;
+    memset(result, 0, sizeof(*result));
+    for (int frame = 0; frame < BENCH_TRACK_FRAMES; ++frame) {
+        bench_scene_step(objects);
+        long long t0 = bench_now_ns();
+        tracker_predict(&tracker);
+        if (frame % interval == 0 && pending_count < BENCH_TRACK_PENDING) {
+            bench_track_pending_t* p = &pending[pending_count++];
+            p->frame = frame;
+            p->state = tracker.state;
+            tracker_ns += bench_now_ns() - t0;
+            p->count = bench_scene_detect(objects, p->dets, &seed);
+            t0 = bench_now_ns();
+        }
+        while (pending_count > 0 && pending[0].frame + latency <= frame) {
+            int detected = pending[0].frame;
+            tracker.state = pending[0].state;
+            tracker_update(&tracker, pending[0].dets, pending[0].count);
+            memmove(&pending[0], &pending[1], (size_t)--pending_count * sizeof(pending[0]));
+            int next = 0;
+            for (int f = detected + 1; f <= frame; ++f) {
+                tracker_predict(&tracker);
+                if (next < pending_count && pending[next].frame == f) {
+                    pending[next++].state = tracker.state;
+                }
+            }
+        }
+        int n = tracker_output(&tracker, out, TRACKER_MAX_TRACKS);
+        tracker_ns += bench_now_ns() - t0;
+
+        // The first second is warm-up: tracks need min_hits detections
+        if (frame < 30) {
+            continue;
+        }
+        bool taken[TRACKER_MAX_TRACKS] = { false };
+        for (int i = 0; i < BENCH_TRACK_OBJECTS; ++i) {
+            const bench_object_t* o = &objects[i];
+            int best = -1;
+            float best_iou = 0.5f;
+            for (int k = 0; k < n; ++k) {
+                float iou = bench_box_iou(o->x, o->y, o->x + o->w, o->y + o->h,
+                                          out[k].x1, out[k].y1, out[k].x2, out[k].y2);
+                if (!taken[k] && iou >= best_iou) {
+                    best = k;
+                    best_iou = iou;
+                }
+            }
+            if (best < 0) {
+                continue;
+            }
+            taken[best] = true;
+            covered++;
+            iou_sum += best_iou;
+            if (last_id[i] && last_id[i] != out[best].id) {
+                result->id_switches++;
+            }
+            last_id[i] = out[best].id;
+        }
+        for (int k = 0; k < n; ++k) {
+            matched += taken[k];
+        }
+        reported += n;
+    }
+
+    long long object_frames = (long long)(BENCH_TRACK_FRAMES - 30) * BENCH_TRACK_OBJECTS;
+    result->recall = (double)covered / object_frames;
+    result->precision = reported ? (double)matched / reported : 0.0;
+    result->mean_iou = covered ? iou_sum / covered : 0.0;
+    result->tracker_switches = tracker.state.id_switches;
+    result->us_per_frame = tracker_ns / 1e3 / BENCH_TRACK_FRAMES;
+    free(pending);
+    tracker_fini(&tracker);
+    return 0;
+}
+
+static int bench_tracker(void) {
+    printf("tracker (%d objects, %d frames, %.0f%% missed, detector every N frames)\n",
+           BENCH_TRACK_OBJECTS, BENCH_TRACK_FRAMES, 100.0f * BENCH_TRACK_MISS_RATE);
+    printf("  %3s %7s %6s %7s %10s %9s %11s %14s %7s\n", "N", "latency", "duty", "recall",
+           "precision", "mean IoU", "id switches", "tracker est.", "us/frame");
+    for (size_t i = 0; i < BENCH_TRACK_RUN_COUNT; ++i) {
+        int interval = g_track_runs[i].interval;
+        bench_track_result_t r;
+        if (bench_track_run(interval, g_track_runs[i].latency, &r) != 0) {
+            return -1;
+        }
+        printf("  %3d %7d %5.0f%% %7.3f %10.3f %9.3f %11d %14llu %7.2f\n", interval,
+               g_track_runs[i].latency, 100.0 / interval, r.recall, r.precision, r.mean_iou,
+               r.id_switches, (unsigned long long)r.tracker_switches, r.us_per_frame);
+        bench_report("us", r.us_per_frame, "n%d/l%d/time", interval, g_track_runs[i].latency);
+        bench_report("ratio", r.recall, "n%d/l%d/recall", interval, g_track_runs[i].latency);
+        bench_report("ratio", r.precision, "n%d/l%d/precision", interval, g_track_runs[i].latency);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// latency_trace: cost per record and the percentiles the histogram reports
+// ---------------------------------------------------------------------------
+
+#define BENCH_LATENCY_SAMPLES 100000
+
+typedef enum {
+    BENCH_LATENCY_UNIFORM,              // 1-50 ms
+    BENCH_LATENCY_LOGNORMAL,            // Around 20 ms, long tail
+    BENCH_LATENCY_BIMODAL,              // 5 ms, 2% stalls around 80 ms
+    BENCH_LATENCY_MICRO,                // 0-40 us, mostly exact buckets
+    BENCH_LATENCY_DIST_COUNT
+} bench_latency_dist_t;
+
+static const char* const g_latency_dist_names[BENCH_LATENCY_DIST_COUNT] = {
+    "uniform", "lognormal", "bimodal", "micro",
+};
+
+static int64_t bench_latency_sample(bench_latency_dist_t dist, unsigned* seed) {
+    double u = bench_random_unit(seed);
+    switch (dist) {
+        case BENCH_LATENCY_UNIFORM:
+            return (int64_t)(1e6 + u * 49e6);
+        case BENCH_LATENCY_LOGNORMAL: {
+            // Box-Muller
+            double v = bench_random_unit(seed);
+            double z = sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);
+            return (int64_t)(20e6 * exp(0.5 * z));
+        }
+        case BENCH_LATENCY_BIMODAL:
+            return u < 0.02 ? (int64_t)(70e6 + bench_random_unit(seed) * 10e6) :
+                              (int64_t)(5e6 + bench_random_unit(seed) * 0.5e6);
+        default:
+            return (int64_t)(u * 40e3);
+    }
+}
+
+static int bench_compare_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Exact percentile with the histogram's rank rule (ceil, 1-based)
+static int64_t bench_latency_exact(const int64_t* sorted, size_t count, double percentile) {
+    double exact = percentile / 100.0 * (double)count;
+    size_t rank = (size_t)exact;
+    if ((double)rank < exact || rank == 0) {
+        rank++;
+    }
+    return sorted[rank - 1];
+}
+
+static int bench_latency_trace(void) {
+    static const double percentiles[] = { 50.0, 95.0, 99.0, 99.9 };
+    const size_t percentile_count = sizeof(percentiles) / sizeof(percentiles[0]);
+
+    printf("latency_trace (%d samples, %d buckets of %zu bytes)\n", BENCH_LATENCY_SAMPLES,
+           LATENCY_HISTOGRAM_BUCKETS, sizeof(latency_histogram_t));
+    int64_t* samples = malloc(BENCH_LATENCY_SAMPLES * sizeof(int64_t));
+    latency_histogram_t* histogram = malloc(sizeof(latency_histogram_t));
+    if (!samples || !histogram) {
+        free(samples);
+        free(histogram);
+        return -1;
+    }
+
+    printf("  %-10s %11s %11s %11s %11s %10s %9s %8s\n", "dist", "p50 ms", "p95 ms", "p99 ms",
+           "p99.9 ms", "max ms", "max err", "ns/rec");
+    for (int d = 0; d < BENCH_LATENCY_DIST_COUNT; ++d) {
+        unsigned seed = 1234u + (unsigned)d;
+        for (int i = 0; i < BENCH_LATENCY_SAMPLES; ++i) {
+            samples[i] = bench_latency_sample((bench_latency_dist_t)d, &seed);
+        }
+
+        latency_histogram_reset(histogram);
+        long long start = bench_now_ns();
+        for (int i = 0; i < BENCH_LATENCY_SAMPLES; ++i) {
+            latency_histogram_record(histogram, samples[i]);
+        }
+        double ns_per_record = (double)(bench_now_ns() - start) / BENCH_LATENCY_SAMPLES;
+
+        qsort(samples, BENCH_LATENCY_SAMPLES, sizeof(int64_t), bench_compare_i64);
+        double worst = 0.0;
+        printf("  %-10s", g_latency_dist_names[d]);
+        for (size_t p = 0; p < percentile_count; ++p) {
+            int64_t exact = bench_latency_exact(samples, BENCH_LATENCY_SAMPLES, percentiles[p]);
+            int64_t estimate = latency_histogram_percentile(histogram, percentiles[p]);
+            double error = fabs((double)(estimate - exact)) / (exact > 32000 ? (double)exact : 32000.0);
+            worst = error > worst ? error : worst;
+            printf(" %11.3f", estimate / 1e6);
+        }
+        printf(" %10.3f %8.2f%% %8.1f\n", histogram->max_ns / 1e6, 100.0 * worst, ns_per_record);
+        bench_report("ns", ns_per_record, "%s/record", g_latency_dist_names[d]);
+    }
+
+    free(samples);
+    free(histogram);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// convert: every YUYV -> RGB24 kernel the CPU runs, one thread
+// ---------------------------------------------------------------------------
+
+static const bench_resolution_t g_frame_resolutions[] = {
+    { 320, 240, "320x240" },
+    { 640, 480, "640x480" },
+    { 1280, 720, "1280x720" },
+    { 1920, 1080, "1920x1080" },
+};
+#define BENCH_FRAME_RESOLUTION_COUNT (sizeof(g_frame_resolutions) / sizeof(g_frame_resolutions[0]))
+
+typedef struct {
+    yuyv_to_rgb24_fn convert;
+    const uint8_t* src;
+    uint8_t* dst;
+    int width;
+    int height;
+} bench_kernel_ctx_t;
+
+static void bench_convert_kernel(void* arg) {
+    bench_kernel_ctx_t* ctx = (bench_kernel_ctx_t*)arg;
+    ctx->convert(ctx->src, ctx->width * 2, ctx->dst, ctx->width * 3, ctx->width, ctx->height);
+}
+
+static int bench_convert(void) {
+    printf("convert (yuyv_to_rgb24, 1 thread, dispatched kernel: %s)\n",
+           color_convert_isa_name(color_convert_active_isa()));
+    printf("  %-10s %-7s %10s %9s %8s\n", "resolution", "kernel", "ms/frame", "MPix/s", "speedup");
+
+    for (size_t r = 0; r < BENCH_FRAME_RESOLUTION_COUNT; ++r) {
+        const bench_resolution_t* res = &g_frame_resolutions[r];
+        size_t src_size = (size_t)res->width * res->height * 2;
+        size_t dst_size = (size_t)res->width * res->height * 3;
+        uint8_t* src = malloc(src_size);
+        uint8_t* dst = malloc(dst_size);
+        if (!src || !dst) {
+            free(src);
+            free(dst);
+            return -1;
+        }
+        bench_fill_random(src, src_size, 1);
+
+        long long scalar = 0;
+        for (int isa = 0; isa < COLOR_CONVERT_ISA_COUNT; ++isa) {
+            yuyv_to_rgb24_fn convert = color_convert_get_yuyv_to_rgb24((color_convert_isa_t)isa);
+            if (!convert || color_convert_detect_isa() < (color_convert_isa_t)isa) {
+                continue;
+            }
+            bench_kernel_ctx_t ctx = { convert, src, dst, res->width, res->height };
+            long long ns = bench_measure(bench_convert_kernel, &ctx);
+            if (isa == COLOR_CONVERT_ISA_SCALAR) {
+                scalar = ns;
+            }
+            const char* name = color_convert_isa_name((color_convert_isa_t)isa);
+            printf("  %-10s %-7s %10.3f %9.1f %7.2fx\n", res->name, name, ns / 1e6,
+                   (double)res->width * res->height / (ns / 1e3), (double)scalar / ns);
+            bench_report("ms", ns / 1e6, "%s/%s", res->name, name);
+        }
+
+        free(src);
+        free(dst);
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// message_prep: per-frame work before publishing a YUYV frame: refilling
+// the camera's sensor_msgs/Image like camera_node_read_frame, a new message
+// per frame, and a shared-memory frame ring slot instead
+// ---------------------------------------------------------------------------
+
+#define BENCH_MESSAGE_ENCODING "yuv422_yuy2"
+
+typedef struct {
+    sensor_msgs__msg__Image* msg;
+    frame_ring_t* ring;
+    const uint8_t* frame;
+    size_t size;
+    int width;
+    int height;
+    int failures;
+} bench_message_ctx_t;
+
+static void bench_message_refill(void* arg) {
+    bench_message_ctx_t* ctx = (bench_message_ctx_t*)arg;
+    if (image_message_fill(ctx->msg, ctx->frame, ctx->size, (uint32_t)ctx->width,
+                           (uint32_t)ctx->height, (uint32_t)ctx->width * 2,
+                           BENCH_MESSAGE_ENCODING) != 0) {
+        ctx->failures++;
+    }
+}
+
+static void bench_message_fresh(void* arg) {
+    bench_message_ctx_t* ctx = (bench_message_ctx_t*)arg;
+    sensor_msgs__msg__Image* msg = sensor_msgs__msg__Image__create();
+    if (!msg || image_message_fill(msg, ctx->frame, ctx->size, (uint32_t)ctx->width,
+                                   (uint32_t)ctx->height, (uint32_t)ctx->width * 2,
+                                   BENCH_MESSAGE_ENCODING) != 0) {
+        ctx->failures++;
+    }
+    if (msg) {
+        sensor_msgs__msg__Image__destroy(msg);
+    }
+}
+
+static void bench_message_ring(void* arg) {
+    bench_message_ctx_t* ctx = (bench_message_ctx_t*)arg;
+    int slot = frame_ring_begin_write(ctx->ring);
+    if (slot < 0) {
+        ctx->failures++;
+        return;
+    }
+    memcpy(frame_ring_slot_data(ctx->ring, slot), ctx->frame, ctx->size);
+    frame_ring_frame_info_t info = {
+        .size = (uint32_t)ctx->size,
+        .width = (uint32_t)ctx->width,
+        .height = (uint32_t)ctx->height,
+        .step = (uint32_t)ctx->width * 2,
+        .stamp_ns = 0,
+        .encoding = BENCH_MESSAGE_ENCODING,
+    };
+    frame_ring_commit_write(ctx->ring, slot, &info);
+}
+
+static int bench_message_prep(void) {
+    printf("message_prep (YUYV frame into a message or ring slot)\n");
+    printf("  %-10s %10s %10s %10s %9s\n", "resolution", "refill ms", "new ms", "ring ms", "GB/s");
+
+    int result = 0;
+    for (size_t r = 0; r < BENCH_FRAME_RESOLUTION_COUNT && result == 0; ++r) {
+        const bench_resolution_t* res = &g_frame_resolutions[r];
+        size_t size = (size_t)res->width * res->height * 2;
+        uint8_t* frame = malloc(size);
+        sensor_msgs__msg__Image* msg = sensor_msgs__msg__Image__create();
+        char ring_name[64];
+        snprintf(ring_name, sizeof(ring_name), "/bench_frames_%d", (int)getpid());
+        frame_ring_t ring;
+        if (!frame || !msg || frame_ring_create(&ring, ring_name, 4, size) != 0) {
+            free(frame);
+            if (msg) {
+                sensor_msgs__msg__Image__destroy(msg);
+            }
+            return -1;
+        }
+        bench_fill_random(frame, size, 5);
+
+        bench_message_ctx_t ctx = { msg, &ring, frame, size, res->width, res->height, 0 };
+        long long refill = bench_measure(bench_message_refill, &ctx);
+        long long fresh = bench_measure(bench_message_fresh, &ctx);
+        long long ring_ns = bench_measure(bench_message_ring, &ctx);
+        printf("  %-10s %10.3f %10.3f %10.3f %9.2f\n", res->name, refill / 1e6, fresh / 1e6,
+               ring_ns / 1e6, (double)size / refill);
+        bench_report("ms", refill / 1e6, "%s/refill", res->name);
+        bench_report("ms", fresh / 1e6, "%s/new", res->name);
+        bench_report("ms", ring_ns / 1e6, "%s/ring", res->name);
+
+        if (ctx.failures) {
+            fprintf(stderr, "message_prep: %s fills failed\n", res->name);
+            result = -1;
+        }
+        frame_ring_close(&ring);
+        sensor_msgs__msg__Image__destroy(msg);
+        free(frame);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// frame_source: replay and test pattern sources, no camera needed. Each
+// source runs unpaced into a capture queue with the WAIT policy, as
+// camera_node does, drained by a thread that copies every frame once (like
+// the frame ring write): the rate is what capture -> publish sustains.
+// ---------------------------------------------------------------------------
+
+#define BENCH_SOURCE_FILE_FRAMES 30
+#define BENCH_SOURCE_PIPELINE_FRAMES 600
+#define BENCH_SOURCE_QUEUE_DEPTH 3
+
+typedef struct {
+    frame_queue_t* queue;
+    uint8_t* dst;               // Stand-in for a ring slot
+    int frames;
+    int out_of_order;
+    uint64_t bytes;
+} bench_source_consumer_t;
+
+static void* bench_source_consume(void* arg) {
+    bench_source_consumer_t* consumer = (bench_source_consumer_t*)arg;
+    struct pollfd pfd = { .fd = frame_queue_event_fd(consumer->queue), .events = POLLIN };
+    int received = 0;
+    uint32_t expected = 0;
+    while (received < consumer->frames) {
+        poll(&pfd, 1, 1000);
+        frame_queue_clear_event(consumer->queue);
+        frame_queue_frame_t* frame;
+        while ((frame = frame_queue_pop(consumer->queue)) != NULL) {
+            if (frame->sequence != expected) {
+                consumer->out_of_order++;
+            }
+            expected = frame->sequence + 1;
+            memcpy(consumer->dst, frame->data, frame->size);
+            consumer->bytes += frame->size;
+            frame_queue_release(consumer->queue, frame);
+            received++;
+        }
+    }
+    return NULL;
+}
+
+// Frames per second an unpaced source sustains through the capture queue
+static int bench_source_pipeline(const camera_config_t* config, const char* label) {
+    frame_source_t source;
+    if (frame_source_open(&source, config) != 0 || frame_source_start(&source) != 0) {
+        return -1;
+    }
+    frame_queue_t queue;
+    uint8_t* dst = malloc(source.mode.sizeimage);
+    if (!dst || frame_queue_init(&queue, BENCH_SOURCE_QUEUE_DEPTH, source.mode.sizeimage,
+                                 FRAME_QUEUE_WAIT) != 0) {
+        free(dst);
+        frame_source_close(&source);
+        return -1;
+    }
+
+    bench_source_consumer_t consumer = { &queue, dst, BENCH_SOURCE_PIPELINE_FRAMES, 0, 0 };
+    pthread_t thread;
+    long long start = bench_now_ns();
+    if (pthread_create(&thread, NULL, bench_source_consume, &consumer) != 0) {
+        frame_queue_fini(&queue);
+        free(dst);
+        frame_source_close(&source);
+        return -1;
+    }
+
+    // The capture thread's loop, minus epoll on the shutdown fd
+    struct pollfd pfd = { .fd = frame_queue_space_fd(&queue), .events = POLLIN };
+    int pushed = 0;
+    int result = 0;
+    while (pushed < BENCH_SOURCE_PIPELINE_FRAMES && result == 0) {
+        poll(&pfd, 1, 1000);
+        frame_queue_clear_space(&queue);
+        while (pushed < BENCH_SOURCE_PIPELINE_FRAMES && !frame_queue_full(&queue)) {
+            frame_source_frame_t captured;
+            frame_queue_frame_t* frame;
+            if (frame_source_next(&source, &captured) != 1 || !captured.borrowed ||
+                (frame = frame_queue_begin_push(&queue)) == NULL) {
+                result = -1;
+                break;
+            }
+            frame->data = captured.data;
+            frame->size = captured.size;
+            frame->sequence = captured.sequence;
+            frame_queue_push(&queue);
+            pushed++;
+        }
+    }
+    if (result != 0) {
+        // Let the consumer finish on what was queued
+        consumer.frames = pushed;
+    }
+    pthread_join(thread, NULL);
+    long long elapsed = bench_now_ns() - start;
+
+    frame_queue_stats_t stats;
+    frame_queue_get_stats(&queue, &stats);
+    double fps = BENCH_SOURCE_PIPELINE_FRAMES * 1e9 / elapsed;
+    printf("  %-24s %10.0f %9.2f\n", label, fps, consumer.bytes / (double)elapsed);
+    bench_report("fps", fps, "%s/pipeline", label);
+
+    if (result != 0 || consumer.out_of_order || stats.dropped_oldest || stats.dropped_newest ||
+        source.drops) {
+        fprintf(stderr, "frame_source: %s lost or reordered frames\n", label);
+        result = -1;
+    }
+    frame_queue_fini(&queue);
+    free(dst);
+    frame_source_close(&source);
+    return result;
+}
+
+// Test file frame i: random bytes, or the same JPEG every time
+static void bench_source_expected(int i, uint8_t* data, size_t size) {
+    bench_fill_random(data, size, (unsigned)i + 1);
+}
+
+static int bench_source_write_files(const char* y4m, const char* raw, const char* mjpeg,
+                                    int width, int height, const uint8_t* jpeg, size_t jpeg_size) {
+    size_t i420_size = (size_t)width * height * 3 / 2;
+    size_t yuyv_size = (size_t)width * height * 2;
+    uint8_t* frame = malloc(yuyv_size);
+    FILE* y4m_file = fopen(y4m, "wb");
+    FILE* raw_file = fopen(raw, "wb");
+    FILE* mjpeg_file = fopen(mjpeg, "wb");
+    int result = frame && y4m_file && raw_file && mjpeg_file ? 0 : -1;
+
+    if (result == 0) {
+        fprintf(y4m_file, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg\n", width, height);
+        for (int i = 0; i < BENCH_SOURCE_FILE_FRAMES; ++i) {
+            bench_source_expected(i, frame, i420_size);
+            fprintf(y4m_file, i % 2 ? "FRAME Ixyz\n" : "FRAME\n");  // Parameters are skipped
+            fwrite(frame, 1, i420_size, y4m_file);
+            bench_source_expected(i, frame, yuyv_size);
+            fwrite(frame, 1, yuyv_size, raw_file);
+            fwrite(jpeg, 1, jpeg_size, mjpeg_file);
+        }
+    }
+    if (y4m_file && fclose(y4m_file) != 0) {
+        result = -1;
+    }
+    if (raw_file && fclose(raw_file) != 0) {
+        result = -1;
+    }
+    if (mjpeg_file && fclose(mjpeg_file) != 0) {
+        result = -1;
+    }
+    free(frame);
+    return result;
+}
+
+static int bench_frame_source(void) {
+    printf("frame_source (unpaced source -> capture queue -> copy, %d frames)\n",
+           BENCH_SOURCE_PIPELINE_FRAMES);
+    printf("  %-24s %10s %9s\n", "source", "fps", "GB/s");
+
+    int result = 0;
+    for (size_t r = 0; r < BENCH_FRAME_RESOLUTION_COUNT && result == 0; ++r) {
+        const bench_resolution_t* res = &g_frame_resolutions[r];
+        camera_config_t config;
+        camera_config_init(&config, "", (uint32_t)res->width, (uint32_t)res->height, 30, 80, 15);
+        config.source = CAMERA_SOURCE_SYNTHETIC;
+        config.realtime = false;
+        char label[64];
+        snprintf(label, sizeof(label), "synthetic/%s", res->name);
+        result = bench_source_pipeline(&config, label);
+    }
+
+    // Recordings at 640x480 in every container
+    const int width = 640, height = 480;
+    const char* dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    char y4m[256], raw[256], mjpeg[256];
+    snprintf(y4m, sizeof(y4m), "%s/bench_source_%d.y4m", dir, (int)getpid());
+    snprintf(raw, sizeof(raw), "%s/bench_source_%d.yuyv", dir, (int)getpid());
+    snprintf(mjpeg, sizeof(mjpeg), "%s/bench_source_%d.mjpeg", dir, (int)getpid());
+    size_t jpeg_size = 0;
+    uint8_t* jpeg = bench_make_jpeg(width, height, &jpeg_size);
+    if (result == 0 && (!jpeg || bench_source_write_files(y4m, raw, mjpeg, width, height,
+                                                          jpeg, jpeg_size) != 0)) {
+        fprintf(stderr, "frame_source: cannot write test files to %s\n", dir);
+        result = -1;
+    }
+
+    const struct {
+        const char* label;
+        const char* path;
+        uint32_t format;        // Needed for raw files only
+        bool jpeg;
+    } files[] = {
+        { "y4m/640x480", y4m, 0, false },
+        { "raw-yuyv/640x480", raw, V4L2_PIX_FMT_YUYV, false },
+        { "mjpeg/640x480", mjpeg, 0, true },
+    };
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]) && result == 0; ++f) {
+        camera_config_t config;
+        camera_config_init(&config, "", (uint32_t)width, (uint32_t)height, 30, 80, 15);
+        config.source = CAMERA_SOURCE_FILE;
+        config.realtime = false;
+        config.pixel_format = files[f].format;
+        snprintf(config.file, sizeof(config.file), "%s", files[f].path);
+        result = bench_source_pipeline(&config, files[f].label);
+    }
+    unlink(y4m);
+    unlink(raw);
+    unlink(mjpeg);
+    free(jpeg);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// record: raw recording throughput and seeking. Frames are written the way
+// a bag would (stdio, one write per frame) and through the recorder, first
+// as fast as possible and then at a camera rate; the recording is then
+// seeked by time.
+// BENCH_RECORD_DIR picks the disk (default $TMPDIR or /tmp).
+// ---------------------------------------------------------------------------
+
+#define BENCH_RECORD_WIDTH 1280
+#define BENCH_RECORD_HEIGHT 720
+#define BENCH_RECORD_FRAMES 150
+#define BENCH_RECORD_PATTERNS 8      // Distinct frame contents, by sequence
+#define BENCH_RECORD_QUEUE_DEPTH 16
+#define BENCH_RECORD_PACED_FPS 30
+#define BENCH_RECORD_PACED_FRAMES 60
+#define BENCH_RECORD_SEEKS 100000
+#define BENCH_RECORD_LONG_FRAMES (10 * 3600 * BENCH_RECORD_PACED_FPS)
+
+// Small buffered writes, one frame at a time, then fsync
+static double bench_record_stdio(const char* path, uint8_t* const* patterns, size_t frame_size) {
+    long long start = bench_now_ns();
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        return -1.0;
+    }
+    int result = 0;
+    for (int i = 0; i < BENCH_RECORD_FRAMES && result == 0; ++i) {
+        frame_record_frame_t header = { .magic = FRAME_RECORD_FRAME_MAGIC, .size = (uint32_t)frame_size };
+        if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+            fwrite(patterns[i % BENCH_RECORD_PATTERNS], 1, frame_size, file) != frame_size) {
+            result = -1;
+        }
+    }
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0) {
+        result = -1;
+    }
+    fclose(file);
+    double seconds = (bench_now_ns() - start) / 1e9;
+    return result == 0 ? BENCH_RECORD_FRAMES * (double)frame_size / 1e6 / seconds : -1.0;
+}
+
+// Write frames through the recorder, back to back (fps 0) or at fps.
+// Fills stats with the recorder's view after close.
+static int bench_record_run(const char* path, uint8_t* const* patterns, size_t frame_size,
+                            int frames, int fps, frame_recorder_stats_t* stats, double* mb_per_s) {
+    frame_recorder_t recorder;
+    if (frame_recorder_open(&recorder, path, V4L2_PIX_FMT_YUYV, BENCH_RECORD_WIDTH, BENCH_RECORD_HEIGHT,
+                            BENCH_RECORD_WIDTH * 2, fps ? fps : BENCH_RECORD_PACED_FPS, frame_size,
+                            BENCH_RECORD_QUEUE_DEPTH) != 0) {
+        return -1;
+    }
+    long long start = bench_now_ns();
+    for (int i = 0; i < frames; ++i) {
+        if (fps) {
+            long long due = start + (long long)i * 1000000000LL / fps;
+            long long now = bench_now_ns();
+            if (due > now) {
+                bench_sleep_us((int)((due - now) / 1000));
+            }
+        }
+        frame_recorder_write(&recorder, patterns[i % BENCH_RECORD_PATTERNS], frame_size,
+                             (uint32_t)i, latency_monotonic_ns());
+    }
+    // Close writes the index and syncs, so the rate covers the data being
+    // on disk
+    int result = frame_recorder_close(&recorder, stats);
+    double seconds = (bench_now_ns() - start) / 1e9;
+    *mb_per_s = stats->bytes / 1e6 / seconds;
+    return result;
+}
+
+// Seek by time at random times around the recording, then over a 10-hour
+// index at 30 fps
+static int bench_record_seek(const frame_record_player_t* player) {
+    const frame_record_view_t* view = &player->view;
+    int64_t first = view->index[0].stamp_ns;
+    int64_t span = view->index[view->count - 1].stamp_ns - first;
+    int64_t stamps[256];
+    unsigned seed = 7;
+    for (int i = 0; i < 256; ++i) {
+        stamps[i] = first - span / 10 + (int64_t)(bench_random_unit(&seed) * span * 1.2);
+    }
+
+    frame_record_view_t hours;
+    memset(&hours, 0, sizeof(hours));
+    hours.count = BENCH_RECORD_LONG_FRAMES;
+    hours.rebuilt = malloc(hours.count * sizeof(frame_record_entry_t));
+    if (!hours.rebuilt) {
+        return -1;
+    }
+    for (size_t i = 0; i < hours.count; ++i) {
+        hours.rebuilt[i].stamp_ns = first + (int64_t)i * 1000000000LL / BENCH_RECORD_PACED_FPS;
+    }
+    hours.index = hours.rebuilt;
+    int64_t hours_span = hours.rebuilt[hours.count - 1].stamp_ns - first;
+
+    size_t sink = 0;
+    long long start = bench_now_ns();
+    for (int i = 0; i < BENCH_RECORD_SEEKS; ++i) {
+        sink += frame_record_player_seek(player, stamps[i & 255]);
+    }
+    double ns = (double)(bench_now_ns() - start) / BENCH_RECORD_SEEKS;
+    start = bench_now_ns();
+    for (int i = 0; i < BENCH_RECORD_SEEKS; ++i) {
+        sink += frame_record_view_seek(&hours, first + (stamps[i & 255] - first) % hours_span * 7);
+    }
+    double long_ns = (double)(bench_now_ns() - start) / BENCH_RECORD_SEEKS;
+    printf("  seek by time: %.0f ns over %zu frames, %.0f ns over %zu (%zu)\n",
+           ns, view->count, long_ns, hours.count, sink % 2);
+    bench_report("ns", ns, "seek");
+    bench_report("ns", long_ns, "seek/10h");
+    frame_record_view_fini(&hours);
+    return 0;
+}
+
+static int bench_record(void) {
+    const char* dir = getenv("BENCH_RECORD_DIR");
+    if (!dir) {
+        dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    }
+    char stdio_path[256], path[256];
+    snprintf(stdio_path, sizeof(stdio_path), "%s/bench_record_%d.bin", dir, (int)getpid());
+    snprintf(path, sizeof(path), "%s/bench_record_%d.rec", dir, (int)getpid());
+
+    size_t frame_size = (size_t)BENCH_RECORD_WIDTH * BENCH_RECORD_HEIGHT * 2;
+    uint8_t* patterns[BENCH_RECORD_PATTERNS];
+    int result = 0;
+    for (int i = 0; i < BENCH_RECORD_PATTERNS; ++i) {
+        patterns[i] = malloc(frame_size);
+        if (!patterns[i]) {
+            result = -1;
+        } else {
+            bench_fill_random(patterns[i], frame_size, (unsigned)i + 1);
+        }
+    }
+
+    printf("record (%dx%d YUYV, %.1f MB frames, to %s)\n",
+           BENCH_RECORD_WIDTH, BENCH_RECORD_HEIGHT, frame_size / 1e6, dir);
+    double stdio_rate = result == 0 ? bench_record_stdio(stdio_path, patterns, frame_size) : -1.0;
+    unlink(stdio_path);
+    if (stdio_rate < 0.0) {
+        fprintf(stderr, "record: cannot write to %s\n", dir);
+        result = -1;
+    } else {
+        printf("  %-28s %8.0f MB/s\n", "stdio, one write per frame", stdio_rate);
+        bench_report("MB/s", stdio_rate, "stdio");
+    }
+
+    frame_recorder_stats_t stats;
+    double flood_rate = 0.0;
+    if (result == 0) {
+        result = bench_record_run(path, patterns, frame_size, BENCH_RECORD_FRAMES, 0, &stats, &flood_rate);
+    }
+    if (result == 0) {
+        printf("  %-28s %8.0f MB/s  %s writes, disk busy %.0f%%, longest write %.1f ms, "
+               "%llu of %d frames dropped\n", "recorder, back to back", flood_rate,
+               stats.direct ? "direct" : "buffered",
+               stats.elapsed_ns ? 100.0 * stats.write_ns / stats.elapsed_ns : 0.0,
+               stats.max_write_ns / 1e6, (unsigned long long)stats.dropped, BENCH_RECORD_FRAMES);
+        bench_report("MB/s", flood_rate, "recorder");
+    }
+
+    double paced_rate = 0.0;
+    if (result == 0) {
+        result = bench_record_run(path, patterns, frame_size, BENCH_RECORD_PACED_FRAMES,
+                                  BENCH_RECORD_PACED_FPS, &stats, &paced_rate);
+    }
+    if (result == 0) {
+        printf("  %-28s %8.0f MB/s  %llu of %d frames dropped\n", "recorder, 30 fps", paced_rate,
+               (unsigned long long)stats.dropped, BENCH_RECORD_PACED_FRAMES);
+        bench_report("frames", BENCH_RECORD_PACED_FRAMES - (double)stats.dropped, "paced/recorded");
+    }
+
+    if (result == 0) {
+        frame_record_player_t player;
+        result = frame_record_player_open(&player, path);
+        if (result == 0) {
+            result = bench_record_seek(&player);
+            frame_record_player_close(&player);
+        }
+    }
+
+    unlink(path);
+    for (int i = 0; i < BENCH_RECORD_PATTERNS; ++i) {
+        free(patterns[i]);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// dds_roundtrip: publish -> take through the middleware inside this
+// process, for raw images of each size and for the frame descriptor that
+// stands in for them on the same host
+// ---------------------------------------------------------------------------
+
+#define BENCH_DDS_ROUND_TRIPS 300
+#define BENCH_DDS_WARMUP 10
+#define BENCH_DDS_DISCOVERY_MS 5000
+#define BENCH_DDS_TIMEOUT_MS 1000
+
+typedef struct {
+    rcl_node_t* node;
+    rcl_wait_set_t* wait_set;
+    rcl_publisher_t publisher;
+    rcl_subscription_t subscription;
+} bench_dds_ctx_t;
+
+// Publisher and subscription on a topic of this process only, matched
+static int bench_dds_connect(bench_dds_ctx_t* dds, const rosidl_message_type_support_t* type_support,
+                             const char* topic) {
+    dds->publisher = rcl_get_zero_initialized_publisher();
+    dds->subscription = rcl_get_zero_initialized_subscription();
+    rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
+    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
+    if (rcl_publisher_init(&dds->publisher, dds->node, type_support, topic, &pub_options) != RCL_RET_OK) {
+        fprintf(stderr, "dds_roundtrip: no publisher for %s\n", topic);
+        return -1;
+    }
+    if (rcl_subscription_init(&dds->subscription, dds->node, type_support, topic,
+                              &sub_options) != RCL_RET_OK) {
+        fprintf(stderr, "dds_roundtrip: no subscription for %s\n", topic);
+        rcl_publisher_fini(&dds->publisher, dds->node);
+        return -1;
+    }
+
+    for (int waited = 0; waited < BENCH_DDS_DISCOVERY_MS; waited += 10) {
+        size_t subscribers = 0, publishers = 0;
+        if (rcl_publisher_get_subscription_count(&dds->publisher, &subscribers) == RCL_RET_OK &&
+            rcl_subscription_get_publisher_count(&dds->subscription, &publishers) == RCL_RET_OK &&
+            subscribers > 0 && publishers > 0) {
+            return 0;
+        }
+        bench_sleep_us(10000);
+    }
+    fprintf(stderr, "dds_roundtrip: %s never matched\n", topic);
+    rcl_subscription_fini(&dds->subscription, dds->node);
+    rcl_publisher_fini(&dds->publisher, dds->node);
+    return -1;
+}
+
+static void bench_dds_disconnect(bench_dds_ctx_t* dds) {
+    rcl_subscription_fini(&dds->subscription, dds->node);
+    rcl_publisher_fini(&dds->publisher, dds->node);
+}
+
+// Publish msg and wait until it has been taken into received
+static int bench_dds_round_trip(bench_dds_ctx_t* dds, const void* msg, void* received) {
+    if (rcl_publish(&dds->publisher, msg, NULL) != RCL_RET_OK) {
+        return -1;
+    }
+    for (;;) {
+        if (rcl_wait_set_clear(dds->wait_set) != RCL_RET_OK ||
+            rcl_wait_set_add_subscription(dds->wait_set, &dds->subscription, NULL) != RCL_RET_OK ||
+            rcl_wait(dds->wait_set, RCL_MS_TO_NS(BENCH_DDS_TIMEOUT_MS)) != RCL_RET_OK) {
+            return -1;
+        }
+        rmw_message_info_t message_info;
+        rcl_ret_t ret = rcl_take(&dds->subscription, received, &message_info, NULL);
+        if (ret == RCL_RET_OK) {
+            return 0;
+        }
+        if (ret != RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+            return -1;
+        }
+    }
+}
+
+static int bench_dds_run(bench_dds_ctx_t* dds, const char* name, size_t bytes,
+                         const rosidl_message_type_support_t* type_support,
+                         const void* msg, void* received) {
+    char topic[96];
+    snprintf(topic, sizeof(topic), "/benchmarks_%d/%s", (int)getpid(), name);
+    if (bench_dds_connect(dds, type_support, topic) != 0) {
+        return -1;
+    }
+
+    latency_histogram_t* histogram = malloc(sizeof(latency_histogram_t));
+    if (!histogram) {
+        bench_dds_disconnect(dds);
+        return -1;
+    }
+    latency_histogram_reset(histogram);
+
+    int result = 0;
+    for (int i = 0; i < BENCH_DDS_WARMUP + BENCH_DDS_ROUND_TRIPS && result == 0; ++i) {
+        int64_t start = latency_monotonic_ns();
+        result = bench_dds_round_trip(dds, msg, received);
+        if (i >= BENCH_DDS_WARMUP) {
+            latency_histogram_record(histogram, latency_monotonic_ns() - start);
+        }
+    }
+
+    if (result == 0) {
+        double p50 = latency_histogram_percentile(histogram, 50.0) / 1e3;
+        double p99 = latency_histogram_percentile(histogram, 99.0) / 1e3;
+        printf("  %-18s %10zu %9.1f %9.1f %9.1f %9.1f\n", name, bytes, p50, p99,
+               histogram->max_ns / 1e3, bytes / p50);
+        bench_report("us", p50, "%s/p50", name);
+        bench_report("us", p99, "%s/p99", name);
+    } else {
+        fprintf(stderr, "dds_roundtrip: %s failed after %llu round trips\n", name,
+                (unsigned long long)histogram->count);
+    }
+    free(histogram);
+    bench_dds_disconnect(dds);
+    return result;
+}
+
+static int bench_dds_images(bench_dds_ctx_t* dds) {
+    const rosidl_message_type_support_t* type_support =
+        ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image);
+    sensor_msgs__msg__Image* msg = sensor_msgs__msg__Image__create();
+    sensor_msgs__msg__Image* received = sensor_msgs__msg__Image__create();
+    if (!msg || !received) {
+        if (msg) {
+            sensor_msgs__msg__Image__destroy(msg);
+        }
+        if (received) {
+            sensor_msgs__msg__Image__destroy(received);
+        }
+        return -1;
+    }
+
+    int result = 0;
+    for (size_t r = 0; r < BENCH_FRAME_RESOLUTION_COUNT && result == 0; ++r) {
+        const bench_resolution_t* res = &g_frame_resolutions[r];
+        size_t size = (size_t)res->width * res->height * 2;
+        uint8_t* frame = malloc(size);
+        if (!frame) {
+            result = -1;
+            break;
+        }
+        bench_fill_random(frame, size, 7);
+        char name[32];
+        snprintf(name, sizeof(name), "image_%s", res->name);
+        if (image_message_fill(msg, frame, size, (uint32_t)res->width, (uint32_t)res->height,
+                               (uint32_t)res->width * 2, BENCH_MESSAGE_ENCODING) != 0) {
+            result = -1;
+        } else {
+            result = bench_dds_run(dds, name, size, type_support, msg, received);
+        }
+        if (result == 0 && (received->data.size != size ||
+                            memcmp(received->data.data, frame, size) != 0)) {
+            fprintf(stderr, "dds_roundtrip: %s arrived damaged\n", name);
+            result = -1;
+        }
+        free(frame);
+    }
+
+    sensor_msgs__msg__Image__destroy(msg);
+    sensor_msgs__msg__Image__destroy(received);
+    return result;
+}
+
+static int bench_dds_descriptor(bench_dds_ctx_t* dds) {
+    embedded_object_detection_pi5__msg__FrameDescriptor* msg =
+        embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    embedded_object_detection_pi5__msg__FrameDescriptor* received =
+        embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    int result = -1;
+    if (msg && received &&
+        rosidl_runtime_c__String__assign(&msg->ring_name, "/camera_frames") &&
+        rosidl_runtime_c__String__assign(&msg->encoding, BENCH_MESSAGE_ENCODING)) {
+        msg->width = 640;
+        msg->height = 480;
+        msg->step = 1280;
+        msg->size = 640 * 480 * 2;
+        result = bench_dds_run(dds, "frame_descriptor", sizeof(*msg),
+                               ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg,
+                                                           FrameDescriptor),
+                               msg, received);
+    }
+    if (msg) {
+        embedded_object_detection_pi5__msg__FrameDescriptor__destroy(msg);
+    }
+    if (received) {
+        embedded_object_detection_pi5__msg__FrameDescriptor__destroy(received);
+    }
+    return result;
+}
+
+static int bench_dds_roundtrip(void) {
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+    if (rcl_init_options_init(&init_options, rcl_get_default_allocator()) != RCL_RET_OK) {
+        return -1;
+    }
+    rcl_context_t context = rcl_get_zero_initialized_context();
+    if (rcl_init(0, NULL, &init_options, &context) != RCL_RET_OK) {
+        // No middleware to measure, e.g. ROS_DOMAIN_ID unusable or no RMW
+        printf("dds_roundtrip skipped: rcl_init failed\n");
+        rcl_init_options_fini(&init_options);
+        return 0;
+    }
+
+    int result = -1;
+    rcl_node_t node = rcl_get_zero_initialized_node();
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    rcl_wait_set_t wait_set = rcl_get_zero_initialized_wait_set();
+    if (rcl_node_init(&node, "benchmarks", "", &context, &node_options) == RCL_RET_OK) {
+        if (rcl_wait_set_init(&wait_set, 1, 0, 0, 0, 0, 0, &context,
+                              rcl_get_default_allocator()) == RCL_RET_OK) {
+            printf("dds_roundtrip (publish -> take in one process, %d round trips)\n",
+                   BENCH_DDS_ROUND_TRIPS);
+            printf("  %-18s %10s %9s %9s %9s %9s\n", "message", "bytes", "p50 us", "p99 us",
+                   "max us", "MB/s");
+            bench_dds_ctx_t dds;
+            memset(&dds, 0, sizeof(dds));
+            dds.node = &node;
+            dds.wait_set = &wait_set;
+            result = bench_dds_descriptor(&dds);
+            if (result == 0) {
+                result = bench_dds_images(&dds);
+            }
+            rcl_wait_set_fini(&wait_set);
+        }
+        rcl_node_fini(&node);
+    }
+
+    rcl_shutdown(&context);
+    rcl_context_fini(&context);
+    rcl_init_options_fini(&init_options);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// composed: camera -> display handoff through the real components. A
+// camera_node (synthetic YUYV source, unpaced) is set up on this process's
+// node with camera_node_init_member and driven at a camera rate: capture,
+// pop, camera_node_publish_queued. The display side takes frames with the
+// display_node intake functions (display_intake.h) into a mailbox, and a
+// render thread runs display_render_take, uploading into a plain buffer
+// in place of a texture. Latency is capture stamp to uploaded, CPU is
+// process CPU time per published frame (middleware threads included).
+//   pool      pipeline_node: camera sink -> display_intake_pool, by pointer
+//   dds_ring  two processes on one host: descriptor through the middleware,
+//             then the ring slot copied out (display_intake_copy_ring)
+//   dds_image two processes without the ring: serialized sensor_msgs/Image
+//             taken and read in place (display_intake_take_image)
+// The dds modes subscribe in this process; rcl has no intra-process
+// shortcut, so frames take the same path as between processes. The camera
+// writes its ring in dds_image too, as a standalone camera_node does. The
+// case is skipped when rcl cannot initialize.
+// ---------------------------------------------------------------------------
+
+#define BENCH_COMPOSED_FPS 100
+#define BENCH_COMPOSED_FRAMES 150
+#define BENCH_COMPOSED_TAKE_MS 10
+#define BENCH_COMPOSED_DESCRIPTOR_RESERVE 512
+
+typedef enum {
+    BENCH_HANDOFF_POOL,
+    BENCH_HANDOFF_DDS_RING,
+    BENCH_HANDOFF_DDS_IMAGE,
+    BENCH_HANDOFF_COUNT
+} bench_handoff_mode_t;
+
+static const char* const g_handoff_names[BENCH_HANDOFF_COUNT] = {
+    "pool", "dds_ring", "dds_image",
+};
+
+// This process's context, node and a one-subscription wait set
+typedef struct {
+    rcl_init_options_t init_options;
+    rcl_context_t context;
+    rcl_node_t node;
+    rcl_wait_set_t wait_set;
+    bool have_context;
+    bool ready;
+} bench_rcl_t;
+
+// 0 if everything is up; bench_rcl_close either way
+static int bench_rcl_open(bench_rcl_t* rcl, const char* node_name) {
+    rcl->init_options = rcl_get_zero_initialized_init_options();
+    rcl->context = rcl_get_zero_initialized_context();
+    rcl->node = rcl_get_zero_initialized_node();
+    rcl->wait_set = rcl_get_zero_initialized_wait_set();
+    rcl->have_context = false;
+    rcl->ready = false;
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    if (rcl_init_options_init(&rcl->init_options, rcl_get_default_allocator()) == RCL_RET_OK) {
+        rcl->have_context = rcl_init(0, NULL, &rcl->init_options, &rcl->context) == RCL_RET_OK;
+        if (rcl->have_context) {
+            if (rcl_node_init(&rcl->node, node_name, "", &rcl->context, &node_options) == RCL_RET_OK &&
+                rcl_wait_set_init(&rcl->wait_set, 1, 0, 0, 0, 0, 0, &rcl->context,
+                                  rcl_get_default_allocator()) == RCL_RET_OK) {
+                rcl->ready = true;
+            }
+        }
+    }
+    return rcl->ready ? 0 : -1;
+}
+
+static void bench_rcl_close(bench_rcl_t* rcl) {
+    // Both fini calls accept what is still zero-initialized
+    if (rcl->have_context) {
+        rcl_wait_set_fini(&rcl->wait_set);
+        rcl_node_fini(&rcl->node);
+        rcl_shutdown(&rcl->context);
+        rcl_context_fini(&rcl->context);
+    }
+    rcl_init_options_fini(&rcl->init_options);
+}
+
+// One camera and one display stream, joined by a transport
+typedef struct {
+    bench_handoff_mode_t mode;
+    camera_node_t camera;
+    bool camera_ready;
+
+    // Display intake, as display_node_init_stream sets it up
+    rcl_node_t* node;
+    rcl_wait_set_t* wait_set;
+    rcl_subscription_t subscription;
+    bool subscribed;
+    rmw_serialized_message_t descriptor_serialized;
+    embedded_object_detection_pi5__msg__FrameDescriptor* descriptor;
+    frame_ring_t ring;
+    bool ring_open;
+    display_frame_t frames[FRAME_MAILBOX_BUFFERS];
+    frame_mailbox_t mailbox;
+    bool mailbox_ready;
+    frame_mailbox_group_t group;
+    bool group_ready;
+    uint64_t intake_index;
+    uint64_t stale;             // Ring slots recycled before the intake got there
+
+    // Render side
+    display_render_t render;
+    uint8_t* texture;
+    size_t texture_size;
+    uint64_t uploads;           // Upload callbacks that wrote the texture
+    worker_pool_t* convert;     // If set, uploads convert to RGB into rgb
+    uint8_t* rgb;
+    latency_histogram_t histogram;
+    uint64_t received;
+    int stop;                   // Atomic
+    int failed;
+} bench_link_t;
+
+// display_render_upload_t: the texture upload, rows into one buffer or
+// converted into rgb
+static int bench_link_upload(void* ctx, int stream, const sensor_msgs__msg__Image* image,
+                             bool partial, int dirty_y, int dirty_height) {
+    bench_link_t* link = (bench_link_t*)ctx;
+    (void)stream;
+    if ((size_t)image->step * image->height != link->texture_size ||
+        image->data.size < link->texture_size) {
+        return -1;
+    }
+    if (!partial || dirty_y < 0 || dirty_height < 0 || dirty_y + dirty_height > (int)image->height) {
+        dirty_y = 0;
+        dirty_height = (int)image->height;
+    }
+    if (link->convert) {
+        // display_node's CPU fallback, sdl2_upload_yuyv_converted
+        size_t rgb_step = (size_t)image->width * 3;
+        yuyv_to_rgb24_parallel(link->convert, image->data.data + (size_t)dirty_y * image->step,
+                               (int)image->step, link->rgb + (size_t)dirty_y * rgb_step, (int)rgb_step,
+                               (int)image->width, dirty_height);
+    } else {
+        memcpy(link->texture + (size_t)dirty_y * image->step,
+               image->data.data + (size_t)dirty_y * image->step, (size_t)dirty_height * image->step);
+    }
+    link->uploads++;
+    return 0;
+}
+
+// camera_frame_sink_t, as display_node_post_frame
+static void bench_link_post(void* ctx, frame_pool_frame_t* pooled) {
+    bench_link_t* link = (bench_link_t*)ctx;
+    display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&link->mailbox);
+    display_intake_pool(frame, pooled);
+    frame->receive_ns = latency_monotonic_ns();
+    frame->index = ++link->intake_index;
+    frame_mailbox_publish(&link->mailbox);
+}
+
+// The ring the descriptor names, mapped on first use like
+// display_node_handle_descriptor does
+static int bench_link_copy_ring(bench_link_t* link, display_frame_t* frame) {
+    if (!link->ring_open) {
+        if (frame_ring_open(&link->ring, link->descriptor->ring_name.data) != 0) {
+            return -1;
+        }
+        link->ring_open = true;
+    }
+    if (display_intake_copy_ring(frame, &link->ring, link->descriptor) != 0) {
+        link->stale++;
+        return 0;
+    }
+    return 1;
+}
+
+// Intake thread step for the dds modes: wait for the subscription, take
+// into the mailbox. 1 if a frame was posted, 0 if none, -1 on error.
+static int bench_link_intake(bench_link_t* link, int timeout_ms) {
+    if (rcl_wait_set_clear(link->wait_set) != RCL_RET_OK ||
+        rcl_wait_set_add_subscription(link->wait_set, &link->subscription, NULL) != RCL_RET_OK) {
+        return -1;
+    }
+    rcl_ret_t ret = rcl_wait(link->wait_set, RCL_MS_TO_NS(timeout_ms));
+    if (ret == RCL_RET_TIMEOUT) {
+        return 0;
+    }
+    if (ret != RCL_RET_OK) {
+        return -1;
+    }
+
+    display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&link->mailbox);
+    int got = 1;
+    if (link->mode == BENCH_HANDOFF_DDS_IMAGE) {
+        ret = display_intake_take_image(frame, &link->subscription);
+    } else {
+        ret = display_intake_take_descriptor(&link->subscription, &link->descriptor_serialized,
+                                             link->descriptor);
+        if (ret == RCL_RET_OK) {
+            got = bench_link_copy_ring(link, frame);
+        }
+    }
+    if (ret == RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+        return 0;
+    }
+    if (ret != RCL_RET_OK || got <= 0) {
+        return ret != RCL_RET_OK ? -1 : got;
+    }
+    frame->receive_ns = latency_monotonic_ns();
+    frame->index = ++link->intake_index;
+    frame_mailbox_publish(&link->mailbox);
+    return 1;
+}
+
+// Camera publish thread step: one frame from the source through
+// camera_node_publish_queued. 0 if it went out.
+static int bench_link_publish(bench_link_t* link) {
+    if (camera_node_capture_frame(&link->camera) <= 0) {
+        return -1;
+    }
+    frame_queue_frame_t* frame = frame_queue_pop(&link->camera.capture_queue);
+    if (!frame) {
+        return -1;
+    }
+    int result = camera_node_publish_queued(&link->camera, frame);
+    frame_queue_release(&link->camera.capture_queue, frame);
+    return result;
+}
+
+// Render step: display_render_take, then the latency of what was shown.
+// Waits on the group up to timeout_ms when nothing is new.
+static int bench_link_render(bench_link_t* link, int timeout_ms) {
+    uint64_t seen = frame_mailbox_group_count(&link->group);
+    display_frame_t* shown[DISPLAY_MAX_STREAMS];
+    int count = display_render_take(&link->render, shown);
+    if (count == 0) {
+        frame_mailbox_group_wait(&link->group, seen, timeout_ms);
+        return 0;
+    }
+    int64_t uploaded_ns = latency_monotonic_ns();
+    if (shown[0]->capture_ns) {
+        latency_histogram_record(&link->histogram, uploaded_ns - shown[0]->capture_ns);
+    }
+    link->received++;
+    return count;
+}
+
+static void* bench_link_intake_thread(void* arg) {
+    bench_link_t* link = (bench_link_t*)arg;
+    while (!__atomic_load_n(&link->stop, __ATOMIC_ACQUIRE)) {
+        if (bench_link_intake(link, BENCH_COMPOSED_TAKE_MS) < 0) {
+            __atomic_store_n(&link->failed, 1, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void* bench_link_render_thread(void* arg) {
+    bench_link_t* link = (bench_link_t*)arg;
+    while (!__atomic_load_n(&link->stop, __ATOMIC_ACQUIRE)) {
+        bench_link_render(link, BENCH_COMPOSED_TAKE_MS);
+    }
+    return NULL;
+}
+
+// Both ends of a dds link see each other
+static int bench_link_match(bench_link_t* link) {
+    const rcl_publisher_t* publisher = link->mode == BENCH_HANDOFF_DDS_IMAGE ?
+        &link->camera.publisher : &link->camera.descriptor_publisher;
+    for (int waited = 0; waited < BENCH_DDS_DISCOVERY_MS; waited += 10) {
+        size_t subscribers = 0, publishers = 0;
+        if (rcl_publisher_get_subscription_count(publisher, &subscribers) == RCL_RET_OK &&
+            rcl_subscription_get_publisher_count(&link->subscription, &publishers) == RCL_RET_OK &&
+            subscribers > 0 && publishers > 0) {
+            return 0;
+        }
+        bench_sleep_us(10000);
+    }
+    fprintf(stderr, "composed: %s never matched\n", link->camera.image_topic);
+    return -1;
+}
+
+// Display side: mailbox frames reserved up front, and for the dds modes
+// the subscription the intake thread takes from
+static int bench_link_open_display(bench_link_t* link, size_t frame_size) {
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    void* buffers[FRAME_MAILBOX_BUFFERS];
+    for (int i = 0; i < FRAME_MAILBOX_BUFFERS; ++i) {
+        display_frame_t* frame = &link->frames[i];
+        if (!sensor_msgs__msg__Image__init(&frame->image) ||
+            image_message_reserve(&frame->image, frame_size, link->camera.output.encoding) != 0 ||
+            rmw_serialized_message_init(&frame->serialized,
+                                        frame_size + BENCH_COMPOSED_DESCRIPTOR_RESERVE,
+                                        &allocator) != RMW_RET_OK) {
+            return -1;
+        }
+        buffers[i] = frame;
+    }
+    if (frame_mailbox_group_init(&link->group) != 0) {
+        return -1;
+    }
+    link->group_ready = true;
+    if (frame_mailbox_init(&link->mailbox, buffers) != 0) {
+        return -1;
+    }
+    frame_mailbox_join(&link->mailbox, &link->group);
+    link->mailbox_ready = true;
+    display_render_init(&link->render, bench_link_upload, link);
+    display_render_add_stream(&link->render, &link->mailbox);
+
+    if (link->mode == BENCH_HANDOFF_POOL) {
+        return camera_node_add_sink(&link->camera, bench_link_post, link);
+    }
+
+    const rosidl_message_type_support_t* type_support =
+        ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image);
+    const char* topic = link->camera.image_topic;
+    if (link->mode == BENCH_HANDOFF_DDS_RING) {
+        if (!link->camera.use_frame_ring ||
+            rmw_serialized_message_init(&link->descriptor_serialized, BENCH_COMPOSED_DESCRIPTOR_RESERVE,
+                                        &allocator) != RMW_RET_OK) {
+            return -1;
+        }
+        link->descriptor = embedded_object_detection_pi5__msg__FrameDescriptor__create();
+        if (!link->descriptor) {
+            return -1;
+        }
+        type_support = ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg, FrameDescriptor);
+        topic = link->camera.descriptor_topic;
+    }
+    link->subscription = rcl_get_zero_initialized_subscription();
+    rcl_subscription_options_t options = rcl_subscription_get_default_options();
+    if (rcl_subscription_init(&link->subscription, link->node, type_support, topic,
+                              &options) != RCL_RET_OK) {
+        fprintf(stderr, "composed: no subscription for %s\n", topic);
+        return -1;
+    }
+    link->subscribed = true;
+    return bench_link_match(link);
+}
+
+// Camera numbers are unique per process and run, so topics and rings
+// never collide with a camera_node on the same host
+static int bench_link_open(bench_link_t* link, bench_handoff_mode_t mode, const bench_resolution_t* res,
+                           rcl_node_t* node, rcl_wait_set_t* wait_set) {
+    static int runs;
+    memset(link, 0, sizeof(*link));
+    link->mode = mode;
+    link->node = node;
+    link->wait_set = wait_set;
+    latency_histogram_reset(&link->histogram);
+
+    camera_config_t config;
+    camera_config_init(&config, "composed", (uint32_t)res->width, (uint32_t)res->height,
+                       BENCH_COMPOSED_FPS, CAMERA_JPEG_QUALITY, CAMERA_COMPRESSED_FPS);
+    config.source = CAMERA_SOURCE_SYNTHETIC;
+    config.realtime = false;
+    int index = (int)(getpid() % 100000) * 100 + runs++ % 100;
+    if (camera_node_init_member(&link->camera, node, &config, index) != 0) {
+        return -1;
+    }
+    link->camera_ready = true;
+
+    link->texture_size = link->camera.output.size;
+    link->texture = malloc(link->texture_size);
+    if (!link->texture || bench_link_open_display(link, link->camera.output.size) != 0) {
+        return -1;
+    }
+    return frame_source_start(&link->camera.source);
+}
+
+// Safe on a partly opened link; the threads have stopped
+static void bench_link_close(bench_link_t* link) {
+    if (link->subscribed) {
+        rcl_subscription_fini(&link->subscription, link->node);
+    }
+    if (link->ring_open) {
+        frame_ring_close(&link->ring);
+    }
+    if (link->descriptor) {
+        embedded_object_detection_pi5__msg__FrameDescriptor__destroy(link->descriptor);
+    }
+    if (link->descriptor_serialized.buffer) {
+        rmw_serialized_message_fini(&link->descriptor_serialized);
+    }
+    if (link->mailbox_ready) {
+        frame_mailbox_fini(&link->mailbox);
+    }
+    if (link->group_ready) {
+        frame_mailbox_group_fini(&link->group);
+    }
+    // Pool frames go back before the camera's pool does
+    for (int i = 0; i < FRAME_MAILBOX_BUFFERS; ++i) {
+        sensor_msgs__msg__Image__fini(&link->frames[i].image);
+        if (link->frames[i].serialized.buffer) {
+            rmw_serialized_message_fini(&link->frames[i].serialized);
+        }
+        if (link->frames[i].pooled) {
+            frame_pool_release(link->frames[i].pooled);
+        }
+    }
+    if (link->camera_ready) {
+        camera_node_fini(&link->camera);
+    }
+    free(link->texture);
+    free(link->rgb);
+}
+
+static int64_t bench_process_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Frames at BENCH_COMPOSED_FPS through one transport
+static int bench_handoff_run(bench_handoff_mode_t mode, const bench_resolution_t* res,
+                             rcl_node_t* node, rcl_wait_set_t* wait_set) {
+    bench_link_t* link = malloc(sizeof(bench_link_t));
+    if (!link) {
+        return -1;
+    }
+    if (bench_link_open(link, mode, res, node, wait_set) != 0) {
+        fprintf(stderr, "composed: cannot set up %s at %s\n", g_handoff_names[mode], res->name);
+        bench_link_close(link);
+        free(link);
+        return -1;
+    }
+
+    pthread_t render, intake;
+    bool intake_started = false;
+    if (pthread_create(&render, NULL, bench_link_render_thread, link) != 0) {
+        bench_link_close(link);
+        free(link);
+        return -1;
+    }
+    if (mode != BENCH_HANDOFF_POOL) {
+        intake_started = pthread_create(&intake, NULL, bench_link_intake_thread, link) == 0;
+        link->failed = !intake_started;
+    }
+
+    int64_t period_ns = 1000000000LL / BENCH_COMPOSED_FPS;
+    int64_t next_ns = latency_monotonic_ns();
+    int64_t cpu_start = bench_process_cpu_ns();
+    uint64_t published = 0;
+    for (int i = 0; i < BENCH_COMPOSED_FRAMES && !__atomic_load_n(&link->failed, __ATOMIC_ACQUIRE); ++i) {
+        next_ns += period_ns;
+        struct timespec until = {
+            .tv_sec = next_ns / 1000000000LL,
+            .tv_nsec = next_ns % 1000000000LL,
+        };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+        published += bench_link_publish(link) == 0;
+    }
+    // The last frame still has to arrive
+    bench_sleep_us(2 * (int)(period_ns / 1000));
+    __atomic_store_n(&link->stop, 1, __ATOMIC_RELEASE);
+    if (intake_started) {
+        pthread_join(intake, NULL);
+    }
+    frame_mailbox_group_close(&link->group);
+    pthread_join(render, NULL);
+    double cpu_us = published ? (bench_process_cpu_ns() - cpu_start) / 1e3 / published : 0.0;
+
+    int result = 0;
+    if (link->failed || link->received == 0 || link->uploads != link->received) {
+        fprintf(stderr, "composed: %s at %s published %llu frames, displayed %llu%s\n",
+                g_handoff_names[mode], res->name, (unsigned long long)published,
+                (unsigned long long)link->received, link->failed ? " before failing" : "");
+        result = -1;
+    } else {
+        double p50 = latency_histogram_percentile(&link->histogram, 50.0) / 1e3;
+        double p99 = latency_histogram_percentile(&link->histogram, 99.0) / 1e3;
+        printf("  %-10s %-10s %9.1f %9.1f %11.1f %9llu %7llu\n", g_handoff_names[mode], res->name,
+               p50, p99, cpu_us, (unsigned long long)link->received, (unsigned long long)link->stale);
+        bench_report("us", p50, "%s/%s/p50", g_handoff_names[mode], res->name);
+        bench_report("us", p99, "%s/%s/p99", g_handoff_names[mode], res->name);
+        bench_report("us", cpu_us, "%s/%s/cpu_per_frame", g_handoff_names[mode], res->name);
+    }
+    bench_link_close(link);
+    free(link);
+    return result;
+}
+
+static int bench_composed(void) {
+    bench_rcl_t rcl;
+    bool have_rcl = bench_rcl_open(&rcl, "benchmarks_composed") == 0;
+    printf("composed (camera_node -> display intake and render, %d frames at %d fps, YUYV)%s\n",
+           BENCH_COMPOSED_FRAMES, BENCH_COMPOSED_FPS, have_rcl ? "" : ", skipped: rcl_init failed");
+    int result = 0;
+    if (have_rcl) {
+        printf("  %-10s %-10s %9s %9s %11s %9s %7s\n", "mode", "frame", "p50 us", "p99 us",
+               "cpu us/frm", "displayed", "stale");
+    }
+    for (size_t r = 1; r < BENCH_FRAME_RESOLUTION_COUNT && have_rcl && result == 0; ++r) {
+        for (int mode = 0; mode < BENCH_HANDOFF_COUNT && result == 0; ++mode) {
+            result = bench_handoff_run((bench_handoff_mode_t)mode, &g_frame_resolutions[r], &rcl.node,
+                                       &rcl.wait_set);
+        }
+    }
+    bench_rcl_close(&rcl);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// steady_state: once warmed up, the per-frame paths of camera_node and
+// display_node must not touch the heap. Each composed transport is set up
+// as a link (bench_link_t, real camera_node and display intake) and every
+// frame runs on this thread through the same functions:
+// camera_node_capture_frame, camera_node_publish_queued (motion gate,
+// pool sink or ring write, rcl_publish), the display intake and
+// display_render_take, whose upload converts to RGB on a worker pool like
+// display_node's CPU fallback. malloc and friends are wrapped (glibc only)
+// and counted on this thread while the measured frames run; worker and
+// middleware threads are not counted.
+//   pool      must not allocate at all
+//   dds_*     rcl_publish, rcl_wait and rcl_take allocate as the
+//             middleware sees fit, so the same rcl calls are counted bare
+//             over as many frames, and the node path may not allocate
+//             more than they do
+// The run stays inside one LATENCY_DIAGNOSTICS_PERIOD_MS, so no
+// diagnostics go out while counting. Without rcl only libjpeg is
+// measured: it allocates per image by design, so MJPEG decode and JPEG
+// encode are counted and reported only.
+// ---------------------------------------------------------------------------
+
+#define BENCH_STEADY_WARMUP 10
+#define BENCH_STEADY_FRAMES 200
+#define BENCH_STEADY_JPEG_FRAMES 20
+
+#ifdef __GLIBC__
+#include <errno.h>
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+
+#define BENCH_ALLOC_COUNTED 1
+
+static __thread int g_alloc_counting;  // Per thread: only the frame thread counts
+static uint64_t g_alloc_count;
+
+static void bench_alloc_note(void) {
+    if (g_alloc_counting) {
+        __atomic_add_fetch(&g_alloc_count, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void* malloc(size_t size) {
+    bench_alloc_note();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    bench_alloc_note();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    bench_alloc_note();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    bench_alloc_note();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    bench_alloc_note();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size) {
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    bench_alloc_note();
+    void* p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *ptr = p;
+    return 0;
+}
+#else
+#define BENCH_ALLOC_COUNTED 0
+static int g_alloc_counting;
+static uint64_t g_alloc_count;
+#endif
+
+static void bench_alloc_start(void) {
+    __atomic_store_n(&g_alloc_count, 0, __ATOMIC_RELAXED);
+    g_alloc_counting = 1;
+}
+
+static uint64_t bench_alloc_stop(void) {
+    g_alloc_counting = 0;
+    return __atomic_load_n(&g_alloc_count, __ATOMIC_RELAXED);
+}
+
+// One frame on this thread: publish, take it in (dds modes), render
+static int bench_steady_frame(bench_link_t* link) {
+    if (bench_link_publish(link) != 0) {
+        return -1;
+    }
+    if (link->mode != BENCH_HANDOFF_POOL && bench_link_intake(link, BENCH_DDS_TIMEOUT_MS) != 1) {
+        return -1;
+    }
+    return bench_link_render(link, 0) == 1 ? 0 : -1;
+}
+
+// The rcl calls of one dds frame, bare: camera_node_publish_frame's
+// subscriber checks and publishes, then the intake's wait and take
+static int bench_steady_middleware(bench_link_t* link, rmw_serialized_message_t* scratch) {
+    camera_node_t* camera = &link->camera;
+    size_t count = 0;
+    if (camera->use_compressed) {
+        rcl_publisher_get_subscription_count(&camera->compressed_publisher, &count);
+    }
+    rcl_publisher_get_subscription_count(&camera->publisher, &count);
+    if (rcl_publish(&camera->descriptor_publisher, camera->descriptor_msg, NULL) != RCL_RET_OK ||
+        (link->mode == BENCH_HANDOFF_DDS_IMAGE &&
+         rcl_publish(&camera->publisher, camera->image_msg, NULL) != RCL_RET_OK)) {
+        return -1;
+    }
+    if (rcl_wait_set_clear(link->wait_set) != RCL_RET_OK ||
+        rcl_wait_set_add_subscription(link->wait_set, &link->subscription, NULL) != RCL_RET_OK ||
+        rcl_wait(link->wait_set, RCL_MS_TO_NS(BENCH_DDS_TIMEOUT_MS)) != RCL_RET_OK) {
+        return -1;
+    }
+    rmw_message_info_t message_info;
+    return rcl_take_serialized_message(&link->subscription, scratch, &message_info, NULL) ==
+           RCL_RET_OK ? 0 : -1;
+}
+
+// Warm up, then count BENCH_STEADY_FRAMES of step; -1 if any frame failed
+static int bench_steady_count(bench_link_t* link, rmw_serialized_message_t* scratch, bool bare,
+                              uint64_t* allocations, double* us) {
+    int failures = 0;
+    for (int i = 0; i < BENCH_STEADY_WARMUP; ++i) {
+        failures += (bare ? bench_steady_middleware(link, scratch) : bench_steady_frame(link)) != 0;
+    }
+    long long start = bench_now_ns();
+    bench_alloc_start();
+    for (int i = 0; i < BENCH_STEADY_FRAMES; ++i) {
+        failures += (bare ? bench_steady_middleware(link, scratch) : bench_steady_frame(link)) != 0;
+    }
+    *allocations = bench_alloc_stop();
+    *us = (bench_now_ns() - start) / 1e3 / BENCH_STEADY_FRAMES;
+    return failures ? -1 : 0;
+}
+
+// The node path, then for the dds modes the bare rcl calls, on an open link
+static int bench_steady_measure(bench_link_t* link, const bench_resolution_t* res,
+                                rmw_serialized_message_t* scratch) {
+    const char* name = g_handoff_names[link->mode];
+    bool dds = link->mode != BENCH_HANDOFF_POOL;
+    uint64_t allocations = 0, middleware = 0;
+    double us = 0.0, bare_us = 0.0;
+    if (bench_steady_count(link, scratch, false, &allocations, &us) != 0 ||
+        (dds && bench_steady_count(link, scratch, true, &middleware, &bare_us) != 0)) {
+        fprintf(stderr, "steady_state: %s at %s: frames failed\n", name, res->name);
+        return -1;
+    }
+
+    char bare[24] = "-";
+    if (dds) {
+        snprintf(bare, sizeof(bare), "%llu", (unsigned long long)middleware);
+        bench_report("count", (double)middleware, "%s/%s/middleware_allocations", name, res->name);
+    }
+    printf("  %-10s %-10s %12llu %12s %10.1f\n", name, res->name, (unsigned long long)allocations, bare, us);
+    bench_report("count", (double)allocations, "%s/%s/allocations", name, res->name);
+    bench_report("us", us, "%s/%s/frame", name, res->name);
+    if (allocations > middleware) {
+        fprintf(stderr, "steady_state: %s at %s: %llu allocations after warm-up, %llu by the middleware alone\n",
+                name, res->name, (unsigned long long)allocations, (unsigned long long)middleware);
+        return -1;
+    }
+    return 0;
+}
+
+// One transport at one resolution
+static int bench_steady_run(bench_handoff_mode_t mode, const bench_resolution_t* res, bench_rcl_t* rcl,
+                            worker_pool_t* workers) {
+    bench_link_t* link = malloc(sizeof(bench_link_t));
+    if (!link) {
+        return -1;
+    }
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    rmw_serialized_message_t scratch = rmw_get_zero_initialized_serialized_message();
+    int result = -1;
+    if (bench_link_open(link, mode, res, &rcl->node, &rcl->wait_set) != 0 ||
+        rmw_serialized_message_init(&scratch, link->camera.output.size + BENCH_COMPOSED_DESCRIPTOR_RESERVE,
+                                    &allocator) != RMW_RET_OK ||
+        !(link->rgb = malloc((size_t)res->width * res->height * 3))) {
+        fprintf(stderr, "steady_state: cannot set up %s at %s\n", g_handoff_names[mode], res->name);
+    } else {
+        link->convert = workers;
+        result = bench_steady_measure(link, res, &scratch);
+    }
+    if (scratch.buffer) {
+        rmw_serialized_message_fini(&scratch);
+    }
+    bench_link_close(link);
+    free(link);
+    return result;
+}
+
+// Allocations per frame of libjpeg's decode and encode
+static int bench_steady_jpeg(const bench_resolution_t* res, double* decode, double* encode) {
+    size_t jpeg_size = 0;
+    uint8_t* jpeg = bench_make_jpeg(res->width, res->height, &jpeg_size);
+    size_t size = (size_t)res->width * res->height * 2;
+    uint8_t* yuyv = malloc(size);
+    mjpeg_decoder_t decoder;
+    jpeg_encoder_t encoder;
+    if (!jpeg || !yuyv || mjpeg_decoder_init(&decoder, MJPEG_OUTPUT_YUYV, 1) != 0) {
+        free(jpeg);
+        free(yuyv);
+        return -1;
+    }
+    if (jpeg_encoder_init(&encoder, 80) != 0) {
+        mjpeg_decoder_fini(&decoder);
+        free(jpeg);
+        free(yuyv);
+        return -1;
+    }
+    
+    bench_mjpeg_ctx_t decode_ctx = { &decoder, jpeg, jpeg_size, yuyv, size, 0 };
+    bench_jpeg_ctx_t encode_ctx = { &encoder, yuyv, "yuv422_yuy2", res->width, res->height,
+                                    res->width * 2, 0, 0 };
+    bench_mjpeg_decode_one(&decode_ctx);
+    bench_jpeg_encode_one(&encode_ctx);
+    bench_alloc_start();
+    for (int i = 0; i < BENCH_STEADY_JPEG_FRAMES; ++i) {
+        bench_mjpeg_decode_one(&decode_ctx);
+    }
+    *decode = (double)bench_alloc_stop() / BENCH_STEADY_JPEG_FRAMES;
+    bench_alloc_start();
+    for (int i = 0; i < BENCH_STEADY_JPEG_FRAMES; ++i) {
+        bench_jpeg_encode_one(&encode_ctx);
+    }
+    *encode = (double)bench_alloc_stop() / BENCH_STEADY_JPEG_FRAMES;
+    
+    jpeg_encoder_fini(&encoder);
+    mjpeg_decoder_fini(&decoder);
+    free(jpeg);
+    free(yuyv);
+    return decode_ctx.failures || encode_ctx.failures ? -1 : 0;
+}
+
+static int bench_steady_state(void) {
+    bench_rcl_t rcl;
+    bool have_rcl = bench_rcl_open(&rcl, "benchmarks_steady") == 0;
+    printf("steady_state (heap allocations on the frame thread after %d warm-up frames, %d frames)%s%s\n",
+           BENCH_STEADY_WARMUP, BENCH_STEADY_FRAMES, BENCH_ALLOC_COUNTED ? "" : ", not counted: needs glibc",
+           have_rcl ? "" : ", nodes skipped: rcl_init failed");
+
+    int result = 0;
+    worker_pool_t workers;
+    if (have_rcl) {
+        if (worker_pool_init(&workers, 0, false) != 0) {
+            bench_rcl_close(&rcl);
+            return -1;
+        }
+        printf("  %-10s %-10s %12s %12s %10s\n", "mode", "frame", "allocations", "middleware", "us/frame");
+        for (size_t r = 1; r < BENCH_FRAME_RESOLUTION_COUNT && result == 0; ++r) {
+            for (int mode = 0; mode < BENCH_HANDOFF_COUNT && result == 0; ++mode) {
+                result = bench_steady_run((bench_handoff_mode_t)mode, &g_frame_resolutions[r], &rcl,
+                                          &workers);
+            }
+        }
+        worker_pool_fini(&workers);
+    }
+    bench_rcl_close(&rcl);
+
+    printf("  %-10s %12s %12s   (libjpeg, reported only)\n", "frame", "mjpeg/frame", "jpeg/frame");
+    for (size_t r = 1; r < BENCH_FRAME_RESOLUTION_COUNT; ++r) {
+        const bench_resolution_t* res = &g_frame_resolutions[r];
+        double decode = 0.0, encode = 0.0;
+        if (bench_steady_jpeg(res, &decode, &encode) != 0) {
+            result = -1;
+            continue;
+        }
+        printf("  %-10s %12.1f %12.1f\n", res->name, decode, encode);
+        bench_report("count", decode, "%s/mjpeg_decode_allocations", res->name);
+        bench_report("count", encode, "%s/jpeg_encode_allocations", res->name);
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// multi_camera: a multi-camera camera_node without ROS. BENCH_MULTI_CAMERAS
+// realtime 720p test patterns are captured on one thread with one epoll
+// into their own queues, each drained by its own thread, and grouped into
+// sets.
+// ---------------------------------------------------------------------------
+
+#define BENCH_MULTI_CAMERAS 4
+#define BENCH_MULTI_WIDTH 1280
+#define BENCH_MULTI_HEIGHT 720
+#define BENCH_MULTI_FPS 30
+#define BENCH_MULTI_MS 3000
+#define BENCH_MULTI_QUEUE_DEPTH 3
+
+// One camera: its source and queue, drained by its own thread the way a
+// publish thread would, copying every frame once
+typedef struct {
+    int index;
+    frame_source_t source;
+    bool source_ready;
+    frame_queue_t queue;
+    bool queue_ready;
+    uint8_t* dst;
+    pthread_t thread;
+    int stop_fd;                // Shared eventfd, never read
+    uint64_t captured;          // Capture thread
+    uint64_t published;         // Its own thread, read after join
+    frame_sync_t* sync;
+    pthread_mutex_t* sync_lock;
+} bench_multi_camera_t;
+
+static void* bench_multi_publish(void* arg) {
+    bench_multi_camera_t* camera = (bench_multi_camera_t*)arg;
+    struct pollfd pfds[2] = {
+        { .fd = frame_queue_event_fd(&camera->queue), .events = POLLIN },
+        { .fd = camera->stop_fd, .events = POLLIN },
+    };
+    for (;;) {
+        poll(pfds, 2, 1000);
+        frame_queue_clear_event(&camera->queue);
+        frame_queue_frame_t* frame;
+        while ((frame = frame_queue_pop(&camera->queue)) != NULL) {
+            memcpy(camera->dst, frame->data, frame->size);
+            frame_sync_set_t set;
+            pthread_mutex_lock(camera->sync_lock);
+            frame_sync_add(camera->sync, camera->index, frame->sequence, frame->stamp_ns, &set);
+            pthread_mutex_unlock(camera->sync_lock);
+            frame_queue_release(&camera->queue, frame);
+            camera->published++;
+        }
+        if (pfds[1].revents & POLLIN) {
+            return NULL;
+        }
+    }
+}
+
+static void bench_multi_close(bench_multi_camera_t* cameras, int count) {
+    for (int i = 0; i < count; ++i) {
+        if (cameras[i].queue_ready) {
+            frame_queue_fini(&cameras[i].queue);
+        }
+        if (cameras[i].source_ready) {
+            frame_source_close(&cameras[i].source);
+        }
+        free(cameras[i].dst);
+    }
+}
+
+static int bench_multi_capture(void) {
+    bench_multi_camera_t cameras[BENCH_MULTI_CAMERAS];
+    memset(cameras, 0, sizeof(cameras));
+    frame_sync_t sync;
+    pthread_mutex_t sync_lock = PTHREAD_MUTEX_INITIALIZER;
+    if (frame_sync_init(&sync, BENCH_MULTI_CAMERAS, 1000000000LL / BENCH_MULTI_FPS / 2) != 0) {
+        return -1;
+    }
+    int stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    int result = stop_fd != -1 && epoll_fd != -1 ? 0 : -1;
+
+    int opened = 0;
+    for (int i = 0; i < BENCH_MULTI_CAMERAS && result == 0; ++i, ++opened) {
+        bench_multi_camera_t* camera = &cameras[i];
+        camera_config_t config;
+        camera_config_init(&config, "", BENCH_MULTI_WIDTH, BENCH_MULTI_HEIGHT, BENCH_MULTI_FPS, 80, 15);
+        config.source = CAMERA_SOURCE_SYNTHETIC;
+        camera->index = i;
+        camera->stop_fd = stop_fd;
+        camera->sync = &sync;
+        camera->sync_lock = &sync_lock;
+        if (frame_source_open(&camera->source, &config) != 0) {
+            result = -1;
+            break;
+        }
+        camera->source_ready = true;
+        camera->dst = malloc(camera->source.mode.sizeimage);
+        if (!camera->dst || frame_queue_init(&camera->queue, BENCH_MULTI_QUEUE_DEPTH,
+                                             camera->source.mode.sizeimage, FRAME_QUEUE_DROP_OLDEST) != 0) {
+            result = -1;
+            break;
+        }
+        camera->queue_ready = true;
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = camera };
+        if (camera->source.fd == -1 || epoll_ctl(epoll_fd, EPOLL_CTL_ADD, camera->source.fd, &ev) != 0) {
+            result = -1;
+        }
+    }
+
+    int started = 0;
+    for (int i = 0; i < BENCH_MULTI_CAMERAS && result == 0; ++i) {
+        if (frame_source_start(&cameras[i].source) != 0 ||
+            pthread_create(&cameras[i].thread, NULL, bench_multi_publish, &cameras[i]) != 0) {
+            result = -1;
+            break;
+        }
+        started++;
+    }
+
+    // camera_rig's capture loop: one epoll over every source, frames only
+    // moved into the queues
+    struct epoll_event events[BENCH_MULTI_CAMERAS];
+    long long start = bench_now_ns();
+    while (result == 0 && bench_now_ns() - start < BENCH_MULTI_MS * 1000000LL) {
+        int n = epoll_wait(epoll_fd, events, BENCH_MULTI_CAMERAS, 100);
+        for (int i = 0; i < n && result == 0; ++i) {
+            bench_multi_camera_t* camera = (bench_multi_camera_t*)events[i].data.ptr;
+            frame_source_frame_t captured;
+            int got;
+            while ((got = frame_source_next(&camera->source, &captured)) == 1) {
+                frame_queue_frame_t* frame = frame_queue_begin_push(&camera->queue);
+                if (frame) {
+                    frame->data = captured.data;
+                    frame->size = captured.size;
+                    frame->sequence = captured.sequence;
+                    frame->stamp_ns = captured.stamp_ns;
+                }
+                frame_source_release(&camera->source, &captured);
+                if (!captured.borrowed || (frame && frame_queue_push(&camera->queue) < 0)) {
+                    result = -1;
+                    break;
+                }
+                camera->captured++;
+            }
+            if (got < 0) {
+                result = -1;
+            }
+        }
+    }
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    uint64_t one = 1;
+    if (stop_fd != -1 && write(stop_fd, &one, sizeof(one)) != sizeof(one)) {
+        result = -1;
+    }
+    for (int i = 0; i < started; ++i) {
+        pthread_join(cameras[i].thread, NULL);
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < started; ++i) {
+        bench_multi_camera_t* camera = &cameras[i];
+        frame_queue_stats_t stats;
+        frame_queue_get_stats(&camera->queue, &stats);
+        double fps = camera->published / seconds;
+        total += fps;
+        printf("  camera%d %dx%d: %6.1f fps captured, %6.1f fps published, %llu source drops, "
+               "%llu queue drops\n", i, BENCH_MULTI_WIDTH, BENCH_MULTI_HEIGHT, camera->captured / seconds,
+               fps, (unsigned long long)camera->source.drops,
+               (unsigned long long)(stats.dropped_oldest + stats.dropped_newest));
+        bench_report("fps", fps, "camera%d/published", i);
+        if (fps < BENCH_MULTI_FPS * 0.9) {
+            fprintf(stderr, "multi_camera: camera%d published %.1f fps of %d\n", i, fps, BENCH_MULTI_FPS);
+            result = -1;
+        }
+    }
+    if (started == BENCH_MULTI_CAMERAS) {
+        printf("  %d cameras: %.1f fps in total, %llu sets from %llu frames, widest spread %.2f ms\n",
+               BENCH_MULTI_CAMERAS, total, (unsigned long long)sync.sets,
+               (unsigned long long)sync.frames, sync.max_spread_ns / 1e6);
+        bench_report("fps", total, "total");
+        bench_report("count", (double)sync.sets, "sets");
+        bench_report("ms", sync.max_spread_ns / 1e6, "max_spread");
+    }
+
+    bench_multi_close(cameras, opened);
+    if (epoll_fd != -1) {
+        close(epoll_fd);
+    }
+    if (stop_fd != -1) {
+        close(stop_fd);
+    }
+    return result;
+}
+
+static int bench_multi_camera(void) {
+    printf("multi_camera (%d realtime %dx%d sources, one capture thread, %d ms)\n",
+           BENCH_MULTI_CAMERAS, BENCH_MULTI_WIDTH, BENCH_MULTI_HEIGHT, BENCH_MULTI_MS);
+    return bench_multi_capture();
+}
+
+// ---------------------------------------------------------------------------
+// mosaic: display_node's render loop over several streams, without SDL.
+// BENCH_MOSAIC_STREAMS producers copy 640x480 YUYV frames at 30 fps into
+// their own mailboxes, joined to one group, the way the intake thread does.
+// A band moves down each picture, so only its rows are dirty. The reader
+// paces itself to a 60 Hz refresh and runs display_render_take, which
+// uploads into the tiles of one mosaic buffer instead of textures, then
+// "presents" once.
+// ---------------------------------------------------------------------------
+
+#define BENCH_MOSAIC_STREAMS 4
+#define BENCH_MOSAIC_WIDTH 640
+#define BENCH_MOSAIC_HEIGHT 480
+#define BENCH_MOSAIC_FPS 30
+#define BENCH_MOSAIC_REFRESH_HZ 60
+#define BENCH_MOSAIC_MS 3000
+#define BENCH_MOSAIC_BAND 48        // Rows of the moving band
+#define BENCH_MOSAIC_BAND_STEP 8    // Rows it moves per frame
+#define BENCH_MOSAIC_COLS 2
+#define BENCH_MOSAIC_MAX_SAMPLES (BENCH_MOSAIC_STREAMS * BENCH_MOSAIC_FPS * BENCH_MOSAIC_MS / 1000 * 2)
+
+typedef struct {
+    int index;
+    frame_mailbox_t mailbox;
+    bool mailbox_ready;
+    display_frame_t frames[FRAME_MAILBOX_BUFFERS];
+    uint8_t* source;            // The camera's picture, copied in like a ring slot
+    uint64_t intake_index;
+    pthread_t thread;
+    volatile int* stop;
+} bench_mosaic_stream_t;
+
+// The "window": every stream's tile in one YUYV buffer
+typedef struct {
+    uint8_t* data;
+    size_t step;
+} bench_mosaic_screen_t;
+
+static void bench_sleep_until_ns(long long deadline_ns) {
+    struct timespec until = {
+        .tv_sec = deadline_ns / 1000000000LL,
+        .tv_nsec = deadline_ns % 1000000000LL,
+    };
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+}
+
+// A camera: fixed rate, phase shifted per stream so arrivals interleave.
+// Each frame is the background with the band one step further down.
+static void* bench_mosaic_produce(void* arg) {
+    bench_mosaic_stream_t* stream = (bench_mosaic_stream_t*)arg;
+    const long long interval = 1000000000LL / BENCH_MOSAIC_FPS;
+    const size_t step = (size_t)BENCH_MOSAIC_WIDTH * 2;
+    const int positions = BENCH_MOSAIC_HEIGHT - BENCH_MOSAIC_BAND;
+    long long next = bench_now_ns() + stream->index * interval / BENCH_MOSAIC_STREAMS;
+    int band_y = 0;
+    memset(stream->source, 16, step * BENCH_MOSAIC_HEIGHT);
+    while (!__atomic_load_n(stream->stop, __ATOMIC_RELAXED)) {
+        bench_sleep_until_ns(next);
+        next += interval;
+
+        int previous_y = band_y;
+        band_y = (int)((stream->intake_index * BENCH_MOSAIC_BAND_STEP) % (uint64_t)positions);
+        memset(stream->source + previous_y * step, 16, BENCH_MOSAIC_BAND * step);
+        memset(stream->source + band_y * step, 200, BENCH_MOSAIC_BAND * step);
+
+        display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&stream->mailbox);
+        if (image_message_fill(&frame->image, stream->source, step * BENCH_MOSAIC_HEIGHT,
+                               BENCH_MOSAIC_WIDTH, BENCH_MOSAIC_HEIGHT, (uint32_t)step,
+                               BENCH_MESSAGE_ENCODING) != 0) {
+            continue;
+        }
+        frame->use_view = false;
+        frame->index = ++stream->intake_index;
+        frame->dirty_y = band_y;
+        frame->dirty_height = BENCH_MOSAIC_BAND;
+        if (frame->index == 1) {
+            frame->dirty_y = 0;
+            frame->dirty_height = BENCH_MOSAIC_HEIGHT;
+        } else {
+            motion_gate_union_rows(&frame->dirty_y, &frame->dirty_height, previous_y,
+                                   BENCH_MOSAIC_BAND);
+        }
+        frame->receive_ns = bench_now_ns();
+        frame->capture_ns = frame->receive_ns;
+        frame_mailbox_publish(&stream->mailbox);
+    }
+    return NULL;
+}
+
+// display_render_upload_t: rows into the stream's tile, the texture upload
+static int bench_mosaic_upload(void* ctx, int stream, const sensor_msgs__msg__Image* image,
+                               bool partial, int dirty_y, int dirty_height) {
+    bench_mosaic_screen_t* screen = (bench_mosaic_screen_t*)ctx;
+    if (image->height != BENCH_MOSAIC_HEIGHT || image->step != BENCH_MOSAIC_WIDTH * 2) {
+        return -1;
+    }
+    if (!partial || dirty_y < 0 || dirty_height < 0 || dirty_y + dirty_height > BENCH_MOSAIC_HEIGHT) {
+        dirty_y = 0;
+        dirty_height = BENCH_MOSAIC_HEIGHT;
+    }
+    uint8_t* tile = screen->data +
+                    (size_t)(stream / BENCH_MOSAIC_COLS) * BENCH_MOSAIC_HEIGHT * screen->step +
+                    (size_t)(stream % BENCH_MOSAIC_COLS) * image->step;
+    for (int y = dirty_y; y < dirty_y + dirty_height; ++y) {
+        memcpy(tile + y * screen->step, image->data.data + (size_t)y * image->step, image->step);
+    }
+    return 0;
+}
+
+static int bench_mosaic(void) {
+    const size_t frame_size = (size_t)BENCH_MOSAIC_WIDTH * BENCH_MOSAIC_HEIGHT * 2;
+    const int rows = (BENCH_MOSAIC_STREAMS + BENCH_MOSAIC_COLS - 1) / BENCH_MOSAIC_COLS;
+    const long long refresh_ns = 1000000000LL / BENCH_MOSAIC_REFRESH_HZ;
+
+    printf("mosaic (%d streams of %dx%d YUYV at %d fps, one reader at %d Hz, %d ms)\n",
+           BENCH_MOSAIC_STREAMS, BENCH_MOSAIC_WIDTH, BENCH_MOSAIC_HEIGHT, BENCH_MOSAIC_FPS,
+           BENCH_MOSAIC_REFRESH_HZ, BENCH_MOSAIC_MS);
+
+    bench_mosaic_stream_t streams[BENCH_MOSAIC_STREAMS];
+    memset(streams, 0, sizeof(streams));
+    bench_mosaic_screen_t screen;
+    screen.step = (size_t)BENCH_MOSAIC_WIDTH * 2 * BENCH_MOSAIC_COLS;
+    screen.data = malloc(screen.step * BENCH_MOSAIC_HEIGHT * rows);
+    frame_mailbox_group_t group;
+    volatile int stop = 0;
+    long long* latency = malloc(BENCH_MOSAIC_MAX_SAMPLES * sizeof(*latency));
+    if (!latency || !screen.data || frame_mailbox_group_init(&group) != 0) {
+        free(latency);
+        free(screen.data);
+        return -1;
+    }
+
+    display_render_t render;
+    display_render_init(&render, bench_mosaic_upload, &screen);
+
+    // Frame buffers reserved up front, as display_node_init_stream does
+    int result = 0;
+    for (int i = 0; i < BENCH_MOSAIC_STREAMS && result == 0; ++i) {
+        bench_mosaic_stream_t* stream = &streams[i];
+        void* buffers[FRAME_MAILBOX_BUFFERS];
+        stream->index = i;
+        stream->stop = &stop;
+        stream->source = malloc(frame_size);
+        if (!stream->source) {
+            result = -1;
+        }
+        for (int b = 0; b < FRAME_MAILBOX_BUFFERS; ++b) {
+            display_frame_t* frame = &stream->frames[b];
+            buffers[b] = frame;
+            if (!sensor_msgs__msg__Image__init(&frame->image) ||
+                image_message_reserve(&frame->image, frame_size, BENCH_MESSAGE_ENCODING) != 0) {
+                result = -1;
+            }
+        }
+        if (result == 0 && frame_mailbox_init(&stream->mailbox, buffers) == 0) {
+            frame_mailbox_join(&stream->mailbox, &group);
+            stream->mailbox_ready = true;
+            display_render_add_stream(&render, &stream->mailbox);
+        } else {
+            result = -1;
+        }
+    }
+
+    int started = 0;
+    for (int i = 0; i < BENCH_MOSAIC_STREAMS && result == 0; ++i, ++started) {
+        if (pthread_create(&streams[i].thread, NULL, bench_mosaic_produce, &streams[i]) != 0) {
+            result = -1;
+        }
+    }
+
+    // display_node_spin: wait out the refresh, take and upload every stream
+    // with a frame, present once; sleep on the group when idle
+    int samples = 0;
+    uint64_t presents = 0;
+    uint64_t idle_wakeups = 0;
+    long long next_present = 0;
+    long long start = bench_now_ns();
+    while (result == 0 && bench_now_ns() - start < BENCH_MOSAIC_MS * 1000000LL) {
+        if (next_present > bench_now_ns()) {
+            bench_sleep_until_ns(next_present);
+        }
+        uint64_t seen = frame_mailbox_group_count(&group);
+        display_frame_t* shown[DISPLAY_MAX_STREAMS];
+        int shown_count = display_render_take(&render, shown);
+        if (shown_count == 0) {
+            if (!frame_mailbox_group_wait(&group, seen, 10)) {
+                idle_wakeups++;
+            }
+            continue;
+        }
+        long long presented = bench_now_ns();
+        next_present = presented + refresh_ns;
+        presents++;
+        for (int i = 0; i < shown_count && samples < BENCH_MOSAIC_MAX_SAMPLES; ++i) {
+            latency[samples++] = presented - shown[i]->receive_ns;
+        }
+    }
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < started; ++i) {
+        pthread_join(streams[i].thread, NULL);
+    }
+
+    if (result == 0) {
+        for (int i = 0; i < BENCH_MOSAIC_STREAMS; ++i) {
+            const display_render_stream_t* shown = &render.streams[i];
+            uint64_t published, taken, overwritten;
+            frame_mailbox_get_counts(&streams[i].mailbox, &published, &taken, &overwritten);
+            double fps = shown->frames_displayed / seconds;
+            printf("  stream%d: %6.1f fps shown, %llu of %llu frames overwritten, "
+                   "%llu partial uploads\n", i, fps, (unsigned long long)overwritten,
+                   (unsigned long long)published, (unsigned long long)shown->partial_uploads);
+            bench_report("fps", fps, "stream%d/shown", i);
+            if (fps < BENCH_MOSAIC_FPS * 0.9) {
+                fprintf(stderr, "mosaic: stream%d shown at %.1f fps of %d\n", i, fps, BENCH_MOSAIC_FPS);
+                result = -1;
+            }
+        }
+        qsort(latency, (size_t)samples, sizeof(latency[0]), bench_compare_ll);
+        double p50_ms = samples ? latency[samples / 2] / 1e6 : 0.0;
+        double p99_ms = samples ? latency[samples * 99 / 100] / 1e6 : 0.0;
+        printf("  %.1f presents/s, %.2f frames per present, publish-to-present p50 %.2f ms, "
+               "p99 %.2f ms, %llu idle wakeups\n", presents / seconds,
+               presents ? (double)samples / presents : 0.0, p50_ms, p99_ms,
+               (unsigned long long)idle_wakeups);
+        bench_report("count", presents / seconds, "presents_per_s");
+        bench_report("ms", p50_ms, "latency/p50");
+        bench_report("ms", p99_ms, "latency/p99");
+        if (samples == 0 || p99_ms > 2.0 * refresh_ns / 1e6) {
+            fprintf(stderr, "mosaic: p99 publish-to-present %.2f ms exceeds two refreshes\n", p99_ms);
+            result = -1;
+        }
+    }
+
+    for (int i = 0; i < BENCH_MOSAIC_STREAMS; ++i) {
+        if (streams[i].mailbox_ready) {
+            frame_mailbox_fini(&streams[i].mailbox);
+        }
+        for (int b = 0; b < FRAME_MAILBOX_BUFFERS; ++b) {
+            sensor_msgs__msg__Image__fini(&streams[i].frames[b].image);
+        }
+        free(streams[i].source);
+    }
+    frame_mailbox_group_fini(&group);
+    free(latency);
+    free(screen.data);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char* name;
+    int (*run)(void);
+} bench_case_t;
+
+static const bench_case_t g_cases[] = {
+    { "convert", bench_convert },
+    { "convert_scaling", bench_convert_scaling },
+    { "mjpeg_decode", bench_mjpeg_decode },
+    { "jpeg_encode", bench_jpeg_encode },
+    { "preprocess", bench_preprocess },
+    { "postprocess", bench_postprocess },
+    { "stage_pipeline", bench_stage_pipeline },
+    { "motion_gate", bench_motion_gate },
+    { "tracker", bench_tracker },
+    { "latency_trace", bench_latency_trace },
+    { "message_prep", bench_message_prep },
+    { "frame_source", bench_frame_source },
+    { "record", bench_record },
+    { "dds_roundtrip", bench_dds_roundtrip },
+    { "composed", bench_composed },
+    { "steady_state", bench_steady_state },
+    { "multi_camera", bench_multi_camera },
+    { "mosaic", bench_mosaic },
+};
+
+#define BENCH_CASE_COUNT (sizeof(g_cases) / sizeof(g_cases[0]))
+
+static void bench_json_string(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text ? text : ""; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(file, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(file, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Host, per-case status (null = not run) and every reported value
+static int bench_write_json(const char* path, const int* status) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    struct utsname host;
+    if (uname(&host) != 0) {
+        memset(&host, 0, sizeof(host));
+    }
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(file, "{\n  \"schema\": 1,\n  \"label\": ");
+    bench_json_string(file, getenv("BENCH_LABEL"));
+    fprintf(file, ",\n  \"time\": \"%s\",\n  \"host\": {\"machine\": ", stamp);
+    bench_json_string(file, host.machine);
+    fprintf(file, ", \"kernel\": ");
+    bench_json_string(file, host.release);
+    fprintf(file, ", \"cpus\": %ld, \"isa\": ", sysconf(_SC_NPROCESSORS_ONLN));
+    bench_json_string(file, color_convert_isa_name(color_convert_active_isa()));
+    fprintf(file, ", \"l2_kib\": %zu},\n  \"cases\": {", worker_pool_l2_cache_size() / 1024);
+    for (size_t i = 0; i < BENCH_CASE_COUNT; ++i) {
+        fprintf(file, "%s\n    \"%s\": %s", i ? "," : "", g_cases[i].name,
+                status[i] < 0 ? "null" : status[i] ? "\"failed\"" : "\"ok\"");
+    }
+    fprintf(file, "\n  },\n  \"results\": [");
+    for (int i = 0; i < g_result_count; ++i) {
+        const bench_result_t* result = &g_results[i];
+        fprintf(file, "%s\n    {\"bench\": \"%s\", \"name\": ", i ? "," : "", result->bench);
+        bench_json_string(file, result->name);
+        if (isfinite(result->value)) {
+            fprintf(file, ", \"value\": %.6g", result->value);
+        } else {
+            fprintf(file, ", \"value\": null");
+        }
+        fprintf(file, ", \"unit\": \"%s\"}", result->unit);
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    if (fclose(file) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* filter = NULL;
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+    int result = 0;
+    int status[BENCH_CASE_COUNT];
+
+    for (size_t i = 0; i < BENCH_CASE_COUNT; ++i) {
+        status[i] = -1;
+        if (filter && !strstr(g_cases[i].name, filter)) {
+            continue;
+        }
+        g_bench_name = g_cases[i].name;
+        status[i] = g_cases[i].run() != 0;
+        if (status[i]) {
+            fprintf(stderr, "%s failed\n", g_cases[i].name);
+            result = 1;
+        }
+    }
+
+    if (g_result_count == BENCH_MAX_RESULTS) {
+        fprintf(stderr, "More than %d results, the rest were not recorded\n", BENCH_MAX_RESULTS);
+    }
+    if (json_path && bench_write_json(json_path, status) != 0) {
+        result = 1;
+    }
+    return result;
+}
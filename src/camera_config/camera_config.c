@@ -0,0 +1,358 @@
+#include "camera_config/camera_config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <linux/videodev2.h>
+#include <rcl/arguments.h>
+#include <rcl_yaml_param_parser/parser.h>
+#include <rcutils/logging_macros.h>
+
+static const camera_format_t g_camera_formats[] = {
+    { V4L2_PIX_FMT_YUYV,   "yuyv",  "yuv422_yuy2" },
+    { V4L2_PIX_FMT_UYVY,   "uyvy",  "uyvy" },
+    { V4L2_PIX_FMT_NV12,   "nv12",  "nv12" },
+    { V4L2_PIX_FMT_YUV420, "i420",  "i420" },
+    { V4L2_PIX_FMT_RGB24,  "rgb24", "rgb8" },
+    { V4L2_PIX_FMT_BGR24,  "bgr24", "bgr8" },
+    { V4L2_PIX_FMT_GREY,   "grey",  "mono8" },
+    { V4L2_PIX_FMT_MJPEG,  "mjpeg", NULL },
+};
+#define CAMERA_FORMAT_COUNT (sizeof(g_camera_formats) / sizeof(g_camera_formats[0]))
+
+static const char* const g_camera_sources[] = { "v4l2", "file", "synthetic" };
+#define CAMERA_SOURCE_COUNT (sizeof(g_camera_sources) / sizeof(g_camera_sources[0]))
+
+const camera_format_t* camera_format_find(uint32_t fourcc) {
+    for (size_t i = 0; i < CAMERA_FORMAT_COUNT; ++i) {
+        if (g_camera_formats[i].fourcc == fourcc) {
+            return &g_camera_formats[i];
+        }
+    }
+    return NULL;
+}
+
+const camera_format_t* camera_format_find_by_name(const char* name) {
+    for (size_t i = 0; i < CAMERA_FORMAT_COUNT; ++i) {
+        if (strcasecmp(g_camera_formats[i].name, name) == 0) {
+            return &g_camera_formats[i];
+        }
+    }
+    return NULL;
+}
+
+const char* camera_fourcc_str(uint32_t fourcc, char* buf) {
+    for (int i = 0; i < 4; ++i) {
+        char c = (char)((fourcc >> (8 * i)) & 0xff);
+        buf[i] = (c >= 32 && c < 127) ? c : '?';
+    }
+    buf[4] = '\0';
+    return buf;
+}
+
+const char* camera_source_name(camera_source_t source) {
+    return (size_t)source < CAMERA_SOURCE_COUNT ? g_camera_sources[source] : "unknown";
+}
+
+void camera_config_init(camera_config_t* config, const char* device,
+                        uint32_t width, uint32_t height, uint32_t fps,
+                        uint32_t jpeg_quality, uint32_t compressed_fps) {
+    memset(config, 0, sizeof(*config));
+    config->source = CAMERA_SOURCE_V4L2;
+    snprintf(config->device, sizeof(config->device), "%s", device);
+    config->realtime = true;
+    config->max_frames = 0;
+    config->width = width;
+    config->height = height;
+    config->fps = fps;
+    config->pixel_format = 0;
+    config->jpeg_quality = jpeg_quality;
+    config->compressed_fps = compressed_fps;
+}
+
+static int camera_config_set_format(camera_config_t* config, const char* name) {
+    if (strcasecmp(name, "auto") == 0) {
+        config->pixel_format = 0;
+        return 0;
+    }
+    const camera_format_t* format = camera_format_find_by_name(name);
+    if (!format) {
+        RCUTILS_LOG_ERROR("Unknown pixel format '%s'", name);
+        return -1;
+    }
+    config->pixel_format = format->fourcc;
+    return 0;
+}
+
+static int camera_config_set_source(camera_config_t* config, const char* name) {
+    for (size_t i = 0; i < CAMERA_SOURCE_COUNT; ++i) {
+        if (strcasecmp(g_camera_sources[i], name) == 0) {
+            config->source = (camera_source_t)i;
+            return 0;
+        }
+    }
+    RCUTILS_LOG_ERROR("Unknown frame source '%s' (v4l2, file or synthetic)", name);
+    return -1;
+}
+
+static int camera_config_set_replay(camera_config_t* config, const char* name) {
+    if (strcasecmp(name, "realtime") == 0) {
+        config->realtime = true;
+    } else if (strcasecmp(name, "fast") == 0) {
+        config->realtime = false;
+    } else {
+        RCUTILS_LOG_ERROR("Unknown replay mode '%s' (realtime or fast)", name);
+        return -1;
+    }
+    return 0;
+}
+
+// Like camera_config_set_uint, but 0 (unlimited) is allowed
+static int camera_config_set_count(uint32_t* value, const char* name, long long parsed) {
+    if (parsed < 0 || parsed > UINT32_MAX) {
+        RCUTILS_LOG_ERROR("Invalid %s: %lld", name, parsed);
+        return -1;
+    }
+    *value = (uint32_t)parsed;
+    return 0;
+}
+
+static int camera_config_set_uint(uint32_t* value, const char* name, long long parsed, long long max) {
+    if (parsed <= 0 || parsed > max) {
+        RCUTILS_LOG_ERROR("Invalid %s: %lld", name, parsed);
+        return -1;
+    }
+    *value = (uint32_t)parsed;
+    return 0;
+}
+
+// Apply one set of parameters; missing ones are left alone
+static int camera_config_apply_params(camera_config_t* config, rcl_params_t* params,
+                                      const char* node_name) {
+    const char* int_names[] = { "width", "height", "fps", "jpeg_quality", "compressed_fps" };
+    uint32_t* int_values[] = { &config->width, &config->height, &config->fps,
+                               &config->jpeg_quality, &config->compressed_fps };
+    const long long int_max[] = { 100000, 100000, 100000, 100, 100000 };
+    int result = 0;
+
+    for (size_t i = 0; i < sizeof(int_names) / sizeof(int_names[0]); ++i) {
+        rcl_variant_t* value = rcl_yaml_node_struct_get(node_name, int_names[i], params);
+        if (!value) {
+            continue;
+        }
+        if (!value->integer_value) {
+            RCUTILS_LOG_ERROR("Parameter %s must be an integer", int_names[i]);
+            result = -1;
+            continue;
+        }
+        if (camera_config_set_uint(int_values[i], int_names[i], (long long)*value->integer_value,
+                                   int_max[i]) != 0) {
+            result = -1;
+        }
+    }
+
+    rcl_variant_t* frames = rcl_yaml_node_struct_get(node_name, "frames", params);
+    if (frames && !frames->integer_value) {
+        RCUTILS_LOG_ERROR("Parameter frames must be an integer");
+        result = -1;
+    } else if (frames &&
+               camera_config_set_count(&config->max_frames, "frames", (long long)*frames->integer_value) != 0) {
+        result = -1;
+    }
+
+    rcl_variant_t* sync_ms = rcl_yaml_node_struct_get(node_name, "sync_ms", params);
+    if (sync_ms && !sync_ms->integer_value) {
+        RCUTILS_LOG_ERROR("Parameter sync_ms must be an integer");
+        result = -1;
+    } else if (sync_ms &&
+               camera_config_set_count(&config->sync_ms, "sync_ms", (long long)*sync_ms->integer_value) != 0) {
+        result = -1;
+    }
+
+    rcl_variant_t* device = rcl_yaml_node_struct_get(node_name, "device", params);
+    if (device && device->string_value) {
+        snprintf(config->device, sizeof(config->device), "%s", device->string_value);
+    }
+
+    rcl_variant_t* devices = rcl_yaml_node_struct_get(node_name, "devices", params);
+    if (devices && devices->string_value) {
+        snprintf(config->devices, sizeof(config->devices), "%s", devices->string_value);
+    }
+
+    rcl_variant_t* file = rcl_yaml_node_struct_get(node_name, "file", params);
+    if (file && file->string_value) {
+        snprintf(config->file, sizeof(config->file), "%s", file->string_value);
+    }
+
+    rcl_variant_t* record = rcl_yaml_node_struct_get(node_name, "record", params);
+    if (record && record->string_value) {
+        snprintf(config->record, sizeof(config->record), "%s", record->string_value);
+    }
+
+    rcl_variant_t* source = rcl_yaml_node_struct_get(node_name, "source", params);
+    if (source && source->string_value && camera_config_set_source(config, source->string_value) != 0) {
+        result = -1;
+    }
+
+    rcl_variant_t* replay = rcl_yaml_node_struct_get(node_name, "replay", params);
+    if (replay && replay->string_value && camera_config_set_replay(config, replay->string_value) != 0) {
+        result = -1;
+    }
+
+    rcl_variant_t* format = rcl_yaml_node_struct_get(node_name, "format", params);
+    if (format && format->string_value && camera_config_set_format(config, format->string_value) != 0) {
+        result = -1;
+    }
+
+    return result;
+}
+
+int camera_config_load_params(camera_config_t* config, const rcl_arguments_t* arguments,
+                              const char* node_name) {
+    rcl_params_t* params = NULL;
+    if (rcl_arguments_get_param_overrides(arguments, &params) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to read parameter overrides");
+        return -1;
+    }
+    if (!params) {
+        return 0; // None given
+    }
+
+    // Wildcard first, so parameters addressed to this node win
+    char qualified[128];
+    snprintf(qualified, sizeof(qualified), "/%s", node_name);
+    int result = 0;
+    if (camera_config_apply_params(config, params, "/**") != 0 ||
+        camera_config_apply_params(config, params, node_name) != 0 ||
+        camera_config_apply_params(config, params, qualified) != 0) {
+        result = -1;
+    }
+
+    rcl_yaml_node_struct_fini(params);
+    return result;
+}
+
+int camera_config_parse_args(camera_config_t* config, int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+
+        // Everything up to the closing "--" belongs to rcl
+        if (strcmp(arg, "--ros-args") == 0) {
+            while (i + 1 < argc && strcmp(argv[i + 1], "--") != 0) {
+                ++i;
+            }
+            ++i;
+            continue;
+        }
+
+        if (strncmp(arg, "--", 2) != 0) {
+            continue;
+        }
+        if (i + 1 >= argc) {
+            RCUTILS_LOG_ERROR("Missing value for %s", arg);
+            return -1;
+        }
+        const char* value = argv[++i];
+
+        int rc = 0;
+        if (strcmp(arg, "--device") == 0) {
+            snprintf(config->device, sizeof(config->device), "%s", value);
+        } else if (strcmp(arg, "--devices") == 0) {
+            snprintf(config->devices, sizeof(config->devices), "%s", value);
+        } else if (strcmp(arg, "--sync-ms") == 0) {
+            rc = camera_config_set_count(&config->sync_ms, "sync_ms", strtoll(value, NULL, 10));
+        } else if (strcmp(arg, "--file") == 0) {
+            snprintf(config->file, sizeof(config->file), "%s", value);
+        } else if (strcmp(arg, "--record") == 0) {
+            snprintf(config->record, sizeof(config->record), "%s", value);
+        } else if (strcmp(arg, "--source") == 0) {
+            rc = camera_config_set_source(config, value);
+        } else if (strcmp(arg, "--replay") == 0) {
+            rc = camera_config_set_replay(config, value);
+        } else if (strcmp(arg, "--frames") == 0) {
+            rc = camera_config_set_count(&config->max_frames, "frames", strtoll(value, NULL, 10));
+        } else if (strcmp(arg, "--width") == 0) {
+            rc = camera_config_set_uint(&config->width, "width", strtoll(value, NULL, 10), 100000);
+        } else if (strcmp(arg, "--height") == 0) {
+            rc = camera_config_set_uint(&config->height, "height", strtoll(value, NULL, 10), 100000);
+        } else if (strcmp(arg, "--fps") == 0) {
+            rc = camera_config_set_uint(&config->fps, "fps", strtoll(value, NULL, 10), 100000);
+        } else if (strcmp(arg, "--jpeg-quality") == 0) {
+            rc = camera_config_set_uint(&config->jpeg_quality, "jpeg_quality", strtoll(value, NULL, 10), 100);
+        } else if (strcmp(arg, "--compressed-fps") == 0) {
+            rc = camera_config_set_uint(&config->compressed_fps, "compressed_fps", strtoll(value, NULL, 10), 100000);
+        } else if (strcmp(arg, "--format") == 0) {
+            rc = camera_config_set_format(config, value);
+        } else {
+            RCUTILS_LOG_WARN("Ignoring unknown option %s", arg);
+        }
+        if (rc != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void camera_config_log(const camera_config_t* config) {
+    char fourcc[5];
+    const char* name = config->devices[0] != '\0' ? config->devices :
+                       config->source == CAMERA_SOURCE_V4L2 ? config->device :
+                       config->source == CAMERA_SOURCE_FILE ? config->file : "synthetic";
+    RCUTILS_LOG_INFO("Requested %s: %ux%u @ %u fps, format %s", name,
+        config->width, config->height, config->fps,
+        config->pixel_format ? camera_fourcc_str(config->pixel_format, fourcc) : "auto");
+    if (config->source != CAMERA_SOURCE_V4L2) {
+        RCUTILS_LOG_INFO("Replay: %s", config->realtime ? "realtime" : "as fast as consumed");
+    }
+    if (config->max_frames) {
+        RCUTILS_LOG_INFO("Stopping after %u frames", config->max_frames);
+    }
+    if (config->record[0] != '\0') {
+        RCUTILS_LOG_INFO("Recording captured frames to %s", config->record);
+    }
+    if (config->devices[0] != '\0') {
+        if (config->sync_ms) {
+            RCUTILS_LOG_INFO("Frame sets: captures within %u ms", config->sync_ms);
+        } else {
+            RCUTILS_LOG_INFO("Frame sets: off");
+        }
+    }
+    RCUTILS_LOG_INFO("Compressed topic: JPEG quality %u, at most %u fps",
+        config->jpeg_quality, config->compressed_fps);
+}
+
+int camera_config_split(const camera_config_t* config, camera_config_t* cameras, int max_cameras) {
+    if (config->devices[0] == '\0') {
+        cameras[0] = *config;
+        return 1;
+    }
+
+    int count = 0;
+    const char* entry = config->devices;
+    for (;;) {
+        size_t length = strcspn(entry, ",");
+        if (length == 0 || length >= CAMERA_CONFIG_DEVICE_MAX) {
+            RCUTILS_LOG_ERROR("Empty or overlong entry in devices '%s'", config->devices);
+            return -1;
+        }
+        if (count == max_cameras) {
+            RCUTILS_LOG_ERROR("At most %d cameras per node", max_cameras);
+            return -1;
+        }
+        camera_config_t* camera = &cameras[count];
+        *camera = *config;
+        camera->devices[0] = '\0';
+        char* path = config->source == CAMERA_SOURCE_FILE ? camera->file : camera->device;
+        snprintf(path, CAMERA_CONFIG_DEVICE_MAX, "%.*s", (int)length, entry);
+        if (config->record[0] != '\0') {
+            snprintf(camera->record, sizeof(camera->record), "%.*s.%d",
+                     (int)sizeof(camera->record) - 12, config->record, count);
+        }
+        count++;
+        if (entry[length] == '\0') {
+            break;
+        }
+        entry += length + 1;
+    }
+    return count;
+}
@@ -6,413 +6,1147 @@
 #include <signal.h>
 #include <rcutils/logging_macros.h>
 #include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/primitives_sequence_functions.h>
+#include <rosidl_runtime_c/string_functions.h>
 
 // Global flag for signal handling
 static volatile sig_atomic_t g_running = 1;
 
-void signal_handler(int sig) {
-    (void)sig;
+// Latency stages on /diagnostics; the last one is end to end
+enum { CAMERA_STAGE_DEQUEUE, CAMERA_STAGE_PUBLISH, CAMERA_STAGE_TOTAL, CAMERA_STAGES };
+static const char* const g_latency_stages[CAMERA_STAGES] = {
+    "capture_to_dequeue", "dequeue_to_publish", "capture_to_publish",
+};
+
+// eventfd used to wake camera_node_spin out of epoll_wait on shutdown
+static int g_shutdown_fd = -1;
+
+void camera_node_request_shutdown(void) {
     g_running = 0;
+    if (g_shutdown_fd != -1) {
+        // write() is async-signal-safe, so this is fine from a signal handler
+        uint64_t one = 1;
+        ssize_t written = write(g_shutdown_fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+// Turn a captured frame into a publishable one: raw formats pass through,
+// MJPEG is decoded into decode_buffer. *size is updated to the result.
+// Returns NULL if the frame was corrupt and has to be skipped.
+static const uint8_t* camera_node_decode_frame(camera_node_t* camera, const uint8_t* data, size_t* size) {
+    if (!camera->decode_mjpeg) {
+        return data;
+    }
+    
+    if (mjpeg_decoder_decode(&camera->decoder, data, *size, camera->source.mode.width, camera->source.mode.height,
+                             camera->decode_buffer, camera->output.size) != 0) {
+        // USB cameras can emit bursts of these; log 1st, 2nd, 4th, 8th, ...
+        uint64_t corrupt = camera->decoder.corrupt;
+        if ((corrupt & (corrupt - 1)) == 0) {
+            RCUTILS_LOG_WARN("Skipped corrupt MJPEG frame (%llu so far)", (unsigned long long)corrupt);
+        }
+        return NULL;
+    }
+    
+    *size = camera->output.size;
+    return camera->decode_buffer;
 }
 
-int v4l2_open_device(camera_node_t* camera, const char* device) {
-    camera->fd = open(device, O_RDWR);
-    if (camera->fd == -1) {
-        RCUTILS_LOG_ERROR("Cannot open device %s: %s", device, strerror(errno));
+// Copy a captured frame into camera->image_msg for rcl_publish
+static int camera_node_copy_to_image(camera_node_t* camera, const void* frame, size_t frame_size) {
+    if (image_message_fill(camera->image_msg, frame, frame_size, camera->output.width,
+                           camera->output.height, camera->output.step, camera->output.encoding) != 0) {
         return -1;
     }
+    camera->bytes_copied += frame_size;
     return 0;
 }
 
-int v4l2_init_device(camera_node_t* camera) {
-    struct v4l2_capability cap;
-    struct v4l2_format fmt;
-    struct v4l2_requestbuffers req;
-    struct v4l2_buffer buf;
+int camera_node_read_frame(camera_node_t* camera) {
+    frame_source_frame_t captured;
     
-    // Query device capabilities
-    if (ioctl(camera->fd, VIDIOC_QUERYCAP, &cap) == -1) {
-        RCUTILS_LOG_ERROR("VIDIOC_QUERYCAP failed: %s", strerror(errno));
+    int got = frame_source_next(&camera->source, &captured);
+    if (got <= 0) {
+        return got;
+    }
+    
+    // Decode (MJPEG) and copy frame data to ROS message; corrupt frames
+    // are dropped but the buffer still goes back to the source
+    int copy_result = 0;
+    bool dropped = false;
+    if (camera->image_msg) {
+        size_t size = captured.size;
+        const uint8_t* frame = camera_node_decode_frame(camera, captured.data, &size);
+        if (frame) {
+            copy_result = camera_node_copy_to_image(camera, frame, size);
+            latency_stamp_from_monotonic(&camera->image_msg->header.stamp, captured.stamp_ns);
+        } else {
+            dropped = true;
+        }
+    }
+    
+    if (frame_source_release(&camera->source, &captured) != 0 || copy_result != 0) {
         return -1;
     }
     
-    if (!(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE)) {
-        RCUTILS_LOG_ERROR("Device does not support video capture");
+    return dropped ? 0 : 1; // Frame captured
+}
+
+static int camera_node_epoll_add(int epoll_fd, int fd, const char* what) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        RCUTILS_LOG_ERROR("epoll_ctl(%s) failed: %s", what, strerror(errno));
         return -1;
     }
+    return 0;
+}
+
+static int camera_node_init_wait(camera_node_t* camera) {
+    camera->shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (camera->shutdown_fd == -1) {
+        RCUTILS_LOG_ERROR("eventfd failed: %s", strerror(errno));
+        return -1;
+    }
+
+    camera->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    camera->publish_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (camera->epoll_fd == -1 || camera->publish_epoll_fd == -1) {
+        RCUTILS_LOG_ERROR("epoll_create1 failed: %s", strerror(errno));
+        return -1;
+    }
+
+    // A source without an fd is always ready; the capture thread then
+    // waits for room in the queue instead
+    int source_fd = camera->source.fd;
+    const char* source_what = "source fd";
+    if (source_fd == -1) {
+        source_fd = frame_queue_space_fd(&camera->capture_queue);
+        source_what = "queue space fd";
+    }
     
-    if (!(cap.capabilities & V4L2_CAP_STREAMING)) {
-        RCUTILS_LOG_ERROR("Device does not support streaming I/O");
+    // The shutdown eventfd is never read, so it wakes both threads
+    if (camera_node_epoll_add(camera->epoll_fd, source_fd, source_what) != 0 ||
+        camera_node_epoll_add(camera->epoll_fd, camera->shutdown_fd, "shutdown fd") != 0 ||
+        camera_node_epoll_add(camera->publish_epoll_fd,
+                              frame_queue_event_fd(&camera->capture_queue), "queue fd") != 0 ||
+        camera_node_epoll_add(camera->publish_epoll_fd, camera->shutdown_fd, "shutdown fd") != 0) {
         return -1;
     }
+
+    g_shutdown_fd = camera->shutdown_fd;
+    return 0;
+}
+
+static void camera_node_fini_wait(camera_node_t* camera) {
+    if (g_shutdown_fd == camera->shutdown_fd) {
+        g_shutdown_fd = -1;
+    }
+
+    if (camera->epoll_fd != -1) {
+        close(camera->epoll_fd);
+        camera->epoll_fd = -1;
+    }
+
+    if (camera->publish_epoll_fd != -1) {
+        close(camera->publish_epoll_fd);
+        camera->publish_epoll_fd = -1;
+    }
+
+    if (camera->shutdown_fd != -1) {
+        close(camera->shutdown_fd);
+        camera->shutdown_fd = -1;
+    }
+}
+
+// With the frame ring active, or components in this process taking frames
+// from the pool, raw images are only serialized for subscribers that
+// cannot get them either way (other hosts, rosbag, ...)
+static bool camera_node_wants_raw(camera_node_t* camera) {
+    if (!camera->use_frame_ring && camera->sink_count == 0) {
+        return true;
+    }
+    size_t count = 0;
+    if (rcl_publisher_get_subscription_count(&camera->publisher, &count) != RCL_RET_OK) {
+        return true;
+    }
+    return count > 0;
+}
+
+// The ring copy and descriptor only serve other processes. Standalone the
+// ring is always written; with in-process sinks only while a descriptor
+// subscriber exists.
+static bool camera_node_wants_ring(camera_node_t* camera) {
+    if (!camera->use_frame_ring) {
+        return false;
+    }
+    if (camera->sink_count == 0) {
+        return true;
+    }
+    size_t count = 0;
+    if (rcl_publisher_get_subscription_count(&camera->descriptor_publisher, &count) != RCL_RET_OK) {
+        return true;
+    }
+    return count > 0;
+}
+
+// Called on an encoder thread (or the publish thread for MJPEG
+// passthrough). Publishes a finished JPEG unless a newer frame already went
+// out, so viewers never see time run backwards.
+static void camera_node_publish_compressed(void* ctx, const jpeg_encode_frame_t* frame,
+                                           const uint8_t* jpeg, size_t jpeg_size) {
+    camera_node_t* camera = (camera_node_t*)ctx;
     
-    // Set video format
-    memset(&fmt, 0, sizeof(fmt));
-    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    fmt.fmt.pix.width = CAMERA_WIDTH;
-    fmt.fmt.pix.height = CAMERA_HEIGHT;
-    fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
-    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    pthread_mutex_lock(&camera->compressed_lock);
+    if (camera->compressed_published > 0 && frame->sequence <= camera->compressed_last_sequence) {
+        camera->compressed_stale++;
+        pthread_mutex_unlock(&camera->compressed_lock);
+        return;
+    }
     
-    if (ioctl(camera->fd, VIDIOC_S_FMT, &fmt) == -1) {
-        RCUTILS_LOG_ERROR("VIDIOC_S_FMT failed: %s", strerror(errno));
-        return -1;
+    // Lend the encoder's buffer to the message for the duration of the publish
+    sensor_msgs__msg__CompressedImage* msg = camera->compressed_msg;
+    latency_stamp_from_monotonic(&msg->header.stamp, frame->stamp_ns);
+    msg->data.data = (uint8_t*)jpeg;
+    msg->data.size = jpeg_size;
+    msg->data.capacity = jpeg_size;
+    if (rcl_publish(&camera->compressed_publisher, msg, NULL) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to publish compressed image");
+    }
+    msg->data.data = NULL;
+    msg->data.size = 0;
+    msg->data.capacity = 0;
+    
+    camera->compressed_last_sequence = frame->sequence;
+    camera->compressed_published++;
+    pthread_mutex_unlock(&camera->compressed_lock);
+}
+
+// Publish thread: pass the frame on for the compressed topic if someone
+// listens and the rate limit allows. Never waits for an encoder.
+static void camera_node_send_compressed(camera_node_t* camera, const frame_queue_frame_t* frame,
+                                        const uint8_t* data, size_t size) {
+    if (!camera->use_compressed) {
+        return;
     }
     
-    // Request buffers
-    memset(&req, 0, sizeof(req));
-    req.count = CAMERA_BUFFER_COUNT;
-    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
+    size_t count = 0;
+    if (rcl_publisher_get_subscription_count(&camera->compressed_publisher, &count) != RCL_RET_OK ||
+        count == 0) {
+        return;
+    }
     
-    if (ioctl(camera->fd, VIDIOC_REQBUFS, &req) == -1) {
-        RCUTILS_LOG_ERROR("VIDIOC_REQBUFS failed: %s", strerror(errno));
-        return -1;
+    // Allow some jitter, so a camera running at exactly the limit isn't halved
+    int64_t interval_ns = 1000000000LL / camera->config.compressed_fps;
+    if (camera->compressed_last_ns != 0 &&
+        frame->stamp_ns - camera->compressed_last_ns < interval_ns - interval_ns / 8) {
+        return;
     }
+    camera->compressed_last_ns = frame->stamp_ns;
+    
+    jpeg_encode_frame_t info = {
+        .encoding = camera->output.encoding,
+        .width = camera->output.width,
+        .height = camera->output.height,
+        .step = camera->output.step,
+        .size = size,
+        .sequence = frame->sequence,
+        .stamp_ns = frame->stamp_ns,
+    };
     
-    if (req.count < 2) {
-        RCUTILS_LOG_ERROR("Insufficient buffer memory");
+    if (camera->jpeg_passthrough) {
+        camera_node_publish_compressed(camera, &info, frame->data, frame->size);
+    } else {
+        jpeg_encode_pool_submit(&camera->encode_pool, data, &info);
+    }
+}
+
+// Capture thread: take one frame from the source, queue it for the
+// publish thread and hand the buffer straight back. Nothing here waits on
+// the middleware, so publish stalls cannot starve the driver of buffers.
+// Returns 1 if a frame was taken, 0 if none was ready, -1 on error.
+int camera_node_capture_frame(camera_node_t* camera) {
+    frame_source_frame_t captured;
+    
+    if (camera->config.max_frames && camera->frames_captured >= camera->config.max_frames) {
+        return 0;
+    }
+    // Unpaced sources are held back until there is room, so none of
+    // their frames are dropped
+    if (camera->capture_queue.policy == FRAME_QUEUE_WAIT && frame_queue_full(&camera->capture_queue)) {
+        return 0;
+    }
+    
+    int got = frame_source_next(&camera->source, &captured);
+    if (got <= 0) {
+        return got;
+    }
+    int64_t dequeue_ns = latency_monotonic_ns();
+    if (camera->frames_captured == 0) {
+        camera->first_capture_ns = dequeue_ns;
+    }
+    
+    // NULL means the queue is full and the policy drops the new frame
+    frame_queue_frame_t* frame = frame_queue_begin_push(&camera->capture_queue);
+    if (frame) {
+        // Mapped frames outlive the queue and go by pointer
+        if (captured.borrowed) {
+            frame->data = captured.data;
+        } else {
+            memcpy(frame->buffer, captured.data, captured.size);
+            frame->data = frame->buffer;
+        }
+        frame->size = captured.size;
+        frame->sequence = captured.sequence;
+        frame->stamp_ns = captured.stamp_ns;
+        frame->dequeue_ns = dequeue_ns;
+    }
+    
+    // The recorder copies the frame as captured; a slow disk costs
+    // recorded frames, never captured ones
+    if (camera->recording) {
+        frame_recorder_write(&camera->recorder, captured.data, captured.size,
+                             captured.sequence, captured.stamp_ns);
+    }
+    
+    int qret = frame_source_release(&camera->source, &captured);
+    
+    if (frame && frame_queue_push(&camera->capture_queue) < 0) {
         return -1;
     }
     
-    camera->buffer_count = req.count;
-    camera->buffers = calloc(req.count, sizeof(camera_buffer_t));
+    camera->frames_captured++;
+    return qret == 0 ? 1 : -1;
+}
+
+// Descriptor motion fields without a gate result: moving, dirty all over
+static void camera_node_mark_moving(camera_node_t* camera) {
+    embedded_object_detection_pi5__msg__FrameDescriptor* desc = camera->descriptor_msg;
+    desc->still = false;
+    desc->motion_score = 1.0f;
+    desc->dirty_x = 0;
+    desc->dirty_y = 0;
+    desc->dirty_width = camera->output.width;
+    desc->dirty_height = camera->output.height;
+}
+
+// Fill the motion fields of the descriptor for the frame in data
+static void camera_node_gate_frame(camera_node_t* camera, const uint8_t* data) {
+    if (!camera->use_motion_gate) {
+        return;
+    }
+    embedded_object_detection_pi5__msg__FrameDescriptor* desc = camera->descriptor_msg;
+    motion_gate_result_t motion;
+    if (motion_gate_run(&camera->motion_gate, data, (int)camera->output.step,
+                        (int)camera->output.width, (int)camera->output.height, &motion) != 0) {
+        camera_node_mark_moving(camera);
+        return;
+    }
+    desc->still = !motion.motion;
+    desc->motion_score = motion.score;
+    desc->dirty_x = (uint32_t)motion.x;
+    desc->dirty_y = (uint32_t)motion.y;
+    desc->dirty_width = (uint32_t)motion.width;
+    desc->dirty_height = (uint32_t)motion.height;
+    if (desc->still) {
+        camera->still_frames++;
+    }
+}
+
+// Pass the frame to the in-process sinks by pointer. The capture queue
+// entry and decode buffer are reused as soon as this returns, so the frame
+// is copied into a pool frame once; sinks that keep it hold a reference
+// instead of copying again.
+static void camera_node_hand_off(camera_node_t* camera, const frame_queue_frame_t* frame,
+                                 const uint8_t* data, size_t frame_size) {
+    frame_pool_frame_t* pooled = frame_pool_acquire(&camera->pool);
+    if (!pooled) {
+        return;  // Counted by the pool
+    }
+    memcpy(pooled->data, data, frame_size);
+    camera->bytes_copied += frame_size;
+    
+    pooled->size = frame_size;
+    pooled->width = camera->output.width;
+    pooled->height = camera->output.height;
+    pooled->step = camera->output.step;
+    pooled->encoding = camera->output.encoding;
+    pooled->sequence = frame->sequence;
+    pooled->stamp_ns = frame->stamp_ns;
+    
+    // The gate verdict lives in the descriptor, filled in even when no
+    // descriptor goes out
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc = camera->descriptor_msg;
+    if (camera->use_motion_gate) {
+        pooled->still = desc->still;
+        pooled->motion_score = desc->motion_score;
+        pooled->dirty_x = desc->dirty_x;
+        pooled->dirty_y = desc->dirty_y;
+        pooled->dirty_width = desc->dirty_width;
+        pooled->dirty_height = desc->dirty_height;
+    } else {
+        pooled->still = false;
+        pooled->motion_score = 1.0f;
+        pooled->dirty_x = 0;
+        pooled->dirty_y = 0;
+        pooled->dirty_width = camera->output.width;
+        pooled->dirty_height = camera->output.height;
+    }
     
-    if (!camera->buffers) {
-        RCUTILS_LOG_ERROR("Out of memory");
+    for (int i = 0; i < camera->sink_count; ++i) {
+        camera->sinks[i](camera->sink_contexts[i], pooled);
+    }
+    frame_pool_release(pooled);
+}
+
+// Publish thread: decode a queued frame if needed, then share it through
+// in-process sinks, the frame ring and/or a raw image. Returns -1 if the
+// frame was corrupt and skipped.
+int camera_node_publish_frame(camera_node_t* camera, const frame_queue_frame_t* frame) {
+    // The capture thread's copy into the queue, if it made one
+    if (frame->data == frame->buffer) {
+        camera->bytes_copied += frame->size;
+    }
+    
+    size_t frame_size = frame->size;
+    const uint8_t* data = camera_node_decode_frame(camera, frame->data, &frame_size);
+    if (!data) {
         return -1;
     }
     
-    // Map buffers
-    for (int i = 0; i < camera->buffer_count; ++i) {
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
-        
-        if (ioctl(camera->fd, VIDIOC_QUERYBUF, &buf) == -1) {
-            RCUTILS_LOG_ERROR("VIDIOC_QUERYBUF failed: %s", strerror(errno));
-            return -1;
-        }
-        
-        camera->buffers[i].length = buf.length;
-        camera->buffers[i].start = mmap(NULL, buf.length,
-                                       PROT_READ | PROT_WRITE,
-                                       MAP_SHARED,
-                                       camera->fd, buf.m.offset);
-        
-        if (camera->buffers[i].start == MAP_FAILED) {
-            RCUTILS_LOG_ERROR("mmap failed: %s", strerror(errno));
-            return -1;
+    camera_node_send_compressed(camera, frame, data, frame_size);
+    
+    builtin_interfaces__msg__Time stamp;
+    latency_stamp_from_monotonic(&stamp, frame->stamp_ns);
+    
+    bool share_ring = camera_node_wants_ring(camera);
+    if (share_ring || camera->sink_count > 0) {
+        camera_node_gate_frame(camera, data);
+    }
+    
+    if (camera->sink_count > 0) {
+        camera_node_hand_off(camera, frame, data, frame_size);
+    }
+    
+    if (share_ring) {
+        int ring_slot = frame_ring_begin_write(&camera->frame_ring);
+        if (ring_slot >= 0) {
+            memcpy(frame_ring_slot_data(&camera->frame_ring, ring_slot), data, frame_size);
+            camera->bytes_copied += frame_size;
+            
+            frame_ring_frame_info_t info = {
+                .size = (uint32_t)frame_size,
+                .width = camera->output.width,
+                .height = camera->output.height,
+                .step = camera->output.step,
+                .stamp_ns = frame->stamp_ns,
+                .encoding = camera->output.encoding,
+            };
+            camera->descriptor_msg->header.stamp = stamp;
+            camera->descriptor_msg->capture_sequence = frame->sequence;
+            camera->descriptor_msg->slot = (uint32_t)ring_slot;
+            camera->descriptor_msg->size = (uint32_t)frame_size;
+            camera->descriptor_msg->sequence =
+                frame_ring_commit_write(&camera->frame_ring, ring_slot, &info);
+            
+            if (rcl_publish(&camera->descriptor_publisher, camera->descriptor_msg, NULL) != RCL_RET_OK) {
+                RCUTILS_LOG_ERROR("Failed to publish frame descriptor");
+            }
+        } else {
+            __atomic_add_fetch(&camera->ring_drops, 1, __ATOMIC_RELAXED);
         }
     }
     
+    if (!camera_node_wants_raw(camera)) {
+        return 0;
+    }
+    
+    if (camera_node_copy_to_image(camera, data, frame_size) == 0) {
+        camera->image_msg->header.stamp = stamp;
+        if (rcl_publish(&camera->publisher, camera->image_msg, NULL) != RCL_RET_OK) {
+            RCUTILS_LOG_ERROR("Failed to publish image");
+        } else {
+            // rcl_publish serializes the message: another full copy
+            camera->bytes_copied += camera->image_msg->data.size;
+        }
+    }
     return 0;
 }
 
-int v4l2_start_capture(camera_node_t* camera) {
-    struct v4l2_buffer buf;
-    enum v4l2_buf_type type;
+static void camera_node_log_copy_stats(camera_node_t* camera) {
+    if (camera->frames_published == 0) {
+        return;
+    }
+    if (camera->index >= 0) {
+        RCUTILS_LOG_INFO("Camera %d (%s, %s):", camera->index, frame_source_name(&camera->source),
+            camera->image_topic);
+    }
+    RCUTILS_LOG_INFO("Published %llu frames via rcl_publish%s, %llu bytes copied per frame, %llu ring drops",
+        (unsigned long long)camera->frames_published,
+        camera->use_frame_ring ? " + frame ring" : "",
+        (unsigned long long)(camera->bytes_copied / camera->frames_published),
+        (unsigned long long)camera->ring_drops);
     
-    // Queue all buffers
-    for (int i = 0; i < camera->buffer_count; ++i) {
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
-        
-        if (ioctl(camera->fd, VIDIOC_QBUF, &buf) == -1) {
-            RCUTILS_LOG_ERROR("VIDIOC_QBUF failed: %s", strerror(errno));
-            return -1;
+    if (camera->source.drops || camera->source.corrupt || camera->source.unstamped) {
+        RCUTILS_LOG_INFO("Source %s: %llu frames dropped (sequence gaps), %llu corrupt, "
+            "%llu without a monotonic timestamp",
+            frame_source_name(&camera->source), (unsigned long long)camera->source.drops,
+            (unsigned long long)camera->source.corrupt, (unsigned long long)camera->source.unstamped);
+    }
+    
+    if (camera->sink_count > 0) {
+        uint64_t acquired, exhausted;
+        frame_pool_get_counts(&camera->pool, &acquired, &exhausted);
+        RCUTILS_LOG_INFO("Handed %llu frames to %d in-process sink(s), %llu dropped with the pool exhausted",
+            (unsigned long long)acquired, camera->sink_count, (unsigned long long)exhausted);
+    }
+    
+    if (camera->use_motion_gate) {
+        RCUTILS_LOG_INFO("Motion gate: %llu of %llu frames still",
+            (unsigned long long)camera->still_frames,
+            (unsigned long long)camera->frames_published);
+    }
+    
+    if (camera->capture_queue_ready) {
+        frame_queue_stats_t stats;
+        frame_queue_get_stats(&camera->capture_queue, &stats);
+        RCUTILS_LOG_INFO("Capture queue (%s): %llu queued, %llu dropped oldest, %llu dropped newest",
+            frame_queue_policy_name(camera->capture_queue.policy),
+            (unsigned long long)stats.pushed,
+            (unsigned long long)stats.dropped_oldest,
+            (unsigned long long)stats.dropped_newest);
+    }
+    
+    if (camera->use_compressed) {
+        pthread_mutex_lock(&camera->compressed_lock);
+        uint64_t published = camera->compressed_published;
+        uint64_t stale = camera->compressed_stale;
+        pthread_mutex_unlock(&camera->compressed_lock);
+        if (camera->jpeg_passthrough) {
+            RCUTILS_LOG_INFO("Compressed topic: %llu MJPEG frames passed through",
+                (unsigned long long)published);
+        } else {
+            RCUTILS_LOG_INFO("Compressed topic: %llu published, %llu encoder busy drops, "
+                "%llu out of order, %llu failed",
+                (unsigned long long)published,
+                (unsigned long long)__atomic_load_n(&camera->encode_pool.busy_drops, __ATOMIC_RELAXED),
+                (unsigned long long)stale,
+                (unsigned long long)__atomic_load_n(&camera->encode_pool.failed, __ATOMIC_RELAXED));
         }
     }
     
-    // Start streaming
-    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    if (ioctl(camera->fd, VIDIOC_STREAMON, &type) == -1) {
-        RCUTILS_LOG_ERROR("VIDIOC_STREAMON failed: %s", strerror(errno));
-        return -1;
+    if (camera->decode_mjpeg) {
+        RCUTILS_LOG_INFO("MJPEG decoder: %llu decoded, %llu corrupt frames skipped",
+            (unsigned long long)camera->decoder.decoded,
+            (unsigned long long)camera->decoder.corrupt);
     }
     
-    camera->is_streaming = true;
-    return 0;
+    if (camera->recording) {
+        frame_recorder_stats_t stats;
+        frame_recorder_get_stats(&camera->recorder, &stats);
+        double seconds = stats.elapsed_ns / 1e9;
+        RCUTILS_LOG_INFO("Recorder: %llu frames, %.1f MB/s, disk busy %.0f%%, longest write %.1f ms, "
+            "%llu dropped",
+            (unsigned long long)stats.frames, seconds > 0.0 ? stats.bytes / 1e6 / seconds : 0.0,
+            stats.elapsed_ns > 0 ? 100.0 * stats.write_ns / stats.elapsed_ns : 0.0,
+            stats.max_write_ns / 1e6, (unsigned long long)stats.dropped);
+    }
 }
 
-int v4l2_stop_capture(camera_node_t* camera) {
-    enum v4l2_buf_type type;
-    
-    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    if (ioctl(camera->fd, VIDIOC_STREAMOFF, &type) == -1) {
-        RCUTILS_LOG_ERROR("VIDIOC_STREAMOFF failed: %s", strerror(errno));
+// Record frames as captured, before any decoding
+static int camera_node_init_recorder(camera_node_t* camera) {
+    const camera_mode_t* mode = &camera->source.mode;
+    if (frame_recorder_open(&camera->recorder, camera->config.record, mode->format->fourcc,
+                            mode->width, mode->height, mode->bytesperline, mode->fps,
+                            mode->sizeimage, CAMERA_RECORD_QUEUE_DEPTH) != 0) {
         return -1;
     }
-    
-    camera->is_streaming = false;
+    camera->recording = true;
     return 0;
 }
 
-int v4l2_read_frame(camera_node_t* camera) {
-    struct v4l2_buffer buf;
+// The gate reads luma only, so it runs on YUYV output only
+static void camera_node_init_motion_gate(camera_node_t* camera) {
+    if (!CAMERA_MOTION_GATE || strcmp(camera->output.encoding, "yuv422_yuy2") != 0) {
+        return;
+    }
+    motion_gate_config_t config;
+    motion_gate_config_default(&config);
+    config.decimation = CAMERA_MOTION_DECIMATION;
+    if (motion_gate_init(&camera->motion_gate, &config) != 0) {
+        RCUTILS_LOG_WARN("Motion gate unavailable, every frame marked as moving");
+        return;
+    }
+    camera->use_motion_gate = true;
+    RCUTILS_LOG_INFO("Motion gate: %s, luma decimated by %d, %d-sample blocks",
+        color_convert_isa_name(camera->motion_gate.isa), config.decimation, config.block_size);
+}
+
+static int camera_node_init_frame_ring(camera_node_t* camera, size_t frame_size) {
+    if (frame_ring_create(&camera->frame_ring, camera->ring_name,
+                          CAMERA_FRAME_RING_SLOTS, frame_size) != 0) {
+        return -1;
+    }
+    
+    rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
+    const rosidl_message_type_support_t* type_support = 
+        ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg, FrameDescriptor);
     
-    memset(&buf, 0, sizeof(buf));
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
+    rcl_ret_t ret = rcl_publisher_init(&camera->descriptor_publisher, camera->node, type_support,
+                                       camera->descriptor_topic, &pub_options);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize descriptor publisher");
+        frame_ring_close(&camera->frame_ring);
+        return -1;
+    }
     
-    // Dequeue buffer
-    if (ioctl(camera->fd, VIDIOC_DQBUF, &buf) == -1) {
-        if (errno == EAGAIN) {
-            return 0; // No frame available
+    // Everything except slot, sequence and size is fixed for the life of the ring
+    camera->descriptor_msg = embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    if (!camera->descriptor_msg ||
+        !rosidl_runtime_c__String__assign(&camera->descriptor_msg->ring_name, camera->ring_name) ||
+        !rosidl_runtime_c__String__assign(&camera->descriptor_msg->encoding, camera->output.encoding) ||
+        !rosidl_runtime_c__String__assign(&camera->descriptor_msg->header.frame_id, camera->frame_id)) {
+        RCUTILS_LOG_ERROR("Failed to create frame descriptor message");
+        if (camera->descriptor_msg) {
+            embedded_object_detection_pi5__msg__FrameDescriptor__destroy(camera->descriptor_msg);
+            camera->descriptor_msg = NULL;
         }
-        RCUTILS_LOG_ERROR("VIDIOC_DQBUF failed: %s", strerror(errno));
+        rcl_publisher_fini(&camera->descriptor_publisher, camera->node);
+        frame_ring_close(&camera->frame_ring);
         return -1;
     }
+    camera->descriptor_msg->size = (uint32_t)frame_size;
+    camera->descriptor_msg->width = camera->output.width;
+    camera->descriptor_msg->height = camera->output.height;
+    camera->descriptor_msg->step = camera->output.step;
     
-    // Copy frame data to ROS message
-    if (camera->image_msg && camera->buffers[buf.index].start) {
-        size_t frame_size = CAMERA_WIDTH * CAMERA_HEIGHT * 2; // YUYV
-        
-        // Ensure message data is large enough
-        if (camera->image_msg->data.capacity < frame_size) {
-            // Free existing data if any
-            if (camera->image_msg->data.data) {
-                free(camera->image_msg->data.data);
-            }
-            
-            // Allocate new data buffer
-            camera->image_msg->data.data = malloc(frame_size);
-            if (!camera->image_msg->data.data) {
-                RCUTILS_LOG_ERROR("Failed to allocate image data buffer");
-                return -1;
-            }
-            camera->image_msg->data.capacity = frame_size;
-        }
-        
-        // Copy frame data
-        memcpy(camera->image_msg->data.data, 
-               camera->buffers[buf.index].start, 
-               frame_size);
-        
-        camera->image_msg->data.size = frame_size;
-        camera->image_msg->width = CAMERA_WIDTH;
-        camera->image_msg->height = CAMERA_HEIGHT;
-        camera->image_msg->step = CAMERA_WIDTH * 2;
-        
-        // Set encoding string
-        if (camera->image_msg->encoding.data) {
-            free(camera->image_msg->encoding.data);
-        }
-        camera->image_msg->encoding.data = strdup("yuv422_yuy2");
-        camera->image_msg->encoding.size = 12;
-        camera->image_msg->encoding.capacity = 13;
+    camera_node_mark_moving(camera);
+    camera_node_init_motion_gate(camera);
+    
+    camera->use_frame_ring = true;
+    RCUTILS_LOG_INFO("Sharing frames via %s (%d slots), descriptors on %s",
+        camera->ring_name, CAMERA_FRAME_RING_SLOTS, camera->descriptor_topic);
+    return 0;
+}
+
+static void camera_node_fini_frame_ring(camera_node_t* camera) {
+    if (!camera->use_frame_ring) {
+        return;
+    }
+    if (camera->use_motion_gate) {
+        motion_gate_fini(&camera->motion_gate);
+        camera->use_motion_gate = false;
     }
+    embedded_object_detection_pi5__msg__FrameDescriptor__destroy(camera->descriptor_msg);
+    camera->descriptor_msg = NULL;
+    rcl_publisher_fini(&camera->descriptor_publisher, camera->node);
+    frame_ring_close(&camera->frame_ring);
+    camera->use_frame_ring = false;
+}
+
+// Derive the published frame geometry from the capture mode and set up
+// the MJPEG decoder if the camera delivers compressed frames
+static int camera_node_init_output(camera_node_t* camera) {
+    const camera_mode_t* mode = &camera->source.mode;
+    
+    if (mode->format->encoding) {
+        camera->output.encoding = mode->format->encoding;
+        camera->output.width = mode->width;
+        camera->output.height = mode->height;
+        camera->output.step = mode->bytesperline;
+        camera->output.size = mode->sizeimage;
+        return 0;
+    }
+    
+    if (mjpeg_decoder_init(&camera->decoder, CAMERA_MJPEG_OUTPUT, CAMERA_MJPEG_SCALE) != 0) {
+        RCUTILS_LOG_ERROR("Failed to create MJPEG decoder");
+        return -1;
+    }
+    camera->decode_mjpeg = true;
     
-    // Re-queue buffer
-    if (ioctl(camera->fd, VIDIOC_QBUF, &buf) == -1) {
-        RCUTILS_LOG_ERROR("VIDIOC_QBUF failed: %s", strerror(errno));
+    camera->output.encoding = mjpeg_output_encoding(CAMERA_MJPEG_OUTPUT);
+    mjpeg_decoder_output_size(&camera->decoder, mode->width, mode->height,
+                              &camera->output.width, &camera->output.height,
+                              &camera->output.step, &camera->output.size);
+    camera->decode_buffer = malloc(camera->output.size);
+    if (!camera->decode_buffer) {
+        RCUTILS_LOG_ERROR("Failed to allocate MJPEG decode buffer");
         return -1;
     }
     
-    return 1; // Frame captured
+    RCUTILS_LOG_INFO("Decoding MJPEG to %s %ux%u (1/%d scale)", camera->output.encoding,
+        camera->output.width, camera->output.height, CAMERA_MJPEG_SCALE);
+    return 0;
 }
 
-void v4l2_close_device(camera_node_t* camera) {
-    if (camera->is_streaming) {
-        v4l2_stop_capture(camera);
+static int camera_node_init_compressed(camera_node_t* camera) {
+    camera->jpeg_passthrough = camera->decode_mjpeg;
+    if (!camera->jpeg_passthrough && !jpeg_encoder_supports(camera->output.encoding)) {
+        RCUTILS_LOG_WARN("Cannot JPEG-compress %s, %s disabled",
+            camera->output.encoding, camera->compressed_topic);
+        return 0;
     }
     
-    if (camera->buffers) {
-        for (int i = 0; i < camera->buffer_count; ++i) {
-            if (camera->buffers[i].start) {
-                munmap(camera->buffers[i].start, camera->buffers[i].length);
-            }
+    rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
+    const rosidl_message_type_support_t* type_support = 
+        ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, CompressedImage);
+    if (rcl_publisher_init(&camera->compressed_publisher, camera->node, type_support,
+                           camera->compressed_topic, &pub_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize compressed image publisher");
+        return -1;
+    }
+    
+    camera->compressed_msg = sensor_msgs__msg__CompressedImage__create();
+    if (!camera->compressed_msg ||
+        !rosidl_runtime_c__String__assign(&camera->compressed_msg->format, "jpeg") ||
+        !rosidl_runtime_c__String__assign(&camera->compressed_msg->header.frame_id, camera->frame_id)) {
+        RCUTILS_LOG_ERROR("Failed to create compressed image message");
+        if (camera->compressed_msg) {
+            sensor_msgs__msg__CompressedImage__destroy(camera->compressed_msg);
+            camera->compressed_msg = NULL;
         }
-        free(camera->buffers);
-        camera->buffers = NULL;
+        rcl_publisher_fini(&camera->compressed_publisher, camera->node);
+        return -1;
     }
+    pthread_mutex_init(&camera->compressed_lock, NULL);
+    camera->use_compressed = true;
     
-    if (camera->fd != -1) {
-        close(camera->fd);
-        camera->fd = -1;
+    if (camera->jpeg_passthrough) {
+        RCUTILS_LOG_INFO("Publishing camera MJPEG on %s at up to %u fps",
+            camera->compressed_topic, camera->config.compressed_fps);
+        return 0;
     }
+    
+    if (jpeg_encode_pool_init(&camera->encode_pool, CAMERA_JPEG_THREADS, camera->output.size,
+                              (int)camera->config.jpeg_quality,
+                              camera_node_publish_compressed, camera) != 0) {
+        return -1;
+    }
+    camera->encode_pool_ready = true;
+    RCUTILS_LOG_INFO("Publishing JPEG (quality %u) on %s at up to %u fps, %d encoder threads",
+        camera->config.jpeg_quality, camera->compressed_topic, camera->config.compressed_fps,
+        CAMERA_JPEG_THREADS);
+    return 0;
 }
 
-int camera_node_init(camera_node_t* camera, rcl_context_t* context) {
-    rcl_ret_t ret;
-    
-    // Initialize camera structure
+static void camera_node_fini_compressed(camera_node_t* camera) {
+    // Workers publish, so they go first
+    if (camera->encode_pool_ready) {
+        jpeg_encode_pool_fini(&camera->encode_pool);
+        camera->encode_pool_ready = false;
+    }
+    if (!camera->use_compressed) {
+        return;
+    }
+    sensor_msgs__msg__CompressedImage__destroy(camera->compressed_msg);
+    camera->compressed_msg = NULL;
+    rcl_publisher_fini(&camera->compressed_publisher, camera->node);
+    pthread_mutex_destroy(&camera->compressed_lock);
+    camera->use_compressed = false;
+}
+
+// Topic, ring and frame_id names: a camera on its own keeps the plain
+// /camera names, camera N of a multi-camera node moves under /camera<N>
+static void camera_node_reset(camera_node_t* camera, const camera_config_t* config, int index) {
     memset(camera, 0, sizeof(camera_node_t));
-    camera->fd = -1;
+    camera->config = *config;
+    camera->epoll_fd = -1;
+    camera->publish_epoll_fd = -1;
+    camera->shutdown_fd = -1;
+    camera->index = index;
     
-    // Initialize ROS2 node
-    rcl_node_options_t node_options = rcl_node_get_default_options();
-    ret = rcl_node_init(&camera->node, "camera_node", "", context, &node_options);
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize ROS2 node");
-        return -1;
+    if (index < 0) {
+        snprintf(camera->frame_id, CAMERA_NAME_MAX, "%s", CAMERA_FRAME_ID);
+        snprintf(camera->image_topic, CAMERA_NAME_MAX, "%s", CAMERA_IMAGE_TOPIC);
+        snprintf(camera->descriptor_topic, CAMERA_NAME_MAX, "%s", CAMERA_DESCRIPTOR_TOPIC);
+        snprintf(camera->compressed_topic, CAMERA_NAME_MAX, "%s", CAMERA_COMPRESSED_TOPIC);
+        snprintf(camera->ring_name, CAMERA_NAME_MAX, "%s", CAMERA_FRAME_RING_NAME);
+        return;
     }
+    snprintf(camera->frame_id, CAMERA_NAME_MAX, "%s%d", CAMERA_FRAME_ID, index);
+    snprintf(camera->image_topic, CAMERA_NAME_MAX, "/camera%d/image_raw", index);
+    snprintf(camera->descriptor_topic, CAMERA_NAME_MAX, "/camera%d/frame_descriptor", index);
+    snprintf(camera->compressed_topic, CAMERA_NAME_MAX, "/camera%d/image_raw/compressed", index);
+    snprintf(camera->ring_name, CAMERA_NAME_MAX, "/camera%d_frames", index);
+}
+
+// Everything but the node, the waits and starting the source. The caller
+// cleans up with camera_node_fini on failure.
+static int camera_node_setup(camera_node_t* camera) {
+    rcl_ret_t ret;
     
     // Initialize publisher
     rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
     const rosidl_message_type_support_t* type_support = 
         ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image);
     
-    ret = rcl_publisher_init(&camera->publisher, &camera->node, type_support, 
-                            "/camera/image_raw", &pub_options);
+    ret = rcl_publisher_init(&camera->publisher, camera->node, type_support, 
+                            camera->image_topic, &pub_options);
     if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize publisher");
-        rcl_node_fini(&camera->node);
+        RCUTILS_LOG_ERROR("Failed to initialize publisher on %s", camera->image_topic);
+        return -1;
+    }
+    
+    // Initialize image message
+    camera->image_msg = sensor_msgs__msg__Image__create();
+    if (!camera->image_msg) {
+        RCUTILS_LOG_ERROR("Failed to create image message");
+        return -1;
+    }
+    
+    // Open the camera, recording or test pattern
+    if (frame_source_open(&camera->source, &camera->config) != 0) {
+        RCUTILS_LOG_ERROR("Failed to open frame source %s", camera_source_name(camera->config.source));
+        return -1;
+    }
+    camera->source_ready = true;
+    
+    if (camera_node_init_output(camera) != 0) {
+        return -1;
+    }
+    
+    // Size the published message from the negotiated format once; every
+    // frame after that is refilled in place
+    size_t frame_size = camera->output.size;
+    if (image_message_reserve(camera->image_msg, frame_size, camera->output.encoding) != 0) {
+        RCUTILS_LOG_ERROR("Failed to allocate initial image data buffer");
+        return -1;
+    }
+    camera->image_msg->width = camera->output.width;
+    camera->image_msg->height = camera->output.height;
+    camera->image_msg->step = camera->output.step;
+    if (!rosidl_runtime_c__String__assign(&camera->image_msg->header.frame_id, camera->frame_id)) {
+        RCUTILS_LOG_ERROR("Failed to set image frame id");
+        return -1;
+    }
+    
+    // The queue carries frames as captured (compressed for MJPEG). A source
+    // without its own pace runs as fast as the publish thread takes frames.
+    frame_queue_policy_t policy = camera->source.paced ? CAMERA_QUEUE_POLICY : FRAME_QUEUE_WAIT;
+    if (frame_queue_init(&camera->capture_queue, CAMERA_QUEUE_DEPTH, camera->source.mode.sizeimage,
+                         policy) != 0) {
+        RCUTILS_LOG_ERROR("Failed to create capture queue");
         return -1;
     }
+    camera->capture_queue_ready = true;
+    RCUTILS_LOG_INFO("Capture queue: %d frames, %s",
+        CAMERA_QUEUE_DEPTH, frame_queue_policy_name(policy));
     
+    if (camera->config.record[0] != '\0' && camera_node_init_recorder(camera) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start recording");
+        return -1;
+    }
+    
+    if (CAMERA_USE_FRAME_RING && camera_node_init_frame_ring(camera, frame_size) != 0) {
+        RCUTILS_LOG_WARN("Frame ring unavailable, publishing raw images only");
+    }
+    
+    if (camera_node_init_compressed(camera) != 0) {
+        RCUTILS_LOG_WARN("Compressed image topic unavailable");
+    }
+    
+    const char* latency_name = camera->index < 0 ? "camera_node" : camera->frame_id;
+    if (latency_diagnostics_init(&camera->latency, camera->node, latency_name,
+                                 g_latency_stages, CAMERA_STAGES) == 0) {
+        camera->latency_ready = true;
+    } else {
+        RCUTILS_LOG_WARN("Latency diagnostics unavailable");
+    }
+    return 0;
+}
 
+int camera_node_init(camera_node_t* camera, rcl_context_t* context, const camera_config_t* config) {
+    rcl_ret_t ret;
+    
+    // Initialize camera structure
+    camera_node_reset(camera, config, -1);
+    
+    // Initialize ROS2 node
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    ret = rcl_node_init(&camera->own_node, "camera_node", "", context, &node_options);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize ROS2 node");
+        return -1;
+    }
+    camera->node = &camera->own_node;
     
     // Initialize wait set (no timers, no subscriptions, just for publishing)
     ret = rcl_wait_set_init(&camera->wait_set, 0, 0, 0, 0, 0, 0, context, 
                            rcl_get_default_allocator());
     if (ret != RCL_RET_OK) {
         RCUTILS_LOG_ERROR("Failed to initialize wait set");
-        rcl_publisher_fini(&camera->publisher, &camera->node);
-        rcl_node_fini(&camera->node);
+        camera_node_fini(camera);
         return -1;
     }
     
-        // Initialize image message
-    camera->image_msg = sensor_msgs__msg__Image__create();
-    if (!camera->image_msg) {
-        RCUTILS_LOG_ERROR("Failed to create image message");
-        rcl_wait_set_fini(&camera->wait_set);
-        rcl_publisher_fini(&camera->publisher, &camera->node);
-        rcl_node_fini(&camera->node);
+    if (camera_node_setup(camera) != 0) {
+        camera_node_fini(camera);
         return -1;
     }
     
-    // Initialize message fields
-    size_t frame_size = CAMERA_WIDTH * CAMERA_HEIGHT * 2; // YUYV
-    camera->image_msg->data.data = malloc(frame_size);
-    if (!camera->image_msg->data.data) {
-        RCUTILS_LOG_ERROR("Failed to allocate initial image data buffer");
-        sensor_msgs__msg__Image__destroy(camera->image_msg);
-        rcl_wait_set_fini(&camera->wait_set);
-        rcl_publisher_fini(&camera->publisher, &camera->node);
-        rcl_node_fini(&camera->node);
-        return -1;
-    }
-    camera->image_msg->data.capacity = frame_size;
-    camera->image_msg->data.size = 0;
-    camera->image_msg->width = CAMERA_WIDTH;
-    camera->image_msg->height = CAMERA_HEIGHT;
-    camera->image_msg->step = CAMERA_WIDTH * 2;
-    camera->image_msg->encoding.data = strdup("yuv422_yuy2");
-    camera->image_msg->encoding.size = 12;
-    camera->image_msg->encoding.capacity = 13;
-    
-    // Initialize V4L2 camera
-    if (v4l2_open_device(camera, CAMERA_DEVICE) != 0) {
-        RCUTILS_LOG_ERROR("Failed to open V4L2 device");
+    if (camera_node_init_wait(camera) != 0) {
+        RCUTILS_LOG_ERROR("Failed to set up capture wait");
         camera_node_fini(camera);
         return -1;
     }
     
-    if (v4l2_init_device(camera) != 0) {
-        RCUTILS_LOG_ERROR("Failed to initialize V4L2 device");
+    if (frame_source_start(&camera->source) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start frame source");
         camera_node_fini(camera);
         return -1;
     }
     
-    if (v4l2_start_capture(camera) != 0) {
-        RCUTILS_LOG_ERROR("Failed to start V4L2 capture");
+    RCUTILS_LOG_INFO("Camera node initialized successfully");
+    return 0;
+}
+
+int camera_node_init_member(camera_node_t* camera, rcl_node_t* node, const camera_config_t* config,
+                            int index) {
+    camera_node_reset(camera, config, index);
+    camera->node = node;
+    if (camera_node_setup(camera) != 0) {
+        RCUTILS_LOG_ERROR("Failed to set up camera %d (%s)", index, camera->image_topic);
         camera_node_fini(camera);
         return -1;
     }
-    
-    RCUTILS_LOG_INFO("Camera node initialized successfully");
     return 0;
 }
 
 void camera_node_fini(camera_node_t* camera) {
+    camera_node_log_copy_stats(camera);
+    
     if (camera->image_msg) {
-        // Free allocated memory
-        if (camera->image_msg->data.data) {
-            free(camera->image_msg->data.data);
-        }
-        if (camera->image_msg->encoding.data) {
-            free(camera->image_msg->encoding.data);
-        }
+        // Data and encoding come from the default allocator, like rosidl's own
         sensor_msgs__msg__Image__destroy(camera->image_msg);
         camera->image_msg = NULL;
     }
     
+    camera_node_fini_compressed(camera);
+    camera_node_fini_frame_ring(camera);
+    if (camera->latency_ready) {
+        latency_diagnostics_fini(&camera->latency);
+        camera->latency_ready = false;
+    }
     rcl_wait_set_fini(&camera->wait_set);
-    rcl_publisher_fini(&camera->publisher, &camera->node);
-    rcl_node_fini(&camera->node);
+    if (camera->node) {
+        rcl_publisher_fini(&camera->publisher, camera->node);
+    }
     
-    v4l2_close_device(camera);
+    // A multi-camera node outlives its cameras
+    if (camera->node == &camera->own_node) {
+        rcl_node_fini(&camera->own_node);
+    }
+    camera->node = NULL;
+    
+    // The capture thread has stopped: finish the file with its index
+    if (camera->recording) {
+        frame_recorder_close(&camera->recorder, NULL);
+        camera->recording = false;
+    }
+    
+    camera_node_fini_wait(camera);
+    if (camera->source_ready) {
+        frame_source_close(&camera->source);
+        camera->source_ready = false;
+    }
+    
+    if (camera->capture_queue_ready) {
+        frame_queue_fini(&camera->capture_queue);
+        camera->capture_queue_ready = false;
+    }
+    
+    if (camera->decode_mjpeg) {
+        mjpeg_decoder_fini(&camera->decoder);
+        camera->decode_mjpeg = false;
+    }
+    free(camera->decode_buffer);
+    camera->decode_buffer = NULL;
+    
+    // Sinks release their frames before the camera goes away
+    if (camera->pool_ready) {
+        frame_pool_fini(&camera->pool);
+        camera->pool_ready = false;
+    }
+    camera->sink_count = 0;
 }
 
-int camera_node_spin(camera_node_t* camera) {
-    rcl_ret_t ret;
+int camera_node_add_sink(camera_node_t* camera, camera_frame_sink_t sink, void* ctx) {
+    if (camera->sink_count == CAMERA_MAX_SINKS) {
+        RCUTILS_LOG_ERROR("At most %d in-process frame sinks", CAMERA_MAX_SINKS);
+        return -1;
+    }
+    if (!camera->pool_ready) {
+        if (frame_pool_init(&camera->pool, CAMERA_POOL_FRAMES, camera->output.size) != 0) {
+            return -1;
+        }
+        camera->pool_ready = true;
+        RCUTILS_LOG_INFO("In-process frame pool: %d frames of %zu bytes",
+            CAMERA_POOL_FRAMES, camera->output.size);
+    }
+    camera->sinks[camera->sink_count] = sink;
+    camera->sink_contexts[camera->sink_count] = ctx;
+    camera->sink_count++;
+    return 0;
+}
+
+static void* camera_node_capture_thread(void* arg) {
+    camera_node_t* camera = (camera_node_t*)arg;
+    struct epoll_event events[2];
     
     while (g_running) {
-        // Read frame from camera
-        int frame_result = v4l2_read_frame(camera);
-        if (frame_result > 0 && camera->image_msg) {
-            // Publish frame
-            ret = rcl_publish(&camera->publisher, camera->image_msg, NULL);
-            if (ret != RCL_RET_OK) {
-                RCUTILS_LOG_ERROR("Failed to publish image");
+        // Sleep until the source has a frame (or, unpaced, the queue has
+        // room) or shutdown is requested
+        int n = epoll_wait(camera->epoll_fd, events, 2, CAMERA_WAIT_TIMEOUT_MS);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
             }
+            RCUTILS_LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+            camera->capture_result = -1;
+            break;
+        }
+        
+        if (n == 0) {
+            RCUTILS_LOG_WARN("No frame from %s in %d ms", frame_source_name(&camera->source),
+                CAMERA_WAIT_TIMEOUT_MS);
+            continue;
         }
         
-        // Simple delay for 30 FPS
-        usleep(33333); // ~30 FPS
+        bool frame_ready = false;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == camera->shutdown_fd) {
+                g_running = 0;
+            } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                RCUTILS_LOG_ERROR("Frame source reported an error, stopping capture");
+                camera->capture_result = -1;
+                g_running = 0;
+            } else if (events[i].events & EPOLLIN) {
+                frame_ready = true;
+            }
+        }
+        
+        if (!g_running || !frame_ready) {
+            continue;
+        }
+        
+        // Reset the space wakeup before filling the queue, so a pop
+        // meanwhile either leaves room below or signals again
+        if (camera->capture_queue.policy == FRAME_QUEUE_WAIT) {
+            frame_queue_clear_space(&camera->capture_queue);
+        }
+        
+        // Drain every buffer the driver has completed (errors are logged
+        // by the callees)
+        while (camera_node_capture_frame(camera) > 0) {
+        }
+        
+        if (camera->config.max_frames && camera->frames_captured >= camera->config.max_frames) {
+            RCUTILS_LOG_INFO("Captured %u frames, stopping", camera->config.max_frames);
+            camera->capture_finished = true;
+            break;
+        }
     }
     
-    return 0;
+    // Wake the publish thread if capture stopped on its own
+    camera_node_request_shutdown();
+    return NULL;
 }
 
-int main(int argc, char* argv[]) {
-    // Set up signal handling
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-    
-    // Initialize RCL
-    rcl_context_t context = rcl_get_zero_initialized_context();
-    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+// Latency of a frame that was just handed on
+static void camera_node_trace_frame(camera_node_t* camera, const frame_queue_frame_t* frame) {
+    if (!camera->latency_ready) {
+        return;
+    }
+    int64_t now_ns = latency_monotonic_ns();
+    latency_diagnostics_record(&camera->latency, CAMERA_STAGE_DEQUEUE, frame->dequeue_ns - frame->stamp_ns);
+    latency_diagnostics_record(&camera->latency, CAMERA_STAGE_PUBLISH, now_ns - frame->dequeue_ns);
+    latency_diagnostics_record(&camera->latency, CAMERA_STAGE_TOTAL, now_ns - frame->stamp_ns);
+    latency_diagnostics_tick(&camera->latency, now_ns);
+}
+
+int camera_node_publish_queued(camera_node_t* camera, const frame_queue_frame_t* frame) {
+    if (camera_node_publish_frame(camera, frame) != 0) {
+        return -1;
+    }
+    camera_node_trace_frame(camera, frame);
     
-    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize init options");
-        return 1;
+    // A multi-camera node logs every camera on its own schedule (camera_rig.c)
+    uint64_t published = __atomic_add_fetch(&camera->frames_published, 1, __ATOMIC_RELAXED);
+    if (camera->index < 0 && published % CAMERA_STATS_INTERVAL == 0) {
+        camera_node_log_copy_stats(camera);
+    }
+    return 0;
+}
+
+// Publish everything in the capture queue
+static void camera_node_drain_queue(camera_node_t* camera) {
+    frame_queue_frame_t* frame;
+    while ((frame = frame_queue_pop(&camera->capture_queue)) != NULL) {
+        camera_node_publish_queued(camera, frame);
+        frame_queue_release(&camera->capture_queue, frame);
     }
+}
+
+int camera_node_spin(camera_node_t* camera) {
+    struct epoll_event events[2];
+    int result = 0;
     
-    ret = rcl_init(argc, (const char* const*)argv, &init_options, &context);
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize RCL");
-        rcl_init_options_fini(&init_options);
-        return 1;
+    camera->capture_result = 0;
+    if (pthread_create(&camera->capture_thread, NULL, camera_node_capture_thread, camera) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start capture thread");
+        return -1;
     }
     
-    // Initialize camera node
-    camera_node_t camera;
-    if (camera_node_init(&camera, &context) != 0) {
-        RCUTILS_LOG_ERROR("Failed to initialize camera node");
-        rcl_shutdown(&context);
-        rcl_context_fini(&context);
-        rcl_init_options_fini(&init_options);
-        return 1;
+    // This thread publishes whatever the capture thread queues
+    while (g_running) {
+        int n = epoll_wait(camera->publish_epoll_fd, events, 2, CAMERA_WAIT_TIMEOUT_MS);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RCUTILS_LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+            result = -1;
+            camera_node_request_shutdown();
+            break;
+        }
+        
+        bool frames_ready = false;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.fd == camera->shutdown_fd) {
+                g_running = 0;
+            } else {
+                frames_ready = true;
+            }
+        }
+        
+        if (!g_running || !frames_ready) {
+            continue;
+        }
+        
+        // Reset the wakeup before draining, so a frame queued meanwhile
+        // either gets popped below or signals again
+        frame_queue_clear_event(&camera->capture_queue);
+        camera_node_drain_queue(camera);
     }
     
-    RCUTILS_LOG_INFO("Camera node started");
+    pthread_join(camera->capture_thread, NULL);
     
-    // Run camera node
-    int result = camera_node_spin(&camera);
+    // A frame limit ends the run with frames still queued; publish them so
+    // the rate below covers every captured frame
+    if (camera->capture_finished) {
+        camera_node_drain_queue(camera);
+    }
     
-    // Cleanup
-    camera_node_fini(&camera);
-    rcl_shutdown(&context);
-    rcl_context_fini(&context);
-    rcl_init_options_fini(&init_options);
+    // With an unpaced source this is the pipeline's sustainable rate
+    if (camera->frames_published > 0) {
+        double seconds = (latency_monotonic_ns() - camera->first_capture_ns) / 1e9;
+        RCUTILS_LOG_INFO("Published %llu frames from %s in %.2f s (%.1f fps)",
+            (unsigned long long)camera->frames_published, frame_source_name(&camera->source),
+            seconds, seconds > 0.0 ? camera->frames_published / seconds : 0.0);
+    }
     
-    RCUTILS_LOG_INFO("Camera node stopped");
-    return result;
-} 
\ No newline at end of file
+    return camera->capture_result != 0 ? camera->capture_result : result;
+}
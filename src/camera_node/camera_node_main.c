@@ -0,0 +1,107 @@
+#include "camera_node/camera_node.h"
+#include "camera_node/camera_rig.h"
+#include <signal.h>
+#include <rcutils/logging_macros.h>
+
+// The camera as its own process; pipeline_node hosts the same component
+// next to the display instead. A device list runs every camera in this
+// process (camera_rig.h).
+
+static void signal_handler(int sig) {
+    (void)sig;
+    camera_node_request_shutdown();
+    camera_rig_request_shutdown();
+}
+
+int main(int argc, char* argv[]) {
+    // Set up signal handling
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    // Initialize RCL
+    rcl_context_t context = rcl_get_zero_initialized_context();
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+    
+    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize init options");
+        return 1;
+    }
+    
+    ret = rcl_init(argc, (const char* const*)argv, &init_options, &context);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize RCL");
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    // Defaults, then ROS parameters, then command-line flags
+    camera_config_t config;
+    camera_config_init(&config, CAMERA_DEVICE, CAMERA_WIDTH, CAMERA_HEIGHT, CAMERA_FPS,
+                       CAMERA_JPEG_QUALITY, CAMERA_COMPRESSED_FPS);
+    if (camera_config_load_params(&config, &context.global_arguments, "camera_node") != 0 ||
+        camera_config_parse_args(&config, argc, argv) != 0) {
+        RCUTILS_LOG_ERROR("Invalid camera configuration");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    camera_config_log(&config);
+    
+    camera_config_t cameras[CAMERA_CONFIG_MAX_CAMERAS];
+    int count = camera_config_split(&config, cameras, CAMERA_CONFIG_MAX_CAMERAS);
+    if (count < 0) {
+        RCUTILS_LOG_ERROR("Invalid camera configuration");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    if (count > 1) {
+        camera_rig_t rig;
+        if (camera_rig_init(&rig, &context, cameras, count) != 0) {
+            RCUTILS_LOG_ERROR("Failed to initialize camera node");
+            rcl_shutdown(&context);
+            rcl_context_fini(&context);
+            rcl_init_options_fini(&init_options);
+            return 1;
+        }
+        
+        RCUTILS_LOG_INFO("Camera node started with %d cameras", count);
+        int result = camera_rig_spin(&rig);
+        
+        camera_rig_fini(&rig);
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        
+        RCUTILS_LOG_INFO("Camera node stopped");
+        return result;
+    }
+    
+    // Initialize camera node
+    camera_node_t camera;
+    if (camera_node_init(&camera, &context, &config) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize camera node");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    RCUTILS_LOG_INFO("Camera node started");
+    
+    // Run camera node
+    int result = camera_node_spin(&camera);
+    
+    // Cleanup
+    camera_node_fini(&camera);
+    rcl_shutdown(&context);
+    rcl_context_fini(&context);
+    rcl_init_options_fini(&init_options);
+    
+    RCUTILS_LOG_INFO("Camera node stopped");
+    return result;
+} 
\ No newline at end of file
@@ -0,0 +1,467 @@
+#include "camera_node/camera_rig.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <rcutils/logging_macros.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/primitives_sequence_functions.h>
+#include <rosidl_runtime_c/string_functions.h>
+
+#include "latency_diagnostics/latency_diagnostics.h"
+#include "latency_trace/latency_trace.h"
+
+// Global flag for signal handling
+static volatile sig_atomic_t g_rig_running = 1;
+
+// eventfd used to wake every rig thread out of epoll_wait on shutdown
+static int g_rig_shutdown_fd = -1;
+
+void camera_rig_request_shutdown(void) {
+    g_rig_running = 0;
+    if (g_rig_shutdown_fd != -1) {
+        // write() is async-signal-safe, so this is fine from a signal handler
+        uint64_t one = 1;
+        ssize_t written = write(g_rig_shutdown_fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+static int camera_rig_epoll_add(int epoll_fd, int fd, void* ptr, const char* what) {
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = ptr;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+        RCUTILS_LOG_ERROR("epoll_ctl(%s) failed: %s", what, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+// The fd that says camera has something to capture: its source, or for
+// a source that is always ready, room in its capture queue
+static int camera_rig_capture_fd(camera_node_t* camera) {
+    if (camera->source.fd != -1) {
+        return camera->source.fd;
+    }
+    return frame_queue_space_fd(&camera->capture_queue);
+}
+
+// One FrameSet, reused for every set: the sequences are sized once
+static int camera_rig_init_sync(camera_rig_t* rig) {
+    const camera_config_t* config = &rig->cameras[0].config;
+    if (config->sync_ms == 0) {
+        return 0;
+    }
+
+    if (frame_sync_init(&rig->sync, rig->count, (int64_t)config->sync_ms * 1000000) != 0) {
+        return -1;
+    }
+
+    rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
+    const rosidl_message_type_support_t* type_support =
+        ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg, FrameSet);
+    if (rcl_publisher_init(&rig->set_publisher, &rig->node, type_support,
+                           CAMERA_RIG_SET_TOPIC, &pub_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize frame set publisher");
+        return -1;
+    }
+
+    rig->set_msg = embedded_object_detection_pi5__msg__FrameSet__create();
+    if (!rig->set_msg ||
+        !std_msgs__msg__Header__Sequence__init(&rig->set_msg->headers, rig->count) ||
+        !rosidl_runtime_c__uint32__Sequence__init(&rig->set_msg->capture_sequences, rig->count) ||
+        !rosidl_runtime_c__String__assign(&rig->set_msg->header.frame_id, CAMERA_FRAME_ID)) {
+        RCUTILS_LOG_ERROR("Failed to create frame set message");
+        embedded_object_detection_pi5__msg__FrameSet__destroy(rig->set_msg);
+        rig->set_msg = NULL;
+        rcl_publisher_fini(&rig->set_publisher, &rig->node);
+        return -1;
+    }
+    for (int i = 0; i < rig->count; ++i) {
+        if (!rosidl_runtime_c__String__assign(&rig->set_msg->headers.data[i].frame_id,
+                                              rig->cameras[i].frame_id)) {
+            RCUTILS_LOG_ERROR("Failed to set frame set frame id");
+            embedded_object_detection_pi5__msg__FrameSet__destroy(rig->set_msg);
+            rig->set_msg = NULL;
+            rcl_publisher_fini(&rig->set_publisher, &rig->node);
+            return -1;
+        }
+    }
+
+    pthread_mutex_init(&rig->sync_lock, NULL);
+    rig->use_sync = true;
+    RCUTILS_LOG_INFO("Publishing frame sets of %d cameras within %u ms on %s",
+        rig->count, config->sync_ms, CAMERA_RIG_SET_TOPIC);
+    return 0;
+}
+
+static void camera_rig_fini_sync(camera_rig_t* rig) {
+    if (!rig->use_sync) {
+        return;
+    }
+    RCUTILS_LOG_INFO("Frame sets: %llu from %llu frames, widest spread %.2f ms",
+        (unsigned long long)rig->sync.sets, (unsigned long long)rig->sync.frames,
+        rig->sync.max_spread_ns / 1e6);
+    embedded_object_detection_pi5__msg__FrameSet__destroy(rig->set_msg);
+    rig->set_msg = NULL;
+    rcl_publisher_fini(&rig->set_publisher, &rig->node);
+    pthread_mutex_destroy(&rig->sync_lock);
+    rig->use_sync = false;
+}
+
+int camera_rig_init(camera_rig_t* rig, rcl_context_t* context, const camera_config_t* cameras,
+                    int count) {
+    memset(rig, 0, sizeof(camera_rig_t));
+    rig->epoll_fd = -1;
+    rig->shutdown_fd = -1;
+    for (int i = 0; i < CAMERA_CONFIG_MAX_CAMERAS; ++i) {
+        rig->workers[i].epoll_fd = -1;
+    }
+    if (count < 1 || count > CAMERA_CONFIG_MAX_CAMERAS) {
+        RCUTILS_LOG_ERROR("A camera rig takes 1-%d cameras, got %d", CAMERA_CONFIG_MAX_CAMERAS, count);
+        return -1;
+    }
+
+    // Initialize ROS2 node, shared by every camera
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    if (rcl_node_init(&rig->node, "camera_node", "", context, &node_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize ROS2 node");
+        return -1;
+    }
+    rig->node_ready = true;
+
+    for (int i = 0; i < count; ++i) {
+        if (camera_node_init_member(&rig->cameras[i], &rig->node, &cameras[i], i) != 0) {
+            camera_rig_fini(rig);
+            return -1;
+        }
+        rig->count++;
+    }
+
+    if (camera_rig_init_sync(rig) != 0) {
+        RCUTILS_LOG_WARN("Frame sets unavailable");
+    }
+
+    rig->shutdown_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    rig->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (rig->shutdown_fd == -1 || rig->epoll_fd == -1) {
+        RCUTILS_LOG_ERROR("Failed to set up capture wait: %s", strerror(errno));
+        camera_rig_fini(rig);
+        return -1;
+    }
+
+    // The shutdown eventfd is never read, so it wakes every thread
+    if (camera_rig_epoll_add(rig->epoll_fd, rig->shutdown_fd, NULL, "shutdown fd") != 0) {
+        camera_rig_fini(rig);
+        return -1;
+    }
+    for (int i = 0; i < rig->count; ++i) {
+        camera_node_t* camera = &rig->cameras[i];
+        camera_rig_worker_t* worker = &rig->workers[i];
+        worker->rig = rig;
+        worker->index = i;
+        worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (worker->epoll_fd == -1 ||
+            camera_rig_epoll_add(rig->epoll_fd, camera_rig_capture_fd(camera), camera, "source fd") != 0 ||
+            camera_rig_epoll_add(worker->epoll_fd, frame_queue_event_fd(&camera->capture_queue),
+                                 camera, "queue fd") != 0 ||
+            camera_rig_epoll_add(worker->epoll_fd, rig->shutdown_fd, NULL, "shutdown fd") != 0) {
+            RCUTILS_LOG_ERROR("Failed to set up camera %d wait", i);
+            camera_rig_fini(rig);
+            return -1;
+        }
+    }
+    g_rig_shutdown_fd = rig->shutdown_fd;
+
+    // Start the sources last so no driver buffers pile up during setup
+    for (int i = 0; i < rig->count; ++i) {
+        if (frame_source_start(&rig->cameras[i].source) != 0) {
+            RCUTILS_LOG_ERROR("Failed to start frame source of camera %d", i);
+            camera_rig_fini(rig);
+            return -1;
+        }
+        rig->capturing[i] = true;
+        rig->active++;
+    }
+
+    RCUTILS_LOG_INFO("Camera node initialized with %d cameras", rig->count);
+    return 0;
+}
+
+void camera_rig_fini(camera_rig_t* rig) {
+    if (g_rig_shutdown_fd == rig->shutdown_fd) {
+        g_rig_shutdown_fd = -1;
+    }
+
+    camera_rig_fini_sync(rig);
+    for (int i = 0; i < rig->count; ++i) {
+        camera_node_fini(&rig->cameras[i]);
+    }
+    rig->count = 0;
+
+    for (int i = 0; i < CAMERA_CONFIG_MAX_CAMERAS; ++i) {
+        if (rig->workers[i].epoll_fd != -1) {
+            close(rig->workers[i].epoll_fd);
+            rig->workers[i].epoll_fd = -1;
+        }
+    }
+    if (rig->epoll_fd != -1) {
+        close(rig->epoll_fd);
+        rig->epoll_fd = -1;
+    }
+    if (rig->shutdown_fd != -1) {
+        close(rig->shutdown_fd);
+        rig->shutdown_fd = -1;
+    }
+
+    if (rig->node_ready) {
+        rcl_node_fini(&rig->node);
+        rig->node_ready = false;
+    }
+}
+
+// Publish thread, sync_lock held: announce a complete set
+static void camera_rig_publish_set(camera_rig_t* rig, const frame_sync_set_t* set) {
+    embedded_object_detection_pi5__msg__FrameSet* msg = rig->set_msg;
+    latency_stamp_from_monotonic(&msg->header.stamp, set->earliest_ns);
+    for (int i = 0; i < rig->count; ++i) {
+        latency_stamp_from_monotonic(&msg->headers.data[i].stamp, set->frames[i].stamp_ns);
+        msg->capture_sequences.data[i] = set->frames[i].sequence;
+    }
+    msg->spread_ns = set->spread_ns;
+    if (rcl_publish(&rig->set_publisher, msg, NULL) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to publish frame set");
+    }
+}
+
+// Publish thread: publish everything in camera index's capture queue and
+// offer each frame for a set
+static void camera_rig_drain_queue(camera_rig_t* rig, int index) {
+    camera_node_t* camera = &rig->cameras[index];
+    frame_queue_frame_t* frame;
+    while ((frame = frame_queue_pop(&camera->capture_queue)) != NULL) {
+        if (camera_node_publish_queued(camera, frame) == 0 && rig->use_sync) {
+            frame_sync_set_t set;
+            pthread_mutex_lock(&rig->sync_lock);
+            if (frame_sync_add(&rig->sync, index, frame->sequence, frame->stamp_ns, &set)) {
+                camera_rig_publish_set(rig, &set);
+            }
+            pthread_mutex_unlock(&rig->sync_lock);
+        }
+        frame_queue_release(&camera->capture_queue, frame);
+    }
+}
+
+static void* camera_rig_publish_thread(void* arg) {
+    camera_rig_worker_t* worker = (camera_rig_worker_t*)arg;
+    camera_rig_t* rig = worker->rig;
+    camera_node_t* camera = &rig->cameras[worker->index];
+    struct epoll_event events[2];
+
+    while (g_rig_running) {
+        int n = epoll_wait(worker->epoll_fd, events, 2, CAMERA_WAIT_TIMEOUT_MS);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RCUTILS_LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+            camera_rig_request_shutdown();
+            break;
+        }
+
+        bool frames_ready = false;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.ptr == NULL) {
+                g_rig_running = 0;
+            } else {
+                frames_ready = true;
+            }
+        }
+
+        if (!g_rig_running || !frames_ready) {
+            continue;
+        }
+
+        // Reset the wakeup before draining, so a frame queued meanwhile
+        // either gets popped below or signals again
+        frame_queue_clear_event(&camera->capture_queue);
+        camera_rig_drain_queue(rig, worker->index);
+    }
+    return NULL;
+}
+
+// Capture thread: stop waiting on a camera that failed or is done
+static void camera_rig_stop_camera(camera_rig_t* rig, int index) {
+    if (!rig->capturing[index]) {
+        return;
+    }
+    camera_node_t* camera = &rig->cameras[index];
+    epoll_ctl(rig->epoll_fd, EPOLL_CTL_DEL, camera_rig_capture_fd(camera), NULL);
+    rig->capturing[index] = false;
+    rig->active--;
+}
+
+// Capture thread: rates since the last call and drops so far, per camera
+static void camera_rig_log_stats(camera_rig_t* rig, int64_t now_ns) {
+    double seconds = (now_ns - rig->stats_ns) / 1e9;
+    for (int i = 0; i < rig->count; ++i) {
+        camera_node_t* camera = &rig->cameras[i];
+        uint64_t captured = camera->frames_captured;
+        uint64_t published = __atomic_load_n(&camera->frames_published, __ATOMIC_RELAXED);
+        frame_queue_stats_t queue;
+        frame_queue_get_stats(&camera->capture_queue, &queue);
+        RCUTILS_LOG_INFO("%s: %.1f fps captured, %.1f fps published, %llu driver drops, "
+            "%llu corrupt, %llu queue drops, %llu ring drops%s",
+            camera->frame_id,
+            seconds > 0.0 ? (captured - rig->stats_captured[i]) / seconds : 0.0,
+            seconds > 0.0 ? (published - rig->stats_published[i]) / seconds : 0.0,
+            (unsigned long long)camera->source.drops,
+            (unsigned long long)camera->source.corrupt,
+            (unsigned long long)(queue.dropped_oldest + queue.dropped_newest),
+            (unsigned long long)__atomic_load_n(&camera->ring_drops, __ATOMIC_RELAXED),
+            rig->capturing[i] ? "" : " (stopped)");
+        rig->stats_captured[i] = captured;
+        rig->stats_published[i] = published;
+    }
+
+    if (rig->use_sync) {
+        pthread_mutex_lock(&rig->sync_lock);
+        uint64_t sets = rig->sync.sets;
+        uint64_t frames = rig->sync.frames;
+        int64_t max_spread_ns = rig->sync.max_spread_ns;
+        pthread_mutex_unlock(&rig->sync_lock);
+        RCUTILS_LOG_INFO("Frame sets: %llu from %llu frames, widest spread %.2f ms",
+            (unsigned long long)sets, (unsigned long long)frames, max_spread_ns / 1e6);
+    }
+    rig->stats_ns = now_ns;
+}
+
+int camera_rig_spin(camera_rig_t* rig) {
+    struct epoll_event events[CAMERA_CONFIG_MAX_CAMERAS + 1];
+
+    rig->result = 0;
+    for (int i = 0; i < rig->count; ++i) {
+        camera_rig_worker_t* worker = &rig->workers[i];
+        if (pthread_create(&worker->thread, NULL, camera_rig_publish_thread, worker) != 0) {
+            RCUTILS_LOG_ERROR("Failed to start publish thread of camera %d", i);
+            rig->result = -1;
+            camera_rig_request_shutdown();
+            break;
+        }
+        worker->thread_running = true;
+    }
+
+    // This thread captures for every camera; it only ever copies frames
+    // into the capture queues, so one core keeps up with all of them
+    int64_t start_ns = latency_monotonic_ns();
+    rig->stats_ns = start_ns;
+    while (g_rig_running && rig->active > 0) {
+        int n = epoll_wait(rig->epoll_fd, events, CAMERA_CONFIG_MAX_CAMERAS + 1, CAMERA_WAIT_TIMEOUT_MS);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RCUTILS_LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+            rig->result = -1;
+            break;
+        }
+
+        if (n == 0) {
+            RCUTILS_LOG_WARN("No frame from any of %d cameras in %d ms", rig->active,
+                CAMERA_WAIT_TIMEOUT_MS);
+        }
+
+        for (int i = 0; i < n; ++i) {
+            camera_node_t* camera = (camera_node_t*)events[i].data.ptr;
+            if (!camera) {
+                g_rig_running = 0;
+                continue;
+            }
+            int index = camera->index;
+            if (!rig->capturing[index]) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                RCUTILS_LOG_ERROR("Camera %d (%s) reported an error, dropping it",
+                    index, frame_source_name(&camera->source));
+                camera->capture_result = -1;
+                camera_rig_stop_camera(rig, index);
+                continue;
+            }
+            if (!(events[i].events & EPOLLIN)) {
+                continue;
+            }
+
+            // Reset the space wakeup before filling the queue, so a pop
+            // meanwhile either leaves room below or signals again
+            if (camera->capture_queue.policy == FRAME_QUEUE_WAIT) {
+                frame_queue_clear_space(&camera->capture_queue);
+            }
+
+            // Drain every buffer the driver has completed. A failed dequeue
+            // (device unplugged, EIO) would keep the fd readable forever, so
+            // the camera leaves the epoll set like one that reports EPOLLERR.
+            int got;
+            while ((got = camera_node_capture_frame(camera)) > 0) {
+            }
+            if (got < 0) {
+                RCUTILS_LOG_ERROR("Camera %d (%s) failed to capture, dropping it",
+                    index, frame_source_name(&camera->source));
+                camera->capture_result = -1;
+                camera_rig_stop_camera(rig, index);
+                continue;
+            }
+
+            if (camera->config.max_frames && camera->frames_captured >= camera->config.max_frames) {
+                RCUTILS_LOG_INFO("Camera %d captured %u frames, stopping", index,
+                    camera->config.max_frames);
+                camera->capture_finished = true;
+                camera_rig_stop_camera(rig, index);
+            }
+        }
+
+        int64_t now_ns = latency_monotonic_ns();
+        if (now_ns - rig->stats_ns >= (int64_t)CAMERA_RIG_STATS_INTERVAL_MS * 1000000) {
+            camera_rig_log_stats(rig, now_ns);
+        }
+    }
+
+    if (rig->active == 0 && g_rig_running) {
+        RCUTILS_LOG_INFO("Every camera has stopped");
+    }
+    camera_rig_request_shutdown();
+    for (int i = 0; i < rig->count; ++i) {
+        if (rig->workers[i].thread_running) {
+            pthread_join(rig->workers[i].thread, NULL);
+            rig->workers[i].thread_running = false;
+        }
+    }
+
+    // Publish what a frame limit left queued so the rates cover every
+    // captured frame
+    double seconds = (latency_monotonic_ns() - start_ns) / 1e9;
+    int failed = 0;
+    for (int i = 0; i < rig->count; ++i) {
+        camera_node_t* camera = &rig->cameras[i];
+        failed += camera->capture_result != 0;
+        if (camera->capture_finished) {
+            camera_rig_drain_queue(rig, i);
+        }
+        RCUTILS_LOG_INFO("%s: published %llu frames from %s in %.2f s (%.1f fps)%s",
+            camera->frame_id, (unsigned long long)camera->frames_published,
+            frame_source_name(&camera->source), seconds,
+            seconds > 0.0 ? camera->frames_published / seconds : 0.0,
+            camera->capture_result != 0 ? ", stopped on a capture error" : "");
+    }
+
+    // One failed camera is dropped; the rig only fails if none are left
+    if (failed == rig->count) {
+        rig->result = -1;
+    }
+    return rig->result;
+}
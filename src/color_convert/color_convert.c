@@ -0,0 +1,172 @@
+#include "color_convert/color_convert.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <rcutils/logging_macros.h>
+
+#if defined(__aarch64__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static inline uint8_t clamp_u8(int value) {
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Reference implementation; the SIMD kernels use it for row tails
+void yuyv_to_rgb24_row_scalar(const uint8_t* src, uint8_t* dst, int x_begin, int width) {
+    for (int x = x_begin; x < width; x += 2) {
+        const uint8_t* p = src + x * 2;
+        uint8_t* q = dst + x * 3;
+
+        int d = p[1] - 128;
+        int e = p[3] - 128;
+
+        // Convert YUV to RGB for first pixel
+        int c1 = p[0] - 16;
+        q[0] = clamp_u8((298 * c1 + 409 * e + 128) >> 8);
+        q[1] = clamp_u8((298 * c1 - 100 * d - 208 * e + 128) >> 8);
+        q[2] = clamp_u8((298 * c1 + 516 * d + 128) >> 8);
+
+        // The last macropixel of an odd-width row only carries one pixel
+        if (x + 1 >= width) {
+            break;
+        }
+
+        // Convert YUV to RGB for second pixel
+        int c2 = p[2] - 16;
+        q[3] = clamp_u8((298 * c2 + 409 * e + 128) >> 8);
+        q[4] = clamp_u8((298 * c2 - 100 * d - 208 * e + 128) >> 8);
+        q[5] = clamp_u8((298 * c2 + 516 * d + 128) >> 8);
+    }
+}
+
+void yuyv_to_rgb24_scalar(const uint8_t* src, int src_stride,
+                          uint8_t* dst, int dst_stride, int width, int height) {
+    for (int y = 0; y < height; y++) {
+        yuyv_to_rgb24_row_scalar(src + (size_t)y * src_stride,
+                                 dst + (size_t)y * dst_stride, 0, width);
+    }
+}
+
+static const char* const g_isa_names[COLOR_CONVERT_ISA_COUNT] = {
+    "scalar", "sse2", "avx2", "neon"
+};
+
+const char* color_convert_isa_name(color_convert_isa_t isa) {
+    if (isa < 0 || isa >= COLOR_CONVERT_ISA_COUNT) {
+        return "unknown";
+    }
+    return g_isa_names[isa];
+}
+
+yuyv_to_rgb24_fn color_convert_get_yuyv_to_rgb24(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return yuyv_to_rgb24_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        case COLOR_CONVERT_ISA_SSE2:
+            return yuyv_to_rgb24_sse2;
+        case COLOR_CONVERT_ISA_AVX2:
+            return yuyv_to_rgb24_avx2;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+            return yuyv_to_rgb24_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+static bool color_convert_isa_supported(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case COLOR_CONVERT_ISA_SSE2:
+            return __builtin_cpu_supports("sse2");
+        case COLOR_CONVERT_ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+#if defined(__aarch64__)
+            return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#else
+            return true; // Built with -mfpu=neon
+#endif
+#endif
+        default:
+            return false;
+    }
+}
+
+color_convert_isa_t color_convert_detect_isa(void) {
+    static const color_convert_isa_t preference[] = {
+        COLOR_CONVERT_ISA_AVX2, COLOR_CONVERT_ISA_NEON, COLOR_CONVERT_ISA_SSE2
+    };
+
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); ++i) {
+        if (color_convert_get_yuyv_to_rgb24(preference[i]) &&
+            color_convert_isa_supported(preference[i])) {
+            return preference[i];
+        }
+    }
+    return COLOR_CONVERT_ISA_SCALAR;
+}
+
+static pthread_once_t g_dispatch_once = PTHREAD_ONCE_INIT;
+static color_convert_isa_t g_active_isa = COLOR_CONVERT_ISA_SCALAR;
+static yuyv_to_rgb24_fn g_yuyv_to_rgb24 = yuyv_to_rgb24_scalar;
+
+static void color_convert_init_dispatch(void) {
+    color_convert_isa_t isa = color_convert_detect_isa();
+
+    // COLOR_CONVERT_ISA=scalar|sse2|avx2|neon pins a kernel for comparisons
+    const char* forced = getenv("COLOR_CONVERT_ISA");
+    if (forced) {
+        for (int i = 0; i < COLOR_CONVERT_ISA_COUNT; ++i) {
+            if (strcmp(forced, g_isa_names[i]) == 0 &&
+                color_convert_get_yuyv_to_rgb24((color_convert_isa_t)i) &&
+                color_convert_isa_supported((color_convert_isa_t)i)) {
+                isa = (color_convert_isa_t)i;
+            }
+        }
+    }
+
+    g_active_isa = isa;
+    g_yuyv_to_rgb24 = color_convert_get_yuyv_to_rgb24(isa);
+    RCUTILS_LOG_INFO("Color conversion using %s kernels", g_isa_names[isa]);
+}
+
+color_convert_isa_t color_convert_active_isa(void) {
+    pthread_once(&g_dispatch_once, color_convert_init_dispatch);
+    return g_active_isa;
+}
+
+int color_convert_set_isa(color_convert_isa_t isa) {
+    pthread_once(&g_dispatch_once, color_convert_init_dispatch);
+
+    yuyv_to_rgb24_fn fn = color_convert_get_yuyv_to_rgb24(isa);
+    if (!fn || !color_convert_isa_supported(isa)) {
+        return -1;
+    }
+    g_active_isa = isa;
+    g_yuyv_to_rgb24 = fn;
+    return 0;
+}
+
+void yuyv_to_rgb24_strided(const uint8_t* src, int src_stride,
+                           uint8_t* dst, int dst_stride,
+                           int width, int height) {
+    pthread_once(&g_dispatch_once, color_convert_init_dispatch);
+    g_yuyv_to_rgb24(src, src_stride, dst, dst_stride, width, height);
+}
+
+// YUYV to RGB24 conversion function
+void yuyv_to_rgb24(const uint8_t* yuyv_data, uint8_t* rgb_data, int width, int height) {
+    yuyv_to_rgb24_strided(yuyv_data, ((width + 1) / 2) * 4, rgb_data, width * 3, width, height);
+}
@@ -0,0 +1,27 @@
+#include "color_convert/color_convert.h"
+#include "worker_pool/worker_pool.h"
+#include <stddef.h>
+
+typedef struct {
+    const uint8_t* src;
+    int src_stride;
+    uint8_t* dst;
+    int dst_stride;
+    int width;
+} yuyv_to_rgb24_job_t;
+
+static void yuyv_to_rgb24_band(void* ctx, int row_begin, int row_end) {
+    const yuyv_to_rgb24_job_t* job = (const yuyv_to_rgb24_job_t*)ctx;
+    yuyv_to_rgb24_strided(job->src + (size_t)row_begin * job->src_stride, job->src_stride,
+                          job->dst + (size_t)row_begin * job->dst_stride, job->dst_stride,
+                          job->width, row_end - row_begin);
+}
+
+void yuyv_to_rgb24_parallel(struct worker_pool* pool,
+                            const uint8_t* src, int src_stride,
+                            uint8_t* dst, int dst_stride,
+                            int width, int height) {
+    yuyv_to_rgb24_job_t job = { src, src_stride, dst, dst_stride, width };
+    size_t bytes_per_row = (size_t)src_stride + (size_t)width * 3;
+    worker_pool_run_bands(pool, height, bytes_per_row, yuyv_to_rgb24_band, &job);
+}
@@ -0,0 +1,81 @@
+#include "color_convert/color_convert.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <stddef.h>
+#include <arm_neon.h>
+
+// Same fixed-point math as the scalar reference, evaluated in 32-bit
+// lanes. vqmovn_s32 + vqmovun_s16 perform the [0, 255] clamp.
+
+// clamp((298 * c + ka * a + 128) >> 8) for 8 pixels
+static inline uint8x8_t neon_channel1(int16x8_t c, int16x8_t a, int16_t ka) {
+    const int32x4_t round = vdupq_n_s32(128);
+
+    int32x4_t lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(c), 298), vget_low_s16(a), ka);
+    int32x4_t hi = vmlal_n_s16(vmull_n_s16(vget_high_s16(c), 298), vget_high_s16(a), ka);
+
+    int16x8_t narrowed = vcombine_s16(vqmovn_s32(vshrq_n_s32(vaddq_s32(lo, round), 8)),
+                                      vqmovn_s32(vshrq_n_s32(vaddq_s32(hi, round), 8)));
+    return vqmovun_s16(narrowed);
+}
+
+// clamp((298 * c + ka * a + kb * b + 128) >> 8) for 8 pixels
+static inline uint8x8_t neon_channel2(int16x8_t c, int16x8_t a, int16_t ka,
+                                      int16x8_t b, int16_t kb) {
+    const int32x4_t round = vdupq_n_s32(128);
+
+    int32x4_t lo = vmull_n_s16(vget_low_s16(c), 298);
+    lo = vmlal_n_s16(lo, vget_low_s16(a), ka);
+    lo = vmlal_n_s16(lo, vget_low_s16(b), kb);
+
+    int32x4_t hi = vmull_n_s16(vget_high_s16(c), 298);
+    hi = vmlal_n_s16(hi, vget_high_s16(a), ka);
+    hi = vmlal_n_s16(hi, vget_high_s16(b), kb);
+
+    int16x8_t narrowed = vcombine_s16(vqmovn_s32(vshrq_n_s32(vaddq_s32(lo, round), 8)),
+                                      vqmovn_s32(vshrq_n_s32(vaddq_s32(hi, round), 8)));
+    return vqmovun_s16(narrowed);
+}
+
+static inline uint8x16_t neon_zip(uint8x8_t even, uint8x8_t odd) {
+    uint8x8x2_t z = vzip_u8(even, odd);
+    return vcombine_u8(z.val[0], z.val[1]);
+}
+
+void yuyv_to_rgb24_neon(const uint8_t* src, int src_stride,
+                        uint8_t* dst, int dst_stride, int width, int height) {
+    const int block = 16;
+    int simd_width = width & ~(block - 1);
+    const uint8x8_t k16 = vdup_n_u8(16);
+    const uint8x8_t k128 = vdup_n_u8(128);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* s = src + (size_t)y * src_stride;
+        uint8_t* d = dst + (size_t)y * dst_stride;
+
+        for (int x = 0; x < simd_width; x += block) {
+            // De-interleave 8 macropixels: Y0[8], U[8], Y1[8], V[8]
+            uint8x8x4_t yuyv = vld4_u8(s + x * 2);
+
+            // Unsigned widening subtract wraps; reinterpreting as signed
+            // yields the intended negative values
+            int16x8_t c0 = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[0], k16));
+            int16x8_t c1 = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[2], k16));
+            int16x8_t du = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[1], k128));
+            int16x8_t ev = vreinterpretq_s16_u16(vsubl_u8(yuyv.val[3], k128));
+
+            uint8x16x3_t rgb;
+            rgb.val[0] = neon_zip(neon_channel1(c0, ev, 409), neon_channel1(c1, ev, 409));
+            rgb.val[1] = neon_zip(neon_channel2(c0, du, -100, ev, -208),
+                                  neon_channel2(c1, du, -100, ev, -208));
+            rgb.val[2] = neon_zip(neon_channel1(c0, du, 516), neon_channel1(c1, du, 516));
+
+            vst3q_u8(d + x * 3, rgb);
+        }
+
+        yuyv_to_rgb24_row_scalar(s, d, simd_width, width);
+    }
+}
+
+#endif // __ARM_NEON
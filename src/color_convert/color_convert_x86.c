@@ -0,0 +1,224 @@
+#include "color_convert/color_convert.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <stddef.h>
+#include <immintrin.h>
+
+// The fixed-point formulas are evaluated in 32-bit lanes with pmaddwd, which
+// multiplies 16-bit pairs and sums them. Folding the -16/-128 offsets and
+// the +128 rounding term into one constant per channel keeps the result
+// exactly equal to the scalar reference:
+//
+//   R = (298*Y + 409*V            - 56992) >> 8
+//   G = (298*Y - 100*U - 208*V    + 34784) >> 8
+//   B = (298*Y + 516*U            - 70688) >> 8
+//
+// packssdw + packuswb then perform the [0, 255] clamp.
+#define YUV_K_R (-298 * 16 - 409 * 128 + 128)
+#define YUV_K_G (-298 * 16 + 100 * 128 + 208 * 128 + 128)
+#define YUV_K_B (-298 * 16 - 516 * 128 + 128)
+
+// 16-bit pair (lo, hi) replicated across a vector, as pmaddwd coefficients
+#define COEFF_PAIR(lo, hi) ((int)(((uint32_t)(uint16_t)(hi) << 16) | (uint16_t)(lo)))
+
+// Shuffle each 4 x 16-bit macropixel [Y0 U Y1 V] within both 64-bit halves
+#define SHUF_YU _MM_SHUFFLE(1, 2, 1, 0)   // [Y0 U Y1 U]
+#define SHUF_YV _MM_SHUFFLE(3, 2, 3, 0)   // [Y0 V Y1 V]
+#define SHUF_VV _MM_SHUFFLE(3, 3, 3, 3)   // [V  V V  V]
+
+// ---------------------------------------------------------------------------
+// SSE2
+// ---------------------------------------------------------------------------
+
+// Four pixels (two macropixels, widened to 16 bit) -> R, G, B as int32
+static inline void sse2_yuv_to_rgb32(__m128i v, __m128i* r, __m128i* g, __m128i* b) {
+    const __m128i c_r = _mm_set1_epi32(COEFF_PAIR(298, 409));
+    const __m128i c_g_yu = _mm_set1_epi32(COEFF_PAIR(298, -100));
+    const __m128i c_g_v = _mm_set1_epi32(COEFF_PAIR(-208, 0));
+    const __m128i c_b = _mm_set1_epi32(COEFF_PAIR(298, 516));
+
+    __m128i yu = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, SHUF_YU), SHUF_YU);
+    __m128i yv = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, SHUF_YV), SHUF_YV);
+    __m128i vv = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, SHUF_VV), SHUF_VV);
+
+    *r = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yv, c_r), _mm_set1_epi32(YUV_K_R)), 8);
+    *g = _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yu, c_g_yu),
+                                                    _mm_madd_epi16(vv, c_g_v)),
+                                      _mm_set1_epi32(YUV_K_G)), 8);
+    *b = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yu, c_b), _mm_set1_epi32(YUV_K_B)), 8);
+}
+
+// Eight pixels (16 YUYV bytes) -> R, G, B as saturated int16
+static inline void sse2_convert8(__m128i in, __m128i* r, __m128i* g, __m128i* b) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r0, g0, b0, r1, g1, b1;
+
+    sse2_yuv_to_rgb32(_mm_unpacklo_epi8(in, zero), &r0, &g0, &b0);
+    sse2_yuv_to_rgb32(_mm_unpackhi_epi8(in, zero), &r1, &g1, &b1);
+
+    *r = _mm_packs_epi32(r0, r1);
+    *g = _mm_packs_epi32(g0, g1);
+    *b = _mm_packs_epi32(b0, b1);
+}
+
+// Squeeze 4 RGB0 pixels into 12 bytes (top 4 bytes zero)
+static inline __m128i sse2_pack_rgb0(__m128i x) {
+    const __m128i m_p0 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0x00FFFFFF);
+    const __m128i m_p1 = _mm_set_epi32(0x0000FFFF, (int)0xFF000000, 0x0000FFFF, (int)0xFF000000);
+    const __m128i m_lo6 = _mm_set_epi32(0, 0, 0x0000FFFF, (int)0xFFFFFFFF);
+    const __m128i m_hi6 = _mm_set_epi32(0, (int)0xFFFFFFFF, (int)0xFFFF0000, 0);
+
+    // Each 64-bit lane: p0 | p1 << 32 -> p0 | p1 << 24
+    __m128i t = _mm_or_si128(_mm_and_si128(x, m_p0),
+                             _mm_and_si128(_mm_srli_epi64(x, 8), m_p1));
+    // Close the 2-byte gap between the lanes
+    return _mm_or_si128(_mm_and_si128(t, m_lo6),
+                        _mm_and_si128(_mm_srli_si128(t, 2), m_hi6));
+}
+
+// Interleave 16 R, G, B bytes into 48 bytes of RGB24
+static inline void sse2_store_rgb24(uint8_t* dst, __m128i r, __m128i g, __m128i b) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+    __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+    __m128i b0_lo = _mm_unpacklo_epi8(b, zero);
+    __m128i b0_hi = _mm_unpackhi_epi8(b, zero);
+
+    __m128i c0 = sse2_pack_rgb0(_mm_unpacklo_epi16(rg_lo, b0_lo));
+    __m128i c1 = sse2_pack_rgb0(_mm_unpackhi_epi16(rg_lo, b0_lo));
+    __m128i c2 = sse2_pack_rgb0(_mm_unpacklo_epi16(rg_hi, b0_hi));
+    __m128i c3 = sse2_pack_rgb0(_mm_unpackhi_epi16(rg_hi, b0_hi));
+
+    _mm_storeu_si128((__m128i*)(dst + 0), _mm_or_si128(c0, _mm_slli_si128(c1, 12)));
+    _mm_storeu_si128((__m128i*)(dst + 16), _mm_or_si128(_mm_srli_si128(c1, 4), _mm_slli_si128(c2, 8)));
+    _mm_storeu_si128((__m128i*)(dst + 32), _mm_or_si128(_mm_srli_si128(c2, 8), _mm_slli_si128(c3, 4)));
+}
+
+void yuyv_to_rgb24_sse2(const uint8_t* src, int src_stride,
+                        uint8_t* dst, int dst_stride, int width, int height) {
+    const int block = 16;
+    int simd_width = width & ~(block - 1);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* s = src + (size_t)y * src_stride;
+        uint8_t* d = dst + (size_t)y * dst_stride;
+
+        for (int x = 0; x < simd_width; x += block) {
+            __m128i r0, g0, b0, r1, g1, b1;
+            sse2_convert8(_mm_loadu_si128((const __m128i*)(s + x * 2)), &r0, &g0, &b0);
+            sse2_convert8(_mm_loadu_si128((const __m128i*)(s + x * 2 + 16)), &r1, &g1, &b1);
+
+            sse2_store_rgb24(d + x * 3,
+                             _mm_packus_epi16(r0, r1),
+                             _mm_packus_epi16(g0, g1),
+                             _mm_packus_epi16(b0, b1));
+        }
+
+        yuyv_to_rgb24_row_scalar(s, d, simd_width, width);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+// Sixteen pixels (32 YUYV bytes) -> R, G, B as saturated int16, with
+// pixels 0-7 in the low 128-bit lane and 8-15 in the high lane
+static inline AVX2_TARGET void avx2_convert16(__m256i in, __m256i* r, __m256i* g, __m256i* b) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c_r = _mm256_set1_epi32(COEFF_PAIR(298, 409));
+    const __m256i c_g_yu = _mm256_set1_epi32(COEFF_PAIR(298, -100));
+    const __m256i c_g_v = _mm256_set1_epi32(COEFF_PAIR(-208, 0));
+    const __m256i c_b = _mm256_set1_epi32(COEFF_PAIR(298, 516));
+    const __m256i k_r = _mm256_set1_epi32(YUV_K_R);
+    const __m256i k_g = _mm256_set1_epi32(YUV_K_G);
+    const __m256i k_b = _mm256_set1_epi32(YUV_K_B);
+
+    __m256i halves[2] = { _mm256_unpacklo_epi8(in, zero), _mm256_unpackhi_epi8(in, zero) };
+    __m256i rr[2], gg[2], bb[2];
+
+    for (int i = 0; i < 2; ++i) {
+        __m256i v = halves[i];
+        __m256i yu = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, SHUF_YU), SHUF_YU);
+        __m256i yv = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, SHUF_YV), SHUF_YV);
+        __m256i vv = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, SHUF_VV), SHUF_VV);
+
+        rr[i] = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yv, c_r), k_r), 8);
+        gg[i] = _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu, c_g_yu),
+                                                                    _mm256_madd_epi16(vv, c_g_v)),
+                                                   k_g), 8);
+        bb[i] = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yu, c_b), k_b), 8);
+    }
+
+    *r = _mm256_packs_epi32(rr[0], rr[1]);
+    *g = _mm256_packs_epi32(gg[0], gg[1]);
+    *b = _mm256_packs_epi32(bb[0], bb[1]);
+}
+
+// Interleave 16 R, G, B bytes into 48 bytes of RGB24 with pshufb
+static inline AVX2_TARGET void ssse3_store_rgb24(uint8_t* dst, __m128i r, __m128i g, __m128i b) {
+    const __m128i m0r = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+    const __m128i m0g = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+    const __m128i m0b = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i m1r = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+    const __m128i m1g = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+    const __m128i m1b = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+    const __m128i m2r = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+    const __m128i m2g = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+    const __m128i m2b = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+    __m128i o0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, m0r), _mm_shuffle_epi8(g, m0g)),
+                              _mm_shuffle_epi8(b, m0b));
+    __m128i o1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, m1r), _mm_shuffle_epi8(g, m1g)),
+                              _mm_shuffle_epi8(b, m1b));
+    __m128i o2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, m2r), _mm_shuffle_epi8(g, m2g)),
+                              _mm_shuffle_epi8(b, m2b));
+
+    _mm_storeu_si128((__m128i*)(dst + 0), o0);
+    _mm_storeu_si128((__m128i*)(dst + 16), o1);
+    _mm_storeu_si128((__m128i*)(dst + 32), o2);
+}
+
+AVX2_TARGET void yuyv_to_rgb24_avx2(const uint8_t* src, int src_stride,
+                                    uint8_t* dst, int dst_stride, int width, int height) {
+    const int block = 32;
+    int simd_width = width & ~(block - 1);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* s = src + (size_t)y * src_stride;
+        uint8_t* d = dst + (size_t)y * dst_stride;
+
+        for (int x = 0; x < simd_width; x += block) {
+            __m256i r0, g0, b0, r1, g1, b1;
+            avx2_convert16(_mm256_loadu_si256((const __m256i*)(s + x * 2)), &r0, &g0, &b0);
+            avx2_convert16(_mm256_loadu_si256((const __m256i*)(s + x * 2 + 32)), &r1, &g1, &b1);
+
+            // packus works per lane: [0-7 16-23 | 8-15 24-31] -> restore order
+            __m256i r = _mm256_permute4x64_epi64(_mm256_packus_epi16(r0, r1), _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i g = _mm256_permute4x64_epi64(_mm256_packus_epi16(g0, g1), _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), _MM_SHUFFLE(3, 1, 2, 0));
+
+            ssse3_store_rgb24(d + x * 3,
+                              _mm256_castsi256_si128(r),
+                              _mm256_castsi256_si128(g),
+                              _mm256_castsi256_si128(b));
+            ssse3_store_rgb24(d + x * 3 + 48,
+                              _mm256_extracti128_si256(r, 1),
+                              _mm256_extracti128_si256(g, 1),
+                              _mm256_extracti128_si256(b, 1));
+        }
+
+        // Finish the row with SSE2, then scalar
+        int rest = width - simd_width;
+        if (rest >= 16) {
+            yuyv_to_rgb24_sse2(s + simd_width * 2, 0, d + simd_width * 3, 0, rest, 1);
+        } else {
+            yuyv_to_rgb24_row_scalar(s, d, simd_width, width);
+        }
+    }
+}
+
+#endif // __x86_64__ || __i386__
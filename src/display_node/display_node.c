@@ -4,54 +4,53 @@
 #include <string.h>
 #include <signal.h>
 #include <math.h>
+#include <stdint.h>
+#include <time.h>
 #include <rcutils/logging_macros.h>
 #include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/primitives_sequence_functions.h>
+#include <rosidl_runtime_c/string_functions.h>
+
+#include "display_render/display_intake.h"
+#include "image_message/image_message.h"
 
 // Global flag for signal handling
 static volatile sig_atomic_t g_running = 1;
 
-void signal_handler(int sig) {
-    (void)sig;
+// Latency stages on /diagnostics; the last one is end to end
+enum { DISPLAY_STAGE_TAKE, DISPLAY_STAGE_CONVERT, DISPLAY_STAGE_PRESENT, DISPLAY_STAGE_TOTAL, DISPLAY_STAGES };
+static const char* const g_latency_stages[DISPLAY_STAGES] = {
+    "capture_to_take", "take_to_convert", "convert_to_present", "capture_to_present",
+};
+
+void display_node_request_shutdown(void) {
     g_running = 0;
 }
 
-// YUYV to RGB24 conversion function
-void yuyv_to_rgb24(const uint8_t* yuyv_data, uint8_t* rgb_data, int width, int height) {
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x += 2) {
-            int yuyv_idx = y * width * 2 + x * 2;
-            int rgb_idx = y * width * 3 + x * 3;
-            
-            uint8_t y1 = yuyv_data[yuyv_idx];
-            uint8_t u = yuyv_data[yuyv_idx + 1];
-            uint8_t y2 = yuyv_data[yuyv_idx + 2];
-            uint8_t v = yuyv_data[yuyv_idx + 3];
-            
-            // Convert YUV to RGB for first pixel
-            int c1 = y1 - 16;
-            int d = u - 128;
-            int e = v - 128;
-            
-            int r1 = (298 * c1 + 409 * e + 128) >> 8;
-            int g1 = (298 * c1 - 100 * d - 208 * e + 128) >> 8;
-            int b1 = (298 * c1 + 516 * d + 128) >> 8;
-            
-            rgb_data[rgb_idx] = (uint8_t)(r1 < 0 ? 0 : (r1 > 255 ? 255 : r1));
-            rgb_data[rgb_idx + 1] = (uint8_t)(g1 < 0 ? 0 : (g1 > 255 ? 255 : g1));
-            rgb_data[rgb_idx + 2] = (uint8_t)(b1 < 0 ? 0 : (b1 > 255 ? 255 : b1));
-            
-            // Convert YUV to RGB for second pixel
-            int c2 = y2 - 16;
-            
-            int r2 = (298 * c2 + 409 * e + 128) >> 8;
-            int g2 = (298 * c2 - 100 * d - 208 * e + 128) >> 8;
-            int b2 = (298 * c2 + 516 * d + 128) >> 8;
-            
-            rgb_data[rgb_idx + 3] = (uint8_t)(r2 < 0 ? 0 : (r2 > 255 ? 255 : r2));
-            rgb_data[rgb_idx + 4] = (uint8_t)(g2 < 0 ? 0 : (g2 > 255 ? 255 : g2));
-            rgb_data[rgb_idx + 5] = (uint8_t)(b2 < 0 ? 0 : (b2 > 255 ? 255 : b2));
-        }
+static int64_t display_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// is_running is shared by the intake thread and the render loop
+static bool display_node_running(display_node_t* display) {
+    return g_running && __atomic_load_n(&display->is_running, __ATOMIC_RELAXED);
+}
+
+static void display_node_stop(display_node_t* display) {
+    __atomic_store_n(&display->is_running, false, __ATOMIC_RELAXED);
+    g_running = 0;
+}
+
+// Mosaic grid: as square as possible, filled row by row
+static void display_grid(int count, int* cols, int* rows) {
+    int c = 1;
+    while (c * c < count) {
+        c++;
     }
+    *cols = c;
+    *rows = (count + c - 1) / c;
 }
 
 int sdl2_init_window(display_node_t* display) {
@@ -61,13 +60,15 @@ int sdl2_init_window(display_node_t* display) {
         return -1;
     }
     
-    // Create window
+    // Create window, one DISPLAY_WIDTH x DISPLAY_HEIGHT tile per stream
+    int cols, rows;
+    display_grid(display->stream_count, &cols, &rows);
     display->window = SDL_CreateWindow(
         DISPLAY_TITLE,
         SDL_WINDOWPOS_UNDEFINED,
         SDL_WINDOWPOS_UNDEFINED,
-        DISPLAY_WIDTH,
-        DISPLAY_HEIGHT,
+        cols * DISPLAY_WIDTH + (cols - 1) * DISPLAY_MOSAIC_GAP,
+        rows * DISPLAY_HEIGHT + (rows - 1) * DISPLAY_MOSAIC_GAP,
         SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
     );
     
@@ -77,8 +78,12 @@ int sdl2_init_window(display_node_t* display) {
         return -1;
     }
     
-    // Create renderer
-    display->renderer = SDL_CreateRenderer(display->window, -1, SDL_RENDERER_ACCELERATED);
+    // Create renderer; with vsync SDL_RenderPresent paces the render loop
+    Uint32 renderer_flags = SDL_RENDERER_ACCELERATED;
+    if (DISPLAY_VSYNC) {
+        renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    display->renderer = SDL_CreateRenderer(display->window, -1, renderer_flags);
     if (!display->renderer) {
         RCUTILS_LOG_ERROR("Failed to create SDL renderer: %s", SDL_GetError());
         SDL_DestroyWindow(display->window);
@@ -86,30 +91,37 @@ int sdl2_init_window(display_node_t* display) {
         return -1;
     }
     
-    // Create texture (will be updated with actual image data)
-    display->texture = SDL_CreateTexture(
-        display->renderer,
-        SDL_PIXELFORMAT_RGB24,
-        SDL_TEXTUREACCESS_STREAMING,
-        DISPLAY_WIDTH,
-        DISPLAY_HEIGHT
-    );
+    // Remember which pixel formats the renderer handles natively; textures
+    // are created lazily once the first frame tells us size and encoding
+    if (SDL_GetRendererInfo(display->renderer, &display->renderer_info) != 0) {
+        RCUTILS_LOG_WARN("Failed to query SDL renderer: %s", SDL_GetError());
+        memset(&display->renderer_info, 0, sizeof(display->renderer_info));
+    } else {
+        RCUTILS_LOG_INFO("SDL renderer: %s", display->renderer_info.name);
+    }
+    display->vsync = (display->renderer_info.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
     
-    if (!display->texture) {
-        RCUTILS_LOG_ERROR("Failed to create SDL texture: %s", SDL_GetError());
-        SDL_DestroyRenderer(display->renderer);
-        SDL_DestroyWindow(display->window);
-        SDL_Quit();
-        return -1;
+    // Without vsync the render loop paces itself to the refresh rate
+    SDL_DisplayMode mode;
+    int refresh_rate = 60;
+    if (SDL_GetCurrentDisplayMode(SDL_GetWindowDisplayIndex(display->window), &mode) == 0 &&
+        mode.refresh_rate > 0) {
+        refresh_rate = mode.refresh_rate;
     }
+    display->refresh_interval_ns = 1000000000LL / refresh_rate;
+    RCUTILS_LOG_INFO("Presenting at %d Hz %s", refresh_rate,
+        display->vsync ? "with vsync" : "without vsync (self-paced)");
     
     return 0;
 }
 
 void sdl2_cleanup_window(display_node_t* display) {
-    if (display->texture) {
-        SDL_DestroyTexture(display->texture);
-        display->texture = NULL;
+    for (int i = 0; i < display->stream_count; ++i) {
+        display_stream_t* stream = &display->streams[i];
+        if (stream->texture) {
+            SDL_DestroyTexture(stream->texture);
+            stream->texture = NULL;
+        }
     }
     
     if (display->renderer) {
@@ -125,39 +137,274 @@ void sdl2_cleanup_window(display_node_t* display) {
     SDL_Quit();
 }
 
-int sdl2_update_display(display_node_t* display, const sensor_msgs__msg__Image* msg) {
-    if (!msg || !msg->data.data || !display->texture) {
+// ROS image encodings that map directly onto SDL texture formats
+typedef enum {
+    DISPLAY_LAYOUT_PACKED,      // One plane, bytes_per_pixel per pixel
+    DISPLAY_LAYOUT_YUV422,      // One plane, 4 bytes per 2 pixels
+    DISPLAY_LAYOUT_NV,          // Y plane + interleaved UV plane at half height
+    DISPLAY_LAYOUT_I420         // Y, U, V planes, chroma at half size
+} display_layout_t;
+
+typedef struct {
+    const char* encoding;
+    Uint32 sdl_format;
+    display_layout_t layout;
+    int bytes_per_pixel;
+} display_format_t;
+
+static const display_format_t g_display_formats[] = {
+    { "yuv422_yuy2", SDL_PIXELFORMAT_YUY2,   DISPLAY_LAYOUT_YUV422, 2 },
+    { "yuyv",        SDL_PIXELFORMAT_YUY2,   DISPLAY_LAYOUT_YUV422, 2 },
+    { "yuv422",      SDL_PIXELFORMAT_UYVY,   DISPLAY_LAYOUT_YUV422, 2 },
+    { "uyvy",        SDL_PIXELFORMAT_UYVY,   DISPLAY_LAYOUT_YUV422, 2 },
+    { "nv12",        SDL_PIXELFORMAT_NV12,   DISPLAY_LAYOUT_NV,     1 },
+    { "nv21",        SDL_PIXELFORMAT_NV21,   DISPLAY_LAYOUT_NV,     1 },
+    { "i420",        SDL_PIXELFORMAT_IYUV,   DISPLAY_LAYOUT_I420,   1 },
+    { "rgb8",        SDL_PIXELFORMAT_RGB24,  DISPLAY_LAYOUT_PACKED, 3 },
+    { "bgr8",        SDL_PIXELFORMAT_BGR24,  DISPLAY_LAYOUT_PACKED, 3 },
+    { "rgba8",       SDL_PIXELFORMAT_RGBA32, DISPLAY_LAYOUT_PACKED, 4 },
+    { "bgra8",       SDL_PIXELFORMAT_BGRA32, DISPLAY_LAYOUT_PACKED, 4 },
+};
+
+static const display_format_t* display_find_format(const char* encoding) {
+    if (!encoding) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(g_display_formats) / sizeof(g_display_formats[0]); ++i) {
+        if (strcmp(encoding, g_display_formats[i].encoding) == 0) {
+            return &g_display_formats[i];
+        }
+    }
+    return NULL;
+}
+
+static bool sdl2_renderer_supports(const display_node_t* display, Uint32 format) {
+    for (Uint32 i = 0; i < display->renderer_info.num_texture_formats; ++i) {
+        if (display->renderer_info.texture_formats[i] == format) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Check that msg->step and msg->data.size cover the layout
+static bool display_frame_fits(const display_format_t* fmt, const sensor_msgs__msg__Image* msg) {
+    size_t step = msg->step;
+    size_t height = msg->height;
+    size_t chroma_rows = (height + 1) / 2;
+    size_t min_step;
+    size_t needed;
+    
+    switch (fmt->layout) {
+        case DISPLAY_LAYOUT_YUV422:
+            min_step = ((size_t)(msg->width + 1) / 2) * 4;
+            needed = step * height;
+            break;
+        case DISPLAY_LAYOUT_NV:
+            min_step = msg->width;
+            needed = step * height + step * chroma_rows;
+            break;
+        case DISPLAY_LAYOUT_I420:
+            min_step = msg->width;
+            needed = step * height + 2 * ((step + 1) / 2) * chroma_rows;
+            break;
+        default:
+            min_step = (size_t)msg->width * fmt->bytes_per_pixel;
+            needed = step * height;
+            break;
+    }
+    
+    return step >= min_step && msg->data.size >= needed;
+}
+
+// (Re)create the streaming texture when size or pixel format changes.
+// Returns 1 if the texture is new, so holds no frame yet.
+static int sdl2_ensure_texture(display_node_t* display, display_stream_t* stream, Uint32 format,
+                               int width, int height) {
+    if (stream->texture && stream->texture_format == format &&
+        stream->texture_width == width && stream->texture_height == height) {
+        return 0;
+    }
+    
+    if (stream->texture) {
+        SDL_DestroyTexture(stream->texture);
+        stream->texture = NULL;
+    }
+    
+    stream->texture = SDL_CreateTexture(display->renderer, format,
+                                        SDL_TEXTUREACCESS_STREAMING, width, height);
+    if (!stream->texture) {
+        RCUTILS_LOG_ERROR("Failed to create %dx%d %s texture: %s", width, height,
+            SDL_GetPixelFormatName(format), SDL_GetError());
         return -1;
     }
     
-    // Update texture with new image data
+    stream->texture_format = format;
+    stream->texture_width = width;
+    stream->texture_height = height;
+    RCUTILS_LOG_INFO("Created %dx%d %s texture for %s", width, height,
+        SDL_GetPixelFormatName(format), stream->image_topic);
+    return 1;
+}
+
+// Upload a frame without touching the pixels on the CPU: the renderer
+// samples (and for YUV formats converts) the raw bytes on the GPU.
+// Single-plane formats upload only the rows in band.
+static int sdl2_upload_native(SDL_Texture* texture, const display_format_t* fmt,
+                              const sensor_msgs__msg__Image* msg, const SDL_Rect* band) {
+    const uint8_t* data = msg->data.data;
+    int step = (int)msg->step;
+    int rc;
+    
+    switch (fmt->layout) {
+        case DISPLAY_LAYOUT_NV: {
+            const uint8_t* uv = data + (size_t)step * msg->height;
+            rc = SDL_UpdateNVTexture(texture, NULL, data, step, uv, step);
+            break;
+        }
+        case DISPLAY_LAYOUT_I420: {
+            int chroma_step = (step + 1) / 2;
+            const uint8_t* u = data + (size_t)step * msg->height;
+            const uint8_t* v = u + (size_t)chroma_step * ((msg->height + 1) / 2);
+            rc = SDL_UpdateYUVTexture(texture, NULL, data, step, u, chroma_step, v, chroma_step);
+            break;
+        }
+        default:
+            rc = SDL_UpdateTexture(texture, band, data + (size_t)step * band->y, step);
+            break;
+    }
+    
+    if (rc != 0) {
+        RCUTILS_LOG_ERROR("Failed to update texture: %s", SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+// Fallback for renderers without YUY2 support: convert on the CPU straight
+// into the locked RGB24 texture, honouring both strides. Locking a band
+// leaves the rest of the texture as it was; every locked pixel is written.
+static int sdl2_upload_yuyv_converted(display_node_t* display, SDL_Texture* texture,
+                                      const sensor_msgs__msg__Image* msg, const SDL_Rect* band) {
     void* pixels;
     int pitch;
     
-    if (SDL_LockTexture(display->texture, NULL, &pixels, &pitch) != 0) {
+    if (SDL_LockTexture(texture, band, &pixels, &pitch) != 0) {
         RCUTILS_LOG_ERROR("Failed to lock texture: %s", SDL_GetError());
         return -1;
     }
     
-    // Check if we need to convert YUYV to RGB
-    if (strcmp(msg->encoding.data, "yuv422_yuy2") == 0) {
-        // Convert YUYV to RGB24
-        yuyv_to_rgb24(msg->data.data, (uint8_t*)pixels, msg->width, msg->height);
-    } else {
-        // Direct copy for RGB formats
-        memcpy(pixels, msg->data.data, msg->data.size);
+    yuyv_to_rgb24_parallel(&display->convert_pool, msg->data.data + (size_t)msg->step * band->y,
+                           (int)msg->step, (uint8_t*)pixels, pitch, (int)msg->width, band->h);
+    
+    SDL_UnlockTexture(texture);
+    return 0;
+}
+
+int sdl2_update_stream(display_node_t* display, display_stream_t* stream,
+                       const sensor_msgs__msg__Image* msg) {
+    return sdl2_update_stream_rows(display, stream, msg, 0, msg ? (int)msg->height : 0);
+}
+
+int sdl2_update_stream_rows(display_node_t* display, display_stream_t* stream,
+                            const sensor_msgs__msg__Image* msg, int dirty_y, int dirty_height) {
+    if (!msg || !msg->data.data || msg->width == 0 || msg->height == 0) {
+        return -1;
     }
     
-    SDL_UnlockTexture(display->texture);
+    const display_format_t* fmt = display_find_format(msg->encoding.data);
+    if (!fmt) {
+        RCUTILS_LOG_ERROR("Unsupported image encoding: %s",
+            msg->encoding.data ? msg->encoding.data : "(null)");
+        return -1;
+    }
     
-    // Clear renderer and draw texture
+    if (!display_frame_fits(fmt, msg)) {
+        RCUTILS_LOG_ERROR("%s image %ux%u step %u does not fit %zu bytes",
+            fmt->encoding, msg->width, msg->height, msg->step, msg->data.size);
+        return -1;
+    }
+    
+    // YUY2 is the one format we can convert faster ourselves than SDL's
+    // software emulation when the renderer can't sample it directly
+    bool cpu_convert = fmt->sdl_format == SDL_PIXELFORMAT_YUY2 &&
+                       !sdl2_renderer_supports(display, SDL_PIXELFORMAT_YUY2);
+    Uint32 texture_format = cpu_convert ? (Uint32)SDL_PIXELFORMAT_RGB24 : fmt->sdl_format;
+    
+    int created = sdl2_ensure_texture(display, stream, texture_format, (int)msg->width,
+                                      (int)msg->height);
+    if (created < 0) {
+        return -1;
+    }
+    
+    // Planar formats share chroma rows between luma rows: upload them whole
+    SDL_Rect band = { 0, dirty_y, (int)msg->width, dirty_height };
+    bool single_plane = fmt->layout == DISPLAY_LAYOUT_PACKED || fmt->layout == DISPLAY_LAYOUT_YUV422;
+    if (created || !single_plane || dirty_y < 0 || dirty_height < 0 ||
+        dirty_y + dirty_height > (int)msg->height) {
+        band.y = 0;
+        band.h = (int)msg->height;
+    }
+    
+    // Nothing changed: the texture is shown as it is
+    if (band.h > 0) {
+        int rc = cpu_convert ? sdl2_upload_yuyv_converted(display, stream->texture, msg, &band)
+                             : sdl2_upload_native(stream->texture, fmt, msg, &band);
+        if (rc != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Largest rect with the texture's aspect ratio, centred in tile
+static SDL_Rect display_fit(const SDL_Rect* tile, int width, int height) {
+    SDL_Rect rect = *tile;
+    if ((int64_t)width * tile->h > (int64_t)height * tile->w) {
+        rect.h = (int)((int64_t)height * tile->w / width);
+        rect.y += (tile->h - rect.h) / 2;
+    } else {
+        rect.w = (int)((int64_t)width * tile->h / height);
+        rect.x += (tile->w - rect.w) / 2;
+    }
+    return rect;
+}
+
+void sdl2_present(display_node_t* display) {
     SDL_SetRenderDrawColor(display->renderer, 0, 0, 0, 255);
     SDL_RenderClear(display->renderer);
     
-    SDL_RenderCopy(display->renderer, display->texture, NULL, NULL);
-    SDL_RenderPresent(display->renderer);
+    // A single stream fills the window as before; mosaic tiles keep their
+    // aspect ratio. The grid follows the window when it is resized.
+    if (display->stream_count == 1) {
+        if (display->streams[0].texture) {
+            SDL_RenderCopy(display->renderer, display->streams[0].texture, NULL, NULL);
+        }
+    } else {
+        int output_w, output_h, cols, rows;
+        if (SDL_GetRendererOutputSize(display->renderer, &output_w, &output_h) != 0) {
+            SDL_GetWindowSize(display->window, &output_w, &output_h);
+        }
+        display_grid(display->stream_count, &cols, &rows);
+        int tile_w = (output_w - (cols - 1) * DISPLAY_MOSAIC_GAP) / cols;
+        int tile_h = (output_h - (rows - 1) * DISPLAY_MOSAIC_GAP) / rows;
+        
+        for (int i = 0; i < display->stream_count; ++i) {
+            const display_stream_t* stream = &display->streams[i];
+            if (!stream->texture || tile_w <= 0 || tile_h <= 0) {
+                continue;
+            }
+            SDL_Rect tile = {
+                (i % cols) * (tile_w + DISPLAY_MOSAIC_GAP),
+                (i / cols) * (tile_h + DISPLAY_MOSAIC_GAP),
+                tile_w, tile_h,
+            };
+            SDL_Rect rect = display_fit(&tile, stream->texture_width, stream->texture_height);
+            SDL_RenderCopy(display->renderer, stream->texture, NULL, &rect);
+        }
+    }
     
-    return 0;
+    SDL_RenderPresent(display->renderer);
 }
 
 void sdl2_handle_events(display_node_t* display) {
@@ -166,28 +413,243 @@ void sdl2_handle_events(display_node_t* display) {
         switch (event.type) {
             case SDL_QUIT:
                 RCUTILS_LOG_INFO("Window closed");
-                display->is_running = false;
-                g_running = 0;
+                display_node_stop(display);
                 break;
                 
             case SDL_KEYDOWN:
                 if (event.key.keysym.sym == SDLK_ESCAPE || 
                     event.key.keysym.sym == SDLK_q) {
                     RCUTILS_LOG_INFO("Exit key pressed");
-                    display->is_running = false;
-                    g_running = 0;
+                    display_node_stop(display);
                 }
                 break;
         }
     }
 }
 
-int display_node_init(display_node_t* display, rcl_context_t* context) {
+static int display_node_subscribe_raw(display_node_t* display, display_stream_t* stream) {
+    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
+    const rosidl_message_type_support_t* type_support = 
+        ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image);
+    
+    stream->subscription = rcl_get_zero_initialized_subscription();
+    rcl_ret_t ret = rcl_subscription_init(&stream->subscription, &display->node, type_support,
+                                          stream->image_topic, &sub_options);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize subscription to %s", stream->image_topic);
+        return -1;
+    }
+    
+    stream->raw_subscribed = true;
+    return 0;
+}
+
+static int display_node_subscribe_descriptors(display_node_t* display, display_stream_t* stream) {
+    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
+    const rosidl_message_type_support_t* type_support = 
+        ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg, FrameDescriptor);
+    
+    stream->descriptor_subscription = rcl_get_zero_initialized_subscription();
+    rcl_ret_t ret = rcl_subscription_init(&stream->descriptor_subscription, &display->node,
+                                          type_support, stream->descriptor_topic, &sub_options);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize descriptor subscription to %s",
+            stream->descriptor_topic);
+        return -1;
+    }
+    
+    stream->ring_subscribed = true;
+    return 0;
+}
+
+// The ring named in the descriptors cannot be mapped (e.g. the camera runs
+// on another host): stop listening for descriptors and take raw images
+static void display_node_fall_back_to_raw(display_node_t* display, display_stream_t* stream) {
+    RCUTILS_LOG_WARN("Frame ring unavailable, subscribing to %s instead", stream->image_topic);
+    rcl_subscription_fini(&stream->descriptor_subscription, &display->node);
+    stream->ring_subscribed = false;
+    
+    if (!stream->raw_subscribed && display_node_subscribe_raw(display, stream) != 0) {
+        display_node_stop(display);
+    }
+}
+
+// Still frames look like the one on screen: skip all but every
+// DISPLAY_STILL_REFRESH-th, without touching the ring
+static bool display_node_skip_still(display_stream_t* stream, bool still) {
+    if (!still || stream->intake_index == 0 ||
+        ++stream->still_run >= DISPLAY_STILL_REFRESH) {
+        stream->still_run = 0;
+        return false;
+    }
+    return true;
+}
+
+int display_node_handle_descriptor(display_node_t* display, display_stream_t* stream,
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc,
+    display_frame_t* frame) {
+    if (stream->ring_open && strcmp(stream->frame_ring.name, desc->ring_name.data) != 0) {
+        frame_ring_close(&stream->frame_ring);
+        stream->ring_open = false;
+    }
+    
+    if (!stream->ring_open) {
+        if (frame_ring_open(&stream->frame_ring, desc->ring_name.data) != 0) {
+            display_node_fall_back_to_raw(display, stream);
+            return -1;
+        }
+        stream->ring_open = true;
+        RCUTILS_LOG_INFO("Reading frames from shared ring %s", desc->ring_name.data);
+    }
+    
+    if (display_intake_copy_ring(frame, &stream->frame_ring, desc) != 0) {
+        stream->ring_stale++;
+        
+        // A restarted camera replaces the ring; our mapping then never
+        // matches again, so remap after a run of misses
+        if (stream->frame_ring.stale_count >= DISPLAY_RING_REOPEN_AFTER) {
+            frame_ring_close(&stream->frame_ring);
+            stream->ring_open = false;
+        }
+        return -1;
+    }
+    stream->ring_frames++;
+    return 0;
+}
+
+// Stream for image_topic. Without an explicit descriptor topic, one ending
+// in /image_raw gets the camera's /frame_descriptor topic next to it.
+static int display_node_add_stream(display_node_t* display, const char* image_topic,
+                                   const char* descriptor_topic) {
+    static const char raw_suffix[] = "/image_raw";
+    static const char descriptor_suffix[] = "/frame_descriptor";
+    
+    if (display->stream_count >= DISPLAY_MAX_STREAMS) {
+        RCUTILS_LOG_ERROR("At most %d image topics can be displayed", DISPLAY_MAX_STREAMS);
+        return -1;
+    }
+    size_t length = strlen(image_topic);
+    if (length == 0 || length >= DISPLAY_TOPIC_MAX) {
+        RCUTILS_LOG_ERROR("Invalid image topic '%s'", image_topic);
+        return -1;
+    }
+    
+    display_stream_t* stream = &display->streams[display->stream_count];
+    stream->index = display->stream_count;
+    memcpy(stream->image_topic, image_topic, length + 1);
+    
+    size_t prefix = length - (sizeof(raw_suffix) - 1);
+    if (descriptor_topic) {
+        snprintf(stream->descriptor_topic, DISPLAY_TOPIC_MAX, "%s", descriptor_topic);
+    } else if (length > sizeof(raw_suffix) - 1 && strcmp(image_topic + prefix, raw_suffix) == 0 &&
+               prefix + sizeof(descriptor_suffix) <= DISPLAY_TOPIC_MAX) {
+        memcpy(stream->descriptor_topic, image_topic, prefix);
+        memcpy(stream->descriptor_topic + prefix, descriptor_suffix, sizeof(descriptor_suffix));
+    }
+    display->stream_count++;
+    return 0;
+}
+
+// Comma-separated image topics, in mosaic order
+static int display_node_add_streams(display_node_t* display, const char* topics) {
+    char list[DISPLAY_MAX_STREAMS * DISPLAY_TOPIC_MAX];
+    if (strlen(topics) >= sizeof(list)) {
+        RCUTILS_LOG_ERROR("Topic list too long");
+        return -1;
+    }
+    strcpy(list, topics);
+    
+    char* save = NULL;
+    for (char* topic = strtok_r(list, ",", &save); topic; topic = strtok_r(NULL, ",", &save)) {
+        if (display_node_add_stream(display, topic, NULL) != 0) {
+            return -1;
+        }
+    }
+    if (display->stream_count == 0) {
+        RCUTILS_LOG_ERROR("No image topics in '%s'", topics);
+        return -1;
+    }
+    return 0;
+}
+
+// display_render_upload_t: into the stream's SDL texture
+static int display_node_upload(void* ctx, int index, const sensor_msgs__msg__Image* image,
+                               bool partial, int dirty_y, int dirty_height) {
+    display_node_t* display = (display_node_t*)ctx;
+    display_stream_t* stream = &display->streams[index];
+    return partial ? sdl2_update_stream_rows(display, stream, image, dirty_y, dirty_height) :
+                     sdl2_update_stream(display, stream, image);
+}
+
+static int display_node_init_stream(display_node_t* display, display_stream_t* stream) {
+    // Subscribe to frame descriptors when sharing memory with the camera,
+    // otherwise to the serialized images. In-process frames need neither.
+    if (!display->local) {
+        bool use_ring = DISPLAY_USE_FRAME_RING && stream->descriptor_topic[0] != '\0';
+        int sub_result = use_ring ? display_node_subscribe_descriptors(display, stream) :
+                                    display_node_subscribe_raw(display, stream);
+        if (sub_result != 0) {
+            return -1;
+        }
+    }
+    
+    // Initialize messages
+    stream->descriptor_msg = embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    if (!stream->descriptor_msg) {
+        RCUTILS_LOG_ERROR("Failed to create frame descriptor message");
+        return -1;
+    }
+    
+    // Three frames rotate between the intake thread, the mailbox and the
+    // renderer, so neither side ever waits for the other. Their buffers are
+    // sized for the window up front; a larger stream grows them once.
+    rcutils_allocator_t allocator = rcutils_get_default_allocator();
+    if (!display->local && rmw_serialized_message_init(&stream->descriptor_serialized,
+                                                       DISPLAY_DESCRIPTOR_RESERVE,
+                                                       &allocator) != RMW_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to reserve descriptor buffer");
+        return -1;
+    }
+    void* buffers[FRAME_MAILBOX_BUFFERS];
+    for (int i = 0; i < FRAME_MAILBOX_BUFFERS; ++i) {
+        display_frame_t* frame = &stream->frames[i];
+        if (!sensor_msgs__msg__Image__init(&frame->image)) {
+            RCUTILS_LOG_ERROR("Failed to create image message");
+            return -1;
+        }
+        if (!display->local &&
+            (image_message_reserve(&frame->image, DISPLAY_FRAME_RESERVE, "yuv422_yuy2") != 0 ||
+             rmw_serialized_message_init(&frame->serialized,
+                                         DISPLAY_FRAME_RESERVE + DISPLAY_DESCRIPTOR_RESERVE,
+                                         &allocator) != RMW_RET_OK)) {
+            RCUTILS_LOG_ERROR("Failed to reserve frame buffers");
+            return -1;
+        }
+        buffers[i] = frame;
+    }
+    if (frame_mailbox_init(&stream->mailbox, buffers) != 0) {
+        return -1;
+    }
+    frame_mailbox_join(&stream->mailbox, &display->group);
+    stream->mailbox_ready = true;
+    display_render_add_stream(&display->render, &stream->mailbox);
+    return 0;
+}
+
+static int display_node_init_common(display_node_t* display, rcl_context_t* context,
+                                    const char* topics, bool local) {
     rcl_ret_t ret;
     
     // Initialize display structure
     memset(display, 0, sizeof(display_node_t));
     display->is_running = true;
+    display->local = local;
+    
+    int stream_result = topics ? display_node_add_streams(display, topics) :
+        display_node_add_stream(display, DISPLAY_IMAGE_TOPIC, DISPLAY_DESCRIPTOR_TOPIC);
+    if (stream_result != 0) {
+        return -1;
+    }
     
     // Initialize SDL2 window
     if (sdl2_init_window(display) != 0) {
@@ -195,75 +657,236 @@ int display_node_init(display_node_t* display, rcl_context_t* context) {
         return -1;
     }
     
+    // Conversion workers are started once and reused for every frame
+    if (worker_pool_init(&display->convert_pool, DISPLAY_CONVERT_THREADS, true) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start color conversion workers");
+        sdl2_cleanup_window(display);
+        return -1;
+    }
+    display->convert_pool_ready = true;
+    
     // Initialize ROS2 node
     rcl_node_options_t node_options = rcl_node_get_default_options();
     ret = rcl_node_init(&display->node, "display_node", "", context, &node_options);
     if (ret != RCL_RET_OK) {
         RCUTILS_LOG_ERROR("Failed to initialize ROS2 node");
+        worker_pool_fini(&display->convert_pool);
+        display->convert_pool_ready = false;
         sdl2_cleanup_window(display);
         return -1;
     }
     
-    // Initialize subscription
-    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
-    const rosidl_message_type_support_t* type_support = 
-        ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image);
-    
-    ret = rcl_subscription_init(&display->subscription, &display->node, type_support,
-                               "/camera/image_raw", &sub_options);
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize subscription");
-        rcl_node_fini(&display->node);
-        sdl2_cleanup_window(display);
+    if (frame_mailbox_group_init(&display->group) != 0) {
+        display_node_fini(display);
         return -1;
     }
+    display->group_ready = true;
     
-    // Initialize wait set
-    ret = rcl_wait_set_init(&display->wait_set, 1, 0, 0, 0, 0, 0, context,
-                           rcl_get_default_allocator());
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize wait set");
-        rcl_subscription_fini(&display->subscription, &display->node);
-        rcl_node_fini(&display->node);
-        sdl2_cleanup_window(display);
-        return -1;
+    display_render_init(&display->render, display_node_upload, display);
+    for (int i = 0; i < display->stream_count; ++i) {
+        if (display_node_init_stream(display, &display->streams[i]) != 0) {
+            display_node_fini(display);
+            return -1;
+        }
     }
     
-    // Initialize image message
-    display->image_msg = sensor_msgs__msg__Image__create();
-    if (!display->image_msg) {
-        RCUTILS_LOG_ERROR("Failed to create image message");
-        rcl_wait_set_fini(&display->wait_set);
-        rcl_subscription_fini(&display->subscription, &display->node);
-        rcl_node_fini(&display->node);
-        sdl2_cleanup_window(display);
-        return -1;
+    // Initialize wait set (raw images and descriptors of every stream)
+    if (!local) {
+        ret = rcl_wait_set_init(&display->wait_set, 2 * (size_t)display->stream_count, 0, 0, 0, 0, 0,
+                               context, rcl_get_default_allocator());
+        if (ret != RCL_RET_OK) {
+            RCUTILS_LOG_ERROR("Failed to initialize wait set");
+            display_node_fini(display);
+            return -1;
+        }
+    }
+    
+    if (latency_diagnostics_init(&display->latency, &display->node, "display_node",
+                                 g_latency_stages, DISPLAY_STAGES) == 0) {
+        display->latency_ready = true;
+    } else {
+        RCUTILS_LOG_WARN("Latency diagnostics unavailable");
     }
     
-    RCUTILS_LOG_INFO("Display node initialized successfully");
+    if (display->stream_count > 1) {
+        RCUTILS_LOG_INFO("Display node initialized successfully (mosaic of %d streams)",
+            display->stream_count);
+    } else {
+        RCUTILS_LOG_INFO("Display node initialized successfully%s",
+            local ? " (in-process frames)" : "");
+    }
     return 0;
 }
 
-void display_node_fini(display_node_t* display) {
-    if (display->image_msg) {
-        sensor_msgs__msg__Image__destroy(display->image_msg);
-        display->image_msg = NULL;
+int display_node_init(display_node_t* display, rcl_context_t* context) {
+    return display_node_init_common(display, context, NULL, false);
+}
+
+int display_node_init_mosaic(display_node_t* display, rcl_context_t* context, const char* topics) {
+    return display_node_init_common(display, context, topics, false);
+}
+
+int display_node_init_local(display_node_t* display, rcl_context_t* context) {
+    return display_node_init_common(display, context, NULL, true);
+}
+
+static void display_node_fini_stream(display_node_t* display, display_stream_t* stream) {
+    if (stream->ring_frames || stream->ring_stale) {
+        RCUTILS_LOG_INFO("%s: received %llu frames from the shared ring, %llu stale descriptors, "
+            "%llu still frames skipped", stream->image_topic,
+            (unsigned long long)stream->ring_frames, (unsigned long long)stream->ring_stale,
+            (unsigned long long)stream->still_skipped);
+    }
+    
+    if (stream->mailbox_ready) {
+        uint64_t received, taken, skipped;
+        frame_mailbox_get_counts(&stream->mailbox, &received, &taken, &skipped);
+        RCUTILS_LOG_INFO("%s: received %llu frames, displayed %llu, skipped %llu",
+            stream->image_topic, (unsigned long long)received,
+            (unsigned long long)display->render.streams[stream->index].frames_displayed,
+            (unsigned long long)skipped);
+        frame_mailbox_fini(&stream->mailbox);
+        stream->mailbox_ready = false;
+    }
+    
+    // Zero-initialized frames are safe to finalize too. Pool frames posted
+    // but never shown go back to the camera's pool.
+    for (int i = 0; i < FRAME_MAILBOX_BUFFERS; ++i) {
+        sensor_msgs__msg__Image__fini(&stream->frames[i].image);
+        if (stream->frames[i].serialized.buffer) {
+            rmw_serialized_message_fini(&stream->frames[i].serialized);
+        }
+        if (stream->frames[i].pooled) {
+            frame_pool_release(stream->frames[i].pooled);
+            stream->frames[i].pooled = NULL;
+        }
+    }
+    
+    if (stream->descriptor_msg) {
+        embedded_object_detection_pi5__msg__FrameDescriptor__destroy(stream->descriptor_msg);
+        stream->descriptor_msg = NULL;
+    }
+    if (stream->descriptor_serialized.buffer) {
+        rmw_serialized_message_fini(&stream->descriptor_serialized);
     }
     
+    if (stream->ring_open) {
+        frame_ring_close(&stream->frame_ring);
+        stream->ring_open = false;
+    }
+    
+    if (stream->ring_subscribed) {
+        rcl_subscription_fini(&stream->descriptor_subscription, &display->node);
+        stream->ring_subscribed = false;
+    }
+    if (stream->raw_subscribed) {
+        rcl_subscription_fini(&stream->subscription, &display->node);
+        stream->raw_subscribed = false;
+    }
+}
+
+void display_node_fini(display_node_t* display) {
     rcl_wait_set_fini(&display->wait_set);
-    rcl_subscription_fini(&display->subscription, &display->node);
+    for (int i = 0; i < display->stream_count; ++i) {
+        display_node_fini_stream(display, &display->streams[i]);
+    }
+    if (display->group_ready) {
+        frame_mailbox_group_fini(&display->group);
+        display->group_ready = false;
+    }
+    
+    if (display->latency_ready) {
+        latency_diagnostics_fini(&display->latency);
+        display->latency_ready = false;
+    }
     rcl_node_fini(&display->node);
     
+    if (display->convert_pool_ready) {
+        worker_pool_fini(&display->convert_pool);
+        display->convert_pool_ready = false;
+    }
+    
     sdl2_cleanup_window(display);
 }
 
-int display_node_spin(display_node_t* display) {
+// Publishers that leave the stamp at zero get no capture-based latencies
+static void display_node_trace_take(display_node_t* display, display_frame_t* frame) {
+    if (frame->capture_ns && display->latency_ready) {
+        latency_diagnostics_record(&display->latency, DISPLAY_STAGE_TAKE,
+                                   frame->receive_ns - frame->capture_ns);
+    }
+}
+
+// Take the serialized message straight into the next mailbox frame and
+// read it in place: no deserialization, no allocation
+static void display_node_take_raw(display_node_t* display, display_stream_t* stream) {
+    display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&stream->mailbox);
+    rcl_ret_t ret = display_intake_take_image(frame, &stream->subscription);
+    if (ret == RCL_RET_OK) {
+        RCUTILS_LOG_DEBUG("Received image on %s: %dx%d, encoding: %s", stream->image_topic,
+            frame->view.width, frame->view.height, frame->view.encoding.data);
+        frame->receive_ns = display_now_ns();
+        display_node_trace_take(display, frame);
+        frame->index = ++stream->intake_index;
+        frame_mailbox_publish(&stream->mailbox);
+    } else if (ret != RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+        RCUTILS_LOG_ERROR("Failed to take message from %s", stream->image_topic);
+    }
+}
+
+static void display_node_take_descriptor(display_node_t* display, display_stream_t* stream) {
+    rcl_ret_t ret = display_intake_take_descriptor(&stream->descriptor_subscription,
+                                                   &stream->descriptor_serialized,
+                                                   stream->descriptor_msg);
+    if (ret == RCL_RET_OK && display_node_skip_still(stream, stream->descriptor_msg->still)) {
+        stream->still_skipped++;
+    } else if (ret == RCL_RET_OK) {
+        display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&stream->mailbox);
+        if (display_node_handle_descriptor(display, stream, stream->descriptor_msg, frame) == 0) {
+            frame->receive_ns = display_now_ns();
+            display_node_trace_take(display, frame);
+            frame->index = ++stream->intake_index;
+            frame_mailbox_publish(&stream->mailbox);
+        }
+    } else if (ret != RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+        RCUTILS_LOG_ERROR("Failed to take frame descriptor from %s", stream->descriptor_topic);
+    }
+}
+
+// Add every stream's active subscriptions to the wait set, remembering
+// their indices (SIZE_MAX if inactive)
+static int display_node_fill_wait_set(display_node_t* display, size_t raw_index[],
+                                      size_t ring_index[]) {
+    for (int i = 0; i < display->stream_count; ++i) {
+        display_stream_t* stream = &display->streams[i];
+        raw_index[i] = SIZE_MAX;
+        ring_index[i] = SIZE_MAX;
+        if (stream->raw_subscribed &&
+            rcl_wait_set_add_subscription(&display->wait_set, &stream->subscription,
+                                          &raw_index[i]) != RCL_RET_OK) {
+            RCUTILS_LOG_ERROR("Failed to add subscription to wait set");
+            return -1;
+        }
+        if (stream->ring_subscribed &&
+            rcl_wait_set_add_subscription(&display->wait_set, &stream->descriptor_subscription,
+                                          &ring_index[i]) != RCL_RET_OK) {
+            RCUTILS_LOG_ERROR("Failed to add descriptor subscription to wait set");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Intake thread: take messages as fast as they arrive and post each one to
+// its stream's mailbox, replacing the previous frame if the renderer hasn't
+// got to it
+static void* display_node_intake_thread(void* arg) {
+    display_node_t* display = (display_node_t*)arg;
+    size_t raw_index[DISPLAY_MAX_STREAMS];
+    size_t ring_index[DISPLAY_MAX_STREAMS];
     rcl_ret_t ret;
     
-    while (g_running && display->is_running) {
-        // Handle SDL events
-        sdl2_handle_events(display);
-        
+    while (display_node_running(display)) {
         // Clear wait set
         ret = rcl_wait_set_clear(&display->wait_set);
         if (ret != RCL_RET_OK) {
@@ -271,10 +894,8 @@ int display_node_spin(display_node_t* display) {
             break;
         }
         
-        // Add subscription to wait set
-        ret = rcl_wait_set_add_subscription(&display->wait_set, &display->subscription, NULL);
-        if (ret != RCL_RET_OK) {
-            RCUTILS_LOG_ERROR("Failed to add subscription to wait set");
+        // Add active subscriptions to wait set
+        if (display_node_fill_wait_set(display, raw_index, ring_index) != 0) {
             break;
         }
         
@@ -288,72 +909,151 @@ int display_node_spin(display_node_t* display) {
             break;
         }
         
-        // Check if subscription has data
-        if (display->wait_set.subscriptions[0]) {
-            // Take message
-            rmw_message_info_t message_info;
-            ret = rcl_take(&display->subscription, display->image_msg, &message_info, NULL);
-            
-            if (ret == RCL_RET_OK) {
-                RCUTILS_LOG_DEBUG("Received image: %dx%d, encoding: %s", 
-                    display->image_msg->width, display->image_msg->height, 
-                    display->image_msg->encoding.data);
-                
-                // Update display
-                sdl2_update_display(display, display->image_msg);
-                
-            } else if (ret != RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
-                RCUTILS_LOG_ERROR("Failed to take message");
+        // Each stream only takes what arrived for it
+        for (int i = 0; i < display->stream_count; ++i) {
+            display_stream_t* stream = &display->streams[i];
+            if (raw_index[i] != SIZE_MAX && display->wait_set.subscriptions[raw_index[i]]) {
+                display_node_take_raw(display, stream);
+            }
+            if (ring_index[i] != SIZE_MAX && display->wait_set.subscriptions[ring_index[i]]) {
+                display_node_take_descriptor(display, stream);
             }
         }
     }
     
-    return 0;
+    // Wake the render loop so both sides stop
+    display_node_stop(display);
+    for (int i = 0; i < display->stream_count; ++i) {
+        frame_mailbox_close(&display->streams[i].mailbox);
+    }
+    frame_mailbox_group_close(&display->group);
+    return NULL;
 }
 
-int main(int argc, char* argv[]) {
-    // Set up signal handling
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-    
-    // Initialize RCL
-    rcl_context_t context = rcl_get_zero_initialized_context();
-    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
-    
-    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize init options");
-        return 1;
+// Runs on the camera's publish thread in place of the intake thread
+void display_node_post_frame(void* ctx, frame_pool_frame_t* pooled) {
+    display_node_t* display = (display_node_t*)ctx;
+    display_stream_t* stream = &display->streams[0];
+    if (!display_node_running(display)) {
+        return;
+    }
+    if (display_node_skip_still(stream, pooled->still)) {
+        stream->still_skipped++;
+        return;
     }
     
-    ret = rcl_init(argc, (const char* const*)argv, &init_options, &context);
-    if (ret != RCL_RET_OK) {
-        RCUTILS_LOG_ERROR("Failed to initialize RCL");
-        rcl_init_options_fini(&init_options);
-        return 1;
+    display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&stream->mailbox);
+    display_intake_pool(frame, pooled);
+    frame->receive_ns = display_now_ns();
+    display_node_trace_take(display, frame);
+    frame->index = ++stream->intake_index;
+    frame_mailbox_publish(&stream->mailbox);
+}
+
+static void display_node_log_stats(display_node_t* display) {
+    uint64_t skipped = 0;
+    uint64_t partial_uploads = 0;
+    for (int i = 0; i < display->stream_count; ++i) {
+        uint64_t received, taken, overwritten;
+        frame_mailbox_get_counts(&display->streams[i].mailbox, &received, &taken, &overwritten);
+        skipped += overwritten;
+        partial_uploads += display->render.streams[i].partial_uploads;
     }
     
-    // Initialize display node
-    display_node_t display;
-    if (display_node_init(&display, &context) != 0) {
-        RCUTILS_LOG_ERROR("Failed to initialize display node");
-        rcl_shutdown(&context);
-        rcl_context_fini(&context);
-        rcl_init_options_fini(&init_options);
-        return 1;
+    double avg_ms = display->latency_count ?
+        (double)display->latency_sum_ns / display->latency_count / 1e6 : 0.0;
+    RCUTILS_LOG_INFO("Displayed %llu frames in %llu presents (%llu partial uploads), skipped %llu, "
+        "receive-to-present latency avg %.1f ms, max %.1f ms",
+        (unsigned long long)display->frames_displayed, (unsigned long long)display->presents,
+        (unsigned long long)partial_uploads, (unsigned long long)skipped,
+        avg_ms, display->latency_max_ns / 1e6);
+    for (int i = 0; display->stream_count > 1 && i < display->stream_count; ++i) {
+        RCUTILS_LOG_INFO("  %s: displayed %llu", display->streams[i].image_topic,
+            (unsigned long long)display->render.streams[i].frames_displayed);
     }
     
-    RCUTILS_LOG_INFO("Display node started");
+    display->latency_sum_ns = 0;
+    display->latency_max_ns = 0;
+    display->latency_count = 0;
+}
+
+// Render loop, on the main thread because SDL wants rendering and events
+// on the thread that created the window. At most once per refresh it
+// uploads the newest frame of every stream that has one and presents the
+// whole grid once: vsync blocks SDL_RenderPresent, otherwise the loop
+// sleeps off the rest of the refresh interval.
+int display_node_spin(display_node_t* display) {
+    if (!display->local &&
+        pthread_create(&display->intake_thread, NULL, display_node_intake_thread, display) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start intake thread");
+        return -1;
+    }
     
-    // Run display node
-    int result = display_node_spin(&display);
+    int64_t next_present_ns = 0;
     
-    // Cleanup
-    display_node_fini(&display);
-    rcl_shutdown(&context);
-    rcl_context_fini(&context);
-    rcl_init_options_fini(&init_options);
+    while (display_node_running(display)) {
+        // Handle SDL events
+        sdl2_handle_events(display);
+        
+        // Without vsync, wait out the refresh before picking frames so
+        // anything arriving meanwhile still makes it onto the screen
+        if (!display->vsync && next_present_ns > display_now_ns()) {
+            struct timespec until = {
+                .tv_sec = next_present_ns / 1000000000LL,
+                .tv_nsec = next_present_ns % 1000000000LL,
+            };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+        }
+        
+        uint64_t seen = frame_mailbox_group_count(&display->group);
+        display_frame_t* shown[DISPLAY_MAX_STREAMS];
+        int shown_count = display_render_take(&display->render, shown);
+        if (shown_count == 0) {
+            frame_mailbox_group_wait(&display->group, seen, DISPLAY_EVENT_POLL_MS);
+            continue;
+        }
+        
+        int64_t converted_ns = display_now_ns();
+        sdl2_present(display);
+        int64_t presented_ns = display_now_ns();
+        next_present_ns = presented_ns + display->refresh_interval_ns;
+        display->presents++;
+        
+        // Shown frames stay valid until their stream's next take
+        uint64_t before = display->frames_displayed;
+        for (int i = 0; i < shown_count; ++i) {
+            const display_frame_t* frame = shown[i];
+            if (display->latency_ready) {
+                latency_diagnostics_record(&display->latency, DISPLAY_STAGE_CONVERT,
+                                           converted_ns - frame->receive_ns);
+                latency_diagnostics_record(&display->latency, DISPLAY_STAGE_PRESENT,
+                                           presented_ns - converted_ns);
+                if (frame->capture_ns) {
+                    latency_diagnostics_record(&display->latency, DISPLAY_STAGE_TOTAL,
+                                               presented_ns - frame->capture_ns);
+                }
+            }
+            
+            int64_t latency = presented_ns - frame->receive_ns;
+            display->latency_sum_ns += latency;
+            display->latency_count++;
+            if (latency > display->latency_max_ns) {
+                display->latency_max_ns = latency;
+            }
+        }
+        if (display->latency_ready) {
+            latency_diagnostics_tick(&display->latency, presented_ns);
+        }
+        
+        display->frames_displayed += shown_count;
+        if (display->frames_displayed / DISPLAY_STATS_INTERVAL != before / DISPLAY_STATS_INTERVAL) {
+            display_node_log_stats(display);
+        }
+    }
     
-    RCUTILS_LOG_INFO("Display node stopped");
-    return result;
-} 
\ No newline at end of file
+    display_node_stop(display);
+    if (!display->local) {
+        pthread_join(display->intake_thread, NULL);
+    }
+    return 0;
+}
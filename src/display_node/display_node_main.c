@@ -0,0 +1,81 @@
+#include "display_node/display_node.h"
+#include <signal.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+// The display as its own process, fed over ROS; pipeline_node hosts the
+// same component next to the camera instead. --topics a,b,... shows
+// several image topics as a mosaic.
+
+static void signal_handler(int sig) {
+    (void)sig;
+    display_node_request_shutdown();
+}
+
+// Value of --topics, NULL for the default single stream
+static const char* display_topics_arg(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        // Everything up to the closing "--" belongs to rcl
+        if (strcmp(argv[i], "--ros-args") == 0) {
+            while (i + 1 < argc && strcmp(argv[i + 1], "--") != 0) {
+                ++i;
+            }
+            ++i;
+            continue;
+        }
+        if (strcmp(argv[i], "--topics") == 0 && i + 1 < argc) {
+            return argv[i + 1];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char* argv[]) {
+    // Set up signal handling
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    // Initialize RCL
+    rcl_context_t context = rcl_get_zero_initialized_context();
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+    
+    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize init options");
+        return 1;
+    }
+    
+    ret = rcl_init(argc, (const char* const*)argv, &init_options, &context);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize RCL");
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    // Initialize display node
+    display_node_t display;
+    const char* topics = display_topics_arg(argc, argv);
+    int init_result = topics ? display_node_init_mosaic(&display, &context, topics) :
+                               display_node_init(&display, &context);
+    if (init_result != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize display node");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    RCUTILS_LOG_INFO("Display node started");
+    
+    // Run display node
+    int result = display_node_spin(&display);
+    
+    // Cleanup
+    display_node_fini(&display);
+    rcl_shutdown(&context);
+    rcl_context_fini(&context);
+    rcl_init_options_fini(&init_options);
+    
+    RCUTILS_LOG_INFO("Display node stopped");
+    return result;
+} 
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "display_render/display_intake.h"
+#include <string.h>
+
+#include "image_message/image_message.h"
+#include "image_message/image_message_cdr.h"
+#include "latency_diagnostics/latency_diagnostics.h"
+
+// Capture time from the header stamp; publishers that leave it at zero
+// get no capture-based latencies
+static void display_intake_stamp(display_frame_t* frame) {
+    const builtin_interfaces__msg__Time* stamp = &display_frame_image(frame)->header.stamp;
+    frame->capture_ns = 0;
+    if (stamp->sec != 0 || stamp->nanosec != 0) {
+        frame->capture_ns = latency_stamp_to_monotonic(stamp);
+    }
+}
+
+rcl_ret_t display_intake_take_image(display_frame_t* frame, rcl_subscription_t* subscription) {
+    rmw_message_info_t message_info;
+    rcl_ret_t ret = rcl_take_serialized_message(subscription, &frame->serialized, &message_info, NULL);
+    if (ret != RCL_RET_OK) {
+        return ret;
+    }
+    if (image_message_cdr_view(frame->serialized.buffer, frame->serialized.buffer_length,
+                               &frame->view) != 0) {
+        return RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+    }
+    frame->use_view = true;
+    display_intake_stamp(frame);
+    frame->dirty_y = 0;
+    frame->dirty_height = (int)frame->view.height;
+    return RCL_RET_OK;
+}
+
+rcl_ret_t display_intake_take_descriptor(rcl_subscription_t* subscription,
+    rmw_serialized_message_t* serialized,
+    embedded_object_detection_pi5__msg__FrameDescriptor* desc) {
+    rmw_message_info_t message_info;
+    rcl_ret_t ret = rcl_take_serialized_message(subscription, serialized, &message_info, NULL);
+    if (ret == RCL_RET_OK &&
+        image_message_cdr_read_descriptor(serialized->buffer, serialized->buffer_length, desc) != 0) {
+        ret = RCL_RET_SUBSCRIPTION_TAKE_FAILED;
+    }
+    return ret;
+}
+
+int display_intake_copy_ring(display_frame_t* frame, frame_ring_t* ring,
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc) {
+    frame_ring_view_t view;
+    if (frame_ring_acquire(ring, desc->slot, desc->sequence, &view) != 0) {
+        return -1;
+    }
+    frame->use_view = false;
+    int result = image_message_fill(&frame->image, view.data, view.size, view.width, view.height,
+                                    view.step, view.encoding);
+    frame_ring_release(ring, desc->slot);
+    frame->image.header.stamp = desc->header.stamp;
+    display_intake_stamp(frame);
+
+    // A still frame shown as a refresh redraws everything, so slow drift
+    // the motion gate lets through never stays on screen
+    frame->dirty_y = 0;
+    frame->dirty_height = (int)frame->image.height;
+    if (!desc->still && desc->dirty_y + desc->dirty_height <= frame->image.height) {
+        frame->dirty_y = (int)desc->dirty_y;
+        frame->dirty_height = (int)desc->dirty_height;
+    }
+    return result;
+}
+
+// Image message over a pool frame's bytes, for the upload functions; it
+// borrows everything and must not be finalized
+static void display_intake_pool_view(const frame_pool_frame_t* pooled, sensor_msgs__msg__Image* view) {
+    memset(view, 0, sizeof(*view));
+    view->width = pooled->width;
+    view->height = pooled->height;
+    view->step = pooled->step;
+    view->encoding.data = (char*)pooled->encoding;
+    view->encoding.size = strlen(pooled->encoding);
+    view->encoding.capacity = view->encoding.size + 1;
+    view->data.data = pooled->data;
+    view->data.size = pooled->size;
+    view->data.capacity = pooled->capacity;
+}
+
+void display_intake_pool(display_frame_t* frame, frame_pool_frame_t* pooled) {
+    // The buffer may still hold a frame that was overwritten in the
+    // mailbox before the renderer saw it
+    if (frame->pooled) {
+        frame_pool_release(frame->pooled);
+    }
+    frame_pool_ref(pooled);
+    frame->pooled = pooled;
+    display_intake_pool_view(pooled, &frame->view);
+    frame->use_view = true;
+    frame->capture_ns = pooled->stamp_ns;
+
+    // Same rule as for descriptors: still refreshes redraw everything
+    frame->dirty_y = 0;
+    frame->dirty_height = (int)pooled->height;
+    if (!pooled->still && pooled->dirty_y + pooled->dirty_height <= pooled->height) {
+        frame->dirty_y = (int)pooled->dirty_y;
+        frame->dirty_height = (int)pooled->dirty_height;
+    }
+}
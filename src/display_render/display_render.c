@@ -0,0 +1,79 @@
+#include "display_render/display_render.h"
+#include <string.h>
+
+#include "motion_gate/motion_gate.h"
+
+void display_render_init(display_render_t* render, display_render_upload_t upload, void* ctx) {
+    memset(render, 0, sizeof(*render));
+    render->upload = upload;
+    render->ctx = ctx;
+}
+
+int display_render_add_stream(display_render_t* render, frame_mailbox_t* mailbox) {
+    if (render->stream_count >= DISPLAY_MAX_STREAMS) {
+        return -1;
+    }
+    display_render_stream_t* stream = &render->streams[render->stream_count];
+    memset(stream, 0, sizeof(*stream));
+    stream->mailbox = mailbox;
+    return render->stream_count++;
+}
+
+const sensor_msgs__msg__Image* display_frame_image(const display_frame_t* frame) {
+    return frame->use_view ? &frame->view : &frame->image;
+}
+
+// Upload a frame into its stream's texture. Only the dirty rows changed if
+// this frame directly follows the one in the texture: its own, and those
+// of the texture's frame, which an object may have just left. Skipped still
+// frames are never handed over, so they don't break the chain. The
+// periodic full upload clears any drift.
+static int display_render_upload_frame(display_render_t* render, int index,
+                                       display_frame_t* frame) {
+    display_render_stream_t* stream = &render->streams[index];
+    const sensor_msgs__msg__Image* image = display_frame_image(frame);
+    bool partial = frame->index == stream->shown_index + 1 &&
+                   stream->partial_run < DISPLAY_FULL_REFRESH;
+    int dirty_y = frame->dirty_y;
+    int dirty_height = frame->dirty_height;
+    if (partial) {
+        motion_gate_union_rows(&dirty_y, &dirty_height, stream->shown_dirty_y,
+                               stream->shown_dirty_height);
+    }
+    int rc = render->upload(render->ctx, index, image, partial, dirty_y, dirty_height);
+
+    // The texture has its own copy now
+    uint32_t image_height = image->height;
+    if (frame->pooled) {
+        frame_pool_release(frame->pooled);
+        frame->pooled = NULL;
+    }
+    if (rc != 0) {
+        stream->shown_index = 0;
+        return -1;
+    }
+    stream->shown_index = frame->index;
+    stream->shown_dirty_y = frame->dirty_y;
+    stream->shown_dirty_height = frame->dirty_height;
+    if (partial && dirty_height < (int)image_height) {
+        stream->partial_run++;
+        stream->partial_uploads++;
+    } else {
+        stream->partial_run = 0;
+    }
+    return 0;
+}
+
+int display_render_take(display_render_t* render, display_frame_t* shown[]) {
+    // Streams without a new frame keep their texture as it is
+    int shown_count = 0;
+    for (int i = 0; i < render->stream_count; ++i) {
+        display_render_stream_t* stream = &render->streams[i];
+        display_frame_t* frame = (display_frame_t*)frame_mailbox_take(stream->mailbox, 0);
+        if (frame && display_render_upload_frame(render, i, frame) == 0) {
+            stream->frames_displayed++;
+            shown[shown_count++] = frame;
+        }
+    }
+    return shown_count;
+}
@@ -0,0 +1,169 @@
+#include "frame_mailbox/frame_mailbox.h"
+#include <string.h>
+#include <time.h>
+#include <rcutils/logging_macros.h>
+
+// Timed waits use CLOCK_MONOTONIC so wall clock jumps don't stall them
+static int frame_mailbox_init_wait(pthread_mutex_t* mutex, pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    int rc = pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+    if (rc != 0) {
+        return -1;
+    }
+    if (pthread_mutex_init(mutex, NULL) != 0) {
+        pthread_cond_destroy(cond);
+        return -1;
+    }
+    return 0;
+}
+
+static void frame_mailbox_deadline(struct timespec* deadline, int timeout_ms) {
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += timeout_ms / 1000;
+    deadline->tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+int frame_mailbox_init(frame_mailbox_t* mailbox, void* buffers[FRAME_MAILBOX_BUFFERS]) {
+    memset(mailbox, 0, sizeof(*mailbox));
+    for (int i = 0; i < FRAME_MAILBOX_BUFFERS; ++i) {
+        mailbox->buffers[i] = buffers[i];
+    }
+    mailbox->write_index = 0;
+    mailbox->ready_index = 1;
+    mailbox->read_index = 2;
+
+    if (frame_mailbox_init_wait(&mailbox->mutex, &mailbox->cond) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize frame mailbox");
+        return -1;
+    }
+    return 0;
+}
+
+void frame_mailbox_fini(frame_mailbox_t* mailbox) {
+    pthread_cond_destroy(&mailbox->cond);
+    pthread_mutex_destroy(&mailbox->mutex);
+}
+
+void* frame_mailbox_write_buffer(frame_mailbox_t* mailbox) {
+    // write_index only changes in frame_mailbox_publish on this thread
+    return mailbox->buffers[mailbox->write_index];
+}
+
+void frame_mailbox_publish(frame_mailbox_t* mailbox) {
+    pthread_mutex_lock(&mailbox->mutex);
+    int ready = mailbox->ready_index;
+    mailbox->ready_index = mailbox->write_index;
+    mailbox->write_index = ready;
+    if (mailbox->fresh) {
+        mailbox->overwritten++;
+    }
+    mailbox->fresh = true;
+    mailbox->published++;
+    pthread_cond_signal(&mailbox->cond);
+    pthread_mutex_unlock(&mailbox->mutex);
+
+    // After the frame is in the mailbox, so a reader woken by the group
+    // always finds it
+    frame_mailbox_group_t* group = mailbox->group;
+    if (group) {
+        pthread_mutex_lock(&group->mutex);
+        group->published++;
+        pthread_cond_signal(&group->cond);
+        pthread_mutex_unlock(&group->mutex);
+    }
+}
+
+void* frame_mailbox_take(frame_mailbox_t* mailbox, int timeout_ms) {
+    struct timespec deadline;
+    if (timeout_ms > 0) {
+        frame_mailbox_deadline(&deadline, timeout_ms);
+    }
+
+    void* frame = NULL;
+    pthread_mutex_lock(&mailbox->mutex);
+    while (timeout_ms > 0 && !mailbox->fresh && !mailbox->closed) {
+        if (pthread_cond_timedwait(&mailbox->cond, &mailbox->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+    if (mailbox->fresh) {
+        int read = mailbox->read_index;
+        mailbox->read_index = mailbox->ready_index;
+        mailbox->ready_index = read;
+        mailbox->fresh = false;
+        mailbox->taken++;
+        frame = mailbox->buffers[mailbox->read_index];
+    }
+    pthread_mutex_unlock(&mailbox->mutex);
+    return frame;
+}
+
+void frame_mailbox_close(frame_mailbox_t* mailbox) {
+    pthread_mutex_lock(&mailbox->mutex);
+    mailbox->closed = true;
+    pthread_cond_broadcast(&mailbox->cond);
+    pthread_mutex_unlock(&mailbox->mutex);
+}
+
+void frame_mailbox_get_counts(frame_mailbox_t* mailbox, uint64_t* published,
+                              uint64_t* taken, uint64_t* overwritten) {
+    pthread_mutex_lock(&mailbox->mutex);
+    *published = mailbox->published;
+    *taken = mailbox->taken;
+    *overwritten = mailbox->overwritten;
+    pthread_mutex_unlock(&mailbox->mutex);
+}
+
+int frame_mailbox_group_init(frame_mailbox_group_t* group) {
+    memset(group, 0, sizeof(*group));
+    if (frame_mailbox_init_wait(&group->mutex, &group->cond) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize frame mailbox group");
+        return -1;
+    }
+    return 0;
+}
+
+void frame_mailbox_group_fini(frame_mailbox_group_t* group) {
+    pthread_cond_destroy(&group->cond);
+    pthread_mutex_destroy(&group->mutex);
+}
+
+void frame_mailbox_join(frame_mailbox_t* mailbox, frame_mailbox_group_t* group) {
+    mailbox->group = group;
+}
+
+uint64_t frame_mailbox_group_count(frame_mailbox_group_t* group) {
+    pthread_mutex_lock(&group->mutex);
+    uint64_t published = group->published;
+    pthread_mutex_unlock(&group->mutex);
+    return published;
+}
+
+bool frame_mailbox_group_wait(frame_mailbox_group_t* group, uint64_t seen, int timeout_ms) {
+    struct timespec deadline;
+    frame_mailbox_deadline(&deadline, timeout_ms);
+
+    pthread_mutex_lock(&group->mutex);
+    while (group->published == seen && !group->closed) {
+        if (pthread_cond_timedwait(&group->cond, &group->mutex, &deadline) != 0) {
+            break;
+        }
+    }
+    bool moved = group->published != seen && !group->closed;
+    pthread_mutex_unlock(&group->mutex);
+    return moved;
+}
+
+void frame_mailbox_group_close(frame_mailbox_group_t* group) {
+    pthread_mutex_lock(&group->mutex);
+    group->closed = true;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->mutex);
+}
@@ -0,0 +1,81 @@
+#include "frame_pool/frame_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+#define FRAME_POOL_ALIGN 64
+
+int frame_pool_init(frame_pool_t* pool, int count, size_t frame_size) {
+    memset(pool, 0, sizeof(*pool));
+    if (count <= 0 || frame_size == 0) {
+        RCUTILS_LOG_ERROR("Invalid frame pool size: %d frames of %zu bytes", count, frame_size);
+        return -1;
+    }
+
+    size_t stride = (frame_size + FRAME_POOL_ALIGN - 1) & ~(size_t)(FRAME_POOL_ALIGN - 1);
+    void* memory = NULL;
+    pool->frames = calloc((size_t)count, sizeof(frame_pool_frame_t));
+    if (!pool->frames || posix_memalign(&memory, FRAME_POOL_ALIGN, stride * (size_t)count) != 0) {
+        RCUTILS_LOG_ERROR("Failed to allocate %d pool frames of %zu bytes", count, frame_size);
+        free(pool->frames);
+        pool->frames = NULL;
+        return -1;
+    }
+    pool->memory = memory;
+    pool->count = count;
+
+    for (int i = 0; i < count; ++i) {
+        frame_pool_frame_t* frame = &pool->frames[i];
+        frame->data = pool->memory + stride * (size_t)i;
+        frame->capacity = frame_size;
+        frame->pool = pool;
+    }
+    return 0;
+}
+
+void frame_pool_fini(frame_pool_t* pool) {
+    for (int i = 0; i < pool->count; ++i) {
+        if (__atomic_load_n(&pool->frames[i].refs, __ATOMIC_ACQUIRE) != 0) {
+            RCUTILS_LOG_WARN("Frame pool freed while frame %d is still held", i);
+        }
+    }
+    free(pool->memory);
+    free(pool->frames);
+    memset(pool, 0, sizeof(*pool));
+}
+
+frame_pool_frame_t* frame_pool_acquire(frame_pool_t* pool) {
+    // Start after the last frame handed out, so a frame a consumer just
+    // released is the last to be reused
+    unsigned int start = __atomic_fetch_add(&pool->cursor, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < pool->count; ++i) {
+        frame_pool_frame_t* frame = &pool->frames[(start + (unsigned int)i) % (unsigned int)pool->count];
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&frame->refs, &expected, 1, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&pool->acquired, 1, __ATOMIC_RELAXED);
+            return frame;
+        }
+    }
+    __atomic_fetch_add(&pool->exhausted, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+void frame_pool_ref(frame_pool_frame_t* frame) {
+    __atomic_fetch_add(&frame->refs, 1, __ATOMIC_RELAXED);
+}
+
+void frame_pool_release(frame_pool_frame_t* frame) {
+    // Release ordering: everything this holder read from the frame happens
+    // before the producer can refill it
+    int refs = __atomic_sub_fetch(&frame->refs, 1, __ATOMIC_RELEASE);
+    if (refs < 0) {
+        RCUTILS_LOG_ERROR("Pool frame released more often than it was held");
+        __atomic_store_n(&frame->refs, 0, __ATOMIC_RELEASE);
+    }
+}
+
+void frame_pool_get_counts(const frame_pool_t* pool, uint64_t* acquired, uint64_t* exhausted) {
+    *acquired = __atomic_load_n(&pool->acquired, __ATOMIC_RELAXED);
+    *exhausted = __atomic_load_n(&pool->exhausted, __ATOMIC_RELAXED);
+}
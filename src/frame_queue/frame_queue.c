@@ -0,0 +1,222 @@
+#include "frame_queue/frame_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <rcutils/logging_macros.h>
+
+int frame_queue_init(frame_queue_t* queue, int capacity, size_t frame_size,
+                     frame_queue_policy_t policy) {
+    memset(queue, 0, sizeof(*queue));
+    queue->event_fd = -1;
+    queue->space_fd = -1;
+
+    if (capacity < 1) {
+        RCUTILS_LOG_ERROR("Frame queue capacity must be at least 1");
+        return -1;
+    }
+
+    queue->policy = policy;
+    queue->capacity = capacity;
+    queue->buffer_count = capacity + 2;
+
+    // Cache-line aligned buffers so neighbouring frames never share a line
+    size_t stride = (frame_size + FRAME_QUEUE_CACHE_LINE - 1) & ~(size_t)(FRAME_QUEUE_CACHE_LINE - 1);
+    void* storage = NULL;
+    if (posix_memalign(&storage, FRAME_QUEUE_CACHE_LINE, stride * queue->buffer_count) != 0) {
+        RCUTILS_LOG_ERROR("Failed to allocate frame queue buffers");
+        return -1;
+    }
+    queue->storage = storage;
+
+    queue->frames = calloc(queue->buffer_count, sizeof(frame_queue_frame_t));
+    queue->entries = calloc(capacity, sizeof(int));
+    queue->free_entries = calloc(queue->buffer_count, sizeof(int));
+    if (!queue->frames || !queue->entries || !queue->free_entries) {
+        RCUTILS_LOG_ERROR("Failed to allocate frame queue");
+        frame_queue_fini(queue);
+        return -1;
+    }
+
+    for (int i = 0; i < queue->buffer_count; ++i) {
+        queue->frames[i].buffer = queue->storage + (size_t)i * stride;
+        queue->frames[i].data = queue->frames[i].buffer;
+        queue->frames[i].capacity = frame_size;
+    }
+
+    // Buffer 0 is the producer's first spare, the rest start out released
+    queue->spare = 0;
+    for (int i = 1; i < queue->buffer_count; ++i) {
+        queue->free_entries[i - 1] = i;
+    }
+    queue->free_head = queue->buffer_count - 1;
+
+    queue->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (queue->event_fd == -1) {
+        RCUTILS_LOG_ERROR("eventfd failed: %s", strerror(errno));
+        frame_queue_fini(queue);
+        return -1;
+    }
+
+    // Starts out readable: the empty queue has room
+    if (policy == FRAME_QUEUE_WAIT) {
+        queue->space_fd = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (queue->space_fd == -1) {
+            RCUTILS_LOG_ERROR("eventfd failed: %s", strerror(errno));
+            frame_queue_fini(queue);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void frame_queue_fini(frame_queue_t* queue) {
+    if (queue->event_fd != -1) {
+        close(queue->event_fd);
+        queue->event_fd = -1;
+    }
+    if (queue->space_fd != -1) {
+        close(queue->space_fd);
+        queue->space_fd = -1;
+    }
+    free(queue->free_entries);
+    free(queue->entries);
+    free(queue->frames);
+    free(queue->storage);
+    queue->free_entries = NULL;
+    queue->entries = NULL;
+    queue->frames = NULL;
+    queue->storage = NULL;
+}
+
+// Take the oldest queued entry. Used by the consumer to pop and by the
+// producer to drop; whoever wins the CAS owns the buffer.
+static int frame_queue_take_oldest(frame_queue_t* queue) {
+    uint64_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    for (;;) {
+        uint64_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (tail == head) {
+            return -1;
+        }
+        // May read an entry the producer is already reusing; the CAS below
+        // then fails because tail has moved, and the value is discarded
+        int index = __atomic_load_n(&queue->entries[tail % queue->capacity], __ATOMIC_RELAXED);
+        if (__atomic_compare_exchange_n(&queue->tail, &tail, tail + 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return index;
+        }
+    }
+}
+
+bool frame_queue_full(const frame_queue_t* queue) {
+    uint64_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    return queue->head - tail >= (uint64_t)queue->capacity;
+}
+
+frame_queue_frame_t* frame_queue_begin_push(frame_queue_t* queue) {
+    if (queue->policy != FRAME_QUEUE_DROP_OLDEST && frame_queue_full(queue)) {
+        if (queue->policy == FRAME_QUEUE_DROP_NEWEST) {
+            __atomic_store_n(&queue->dropped_newest, queue->dropped_newest + 1, __ATOMIC_RELAXED);
+        }
+        return NULL;
+    }
+    return &queue->frames[queue->spare];
+}
+
+int frame_queue_push(frame_queue_t* queue) {
+    int dropped = 0;
+    int recycled = -1;
+
+    // Only DROP_OLDEST can still be full here: the consumer never adds
+    // entries, so the room seen in frame_queue_begin_push remains
+    if (frame_queue_full(queue)) {
+        recycled = frame_queue_take_oldest(queue);
+        if (recycled >= 0) {
+            __atomic_store_n(&queue->dropped_oldest, queue->dropped_oldest + 1, __ATOMIC_RELAXED);
+            dropped = 1;
+        }
+        // Otherwise the consumer popped it first, which made room as well
+    }
+
+    __atomic_store_n(&queue->entries[queue->head % queue->capacity], queue->spare, __ATOMIC_RELAXED);
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&queue->pushed, queue->pushed + 1, __ATOMIC_RELAXED);
+
+    if (recycled >= 0) {
+        queue->spare = recycled;
+    } else {
+        // At most capacity buffers are queued and one is held by the
+        // consumer, so a released buffer is always available
+        uint64_t free_head = __atomic_load_n(&queue->free_head, __ATOMIC_ACQUIRE);
+        if (queue->free_tail == free_head) {
+            RCUTILS_LOG_ERROR("Frame queue ran out of buffers");
+            return -1;
+        }
+        queue->spare = queue->free_entries[queue->free_tail % queue->buffer_count];
+        __atomic_store_n(&queue->free_tail, queue->free_tail + 1, __ATOMIC_RELEASE);
+    }
+
+    uint64_t one = 1;
+    ssize_t written = write(queue->event_fd, &one, sizeof(one));
+    (void)written;
+
+    return dropped;
+}
+
+frame_queue_frame_t* frame_queue_pop(frame_queue_t* queue) {
+    int index = frame_queue_take_oldest(queue);
+    if (index < 0) {
+        return NULL;
+    }
+    __atomic_store_n(&queue->popped, queue->popped + 1, __ATOMIC_RELAXED);
+    if (queue->space_fd != -1) {
+        uint64_t one = 1;
+        ssize_t written = write(queue->space_fd, &one, sizeof(one));
+        (void)written;
+    }
+    return &queue->frames[index];
+}
+
+void frame_queue_release(frame_queue_t* queue, frame_queue_frame_t* frame) {
+    int index = (int)(frame - queue->frames);
+    queue->free_entries[queue->free_head % queue->buffer_count] = index;
+    __atomic_store_n(&queue->free_head, queue->free_head + 1, __ATOMIC_RELEASE);
+}
+
+int frame_queue_event_fd(const frame_queue_t* queue) {
+    return queue->event_fd;
+}
+
+void frame_queue_clear_event(frame_queue_t* queue) {
+    uint64_t value;
+    ssize_t got = read(queue->event_fd, &value, sizeof(value));
+    (void)got;
+}
+
+int frame_queue_space_fd(const frame_queue_t* queue) {
+    return queue->space_fd;
+}
+
+void frame_queue_clear_space(frame_queue_t* queue) {
+    uint64_t value;
+    ssize_t got = read(queue->space_fd, &value, sizeof(value));
+    (void)got;
+}
+
+void frame_queue_get_stats(const frame_queue_t* queue, frame_queue_stats_t* stats) {
+    stats->pushed = __atomic_load_n(&queue->pushed, __ATOMIC_RELAXED);
+    stats->popped = __atomic_load_n(&queue->popped, __ATOMIC_RELAXED);
+    stats->dropped_oldest = __atomic_load_n(&queue->dropped_oldest, __ATOMIC_RELAXED);
+    stats->dropped_newest = __atomic_load_n(&queue->dropped_newest, __ATOMIC_RELAXED);
+}
+
+const char* frame_queue_policy_name(frame_queue_policy_t policy) {
+    switch (policy) {
+        case FRAME_QUEUE_DROP_NEWEST: return "drop-newest";
+        case FRAME_QUEUE_WAIT: return "wait";
+        default: return "drop-oldest";
+    }
+}
@@ -0,0 +1,370 @@
+#define _GNU_SOURCE
+#include "frame_record/frame_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <rcutils/logging_macros.h>
+
+#include "latency_trace/latency_trace.h"
+
+#define FRAME_RECORD_INDEX_INITIAL 1024
+
+static uint64_t frame_record_round_up(uint64_t value, uint64_t align) {
+    return (value + align - 1) & ~(align - 1);
+}
+
+// Reserve blocks ahead of the writes so the filesystem hands out large
+// extents instead of allocating on every chunk. The file size is left
+// alone: it only grows with written chunks, so after a crash the player's
+// scan still sees where the data ends and rejects a frame whose payload
+// never reached the disk.
+static int frame_recorder_reserve(frame_recorder_t* recorder, uint64_t end) {
+    if (!recorder->prealloc || end <= recorder->allocated) {
+        return 0;
+    }
+    uint64_t length = frame_record_round_up(end - recorder->allocated, FRAME_RECORD_PREALLOC);
+    if (fallocate(recorder->fd, FALLOC_FL_KEEP_SIZE, (off_t)recorder->allocated, (off_t)length) == -1) {
+        if (errno == EOPNOTSUPP || errno == ENOSYS) {
+            recorder->prealloc = false;
+            return 0;
+        }
+        RCUTILS_LOG_ERROR("Cannot reserve recording space: %s", strerror(errno));
+        return -1;
+    }
+    recorder->allocated += length;
+    return 0;
+}
+
+static int frame_recorder_pwrite(frame_recorder_t* recorder, const uint8_t* data, size_t length,
+                                 uint64_t offset) {
+    int64_t start_ns = latency_monotonic_ns();
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pwrite(recorder->fd, data + done, length - done, (off_t)(offset + done));
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && errno == EINVAL && recorder->direct) {
+            // Some filesystems accept O_DIRECT at open but not on write
+            RCUTILS_LOG_WARN("Direct writes rejected, falling back to buffered writes");
+            recorder->direct = false;
+            fcntl(recorder->fd, F_SETFL, fcntl(recorder->fd, F_GETFL) & ~O_DIRECT);
+            continue;
+        }
+        if (n <= 0) {
+            RCUTILS_LOG_ERROR("Recording write failed: %s", n == 0 ? "no progress" : strerror(errno));
+            return -1;
+        }
+        done += (size_t)n;
+    }
+
+    int64_t elapsed_ns = latency_monotonic_ns() - start_ns;
+    __atomic_store_n(&recorder->bytes, recorder->bytes + length, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->write_ns, recorder->write_ns + elapsed_ns, __ATOMIC_RELAXED);
+    if (elapsed_ns > recorder->max_write_ns) {
+        __atomic_store_n(&recorder->max_write_ns, elapsed_ns, __ATOMIC_RELAXED);
+    }
+    return 0;
+}
+
+// Write the chunk out. A partial chunk (only when closing) is padded with
+// zeros to the O_DIRECT alignment; the file is truncated afterwards.
+static int frame_recorder_flush(frame_recorder_t* recorder) {
+    if (recorder->chunk_fill == 0) {
+        return 0;
+    }
+    size_t length = (size_t)frame_record_round_up(recorder->chunk_fill, FRAME_RECORD_ALIGN);
+    memset(recorder->chunk + recorder->chunk_fill, 0, length - recorder->chunk_fill);
+    if (frame_recorder_reserve(recorder, recorder->chunk_offset + length) != 0 ||
+        frame_recorder_pwrite(recorder, recorder->chunk, length, recorder->chunk_offset) != 0) {
+        return -1;
+    }
+    recorder->chunk_offset += recorder->chunk_fill;
+    recorder->chunk_fill = 0;
+    return 0;
+}
+
+static int frame_recorder_append(frame_recorder_t* recorder, const void* bytes, size_t size) {
+    const uint8_t* src = bytes;
+    while (size > 0) {
+        size_t n = FRAME_RECORD_CHUNK_SIZE - recorder->chunk_fill;
+        if (n > size) {
+            n = size;
+        }
+        if (src) {
+            memcpy(recorder->chunk + recorder->chunk_fill, src, n);
+            src += n;
+        } else {
+            memset(recorder->chunk + recorder->chunk_fill, 0, n);
+        }
+        recorder->chunk_fill += n;
+        size -= n;
+        if (recorder->chunk_fill == FRAME_RECORD_CHUNK_SIZE && frame_recorder_flush(recorder) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static uint64_t frame_recorder_offset(const frame_recorder_t* recorder) {
+    return recorder->chunk_offset + recorder->chunk_fill;
+}
+
+// Writer thread: one frame into the chunk and the index
+static int frame_recorder_write_frame(frame_recorder_t* recorder, const frame_queue_frame_t* frame) {
+    if (recorder->count == recorder->capacity) {
+        size_t capacity = recorder->capacity ? recorder->capacity * 2 : FRAME_RECORD_INDEX_INITIAL;
+        frame_record_entry_t* index = realloc(recorder->index, capacity * sizeof(frame_record_entry_t));
+        if (!index) {
+            RCUTILS_LOG_ERROR("Out of memory for the recording index");
+            return -1;
+        }
+        recorder->index = index;
+        recorder->capacity = capacity;
+    }
+
+    frame_record_frame_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = FRAME_RECORD_FRAME_MAGIC;
+    header.size = (uint32_t)frame->size;
+    header.sequence = frame->sequence;
+    header.stamp_ns = frame->stamp_ns;
+
+    frame_record_entry_t* entry = &recorder->index[recorder->count];
+    memset(entry, 0, sizeof(*entry));
+    entry->stamp_ns = frame->stamp_ns;
+    entry->offset = frame_recorder_offset(recorder) + sizeof(header);
+    entry->size = (uint32_t)frame->size;
+    entry->sequence = frame->sequence;
+    entry->fourcc = recorder->header.fourcc;
+
+    size_t padding = (size_t)(frame_record_round_up(frame->size, FRAME_RECORD_FRAME_ALIGN) - frame->size);
+    if (frame_recorder_append(recorder, &header, sizeof(header)) != 0 ||
+        frame_recorder_append(recorder, frame->data, frame->size) != 0 ||
+        frame_recorder_append(recorder, NULL, padding) != 0) {
+        return -1;
+    }
+    recorder->count++;
+    __atomic_store_n(&recorder->frames, recorder->frames + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void* frame_recorder_thread(void* arg) {
+    frame_recorder_t* recorder = (frame_recorder_t*)arg;
+    struct pollfd fds[2] = {
+        { .fd = frame_queue_event_fd(&recorder->queue), .events = POLLIN },
+        { .fd = recorder->stop_fd, .events = POLLIN },
+    };
+
+    bool stopping = false;
+    while (!stopping) {
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            RCUTILS_LOG_ERROR("Recorder poll failed: %s", strerror(errno));
+            __atomic_store_n(&recorder->error, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        // The capture side has stopped writing before stop is signalled,
+        // so the drain below sees every frame
+        stopping = (fds[1].revents & POLLIN) != 0;
+
+        frame_queue_clear_event(&recorder->queue);
+        frame_queue_frame_t* frame;
+        while ((frame = frame_queue_pop(&recorder->queue)) != NULL) {
+            if (!recorder->error && frame_recorder_write_frame(recorder, frame) != 0) {
+                __atomic_store_n(&recorder->error, 1, __ATOMIC_RELAXED);
+            }
+            frame_queue_release(&recorder->queue, frame);
+        }
+    }
+    return NULL;
+}
+
+static void frame_recorder_free(frame_recorder_t* recorder) {
+    if (recorder->queue_ready) {
+        frame_queue_fini(&recorder->queue);
+        recorder->queue_ready = false;
+    }
+    if (recorder->stop_fd != -1) {
+        close(recorder->stop_fd);
+        recorder->stop_fd = -1;
+    }
+    if (recorder->fd != -1) {
+        close(recorder->fd);
+        recorder->fd = -1;
+    }
+    free(recorder->chunk);
+    recorder->chunk = NULL;
+    free(recorder->index);
+    recorder->index = NULL;
+}
+
+int frame_recorder_open(frame_recorder_t* recorder, const char* path, uint32_t fourcc,
+                        uint32_t width, uint32_t height, uint32_t bytesperline, double fps,
+                        size_t max_frame_size, int queue_depth) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->fd = -1;
+    recorder->stop_fd = -1;
+    recorder->prealloc = true;
+
+    // tmpfs and some FUSE filesystems refuse O_DIRECT
+    recorder->direct = true;
+    recorder->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+    if (recorder->fd == -1 && errno == EINVAL) {
+        recorder->direct = false;
+        recorder->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (recorder->fd == -1) {
+        RCUTILS_LOG_ERROR("Cannot create recording %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    void* chunk = NULL;
+    if (posix_memalign(&chunk, FRAME_RECORD_ALIGN, FRAME_RECORD_CHUNK_SIZE) != 0) {
+        RCUTILS_LOG_ERROR("Failed to allocate the recording buffer");
+        frame_recorder_free(recorder);
+        return -1;
+    }
+    recorder->chunk = chunk;
+
+    if (frame_queue_init(&recorder->queue, queue_depth, max_frame_size, FRAME_QUEUE_DROP_NEWEST) != 0) {
+        frame_recorder_free(recorder);
+        return -1;
+    }
+    recorder->queue_ready = true;
+
+    recorder->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (recorder->stop_fd == -1) {
+        RCUTILS_LOG_ERROR("eventfd failed: %s", strerror(errno));
+        frame_recorder_free(recorder);
+        return -1;
+    }
+
+    // The header goes out with the first chunk, without an index, so an
+    // interrupted recording is still recognised and can be scanned
+    frame_record_header_t* header = &recorder->header;
+    memcpy(header->magic, FRAME_RECORD_MAGIC, sizeof(header->magic));
+    header->version = FRAME_RECORD_VERSION;
+    header->header_size = FRAME_RECORD_ALIGN;
+    header->fourcc = fourcc;
+    header->width = width;
+    header->height = height;
+    header->bytesperline = bytesperline;
+    header->fps = fps;
+    header->clock_offset_ns = latency_realtime_offset_ns();
+    memset(recorder->chunk, 0, FRAME_RECORD_ALIGN);
+    memcpy(recorder->chunk, header, sizeof(*header));
+    recorder->chunk_fill = FRAME_RECORD_ALIGN;
+
+    recorder->open_ns = latency_monotonic_ns();
+    if (pthread_create(&recorder->thread, NULL, frame_recorder_thread, recorder) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start the recorder thread");
+        frame_recorder_free(recorder);
+        return -1;
+    }
+    recorder->thread_running = true;
+
+    RCUTILS_LOG_INFO("Recording to %s (%s writes, %u KB chunks, %d frames queued at most)",
+        path, recorder->direct ? "direct" : "buffered", FRAME_RECORD_CHUNK_SIZE / 1024, queue_depth);
+    return 0;
+}
+
+int frame_recorder_write(frame_recorder_t* recorder, const uint8_t* data, size_t size,
+                         uint32_t sequence, int64_t stamp_ns) {
+    if (__atomic_load_n(&recorder->error, __ATOMIC_RELAXED) || size > recorder->queue.frames[0].capacity) {
+        __atomic_store_n(&recorder->lost, recorder->lost + 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    // NULL: the writer is behind and the frame is dropped (and counted)
+    frame_queue_frame_t* frame = frame_queue_begin_push(&recorder->queue);
+    if (!frame) {
+        return 0;
+    }
+    memcpy(frame->buffer, data, size);
+    frame->data = frame->buffer;
+    frame->size = size;
+    frame->sequence = sequence;
+    frame->stamp_ns = stamp_ns;
+    frame->dequeue_ns = 0;
+    frame_queue_push(&recorder->queue);
+    return 1;
+}
+
+// Frames, then the index right after them, then the final header
+static int frame_recorder_finish(frame_recorder_t* recorder) {
+    frame_record_header_t* header = &recorder->header;
+    header->data_end = frame_recorder_offset(recorder);
+    header->index_offset = header->data_end;
+    header->frame_count = recorder->count;
+    size_t index_size = recorder->count * sizeof(frame_record_entry_t);
+    if (frame_recorder_append(recorder, recorder->index, index_size) != 0) {
+        return -1;
+    }
+    uint64_t end = frame_recorder_offset(recorder);
+    if (frame_recorder_flush(recorder) != 0) {
+        return -1;
+    }
+
+    // The chunk buffer is free now and suitably aligned for the header
+    memset(recorder->chunk, 0, FRAME_RECORD_ALIGN);
+    memcpy(recorder->chunk, header, sizeof(*header));
+    if (frame_recorder_pwrite(recorder, recorder->chunk, FRAME_RECORD_ALIGN, 0) != 0) {
+        return -1;
+    }
+
+    // Drop the padding and whatever was preallocated beyond the index
+    if (ftruncate(recorder->fd, (off_t)end) == -1 || fdatasync(recorder->fd) == -1) {
+        RCUTILS_LOG_ERROR("Cannot finish the recording: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int frame_recorder_close(frame_recorder_t* recorder, frame_recorder_stats_t* stats) {
+    if (recorder->fd == -1) {
+        return 0;
+    }
+    if (recorder->thread_running) {
+        uint64_t one = 1;
+        if (write(recorder->stop_fd, &one, sizeof(one)) != sizeof(one)) {
+            RCUTILS_LOG_WARN("Failed to signal the recorder thread");
+        }
+        pthread_join(recorder->thread, NULL);
+        recorder->thread_running = false;
+    }
+
+    int result = recorder->error ? -1 : frame_recorder_finish(recorder);
+
+    frame_recorder_stats_t final;
+    frame_recorder_get_stats(recorder, &final);
+    double seconds = final.elapsed_ns / 1e9;
+    RCUTILS_LOG_INFO("Recorded %llu frames (%.1f MB, %.1f MB/s), %llu dropped%s",
+        (unsigned long long)final.frames, final.bytes / 1e6,
+        seconds > 0.0 ? final.bytes / 1e6 / seconds : 0.0,
+        (unsigned long long)final.dropped, result == 0 ? "" : ", recording incomplete");
+    if (stats) {
+        *stats = final;
+    }
+
+    frame_recorder_free(recorder);
+    return result;
+}
+
+void frame_recorder_get_stats(const frame_recorder_t* recorder, frame_recorder_stats_t* stats) {
+    frame_queue_stats_t queue;
+    frame_queue_get_stats(&recorder->queue, &queue);
+    stats->frames = __atomic_load_n(&recorder->frames, __ATOMIC_RELAXED);
+    stats->dropped = queue.dropped_newest + __atomic_load_n(&recorder->lost, __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&recorder->bytes, __ATOMIC_RELAXED);
+    stats->write_ns = __atomic_load_n(&recorder->write_ns, __ATOMIC_RELAXED);
+    stats->max_write_ns = __atomic_load_n(&recorder->max_write_ns, __ATOMIC_RELAXED);
+    stats->elapsed_ns = latency_monotonic_ns() - recorder->open_ns;
+    stats->direct = recorder->direct;
+}
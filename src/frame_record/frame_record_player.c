@@ -0,0 +1,174 @@
+#include "frame_record/frame_record.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <rcutils/logging_macros.h>
+
+static uint64_t frame_record_align_frame(uint64_t value) {
+    return (value + FRAME_RECORD_FRAME_ALIGN - 1) & ~(uint64_t)(FRAME_RECORD_FRAME_ALIGN - 1);
+}
+
+bool frame_record_detect(const uint8_t* data, size_t size) {
+    return size >= sizeof(frame_record_header_t) &&
+           memcmp(data, FRAME_RECORD_MAGIC, sizeof(((frame_record_header_t*)0)->magic)) == 0;
+}
+
+// Rebuild the index of a recording that was never closed: walk the frame
+// headers until one is missing or runs past the end of the file
+static int frame_record_view_scan(frame_record_view_t* view, const uint8_t* data, size_t size) {
+    size_t capacity = 0;
+    uint64_t offset = view->header.header_size;
+    while (offset + sizeof(frame_record_frame_t) <= size) {
+        frame_record_frame_t frame;
+        memcpy(&frame, data + offset, sizeof(frame));
+        uint64_t end = offset + sizeof(frame) + frame.size;
+        if (frame.magic != FRAME_RECORD_FRAME_MAGIC || end > size) {
+            break;
+        }
+        if (view->count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            frame_record_entry_t* rebuilt = realloc(view->rebuilt, capacity * sizeof(frame_record_entry_t));
+            if (!rebuilt) {
+                RCUTILS_LOG_ERROR("Out of memory rebuilding the recording index");
+                return -1;
+            }
+            view->rebuilt = rebuilt;
+        }
+        frame_record_entry_t* entry = &view->rebuilt[view->count++];
+        memset(entry, 0, sizeof(*entry));
+        entry->stamp_ns = frame.stamp_ns;
+        entry->offset = offset + sizeof(frame);
+        entry->size = frame.size;
+        entry->sequence = frame.sequence;
+        entry->fourcc = view->header.fourcc;
+        offset = frame_record_align_frame(end);
+    }
+    view->index = view->rebuilt;
+    view->recovered = true;
+    RCUTILS_LOG_WARN("Recording has no index (not closed?), recovered %zu frames", view->count);
+    return 0;
+}
+
+int frame_record_view_init(frame_record_view_t* view, const uint8_t* data, size_t size) {
+    memset(view, 0, sizeof(*view));
+    if (!frame_record_detect(data, size)) {
+        RCUTILS_LOG_ERROR("Not a frame recording");
+        return -1;
+    }
+    memcpy(&view->header, data, sizeof(view->header));
+    const frame_record_header_t* header = &view->header;
+    if (header->version != FRAME_RECORD_VERSION || header->header_size < sizeof(*header) ||
+        header->header_size > size) {
+        RCUTILS_LOG_ERROR("Unsupported frame recording (version %u)", header->version);
+        return -1;
+    }
+
+    if (header->index_offset == 0 || header->index_offset > size ||
+        header->frame_count > (size - header->index_offset) / sizeof(frame_record_entry_t) ||
+        header->index_offset % FRAME_RECORD_FRAME_ALIGN != 0) {
+        if (frame_record_view_scan(view, data, size) != 0) {
+            frame_record_view_fini(view);
+            return -1;
+        }
+    } else {
+        view->index = (const frame_record_entry_t*)(data + header->index_offset);
+        view->count = (size_t)header->frame_count;
+    }
+
+    bool ordered = true;
+    for (size_t i = 0; i < view->count; ++i) {
+        if (view->index[i].offset > size || view->index[i].size > size - view->index[i].offset) {
+            RCUTILS_LOG_ERROR("Recording index points past the end of the file (frame %zu)", i);
+            frame_record_view_fini(view);
+            return -1;
+        }
+        if (ordered && i > 0 && view->index[i].stamp_ns < view->index[i - 1].stamp_ns) {
+            RCUTILS_LOG_WARN("Recording timestamps go backwards at frame %zu, seeking is approximate", i);
+            ordered = false;
+        }
+    }
+    return 0;
+}
+
+void frame_record_view_fini(frame_record_view_t* view) {
+    free(view->rebuilt);
+    view->rebuilt = NULL;
+    view->index = NULL;
+    view->count = 0;
+}
+
+size_t frame_record_view_seek(const frame_record_view_t* view, int64_t stamp_ns) {
+    size_t low = 0;
+    size_t high = view->count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (view->index[mid].stamp_ns < stamp_ns) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int frame_record_player_open(frame_record_player_t* player, const char* path) {
+    memset(player, 0, sizeof(*player));
+    player->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (player->fd == -1) {
+        RCUTILS_LOG_ERROR("Cannot open %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(player->fd, &st) == -1 || st.st_size == 0) {
+        RCUTILS_LOG_ERROR("Cannot read %s: %s", path, st.st_size == 0 ? "empty file" : strerror(errno));
+        frame_record_player_close(player);
+        return -1;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, player->fd, 0);
+    if (data == MAP_FAILED) {
+        RCUTILS_LOG_ERROR("mmap of %s failed: %s", path, strerror(errno));
+        frame_record_player_close(player);
+        return -1;
+    }
+    player->data = data;
+    player->size = (size_t)st.st_size;
+
+    if (frame_record_view_init(&player->view, player->data, player->size) != 0) {
+        frame_record_player_close(player);
+        return -1;
+    }
+    return 0;
+}
+
+void frame_record_player_close(frame_record_player_t* player) {
+    frame_record_view_fini(&player->view);
+    if (player->data) {
+        munmap((void*)player->data, player->size);
+        player->data = NULL;
+    }
+    if (player->fd != -1) {
+        close(player->fd);
+        player->fd = -1;
+    }
+}
+
+const uint8_t* frame_record_player_frame(const frame_record_player_t* player, size_t i,
+                                         const frame_record_entry_t** entry) {
+    if (i >= player->view.count) {
+        return NULL;
+    }
+    if (entry) {
+        *entry = &player->view.index[i];
+    }
+    return player->data + player->view.index[i].offset;
+}
+
+size_t frame_record_player_seek(const frame_record_player_t* player, int64_t stamp_ns) {
+    return frame_record_view_seek(&player->view, stamp_ns);
+}
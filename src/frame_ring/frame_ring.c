@@ -0,0 +1,321 @@
+#include "frame_ring/frame_ring.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <rcutils/logging_macros.h>
+
+static size_t frame_ring_page_align(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) & ~(page - 1);
+}
+
+static int frame_ring_map(frame_ring_t* ring, size_t size) {
+    ring->base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->base == MAP_FAILED) {
+        RCUTILS_LOG_ERROR("mmap of frame ring %s failed: %s", ring->name, strerror(errno));
+        ring->base = NULL;
+        return -1;
+    }
+    ring->map_size = size;
+    ring->header = (frame_ring_header_t*)ring->base;
+    return 0;
+}
+
+int frame_ring_create(frame_ring_t* ring, const char* name, uint32_t slot_count, size_t slot_size) {
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    ring->reader = -1;
+
+    if (slot_count < 2 || slot_count > FRAME_RING_MAX_SLOTS) {
+        RCUTILS_LOG_ERROR("Frame ring slot count must be 2..%d", FRAME_RING_MAX_SLOTS);
+        return -1;
+    }
+
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+
+    // A ring left behind by a crashed producer is simply replaced; readers
+    // still mapping the old object notice via stale sequences and reopen
+    shm_unlink(ring->name);
+    ring->fd = shm_open(ring->name, O_RDWR | O_CREAT | O_EXCL, 0660);
+    if (ring->fd == -1) {
+        RCUTILS_LOG_ERROR("shm_open(%s) failed: %s", ring->name, strerror(errno));
+        return -1;
+    }
+    ring->is_owner = true;
+
+    size_t data_offset = frame_ring_page_align(sizeof(frame_ring_header_t));
+    slot_size = frame_ring_page_align(slot_size);
+    size_t total = data_offset + (size_t)slot_count * slot_size;
+
+    if (ftruncate(ring->fd, (off_t)total) == -1) {
+        RCUTILS_LOG_ERROR("ftruncate of frame ring failed: %s", strerror(errno));
+        frame_ring_close(ring);
+        return -1;
+    }
+
+    if (frame_ring_map(ring, total) != 0) {
+        frame_ring_close(ring);
+        return -1;
+    }
+
+    frame_ring_header_t* header = ring->header;
+    header->version = FRAME_RING_VERSION;
+    header->slot_count = slot_count;
+    header->slot_size = (uint32_t)slot_size;
+    header->data_offset = data_offset;
+    header->next_sequence = 1;
+
+    // Publish the magic last so readers never see a half-initialized header
+    __atomic_store_n(&header->magic, FRAME_RING_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Whether any lease pins slot
+static bool frame_ring_pinned(const frame_ring_header_t* header, uint32_t slot) {
+    for (int r = 0; r < FRAME_RING_MAX_READERS; ++r) {
+        const frame_ring_reader_t* reader = &header->readers[r];
+        if (__atomic_load_n(&reader->pid, __ATOMIC_RELAXED) != 0 &&
+            __atomic_load_n(&reader->pins[slot], __ATOMIC_SEQ_CST) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int frame_ring_reclaim(frame_ring_t* ring) {
+    frame_ring_header_t* header = ring->header;
+    int freed = 0;
+    for (int r = 0; r < FRAME_RING_MAX_READERS; ++r) {
+        frame_ring_reader_t* reader = &header->readers[r];
+        int32_t pid = __atomic_load_n(&reader->pid, __ATOMIC_ACQUIRE);
+        if (pid <= 0 || kill((pid_t)pid, 0) == 0 || errno != ESRCH) {
+            continue; // Free, or alive (EPERM: someone else's process)
+        }
+
+        // Only one caller gets to clear a dead lease
+        if (!__atomic_compare_exchange_n(&reader->pid, &pid, -1, false,
+                                         __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            continue;
+        }
+        uint32_t pins = 0;
+        for (int s = 0; s < FRAME_RING_MAX_SLOTS; ++s) {
+            pins += __atomic_exchange_n(&reader->pins[s], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&reader->pid, 0, __ATOMIC_RELEASE);
+        if (pins) {
+            RCUTILS_LOG_WARN("Frame ring %s: reader %d exited holding %u slot(s), reclaimed",
+                ring->name, (int)pid, pins);
+        }
+        ring->reclaimed += pins;
+        freed++;
+    }
+    return freed;
+}
+
+int frame_ring_begin_write(frame_ring_t* ring) {
+    frame_ring_header_t* header = ring->header;
+
+    if (++ring->writes >= FRAME_RING_RECLAIM_INTERVAL) {
+        ring->writes = 0;
+        frame_ring_reclaim(ring);
+    }
+
+    // Claim the oldest slot no reader is holding. A reader may pin a slot
+    // between the scan and the mark, so rescan a bounded number of times.
+    bool reclaimed = false;
+    for (uint32_t attempt = 0; attempt < header->slot_count; ++attempt) {
+        int best = -1;
+        uint64_t best_sequence = UINT64_MAX;
+
+        for (uint32_t i = 0; i < header->slot_count; ++i) {
+            frame_ring_slot_t* slot = &header->slots[i];
+            if (slot->sequence < best_sequence && !frame_ring_pinned(header, i)) {
+                best = (int)i;
+                best_sequence = slot->sequence;
+            }
+        }
+
+        if (best < 0) {
+            // Every slot is pinned: unless a dead reader held some, drop
+            // the frame, never wait
+            if (reclaimed || frame_ring_reclaim(ring) == 0) {
+                return -1;
+            }
+            reclaimed = true;
+            continue;
+        }
+
+        // Mark, then check for a reader that pinned it meanwhile
+        frame_ring_slot_t* slot = &header->slots[best];
+        __atomic_store_n(&slot->state, FRAME_RING_WRITING, __ATOMIC_SEQ_CST);
+        if (!frame_ring_pinned(header, (uint32_t)best)) {
+            return best;
+        }
+        __atomic_store_n(&slot->state, 0, __ATOMIC_RELEASE);
+    }
+
+    return -1;
+}
+
+uint8_t* frame_ring_slot_data(frame_ring_t* ring, int slot) {
+    return (uint8_t*)ring->base + ring->header->data_offset +
+           (size_t)slot * ring->header->slot_size;
+}
+
+uint64_t frame_ring_commit_write(frame_ring_t* ring, int slot, const frame_ring_frame_info_t* info) {
+    frame_ring_header_t* header = ring->header;
+    frame_ring_slot_t* s = &header->slots[slot];
+    uint64_t sequence = header->next_sequence++;
+
+    s->size = info->size;
+    s->width = info->width;
+    s->height = info->height;
+    s->step = info->step;
+    s->stamp_ns = info->stamp_ns;
+    snprintf(s->encoding, sizeof(s->encoding), "%s", info->encoding ? info->encoding : "");
+    __atomic_store_n(&s->sequence, sequence, __ATOMIC_RELAXED);
+
+    // Releasing the slot publishes the pixels and metadata above
+    __atomic_store_n(&s->state, 0, __ATOMIC_RELEASE);
+    return sequence;
+}
+
+void frame_ring_abort_write(frame_ring_t* ring, int slot) {
+    __atomic_store_n(&ring->header->slots[slot].state, 0, __ATOMIC_RELEASE);
+}
+
+// Take a free lease for this process; a dead reader's lease is freed
+// first if there is none
+static int frame_ring_take_lease(frame_ring_t* ring) {
+    frame_ring_header_t* header = ring->header;
+    int32_t pid = (int32_t)getpid();
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int r = 0; r < FRAME_RING_MAX_READERS; ++r) {
+            int32_t expected = 0;
+            if (__atomic_compare_exchange_n(&header->readers[r].pid, &expected, pid, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+                ring->reader = r;
+                return 0;
+            }
+        }
+        if (frame_ring_reclaim(ring) == 0) {
+            break;
+        }
+    }
+    RCUTILS_LOG_ERROR("Frame ring %s already has %d readers", ring->name, FRAME_RING_MAX_READERS);
+    return -1;
+}
+
+int frame_ring_open(frame_ring_t* ring, const char* name) {
+    struct stat st;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->reader = -1;
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+
+    ring->fd = shm_open(ring->name, O_RDWR, 0);
+    if (ring->fd == -1) {
+        RCUTILS_LOG_ERROR("shm_open(%s) failed: %s", ring->name, strerror(errno));
+        return -1;
+    }
+
+    if (fstat(ring->fd, &st) == -1 || (size_t)st.st_size < sizeof(frame_ring_header_t)) {
+        RCUTILS_LOG_ERROR("Frame ring %s is not initialized", ring->name);
+        frame_ring_close(ring);
+        return -1;
+    }
+
+    if (frame_ring_map(ring, (size_t)st.st_size) != 0) {
+        frame_ring_close(ring);
+        return -1;
+    }
+
+    frame_ring_header_t* header = ring->header;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != FRAME_RING_MAGIC ||
+        header->version != FRAME_RING_VERSION ||
+        header->slot_count > FRAME_RING_MAX_SLOTS ||
+        header->data_offset + (uint64_t)header->slot_count * header->slot_size > ring->map_size) {
+        RCUTILS_LOG_ERROR("Frame ring %s has an unexpected layout", ring->name);
+        frame_ring_close(ring);
+        return -1;
+    }
+
+    if (frame_ring_take_lease(ring) != 0) {
+        frame_ring_close(ring);
+        return -1;
+    }
+    return 0;
+}
+
+int frame_ring_acquire(frame_ring_t* ring, uint32_t slot, uint64_t sequence, frame_ring_view_t* view) {
+    frame_ring_header_t* header = ring->header;
+    if (slot >= header->slot_count || ring->reader < 0) {
+        return -1;
+    }
+
+    // Pin, then check the writer isn't filling it (see frame_ring.h)
+    frame_ring_slot_t* s = &header->slots[slot];
+    __atomic_fetch_add(&header->readers[ring->reader].pins[slot], 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&s->state, __ATOMIC_SEQ_CST) & FRAME_RING_WRITING) {
+        frame_ring_release(ring, slot);
+        ring->stale_count++;
+        return -1; // Already being overwritten with a newer frame
+    }
+
+    // The pin keeps the slot, but it may have been recycled before we got
+    // here
+    if (__atomic_load_n(&s->sequence, __ATOMIC_RELAXED) != sequence ||
+        s->size > header->slot_size) {
+        frame_ring_release(ring, slot);
+        ring->stale_count++;
+        return -1;
+    }
+
+    view->data = (const uint8_t*)ring->base + header->data_offset + (size_t)slot * header->slot_size;
+    view->size = s->size;
+    view->width = s->width;
+    view->height = s->height;
+    view->step = s->step;
+    view->stamp_ns = s->stamp_ns;
+    view->encoding = s->encoding;
+    ring->stale_count = 0;
+    return 0;
+}
+
+void frame_ring_release(frame_ring_t* ring, uint32_t slot) {
+    __atomic_fetch_sub(&ring->header->readers[ring->reader].pins[slot], 1, __ATOMIC_RELEASE);
+}
+
+void frame_ring_close(frame_ring_t* ring) {
+    // Return the lease with anything still pinned
+    if (ring->header && ring->reader >= 0) {
+        frame_ring_reader_t* reader = &ring->header->readers[ring->reader];
+        for (int s = 0; s < FRAME_RING_MAX_SLOTS; ++s) {
+            __atomic_store_n(&reader->pins[s], 0, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&reader->pid, 0, __ATOMIC_RELEASE);
+        ring->reader = -1;
+    }
+
+    if (ring->base) {
+        munmap(ring->base, ring->map_size);
+        ring->base = NULL;
+        ring->header = NULL;
+    }
+
+    if (ring->fd != -1) {
+        close(ring->fd);
+        ring->fd = -1;
+    }
+
+    if (ring->is_owner) {
+        shm_unlink(ring->name);
+        ring->is_owner = false;
+    }
+}
@@ -0,0 +1,147 @@
+#include "frame_source/frame_source.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <linux/videodev2.h>
+#include <rcutils/logging_macros.h>
+
+int frame_source_open(frame_source_t* source, const camera_config_t* config) {
+    memset(source, 0, sizeof(*source));
+    source->fd = -1;
+    source->pace_fd = -1;
+
+    switch (config->source) {
+        case CAMERA_SOURCE_FILE: source->ops = &frame_source_file_ops; break;
+        case CAMERA_SOURCE_SYNTHETIC: source->ops = &frame_source_synthetic_ops; break;
+        default: source->ops = &frame_source_v4l2_ops; break;
+    }
+
+    if (source->ops->open(source, config) != 0) {
+        frame_source_close(source);
+        return -1;
+    }
+
+    char fourcc[5];
+    RCUTILS_LOG_INFO("Frame source %s: %s %ux%u (stride %u, %u bytes) @ %.1f fps%s",
+        source->ops->name, camera_fourcc_str(source->mode.format->fourcc, fourcc),
+        source->mode.width, source->mode.height, source->mode.bytesperline,
+        source->mode.sizeimage, source->mode.fps, source->paced ? "" : ", unpaced");
+    return 0;
+}
+
+int frame_source_start(frame_source_t* source) {
+    return source->ops->start(source);
+}
+
+int frame_source_next(frame_source_t* source, frame_source_frame_t* frame) {
+    int got = source->ops->next(source, frame);
+    if (got <= 0) {
+        return got;
+    }
+    if (source->frames > 0 && frame->sequence > source->last_sequence + 1) {
+        source->drops += frame->sequence - source->last_sequence - 1;
+    }
+    source->last_sequence = frame->sequence;
+    source->frames++;
+    return 1;
+}
+
+int frame_source_release(frame_source_t* source, const frame_source_frame_t* frame) {
+    return source->ops->release ? source->ops->release(source, frame) : 0;
+}
+
+void frame_source_close(frame_source_t* source) {
+    if (source->ops) {
+        source->ops->close(source);
+        source->ops = NULL;
+    }
+    frame_source_pace_fini(source);
+}
+
+const char* frame_source_name(const frame_source_t* source) {
+    return source->ops ? source->ops->name : "none";
+}
+
+int frame_source_frame_layout(const camera_format_t* format, uint32_t width, uint32_t height,
+                              uint32_t* bytesperline, uint32_t* sizeimage) {
+    switch (format->fourcc) {
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_UYVY:
+            *bytesperline = width * 2;
+            *sizeimage = *bytesperline * height;
+            return 0;
+        case V4L2_PIX_FMT_RGB24:
+        case V4L2_PIX_FMT_BGR24:
+            *bytesperline = width * 3;
+            *sizeimage = *bytesperline * height;
+            return 0;
+        case V4L2_PIX_FMT_GREY:
+            *bytesperline = width;
+            *sizeimage = width * height;
+            return 0;
+        case V4L2_PIX_FMT_NV12:
+        case V4L2_PIX_FMT_YUV420:
+            *bytesperline = width;
+            *sizeimage = width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+int frame_source_pace_init(frame_source_t* source, bool realtime, double fps) {
+    source->fd = -1;
+    source->paced = realtime;
+    if (!realtime) {
+        return 0;
+    }
+    if (fps <= 0.0) {
+        RCUTILS_LOG_ERROR("Realtime replay needs a frame rate");
+        return -1;
+    }
+    source->pace_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (source->pace_fd == -1) {
+        RCUTILS_LOG_ERROR("timerfd_create failed: %s", strerror(errno));
+        return -1;
+    }
+    source->interval_ns = (int64_t)(1e9 / fps + 0.5);
+    source->fd = source->pace_fd;
+    return 0;
+}
+
+int frame_source_pace_start(frame_source_t* source) {
+    if (source->pace_fd == -1) {
+        return 0;
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_sec = source->interval_ns / 1000000000LL;
+    spec.it_interval.tv_nsec = source->interval_ns % 1000000000LL;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(source->pace_fd, 0, &spec, NULL) == -1) {
+        RCUTILS_LOG_ERROR("timerfd_settime failed: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+uint64_t frame_source_pace_take(frame_source_t* source) {
+    if (source->pace_fd == -1) {
+        return 1;
+    }
+    uint64_t expirations = 0;
+    if (read(source->pace_fd, &expirations, sizeof(expirations)) != (ssize_t)sizeof(expirations)) {
+        return 0; // EAGAIN: not due yet
+    }
+    return expirations;
+}
+
+void frame_source_pace_fini(frame_source_t* source) {
+    if (source->pace_fd != -1) {
+        close(source->pace_fd);
+        source->pace_fd = -1;
+    }
+    source->fd = -1;
+}
@@ -0,0 +1,329 @@
+#include "frame_source/frame_source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/videodev2.h>
+#include <rcutils/logging_macros.h>
+
+#include "frame_record/frame_record.h"
+#include "latency_trace/latency_trace.h"
+#include "mjpeg_decoder/mjpeg_decoder.h"
+#include "mjpeg_decoder/mjpeg_stream.h"
+
+// Recording replayed from an mmap'd file. The file is indexed once when
+// opened, so every frame is an offset into the mapping:
+//   record frame_record recording, using its own index
+//   Y4M    YUV4MPEG2 header with W/H/F/C, 4:2:0 (as i420) or mono
+//   MJPEG  Concatenated JPEGs, split like mjpeg_stream does
+//   raw    Back-to-back frames of the configured format and size
+// Replay loops; the sequence keeps counting so a wrap is not a drop.
+
+#define FILE_SOURCE_Y4M_MAGIC "YUV4MPEG2 "
+#define FILE_SOURCE_Y4M_LINE_MAX 256
+
+typedef struct {
+    size_t offset;
+    size_t size;
+} file_source_entry_t;
+
+typedef struct {
+    int fd;
+    const uint8_t* data;
+    size_t size;
+    file_source_entry_t* entries;
+    size_t count;
+    size_t capacity;
+    uint64_t position;          // Frames replayed, including skipped ones
+} file_source_t;
+
+static int file_source_add(file_source_t* file, size_t offset, size_t size) {
+    if (file->count == file->capacity) {
+        size_t capacity = file->capacity ? file->capacity * 2 : 256;
+        file_source_entry_t* entries = realloc(file->entries, capacity * sizeof(file_source_entry_t));
+        if (!entries) {
+            RCUTILS_LOG_ERROR("Out of memory indexing frames");
+            return -1;
+        }
+        file->entries = entries;
+        file->capacity = capacity;
+    }
+    file->entries[file->count].offset = offset;
+    file->entries[file->count].size = size;
+    file->count++;
+    return 0;
+}
+
+// End of the line starting at offset, or 0 if there is none within reach
+static size_t file_source_line_end(const file_source_t* file, size_t offset) {
+    size_t reach = file->size - offset;
+    if (reach > FILE_SOURCE_Y4M_LINE_MAX) {
+        reach = FILE_SOURCE_Y4M_LINE_MAX;
+    }
+    const uint8_t* end = memchr(file->data + offset, '\n', reach);
+    return end ? (size_t)(end - file->data) : 0;
+}
+
+static int file_source_index_y4m(file_source_t* file, camera_mode_t* mode) {
+    size_t header_end = file_source_line_end(file, 0);
+    if (header_end == 0) {
+        RCUTILS_LOG_ERROR("Y4M header is not terminated");
+        return -1;
+    }
+
+    char header[FILE_SOURCE_Y4M_LINE_MAX + 1];
+    memcpy(header, file->data, header_end);
+    header[header_end] = '\0';
+
+    uint32_t width = 0, height = 0, rate_num = 0, rate_den = 0;
+    const char* colorspace = "420jpeg";
+    char* save = NULL;
+    for (char* token = strtok_r(header + strlen(FILE_SOURCE_Y4M_MAGIC), " ", &save); token;
+         token = strtok_r(NULL, " ", &save)) {
+        switch (token[0]) {
+            case 'W': width = (uint32_t)strtoul(token + 1, NULL, 10); break;
+            case 'H': height = (uint32_t)strtoul(token + 1, NULL, 10); break;
+            case 'F': sscanf(token + 1, "%u:%u", &rate_num, &rate_den); break;
+            case 'C': colorspace = token + 1; break;
+            default: break;
+        }
+    }
+
+    if (strncmp(colorspace, "420", 3) == 0) {
+        mode->format = camera_format_find(V4L2_PIX_FMT_YUV420);
+    } else if (strcmp(colorspace, "mono") == 0) {
+        mode->format = camera_format_find(V4L2_PIX_FMT_GREY);
+    } else {
+        // 4:2:2 and 4:4:4 are planar in Y4M and would need repacking
+        RCUTILS_LOG_ERROR("Y4M colorspace C%s not supported, convert with -pix_fmt yuv420p", colorspace);
+        return -1;
+    }
+    if (width == 0 || height == 0 ||
+        frame_source_frame_layout(mode->format, width, height, &mode->bytesperline, &mode->sizeimage) != 0) {
+        RCUTILS_LOG_ERROR("Y4M header has no frame size");
+        return -1;
+    }
+    mode->width = width;
+    mode->height = height;
+    mode->fps = rate_den ? (double)rate_num / rate_den : 0.0;
+
+    // Each frame: "FRAME[ params]\n" then the planes
+    size_t offset = header_end + 1;
+    while (offset + 5 <= file->size && memcmp(file->data + offset, "FRAME", 5) == 0) {
+        size_t line_end = file_source_line_end(file, offset);
+        if (line_end == 0 || line_end + 1 + mode->sizeimage > file->size) {
+            RCUTILS_LOG_WARN("Ignoring truncated Y4M frame at byte %zu", offset);
+            break;
+        }
+        if (file_source_add(file, line_end + 1, mode->sizeimage) != 0) {
+            return -1;
+        }
+        offset = line_end + 1 + mode->sizeimage;
+    }
+    return 0;
+}
+
+static int file_source_index_mjpeg(file_source_t* file, camera_mode_t* mode) {
+    // mjpeg_stream over the mapping we already have; never closed
+    mjpeg_stream_t stream = { .fd = -1, .data = file->data, .size = file->size, .offset = 0 };
+    const uint8_t* frame;
+    size_t size;
+    while (mjpeg_stream_next(&stream, &frame, &size) > 0) {
+        if (file_source_add(file, (size_t)(frame - file->data), size) != 0) {
+            return -1;
+        }
+        if (size > mode->sizeimage) {
+            mode->sizeimage = (uint32_t)size;
+        }
+    }
+    if (file->count == 0) {
+        return 0;
+    }
+
+    // The decoder checks every frame against the first one's size
+    mjpeg_decoder_t decoder;
+    if (mjpeg_decoder_init(&decoder, MJPEG_OUTPUT_YUYV, 1) != 0) {
+        return -1;
+    }
+    int result = mjpeg_decoder_peek_size(&decoder, file->data + file->entries[0].offset,
+                                         file->entries[0].size, &mode->width, &mode->height);
+    mjpeg_decoder_fini(&decoder);
+    if (result != 0) {
+        RCUTILS_LOG_ERROR("Cannot read the first MJPEG frame's header");
+        return -1;
+    }
+    mode->format = camera_format_find(V4L2_PIX_FMT_MJPEG);
+    mode->bytesperline = 0;
+    return 0;
+}
+
+static int file_source_index_record(file_source_t* file, camera_mode_t* mode) {
+    frame_record_view_t view;
+    if (frame_record_view_init(&view, file->data, file->size) != 0) {
+        return -1;
+    }
+    const frame_record_header_t* header = &view.header;
+    int result = 0;
+    mode->format = camera_format_find(header->fourcc);
+    mode->width = header->width;
+    mode->height = header->height;
+    mode->fps = header->fps;
+    if (!mode->format) {
+        char fourcc[5];
+        RCUTILS_LOG_ERROR("Recording has unknown format %s", camera_fourcc_str(header->fourcc, fourcc));
+        result = -1;
+    } else if (frame_source_frame_layout(mode->format, mode->width, mode->height,
+                                         &mode->bytesperline, &mode->sizeimage) != 0) {
+        mode->bytesperline = 0; // Compressed: sizeimage is the largest frame
+    }
+    for (size_t i = 0; i < view.count && result == 0; ++i) {
+        result = file_source_add(file, view.index[i].offset, view.index[i].size);
+        if (view.index[i].size > mode->sizeimage) {
+            mode->sizeimage = view.index[i].size;
+        }
+    }
+    frame_record_view_fini(&view);
+    return result;
+}
+
+static int file_source_index_raw(file_source_t* file, camera_mode_t* mode, const camera_config_t* config) {
+    mode->format = config->pixel_format ? camera_format_find(config->pixel_format) : NULL;
+    if (!mode->format || frame_source_frame_layout(mode->format, config->width, config->height,
+                                                   &mode->bytesperline, &mode->sizeimage) != 0) {
+        RCUTILS_LOG_ERROR("Raw files need an uncompressed --format and the frame size");
+        return -1;
+    }
+    mode->width = config->width;
+    mode->height = config->height;
+
+    size_t frames = file->size / mode->sizeimage;
+    if (file->size % mode->sizeimage != 0) {
+        RCUTILS_LOG_WARN("%zu bytes at the end are not a whole %ux%u frame, ignored",
+            file->size % mode->sizeimage, mode->width, mode->height);
+    }
+    for (size_t i = 0; i < frames; ++i) {
+        if (file_source_add(file, i * mode->sizeimage, mode->sizeimage) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void file_source_close(frame_source_t* source) {
+    file_source_t* file = source->state;
+    if (!file) {
+        return;
+    }
+    if (file->data) {
+        munmap((void*)file->data, file->size);
+    }
+    if (file->fd != -1) {
+        close(file->fd);
+    }
+    free(file->entries);
+    free(file);
+    source->state = NULL;
+}
+
+static int file_source_open(frame_source_t* source, const camera_config_t* config) {
+    if (config->file[0] == '\0') {
+        RCUTILS_LOG_ERROR("Frame source file needs a recording (--file)");
+        return -1;
+    }
+
+    file_source_t* file = calloc(1, sizeof(file_source_t));
+    if (!file) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    source->state = file;
+    file->fd = open(config->file, O_RDONLY | O_CLOEXEC);
+    if (file->fd == -1) {
+        RCUTILS_LOG_ERROR("Cannot open %s: %s", config->file, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(file->fd, &st) == -1 || st.st_size == 0) {
+        RCUTILS_LOG_ERROR("Cannot read %s: %s", config->file, st.st_size == 0 ? "empty file" : strerror(errno));
+        return -1;
+    }
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (data == MAP_FAILED) {
+        RCUTILS_LOG_ERROR("mmap of %s failed: %s", config->file, strerror(errno));
+        return -1;
+    }
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    madvise(data, file->size, MADV_SEQUENTIAL);
+
+    int result;
+    const char* kind;
+    size_t magic = strlen(FILE_SOURCE_Y4M_MAGIC);
+    if (frame_record_detect(file->data, file->size)) {
+        kind = "recorded";
+        result = file_source_index_record(file, &source->mode);
+    } else if (file->size > magic && memcmp(file->data, FILE_SOURCE_Y4M_MAGIC, magic) == 0) {
+        kind = "Y4M";
+        result = file_source_index_y4m(file, &source->mode);
+    } else if (file->size >= 3 && file->data[0] == 0xFF && file->data[1] == 0xD8 && file->data[2] == 0xFF) {
+        kind = "MJPEG";
+        result = file_source_index_mjpeg(file, &source->mode);
+    } else {
+        kind = "raw";
+        result = file_source_index_raw(file, &source->mode, config);
+    }
+    if (result != 0) {
+        return -1;
+    }
+    if (file->count == 0) {
+        RCUTILS_LOG_ERROR("No frames in %s", config->file);
+        return -1;
+    }
+
+    // Y4M and recordings carry their own rate; everything else plays at
+    // the requested one
+    if (source->mode.fps <= 0.0) {
+        source->mode.fps = config->fps;
+    }
+    RCUTILS_LOG_INFO("Replaying %zu %s frames from %s", file->count, kind, config->file);
+    return frame_source_pace_init(source, config->realtime, source->mode.fps);
+}
+
+static int file_source_start(frame_source_t* source) {
+    return frame_source_pace_start(source);
+}
+
+static int file_source_next(frame_source_t* source, frame_source_frame_t* frame) {
+    file_source_t* file = source->state;
+    uint64_t ticks = frame_source_pace_take(source);
+    if (ticks == 0) {
+        return 0;
+    }
+
+    // Frames whose time passed while nobody asked are skipped, not queued up
+    file->position += ticks - 1;
+    const file_source_entry_t* entry = &file->entries[file->position % file->count];
+
+    frame->data = file->data + entry->offset;
+    frame->size = entry->size;
+    frame->sequence = (uint32_t)file->position;
+    frame->stamp_ns = latency_monotonic_ns();
+    frame->borrowed = true;
+    frame->index = -1;
+    file->position++;
+    return 1;
+}
+
+const frame_source_ops_t frame_source_file_ops = {
+    .name = "file",
+    .open = file_source_open,
+    .start = file_source_start,
+    .next = file_source_next,
+    .release = NULL,
+    .close = file_source_close,
+};
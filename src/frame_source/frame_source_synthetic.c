@@ -0,0 +1,172 @@
+#include "frame_source/frame_source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <linux/videodev2.h>
+#include <rcutils/logging_macros.h>
+
+#include "latency_trace/latency_trace.h"
+
+// Generated test pattern: colour bars whose brightness ramps down the
+// frame, crossed by a dark line every 64 rows. The pattern is rendered
+// once into a buffer twice the frame height with a vertical period of one
+// frame, so frame n is just a pointer FRAME_SOURCE_SYNTHETIC_SCROLL * n
+// rows into it: the picture scrolls (the motion gate sees motion) and no
+// pixel is written per frame. Packed formats only.
+
+#define SYNTHETIC_BARS 8
+#define SYNTHETIC_LINE_PERIOD 64
+#define SYNTHETIC_LINE_ROWS 4
+
+typedef struct {
+    uint8_t* pattern;           // 2 * height rows of bytesperline
+    uint64_t position;          // Frames generated, including skipped ones
+} synthetic_source_t;
+
+// 75% colour bars: white, yellow, cyan, green, magenta, red, blue, black
+static const uint8_t g_bars[SYNTHETIC_BARS][3] = {
+    { 191, 191, 191 }, { 191, 191, 0 }, { 0, 191, 191 }, { 0, 191, 0 },
+    { 191, 0, 191 }, { 191, 0, 0 }, { 0, 0, 191 }, { 0, 0, 0 },
+};
+
+// Pattern colour at x, y (y within one frame)
+static void synthetic_rgb(uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint8_t rgb[3]) {
+    const uint8_t* bar = g_bars[(uint64_t)x * SYNTHETIC_BARS / width];
+    if (y % SYNTHETIC_LINE_PERIOD < SYNTHETIC_LINE_ROWS) {
+        rgb[0] = rgb[1] = rgb[2] = 16;
+        return;
+    }
+    // Full brightness at the top and bottom, half in the middle, so the
+    // frame also changes when the bars themselves do not
+    uint32_t half = height / 2 ? height / 2 : 1;
+    uint32_t distance = y < half ? y : height - y;
+    uint32_t gain = 256 - 128 * (distance > half ? half : distance) / half;
+    for (int c = 0; c < 3; ++c) {
+        rgb[c] = (uint8_t)(bar[c] * gain / 256);
+    }
+}
+
+// BT.601 limited range
+static void synthetic_yuv(const uint8_t rgb[3], uint8_t* y, uint8_t* u, uint8_t* v) {
+    int r = rgb[0], g = rgb[1], b = rgb[2];
+    *y = (uint8_t)(16 + ((66 * r + 129 * g + 25 * b + 128) >> 8));
+    *u = (uint8_t)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+    *v = (uint8_t)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+}
+
+static void synthetic_render_row(const camera_mode_t* mode, uint32_t y, uint8_t* row) {
+    uint8_t rgb[3], luma, u, v;
+    for (uint32_t x = 0; x < mode->width; ++x) {
+        synthetic_rgb(x, y, mode->width, mode->height, rgb);
+        switch (mode->format->fourcc) {
+            case V4L2_PIX_FMT_YUYV:
+            case V4L2_PIX_FMT_UYVY: {
+                // Chroma of the even pixel for the pair
+                synthetic_yuv(rgb, &luma, &u, &v);
+                uint8_t* pair = row + (x & ~1u) * 2;
+                bool yuyv = mode->format->fourcc == V4L2_PIX_FMT_YUYV;
+                pair[yuyv ? (x & 1) * 2 : (x & 1) * 2 + 1] = luma;
+                if ((x & 1) == 0) {
+                    pair[yuyv ? 1 : 0] = u;
+                    pair[yuyv ? 3 : 2] = v;
+                }
+                break;
+            }
+            case V4L2_PIX_FMT_RGB24:
+                memcpy(row + x * 3, rgb, 3);
+                break;
+            case V4L2_PIX_FMT_BGR24:
+                row[x * 3] = rgb[2];
+                row[x * 3 + 1] = rgb[1];
+                row[x * 3 + 2] = rgb[0];
+                break;
+            default: // GREY
+                synthetic_yuv(rgb, &row[x], &u, &v);
+                break;
+        }
+    }
+}
+
+static void synthetic_source_close(frame_source_t* source) {
+    synthetic_source_t* synthetic = source->state;
+    if (!synthetic) {
+        return;
+    }
+    free(synthetic->pattern);
+    free(synthetic);
+    source->state = NULL;
+}
+
+static int synthetic_source_open(frame_source_t* source, const camera_config_t* config) {
+    camera_mode_t* mode = &source->mode;
+    uint32_t fourcc = config->pixel_format ? config->pixel_format : V4L2_PIX_FMT_YUYV;
+    if (fourcc != V4L2_PIX_FMT_YUYV && fourcc != V4L2_PIX_FMT_UYVY && fourcc != V4L2_PIX_FMT_RGB24 &&
+        fourcc != V4L2_PIX_FMT_BGR24 && fourcc != V4L2_PIX_FMT_GREY) {
+        RCUTILS_LOG_ERROR("Synthetic frames are yuyv, uyvy, rgb24, bgr24 or grey");
+        return -1;
+    }
+    mode->format = camera_format_find(fourcc);
+    mode->width = config->width & ~1u;
+    mode->height = config->height;
+    mode->fps = config->fps;
+    if (mode->width == 0 || mode->height == 0 ||
+        frame_source_frame_layout(mode->format, mode->width, mode->height,
+                                  &mode->bytesperline, &mode->sizeimage) != 0) {
+        RCUTILS_LOG_ERROR("Invalid synthetic frame size %ux%u", config->width, config->height);
+        return -1;
+    }
+
+    synthetic_source_t* synthetic = calloc(1, sizeof(synthetic_source_t));
+    if (!synthetic) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    source->state = synthetic;
+
+    void* pattern = NULL;
+    if (posix_memalign(&pattern, 64, (size_t)mode->sizeimage * 2) != 0) {
+        RCUTILS_LOG_ERROR("Failed to allocate the synthetic pattern");
+        return -1;
+    }
+    synthetic->pattern = pattern;
+    for (uint32_t y = 0; y < mode->height; ++y) {
+        uint8_t* row = synthetic->pattern + (size_t)y * mode->bytesperline;
+        synthetic_render_row(mode, y, row);
+        memcpy(row + mode->sizeimage, row, mode->bytesperline);
+    }
+
+    return frame_source_pace_init(source, config->realtime, mode->fps);
+}
+
+static int synthetic_source_start(frame_source_t* source) {
+    return frame_source_pace_start(source);
+}
+
+static int synthetic_source_next(frame_source_t* source, frame_source_frame_t* frame) {
+    synthetic_source_t* synthetic = source->state;
+    uint64_t ticks = frame_source_pace_take(source);
+    if (ticks == 0) {
+        return 0;
+    }
+
+    synthetic->position += ticks - 1;
+    uint64_t row = synthetic->position * FRAME_SOURCE_SYNTHETIC_SCROLL % source->mode.height;
+
+    frame->data = synthetic->pattern + row * source->mode.bytesperline;
+    frame->size = source->mode.sizeimage;
+    frame->sequence = (uint32_t)synthetic->position;
+    frame->stamp_ns = latency_monotonic_ns();
+    frame->borrowed = true;
+    frame->index = -1;
+    synthetic->position++;
+    return 1;
+}
+
+const frame_source_ops_t frame_source_synthetic_ops = {
+    .name = "synthetic",
+    .open = synthetic_source_open,
+    .start = synthetic_source_start,
+    .next = synthetic_source_next,
+    .release = NULL,
+    .close = synthetic_source_close,
+};
@@ -0,0 +1,532 @@
+#include "frame_source/frame_source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+#include <rcutils/logging_macros.h>
+
+#include "latency_trace/latency_trace.h"
+
+// Camera through V4L2: mode negotiation, mmap buffers, DQBUF/QBUF
+
+typedef struct {
+    void* start;
+    size_t length;
+} v4l2_mapping_t;
+
+typedef struct {
+    int fd;                     // Device, non-blocking
+    v4l2_mapping_t* buffers;    // Mapped driver buffers
+    int buffer_count;
+    bool is_streaming;
+} v4l2_source_t;
+
+static int v4l2_open_device(v4l2_source_t* v4l2, const char* device) {
+    // Non-blocking so VIDIOC_DQBUF returns EAGAIN instead of sleeping;
+    // the capture thread waits for readiness with epoll instead
+    v4l2->fd = open(device, O_RDWR | O_NONBLOCK);
+    if (v4l2->fd == -1) {
+        RCUTILS_LOG_ERROR("Cannot open device %s: %s", device, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+// Highest frame rate the driver advertises for a mode, 0 if unknown
+static double v4l2_max_fps(int fd, uint32_t fourcc, uint32_t width, uint32_t height) {
+    struct v4l2_frmivalenum ival;
+    double best = 0.0;
+
+    memset(&ival, 0, sizeof(ival));
+    ival.pixel_format = fourcc;
+    ival.width = width;
+    ival.height = height;
+
+    while (ioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &ival) == 0) {
+        // Stepwise/continuous ranges list their shortest interval in min
+        const struct v4l2_fract* interval = ival.type == V4L2_FRMIVAL_TYPE_DISCRETE ?
+            &ival.discrete : &ival.stepwise.min;
+        if (interval->numerator > 0) {
+            double fps = (double)interval->denominator / interval->numerator;
+            if (fps > best) {
+                best = fps;
+            }
+        }
+        if (ival.type != V4L2_FRMIVAL_TYPE_DISCRETE) {
+            break;
+        }
+        ival.index++;
+    }
+    return best;
+}
+
+// A mode the driver offers
+typedef struct {
+    const camera_format_t* format;
+    uint32_t width;
+    uint32_t height;
+    double max_fps;             // 0 if unknown
+} v4l2_candidate_t;
+
+// Ranking, most important first: reaches the requested fps, covers the
+// requested size, is closest in size, comes earlier in the format table
+// (uncompressed before compressed)
+static bool v4l2_candidate_better(const v4l2_candidate_t* a, const v4l2_candidate_t* b,
+                                  const camera_config_t* config) {
+    bool a_fps = a->max_fps == 0.0 || a->max_fps + 0.5 >= config->fps;
+    bool b_fps = b->max_fps == 0.0 || b->max_fps + 0.5 >= config->fps;
+    if (a_fps != b_fps) {
+        return a_fps;
+    }
+
+    bool a_size = a->width >= config->width && a->height >= config->height;
+    bool b_size = b->width >= config->width && b->height >= config->height;
+    if (a_size != b_size) {
+        return a_size;
+    }
+
+    long long requested = (long long)config->width * config->height;
+    long long a_diff = llabs((long long)a->width * a->height - requested);
+    long long b_diff = llabs((long long)b->width * b->height - requested);
+    if (a_diff != b_diff) {
+        return a_diff < b_diff;
+    }
+
+    // Both point into the same format table
+    return a->format < b->format;
+}
+
+static void v4l2_consider(v4l2_candidate_t* best, bool* found, const v4l2_candidate_t* candidate,
+                          const camera_config_t* config) {
+    char fourcc[5];
+    RCUTILS_LOG_DEBUG("Mode %s %ux%u up to %.1f fps",
+        camera_fourcc_str(candidate->format->fourcc, fourcc),
+        candidate->width, candidate->height, candidate->max_fps);
+
+    if (!*found || v4l2_candidate_better(candidate, best, config)) {
+        *best = *candidate;
+        *found = true;
+    }
+}
+
+static uint32_t v4l2_snap(uint32_t value, uint32_t min, uint32_t max, uint32_t step) {
+    if (value < min) {
+        value = min;
+    }
+    if (value > max) {
+        value = max;
+    }
+    if (step > 1) {
+        value = min + (value - min) / step * step;
+    }
+    return value;
+}
+
+// Walk formats, frame sizes and frame intervals and pick the mode that
+// best delivers the requested size at the requested rate
+static int v4l2_select_mode(v4l2_source_t* v4l2, const camera_config_t* config,
+                     uint32_t* fourcc, uint32_t* width, uint32_t* height, double* max_fps) {
+    struct v4l2_fmtdesc desc;
+    v4l2_candidate_t best;
+    bool found = false;
+    char name[5];
+
+    memset(&best, 0, sizeof(best));
+    memset(&desc, 0, sizeof(desc));
+    desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+    for (; ioctl(v4l2->fd, VIDIOC_ENUM_FMT, &desc) == 0; desc.index++) {
+        const camera_format_t* format = camera_format_find(desc.pixelformat);
+        RCUTILS_LOG_INFO("Camera offers %s (%s)%s", camera_fourcc_str(desc.pixelformat, name),
+            (const char*)desc.description, format ? "" : ", not supported");
+        if (!format || (config->pixel_format && format->fourcc != config->pixel_format)) {
+            continue;
+        }
+
+        struct v4l2_frmsizeenum size;
+        memset(&size, 0, sizeof(size));
+        size.pixel_format = desc.pixelformat;
+
+        if (ioctl(v4l2->fd, VIDIOC_ENUM_FRAMESIZES, &size) != 0) {
+            // Driver can't enumerate sizes: assume it takes what we ask for
+            v4l2_candidate_t c = { format, config->width, config->height, 0.0 };
+            v4l2_consider(&best, &found, &c, config);
+            continue;
+        }
+
+        if (size.type == V4L2_FRMSIZE_TYPE_DISCRETE) {
+            do {
+                v4l2_candidate_t c = { format, size.discrete.width, size.discrete.height, 0.0 };
+                c.max_fps = v4l2_max_fps(v4l2->fd, desc.pixelformat, c.width, c.height);
+                v4l2_consider(&best, &found, &c, config);
+                size.index++;
+            } while (ioctl(v4l2->fd, VIDIOC_ENUM_FRAMESIZES, &size) == 0);
+        } else {
+            // Stepwise/continuous: the closest size the range allows
+            v4l2_candidate_t c = { format, 
+                v4l2_snap(config->width, size.stepwise.min_width, size.stepwise.max_width,
+                          size.stepwise.step_width),
+                v4l2_snap(config->height, size.stepwise.min_height, size.stepwise.max_height,
+                          size.stepwise.step_height),
+                0.0 };
+            c.max_fps = v4l2_max_fps(v4l2->fd, desc.pixelformat, c.width, c.height);
+            v4l2_consider(&best, &found, &c, config);
+        }
+    }
+
+    if (!found) {
+        if (desc.index == 0) {
+            // Nothing enumerable at all: ask for exactly what was configured
+            *fourcc = config->pixel_format ? config->pixel_format : V4L2_PIX_FMT_YUYV;
+            *width = config->width;
+            *height = config->height;
+            *max_fps = 0.0;
+            return 0;
+        }
+        RCUTILS_LOG_ERROR("Camera offers no supported capture format%s",
+            config->pixel_format ? " matching the requested one" : "");
+        return -1;
+    }
+
+    *fourcc = best.format->fourcc;
+    *width = best.width;
+    *height = best.height;
+    *max_fps = best.max_fps;
+    return 0;
+}
+
+// Request a frame rate and read back what the driver settled on
+static double v4l2_set_fps(v4l2_source_t* v4l2, uint32_t fps) {
+    struct v4l2_streamparm parm;
+
+    memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(v4l2->fd, VIDIOC_G_PARM, &parm) == -1) {
+        RCUTILS_LOG_WARN("VIDIOC_G_PARM failed: %s", strerror(errno));
+        return 0.0;
+    }
+
+    if (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) {
+        parm.parm.capture.timeperframe.numerator = 1;
+        parm.parm.capture.timeperframe.denominator = fps;
+        if (ioctl(v4l2->fd, VIDIOC_S_PARM, &parm) == -1) {
+            RCUTILS_LOG_WARN("VIDIOC_S_PARM failed: %s", strerror(errno));
+        }
+    } else {
+        RCUTILS_LOG_WARN("Driver does not support setting the frame rate");
+    }
+
+    const struct v4l2_fract* tpf = &parm.parm.capture.timeperframe;
+    return tpf->numerator ? (double)tpf->denominator / tpf->numerator : 0.0;
+}
+
+static int v4l2_init_device(v4l2_source_t* v4l2, camera_mode_t* mode, const camera_config_t* config) {
+    struct v4l2_capability cap;
+    struct v4l2_format fmt;
+    struct v4l2_requestbuffers req;
+    struct v4l2_buffer buf;
+    char name[5];
+
+    // Query device capabilities
+    if (ioctl(v4l2->fd, VIDIOC_QUERYCAP, &cap) == -1) {
+        RCUTILS_LOG_ERROR("VIDIOC_QUERYCAP failed: %s", strerror(errno));
+        return -1;
+    }
+
+    if (!(cap.capabilities & V4L2_CAP_VIDEO_CAPTURE)) {
+        RCUTILS_LOG_ERROR("Device does not support video capture");
+        return -1;
+    }
+
+    if (!(cap.capabilities & V4L2_CAP_STREAMING)) {
+        RCUTILS_LOG_ERROR("Device does not support streaming I/O");
+        return -1;
+    }
+
+    // Pick a mode from what the driver enumerates
+    uint32_t fourcc, width, height;
+    double max_fps;
+    if (v4l2_select_mode(v4l2, config, &fourcc, &width, &height, &max_fps) != 0) {
+        return -1;
+    }
+
+    // Set video format
+    memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = width;
+    fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = fourcc;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+
+    if (ioctl(v4l2->fd, VIDIOC_S_FMT, &fmt) == -1) {
+        RCUTILS_LOG_ERROR("VIDIOC_S_FMT failed: %s", strerror(errno));
+        return -1;
+    }
+
+    // The driver may adjust anything; from here on only its answer counts
+    mode->format = camera_format_find(fmt.fmt.pix.pixelformat);
+    if (!mode->format) {
+        RCUTILS_LOG_ERROR("Driver switched to unsupported format %s",
+            camera_fourcc_str(fmt.fmt.pix.pixelformat, name));
+        return -1;
+    }
+    mode->width = fmt.fmt.pix.width;
+    mode->height = fmt.fmt.pix.height;
+    mode->bytesperline = fmt.fmt.pix.bytesperline;
+    mode->sizeimage = fmt.fmt.pix.sizeimage;
+    if (mode->sizeimage == 0) {
+        mode->sizeimage = mode->bytesperline * mode->height;
+    }
+    if (mode->sizeimage == 0) {
+        RCUTILS_LOG_ERROR("Driver reported no frame size");
+        return -1;
+    }
+
+    // Ask for the requested rate, or the most this mode can do
+    uint32_t fps = config->fps;
+    if (max_fps > 0.0 && max_fps < fps) {
+        fps = (uint32_t)(max_fps + 0.5);
+    }
+    mode->fps = v4l2_set_fps(v4l2, fps);
+
+    if (mode->width != config->width || mode->height != config->height ||
+        (mode->fps > 0.0 && mode->fps + 0.5 < config->fps)) {
+        RCUTILS_LOG_WARN("Camera cannot deliver %ux%u @ %u fps, using the closest mode",
+            config->width, config->height, config->fps);
+    }
+
+    // Request buffers
+    memset(&req, 0, sizeof(req));
+    req.count = FRAME_SOURCE_V4L2_BUFFERS;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+
+    if (ioctl(v4l2->fd, VIDIOC_REQBUFS, &req) == -1) {
+        RCUTILS_LOG_ERROR("VIDIOC_REQBUFS failed: %s", strerror(errno));
+        return -1;
+    }
+
+    if (req.count < 2) {
+        RCUTILS_LOG_ERROR("Insufficient buffer memory");
+        return -1;
+    }
+
+    v4l2->buffer_count = req.count;
+    v4l2->buffers = calloc(req.count, sizeof(v4l2_mapping_t));
+
+    if (!v4l2->buffers) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+
+    // Map buffers
+    for (int i = 0; i < v4l2->buffer_count; ++i) {
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+
+        if (ioctl(v4l2->fd, VIDIOC_QUERYBUF, &buf) == -1) {
+            RCUTILS_LOG_ERROR("VIDIOC_QUERYBUF failed: %s", strerror(errno));
+            return -1;
+        }
+
+        v4l2->buffers[i].length = buf.length;
+        v4l2->buffers[i].start = mmap(NULL, buf.length,
+                                       PROT_READ | PROT_WRITE,
+                                       MAP_SHARED,
+                                       v4l2->fd, buf.m.offset);
+
+        if (v4l2->buffers[i].start == MAP_FAILED) {
+            RCUTILS_LOG_ERROR("mmap failed: %s", strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int v4l2_start_capture(v4l2_source_t* v4l2) {
+    struct v4l2_buffer buf;
+    enum v4l2_buf_type type;
+
+    // Queue all buffers
+    for (int i = 0; i < v4l2->buffer_count; ++i) {
+        memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+
+        if (ioctl(v4l2->fd, VIDIOC_QBUF, &buf) == -1) {
+            RCUTILS_LOG_ERROR("VIDIOC_QBUF failed: %s", strerror(errno));
+            return -1;
+        }
+    }
+
+    // Start streaming
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(v4l2->fd, VIDIOC_STREAMON, &type) == -1) {
+        RCUTILS_LOG_ERROR("VIDIOC_STREAMON failed: %s", strerror(errno));
+        return -1;
+    }
+
+    v4l2->is_streaming = true;
+    return 0;
+}
+
+static int v4l2_stop_capture(v4l2_source_t* v4l2) {
+    enum v4l2_buf_type type;
+
+    type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(v4l2->fd, VIDIOC_STREAMOFF, &type) == -1) {
+        RCUTILS_LOG_ERROR("VIDIOC_STREAMOFF failed: %s", strerror(errno));
+        return -1;
+    }
+
+    v4l2->is_streaming = false;
+    return 0;
+}
+
+static int v4l2_dequeue_buffer(v4l2_source_t* v4l2, struct v4l2_buffer* buf) {
+    memset(buf, 0, sizeof(*buf));
+    buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf->memory = V4L2_MEMORY_MMAP;
+
+    if (ioctl(v4l2->fd, VIDIOC_DQBUF, buf) == -1) {
+        if (errno == EAGAIN) {
+            return 0; // No frame available
+        }
+        RCUTILS_LOG_ERROR("VIDIOC_DQBUF failed: %s", strerror(errno));
+        return -1;
+    }
+
+    return 1;
+}
+
+static int v4l2_queue_buffer(v4l2_source_t* v4l2, struct v4l2_buffer* buf) {
+    if (ioctl(v4l2->fd, VIDIOC_QBUF, buf) == -1) {
+        RCUTILS_LOG_ERROR("VIDIOC_QBUF failed: %s", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+// Capture time of a dequeued buffer on CLOCK_MONOTONIC. Drivers stamping
+// with another clock (or not at all) get the dequeue time instead.
+static int64_t v4l2_buffer_stamp(frame_source_t* source, const struct v4l2_buffer* buf) {
+    if ((buf->flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) != V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        source->unstamped++;
+        return latency_monotonic_ns();
+    }
+    return (int64_t)buf->timestamp.tv_sec * 1000000000LL + (int64_t)buf->timestamp.tv_usec * 1000LL;
+}
+
+static void v4l2_source_close(frame_source_t* source) {
+    v4l2_source_t* v4l2 = source->state;
+    if (!v4l2) {
+        return;
+    }
+
+    if (v4l2->is_streaming) {
+        v4l2_stop_capture(v4l2);
+    }
+
+    if (v4l2->buffers) {
+        for (int i = 0; i < v4l2->buffer_count; ++i) {
+            if (v4l2->buffers[i].start) {
+                munmap(v4l2->buffers[i].start, v4l2->buffers[i].length);
+            }
+        }
+        free(v4l2->buffers);
+    }
+
+    if (v4l2->fd != -1) {
+        close(v4l2->fd);
+    }
+    free(v4l2);
+    source->state = NULL;
+    source->fd = -1;
+}
+
+static int v4l2_source_open(frame_source_t* source, const camera_config_t* config) {
+    v4l2_source_t* v4l2 = calloc(1, sizeof(v4l2_source_t));
+    if (!v4l2) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    v4l2->fd = -1;
+    source->state = v4l2;
+
+    if (v4l2_open_device(v4l2, config->device) != 0) {
+        RCUTILS_LOG_ERROR("Failed to open V4L2 device");
+        return -1;
+    }
+    if (v4l2_init_device(v4l2, &source->mode, config) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize V4L2 device");
+        return -1;
+    }
+
+    // The driver sets the pace; its fd is readable once a buffer is filled
+    source->fd = v4l2->fd;
+    source->paced = true;
+    return 0;
+}
+
+static int v4l2_source_start(frame_source_t* source) {
+    return v4l2_start_capture(source->state);
+}
+
+static int v4l2_source_next(frame_source_t* source, frame_source_frame_t* frame) {
+    v4l2_source_t* v4l2 = source->state;
+    struct v4l2_buffer buf;
+
+    int dq = v4l2_dequeue_buffer(v4l2, &buf);
+    if (dq <= 0) {
+        return dq;
+    }
+
+    // The driver flags buffers it knows are damaged (e.g. uvcvideo on a
+    // USB payload error). Raw frames would be shown as they are and a
+    // damaged MJPEG frame can still decode, so give it straight back.
+    if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+        source->corrupt++;
+        return v4l2_queue_buffer(v4l2, &buf) == 0 ? 0 : -1;
+    }
+
+    // bytesused is the real payload; some drivers leave it at 0
+    size_t size = buf.bytesused ? buf.bytesused : source->mode.sizeimage;
+    if (size > source->mode.sizeimage) {
+        size = source->mode.sizeimage;
+    }
+
+    frame->data = v4l2->buffers[buf.index].start;
+    frame->size = size;
+    frame->sequence = buf.sequence;
+    frame->stamp_ns = v4l2_buffer_stamp(source, &buf);
+    frame->borrowed = false; // The driver refills it once requeued
+    frame->index = (int)buf.index;
+    return 1;
+}
+
+static int v4l2_source_release(frame_source_t* source, const frame_source_frame_t* frame) {
+    struct v4l2_buffer buf;
+    memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    buf.index = (uint32_t)frame->index;
+    return v4l2_queue_buffer(source->state, &buf);
+}
+
+const frame_source_ops_t frame_source_v4l2_ops = {
+    .name = "v4l2",
+    .open = v4l2_source_open,
+    .start = v4l2_source_start,
+    .next = v4l2_source_next,
+    .release = v4l2_source_release,
+    .close = v4l2_source_close,
+};
@@ -0,0 +1,85 @@
+#include "frame_sync/frame_sync.h"
+#include <stdint.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+int frame_sync_init(frame_sync_t* sync, int cameras, int64_t tolerance_ns) {
+    memset(sync, 0, sizeof(*sync));
+    if (cameras < 2 || cameras > FRAME_SYNC_MAX_CAMERAS || tolerance_ns <= 0) {
+        RCUTILS_LOG_ERROR("Frame sets need 2-%d cameras and a tolerance, got %d cameras",
+            FRAME_SYNC_MAX_CAMERAS, cameras);
+        return -1;
+    }
+    sync->cameras = cameras;
+    sync->tolerance_ns = tolerance_ns;
+    for (int i = 0; i < cameras; ++i) {
+        sync->used_ns[i] = INT64_MIN;
+    }
+    return 0;
+}
+
+static int64_t frame_sync_distance(int64_t a, int64_t b) {
+    return a > b ? a - b : b - a;
+}
+
+// Camera's unused frame closest to stamp_ns, NULL if none is within the
+// tolerance
+static const frame_sync_frame_t* frame_sync_closest(const frame_sync_t* sync, int camera,
+                                                    int64_t stamp_ns) {
+    const frame_sync_frame_t* best = NULL;
+    int64_t best_distance = sync->tolerance_ns;
+    for (int i = 0; i < sync->filled[camera]; ++i) {
+        const frame_sync_frame_t* frame = &sync->history[camera][i];
+        int64_t distance = frame_sync_distance(frame->stamp_ns, stamp_ns);
+        if (frame->stamp_ns > sync->used_ns[camera] && distance <= best_distance) {
+            best = frame;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+int frame_sync_add(frame_sync_t* sync, int camera, uint32_t sequence, int64_t stamp_ns,
+                   frame_sync_set_t* set) {
+    if (camera < 0 || camera >= sync->cameras) {
+        return 0;
+    }
+    frame_sync_frame_t* slot = &sync->history[camera][sync->next[camera]];
+    slot->sequence = sequence;
+    slot->stamp_ns = stamp_ns;
+    sync->next[camera] = (sync->next[camera] + 1) % FRAME_SYNC_HISTORY;
+    if (sync->filled[camera] < FRAME_SYNC_HISTORY) {
+        sync->filled[camera]++;
+    }
+    sync->frames++;
+
+    // The new frame anchors the set; a closer partner that has not arrived
+    // yet will anchor its own attempt when it does
+    int64_t earliest = stamp_ns;
+    int64_t latest = stamp_ns;
+    for (int i = 0; i < sync->cameras; ++i) {
+        const frame_sync_frame_t* frame = i == camera ? slot : frame_sync_closest(sync, i, stamp_ns);
+        if (!frame) {
+            return 0;
+        }
+        set->frames[i] = *frame;
+        if (frame->stamp_ns < earliest) {
+            earliest = frame->stamp_ns;
+        }
+        if (frame->stamp_ns > latest) {
+            latest = frame->stamp_ns;
+        }
+    }
+
+    // Older frames of every camera can no longer pair with anything newer
+    for (int i = 0; i < sync->cameras; ++i) {
+        sync->used_ns[i] = set->frames[i].stamp_ns;
+    }
+    set->earliest_ns = earliest;
+    set->spread_ns = latest - earliest;
+    if (set->spread_ns > sync->max_spread_ns) {
+        sync->max_spread_ns = set->spread_ns;
+    }
+    sync->sets++;
+    return 1;
+}
@@ -0,0 +1,71 @@
+#include "image_message/image_message.h"
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+#include <rosidl_runtime_c/string_functions.h>
+
+static int image_message_reserve_data(sensor_msgs__msg__Image* msg, size_t size) {
+    if (msg->data.capacity >= size) {
+        return 0;
+    }
+    
+    // Free existing data if any
+    if (msg->data.data) {
+        free(msg->data.data);
+    }
+    
+    // Allocate new data buffer
+    msg->data.data = malloc(size);
+    msg->data.size = 0;
+    if (!msg->data.data) {
+        RCUTILS_LOG_ERROR("Failed to allocate image data buffer");
+        msg->data.capacity = 0;
+        return -1;
+    }
+    msg->data.capacity = size;
+    return 0;
+}
+
+int image_message_set_string(rosidl_runtime_c__String* str, const char* text) {
+    size_t length = strlen(text);
+    if (str->data && str->capacity > length) {
+        if (str->size != length || memcmp(str->data, text, length) != 0) {
+            memcpy(str->data, text, length + 1);
+            str->size = length;
+        }
+        return 0;
+    }
+    return rosidl_runtime_c__String__assign(str, text) ? 0 : -1;
+}
+
+int image_message_reserve(sensor_msgs__msg__Image* msg, size_t size, const char* encoding) {
+    if (image_message_reserve_data(msg, size) != 0 ||
+        image_message_set_string(&msg->encoding, encoding) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int image_message_fill(sensor_msgs__msg__Image* msg, const void* data, size_t size,
+                       uint32_t width, uint32_t height, uint32_t step, const char* encoding) {
+    // Ensure message data is large enough
+    if (image_message_reserve_data(msg, size) != 0) {
+        return -1;
+    }
+    
+    // Copy frame data
+    memcpy(msg->data.data, data, size);
+    
+    msg->data.size = size;
+    msg->width = width;
+    msg->height = height;
+    msg->step = step;
+    
+    // The encoding practically never changes: compare instead of reallocating
+    if (image_message_set_string(&msg->encoding, encoding) != 0) {
+        RCUTILS_LOG_ERROR("Failed to set image encoding");
+        return -1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,186 @@
+#include "image_message/image_message_cdr.h"
+#include <stdbool.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+#include "image_message/image_message.h"
+
+// Encapsulation identifiers (first two bytes, big endian)
+#define CDR_BE 0x0000
+#define CDR_LE 0x0001
+#define CDR2_BE 0x0006
+#define CDR2_LE 0x0007
+#define CDR_ENCAPSULATION_SIZE 4
+
+typedef struct {
+    const uint8_t* data;        // Body, after the encapsulation header
+    size_t size;
+    size_t offset;
+    size_t max_align;           // 8 for CDR, 4 for XCDR2
+    bool swap;                  // Body byte order differs from ours
+    bool failed;
+} cdr_reader_t;
+
+static int cdr_reader_init(cdr_reader_t* reader, const uint8_t* buffer, size_t length) {
+    memset(reader, 0, sizeof(*reader));
+    if (length < CDR_ENCAPSULATION_SIZE) {
+        return -1;
+    }
+    int id = (buffer[0] << 8) | buffer[1];
+    bool little = id == CDR_LE || id == CDR2_LE;
+    if (id != CDR_BE && id != CDR_LE && id != CDR2_BE && id != CDR2_LE) {
+        RCUTILS_LOG_ERROR("Unsupported CDR encapsulation 0x%04x", id);
+        return -1;
+    }
+    reader->data = buffer + CDR_ENCAPSULATION_SIZE;
+    reader->size = length - CDR_ENCAPSULATION_SIZE;
+    reader->max_align = (id == CDR_BE || id == CDR_LE) ? 8 : 4;
+    uint16_t probe = 1;
+    bool host_little = *(const uint8_t*)&probe == 1;
+    reader->swap = little != host_little;
+    return 0;
+}
+
+// Position of the next n-byte primitive (aligned), or NULL past the end
+static const uint8_t* cdr_take(cdr_reader_t* reader, size_t n, size_t align) {
+    if (align > reader->max_align) {
+        align = reader->max_align;
+    }
+    size_t offset = (reader->offset + align - 1) & ~(align - 1);
+    if (reader->failed || offset > reader->size || n > reader->size - offset) {
+        reader->failed = true;
+        return NULL;
+    }
+    reader->offset = offset + n;
+    return reader->data + offset;
+}
+
+static uint8_t cdr_read_u8(cdr_reader_t* reader) {
+    const uint8_t* p = cdr_take(reader, 1, 1);
+    return p ? *p : 0;
+}
+
+static uint32_t cdr_read_u32(cdr_reader_t* reader) {
+    const uint8_t* p = cdr_take(reader, 4, 4);
+    uint32_t value = 0;
+    if (p) {
+        memcpy(&value, p, 4);
+        if (reader->swap) {
+            value = __builtin_bswap32(value);
+        }
+    }
+    return value;
+}
+
+static uint64_t cdr_read_u64(cdr_reader_t* reader) {
+    const uint8_t* p = cdr_take(reader, 8, 8);
+    uint64_t value = 0;
+    if (p) {
+        memcpy(&value, p, 8);
+        if (reader->swap) {
+            value = __builtin_bswap64(value);
+        }
+    }
+    return value;
+}
+
+static float cdr_read_f32(cdr_reader_t* reader) {
+    uint32_t bits = cdr_read_u32(reader);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Length (terminator included) then the characters; *length excludes the
+// terminator. Points into the buffer.
+static const char* cdr_read_string(cdr_reader_t* reader, size_t* length) {
+    uint32_t size = cdr_read_u32(reader);
+    const uint8_t* p = size > 0 ? cdr_take(reader, size, 1) : NULL;
+    if (!p || p[size - 1] != '\0') {
+        reader->failed = true;
+        return NULL;
+    }
+    *length = size - 1;
+    return (const char*)p;
+}
+
+static void cdr_read_time(cdr_reader_t* reader, builtin_interfaces__msg__Time* stamp) {
+    stamp->sec = (int32_t)cdr_read_u32(reader);
+    stamp->nanosec = cdr_read_u32(reader);
+}
+
+int image_message_cdr_view(const uint8_t* buffer, size_t length, sensor_msgs__msg__Image* view) {
+    cdr_reader_t reader;
+    if (cdr_reader_init(&reader, buffer, length) != 0) {
+        return -1;
+    }
+    memset(view, 0, sizeof(*view));
+    
+    size_t frame_id_length = 0;
+    size_t encoding_length = 0;
+    cdr_read_time(&reader, &view->header.stamp);
+    const char* frame_id = cdr_read_string(&reader, &frame_id_length);
+    view->height = cdr_read_u32(&reader);
+    view->width = cdr_read_u32(&reader);
+    const char* encoding = cdr_read_string(&reader, &encoding_length);
+    view->is_bigendian = cdr_read_u8(&reader);
+    view->step = cdr_read_u32(&reader);
+    uint32_t size = cdr_read_u32(&reader);
+    const uint8_t* data = cdr_take(&reader, size, 1);
+    if (reader.failed) {
+        RCUTILS_LOG_ERROR("Truncated or malformed serialized image (%zu bytes)", length);
+        return -1;
+    }
+    
+    view->header.frame_id.data = (char*)frame_id;
+    view->header.frame_id.size = frame_id_length;
+    view->header.frame_id.capacity = frame_id_length + 1;
+    view->encoding.data = (char*)encoding;
+    view->encoding.size = encoding_length;
+    view->encoding.capacity = encoding_length + 1;
+    view->data.data = (uint8_t*)data;
+    view->data.size = size;
+    view->data.capacity = size;
+    return 0;
+}
+
+int image_message_cdr_read_descriptor(const uint8_t* buffer, size_t length,
+                                      embedded_object_detection_pi5__msg__FrameDescriptor* msg) {
+    cdr_reader_t reader;
+    if (cdr_reader_init(&reader, buffer, length) != 0) {
+        return -1;
+    }
+    
+    size_t frame_id_length = 0;
+    size_t ring_name_length = 0;
+    size_t encoding_length = 0;
+    cdr_read_time(&reader, &msg->header.stamp);
+    const char* frame_id = cdr_read_string(&reader, &frame_id_length);
+    const char* ring_name = cdr_read_string(&reader, &ring_name_length);
+    msg->slot = cdr_read_u32(&reader);
+    msg->sequence = cdr_read_u64(&reader);
+    msg->capture_sequence = cdr_read_u32(&reader);
+    msg->size = cdr_read_u32(&reader);
+    msg->width = cdr_read_u32(&reader);
+    msg->height = cdr_read_u32(&reader);
+    msg->step = cdr_read_u32(&reader);
+    const char* encoding = cdr_read_string(&reader, &encoding_length);
+    msg->still = cdr_read_u8(&reader) != 0;
+    msg->motion_score = cdr_read_f32(&reader);
+    msg->dirty_x = cdr_read_u32(&reader);
+    msg->dirty_y = cdr_read_u32(&reader);
+    msg->dirty_width = cdr_read_u32(&reader);
+    msg->dirty_height = cdr_read_u32(&reader);
+    if (reader.failed) {
+        RCUTILS_LOG_ERROR("Truncated or malformed serialized frame descriptor (%zu bytes)", length);
+        return -1;
+    }
+    
+    // The strings are terminated inside the buffer (checked above)
+    if (image_message_set_string(&msg->header.frame_id, frame_id) != 0 ||
+        image_message_set_string(&msg->ring_name, ring_name) != 0 ||
+        image_message_set_string(&msg->encoding, encoding) != 0) {
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include "inference_config/inference_config.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <rcl/arguments.h>
+#include <rcl_yaml_param_parser/parser.h>
+#include <rcutils/logging_macros.h>
+
+typedef enum {
+    INFERENCE_OPTION_PATH = 0,
+    INFERENCE_OPTION_UINT,          // uint32_t
+    INFERENCE_OPTION_INT,           // int
+    INFERENCE_OPTION_FLOAT,
+    INFERENCE_OPTION_BOOL,
+    INFERENCE_OPTION_OPTIMIZATION,  // GraphOptimizationLevel
+    INFERENCE_OPTION_POLICY         // stage_pipeline_policy_t
+} inference_option_type_t;
+
+typedef struct {
+    const char* name;               // Parameter name
+    const char* flag;
+    inference_option_type_t type;
+    size_t offset;                  // Field in inference_config_t
+    double min;
+    double max;
+} inference_option_t;
+
+static const inference_option_t g_inference_options[] = {
+    { "model", "--model", INFERENCE_OPTION_PATH,
+      offsetof(inference_config_t, model), 0, 0 },
+    { "input_size", "--input-size", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, input_size), 32, 4096 },
+    { "intra_op_threads", "--intra-op-threads", INFERENCE_OPTION_INT,
+      offsetof(inference_config_t, session.intra_op_threads), 0, 256 },
+    { "inter_op_threads", "--inter-op-threads", INFERENCE_OPTION_INT,
+      offsetof(inference_config_t, session.inter_op_threads), 1, 256 },
+    { "graph_optimization", "--graph-optimization", INFERENCE_OPTION_OPTIMIZATION,
+      offsetof(inference_config_t, session.graph_optimization), 0, 0 },
+    { "cpu_mem_arena", "--cpu-mem-arena", INFERENCE_OPTION_BOOL,
+      offsetof(inference_config_t, session.cpu_mem_arena), 0, 1 },
+    { "mem_pattern", "--mem-pattern", INFERENCE_OPTION_BOOL,
+      offsetof(inference_config_t, session.mem_pattern), 0, 1 },
+    { "allow_spinning", "--allow-spinning", INFERENCE_OPTION_BOOL,
+      offsetof(inference_config_t, session.allow_spinning), 0, 1 },
+    { "conf_threshold", "--conf-threshold", INFERENCE_OPTION_FLOAT,
+      offsetof(inference_config_t, conf_threshold), 0, 1 },
+    { "iou_threshold", "--iou-threshold", INFERENCE_OPTION_FLOAT,
+      offsetof(inference_config_t, iou_threshold), 0, 1 },
+    { "max_detections", "--max-detections", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, max_detections), 1, 1000 },
+    { "max_in_flight", "--max-in-flight", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, max_in_flight), 1, STAGE_PIPELINE_MAX_SLOTS },
+    { "queue_depth", "--queue-depth", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, queue_depth), 1, STAGE_PIPELINE_MAX_SLOTS },
+    { "drop_policy", "--drop-policy", INFERENCE_OPTION_POLICY,
+      offsetof(inference_config_t, drop_policy), 0, 0 },
+    { "max_frame_age_ms", "--max-frame-age-ms", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, max_frame_age_ms), 0, 10000 },
+    { "tracking", "--tracking", INFERENCE_OPTION_BOOL,
+      offsetof(inference_config_t, tracking), 0, 1 },
+    { "detect_interval_min", "--detect-interval-min", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, detect_interval_min), 1, 300 },
+    { "detect_interval_max", "--detect-interval-max", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, detect_interval_max), 1, 300 },
+    { "detector_budget", "--detector-budget", INFERENCE_OPTION_FLOAT,
+      offsetof(inference_config_t, detector_budget), 0.01, 1 },
+    { "track_confidence", "--track-confidence", INFERENCE_OPTION_FLOAT,
+      offsetof(inference_config_t, track_confidence), 0, 1 },
+    { "benchmark", "--benchmark", INFERENCE_OPTION_UINT,
+      offsetof(inference_config_t, benchmark_frames), 0, 1000000 },
+    { "expect_test_model", "--expect-test-model", INFERENCE_OPTION_BOOL,
+      offsetof(inference_config_t, expect_test_model), 0, 1 },
+};
+#define INFERENCE_OPTION_COUNT (sizeof(g_inference_options) / sizeof(g_inference_options[0]))
+
+void inference_config_init(inference_config_t* config, const char* model, uint32_t input_size,
+                           int intra_op_threads, int inter_op_threads) {
+    memset(config, 0, sizeof(*config));
+    snprintf(config->model, sizeof(config->model), "%s", model);
+    config->input_size = input_size;
+    onnx_session_options_default(&config->session);
+    config->session.intra_op_threads = intra_op_threads;
+    config->session.inter_op_threads = inter_op_threads;
+    config->conf_threshold = 0.25f;
+    config->iou_threshold = 0.45f;
+    config->max_detections = 100;
+
+    // Three frames in flight keep preprocess, inference and postprocess
+    // busy at once; older frames than the age limit are not worth finishing
+    stage_pipeline_config_t pipeline;
+    stage_pipeline_config_default(&pipeline);
+    config->max_in_flight = (uint32_t)pipeline.max_in_flight;
+    config->queue_depth = (uint32_t)pipeline.queue_depth;
+    config->drop_policy = pipeline.policy;
+    config->max_frame_age_ms = 500;
+
+    // The detector may keep half of each frame interval busy; the tracker
+    // fills in the frames between its runs
+    config->tracking = true;
+    config->detect_interval_min = 1;
+    config->detect_interval_max = 15;
+    config->detector_budget = 0.5f;
+    config->track_confidence = 0.3f;
+    config->benchmark_frames = 0;
+    config->expect_test_model = false;
+}
+
+static int inference_option_set_number(inference_config_t* config, const inference_option_t* option,
+                                       double value) {
+    void* field = (char*)config + option->offset;
+    bool integral = option->type != INFERENCE_OPTION_FLOAT;
+    if (value < option->min || value > option->max || (integral && value != (double)(long long)value)) {
+        RCUTILS_LOG_ERROR("Invalid %s: %g", option->name, value);
+        return -1;
+    }
+
+    switch (option->type) {
+        case INFERENCE_OPTION_UINT:
+            *(uint32_t*)field = (uint32_t)value;
+            return 0;
+        case INFERENCE_OPTION_INT:
+            *(int*)field = (int)value;
+            return 0;
+        case INFERENCE_OPTION_FLOAT:
+            *(float*)field = (float)value;
+            return 0;
+        case INFERENCE_OPTION_BOOL:
+            *(bool*)field = value != 0.0;
+            return 0;
+        default:
+            RCUTILS_LOG_ERROR("Parameter %s must be a string", option->name);
+            return -1;
+    }
+}
+
+static int inference_option_set_string(inference_config_t* config, const inference_option_t* option,
+                                       const char* value) {
+    void* field = (char*)config + option->offset;
+
+    switch (option->type) {
+        case INFERENCE_OPTION_PATH:
+            snprintf((char*)field, INFERENCE_CONFIG_PATH_MAX, "%s", value);
+            return 0;
+        case INFERENCE_OPTION_OPTIMIZATION:
+            if (onnx_session_parse_optimization(value, (GraphOptimizationLevel*)field) != 0) {
+                RCUTILS_LOG_ERROR("Unknown graph optimization level '%s'", value);
+                return -1;
+            }
+            return 0;
+        case INFERENCE_OPTION_POLICY:
+            if (stage_pipeline_parse_policy(value, (stage_pipeline_policy_t*)field) != 0) {
+                RCUTILS_LOG_ERROR("Unknown drop policy '%s' (oldest or newest)", value);
+                return -1;
+            }
+            return 0;
+        case INFERENCE_OPTION_BOOL:
+            if (strcasecmp(value, "true") == 0) {
+                *(bool*)field = true;
+                return 0;
+            }
+            if (strcasecmp(value, "false") == 0) {
+                *(bool*)field = false;
+                return 0;
+            }
+            break;
+        default:
+            break;
+    }
+
+    char* end = NULL;
+    double number = strtod(value, &end);
+    if (end == value || *end != '\0') {
+        RCUTILS_LOG_ERROR("Invalid %s: '%s'", option->name, value);
+        return -1;
+    }
+    return inference_option_set_number(config, option, number);
+}
+
+// Apply one set of parameters; missing ones are left alone
+static int inference_config_apply_params(inference_config_t* config, rcl_params_t* params,
+                                         const char* node_name) {
+    int result = 0;
+    for (size_t i = 0; i < INFERENCE_OPTION_COUNT; ++i) {
+        const inference_option_t* option = &g_inference_options[i];
+        rcl_variant_t* value = rcl_yaml_node_struct_get(node_name, option->name, params);
+        if (!value) {
+            continue;
+        }
+
+        int rc;
+        if (value->string_value) {
+            rc = inference_option_set_string(config, option, value->string_value);
+        } else if (value->integer_value) {
+            rc = inference_option_set_number(config, option, (double)*value->integer_value);
+        } else if (value->double_value) {
+            rc = inference_option_set_number(config, option, *value->double_value);
+        } else if (value->bool_value) {
+            rc = inference_option_set_number(config, option, *value->bool_value ? 1.0 : 0.0);
+        } else {
+            RCUTILS_LOG_ERROR("Parameter %s has an unsupported type", option->name);
+            rc = -1;
+        }
+        if (rc != 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+int inference_config_load_params(inference_config_t* config, const rcl_arguments_t* arguments,
+                                 const char* node_name) {
+    rcl_params_t* params = NULL;
+    if (rcl_arguments_get_param_overrides(arguments, &params) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to read parameter overrides");
+        return -1;
+    }
+    if (!params) {
+        return 0; // None given
+    }
+
+    // Wildcard first, so parameters addressed to this node win
+    char qualified[128];
+    snprintf(qualified, sizeof(qualified), "/%s", node_name);
+    int result = 0;
+    if (inference_config_apply_params(config, params, "/**") != 0 ||
+        inference_config_apply_params(config, params, node_name) != 0 ||
+        inference_config_apply_params(config, params, qualified) != 0) {
+        result = -1;
+    }
+
+    rcl_yaml_node_struct_fini(params);
+    return result;
+}
+
+int inference_config_parse_args(inference_config_t* config, int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+
+        // Everything up to the closing "--" belongs to rcl
+        if (strcmp(arg, "--ros-args") == 0) {
+            while (i + 1 < argc && strcmp(argv[i + 1], "--") != 0) {
+                ++i;
+            }
+            ++i;
+            continue;
+        }
+
+        if (strncmp(arg, "--", 2) != 0) {
+            continue;
+        }
+        if (i + 1 >= argc) {
+            RCUTILS_LOG_ERROR("Missing value for %s", arg);
+            return -1;
+        }
+        const char* value = argv[++i];
+
+        const inference_option_t* option = NULL;
+        for (size_t k = 0; k < INFERENCE_OPTION_COUNT; ++k) {
+            if (strcmp(arg, g_inference_options[k].flag) == 0) {
+                option = &g_inference_options[k];
+                break;
+            }
+        }
+        if (!option) {
+            RCUTILS_LOG_WARN("Ignoring unknown option %s", arg);
+            continue;
+        }
+        if (inference_option_set_string(config, option, value) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void inference_config_log(const inference_config_t* config) {
+    static const char* const optimization_names[] = { "disable", "basic", "extended" };
+    const onnx_session_options_t* session = &config->session;
+    int level = (int)session->graph_optimization;
+
+    RCUTILS_LOG_INFO("Model %s (dynamic input size %u)", config->model, config->input_size);
+    RCUTILS_LOG_INFO("Session: %d intra-op / %d inter-op threads, optimization %s, "
+        "arena %s, memory pattern %s, spinning %s",
+        session->intra_op_threads, session->inter_op_threads,
+        level >= 0 && level < 3 ? optimization_names[level] : "all",
+        session->cpu_mem_arena ? "on" : "off", session->mem_pattern ? "on" : "off",
+        session->allow_spinning ? "on" : "off");
+    RCUTILS_LOG_INFO("Detections: score >= %.2f, IoU <= %.2f, at most %u per frame",
+        config->conf_threshold, config->iou_threshold, config->max_detections);
+    RCUTILS_LOG_INFO("Pipeline: %u frames in flight, queues of %u, %s, max frame age %u ms",
+        config->max_in_flight, config->queue_depth,
+        stage_pipeline_policy_name(config->drop_policy), config->max_frame_age_ms);
+    if (config->tracking) {
+        RCUTILS_LOG_INFO("Tracking: detector every %u-%u frames at %.0f%% of the frame time, "
+            "early below track score %.2f",
+            config->detect_interval_min, config->detect_interval_max,
+            100.0f * config->detector_budget, config->track_confidence);
+    } else {
+        RCUTILS_LOG_INFO("Tracking: off, detector on every frame");
+    }
+}
@@ -0,0 +1,1198 @@
+#include "inference_node/inference_node.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <rcutils/logging_macros.h>
+#include <rosidl_runtime_c/message_type_support_struct.h>
+#include <rosidl_runtime_c/primitives_sequence_functions.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <vision_msgs/msg/detection2_d.h>
+#include <vision_msgs/msg/object_hypothesis_with_pose.h>
+
+// Global flag for signal handling
+static volatile sig_atomic_t g_running = 1;
+
+void signal_handler(int sig) {
+    (void)sig;
+    g_running = 0;
+}
+
+static int64_t inference_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static bool inference_node_running(const inference_node_t* inference) {
+    return g_running && inference->is_running;
+}
+
+static bool inference_encoding_supported(const char* encoding) {
+    return encoding && (strcmp(encoding, "yuv422_yuy2") == 0 || strcmp(encoding, "yuyv") == 0);
+}
+
+static const char* const g_stage_names[INFERENCE_STAGE_COUNT] = {
+    "preprocess", "inference", "postprocess"
+};
+
+// Latency stages on /diagnostics; the last one is end to end. detector is
+// submit to result with tracking (take_to_publish is then the tracker).
+enum { INFERENCE_LATENCY_TAKE, INFERENCE_LATENCY_PUBLISH, INFERENCE_LATENCY_DETECTOR,
+       INFERENCE_LATENCY_TOTAL, INFERENCE_LATENCY_STAGES };
+static const char* const g_latency_stages[INFERENCE_LATENCY_STAGES] = {
+    "capture_to_take", "take_to_publish", "detector", "capture_to_publish",
+};
+
+// Occupancy is the share of the interval a stage thread spent running its
+// frames: the busiest stage sets the frame rate, and queue waits show
+// where frames sit before it
+static void inference_node_log_stats(inference_node_t* inference) {
+    stage_pipeline_stats_t stats;
+    stage_pipeline_take_stats(&inference->pipeline, &stats);
+    if (!stats.submitted && !stats.completed) {
+        return;
+    }
+
+    double seconds = stats.interval_ns / 1e9;
+    RCUTILS_LOG_INFO("Pipeline: %llu frames in %.1f s (%.1f fps), latency avg %.1f ms, max %.1f ms, "
+        "up to %d in flight, dropped %llu oldest / %llu newest",
+        (unsigned long long)stats.completed, seconds, seconds > 0.0 ? stats.completed / seconds : 0.0,
+        stats.completed ? (double)stats.latency_sum_ns / stats.completed / 1e6 : 0.0,
+        stats.latency_max_ns / 1e6, stats.in_flight_max,
+        (unsigned long long)stats.dropped_oldest, (unsigned long long)stats.dropped_newest);
+
+    for (int s = 0; s < INFERENCE_STAGE_COUNT; ++s) {
+        const stage_pipeline_stage_stats_t* stage = &stats.stages[s];
+        double frames = stage->frames ? (double)stage->frames : 1.0;
+        RCUTILS_LOG_INFO("  %-11s occupancy %3.0f%%, %.2f ms/frame, queue wait avg %.2f ms, "
+            "max %.2f ms, blocked %.0f%%, %llu failed, %llu stale",
+            g_stage_names[s], stats.interval_ns ? 100.0 * stage->busy_ns / stats.interval_ns : 0.0,
+            stage->busy_ns / frames / 1e6, stage->wait_sum_ns / frames / 1e6,
+            stage->wait_max_ns / 1e6,
+            stats.interval_ns ? 100.0 * stage->blocked_ns / stats.interval_ns : 0.0,
+            (unsigned long long)stage->failed, (unsigned long long)stage->stale);
+    }
+}
+
+// Model, one set of tensors per pipeline slot, and the stages around it
+static int inference_node_init_model(inference_node_t* inference) {
+    const inference_config_t* config = &inference->config;
+
+    if (onnx_session_init(&inference->session, config->model, &config->session,
+                          (int)config->input_size, (int)config->input_size,
+                          (int)config->max_in_flight) != 0) {
+        return -1;
+    }
+    inference->session_ready = true;
+
+    // YOLO convention: RGB scaled to 0-1, letterboxed with gray. The tensor
+    // is written straight into the bound model input of the frame's slot.
+    preprocess_config_t pre_config;
+    preprocess_config_default(&pre_config);
+    pre_config.width = onnx_session_input_width(&inference->session);
+    pre_config.height = onnx_session_input_height(&inference->session);
+    pre_config.pad_value = INFERENCE_PAD_VALUE;
+    if (preprocess_tensor_size(&pre_config) != inference->session.input.count * sizeof(float) ||
+        preprocess_init(&inference->preprocess, &pre_config) != 0) {
+        RCUTILS_LOG_ERROR("Cannot preprocess into the model input");
+        return -1;
+    }
+    inference->preprocess_ready = true;
+
+    postprocess_config_t post_config;
+    postprocess_config_default(&post_config);
+    post_config.conf_threshold = config->conf_threshold;
+    post_config.iou_threshold = config->iou_threshold;
+    post_config.max_detections = (int)config->max_detections;
+    const onnx_tensor_t* output = &inference->session.outputs[0];
+    if (postprocess_init(&inference->postprocess, &post_config, output->dims, output->dim_count) != 0) {
+        return -1;
+    }
+    inference->postprocess_ready = true;
+    RCUTILS_LOG_INFO("Decoding %s output: %d candidates, %d classes (kernel: %s)",
+        postprocess_layout_name(inference->postprocess.layout),
+        inference->postprocess.candidates, inference->postprocess.classes,
+        color_convert_isa_name(inference->postprocess.isa));
+
+    inference->detections = calloc(config->max_detections, sizeof(postprocess_detection_t));
+    if (!inference->detections) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < config->max_in_flight; ++i) {
+        if (!sensor_msgs__msg__Image__init(&inference->frames[i].image)) {
+            RCUTILS_LOG_ERROR("Failed to create image message");
+            return -1;
+        }
+        inference->frame_count++;
+    }
+    return 0;
+}
+
+// The detection array is sized for max_detections once, including the
+// class id strings, so filling it never allocates
+static int inference_node_init_messages(inference_node_t* inference) {
+    if (!sensor_msgs__msg__Image__init(&inference->discard) ||
+        !vision_msgs__msg__Detection2DArray__init(&inference->detections_msg)) {
+        RCUTILS_LOG_ERROR("Failed to create messages");
+        return -1;
+    }
+    inference->messages_ready = true;
+
+    vision_msgs__msg__Detection2D__Sequence* detections = &inference->detections_msg.detections;
+    if (!vision_msgs__msg__Detection2D__Sequence__init(detections, inference->config.max_detections)) {
+        RCUTILS_LOG_ERROR("Failed to create detection array");
+        return -1;
+    }
+    for (size_t i = 0; i < detections->capacity; ++i) {
+        vision_msgs__msg__Detection2D* detection = &detections->data[i];
+        if (!vision_msgs__msg__ObjectHypothesisWithPose__Sequence__init(&detection->results, 1) ||
+            !rosidl_runtime_c__String__assign(&detection->results.data[0].hypothesis.class_id,
+                                              "-2147483648") ||
+            !rosidl_runtime_c__String__assign(&detection->id, "4294967295")) {
+            RCUTILS_LOG_ERROR("Failed to create detection array");
+            return -1;
+        }
+        detection->id.data[0] = '\0';
+        detection->id.size = 0;
+    }
+    detections->size = 0;
+
+    inference->descriptor_msg = embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    if (!inference->descriptor_msg) {
+        RCUTILS_LOG_ERROR("Failed to create frame descriptor message");
+        return -1;
+    }
+    return 0;
+}
+
+// Only the newest frame matters: the intake never falls behind, and a
+// deeper middleware queue would only hold frames that are already old
+static rcl_subscription_options_t inference_subscription_options(void) {
+    rcl_subscription_options_t sub_options = rcl_subscription_get_default_options();
+    sub_options.qos.depth = 1;
+    return sub_options;
+}
+
+static int inference_node_subscribe_raw(inference_node_t* inference) {
+    rcl_subscription_options_t sub_options = inference_subscription_options();
+    inference->subscription = rcl_get_zero_initialized_subscription();
+    if (rcl_subscription_init(&inference->subscription, &inference->node,
+                              ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image),
+                              INFERENCE_IMAGE_TOPIC, &sub_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize subscription");
+        return -1;
+    }
+    inference->raw_subscribed = true;
+    return 0;
+}
+
+static int inference_node_subscribe_descriptors(inference_node_t* inference) {
+    rcl_subscription_options_t sub_options = inference_subscription_options();
+    inference->descriptor_subscription = rcl_get_zero_initialized_subscription();
+    if (rcl_subscription_init(&inference->descriptor_subscription, &inference->node,
+                              ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg, FrameDescriptor),
+                              INFERENCE_DESCRIPTOR_TOPIC, &sub_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize descriptor subscription");
+        return -1;
+    }
+    inference->ring_subscribed = true;
+    return 0;
+}
+
+static int inference_node_init_ros(inference_node_t* inference, rcl_context_t* context) {
+    rcl_node_options_t node_options = rcl_node_get_default_options();
+    if (rcl_node_init(&inference->node, "inference_node", "", context, &node_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize ROS2 node");
+        return -1;
+    }
+    inference->ros_ready = true;
+
+    // Frame descriptors when sharing memory with the camera, otherwise the
+    // serialized images, as in display_node
+    int sub_result = INFERENCE_USE_FRAME_RING ?
+        inference_node_subscribe_descriptors(inference) : inference_node_subscribe_raw(inference);
+    if (sub_result != 0) {
+        return -1;
+    }
+
+    rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
+    inference->publisher = rcl_get_zero_initialized_publisher();
+    if (rcl_publisher_init(&inference->publisher, &inference->node,
+                           ROSIDL_GET_MSG_TYPE_SUPPORT(vision_msgs, msg, Detection2DArray),
+                           INFERENCE_DETECTIONS_TOPIC, &pub_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize detections publisher");
+        return -1;
+    }
+    inference->publisher_ready = true;
+
+    if (latency_diagnostics_init(&inference->latency, &inference->node, "inference_node",
+                                 g_latency_stages, INFERENCE_LATENCY_STAGES) == 0) {
+        inference->latency_ready = true;
+    } else {
+        RCUTILS_LOG_WARN("Latency diagnostics unavailable");
+    }
+
+    // Raw images and descriptors
+    inference->wait_set = rcl_get_zero_initialized_wait_set();
+    if (rcl_wait_set_init(&inference->wait_set, 2, 0, 0, 0, 0, 0, context,
+                          rcl_get_default_allocator()) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize wait set");
+        return -1;
+    }
+    return inference_node_init_messages(inference);
+}
+
+// Tracker, the request ring with one tracker snapshot per pending
+// detector frame, and the results queue
+static int inference_node_init_tracking(inference_node_t* inference) {
+    const inference_config_t* config = &inference->config;
+
+    tracker_config_t tracker_config;
+    tracker_config_default(&tracker_config);
+    if (tracker_init(&inference->tracker, &tracker_config) != 0) {
+        return -1;
+    }
+    inference->tracker_ready = true;
+
+    inference->requests = calloc(INFERENCE_TRACK_REQUESTS, sizeof(inference_request_t));
+    inference->track_detections = calloc(config->max_detections, sizeof(postprocess_detection_t));
+    if (!inference->requests || !inference->track_detections) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    for (int i = 0; i < INFERENCE_TRACK_RESULTS; ++i) {
+        inference->results[i].detections = calloc(config->max_detections, sizeof(postprocess_detection_t));
+        if (!inference->results[i].detections) {
+            RCUTILS_LOG_ERROR("Out of memory");
+            return -1;
+        }
+    }
+    pthread_mutex_init(&inference->results_mutex, NULL);
+    inference->results_ready = true;
+
+    inference->detect_interval = (int)config->detect_interval_min;
+    inference->tracking = true;
+    return 0;
+}
+
+static int inference_stage_preprocess(void* context, int slot);
+static int inference_stage_inference(void* context, int slot);
+static int inference_stage_postprocess(void* context, int slot);
+
+// Started last: the stage threads use everything above
+static int inference_node_init_pipeline(inference_node_t* inference, bool offline) {
+    static const stage_pipeline_stage_t stages[INFERENCE_STAGE_COUNT] = {
+        { "preprocess", inference_stage_preprocess },
+        { "inference", inference_stage_inference },
+        { "postprocess", inference_stage_postprocess },
+    };
+    const inference_config_t* config = &inference->config;
+
+    // Offline every frame counts, however long it takes
+    stage_pipeline_config_t pipeline_config;
+    stage_pipeline_config_default(&pipeline_config);
+    pipeline_config.max_in_flight = (int)config->max_in_flight;
+    pipeline_config.queue_depth = (int)config->queue_depth;
+    pipeline_config.policy = config->drop_policy;
+    pipeline_config.max_age_ns = offline ? 0 : (int64_t)config->max_frame_age_ms * 1000000LL;
+    if (stage_pipeline_init(&inference->pipeline, &pipeline_config, stages, INFERENCE_STAGE_COUNT,
+                            inference) != 0) {
+        return -1;
+    }
+    inference->pipeline_ready = true;
+    return 0;
+}
+
+int inference_node_init(inference_node_t* inference, rcl_context_t* context,
+                        const inference_config_t* config) {
+    memset(inference, 0, sizeof(inference_node_t));
+    inference->config = *config;
+    inference->is_running = true;
+
+    // The offline benchmark measures the detector alone
+    bool tracking = context && config->tracking;
+    if (inference_node_init_model(inference) != 0 ||
+        (context && inference_node_init_ros(inference, context) != 0) ||
+        (tracking && inference_node_init_tracking(inference) != 0) ||
+        inference_node_init_pipeline(inference, context == NULL) != 0) {
+        inference_node_fini(inference);
+        return -1;
+    }
+
+    RCUTILS_LOG_INFO("Inference node initialized successfully");
+    return 0;
+}
+
+void inference_node_fini(inference_node_t* inference) {
+    // Stop the stages first, they publish and use the model
+    if (inference->pipeline_ready) {
+        stage_pipeline_fini(&inference->pipeline);
+        inference->pipeline_ready = false;
+    }
+
+    if (inference->ring_frames || inference->ring_stale) {
+        RCUTILS_LOG_INFO("Received %llu frames from the shared ring, %llu stale descriptors, "
+            "%llu still frames not detected",
+            (unsigned long long)inference->ring_frames, (unsigned long long)inference->ring_stale,
+            (unsigned long long)inference->still_skipped);
+    }
+    if (inference->frames_received || inference->frames_processed || inference->frames_unsupported) {
+        RCUTILS_LOG_INFO("Received %llu frames, processed %llu, skipped %llu in unsupported "
+            "encodings, published %llu detections",
+            (unsigned long long)inference->frames_received,
+            (unsigned long long)inference->frames_processed,
+            (unsigned long long)inference->frames_unsupported,
+            (unsigned long long)inference->detections_published);
+    }
+
+    if (inference->tracker_ready) {
+        RCUTILS_LOG_INFO("Tracked %llu frames: %llu tracks started, %llu ID switches, "
+            "%llu detector results dropped",
+            (unsigned long long)inference->step,
+            (unsigned long long)inference->tracker.state.started,
+            (unsigned long long)inference->tracker.state.id_switches,
+            (unsigned long long)inference->results_dropped);
+        tracker_fini(&inference->tracker);
+        inference->tracker_ready = false;
+    }
+    if (inference->results_ready) {
+        pthread_mutex_destroy(&inference->results_mutex);
+        inference->results_ready = false;
+    }
+    for (int i = 0; i < INFERENCE_TRACK_RESULTS; ++i) {
+        free(inference->results[i].detections);
+        inference->results[i].detections = NULL;
+    }
+    free(inference->requests);
+    inference->requests = NULL;
+    free(inference->track_detections);
+    inference->track_detections = NULL;
+    inference->tracking = false;
+
+    if (inference->messages_ready) {
+        sensor_msgs__msg__Image__fini(&inference->discard);
+        vision_msgs__msg__Detection2DArray__fini(&inference->detections_msg);
+        inference->messages_ready = false;
+    }
+    if (inference->descriptor_msg) {
+        embedded_object_detection_pi5__msg__FrameDescriptor__destroy(inference->descriptor_msg);
+        inference->descriptor_msg = NULL;
+    }
+    if (inference->ring_open) {
+        frame_ring_close(&inference->frame_ring);
+        inference->ring_open = false;
+    }
+
+    if (inference->ros_ready) {
+        rcl_wait_set_fini(&inference->wait_set);
+        if (inference->publisher_ready) {
+            rcl_publisher_fini(&inference->publisher, &inference->node);
+            inference->publisher_ready = false;
+        }
+        if (inference->latency_ready) {
+            latency_diagnostics_fini(&inference->latency);
+            inference->latency_ready = false;
+        }
+        if (inference->ring_subscribed) {
+            rcl_subscription_fini(&inference->descriptor_subscription, &inference->node);
+            inference->ring_subscribed = false;
+        }
+        if (inference->raw_subscribed) {
+            rcl_subscription_fini(&inference->subscription, &inference->node);
+            inference->raw_subscribed = false;
+        }
+        rcl_node_fini(&inference->node);
+        inference->ros_ready = false;
+    }
+
+    for (int i = 0; i < inference->frame_count; ++i) {
+        sensor_msgs__msg__Image__fini(&inference->frames[i].image);
+    }
+    inference->frame_count = 0;
+
+    free(inference->detections);
+    inference->detections = NULL;
+    if (inference->postprocess_ready) {
+        postprocess_fini(&inference->postprocess);
+        inference->postprocess_ready = false;
+    }
+    if (inference->preprocess_ready) {
+        preprocess_fini(&inference->preprocess);
+        inference->preprocess_ready = false;
+    }
+    if (inference->session_ready) {
+        onnx_session_fini(&inference->session);
+        inference->session_ready = false;
+    }
+}
+
+static float inference_clamp(float value, float max) {
+    return value < 0.0f ? 0.0f : (value > max ? max : value);
+}
+
+// Stage 0: camera frame -> the slot's input tensor
+static int inference_stage_preprocess(void* context, int slot) {
+    inference_node_t* inference = (inference_node_t*)context;
+    inference_frame_t* frame = &inference->frames[slot];
+    const sensor_msgs__msg__Image* image = &frame->image;
+
+    if (!inference_encoding_supported(image->encoding.data)) {
+        if (inference->frames_unsupported++ == 0) {
+            RCUTILS_LOG_WARN("Skipping frames in encoding %s, only yuv422_yuy2 is supported",
+                image->encoding.data ? image->encoding.data : "(none)");
+        }
+        return -1;
+    }
+    if (image->step < image->width * 2 || image->data.size < (size_t)image->step * image->height) {
+        RCUTILS_LOG_ERROR("Image data does not match its %ux%u geometry", image->width, image->height);
+        return -1;
+    }
+
+    if (preprocess_yuyv(&inference->preprocess, image->data.data, (int)image->step,
+                        (int)image->width, (int)image->height,
+                        inference->session.slots[slot].input) != 0) {
+        RCUTILS_LOG_ERROR("Cannot preprocess a %ux%u frame", image->width, image->height);
+        return -1;
+    }
+    frame->letterbox = inference->preprocess.letterbox;
+    return 0;
+}
+
+// Stage 1: the model, on the slot's bound tensors
+static int inference_stage_inference(void* context, int slot) {
+    inference_node_t* inference = (inference_node_t*)context;
+    return onnx_session_run(&inference->session, slot);
+}
+
+// One entry of the preallocated detection array; track id 0 leaves the
+// id empty (untracked detections)
+static void inference_set_detection(vision_msgs__msg__Detection2D* detection, float x1, float y1,
+                                    float x2, float y2, float score, int32_t class_id, uint32_t id) {
+    detection->bbox.center.position.x = (x1 + x2) * 0.5;
+    detection->bbox.center.position.y = (y1 + y2) * 0.5;
+    detection->bbox.center.theta = 0.0;
+    detection->bbox.size_x = x2 - x1;
+    detection->bbox.size_y = y2 - y1;
+
+    if (id) {
+        snprintf(detection->id.data, detection->id.capacity, "%u", id);
+        detection->id.size = strlen(detection->id.data);
+    } else {
+        detection->id.data[0] = '\0';
+        detection->id.size = 0;
+    }
+
+    vision_msgs__msg__ObjectHypothesis* hypothesis = &detection->results.data[0].hypothesis;
+    snprintf(hypothesis->class_id.data, hypothesis->class_id.capacity, "%d", class_id);
+    hypothesis->class_id.size = strlen(hypothesis->class_id.data);
+    hypothesis->score = score;
+}
+
+// Publish the first count entries of the detection array, filled in place,
+// with the header of the frame they belong to
+static int inference_node_publish(inference_node_t* inference, const std_msgs__msg__Header* header,
+                                  int64_t take_ns, int count) {
+    vision_msgs__msg__Detection2DArray* msg = &inference->detections_msg;
+
+    msg->header.stamp = header->stamp;
+    if (header->frame_id.data && (!msg->header.frame_id.data ||
+                                  strcmp(msg->header.frame_id.data, header->frame_id.data) != 0)) {
+        rosidl_runtime_c__String__assign(&msg->header.frame_id, header->frame_id.data);
+    }
+    for (int i = 0; i < count; ++i) {
+        msg->detections.data[i].header.stamp = header->stamp;
+    }
+    msg->detections.size = (size_t)count;
+
+    rcl_ret_t ret = rcl_publish(&inference->publisher, msg, NULL);
+    msg->detections.size = 0;
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to publish detections");
+        return -1;
+    }
+    inference->detections_published += (uint64_t)count;
+
+    if (inference->latency_ready) {
+        int64_t now_ns = inference_now_ns();
+        latency_diagnostics_record(&inference->latency, INFERENCE_LATENCY_PUBLISH, now_ns - take_ns);
+        if (header->stamp.sec != 0 || header->stamp.nanosec != 0) {
+            latency_diagnostics_record(&inference->latency, INFERENCE_LATENCY_TOTAL,
+                                       now_ns - latency_stamp_to_monotonic(&header->stamp));
+        }
+    }
+    return 0;
+}
+
+// Hand a detector result to the intake thread; a full queue loses its
+// oldest result, which a newer one supersedes anyway
+static void inference_node_post_result(inference_node_t* inference, uint64_t step, int count) {
+    pthread_mutex_lock(&inference->results_mutex);
+    if (inference->result_count == INFERENCE_TRACK_RESULTS) {
+        inference->result_head = (inference->result_head + 1) % INFERENCE_TRACK_RESULTS;
+        inference->result_count--;
+        inference->results_dropped++;
+    }
+    inference_result_t* result =
+        &inference->results[(inference->result_head + inference->result_count) % INFERENCE_TRACK_RESULTS];
+    result->step = step;
+    result->count = count;
+    memcpy(result->detections, inference->detections, (size_t)count * sizeof(postprocess_detection_t));
+    inference->result_count++;
+    pthread_mutex_unlock(&inference->results_mutex);
+}
+
+// Stage 2: decode the slot's outputs into camera pixels and publish them,
+// or hand them to the tracker
+static int inference_stage_postprocess(void* context, int slot) {
+    inference_node_t* inference = (inference_node_t*)context;
+    const inference_frame_t* frame = &inference->frames[slot];
+    const sensor_msgs__msg__Image* image = &frame->image;
+
+    int count = postprocess_run(&inference->postprocess, inference->session.slots[slot].outputs[0],
+                                inference->detections, (int)inference->config.max_detections);
+
+    // Tensor pixels -> camera pixels
+    for (int i = 0; i < count; ++i) {
+        postprocess_detection_t* box = &inference->detections[i];
+        preprocess_to_source(&frame->letterbox, box->x1, box->y1, &box->x1, &box->y1);
+        preprocess_to_source(&frame->letterbox, box->x2, box->y2, &box->x2, &box->y2);
+        box->x1 = inference_clamp(box->x1, (float)image->width);
+        box->y1 = inference_clamp(box->y1, (float)image->height);
+        box->x2 = inference_clamp(box->x2, (float)image->width);
+        box->y2 = inference_clamp(box->y2, (float)image->height);
+    }
+    inference->detection_count = count;
+
+    int result = 0;
+    if (inference->tracking) {
+        inference_node_post_result(inference, frame->step, count);
+    } else if (inference->publisher_ready) {
+        vision_msgs__msg__Detection2D* detections = inference->detections_msg.detections.data;
+        for (int i = 0; i < count; ++i) {
+            const postprocess_detection_t* box = &inference->detections[i];
+            inference_set_detection(&detections[i], box->x1, box->y1, box->x2, box->y2,
+                                    box->score, box->class_id, 0);
+        }
+        result = inference_node_publish(inference, &image->header, frame->take_ns, count);
+    }
+    if (++inference->frames_processed % INFERENCE_STATS_INTERVAL == 0) {
+        inference_node_log_stats(inference);
+    }
+    return result;
+}
+
+// The ring named in the descriptors cannot be mapped (e.g. the camera runs
+// on another host): stop listening for descriptors and take raw images
+static void inference_node_fall_back_to_raw(inference_node_t* inference) {
+    RCUTILS_LOG_WARN("Frame ring unavailable, subscribing to %s instead", INFERENCE_IMAGE_TOPIC);
+    rcl_subscription_fini(&inference->descriptor_subscription, &inference->node);
+    inference->ring_subscribed = false;
+
+    if (!inference->raw_subscribed && inference_node_subscribe_raw(inference) != 0) {
+        inference->is_running = false;
+    }
+}
+
+// Copy a ring slot into a pipeline frame and release it right away, so
+// the camera never runs short of slots while inference is slow
+static int inference_frame_copy_view(inference_frame_t* frame, const frame_ring_view_t* view,
+                                     const std_msgs__msg__Header* header) {
+    sensor_msgs__msg__Image* image = &frame->image;
+
+    if (image->data.capacity < view->size) {
+        rosidl_runtime_c__uint8__Sequence__fini(&image->data);
+        if (!rosidl_runtime_c__uint8__Sequence__init(&image->data, view->size)) {
+            RCUTILS_LOG_ERROR("Failed to allocate %u byte frame", view->size);
+            return -1;
+        }
+    }
+    memcpy(image->data.data, view->data, view->size);
+    image->data.size = view->size;
+
+    // Encoding and frame id practically never change; avoid reallocating them
+    if (!image->encoding.data || strcmp(image->encoding.data, view->encoding) != 0) {
+        if (!rosidl_runtime_c__String__assign(&image->encoding, view->encoding)) {
+            return -1;
+        }
+    }
+    if (header->frame_id.data && (!image->header.frame_id.data ||
+                                  strcmp(image->header.frame_id.data, header->frame_id.data) != 0)) {
+        if (!rosidl_runtime_c__String__assign(&image->header.frame_id, header->frame_id.data)) {
+            return -1;
+        }
+    }
+    image->header.stamp = header->stamp;
+
+    image->width = view->width;
+    image->height = view->height;
+    image->step = view->step;
+    return 0;
+}
+
+int inference_node_handle_descriptor(inference_node_t* inference,
+    const embedded_object_detection_pi5__msg__FrameDescriptor* desc,
+    inference_frame_t* frame) {
+    if (inference->ring_open && strcmp(inference->frame_ring.name, desc->ring_name.data) != 0) {
+        frame_ring_close(&inference->frame_ring);
+        inference->ring_open = false;
+    }
+
+    if (!inference->ring_open) {
+        if (frame_ring_open(&inference->frame_ring, desc->ring_name.data) != 0) {
+            inference_node_fall_back_to_raw(inference);
+            return -1;
+        }
+        inference->ring_open = true;
+        RCUTILS_LOG_INFO("Reading frames from shared ring %s", desc->ring_name.data);
+    }
+
+    frame_ring_view_t view;
+    if (frame_ring_acquire(&inference->frame_ring, desc->slot, desc->sequence, &view) != 0) {
+        inference->ring_stale++;
+
+        // A restarted camera replaces the ring; our mapping then never
+        // matches again, so remap after a run of misses
+        if (inference->frame_ring.stale_count >= INFERENCE_RING_REOPEN_AFTER) {
+            frame_ring_close(&inference->frame_ring);
+            inference->ring_open = false;
+        }
+        return -1;
+    }
+
+    int result = inference_frame_copy_view(frame, &view, &desc->header);
+    frame_ring_release(&inference->frame_ring, desc->slot);
+    inference->ring_frames++;
+    return result;
+}
+
+static inference_request_t* inference_request_at(inference_node_t* inference, int index) {
+    return &inference->requests[(inference->request_head + index) % INFERENCE_TRACK_REQUESTS];
+}
+
+static void inference_request_pop(inference_node_t* inference) {
+    inference->request_head = (inference->request_head + 1) % INFERENCE_TRACK_REQUESTS;
+    inference->request_count--;
+}
+
+static void inference_average(double* average, double sample) {
+    *average = *average > 0.0 ? *average + 0.1 * (sample - *average) : sample;
+}
+
+// Run the detector just often enough to keep it within its share of the
+// frame time: N = latency / (frame interval x budget)
+static void inference_node_adapt_interval(inference_node_t* inference) {
+    const inference_config_t* config = &inference->config;
+    int interval = (int)config->detect_interval_min;
+    if (inference->frame_interval_ns > 0.0) {
+        double frames = inference->latency_ns / (inference->frame_interval_ns * config->detector_budget);
+        interval = frames < (double)config->detect_interval_max ? (int)ceil(frames) :
+                                                                  (int)config->detect_interval_max;
+    }
+    if (interval < (int)config->detect_interval_min) {
+        interval = (int)config->detect_interval_min;
+    }
+    inference->detect_interval = interval;
+}
+
+// Every detect_interval frames, or sooner once a track has coasted too
+// long, but not while a detection is already on its way
+static bool inference_node_want_detection(const inference_node_t* inference) {
+    if (!inference->tracking) {
+        return true;
+    }
+    const inference_config_t* config = &inference->config;
+    uint64_t since = inference->step + 1 - inference->last_request_step;
+    if (since >= (uint64_t)inference->detect_interval) {
+        return true;
+    }
+    return since >= config->detect_interval_min && inference->request_count == 0 &&
+           tracker_min_confidence(&inference->tracker) < config->track_confidence;
+}
+
+// Apply the detections of frame step: rewind the tracker to that frame,
+// update it, and predict forward to the current frame again
+static void inference_node_apply_result(inference_node_t* inference, uint64_t step, int count) {
+    // Results come back in frame order; older requests were dropped on the way
+    while (inference->request_count > 0 && inference_request_at(inference, 0)->step < step) {
+        inference_request_pop(inference);
+    }
+    if (inference->request_count == 0 || inference_request_at(inference, 0)->step != step) {
+        return;
+    }
+
+    inference_request_t* request = inference_request_at(inference, 0);
+    int64_t detector_ns = inference_now_ns() - request->submit_ns;
+    inference_average(&inference->latency_ns, (double)detector_ns);
+    if (inference->latency_ready) {
+        latency_diagnostics_record(&inference->latency, INFERENCE_LATENCY_DETECTOR, detector_ns);
+    }
+    inference->tracker.state = request->state;
+    inference_request_pop(inference);
+    tracker_update(&inference->tracker, inference->track_detections, count);
+
+    // Requests still pending were saved without this result; they take
+    // the replayed state of their frame instead
+    int pending = 0;
+    for (uint64_t frame = step + 1; frame <= inference->step; ++frame) {
+        tracker_predict(&inference->tracker);
+        if (pending < inference->request_count && inference_request_at(inference, pending)->step == frame) {
+            inference_request_at(inference, pending)->state = inference->tracker.state;
+            pending++;
+        }
+    }
+
+    inference->track_results++;
+    inference_node_adapt_interval(inference);
+}
+
+static void inference_node_apply_results(inference_node_t* inference) {
+    for (;;) {
+        pthread_mutex_lock(&inference->results_mutex);
+        if (inference->result_count == 0) {
+            pthread_mutex_unlock(&inference->results_mutex);
+            return;
+        }
+        const inference_result_t* result = &inference->results[inference->result_head];
+        uint64_t step = result->step;
+        int count = result->count;
+        memcpy(inference->track_detections, result->detections,
+               (size_t)count * sizeof(postprocess_detection_t));
+        inference->result_head = (inference->result_head + 1) % INFERENCE_TRACK_RESULTS;
+        inference->result_count--;
+        pthread_mutex_unlock(&inference->results_mutex);
+
+        inference_node_apply_result(inference, step, count);
+    }
+}
+
+// Duty cycle is the share of camera frames the detector ran on; ID
+// switches are tracks started where another one was recently lost
+static void inference_node_log_tracking(inference_node_t* inference) {
+    if (!inference->track_frames) {
+        return;
+    }
+    const tracker_state_t* state = &inference->tracker.state;
+    RCUTILS_LOG_INFO("Tracking: %d tracks, detector on %llu of %llu frames (%.0f%%), %llu results, "
+        "every %d frames, latency %.1f ms at %.1f ms/frame, %llu tracks started, %llu ID switches",
+        state->count, (unsigned long long)inference->track_requests,
+        (unsigned long long)inference->track_frames,
+        100.0 * inference->track_requests / inference->track_frames,
+        (unsigned long long)inference->track_results, inference->detect_interval,
+        inference->latency_ns / 1e6, inference->frame_interval_ns / 1e6,
+        (unsigned long long)state->started, (unsigned long long)state->id_switches);
+    inference->track_frames = 0;
+    inference->track_requests = 0;
+    inference->track_results = 0;
+}
+
+// One camera frame; slot holds it if it goes to the detector (-1 if not).
+// With tracking, the tracker's boxes are published for every frame.
+static void inference_node_track_frame(inference_node_t* inference, const std_msgs__msg__Header* header,
+                                       uint32_t width, uint32_t height, int slot, int64_t take_ns) {
+    if (slot >= 0) {
+        inference->frames[slot].take_ns = take_ns;
+    }
+    if (!inference->tracking) {
+        if (slot >= 0) {
+            stage_pipeline_submit(&inference->pipeline, slot);
+        }
+        return;
+    }
+
+    int64_t now_ns = take_ns;
+    if (inference->last_frame_ns) {
+        inference_average(&inference->frame_interval_ns, (double)(now_ns - inference->last_frame_ns));
+    }
+    inference->last_frame_ns = now_ns;
+
+    inference_node_apply_results(inference);
+    tracker_predict(&inference->tracker);
+    inference->step++;
+    inference->track_frames++;
+
+    if (slot >= 0) {
+        // A full ring means the oldest result is never coming back
+        if (inference->request_count == INFERENCE_TRACK_REQUESTS) {
+            inference_request_pop(inference);
+        }
+        inference_request_t* request = inference_request_at(inference, inference->request_count++);
+        request->step = inference->step;
+        request->submit_ns = now_ns;
+        request->state = inference->tracker.state;
+        inference->frames[slot].step = inference->step;
+        inference->last_request_step = inference->step;
+        inference->track_requests++;
+        stage_pipeline_submit(&inference->pipeline, slot);
+    }
+
+    int max = (int)inference->config.max_detections < TRACKER_MAX_TRACKS ?
+              (int)inference->config.max_detections : TRACKER_MAX_TRACKS;
+    int count = tracker_output(&inference->tracker, inference->track_output, max);
+    vision_msgs__msg__Detection2D* detections = inference->detections_msg.detections.data;
+    for (int i = 0; i < count; ++i) {
+        const tracker_output_t* track = &inference->track_output[i];
+        inference_set_detection(&detections[i],
+            inference_clamp(track->x1, (float)width), inference_clamp(track->y1, (float)height),
+            inference_clamp(track->x2, (float)width), inference_clamp(track->y2, (float)height),
+            track->score, track->class_id, track->id);
+    }
+    inference_node_publish(inference, header, take_ns, count);
+
+    if (inference->step % INFERENCE_STATS_INTERVAL == 0) {
+        inference_node_log_tracking(inference);
+    }
+}
+
+// Time a frame was taken, recording its capture-to-take latency
+static int64_t inference_node_trace_take(inference_node_t* inference, const std_msgs__msg__Header* header) {
+    int64_t take_ns = inference_now_ns();
+    if (inference->latency_ready && (header->stamp.sec != 0 || header->stamp.nanosec != 0)) {
+        latency_diagnostics_record(&inference->latency, INFERENCE_LATENCY_TAKE,
+                                   take_ns - latency_stamp_to_monotonic(&header->stamp));
+    }
+    return take_ns;
+}
+
+// Take a raw image, straight into a free slot if it goes to the detector.
+// Otherwise the message is still taken (and dropped after tracking), so
+// the middleware never holds a stale frame.
+static void inference_node_take_raw(inference_node_t* inference) {
+    int slot = inference_node_want_detection(inference) ?
+               stage_pipeline_acquire(&inference->pipeline, false) : -1;
+    sensor_msgs__msg__Image* image = slot >= 0 ? &inference->frames[slot].image : &inference->discard;
+
+    rmw_message_info_t message_info;
+    rcl_ret_t ret = rcl_take(&inference->subscription, image, &message_info, NULL);
+    if (ret != RCL_RET_OK) {
+        if (ret != RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+            RCUTILS_LOG_ERROR("Failed to take message");
+        }
+        if (slot >= 0) {
+            stage_pipeline_cancel(&inference->pipeline, slot);
+        }
+        return;
+    }
+    inference->frames_received++;
+    int64_t take_ns = inference_node_trace_take(inference, &image->header);
+    inference_node_track_frame(inference, &image->header, image->width, image->height, slot, take_ns);
+}
+
+// Descriptors are always taken; the ring slot is only copied when the
+// frame goes to the detector and the pipeline has room for it. Frames the
+// camera marks still skip the detector.
+static void inference_node_take_descriptor(inference_node_t* inference) {
+    embedded_object_detection_pi5__msg__FrameDescriptor* desc = inference->descriptor_msg;
+    rmw_message_info_t message_info;
+    rcl_ret_t ret = rcl_take(&inference->descriptor_subscription, desc, &message_info, NULL);
+    if (ret != RCL_RET_OK) {
+        if (ret != RCL_RET_SUBSCRIPTION_TAKE_FAILED) {
+            RCUTILS_LOG_ERROR("Failed to take frame descriptor");
+        }
+        return;
+    }
+    inference->frames_received++;
+    int64_t take_ns = inference_node_trace_take(inference, &desc->header);
+
+    // Nothing moved since frames the detector (or tracker) already covered:
+    // only the first frame and an occasional still one go to the detector
+    bool skip = false;
+    if (desc->still && inference->frames_received > 1) {
+        skip = ++inference->still_run % INFERENCE_STILL_INTERVAL != 0;
+        inference->still_skipped += skip;
+    } else {
+        inference->still_run = 0;
+    }
+
+    int slot = !skip && inference_node_want_detection(inference) ?
+               stage_pipeline_acquire(&inference->pipeline, false) : -1;
+    if (slot >= 0 && inference_node_handle_descriptor(inference, desc, &inference->frames[slot]) != 0) {
+        stage_pipeline_cancel(&inference->pipeline, slot);
+        slot = -1;
+    }
+    inference_node_track_frame(inference, &desc->header, desc->width, desc->height, slot, take_ns);
+}
+
+// Intake on the main thread: take frames as they arrive and hand them to
+// the pipeline, which drops by policy when every slot is taken
+int inference_node_spin(inference_node_t* inference) {
+    rcl_ret_t ret;
+
+    while (inference_node_running(inference)) {
+        ret = rcl_wait_set_clear(&inference->wait_set);
+        if (ret != RCL_RET_OK) {
+            RCUTILS_LOG_ERROR("Failed to clear wait set");
+            return -1;
+        }
+
+        // Add active subscriptions to wait set
+        size_t raw_index = SIZE_MAX;
+        size_t ring_index = SIZE_MAX;
+        if (inference->raw_subscribed) {
+            ret = rcl_wait_set_add_subscription(&inference->wait_set, &inference->subscription,
+                                                &raw_index);
+            if (ret != RCL_RET_OK) {
+                RCUTILS_LOG_ERROR("Failed to add subscription to wait set");
+                return -1;
+            }
+        }
+        if (inference->ring_subscribed) {
+            ret = rcl_wait_set_add_subscription(&inference->wait_set,
+                                                &inference->descriptor_subscription, &ring_index);
+            if (ret != RCL_RET_OK) {
+                RCUTILS_LOG_ERROR("Failed to add descriptor subscription to wait set");
+                return -1;
+            }
+        }
+
+        // Wait for frames (100ms timeout)
+        ret = rcl_wait(&inference->wait_set, RCL_MS_TO_NS(100));
+        if (ret == RCL_RET_TIMEOUT) {
+            continue;
+        } else if (ret != RCL_RET_OK) {
+            RCUTILS_LOG_ERROR("Failed to wait on wait set");
+            return -1;
+        }
+
+        if (raw_index != SIZE_MAX && inference->wait_set.subscriptions[raw_index]) {
+            inference_node_take_raw(inference);
+        }
+        if (ring_index != SIZE_MAX && inference->wait_set.subscriptions[ring_index]) {
+            inference_node_take_descriptor(inference);
+        }
+        if (inference->latency_ready) {
+            latency_diagnostics_tick(&inference->latency, inference_now_ns());
+        }
+    }
+
+    inference_node_log_stats(inference);
+    if (inference->tracking) {
+        inference_node_log_tracking(inference);
+    }
+    return 0;
+}
+
+// Moving gradient so every frame differs a little
+static void inference_fill_synthetic(uint8_t* yuyv, int width, int height, int frame) {
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = yuyv + (size_t)y * width * 2;
+        for (int x = 0; x + 1 < width; x += 2) {
+            row[x * 2] = (uint8_t)(16 + ((x + frame) * 219 / width) % 220);
+            row[x * 2 + 1] = (uint8_t)(128 + (y * 64 / height) - 32);
+            row[x * 2 + 2] = (uint8_t)(16 + ((x + 1 + frame) * 219 / width) % 220);
+            row[x * 2 + 3] = (uint8_t)(128 - (x * 64 / width) + 32);
+        }
+    }
+}
+
+static int inference_benchmark_frame(sensor_msgs__msg__Image* image, int width, int height, int frame) {
+    size_t size = (size_t)width * height * 2;
+    if (image->data.capacity < size) {
+        rosidl_runtime_c__uint8__Sequence__fini(&image->data);
+        if (!rosidl_runtime_c__uint8__Sequence__init(&image->data, size)) {
+            RCUTILS_LOG_ERROR("Out of memory");
+            return -1;
+        }
+    }
+    if (!image->encoding.data || strcmp(image->encoding.data, "yuyv") != 0) {
+        if (!rosidl_runtime_c__String__assign(&image->encoding, "yuyv")) {
+            return -1;
+        }
+    }
+    image->width = (uint32_t)width;
+    image->height = (uint32_t)height;
+    image->step = (uint32_t)width * 2;
+    image->data.size = size;
+    inference_fill_synthetic(image->data.data, width, height, frame);
+    return 0;
+}
+
+// One detection scripts/make_test_model.py must produce, as fractions of
+// the tensor size
+typedef struct {
+    int class_id;
+    float score;
+    float cx, cy, w, h;
+} inference_expected_t;
+
+static const inference_expected_t g_test_model_detections[] = {
+    { 0, 0.90f, 0.5f, 0.5f, 0.5f, 0.5f },       // Its 0.80 neighbour is suppressed by NMS
+    { 1, 0.60f, 0.25f, 0.25f, 0.25f, 0.25f },   // The 0.20 one is below conf_threshold
+};
+#define INFERENCE_EXPECTED_COUNT (sizeof(g_test_model_detections) / sizeof(g_test_model_detections[0]))
+#define INFERENCE_EXPECT_SCORE_TOLERANCE 0.005f
+#define INFERENCE_EXPECT_BOX_TOLERANCE 1.0f // Camera pixels
+
+static bool inference_expect_near(float value, float expected, float tolerance) {
+    return fabsf(value - expected) <= tolerance;
+}
+
+// The last frame's detections must be exactly the test model's answer,
+// with boxes mapped back through the letterbox of a width x height frame
+static int inference_benchmark_check_test_model(inference_node_t* inference, int width, int height) {
+    const preprocess_config_t* config = &inference->preprocess.config;
+    preprocess_letterbox_t letterbox;
+    preprocess_compute_letterbox(config, width, height, &letterbox);
+
+    if (inference->detection_count != (int)INFERENCE_EXPECTED_COUNT) {
+        RCUTILS_LOG_ERROR("Test model: %d detections, expected %zu", inference->detection_count,
+            INFERENCE_EXPECTED_COUNT);
+        return -1;
+    }
+
+    int result = 0;
+    for (size_t i = 0; i < INFERENCE_EXPECTED_COUNT; ++i) {
+        const inference_expected_t* expected = &g_test_model_detections[i];
+        float x1, y1, x2, y2;
+        preprocess_to_source(&letterbox, (expected->cx - expected->w / 2) * config->width,
+                             (expected->cy - expected->h / 2) * config->height, &x1, &y1);
+        preprocess_to_source(&letterbox, (expected->cx + expected->w / 2) * config->width,
+                             (expected->cy + expected->h / 2) * config->height, &x2, &y2);
+        x1 = inference_clamp(x1, (float)width);
+        y1 = inference_clamp(y1, (float)height);
+        x2 = inference_clamp(x2, (float)width);
+        y2 = inference_clamp(y2, (float)height);
+
+        const postprocess_detection_t* found = NULL;
+        for (int k = 0; k < inference->detection_count; ++k) {
+            if (inference->detections[k].class_id == expected->class_id) {
+                found = &inference->detections[k];
+                break;
+            }
+        }
+        if (!found) {
+            RCUTILS_LOG_ERROR("Test model: no class %d detection", expected->class_id);
+            result = -1;
+            continue;
+        }
+        const float box_tolerance = INFERENCE_EXPECT_BOX_TOLERANCE;
+        if (!inference_expect_near(found->score, expected->score, INFERENCE_EXPECT_SCORE_TOLERANCE) ||
+            !inference_expect_near(found->x1, x1, box_tolerance) ||
+            !inference_expect_near(found->y1, y1, box_tolerance) ||
+            !inference_expect_near(found->x2, x2, box_tolerance) ||
+            !inference_expect_near(found->y2, y2, box_tolerance)) {
+            RCUTILS_LOG_ERROR("Test model: class %d score %.3f box (%.1f, %.1f)-(%.1f, %.1f), "
+                "expected %.3f (%.1f, %.1f)-(%.1f, %.1f)", expected->class_id, found->score,
+                found->x1, found->y1, found->x2, found->y2, expected->score, x1, y1, x2, y2);
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        RCUTILS_LOG_INFO("Test model: detections match");
+    }
+    return result;
+}
+
+// Feeds the pipeline as fast as it takes frames: acquire waits for a slot
+// instead of dropping, so every frame is processed
+int inference_node_benchmark(inference_node_t* inference) {
+    const int width = INFERENCE_BENCHMARK_WIDTH;
+    const int height = INFERENCE_BENCHMARK_HEIGHT;
+    const uint32_t frames = inference->config.benchmark_frames;
+
+    RCUTILS_LOG_INFO("Benchmarking %u synthetic %dx%d frames, %u in flight",
+        frames, width, height, inference->config.max_in_flight);
+    int64_t start_ns = inference_now_ns();
+    uint32_t submitted = 0;
+    while (submitted < frames && g_running) {
+        int slot = stage_pipeline_acquire(&inference->pipeline, true);
+        if (slot < 0) {
+            break;
+        }
+        if (inference_benchmark_frame(&inference->frames[slot].image, width, height,
+                                      (int)submitted) != 0) {
+            stage_pipeline_cancel(&inference->pipeline, slot);
+            break;
+        }
+        stage_pipeline_submit(&inference->pipeline, slot);
+        submitted++;
+    }
+    stage_pipeline_wait_idle(&inference->pipeline);
+    int64_t elapsed_ns = inference_now_ns() - start_ns;
+    inference_node_log_stats(inference);
+
+    uint64_t done = inference->frames_processed;
+    if (done) {
+        RCUTILS_LOG_INFO("Benchmark: %llu frames in %.2f s, %.1f fps, %d detections in the last frame",
+            (unsigned long long)done, elapsed_ns / 1e9, done / (elapsed_ns / 1e9),
+            inference->detection_count);
+    }
+    for (int i = 0; i < inference->detection_count; ++i) {
+        const postprocess_detection_t* box = &inference->detections[i];
+        RCUTILS_LOG_INFO("  class %d score %.3f box (%.1f, %.1f)-(%.1f, %.1f)", box->class_id,
+            box->score, box->x1, box->y1, box->x2, box->y2);
+    }
+    if (done != submitted || submitted == 0) {
+        return -1;
+    }
+    if (inference->config.expect_test_model) {
+        return inference_benchmark_check_test_model(inference, width, height);
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Set up signal handling
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+
+    // Initialize RCL
+    rcl_context_t context = rcl_get_zero_initialized_context();
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+
+    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize init options");
+        return 1;
+    }
+
+    ret = rcl_init(argc, (const char* const*)argv, &init_options, &context);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize RCL");
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+
+    // Defaults, then ROS parameters, then command-line flags
+    inference_config_t config;
+    inference_config_init(&config, INFERENCE_MODEL_PATH, INFERENCE_INPUT_SIZE,
+                          INFERENCE_INTRA_OP_THREADS, INFERENCE_INTER_OP_THREADS);
+    if (inference_config_load_params(&config, &context.global_arguments, "inference_node") != 0 ||
+        inference_config_parse_args(&config, argc, argv) != 0) {
+        RCUTILS_LOG_ERROR("Invalid inference configuration");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    inference_config_log(&config);
+
+    // Initialize inference node; the offline benchmark needs no ROS entities
+    bool benchmark = config.benchmark_frames > 0;
+    inference_node_t inference;
+    if (inference_node_init(&inference, benchmark ? NULL : &context, &config) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize inference node");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+
+    RCUTILS_LOG_INFO("Inference node started");
+
+    // Run inference node
+    int result = benchmark ? inference_node_benchmark(&inference) : inference_node_spin(&inference);
+
+    // Cleanup
+    inference_node_fini(&inference);
+    rcl_shutdown(&context);
+    rcl_context_fini(&context);
+    rcl_init_options_fini(&init_options);
+
+    RCUTILS_LOG_INFO("Inference node stopped");
+    return result == 0 ? 0 : 1;
+}
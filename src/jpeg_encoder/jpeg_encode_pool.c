@@ -0,0 +1,127 @@
+#include "jpeg_encoder/jpeg_encode_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <rcutils/logging_macros.h>
+
+static void* jpeg_encode_worker_main(void* arg) {
+    jpeg_encode_worker_t* worker = (jpeg_encode_worker_t*)arg;
+    jpeg_encode_pool_t* pool = worker->pool;
+
+    for (;;) {
+        if (sem_wait(&worker->wake) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        const uint8_t* jpeg;
+        size_t jpeg_size;
+        const jpeg_encode_frame_t* frame = &worker->frame;
+        if (jpeg_encoder_encode(&worker->encoder, worker->data, frame->encoding,
+                                frame->width, frame->height, frame->step, &jpeg, &jpeg_size) == 0) {
+            pool->done(pool->ctx, frame, jpeg, jpeg_size);
+            __atomic_add_fetch(&pool->encoded, 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_add_fetch(&pool->failed, 1, __ATOMIC_RELAXED);
+        }
+
+        // Hand the buffer back to the submitter
+        __atomic_store_n(&worker->busy, 0, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+int jpeg_encode_pool_init(jpeg_encode_pool_t* pool, int threads, size_t frame_capacity,
+                          int quality, jpeg_encode_done_fn done, void* ctx) {
+    memset(pool, 0, sizeof(*pool));
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    pool->workers = calloc((size_t)threads, sizeof(jpeg_encode_worker_t));
+    if (!pool->workers) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    pool->frame_capacity = frame_capacity;
+    pool->done = done;
+    pool->ctx = ctx;
+
+    for (int i = 0; i < threads; ++i) {
+        jpeg_encode_worker_t* worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->data = malloc(frame_capacity);
+        if (!worker->data || jpeg_encoder_init(&worker->encoder, quality) != 0 ||
+            sem_init(&worker->wake, 0, 0) != 0) {
+            RCUTILS_LOG_ERROR("Failed to set up JPEG encoder %d", i);
+            free(worker->data);
+            jpeg_encoder_fini(&worker->encoder);
+            jpeg_encode_pool_fini(pool);
+            return -1;
+        }
+        if (pthread_create(&worker->thread, NULL, jpeg_encode_worker_main, worker) != 0) {
+            RCUTILS_LOG_ERROR("Failed to start JPEG encoder thread %d", i);
+            sem_destroy(&worker->wake);
+            free(worker->data);
+            jpeg_encoder_fini(&worker->encoder);
+            jpeg_encode_pool_fini(pool);
+            return -1;
+        }
+        pool->worker_count++;
+    }
+
+    return 0;
+}
+
+void jpeg_encode_pool_fini(jpeg_encode_pool_t* pool) {
+    if (!pool->workers) {
+        return;
+    }
+
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    for (int i = 0; i < pool->worker_count; ++i) {
+        sem_post(&pool->workers[i].wake);
+    }
+    for (int i = 0; i < pool->worker_count; ++i) {
+        jpeg_encode_worker_t* worker = &pool->workers[i];
+        pthread_join(worker->thread, NULL);
+        sem_destroy(&worker->wake);
+        jpeg_encoder_fini(&worker->encoder);
+        free(worker->data);
+    }
+
+    free(pool->workers);
+    pool->workers = NULL;
+    pool->worker_count = 0;
+}
+
+int jpeg_encode_pool_submit(jpeg_encode_pool_t* pool, const uint8_t* data,
+                            const jpeg_encode_frame_t* frame) {
+    if (frame->size > pool->frame_capacity) {
+        return -1;
+    }
+
+    // Only the submitting thread sets busy, so a worker seen idle here
+    // stays idle until we post it
+    for (int i = 0; i < pool->worker_count; ++i) {
+        jpeg_encode_worker_t* worker = &pool->workers[i];
+        if (__atomic_load_n(&worker->busy, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        memcpy(worker->data, data, frame->size);
+        worker->frame = *frame;
+        __atomic_store_n(&worker->busy, 1, __ATOMIC_RELAXED);
+        sem_post(&worker->wake);
+        __atomic_add_fetch(&pool->submitted, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+
+    __atomic_add_fetch(&pool->busy_drops, 1, __ATOMIC_RELAXED);
+    return 1;
+}
@@ -0,0 +1,312 @@
+#include "jpeg_encoder/jpeg_encoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <rcutils/logging_macros.h>
+
+#define JPEG_ENCODER_MAX_LINES 16   // Luma rows per 4:2:0 strip (one MCU row)
+
+typedef enum {
+    JPEG_LAYOUT_YUYV = 0,
+    JPEG_LAYOUT_UYVY,
+    JPEG_LAYOUT_NV12,
+    JPEG_LAYOUT_I420,
+    JPEG_LAYOUT_RGB,
+    JPEG_LAYOUT_BGR,
+    JPEG_LAYOUT_MONO,
+    JPEG_LAYOUT_UNSUPPORTED
+} jpeg_layout_t;
+
+typedef struct {
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+} jpeg_encoder_error_t;
+
+struct jpeg_encoder_impl {
+    struct jpeg_compress_struct cinfo;
+    jpeg_encoder_error_t error;
+
+    // Output, reused across frames
+    unsigned char* out;
+    unsigned long out_capacity;
+    unsigned long out_size;
+
+    // One strip of raw planes for jpeg_write_raw_data
+    uint8_t* strip;
+    size_t strip_capacity;
+    JSAMPROW rows[3][JPEG_ENCODER_MAX_LINES];
+};
+
+static jpeg_layout_t jpeg_encoder_layout(const char* encoding) {
+    if (strcmp(encoding, "yuv422_yuy2") == 0 || strcmp(encoding, "yuyv") == 0) {
+        return JPEG_LAYOUT_YUYV;
+    }
+    if (strcmp(encoding, "uyvy") == 0 || strcmp(encoding, "yuv422") == 0) {
+        return JPEG_LAYOUT_UYVY;
+    }
+    if (strcmp(encoding, "nv12") == 0) {
+        return JPEG_LAYOUT_NV12;
+    }
+    if (strcmp(encoding, "i420") == 0) {
+        return JPEG_LAYOUT_I420;
+    }
+    if (strcmp(encoding, "rgb8") == 0) {
+        return JPEG_LAYOUT_RGB;
+    }
+#ifdef JCS_EXTENSIONS
+    if (strcmp(encoding, "bgr8") == 0) {
+        return JPEG_LAYOUT_BGR;
+    }
+#endif
+    if (strcmp(encoding, "mono8") == 0) {
+        return JPEG_LAYOUT_MONO;
+    }
+    return JPEG_LAYOUT_UNSUPPORTED;
+}
+
+bool jpeg_encoder_supports(const char* encoding) {
+    return encoding && jpeg_encoder_layout(encoding) != JPEG_LAYOUT_UNSUPPORTED;
+}
+
+static void jpeg_encoder_error_exit(j_common_ptr cinfo) {
+    jpeg_encoder_error_t* error = (jpeg_encoder_error_t*)cinfo->err;
+    (*cinfo->err->format_message)(cinfo, error->message);
+    longjmp(error->jump, 1);
+}
+
+static void jpeg_encoder_emit_message(j_common_ptr cinfo, int level) {
+    (void)cinfo;
+    (void)level;
+}
+
+int jpeg_encoder_init(jpeg_encoder_t* encoder, int quality) {
+    memset(encoder, 0, sizeof(*encoder));
+
+    if (quality < 1 || quality > 100) {
+        RCUTILS_LOG_ERROR("JPEG quality must be 1-100, not %d", quality);
+        return -1;
+    }
+
+    encoder->impl = calloc(1, sizeof(struct jpeg_encoder_impl));
+    if (!encoder->impl) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    encoder->quality = quality;
+
+    struct jpeg_encoder_impl* impl = encoder->impl;
+    impl->cinfo.err = jpeg_std_error(&impl->error.pub);
+    impl->error.pub.error_exit = jpeg_encoder_error_exit;
+    impl->error.pub.emit_message = jpeg_encoder_emit_message;
+    jpeg_create_compress(&impl->cinfo);
+    return 0;
+}
+
+void jpeg_encoder_fini(jpeg_encoder_t* encoder) {
+    if (!encoder->impl) {
+        return;
+    }
+    jpeg_destroy_compress(&encoder->impl->cinfo);
+    free(encoder->impl->out);
+    free(encoder->impl->strip);
+    free(encoder->impl);
+    encoder->impl = NULL;
+}
+
+// Replicate the last sample of each row into the padding libjpeg reads
+static void jpeg_encoder_pad_row(uint8_t* row, int width, int stride) {
+    memset(row + width, row[width - 1], (size_t)(stride - width));
+}
+
+// Deinterleave luma rows y0..y0+lines-1 (clamped to the frame) and the
+// matching chroma rows into the strip planes
+static void jpeg_encoder_fill_strip(struct jpeg_encoder_impl* impl, jpeg_layout_t layout,
+                                    const uint8_t* data, int width, int height, int step,
+                                    int y0, int lines, int y_stride, int c_stride) {
+    int cw = (width + 1) / 2;
+
+    if (layout == JPEG_LAYOUT_YUYV || layout == JPEG_LAYOUT_UYVY) {
+        int y_off = layout == JPEG_LAYOUT_YUYV ? 0 : 1;
+        int u_off = layout == JPEG_LAYOUT_YUYV ? 1 : 0;
+        for (int r = 0; r < lines; r += 2) {
+            int sy0 = y0 + r < height ? y0 + r : height - 1;
+            int sy1 = y0 + r + 1 < height ? y0 + r + 1 : height - 1;
+            const uint8_t* s0 = data + (size_t)sy0 * step;
+            const uint8_t* s1 = data + (size_t)sy1 * step;
+            uint8_t* y0d = impl->rows[0][r];
+            uint8_t* y1d = impl->rows[0][r + 1];
+            uint8_t* ud = impl->rows[1][r / 2];
+            uint8_t* vd = impl->rows[2][r / 2];
+            for (int x = 0; x < width; ++x) {
+                y0d[x] = s0[2 * x + y_off];
+                y1d[x] = s1[2 * x + y_off];
+            }
+            // 4:2:2 -> 4:2:0 by averaging each pair of chroma rows
+            for (int k = 0; k < cw; ++k) {
+                ud[k] = (uint8_t)((s0[4 * k + u_off] + s1[4 * k + u_off] + 1) >> 1);
+                vd[k] = (uint8_t)((s0[4 * k + u_off + 2] + s1[4 * k + u_off + 2] + 1) >> 1);
+            }
+            jpeg_encoder_pad_row(y0d, width, y_stride);
+            jpeg_encoder_pad_row(y1d, width, y_stride);
+            jpeg_encoder_pad_row(ud, cw, c_stride);
+            jpeg_encoder_pad_row(vd, cw, c_stride);
+        }
+        return;
+    }
+
+    // Planar 4:2:0: luma rows as they are, chroma rows at half height
+    int ch = (height + 1) / 2;
+    const uint8_t* chroma = data + (size_t)step * height;
+    for (int r = 0; r < lines; ++r) {
+        int sy = y0 + r < height ? y0 + r : height - 1;
+        memcpy(impl->rows[0][r], data + (size_t)sy * step, (size_t)width);
+        jpeg_encoder_pad_row(impl->rows[0][r], width, y_stride);
+    }
+    for (int r = 0; r < lines / 2; ++r) {
+        int cy = y0 / 2 + r < ch ? y0 / 2 + r : ch - 1;
+        uint8_t* ud = impl->rows[1][r];
+        uint8_t* vd = impl->rows[2][r];
+        if (layout == JPEG_LAYOUT_NV12) {
+            const uint8_t* uv = chroma + (size_t)cy * step;
+            for (int k = 0; k < cw; ++k) {
+                ud[k] = uv[2 * k];
+                vd[k] = uv[2 * k + 1];
+            }
+        } else {
+            int c_step = (step + 1) / 2;
+            memcpy(ud, chroma + (size_t)cy * c_step, (size_t)cw);
+            memcpy(vd, chroma + (size_t)c_step * ch + (size_t)cy * c_step, (size_t)cw);
+        }
+        jpeg_encoder_pad_row(ud, cw, c_stride);
+        jpeg_encoder_pad_row(vd, cw, c_stride);
+    }
+}
+
+// Size the strip planes and configure libjpeg for raw 4:2:0 YCbCr input
+static int jpeg_encoder_setup_raw(struct jpeg_encoder_impl* impl, int width) {
+    struct jpeg_compress_struct* cinfo = &impl->cinfo;
+    int lines = JPEG_ENCODER_MAX_LINES;
+    int c_lines = JPEG_ENCODER_MAX_LINES / 2;
+    int y_stride = (width + 15) & ~15;      // Whole MCUs
+    int c_stride = y_stride / 2;
+
+    size_t needed = (size_t)y_stride * lines + 2 * (size_t)c_stride * c_lines;
+    if (impl->strip_capacity < needed) {
+        uint8_t* strip = realloc(impl->strip, needed);
+        if (!strip) {
+            return -1;
+        }
+        impl->strip = strip;
+        impl->strip_capacity = needed;
+    }
+    for (int r = 0; r < lines; ++r) {
+        impl->rows[0][r] = impl->strip + (size_t)r * y_stride;
+    }
+    for (int r = 0; r < c_lines; ++r) {
+        impl->rows[1][r] = impl->strip + (size_t)y_stride * lines + (size_t)r * c_stride;
+        impl->rows[2][r] = impl->rows[1][r] + (size_t)c_stride * c_lines;
+    }
+
+    cinfo->in_color_space = JCS_YCbCr;
+    cinfo->input_components = 3;
+    jpeg_set_defaults(cinfo);
+    cinfo->raw_data_in = TRUE;
+    cinfo->comp_info[0].h_samp_factor = 2;
+    cinfo->comp_info[0].v_samp_factor = 2;
+    for (int c = 1; c < 3; ++c) {
+        cinfo->comp_info[c].h_samp_factor = 1;
+        cinfo->comp_info[c].v_samp_factor = 1;
+    }
+    return 0;
+}
+
+int jpeg_encoder_encode(jpeg_encoder_t* encoder, const uint8_t* data, const char* encoding,
+                        uint32_t width, uint32_t height, uint32_t step,
+                        const uint8_t** jpeg, size_t* jpeg_size) {
+    struct jpeg_encoder_impl* impl = encoder->impl;
+    struct jpeg_compress_struct* cinfo = &impl->cinfo;
+    jpeg_layout_t layout = jpeg_encoder_layout(encoding);
+
+    if (layout == JPEG_LAYOUT_UNSUPPORTED || width == 0 || height == 0) {
+        RCUTILS_LOG_ERROR("Cannot JPEG-compress %ux%u %s frames", width, height, encoding);
+        return -1;
+    }
+
+    // Big enough for any sane frame, so libjpeg never has to swap buffers
+    unsigned long capacity = (unsigned long)width * height * 2 + 65536;
+    if (impl->out_capacity < capacity) {
+        free(impl->out);
+        impl->out = malloc(capacity);
+        impl->out_capacity = impl->out ? capacity : 0;
+        if (!impl->out) {
+            RCUTILS_LOG_ERROR("Failed to allocate JPEG output buffer");
+            return -1;
+        }
+    }
+
+    if (setjmp(impl->error.jump)) {
+        RCUTILS_LOG_ERROR("JPEG compression failed: %s", impl->error.message);
+        jpeg_abort_compress(cinfo);
+        return -1;
+    }
+
+    // libjpeg only replaces the buffer if the frame doesn't fit
+    unsigned char* previous = impl->out;
+    impl->out_size = impl->out_capacity;
+    jpeg_mem_dest(cinfo, &impl->out, &impl->out_size);
+
+    cinfo->image_width = width;
+    cinfo->image_height = height;
+
+    bool raw = layout <= JPEG_LAYOUT_I420;
+    if (raw) {
+        if (jpeg_encoder_setup_raw(impl, (int)width) != 0) {
+            snprintf(impl->error.message, sizeof(impl->error.message), "out of memory");
+            longjmp(impl->error.jump, 1);
+        }
+    } else {
+        cinfo->input_components = layout == JPEG_LAYOUT_MONO ? 1 : 3;
+        cinfo->in_color_space = layout == JPEG_LAYOUT_MONO ? JCS_GRAYSCALE : JCS_RGB;
+#ifdef JCS_EXTENSIONS
+        if (layout == JPEG_LAYOUT_BGR) {
+            cinfo->in_color_space = JCS_EXT_BGR;
+        }
+#endif
+        jpeg_set_defaults(cinfo);
+    }
+    jpeg_set_quality(cinfo, encoder->quality, TRUE);
+    cinfo->dct_method = JDCT_IFAST;
+
+    jpeg_start_compress(cinfo, TRUE);
+
+    if (raw) {
+        int lines = cinfo->comp_info[0].v_samp_factor * DCTSIZE;
+        int y_stride = ((int)width + 15) & ~15;
+        JSAMPARRAY planes[3] = { impl->rows[0], impl->rows[1], impl->rows[2] };
+        for (int y0 = 0; y0 < (int)height; y0 += lines) {
+            jpeg_encoder_fill_strip(impl, layout, data, (int)width, (int)height, (int)step,
+                                    y0, lines, y_stride, y_stride / 2);
+            jpeg_write_raw_data(cinfo, planes, (JDIMENSION)lines);
+        }
+    } else {
+        while (cinfo->next_scanline < cinfo->image_height) {
+            JSAMPROW row = (JSAMPROW)(data + (size_t)cinfo->next_scanline * step);
+            jpeg_write_scanlines(cinfo, &row, 1);
+        }
+    }
+
+    jpeg_finish_compress(cinfo);
+
+    if (impl->out != previous) {
+        // libjpeg grew the buffer itself; adopt it
+        free(previous);
+        impl->out_capacity = impl->out_size;
+    }
+
+    *jpeg = impl->out;
+    *jpeg_size = impl->out_size;
+    return 0;
+}
@@ -0,0 +1,218 @@
+#include "latency_diagnostics/latency_diagnostics.h"
+#include <stdio.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+#include <rosidl_runtime_c/string_functions.h>
+
+#define LATENCY_DIAGNOSTICS_VALUE_LENGTH 32
+#define LATENCY_DIAGNOSTICS_MESSAGE_LENGTH 128
+
+static const char* const g_value_names[LATENCY_DIAGNOSTICS_VALUES] = {
+    "p50 ms", "p95 ms", "p99 ms", "max ms", "frames",
+};
+
+void latency_stamp_from_monotonic(builtin_interfaces__msg__Time* stamp, int64_t monotonic_ns) {
+    int64_t ns = monotonic_ns + latency_realtime_offset_ns();
+    stamp->sec = (int32_t)(ns / 1000000000LL);
+    stamp->nanosec = (uint32_t)(ns % 1000000000LL);
+}
+
+int64_t latency_stamp_to_monotonic(const builtin_interfaces__msg__Time* stamp) {
+    int64_t ns = (int64_t)stamp->sec * 1000000000LL + stamp->nanosec;
+    return ns - latency_realtime_offset_ns();
+}
+
+// Grow str to hold length characters, so later windows rewrite it in place
+static int latency_diagnostics_reserve(rosidl_runtime_c__String* str, size_t length) {
+    char blank[LATENCY_DIAGNOSTICS_MESSAGE_LENGTH];
+    memset(blank, ' ', length - 1);
+    blank[length - 1] = '\0';
+    if (!rosidl_runtime_c__String__assign(str, blank)) {
+        return -1;
+    }
+    str->data[0] = '\0';
+    str->size = 0;
+    return 0;
+}
+
+// Like rosidl_runtime_c__String__assign, without the reallocation when the
+// text fits
+static int latency_diagnostics_set_text(rosidl_runtime_c__String* str, const char* text) {
+    size_t length = strlen(text);
+    if (str->data && length < str->capacity) {
+        memcpy(str->data, text, length + 1);
+        str->size = length;
+        return 0;
+    }
+    return rosidl_runtime_c__String__assign(str, text) ? 0 : -1;
+}
+
+static int latency_diagnostics_init_msg(latency_diagnostics_t* diagnostics, const char* name) {
+    diagnostic_msgs__msg__DiagnosticArray* msg = &diagnostics->msg;
+    if (!diagnostic_msgs__msg__DiagnosticArray__init(msg)) {
+        return -1;
+    }
+    diagnostics->msg_ready = true;
+
+    char text[128];
+    snprintf(text, sizeof(text), "%s: latency", name);
+    if (!diagnostic_msgs__msg__DiagnosticStatus__Sequence__init(&msg->status, 1)) {
+        return -1;
+    }
+    diagnostic_msgs__msg__DiagnosticStatus* status = &msg->status.data[0];
+    if (!rosidl_runtime_c__String__assign(&status->name, text) ||
+        !rosidl_runtime_c__String__assign(&status->hardware_id, name) ||
+        latency_diagnostics_reserve(&status->message, LATENCY_DIAGNOSTICS_MESSAGE_LENGTH) != 0) {
+        return -1;
+    }
+
+    // Keys never change; only the values are rewritten per window, into
+    // strings sized here so publishing a window allocates nothing
+    size_t count = (size_t)diagnostics->stage_count * LATENCY_DIAGNOSTICS_VALUES;
+    if (!diagnostic_msgs__msg__KeyValue__Sequence__init(&status->values, count)) {
+        return -1;
+    }
+    for (int stage = 0; stage < diagnostics->stage_count; ++stage) {
+        for (int v = 0; v < LATENCY_DIAGNOSTICS_VALUES; ++v) {
+            snprintf(text, sizeof(text), "%s %s", diagnostics->stages[stage], g_value_names[v]);
+            diagnostic_msgs__msg__KeyValue* value = &status->values.data[stage * LATENCY_DIAGNOSTICS_VALUES + v];
+            if (!rosidl_runtime_c__String__assign(&value->key, text) ||
+                latency_diagnostics_reserve(&value->value, LATENCY_DIAGNOSTICS_VALUE_LENGTH) != 0) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int latency_diagnostics_init(latency_diagnostics_t* diagnostics, rcl_node_t* node,
+                             const char* name, const char* const* stages, int stage_count) {
+    memset(diagnostics, 0, sizeof(*diagnostics));
+    if (stage_count < 1 || stage_count > LATENCY_DIAGNOSTICS_MAX_STAGES) {
+        RCUTILS_LOG_ERROR("Latency diagnostics take 1-%d stages, got %d",
+            LATENCY_DIAGNOSTICS_MAX_STAGES, stage_count);
+        return -1;
+    }
+    diagnostics->node = node;
+    diagnostics->stage_count = stage_count;
+    for (int i = 0; i < stage_count; ++i) {
+        diagnostics->stages[i] = stages[i];
+    }
+
+    if (latency_diagnostics_init_msg(diagnostics, name) != 0) {
+        RCUTILS_LOG_ERROR("Failed to create diagnostics message");
+        if (diagnostics->msg_ready) {
+            diagnostic_msgs__msg__DiagnosticArray__fini(&diagnostics->msg);
+            diagnostics->msg_ready = false;
+        }
+        return -1;
+    }
+
+    diagnostics->publisher = rcl_get_zero_initialized_publisher();
+    rcl_publisher_options_t pub_options = rcl_publisher_get_default_options();
+    const rosidl_message_type_support_t* type_support =
+        ROSIDL_GET_MSG_TYPE_SUPPORT(diagnostic_msgs, msg, DiagnosticArray);
+    if (rcl_publisher_init(&diagnostics->publisher, node, type_support,
+                           LATENCY_DIAGNOSTICS_TOPIC, &pub_options) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize diagnostics publisher");
+        diagnostic_msgs__msg__DiagnosticArray__fini(&diagnostics->msg);
+        diagnostics->msg_ready = false;
+        return -1;
+    }
+
+    pthread_mutex_init(&diagnostics->mutex, NULL);
+    return 0;
+}
+
+void latency_diagnostics_fini(latency_diagnostics_t* diagnostics) {
+    if (!diagnostics->msg_ready) {
+        return;
+    }
+    rcl_publisher_fini(&diagnostics->publisher, diagnostics->node);
+    diagnostic_msgs__msg__DiagnosticArray__fini(&diagnostics->msg);
+    pthread_mutex_destroy(&diagnostics->mutex);
+    diagnostics->msg_ready = false;
+}
+
+void latency_diagnostics_record(latency_diagnostics_t* diagnostics, int stage, int64_t latency_ns) {
+    if (stage < 0 || stage >= diagnostics->stage_count) {
+        return;
+    }
+    pthread_mutex_lock(&diagnostics->mutex);
+    latency_histogram_record(&diagnostics->histograms[stage], latency_ns);
+    pthread_mutex_unlock(&diagnostics->mutex);
+}
+
+static int latency_diagnostics_set_value(diagnostic_msgs__msg__KeyValue* value, const char* format,
+                                         double number) {
+    char text[LATENCY_DIAGNOSTICS_VALUE_LENGTH];
+    snprintf(text, sizeof(text), format, number);
+    return latency_diagnostics_set_text(&value->value, text);
+}
+
+int latency_diagnostics_tick(latency_diagnostics_t* diagnostics, int64_t now_ns) {
+    if (!diagnostics->msg_ready) {
+        return 0;
+    }
+    if (diagnostics->window_start_ns == 0) {
+        diagnostics->window_start_ns = now_ns;
+        return 0;
+    }
+    if (now_ns - diagnostics->window_start_ns < (int64_t)LATENCY_DIAGNOSTICS_PERIOD_MS * 1000000LL) {
+        return 0;
+    }
+    diagnostics->window_start_ns = now_ns;
+
+    // Only the copy holds the lock; formatting and publishing run without it
+    pthread_mutex_lock(&diagnostics->mutex);
+    memcpy(diagnostics->snapshot, diagnostics->histograms,
+           (size_t)diagnostics->stage_count * sizeof(latency_histogram_t));
+    for (int stage = 0; stage < diagnostics->stage_count; ++stage) {
+        latency_histogram_reset(&diagnostics->histograms[stage]);
+    }
+    pthread_mutex_unlock(&diagnostics->mutex);
+
+    diagnostic_msgs__msg__DiagnosticStatus* status = &diagnostics->msg.status.data[0];
+    for (int stage = 0; stage < diagnostics->stage_count; ++stage) {
+        const latency_histogram_t* histogram = &diagnostics->snapshot[stage];
+        diagnostic_msgs__msg__KeyValue* values = &status->values.data[stage * LATENCY_DIAGNOSTICS_VALUES];
+        if (latency_diagnostics_set_value(&values[0], "%.2f",
+                latency_histogram_percentile(histogram, 50.0) / 1e6) != 0 ||
+            latency_diagnostics_set_value(&values[1], "%.2f",
+                latency_histogram_percentile(histogram, 95.0) / 1e6) != 0 ||
+            latency_diagnostics_set_value(&values[2], "%.2f",
+                latency_histogram_percentile(histogram, 99.0) / 1e6) != 0 ||
+            latency_diagnostics_set_value(&values[3], "%.2f", histogram->max_ns / 1e6) != 0 ||
+            latency_diagnostics_set_value(&values[4], "%.0f", (double)histogram->count) != 0) {
+            RCUTILS_LOG_ERROR("Failed to fill diagnostics message");
+            return -1;
+        }
+    }
+
+    // The last stage is end to end
+    const latency_histogram_t* total = &diagnostics->snapshot[diagnostics->stage_count - 1];
+    char message[LATENCY_DIAGNOSTICS_MESSAGE_LENGTH];
+    if (total->count > 0) {
+        status->level = diagnostic_msgs__msg__DiagnosticStatus__OK;
+        snprintf(message, sizeof(message), "%s p50 %.1f ms, p99 %.1f ms, max %.1f ms over %llu frames",
+            diagnostics->stages[diagnostics->stage_count - 1],
+            latency_histogram_percentile(total, 50.0) / 1e6,
+            latency_histogram_percentile(total, 99.0) / 1e6,
+            total->max_ns / 1e6, (unsigned long long)total->count);
+    } else {
+        status->level = diagnostic_msgs__msg__DiagnosticStatus__WARN;
+        snprintf(message, sizeof(message), "No frames");
+    }
+    if (latency_diagnostics_set_text(&status->message, message) != 0) {
+        return -1;
+    }
+    RCUTILS_LOG_DEBUG("%s: %s", status->name.data, message);
+
+    latency_stamp_from_monotonic(&diagnostics->msg.header.stamp, now_ns);
+    if (rcl_publish(&diagnostics->publisher, &diagnostics->msg, NULL) != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to publish latency diagnostics");
+        return -1;
+    }
+    diagnostics->published++;
+    return 1;
+}
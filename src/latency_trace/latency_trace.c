@@ -0,0 +1,96 @@
+#include "latency_trace/latency_trace.h"
+#include <string.h>
+#include <time.h>
+
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_HISTOGRAM_SUB_BITS)
+
+int64_t latency_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Realtime read between two monotonic reads, against their midpoint, so a
+// preemption between the calls can't skew the offset by a whole time slice
+int64_t latency_realtime_offset_ns(void) {
+    struct timespec before, real, after;
+    clock_gettime(CLOCK_MONOTONIC, &before);
+    clock_gettime(CLOCK_REALTIME, &real);
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    int64_t mono_before = (int64_t)before.tv_sec * 1000000000LL + before.tv_nsec;
+    int64_t mono_after = (int64_t)after.tv_sec * 1000000000LL + after.tv_nsec;
+    int64_t realtime = (int64_t)real.tv_sec * 1000000000LL + real.tv_nsec;
+    return realtime - (mono_before + (mono_after - mono_before) / 2);
+}
+
+void latency_histogram_reset(latency_histogram_t* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+static int latency_bucket(uint64_t us) {
+    if (us < LATENCY_SUB_BUCKETS) {
+        return (int)us;
+    }
+    if (us >> LATENCY_HISTOGRAM_MAX_BITS) {
+        return LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+    int exponent = 63 - __builtin_clzll(us);
+    int shift = exponent - LATENCY_HISTOGRAM_SUB_BITS;
+    int sub = (int)(us >> shift) - LATENCY_SUB_BUCKETS;
+    return LATENCY_SUB_BUCKETS + shift * LATENCY_SUB_BUCKETS + sub;
+}
+
+// First microsecond of a bucket and its width
+static void latency_bucket_range(int bucket, uint64_t* lower, uint64_t* width) {
+    if (bucket < LATENCY_SUB_BUCKETS) {
+        *lower = (uint64_t)bucket;
+        *width = 1;
+        return;
+    }
+    int shift = (bucket - LATENCY_SUB_BUCKETS) / LATENCY_SUB_BUCKETS;
+    int sub = (bucket - LATENCY_SUB_BUCKETS) % LATENCY_SUB_BUCKETS;
+    *lower = (uint64_t)(LATENCY_SUB_BUCKETS + sub) << shift;
+    *width = (uint64_t)1 << shift;
+}
+
+void latency_histogram_record(latency_histogram_t* histogram, int64_t latency_ns) {
+    if (latency_ns < 0) {
+        latency_ns = 0;
+    }
+    histogram->counts[latency_bucket((uint64_t)latency_ns / 1000)]++;
+    histogram->count++;
+    histogram->sum_ns += latency_ns;
+    if (latency_ns > histogram->max_ns) {
+        histogram->max_ns = latency_ns;
+    }
+}
+
+int64_t latency_histogram_percentile(const latency_histogram_t* histogram, double percentile) {
+    if (histogram->count == 0) {
+        return 0;
+    }
+    // Rank of the sample, 1-based: p50 of 10 samples is the 5th
+    double exact = percentile / 100.0 * (double)histogram->count;
+    uint64_t rank = (uint64_t)exact;
+    if ((double)rank < exact || rank == 0) {
+        rank++;
+    }
+
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; ++bucket) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            uint64_t lower, width;
+            latency_bucket_range(bucket, &lower, &width);
+            // Microsecond buckets below 16 us are exact
+            int64_t value = width == 1 ? (int64_t)lower * 1000 :
+                                         (int64_t)(lower * 1000 + width * 500);
+            return value < histogram->max_ns ? value : histogram->max_ns;
+        }
+    }
+    return histogram->max_ns;
+}
+
+double latency_histogram_mean_ns(const latency_histogram_t* histogram) {
+    return histogram->count ? (double)histogram->sum_ns / (double)histogram->count : 0.0;
+}
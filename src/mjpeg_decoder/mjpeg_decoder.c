@@ -0,0 +1,397 @@
+#include "mjpeg_decoder/mjpeg_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+#include <jerror.h>
+#include <rcutils/logging_macros.h>
+
+// libjpeg 7+ split the scaled DCT size into horizontal and vertical parts;
+// libjpeg-turbo keeps the 6b names unless built with jpeg7/8 emulation
+#if JPEG_LIB_VERSION >= 70
+#define MJPEG_MIN_DCT_H(cinfo) ((cinfo)->min_DCT_h_scaled_size)
+#define MJPEG_MIN_DCT_V(cinfo) ((cinfo)->min_DCT_v_scaled_size)
+#define MJPEG_DCT_H(comp) ((comp)->DCT_h_scaled_size)
+#define MJPEG_DCT_V(comp) ((comp)->DCT_v_scaled_size)
+#else
+#define MJPEG_MIN_DCT_H(cinfo) ((cinfo)->min_DCT_scaled_size)
+#define MJPEG_MIN_DCT_V(cinfo) ((cinfo)->min_DCT_scaled_size)
+#define MJPEG_DCT_H(comp) ((comp)->DCT_scaled_size)
+#define MJPEG_DCT_V(comp) ((comp)->DCT_scaled_size)
+#endif
+
+#define MJPEG_MAX_COMPONENTS 3
+#define MJPEG_MAX_IMCU_ROWS 32  // max_v_samp_factor (<= 4) * DCTSIZE
+
+typedef struct {
+    struct jpeg_error_mgr pub;
+    jmp_buf jump;
+    char message[JMSG_LENGTH_MAX];
+} mjpeg_error_t;
+
+// One decoded component plane
+typedef struct {
+    uint8_t* data;
+    size_t capacity;
+    int stride;
+    int rows_per_imcu;          // Rows jpeg_read_raw_data fills per call
+    int h_factor;               // Luma pixels per sample, horizontally
+    int v_factor;               // ... and vertically
+} mjpeg_plane_t;
+
+struct mjpeg_decoder_impl {
+    struct jpeg_decompress_struct cinfo;
+    mjpeg_error_t error;
+    mjpeg_plane_t planes[MJPEG_MAX_COMPONENTS];
+    JSAMPROW rows[MJPEG_MAX_COMPONENTS][MJPEG_MAX_IMCU_ROWS];
+};
+
+static void mjpeg_error_exit(j_common_ptr cinfo) {
+    mjpeg_error_t* error = (mjpeg_error_t*)cinfo->err;
+    (*cinfo->err->format_message)(cinfo, error->message);
+    longjmp(error->jump, 1);
+}
+
+// libjpeg only warns about most data corruption and keeps decoding garbage;
+// treat warnings as fatal so such frames are dropped, except for the
+// harmless extraneous bytes many cameras leave between markers
+static void mjpeg_emit_message(j_common_ptr cinfo, int level) {
+    if (level >= 0 || cinfo->err->msg_code == JWRN_EXTRANEOUS_DATA) {
+        return;
+    }
+    mjpeg_error_exit(cinfo);
+}
+
+int mjpeg_decoder_init(mjpeg_decoder_t* decoder, mjpeg_output_t output, int scale_denom) {
+    memset(decoder, 0, sizeof(*decoder));
+
+    if (scale_denom != 1 && scale_denom != 2 && scale_denom != 4 && scale_denom != 8) {
+        RCUTILS_LOG_ERROR("MJPEG scale must be 1/1, 1/2, 1/4 or 1/8, not 1/%d", scale_denom);
+        return -1;
+    }
+
+    decoder->impl = calloc(1, sizeof(struct mjpeg_decoder_impl));
+    if (!decoder->impl) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        return -1;
+    }
+    decoder->output = output;
+    decoder->scale_denom = scale_denom;
+
+    struct mjpeg_decoder_impl* impl = decoder->impl;
+    impl->cinfo.err = jpeg_std_error(&impl->error.pub);
+    impl->error.pub.error_exit = mjpeg_error_exit;
+    impl->error.pub.emit_message = mjpeg_emit_message;
+    jpeg_create_decompress(&impl->cinfo);
+    return 0;
+}
+
+void mjpeg_decoder_fini(mjpeg_decoder_t* decoder) {
+    if (!decoder->impl) {
+        return;
+    }
+    jpeg_destroy_decompress(&decoder->impl->cinfo);
+    for (int i = 0; i < MJPEG_MAX_COMPONENTS; ++i) {
+        free(decoder->impl->planes[i].data);
+    }
+    free(decoder->impl);
+    decoder->impl = NULL;
+}
+
+void mjpeg_decoder_output_size(const mjpeg_decoder_t* decoder, uint32_t width, uint32_t height,
+                               uint32_t* out_width, uint32_t* out_height,
+                               uint32_t* out_step, size_t* out_size) {
+    // Same rounding as libjpeg's jdiv_round_up
+    uint32_t w = (width + decoder->scale_denom - 1) / decoder->scale_denom;
+    uint32_t h = (height + decoder->scale_denom - 1) / decoder->scale_denom;
+
+    *out_width = w;
+    *out_height = h;
+    switch (decoder->output) {
+        case MJPEG_OUTPUT_I420:
+            *out_step = w;
+            *out_size = (size_t)w * h + 2 * (size_t)((w + 1) / 2) * ((h + 1) / 2);
+            break;
+        case MJPEG_OUTPUT_RGB24:
+            *out_step = w * 3;
+            *out_size = (size_t)*out_step * h;
+            break;
+        default:
+            *out_step = ((w + 1) & ~1u) * 2;
+            *out_size = (size_t)*out_step * h;
+            break;
+    }
+}
+
+const char* mjpeg_output_encoding(mjpeg_output_t output) {
+    switch (output) {
+        case MJPEG_OUTPUT_I420: return "i420";
+        case MJPEG_OUTPUT_RGB24: return "rgb8";
+        default: return "yuv422_yuy2";
+    }
+}
+
+bool mjpeg_frame_looks_complete(const uint8_t* jpeg, size_t size) {
+    if (size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+        return false;
+    }
+    // Some cameras pad the buffer after EOI with zeros
+    while (size > 2 && jpeg[size - 1] == 0x00) {
+        size--;
+    }
+    return jpeg[size - 2] == 0xFF && jpeg[size - 1] == 0xD9;
+}
+
+// Size the component planes for the current frame after
+// jpeg_start_decompress; buffers only ever grow
+static int mjpeg_prepare_planes(struct mjpeg_decoder_impl* impl) {
+    struct jpeg_decompress_struct* cinfo = &impl->cinfo;
+    int lines_per_imcu = cinfo->max_v_samp_factor * MJPEG_MIN_DCT_V(cinfo);
+    int imcu_rows = ((int)cinfo->output_height + lines_per_imcu - 1) / lines_per_imcu;
+
+    if (cinfo->num_components > MJPEG_MAX_COMPONENTS) {
+        return -1;
+    }
+
+    for (int c = 0; c < cinfo->num_components; ++c) {
+        jpeg_component_info* comp = &cinfo->comp_info[c];
+        mjpeg_plane_t* plane = &impl->planes[c];
+
+        // Whole MCUs, libjpeg writes full blocks
+        int blocks = (int)((comp->width_in_blocks + comp->h_samp_factor - 1) /
+                           comp->h_samp_factor * comp->h_samp_factor);
+        plane->stride = blocks * MJPEG_DCT_H(comp);
+        plane->rows_per_imcu = comp->v_samp_factor * MJPEG_DCT_V(comp);
+        plane->h_factor = (cinfo->max_h_samp_factor * MJPEG_MIN_DCT_H(cinfo)) /
+                          (comp->h_samp_factor * MJPEG_DCT_H(comp));
+        plane->v_factor = (cinfo->max_v_samp_factor * MJPEG_MIN_DCT_V(cinfo)) /
+                          (comp->v_samp_factor * MJPEG_DCT_V(comp));
+        if (plane->rows_per_imcu > MJPEG_MAX_IMCU_ROWS || plane->h_factor < 1 || plane->v_factor < 1) {
+            return -1;
+        }
+
+        size_t needed = (size_t)plane->stride * plane->rows_per_imcu * imcu_rows;
+        if (plane->capacity < needed) {
+            uint8_t* data = realloc(plane->data, needed);
+            if (!data) {
+                return -1;
+            }
+            plane->data = data;
+            plane->capacity = needed;
+        }
+    }
+    return 0;
+}
+
+static void mjpeg_read_planes(struct mjpeg_decoder_impl* impl) {
+    struct jpeg_decompress_struct* cinfo = &impl->cinfo;
+    int lines_per_imcu = cinfo->max_v_samp_factor * MJPEG_MIN_DCT_V(cinfo);
+    JSAMPARRAY components[MJPEG_MAX_COMPONENTS];
+
+    for (int imcu = 0; cinfo->output_scanline < cinfo->output_height; ++imcu) {
+        for (int c = 0; c < cinfo->num_components; ++c) {
+            mjpeg_plane_t* plane = &impl->planes[c];
+            uint8_t* base = plane->data + (size_t)imcu * plane->rows_per_imcu * plane->stride;
+            for (int r = 0; r < plane->rows_per_imcu; ++r) {
+                impl->rows[c][r] = base + (size_t)r * plane->stride;
+            }
+            components[c] = impl->rows[c];
+        }
+        jpeg_read_raw_data(cinfo, components, lines_per_imcu);
+    }
+}
+
+// Interleave Y and the (subsampled) chroma planes into YUYV
+static void mjpeg_pack_yuyv(const struct mjpeg_decoder_impl* impl, uint8_t* dst, uint32_t step,
+                            int width, int height) {
+    const mjpeg_plane_t* yp = &impl->planes[0];
+    bool gray = impl->cinfo.num_components == 1;
+    const mjpeg_plane_t* up = &impl->planes[1];
+    const mjpeg_plane_t* vp = &impl->planes[2];
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* ys = yp->data + (size_t)y * yp->stride;
+        uint8_t* d = dst + (size_t)y * step;
+
+        if (gray) {
+            for (int x = 0; x < width; x += 2) {
+                d[0] = ys[x];
+                d[1] = 128;
+                d[2] = x + 1 < width ? ys[x + 1] : ys[x];
+                d[3] = 128;
+                d += 4;
+            }
+            continue;
+        }
+
+        const uint8_t* us = up->data + (size_t)(y / up->v_factor) * up->stride;
+        const uint8_t* vs = vp->data + (size_t)(y / vp->v_factor) * vp->stride;
+        if (up->h_factor == 2 && vp->h_factor == 2) {
+            // 4:2:2 and 4:2:0, the usual webcam layouts
+            for (int x = 0; x < width; x += 2) {
+                d[0] = ys[x];
+                d[1] = us[x >> 1];
+                d[2] = x + 1 < width ? ys[x + 1] : ys[x];
+                d[3] = vs[x >> 1];
+                d += 4;
+            }
+        } else {
+            for (int x = 0; x < width; x += 2) {
+                d[0] = ys[x];
+                d[1] = us[x / up->h_factor];
+                d[2] = x + 1 < width ? ys[x + 1] : ys[x];
+                d[3] = vs[x / vp->h_factor];
+                d += 4;
+            }
+        }
+    }
+}
+
+// Copy Y and resample chroma to 4:2:0 (point sampling, exact for 4:2:0 input)
+static void mjpeg_pack_i420(const struct mjpeg_decoder_impl* impl, uint8_t* dst,
+                            int width, int height) {
+    const mjpeg_plane_t* yp = &impl->planes[0];
+    int cw = (width + 1) / 2;
+    int ch = (height + 1) / 2;
+    uint8_t* u_dst = dst + (size_t)width * height;
+    uint8_t* v_dst = u_dst + (size_t)cw * ch;
+
+    for (int y = 0; y < height; ++y) {
+        memcpy(dst + (size_t)y * width, yp->data + (size_t)y * yp->stride, width);
+    }
+
+    if (impl->cinfo.num_components == 1) {
+        memset(u_dst, 128, (size_t)cw * ch * 2);
+        return;
+    }
+
+    const mjpeg_plane_t* up = &impl->planes[1];
+    const mjpeg_plane_t* vp = &impl->planes[2];
+    for (int y = 0; y < ch; ++y) {
+        const uint8_t* us = up->data + (size_t)(2 * y / up->v_factor) * up->stride;
+        const uint8_t* vs = vp->data + (size_t)(2 * y / vp->v_factor) * vp->stride;
+        uint8_t* ud = u_dst + (size_t)y * cw;
+        uint8_t* vd = v_dst + (size_t)y * cw;
+        if (up->h_factor == 2 && vp->h_factor == 2) {
+            memcpy(ud, us, cw);
+            memcpy(vd, vs, cw);
+        } else {
+            for (int x = 0; x < cw; ++x) {
+                ud[x] = us[2 * x / up->h_factor];
+                vd[x] = vs[2 * x / vp->h_factor];
+            }
+        }
+    }
+}
+
+static void mjpeg_read_rgb(struct mjpeg_decoder_impl* impl, uint8_t* dst, uint32_t step) {
+    struct jpeg_decompress_struct* cinfo = &impl->cinfo;
+    while (cinfo->output_scanline < cinfo->output_height) {
+        JSAMPROW row = dst + (size_t)cinfo->output_scanline * step;
+        jpeg_read_scanlines(cinfo, &row, 1);
+    }
+}
+
+int mjpeg_decoder_peek_size(mjpeg_decoder_t* decoder, const uint8_t* jpeg, size_t size,
+                            uint32_t* width, uint32_t* height) {
+    struct mjpeg_decoder_impl* impl = decoder->impl;
+    struct jpeg_decompress_struct* cinfo = &impl->cinfo;
+
+    if (size < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8) {
+        return -1;
+    }
+    if (setjmp(impl->error.jump)) {
+        jpeg_abort_decompress(cinfo);
+        return -1;
+    }
+    jpeg_mem_src(cinfo, (unsigned char*)jpeg, (unsigned long)size);
+    jpeg_read_header(cinfo, TRUE);
+    *width = cinfo->image_width;
+    *height = cinfo->image_height;
+    jpeg_abort_decompress(cinfo);
+    return 0;
+}
+
+int mjpeg_decoder_decode(mjpeg_decoder_t* decoder, const uint8_t* jpeg, size_t size,
+                         uint32_t expected_width, uint32_t expected_height,
+                         uint8_t* dst, size_t dst_capacity) {
+    struct mjpeg_decoder_impl* impl = decoder->impl;
+    struct jpeg_decompress_struct* cinfo = &impl->cinfo;
+
+    if (!mjpeg_frame_looks_complete(jpeg, size)) {
+        decoder->corrupt++;
+        RCUTILS_LOG_DEBUG("Dropping truncated JPEG frame (%zu bytes)", size);
+        return -1;
+    }
+
+    if (setjmp(impl->error.jump)) {
+        // Any libjpeg error or warning lands here; reset for the next frame
+        jpeg_abort_decompress(cinfo);
+        decoder->corrupt++;
+        RCUTILS_LOG_DEBUG("Dropping corrupt JPEG frame: %s", impl->error.message);
+        return -1;
+    }
+
+    // USB cameras usually omit the Huffman tables; libjpeg-turbo then falls
+    // back to the standard tables that Motion-JPEG implies
+    jpeg_mem_src(cinfo, (unsigned char*)jpeg, (unsigned long)size);
+    jpeg_read_header(cinfo, TRUE);
+
+    if ((expected_width && cinfo->image_width != expected_width) ||
+        (expected_height && cinfo->image_height != expected_height)) {
+        snprintf(impl->error.message, sizeof(impl->error.message), "%ux%u frame in a %ux%u stream",
+                 cinfo->image_width, cinfo->image_height, expected_width, expected_height);
+        longjmp(impl->error.jump, 1);
+    }
+
+    uint32_t out_width, out_height, out_step;
+    size_t out_size;
+    mjpeg_decoder_output_size(decoder, cinfo->image_width, cinfo->image_height,
+                              &out_width, &out_height, &out_step, &out_size);
+    if (out_size > dst_capacity) {
+        snprintf(impl->error.message, sizeof(impl->error.message),
+                 "decoded frame needs %zu bytes, buffer has %zu", out_size, dst_capacity);
+        longjmp(impl->error.jump, 1);
+    }
+
+    cinfo->scale_num = 1;
+    cinfo->scale_denom = decoder->scale_denom;
+    cinfo->dct_method = JDCT_IFAST;
+
+    bool yuv = decoder->output != MJPEG_OUTPUT_RGB24;
+    if (yuv) {
+        if (cinfo->jpeg_color_space != JCS_YCbCr && cinfo->jpeg_color_space != JCS_GRAYSCALE) {
+            snprintf(impl->error.message, sizeof(impl->error.message), "unsupported JPEG color space");
+            longjmp(impl->error.jump, 1);
+        }
+        // Hand out the planes as stored: no color conversion, no upsampling
+        cinfo->raw_data_out = TRUE;
+        cinfo->do_fancy_upsampling = FALSE;
+    } else {
+        cinfo->out_color_space = JCS_RGB;
+    }
+
+    jpeg_start_decompress(cinfo);
+
+    if (yuv) {
+        if (mjpeg_prepare_planes(impl) != 0) {
+            snprintf(impl->error.message, sizeof(impl->error.message), "unsupported sampling layout");
+            longjmp(impl->error.jump, 1);
+        }
+        mjpeg_read_planes(impl);
+    } else {
+        mjpeg_read_rgb(impl, dst, out_step);
+    }
+
+    jpeg_finish_decompress(cinfo);
+
+    if (decoder->output == MJPEG_OUTPUT_YUYV) {
+        mjpeg_pack_yuyv(impl, dst, out_step, (int)out_width, (int)out_height);
+    } else if (decoder->output == MJPEG_OUTPUT_I420) {
+        mjpeg_pack_i420(impl, dst, (int)out_width, (int)out_height);
+    }
+
+    decoder->decoded++;
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include "mjpeg_decoder/mjpeg_stream.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <rcutils/logging_macros.h>
+
+int mjpeg_stream_open(mjpeg_stream_t* stream, const char* path) {
+    memset(stream, 0, sizeof(*stream));
+    stream->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (stream->fd == -1) {
+        RCUTILS_LOG_ERROR("Cannot open %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(stream->fd, &st) == -1 || st.st_size == 0) {
+        RCUTILS_LOG_ERROR("Cannot read %s: %s", path, st.st_size == 0 ? "empty file" : strerror(errno));
+        mjpeg_stream_close(stream);
+        return -1;
+    }
+
+    void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, stream->fd, 0);
+    if (data == MAP_FAILED) {
+        RCUTILS_LOG_ERROR("mmap of %s failed: %s", path, strerror(errno));
+        mjpeg_stream_close(stream);
+        return -1;
+    }
+    stream->data = data;
+    stream->size = (size_t)st.st_size;
+    madvise(data, stream->size, MADV_SEQUENTIAL);
+    return 0;
+}
+
+void mjpeg_stream_close(mjpeg_stream_t* stream) {
+    if (stream->data) {
+        munmap((void*)stream->data, stream->size);
+        stream->data = NULL;
+    }
+    if (stream->fd > 0) {
+        close(stream->fd);
+    }
+    stream->fd = -1;
+}
+
+// Offset of the next FF D8 FF at or after from, or size if there is none
+static size_t mjpeg_stream_find_soi(const mjpeg_stream_t* stream, size_t from) {
+    const uint8_t* p = stream->data + from;
+    const uint8_t* end = stream->data + stream->size;
+    while (p + 3 <= end) {
+        p = memchr(p, 0xFF, (size_t)(end - p - 2));
+        if (!p) {
+            break;
+        }
+        if (p[1] == 0xD8 && p[2] == 0xFF) {
+            return (size_t)(p - stream->data);
+        }
+        p++;
+    }
+    return stream->size;
+}
+
+int mjpeg_stream_next(mjpeg_stream_t* stream, const uint8_t** frame, size_t* size) {
+    size_t start = mjpeg_stream_find_soi(stream, stream->offset);
+    if (start >= stream->size) {
+        stream->offset = stream->size;
+        return 0;
+    }
+    size_t end = mjpeg_stream_find_soi(stream, start + 2);
+
+    *frame = stream->data + start;
+    *size = end - start;
+    stream->offset = end;
+    return 1;
+}
+
+void mjpeg_stream_rewind(mjpeg_stream_t* stream) {
+    stream->offset = 0;
+}
@@ -0,0 +1,220 @@
+#include "motion_gate/motion_gate.h"
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+void motion_gate_row_scalar(const uint8_t* yuyv, int decimation, uint8_t* background,
+                            int samples, int shift, uint32_t* sad) {
+    const int round = shift > 0 ? 1 << (shift - 1) : 0;
+    const int stride = 2 * decimation;  // Bytes between used Y samples
+    for (int i = 0; i < samples; ++i) {
+        int y = yuyv[(size_t)i * stride];
+        int b = background[i];
+        int diff = y - b;
+        sad[i / MOTION_GATE_CHUNK] += (uint32_t)(diff < 0 ? -diff : diff);
+        background[i] = (uint8_t)(b + ((diff + round) >> shift));
+    }
+}
+
+motion_gate_row_fn motion_gate_get_row(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return motion_gate_row_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        // 16 samples per psadbw already outrun the memory reads; AVX2
+        // would only widen a loop that waits on loads
+        case COLOR_CONVERT_ISA_SSE2:
+        case COLOR_CONVERT_ISA_AVX2:
+            return motion_gate_row_sse2;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+            return motion_gate_row_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+void motion_gate_config_default(motion_gate_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->block_size = MOTION_GATE_BLOCK;
+    config->decimation = 2;
+    config->threshold = MOTION_GATE_THRESHOLD;
+    config->min_blocks = 1;
+    config->background_shift = 3;
+    config->hold_frames = 10;
+}
+
+int motion_gate_init(motion_gate_t* gate, const motion_gate_config_t* config) {
+    memset(gate, 0, sizeof(*gate));
+
+    if (config->block_size < MOTION_GATE_CHUNK || config->block_size % MOTION_GATE_CHUNK != 0 ||
+        (config->decimation != 1 && config->decimation != 2 && config->decimation != 4) ||
+        config->threshold < 0 || config->min_blocks < 1 ||
+        config->background_shift < 0 || config->background_shift > 7 || config->hold_frames < 0) {
+        RCUTILS_LOG_ERROR("Invalid motion gate: %d-sample blocks, decimation %d",
+            config->block_size, config->decimation);
+        return -1;
+    }
+
+    gate->config = *config;
+    gate->isa = color_convert_active_isa();
+    gate->row = motion_gate_get_row(gate->isa);
+    if (!gate->row) {
+        gate->isa = COLOR_CONVERT_ISA_SCALAR;
+        gate->row = motion_gate_row_scalar;
+    }
+    return 0;
+}
+
+static void motion_gate_free_buffers(motion_gate_t* gate) {
+    free(gate->background);
+    free(gate->chunk_sad);
+    free(gate->mask);
+    gate->background = NULL;
+    gate->chunk_sad = NULL;
+    gate->mask = NULL;
+    gate->width = 0;
+    gate->height = 0;
+}
+
+void motion_gate_fini(motion_gate_t* gate) {
+    motion_gate_free_buffers(gate);
+    gate->row = NULL;
+}
+
+void motion_gate_reset(motion_gate_t* gate) {
+    gate->primed = false;
+    gate->hold = 0;
+}
+
+void motion_gate_union_rows(int* y, int* height, int other_y, int other_height) {
+    if (other_height <= 0) {
+        return;
+    }
+    if (*height <= 0) {
+        *y = other_y;
+        *height = other_height;
+        return;
+    }
+    int end = *y + *height > other_y + other_height ? *y + *height : other_y + other_height;
+    *y = *y < other_y ? *y : other_y;
+    *height = end - *y;
+}
+
+// (Re)size the buffers when the frame size changes
+static int motion_gate_resize(motion_gate_t* gate, int width, int height) {
+    if (gate->background && gate->width == width && gate->height == height) {
+        return 0;
+    }
+    motion_gate_free_buffers(gate);
+
+    const int d = gate->config.decimation;
+    const int block = gate->config.block_size;
+    gate->samples = width / d;
+    gate->rows = (height + d - 1) / d;
+    gate->chunks = (gate->samples + MOTION_GATE_CHUNK - 1) / MOTION_GATE_CHUNK;
+    gate->blocks_x = (gate->samples + block - 1) / block;
+    gate->blocks_y = (gate->rows + block - 1) / block;
+
+    gate->background = malloc((size_t)gate->samples * gate->rows);
+    gate->chunk_sad = calloc((size_t)gate->chunks, sizeof(uint32_t));
+    gate->mask = calloc((size_t)gate->blocks_x * gate->blocks_y, 1);
+    if (!gate->background || !gate->chunk_sad || !gate->mask) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        motion_gate_free_buffers(gate);
+        return -1;
+    }
+    gate->width = width;
+    gate->height = height;
+    gate->primed = false;
+    return 0;
+}
+
+int motion_gate_run(motion_gate_t* gate, const uint8_t* yuyv, int step, int width, int height,
+                    motion_gate_result_t* result) {
+    memset(result, 0, sizeof(*result));
+    if (width < 2 || height < 1 || step < width * 2) {
+        return -1;
+    }
+    if (motion_gate_resize(gate, width, height) != 0) {
+        return -1;
+    }
+
+    const motion_gate_config_t* config = &gate->config;
+    const int d = config->decimation;
+    const int block = config->block_size;
+    const int chunks_per_block = block / MOTION_GATE_CHUNK;
+
+    // The first frame only seeds the background (shift 0 copies it)
+    const bool primed = gate->primed;
+    const int shift = primed ? config->background_shift : 0;
+
+    int changed = 0;
+    int min_bx = gate->blocks_x, min_by = gate->blocks_y, max_bx = -1, max_by = -1;
+    for (int by = 0; by < gate->blocks_y; ++by) {
+        int row_begin = by * block;
+        int row_end = row_begin + block < gate->rows ? row_begin + block : gate->rows;
+
+        memset(gate->chunk_sad, 0, (size_t)gate->chunks * sizeof(uint32_t));
+        for (int r = row_begin; r < row_end; ++r) {
+            gate->row(yuyv + (size_t)r * d * step, d, gate->background + (size_t)r * gate->samples,
+                      gate->samples, shift, gate->chunk_sad);
+        }
+
+        uint8_t* mask_row = gate->mask + (size_t)by * gate->blocks_x;
+        for (int bx = 0; bx < gate->blocks_x; ++bx) {
+            int chunk_begin = bx * chunks_per_block;
+            int chunk_end = chunk_begin + chunks_per_block < gate->chunks ?
+                            chunk_begin + chunks_per_block : gate->chunks;
+            uint64_t sad = 0;
+            for (int c = chunk_begin; c < chunk_end; ++c) {
+                sad += gate->chunk_sad[c];
+            }
+
+            // Edge blocks compare against the samples they actually have
+            int cols = gate->samples - bx * block < block ? gate->samples - bx * block : block;
+            uint64_t limit = (uint64_t)config->threshold * (uint64_t)cols * (uint64_t)(row_end - row_begin);
+            bool moved = !primed || sad > limit;
+            mask_row[bx] = moved;
+            if (moved) {
+                changed++;
+                min_bx = bx < min_bx ? bx : min_bx;
+                max_bx = bx > max_bx ? bx : max_bx;
+                min_by = by < min_by ? by : min_by;
+                max_by = by > max_by ? by : max_by;
+            }
+        }
+    }
+    gate->primed = true;
+
+    int total = gate->blocks_x * gate->blocks_y;
+    result->changed_blocks = changed;
+    result->score = total ? (float)changed / (float)total : 0.0f;
+    if (changed > 0) {
+        // Grown by a block on every side: a change covering only a sliver
+        // of the next block stays under its threshold. The last block
+        // column also covers the columns the decimation skipped.
+        min_bx = min_bx > 0 ? min_bx - 1 : 0;
+        min_by = min_by > 0 ? min_by - 1 : 0;
+        max_bx = max_bx + 1 < gate->blocks_x ? max_bx + 1 : gate->blocks_x - 1;
+        max_by = max_by + 1 < gate->blocks_y ? max_by + 1 : gate->blocks_y - 1;
+        int pixels = block * d;
+        result->x = min_bx * pixels;
+        result->y = min_by * pixels;
+        int x_end = max_bx == gate->blocks_x - 1 ? width : (max_bx + 1) * pixels;
+        int y_end = (max_by + 1) * pixels < height ? (max_by + 1) * pixels : height;
+        result->width = x_end - result->x;
+        result->height = y_end - result->y;
+    }
+
+    if (!primed || changed >= config->min_blocks) {
+        gate->hold = config->hold_frames;
+        result->motion = true;
+    } else if (gate->hold > 0) {
+        gate->hold--;
+        result->motion = true;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "motion_gate/motion_gate.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <stddef.h>
+#include <arm_neon.h>
+
+// The structure loads split YUYV on the fly: vld2 puts every Y in val[0],
+// vld4 every second Y, and two vld4 with an unzip every fourth. The
+// background update is a rounding shift (vrshl by -shift), which is the
+// scalar kernel's (diff + 2^(shift-1)) >> shift.
+
+static inline uint8x16_t load_luma(const uint8_t* src, int decimation) {
+    if (decimation == 1) {
+        return vld2q_u8(src).val[0];
+    }
+    if (decimation == 2) {
+        return vld4q_u8(src).val[0];
+    }
+    uint8x16_t a = vld4q_u8(src).val[0];
+    uint8x16_t b = vld4q_u8(src + 64).val[0];
+    return vuzpq_u8(a, b).val[0];
+}
+
+static inline uint8x8_t follow_half(uint8x8_t y, uint8x8_t b, int16x8_t shift) {
+    int16x8_t diff = vreinterpretq_s16_u16(vsubl_u8(y, b));
+    int16x8_t moved = vaddq_s16(vreinterpretq_s16_u16(vmovl_u8(b)), vrshlq_s16(diff, shift));
+    return vqmovun_s16(moved);
+}
+
+void motion_gate_row_neon(const uint8_t* yuyv, int decimation, uint8_t* background,
+                          int samples, int shift, uint32_t* sad) {
+    const int16x8_t v_shift = vdupq_n_s16((int16_t)-shift);
+    const int chunks = samples / MOTION_GATE_CHUNK;
+    const size_t chunk_bytes = (size_t)32 * decimation;
+
+    for (int c = 0; c < chunks; ++c) {
+        uint8x16_t y = load_luma(yuyv + (size_t)c * chunk_bytes, decimation);
+        uint8_t* bg = background + (size_t)c * MOTION_GATE_CHUNK;
+        uint8x16_t b = vld1q_u8(bg);
+
+        // |y - b| summed pairwise up to two 64-bit halves
+        uint64x2_t s = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vabdq_u8(y, b))));
+        sad[c] += (uint32_t)(vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1));
+
+        if (shift == 0) {
+            vst1q_u8(bg, y);
+        } else {
+            vst1q_u8(bg, vcombine_u8(follow_half(vget_low_u8(y), vget_low_u8(b), v_shift),
+                                     follow_half(vget_high_u8(y), vget_high_u8(b), v_shift)));
+        }
+    }
+
+    int done = chunks * MOTION_GATE_CHUNK;
+    motion_gate_row_scalar(yuyv + (size_t)done * 2 * decimation, decimation, background + done,
+                           samples - done, shift, sad + chunks);
+}
+
+#endif
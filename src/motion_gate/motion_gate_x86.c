@@ -0,0 +1,89 @@
+#include "motion_gate/motion_gate.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <stddef.h>
+#include <emmintrin.h>
+
+// 16 Y samples from 32 * decimation YUYV bytes. Y is the low byte of each
+// 16-bit pair; decimation 2 keeps the low byte of each 32-bit group and 4
+// of each 64-bit group, narrowed with saturating packs (values fit).
+static inline __m128i load_luma_d1(const uint8_t* src) {
+    const __m128i mask = _mm_set1_epi16(0x00ff);
+    __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)src), mask);
+    __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 16)), mask);
+    return _mm_packus_epi16(a, b);
+}
+
+static inline __m128i load_dwords_d2(const uint8_t* src) {
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)src), mask);
+    __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 16)), mask);
+    return _mm_packs_epi32(a, b);
+}
+
+static inline __m128i load_luma_d2(const uint8_t* src) {
+    return _mm_packus_epi16(load_dwords_d2(src), load_dwords_d2(src + 32));
+}
+
+// 4 samples as dwords from 64 bytes: the low byte of each 64-bit group,
+// moved into the low half of each register and joined
+static inline __m128i load_dwords_d4(const uint8_t* src) {
+    const __m128i mask = _mm_set_epi32(0, 0xff, 0, 0xff);
+    __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)src), mask);
+    __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 16)), mask);
+    __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 32)), mask);
+    __m128i d = _mm_and_si128(_mm_loadu_si128((const __m128i*)(src + 48)), mask);
+    a = _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)),
+                           _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+    c = _mm_unpacklo_epi64(_mm_shuffle_epi32(c, _MM_SHUFFLE(3, 1, 2, 0)),
+                           _mm_shuffle_epi32(d, _MM_SHUFFLE(3, 1, 2, 0)));
+    return _mm_packs_epi32(a, c);
+}
+
+static inline __m128i load_luma_d4(const uint8_t* src) {
+    return _mm_packus_epi16(load_dwords_d4(src), load_dwords_d4(src + 64));
+}
+
+// background + ((y - background + round) >> shift) on 8 samples widened to 16 bits
+static inline __m128i follow_half(__m128i y, __m128i b, __m128i round, __m128i shift) {
+    __m128i diff = _mm_add_epi16(_mm_sub_epi16(y, b), round);
+    return _mm_add_epi16(b, _mm_sra_epi16(diff, shift));
+}
+
+void motion_gate_row_sse2(const uint8_t* yuyv, int decimation, uint8_t* background,
+                          int samples, int shift, uint32_t* sad) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i v_round = _mm_set1_epi16((short)(shift > 0 ? 1 << (shift - 1) : 0));
+    const __m128i v_shift = _mm_cvtsi32_si128(shift);
+    const int chunks = samples / MOTION_GATE_CHUNK;
+    const size_t chunk_bytes = (size_t)32 * decimation;
+
+    for (int c = 0; c < chunks; ++c) {
+        const uint8_t* src = yuyv + (size_t)c * chunk_bytes;
+        __m128i y = decimation == 1 ? load_luma_d1(src) :
+                    decimation == 2 ? load_luma_d2(src) : load_luma_d4(src);
+        __m128i* bg = (__m128i*)(background + (size_t)c * MOTION_GATE_CHUNK);
+        __m128i b = _mm_loadu_si128(bg);
+
+        // psadbw: one sum per 8 bytes
+        __m128i s = _mm_sad_epu8(y, b);
+        sad[c] += (uint32_t)(_mm_cvtsi128_si32(s) + _mm_cvtsi128_si32(_mm_srli_si128(s, 8)));
+
+        if (shift == 0) {
+            _mm_storeu_si128(bg, y);
+        } else {
+            __m128i lo = follow_half(_mm_unpacklo_epi8(y, zero), _mm_unpacklo_epi8(b, zero),
+                                     v_round, v_shift);
+            __m128i hi = follow_half(_mm_unpackhi_epi8(y, zero), _mm_unpackhi_epi8(b, zero),
+                                     v_round, v_shift);
+            _mm_storeu_si128(bg, _mm_packus_epi16(lo, hi));
+        }
+    }
+
+    int done = chunks * MOTION_GATE_CHUNK;
+    motion_gate_row_scalar(yuyv + (size_t)done * 2 * decimation, decimation, background + done,
+                           samples - done, shift, sad + chunks);
+}
+
+#endif
@@ -0,0 +1,437 @@
+#include "onnx_session/onnx_session.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <rcutils/logging_macros.h>
+
+#define ONNX_SESSION_ALIGNMENT 64
+
+// Log and release a failed status; 0 if there was none
+static int onnx_session_check(const onnx_session_t* session, OrtStatus* status, const char* what) {
+    if (!status) {
+        return 0;
+    }
+    RCUTILS_LOG_ERROR("%s: %s", what, session->api->GetErrorMessage(status));
+    session->api->ReleaseStatus(status);
+    return -1;
+}
+
+void onnx_session_options_default(onnx_session_options_t* options) {
+    memset(options, 0, sizeof(*options));
+    options->intra_op_threads = 0;
+    options->inter_op_threads = 1;
+    options->graph_optimization = ORT_ENABLE_ALL;
+    options->cpu_mem_arena = true;
+    options->mem_pattern = true;
+    options->allow_spinning = false;
+}
+
+int onnx_session_parse_optimization(const char* name, GraphOptimizationLevel* level) {
+    static const struct {
+        const char* name;
+        GraphOptimizationLevel level;
+    } levels[] = {
+        { "disable", ORT_DISABLE_ALL },
+        { "basic", ORT_ENABLE_BASIC },
+        { "extended", ORT_ENABLE_EXTENDED },
+        { "all", ORT_ENABLE_ALL },
+    };
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+        if (strcasecmp(levels[i].name, name) == 0) {
+            *level = levels[i].level;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static OrtSessionOptions* onnx_session_create_options(onnx_session_t* session,
+                                                      const onnx_session_options_t* options) {
+    const OrtApi* api = session->api;
+    OrtSessionOptions* ort_options = NULL;
+    if (onnx_session_check(session, api->CreateSessionOptions(&ort_options),
+                           "Failed to create session options") != 0) {
+        return NULL;
+    }
+
+    const char* spinning = options->allow_spinning ? "1" : "0";
+    ExecutionMode mode = options->inter_op_threads > 1 ? ORT_PARALLEL : ORT_SEQUENTIAL;
+    OrtStatus* status = api->SetIntraOpNumThreads(ort_options, options->intra_op_threads);
+    if (!status) {
+        status = api->SetInterOpNumThreads(ort_options, options->inter_op_threads);
+    }
+    if (!status) {
+        status = api->SetSessionExecutionMode(ort_options, mode);
+    }
+    if (!status) {
+        status = api->SetSessionGraphOptimizationLevel(ort_options, options->graph_optimization);
+    }
+    if (!status) {
+        status = options->cpu_mem_arena ? api->EnableCpuMemArena(ort_options) :
+                                          api->DisableCpuMemArena(ort_options);
+    }
+    if (!status) {
+        status = options->mem_pattern ? api->EnableMemPattern(ort_options) :
+                                        api->DisableMemPattern(ort_options);
+    }
+    if (!status) {
+        status = api->AddSessionConfigEntry(ort_options, "session.intra_op.allow_spinning", spinning);
+    }
+    if (!status) {
+        status = api->AddSessionConfigEntry(ort_options, "session.inter_op.allow_spinning", spinning);
+    }
+    if (onnx_session_check(session, status, "Failed to set session options") != 0) {
+        api->ReleaseSessionOptions(ort_options);
+        return NULL;
+    }
+    return ort_options;
+}
+
+// Name, element type and shape of one model input or output
+static int onnx_session_describe(onnx_session_t* session, size_t index, bool is_input,
+                                 onnx_tensor_t* tensor) {
+    const OrtApi* api = session->api;
+    OrtAllocator* allocator = NULL;
+    char* name = NULL;
+    OrtTypeInfo* type_info = NULL;
+
+    OrtStatus* status = api->GetAllocatorWithDefaultOptions(&allocator);
+    if (!status) {
+        status = is_input ? api->SessionGetInputName(session->session, index, allocator, &name) :
+                            api->SessionGetOutputName(session->session, index, allocator, &name);
+    }
+    if (!status) {
+        status = is_input ? api->SessionGetInputTypeInfo(session->session, index, &type_info) :
+                            api->SessionGetOutputTypeInfo(session->session, index, &type_info);
+    }
+    if (onnx_session_check(session, status, "Failed to query the model") != 0) {
+        if (name) {
+            api->AllocatorFree(allocator, name);
+        }
+        return -1;
+    }
+
+    tensor->name = strdup(name);
+    api->AllocatorFree(allocator, name);
+
+    const OrtTensorTypeAndShapeInfo* info = NULL;
+    ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+    size_t dim_count = 0;
+    status = api->CastTypeInfoToTensorInfo(type_info, &info);
+    if (!status && !info) {
+        RCUTILS_LOG_ERROR("Model %s %zu is not a tensor", is_input ? "input" : "output", index);
+        api->ReleaseTypeInfo(type_info);
+        return -1;
+    }
+    if (!status) {
+        status = api->GetTensorElementType(info, &type);
+    }
+    if (!status) {
+        status = api->GetDimensionsCount(info, &dim_count);
+    }
+    if (!status && dim_count > ONNX_SESSION_MAX_DIMS) {
+        RCUTILS_LOG_ERROR("Tensor %s has %zu dimensions", tensor->name ? tensor->name : "?", dim_count);
+        api->ReleaseTypeInfo(type_info);
+        return -1;
+    }
+    if (!status) {
+        status = api->GetDimensions(info, tensor->dims, dim_count);
+    }
+    api->ReleaseTypeInfo(type_info);
+    if (onnx_session_check(session, status, "Failed to query tensor shape") != 0 || !tensor->name) {
+        return -1;
+    }
+
+    if (type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+        RCUTILS_LOG_ERROR("Tensor %s is not float32 (type %d)", tensor->name, (int)type);
+        return -1;
+    }
+    tensor->dim_count = dim_count;
+    return 0;
+}
+
+static bool onnx_tensor_is_static(const onnx_tensor_t* tensor) {
+    for (size_t i = 0; i < tensor->dim_count; ++i) {
+        if (tensor->dims[i] <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Allocate a buffer for a fully known shape and wrap it in an OrtValue
+static int onnx_session_create_tensor(onnx_session_t* session, onnx_tensor_t* tensor,
+                                      float** data, OrtValue** value) {
+    size_t count = 1;
+    for (size_t i = 0; i < tensor->dim_count; ++i) {
+        count *= (size_t)tensor->dims[i];
+    }
+
+    void* buffer = NULL;
+    if (posix_memalign(&buffer, ONNX_SESSION_ALIGNMENT, count * sizeof(float)) != 0) {
+        RCUTILS_LOG_ERROR("Out of memory for tensor %s", tensor->name);
+        return -1;
+    }
+    memset(buffer, 0, count * sizeof(float));
+    *data = (float*)buffer;
+    tensor->count = count;
+
+    return onnx_session_check(session,
+        session->api->CreateTensorWithDataAsOrtValue(session->memory_info, buffer,
+            count * sizeof(float), tensor->dims, tensor->dim_count,
+            ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, value),
+        "Failed to create tensor");
+}
+
+// One ordinary (allocating) run on the zeroed input of slot 0 to learn
+// the shape of outputs with dynamic dimensions
+static int onnx_session_probe_outputs(onnx_session_t* session) {
+    const OrtApi* api = session->api;
+    const char* output_names[ONNX_SESSION_MAX_OUTPUTS];
+    OrtValue* values[ONNX_SESSION_MAX_OUTPUTS] = { NULL };
+    for (size_t i = 0; i < session->output_count; ++i) {
+        output_names[i] = session->outputs[i].name;
+    }
+
+    const char* input_name = session->input.name;
+    const OrtValue* input_value = session->slots[0].input_value;
+    int result = onnx_session_check(session,
+        api->Run(session->session, NULL, &input_name, &input_value, 1,
+                 output_names, session->output_count, values),
+        "Probe inference failed");
+
+    for (size_t i = 0; i < session->output_count; ++i) {
+        if (result == 0 && !onnx_tensor_is_static(&session->outputs[i])) {
+            OrtTensorTypeAndShapeInfo* info = NULL;
+            size_t dim_count = 0;
+            OrtStatus* status = api->GetTensorTypeAndShape(values[i], &info);
+            if (!status) {
+                status = api->GetDimensionsCount(info, &dim_count);
+            }
+            if (!status && dim_count <= ONNX_SESSION_MAX_DIMS) {
+                status = api->GetDimensions(info, session->outputs[i].dims, dim_count);
+                session->outputs[i].dim_count = dim_count;
+            }
+            if (info) {
+                api->ReleaseTensorTypeAndShapeInfo(info);
+            }
+            if (onnx_session_check(session, status, "Failed to read output shape") != 0 ||
+                dim_count > ONNX_SESSION_MAX_DIMS) {
+                result = -1;
+            }
+        }
+        if (values[i]) {
+            api->ReleaseValue(values[i]);
+        }
+    }
+    return result;
+}
+
+static int onnx_session_bind(onnx_session_t* session, onnx_session_slot_t* slot) {
+    const OrtApi* api = session->api;
+    OrtStatus* status = api->CreateIoBinding(session->session, &slot->binding);
+    if (!status) {
+        status = api->BindInput(slot->binding, session->input.name, slot->input_value);
+    }
+    for (size_t i = 0; !status && i < session->output_count; ++i) {
+        status = api->BindOutput(slot->binding, session->outputs[i].name, slot->output_values[i]);
+    }
+    return onnx_session_check(session, status, "Failed to bind tensors");
+}
+
+static void onnx_session_log_tensor(const char* kind, const onnx_tensor_t* tensor) {
+    char shape[128];
+    size_t used = 0;
+    shape[0] = '\0';
+    for (size_t i = 0; i < tensor->dim_count && used < sizeof(shape); ++i) {
+        used += (size_t)snprintf(shape + used, sizeof(shape) - used, "%s%lld",
+                                 i ? "x" : "", (long long)tensor->dims[i]);
+    }
+    RCUTILS_LOG_INFO("Model %s '%s': %s", kind, tensor->name, shape);
+}
+
+int onnx_session_init(onnx_session_t* session, const char* model_path,
+                      const onnx_session_options_t* options,
+                      int input_width, int input_height, int slot_count) {
+    memset(session, 0, sizeof(*session));
+    if (slot_count < 1 || slot_count > ONNX_SESSION_MAX_SLOTS) {
+        RCUTILS_LOG_ERROR("Invalid tensor slot count %d", slot_count);
+        return -1;
+    }
+
+    const OrtApiBase* base = OrtGetApiBase();
+    session->api = base ? base->GetApi(ORT_API_VERSION) : NULL;
+    if (!session->api) {
+        RCUTILS_LOG_ERROR("ONNX Runtime library does not provide API version %d", ORT_API_VERSION);
+        return -1;
+    }
+    const OrtApi* api = session->api;
+
+    if (onnx_session_check(session, api->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "inference_node",
+                                                   &session->env),
+                           "Failed to create ONNX Runtime environment") != 0) {
+        onnx_session_fini(session);
+        return -1;
+    }
+
+    OrtSessionOptions* ort_options = onnx_session_create_options(session, options);
+    if (!ort_options) {
+        onnx_session_fini(session);
+        return -1;
+    }
+    OrtStatus* status = api->CreateSession(session->env, model_path, ort_options, &session->session);
+    api->ReleaseSessionOptions(ort_options);
+    if (onnx_session_check(session, status, "Failed to load model") != 0) {
+        onnx_session_fini(session);
+        return -1;
+    }
+
+    size_t input_count = 0;
+    status = api->SessionGetInputCount(session->session, &input_count);
+    if (!status) {
+        status = api->SessionGetOutputCount(session->session, &session->output_count);
+    }
+    if (onnx_session_check(session, status, "Failed to query the model") != 0) {
+        onnx_session_fini(session);
+        return -1;
+    }
+    if (input_count != 1 || session->output_count < 1 ||
+        session->output_count > ONNX_SESSION_MAX_OUTPUTS) {
+        RCUTILS_LOG_ERROR("Expected 1 input and 1-%d outputs, model has %zu and %zu",
+            ONNX_SESSION_MAX_OUTPUTS, input_count, session->output_count);
+        session->output_count = 0;
+        onnx_session_fini(session);
+        return -1;
+    }
+
+    // Image input: resolve dynamic batch, channel and size dimensions
+    onnx_tensor_t* input = &session->input;
+    if (onnx_session_describe(session, 0, true, input) != 0) {
+        onnx_session_fini(session);
+        return -1;
+    }
+    if (input->dim_count != 4 || (input->dims[1] > 0 && input->dims[1] != 3)) {
+        RCUTILS_LOG_ERROR("Model input %s is not a 3-channel NCHW image", input->name);
+        onnx_session_fini(session);
+        return -1;
+    }
+    const int64_t fallback[4] = { 1, 3, input_height, input_width };
+    for (int i = 0; i < 4; ++i) {
+        if (input->dims[i] <= 0) {
+            input->dims[i] = fallback[i];
+        }
+    }
+
+    if (onnx_session_check(session, api->CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault,
+                                                             &session->memory_info),
+                           "Failed to create memory info") != 0 ||
+        onnx_session_check(session, api->CreateRunOptions(&session->run_options),
+                           "Failed to create run options") != 0) {
+        onnx_session_fini(session);
+        return -1;
+    }
+    session->slot_count = slot_count;
+    for (int s = 0; s < slot_count; ++s) {
+        onnx_session_slot_t* slot = &session->slots[s];
+        if (onnx_session_create_tensor(session, input, &slot->input, &slot->input_value) != 0) {
+            onnx_session_fini(session);
+            return -1;
+        }
+    }
+
+    bool dynamic_outputs = false;
+    for (size_t i = 0; i < session->output_count; ++i) {
+        if (onnx_session_describe(session, i, false, &session->outputs[i]) != 0) {
+            onnx_session_fini(session);
+            return -1;
+        }
+        if (!onnx_tensor_is_static(&session->outputs[i])) {
+            dynamic_outputs = true;
+        }
+    }
+    if (dynamic_outputs && onnx_session_probe_outputs(session) != 0) {
+        onnx_session_fini(session);
+        return -1;
+    }
+    for (int s = 0; s < slot_count; ++s) {
+        onnx_session_slot_t* slot = &session->slots[s];
+        for (size_t i = 0; i < session->output_count; ++i) {
+            if (onnx_session_create_tensor(session, &session->outputs[i], &slot->outputs[i],
+                                           &slot->output_values[i]) != 0) {
+                onnx_session_fini(session);
+                return -1;
+            }
+        }
+        if (onnx_session_bind(session, slot) != 0) {
+            onnx_session_fini(session);
+            return -1;
+        }
+    }
+
+    onnx_session_log_tensor("input", input);
+    for (size_t i = 0; i < session->output_count; ++i) {
+        onnx_session_log_tensor("output", &session->outputs[i]);
+    }
+    return 0;
+}
+
+static void onnx_session_slot_fini(const OrtApi* api, onnx_session_slot_t* slot) {
+    if (slot->binding) {
+        api->ReleaseIoBinding(slot->binding);
+    }
+    if (slot->input_value) {
+        api->ReleaseValue(slot->input_value);
+    }
+    free(slot->input);
+    for (size_t i = 0; i < ONNX_SESSION_MAX_OUTPUTS; ++i) {
+        if (slot->output_values[i]) {
+            api->ReleaseValue(slot->output_values[i]);
+        }
+        free(slot->outputs[i]);
+    }
+    memset(slot, 0, sizeof(*slot));
+}
+
+void onnx_session_fini(onnx_session_t* session) {
+    const OrtApi* api = session->api;
+    if (!api) {
+        return;
+    }
+
+    if (session->run_options) {
+        api->ReleaseRunOptions(session->run_options);
+    }
+    for (int s = 0; s < ONNX_SESSION_MAX_SLOTS; ++s) {
+        onnx_session_slot_fini(api, &session->slots[s]);
+    }
+    free(session->input.name);
+    for (size_t i = 0; i < ONNX_SESSION_MAX_OUTPUTS; ++i) {
+        free(session->outputs[i].name);
+    }
+    if (session->memory_info) {
+        api->ReleaseMemoryInfo(session->memory_info);
+    }
+    if (session->session) {
+        api->ReleaseSession(session->session);
+    }
+    if (session->env) {
+        api->ReleaseEnv(session->env);
+    }
+    memset(session, 0, sizeof(*session));
+}
+
+int onnx_session_run(onnx_session_t* session, int slot) {
+    return onnx_session_check(session,
+        session->api->RunWithBinding(session->session, session->run_options,
+                                     session->slots[slot].binding),
+        "Inference failed");
+}
+
+int onnx_session_input_width(const onnx_session_t* session) {
+    return (int)session->input.dims[3];
+}
+
+int onnx_session_input_height(const onnx_session_t* session) {
+    return (int)session->input.dims[2];
+}
@@ -0,0 +1,136 @@
+#include "pipeline_node/pipeline_node.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <rcutils/logging_macros.h>
+
+void pipeline_node_request_shutdown(void) {
+    camera_node_request_shutdown();
+    display_node_request_shutdown();
+}
+
+static void signal_handler(int sig) {
+    (void)sig;
+    pipeline_node_request_shutdown();
+}
+
+int pipeline_node_init(pipeline_node_t* pipeline, rcl_context_t* context, const camera_config_t* config) {
+    memset(pipeline, 0, sizeof(pipeline_node_t));
+    
+    if (camera_node_init(&pipeline->camera, context, config) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize camera component");
+        return -1;
+    }
+    pipeline->camera_ready = true;
+    
+    if (display_node_init_local(&pipeline->display, context) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize display component");
+        pipeline_node_fini(pipeline);
+        return -1;
+    }
+    pipeline->display_ready = true;
+    
+    if (camera_node_add_sink(&pipeline->camera, display_node_post_frame, &pipeline->display) != 0) {
+        RCUTILS_LOG_ERROR("Failed to connect the display to the camera");
+        pipeline_node_fini(pipeline);
+        return -1;
+    }
+    
+    RCUTILS_LOG_INFO("Pipeline initialized: camera -> display in process");
+    return 0;
+}
+
+void pipeline_node_fini(pipeline_node_t* pipeline) {
+    // The display holds references into the camera's pool, so it goes first
+    if (pipeline->display_ready) {
+        display_node_fini(&pipeline->display);
+        pipeline->display_ready = false;
+    }
+    if (pipeline->camera_ready) {
+        camera_node_fini(&pipeline->camera);
+        pipeline->camera_ready = false;
+    }
+}
+
+static void* pipeline_node_camera_thread(void* arg) {
+    pipeline_node_t* pipeline = (pipeline_node_t*)arg;
+    pipeline->camera_result = camera_node_spin(&pipeline->camera);
+    
+    // A frame limit, end of a replay or a capture error ends the run
+    display_node_request_shutdown();
+    return NULL;
+}
+
+int pipeline_node_spin(pipeline_node_t* pipeline) {
+    if (pthread_create(&pipeline->camera_thread, NULL, pipeline_node_camera_thread, pipeline) != 0) {
+        RCUTILS_LOG_ERROR("Failed to start camera thread");
+        return -1;
+    }
+    
+    // SDL needs the main thread
+    int result = display_node_spin(&pipeline->display);
+    
+    // The window was closed, or the camera stopped first
+    camera_node_request_shutdown();
+    pthread_join(pipeline->camera_thread, NULL);
+    return pipeline->camera_result != 0 ? pipeline->camera_result : result;
+}
+
+int main(int argc, char* argv[]) {
+    // Set up signal handling
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    // Initialize RCL
+    rcl_context_t context = rcl_get_zero_initialized_context();
+    rcl_init_options_t init_options = rcl_get_zero_initialized_init_options();
+    
+    rcl_ret_t ret = rcl_init_options_init(&init_options, rcl_get_default_allocator());
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize init options");
+        return 1;
+    }
+    
+    ret = rcl_init(argc, (const char* const*)argv, &init_options, &context);
+    if (ret != RCL_RET_OK) {
+        RCUTILS_LOG_ERROR("Failed to initialize RCL");
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    // The camera reads the same parameters and flags as camera_node
+    camera_config_t config;
+    camera_config_init(&config, CAMERA_DEVICE, CAMERA_WIDTH, CAMERA_HEIGHT, CAMERA_FPS,
+                       CAMERA_JPEG_QUALITY, CAMERA_COMPRESSED_FPS);
+    if (camera_config_load_params(&config, &context.global_arguments, "camera_node") != 0 ||
+        camera_config_parse_args(&config, argc, argv) != 0) {
+        RCUTILS_LOG_ERROR("Invalid camera configuration");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    camera_config_log(&config);
+    
+    pipeline_node_t pipeline;
+    if (pipeline_node_init(&pipeline, &context, &config) != 0) {
+        RCUTILS_LOG_ERROR("Failed to initialize pipeline");
+        rcl_shutdown(&context);
+        rcl_context_fini(&context);
+        rcl_init_options_fini(&init_options);
+        return 1;
+    }
+    
+    RCUTILS_LOG_INFO("Pipeline node started");
+    
+    int result = pipeline_node_spin(&pipeline);
+    
+    // Cleanup
+    pipeline_node_fini(&pipeline);
+    rcl_shutdown(&context);
+    rcl_context_fini(&context);
+    rcl_init_options_fini(&init_options);
+    
+    RCUTILS_LOG_INFO("Pipeline node stopped");
+    return result;
+}
@@ -0,0 +1,555 @@
+#include "postprocess/postprocess.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+#define POSTPROCESS_CELLS (POSTPROCESS_GRID * POSTPROCESS_GRID)
+#define POSTPROCESS_INSERTION_SORT 16   // Partitions below this are insertion sorted
+
+int postprocess_filter_scalar(const float* scores, size_t stride, int classes, int count,
+                              float threshold, int32_t* index, float* score, int32_t* class_id) {
+    int hits = 0;
+    for (int i = 0; i < count; ++i) {
+        float best = scores[i];
+        int best_class = 0;
+        for (int c = 1; c < classes; ++c) {
+            float value = scores[(size_t)c * stride + i];
+            if (value > best) {
+                best = value;
+                best_class = c;
+            }
+        }
+        if (best >= threshold) {
+            index[hits] = i;
+            score[hits] = best;
+            class_id[hits] = best_class;
+            hits++;
+        }
+    }
+    return hits;
+}
+
+float postprocess_row_max_scalar(const float* row, int count) {
+    float best = row[0];
+    for (int i = 1; i < count; ++i) {
+        if (row[i] > best) {
+            best = row[i];
+        }
+    }
+    return best;
+}
+
+postprocess_filter_fn postprocess_get_filter(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return postprocess_filter_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        case COLOR_CONVERT_ISA_SSE2:
+            return postprocess_filter_sse2;
+        case COLOR_CONVERT_ISA_AVX2:
+            return postprocess_filter_avx2;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+            return postprocess_filter_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+postprocess_row_max_fn postprocess_get_row_max(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return postprocess_row_max_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        case COLOR_CONVERT_ISA_SSE2:
+            return postprocess_row_max_sse2;
+        case COLOR_CONVERT_ISA_AVX2:
+            return postprocess_row_max_avx2;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+            return postprocess_row_max_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+void postprocess_config_default(postprocess_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->layout = POSTPROCESS_LAYOUT_AUTO;
+    config->conf_threshold = 0.25f;
+    config->iou_threshold = 0.45f;
+    config->max_detections = 100;
+    config->pre_nms_top_k = POSTPROCESS_PRE_NMS_TOP_K;
+    config->class_agnostic = false;
+}
+
+const char* postprocess_layout_name(postprocess_layout_t layout) {
+    switch (layout) {
+        case POSTPROCESS_LAYOUT_YOLOV5:
+            return "yolov5";
+        case POSTPROCESS_LAYOUT_YOLOV8:
+            return "yolov8";
+        default:
+            return "auto";
+    }
+}
+
+// Candidates entering NMS
+static int postprocess_top_k(const postprocess_t* pp) {
+    int top_k = pp->config.pre_nms_top_k;
+    return top_k > 0 && top_k < pp->candidates ? top_k : pp->candidates;
+}
+
+int postprocess_init(postprocess_t* pp, const postprocess_config_t* config,
+                     const int64_t* dims, size_t dim_count) {
+    memset(pp, 0, sizeof(*pp));
+    pp->config = *config;
+
+    // Drop the batch dimension
+    if (dim_count == 3 && dims[0] == 1) {
+        dims++;
+        dim_count--;
+    }
+    if (dim_count != 2 || dims[0] <= 0 || dims[1] <= 0) {
+        RCUTILS_LOG_ERROR("Unsupported detection output shape");
+        return -1;
+    }
+    if (config->max_detections < 1 || config->pre_nms_top_k < 0) {
+        RCUTILS_LOG_ERROR("Invalid detection limits");
+        return -1;
+    }
+
+    // Candidates always outnumber attributes in real models
+    postprocess_layout_t layout = config->layout;
+    if (layout == POSTPROCESS_LAYOUT_AUTO) {
+        layout = dims[0] < dims[1] ? POSTPROCESS_LAYOUT_YOLOV8 : POSTPROCESS_LAYOUT_YOLOV5;
+    }
+
+    int64_t attributes = layout == POSTPROCESS_LAYOUT_YOLOV8 ? dims[0] : dims[1];
+    int64_t candidates = layout == POSTPROCESS_LAYOUT_YOLOV8 ? dims[1] : dims[0];
+    int64_t classes = attributes - (layout == POSTPROCESS_LAYOUT_YOLOV8 ? 4 : 5);
+    if (classes < 1 || candidates > INT32_MAX) {
+        RCUTILS_LOG_ERROR("Output shape %lldx%lld does not match the %s layout",
+            (long long)dims[0], (long long)dims[1], postprocess_layout_name(layout));
+        return -1;
+    }
+
+    pp->layout = layout;
+    pp->candidates = (int)candidates;
+    pp->classes = (int)classes;
+
+    size_t count = (size_t)candidates;
+    size_t top_k = (size_t)postprocess_top_k(pp);
+    size_t max_detections = (size_t)config->max_detections;
+    pp->hit_index = malloc(count * sizeof(int32_t));
+    pp->hit_score = malloc(count * sizeof(float));
+    pp->hit_class = malloc(count * sizeof(int32_t));
+    pp->keys = malloc(count * sizeof(uint64_t));
+    pp->boxes = malloc(top_k * sizeof(postprocess_detection_t));
+    pp->cell_boxes = malloc(POSTPROCESS_CELLS * max_detections * sizeof(int32_t));
+    pp->visited = malloc(max_detections * sizeof(int32_t));
+    if (!pp->hit_index || !pp->hit_score || !pp->hit_class || !pp->keys || !pp->boxes ||
+        !pp->cell_boxes || !pp->visited) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        postprocess_fini(pp);
+        return -1;
+    }
+
+    // The SIMD kernel follows the color conversion choice
+    pp->isa = color_convert_active_isa();
+    pp->filter = postprocess_get_filter(pp->isa);
+    pp->row_max = postprocess_get_row_max(pp->isa);
+    if (!pp->filter || !pp->row_max) {
+        pp->filter = postprocess_filter_scalar;
+        pp->row_max = postprocess_row_max_scalar;
+    }
+    return 0;
+}
+
+void postprocess_fini(postprocess_t* pp) {
+    free(pp->hit_index);
+    free(pp->hit_score);
+    free(pp->hit_class);
+    free(pp->keys);
+    free(pp->boxes);
+    free(pp->cell_boxes);
+    free(pp->visited);
+    memset(pp, 0, sizeof(*pp));
+}
+
+static void postprocess_set_box(postprocess_detection_t* box, float cx, float cy, float w, float h,
+                                float score, int class_id) {
+    box->x1 = cx - w * 0.5f;
+    box->y1 = cy - h * 0.5f;
+    box->x2 = cx + w * 0.5f;
+    box->y2 = cy + h * 0.5f;
+    box->score = score;
+    box->class_id = class_id;
+}
+
+static void postprocess_decode_box(const postprocess_t* pp, const float* output, int index,
+                                   float score, int class_id, postprocess_detection_t* box) {
+    if (pp->layout == POSTPROCESS_LAYOUT_YOLOV8) {
+        size_t stride = (size_t)pp->candidates;
+        postprocess_set_box(box, output[index], output[stride + index], output[2 * stride + index],
+                            output[3 * stride + index], score, class_id);
+        return;
+    }
+    const float* row = output + (size_t)index * ((size_t)pp->classes + 5);
+    postprocess_set_box(box, row[0], row[1], row[2], row[3], score, class_id);
+}
+
+static float postprocess_iou(const postprocess_detection_t* a, const postprocess_detection_t* b) {
+    float w = (a->x2 < b->x2 ? a->x2 : b->x2) - (a->x1 > b->x1 ? a->x1 : b->x1);
+    float h = (a->y2 < b->y2 ? a->y2 : b->y2) - (a->y1 > b->y1 ? a->y1 : b->y1);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = w * h;
+    float area_a = (a->x2 - a->x1) * (a->y2 - a->y1);
+    float area_b = (b->x2 - b->x1) * (b->y2 - b->y1);
+    return inter / (area_a + area_b - inter);
+}
+
+static bool postprocess_suppresses(const postprocess_config_t* config,
+                                   const postprocess_detection_t* kept,
+                                   const postprocess_detection_t* box) {
+    return (config->class_agnostic || kept->class_id == box->class_id) &&
+           postprocess_iou(kept, box) > config->iou_threshold;
+}
+
+// ---------------------------------------------------------------------------
+// Filter: candidates over the threshold into pp->keys
+// ---------------------------------------------------------------------------
+
+// Sort key: score ordered as an unsigned integer in the high half (-0 folded
+// into +0), ~index in the low half so equal scores keep tensor order
+static inline uint64_t postprocess_key(float score, int32_t index) {
+    union {
+        float f;
+        uint32_t u;
+    } bits;
+    bits.f = score + 0.0f;
+    uint32_t ordered = (bits.u & 0x80000000u) ? ~bits.u : (bits.u | 0x80000000u);
+    return ((uint64_t)ordered << 32) | (uint32_t)~(uint32_t)index;
+}
+
+static inline int32_t postprocess_key_index(uint64_t key) {
+    return (int32_t)~(uint32_t)key;
+}
+
+static int postprocess_filter(postprocess_t* pp, const float* output) {
+    float threshold = pp->config.conf_threshold;
+    int hits = 0;
+
+    if (pp->layout == POSTPROCESS_LAYOUT_YOLOV8) {
+        size_t stride = (size_t)pp->candidates;
+        hits = pp->filter(output + 4 * stride, stride, pp->classes, pp->candidates, threshold,
+                          pp->hit_index, pp->hit_score, pp->hit_class);
+    } else {
+        // Objectness bounds the score, so most rows stop at row[4]
+        size_t row_size = (size_t)pp->classes + 5;
+        for (int i = 0; i < pp->candidates; ++i) {
+            const float* row = output + (size_t)i * row_size;
+            if (!(row[4] >= threshold)) {
+                continue;
+            }
+            float best = pp->row_max(row + 5, pp->classes);
+            int best_class = 0;
+            while (best_class < pp->classes - 1 && !(row[5 + best_class] == best)) {
+                best_class++;
+            }
+            float score = row[4] * row[5 + best_class];
+            if (score >= threshold) {
+                pp->hit_index[hits] = i;
+                pp->hit_score[hits] = score;
+                pp->hit_class[hits] = best_class;
+                hits++;
+            }
+        }
+    }
+
+    // Keys carry the position in the hit arrays; the class and box are only
+    // looked up for the top k
+    for (int i = 0; i < hits; ++i) {
+        pp->keys[i] = postprocess_key(pp->hit_score[i], i);
+    }
+    return hits;
+}
+
+// ---------------------------------------------------------------------------
+// Top k: quickselect, then sort only the selected keys (descending)
+// ---------------------------------------------------------------------------
+
+static inline void postprocess_swap(uint64_t* a, uint64_t* b) {
+    uint64_t t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// Hoare partition around the median of the first, middle and last key.
+// Keys are unique, so the median is neither the largest nor the smallest
+// and both sides are non-empty. Returns p with keys[0, p] >= keys(p, count).
+static int postprocess_partition(uint64_t* keys, int count) {
+    uint64_t a = keys[0];
+    uint64_t b = keys[count / 2];
+    uint64_t c = keys[count - 1];
+    uint64_t pivot = a > b ? (b > c ? b : (a > c ? c : a)) : (a > c ? a : (b > c ? c : b));
+
+    int i = -1;
+    int j = count;
+    for (;;) {
+        do {
+            ++i;
+        } while (keys[i] > pivot);
+        do {
+            --j;
+        } while (keys[j] < pivot);
+        if (i >= j) {
+            return j;
+        }
+        postprocess_swap(&keys[i], &keys[j]);
+    }
+}
+
+static void postprocess_insertion_sort(uint64_t* keys, int count) {
+    for (int i = 1; i < count; ++i) {
+        uint64_t key = keys[i];
+        int j = i;
+        while (j > 0 && keys[j - 1] < key) {
+            keys[j] = keys[j - 1];
+            --j;
+        }
+        keys[j] = key;
+    }
+}
+
+static void postprocess_sort(uint64_t* keys, int count) {
+    // Recurse into the smaller side, loop on the larger: O(log n) stack
+    while (count > POSTPROCESS_INSERTION_SORT) {
+        int p = postprocess_partition(keys, count) + 1;
+        if (p < count - p) {
+            postprocess_sort(keys, p);
+            keys += p;
+            count -= p;
+        } else {
+            postprocess_sort(keys + p, count - p);
+            count = p;
+        }
+    }
+    postprocess_insertion_sort(keys, count);
+}
+
+// Move the k largest keys to the front, in no particular order
+static void postprocess_select(uint64_t* keys, int count, int k) {
+    while (count > POSTPROCESS_INSERTION_SORT) {
+        int p = postprocess_partition(keys, count) + 1;
+        if (k < p) {
+            count = p;
+        } else if (k > p) {
+            keys += p;
+            count -= p;
+            k -= p;
+        } else {
+            return;
+        }
+    }
+    postprocess_insertion_sort(keys, count);
+}
+
+// ---------------------------------------------------------------------------
+// Grid NMS
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    float origin_x;
+    float origin_y;
+    float scale_x;              // Cells per pixel, 0 if the boxes have no extent
+    float scale_y;
+} postprocess_grid_t;
+
+static float postprocess_grid_scale(float lo, float hi) {
+    float scale = (float)POSTPROCESS_GRID / (hi - lo);
+    return isfinite(scale) && scale > 0.0f ? scale : 0.0f;
+}
+
+// Cells are a monotonic function of the coordinate, so two boxes that
+// intersect always share at least one cell
+static inline int postprocess_cell(float value, float origin, float scale) {
+    float cell = (value - origin) * scale;
+    if (!(cell > 0.0f)) {
+        return 0;
+    }
+    return cell < (float)(POSTPROCESS_GRID - 1) ? (int)cell : POSTPROCESS_GRID - 1;
+}
+
+int postprocess_run(postprocess_t* pp, const float* output,
+                    postprocess_detection_t* detections, int capacity) {
+    int count = postprocess_filter(pp, output);
+    int top_k = postprocess_top_k(pp);
+    if (count > top_k) {
+        postprocess_select(pp->keys, count, top_k);
+        count = top_k;
+    }
+    postprocess_sort(pp->keys, count);
+
+    // Boxes for the survivors only, and their extent for the grid
+    float min_x = INFINITY;
+    float min_y = INFINITY;
+    float max_x = -INFINITY;
+    float max_y = -INFINITY;
+    for (int i = 0; i < count; ++i) {
+        int hit = postprocess_key_index(pp->keys[i]);
+        postprocess_detection_t* box = &pp->boxes[i];
+        postprocess_decode_box(pp, output, pp->hit_index[hit], pp->hit_score[hit],
+                               pp->hit_class[hit], box);
+        min_x = box->x1 < min_x ? box->x1 : min_x;
+        min_y = box->y1 < min_y ? box->y1 : min_y;
+        max_x = box->x2 > max_x ? box->x2 : max_x;
+        max_y = box->y2 > max_y ? box->y2 : max_y;
+    }
+    postprocess_grid_t grid = { min_x, min_y, postprocess_grid_scale(min_x, max_x),
+                                postprocess_grid_scale(min_y, max_y) };
+
+    int limit = capacity < pp->config.max_detections ? capacity : pp->config.max_detections;
+    int max_detections = pp->config.max_detections;
+    memset(pp->cell_count, 0, sizeof(pp->cell_count));
+
+    int kept = 0;
+    for (int i = 0; i < count && kept < limit; ++i) {
+        const postprocess_detection_t* box = &pp->boxes[i];
+        int cx0 = postprocess_cell(box->x1, grid.origin_x, grid.scale_x);
+        int cx1 = postprocess_cell(box->x2, grid.origin_x, grid.scale_x);
+        int cy0 = postprocess_cell(box->y1, grid.origin_y, grid.scale_y);
+        int cy1 = postprocess_cell(box->y2, grid.origin_y, grid.scale_y);
+
+        // A kept box spanning several cells is tested once
+        bool suppressed = false;
+        for (int cy = cy0; cy <= cy1 && !suppressed; ++cy) {
+            for (int cx = cx0; cx <= cx1 && !suppressed; ++cx) {
+                int cell = cy * POSTPROCESS_GRID + cx;
+                const int32_t* list = pp->cell_boxes + (size_t)cell * max_detections;
+                for (int n = 0; n < pp->cell_count[cell] && !suppressed; ++n) {
+                    int k = list[n];
+                    if (pp->visited[k] == i + 1) {
+                        continue;
+                    }
+                    pp->visited[k] = i + 1;
+                    suppressed = postprocess_suppresses(&pp->config, &detections[k], box);
+                }
+            }
+        }
+        if (suppressed) {
+            continue;
+        }
+
+        detections[kept] = *box;
+        pp->visited[kept] = 0;
+        for (int cy = cy0; cy <= cy1; ++cy) {
+            for (int cx = cx0; cx <= cx1; ++cx) {
+                int cell = cy * POSTPROCESS_GRID + cx;
+                pp->cell_boxes[(size_t)cell * max_detections + pp->cell_count[cell]++] = kept;
+            }
+        }
+        kept++;
+    }
+    return kept;
+}
+
+// ---------------------------------------------------------------------------
+// Reference: decode all, sort all, O(n^2) NMS
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    postprocess_detection_t box;
+    int index;
+} postprocess_reference_box_t;
+
+static int postprocess_compare_reference(const void* a, const void* b) {
+    const postprocess_reference_box_t* x = a;
+    const postprocess_reference_box_t* y = b;
+    if (x->box.score != y->box.score) {
+        return x->box.score < y->box.score ? 1 : -1;
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int postprocess_reference_decode(const postprocess_t* pp, const float* output,
+                                        postprocess_reference_box_t* boxes) {
+    int count = 0;
+    int classes = pp->classes;
+    float threshold = pp->config.conf_threshold;
+
+    for (int i = 0; i < pp->candidates; ++i) {
+        int best = 0;
+        float score;
+        if (pp->layout == POSTPROCESS_LAYOUT_YOLOV8) {
+            size_t stride = (size_t)pp->candidates;
+            const float* scores = output + 4 * stride + i;
+            for (int c = 1; c < classes; ++c) {
+                if (scores[c * stride] > scores[best * stride]) {
+                    best = c;
+                }
+            }
+            score = scores[best * stride];
+        } else {
+            const float* row = output + (size_t)i * ((size_t)classes + 5);
+            if (!(row[4] >= threshold)) {
+                continue;
+            }
+            for (int c = 1; c < classes; ++c) {
+                if (row[5 + c] > row[5 + best]) {
+                    best = c;
+                }
+            }
+            score = row[4] * row[5 + best];
+        }
+        if (score >= threshold) {
+            postprocess_decode_box(pp, output, i, score, best, &boxes[count].box);
+            boxes[count].index = i;
+            count++;
+        }
+    }
+    return count;
+}
+
+int postprocess_run_reference(const postprocess_t* pp, const float* output,
+                              postprocess_detection_t* detections, int capacity) {
+    postprocess_reference_box_t* boxes = malloc((size_t)pp->candidates * sizeof(*boxes));
+    bool* removed = calloc((size_t)pp->candidates, sizeof(bool));
+    if (!boxes || !removed) {
+        free(boxes);
+        free(removed);
+        return -1;
+    }
+
+    int count = postprocess_reference_decode(pp, output, boxes);
+    qsort(boxes, (size_t)count, sizeof(*boxes), postprocess_compare_reference);
+    int top_k = postprocess_top_k(pp);
+    if (count > top_k) {
+        count = top_k;
+    }
+
+    int limit = capacity < pp->config.max_detections ? capacity : pp->config.max_detections;
+    int kept = 0;
+    for (int i = 0; i < count && kept < limit; ++i) {
+        if (removed[i]) {
+            continue;
+        }
+        detections[kept++] = boxes[i].box;
+        for (int j = i + 1; j < count; ++j) {
+            if (!removed[j] && postprocess_suppresses(&pp->config, &boxes[i].box, &boxes[j].box)) {
+                removed[j] = true;
+            }
+        }
+    }
+
+    free(boxes);
+    free(removed);
+    return kept;
+}
@@ -0,0 +1,79 @@
+#include "postprocess/postprocess.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <stddef.h>
+#include <arm_neon.h>
+
+// One candidate per lane, as in the x86 kernels: vcgtq picks lanes whose
+// score is strictly greater and vbslq moves both the max and its class, so
+// ties keep the first class like the scalar kernel. vmaxq_f32 is only used
+// for the YOLOv5 row max, where the order of a max does not matter.
+
+int postprocess_filter_neon(const float* scores, size_t stride, int classes, int count,
+                            float threshold, int32_t* index, float* score, int32_t* class_id) {
+    const float32x4_t v_threshold = vdupq_n_f32(threshold);
+    int hits = 0;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t best = vld1q_f32(scores + i);
+        uint32x4_t best_class = vdupq_n_u32(0);
+        for (int c = 1; c < classes; ++c) {
+            float32x4_t value = vld1q_f32(scores + (size_t)c * stride + i);
+            uint32x4_t greater = vcgtq_f32(value, best);
+            best = vbslq_f32(greater, value, best);
+            best_class = vbslq_u32(greater, vdupq_n_u32((uint32_t)c), best_class);
+        }
+
+        // Most groups have no hit; test all four lanes at once
+        uint32x4_t pass = vcgeq_f32(best, v_threshold);
+        uint32x2_t any = vorr_u32(vget_low_u32(pass), vget_high_u32(pass));
+        if (vget_lane_u64(vreinterpret_u64_u32(any), 0) == 0) {
+            continue;
+        }
+
+        float lanes[4];
+        uint32_t lane_class[4];
+        uint32_t lane_pass[4];
+        vst1q_f32(lanes, best);
+        vst1q_u32(lane_class, best_class);
+        vst1q_u32(lane_pass, pass);
+        for (int lane = 0; lane < 4; ++lane) {
+            if (lane_pass[lane]) {
+                index[hits] = i + lane;
+                score[hits] = lanes[lane];
+                class_id[hits] = (int32_t)lane_class[lane];
+                hits++;
+            }
+        }
+    }
+
+    int tail = postprocess_filter_scalar(scores + i, stride, classes, count - i, threshold,
+                                         index + hits, score + hits, class_id + hits);
+    for (int n = hits; n < hits + tail; ++n) {
+        index[n] += i;
+    }
+    return hits + tail;
+}
+
+float postprocess_row_max_neon(const float* row, int count) {
+    if (count < 4) {
+        return postprocess_row_max_scalar(row, count);
+    }
+
+    float32x4_t best = vld1q_f32(row);
+    int i = 4;
+    for (; i + 4 <= count; i += 4) {
+        best = vmaxq_f32(best, vld1q_f32(row + i));
+    }
+    float32x2_t half = vpmax_f32(vget_low_f32(best), vget_high_f32(best));
+    half = vpmax_f32(half, half);
+    float result = vget_lane_f32(half, 0);
+    for (; i < count; ++i) {
+        result = row[i] > result ? row[i] : result;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "postprocess/postprocess.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <stddef.h>
+#include <immintrin.h>
+
+// The planar filter keeps one candidate per lane and walks the class rows,
+// so the running max and its class stay in registers. A lane only moves to
+// a new class when the score is strictly greater, which is the scalar
+// kernel's first-best rule, so both pick the same class and score.
+
+// ---------------------------------------------------------------------------
+// SSE2
+// ---------------------------------------------------------------------------
+
+// Append the lanes set in mask (bit n = lane n) starting at candidate base
+static inline int append_hits(int mask, int base, const float* best, const int32_t* best_class,
+                              int32_t* index, float* score, int32_t* class_id, int hits) {
+    while (mask) {
+        int lane = __builtin_ctz((unsigned)mask);
+        mask &= mask - 1;
+        index[hits] = base + lane;
+        score[hits] = best[lane];
+        class_id[hits] = best_class[lane];
+        hits++;
+    }
+    return hits;
+}
+
+int postprocess_filter_sse2(const float* scores, size_t stride, int classes, int count,
+                            float threshold, int32_t* index, float* score, int32_t* class_id) {
+    const __m128 v_threshold = _mm_set1_ps(threshold);
+    int hits = 0;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 best = _mm_loadu_ps(scores + i);
+        __m128i best_class = _mm_setzero_si128();
+        for (int c = 1; c < classes; ++c) {
+            __m128 value = _mm_loadu_ps(scores + (size_t)c * stride + i);
+            __m128 greater = _mm_cmpgt_ps(value, best);
+            best = _mm_or_ps(_mm_and_ps(greater, value), _mm_andnot_ps(greater, best));
+            __m128i take = _mm_castps_si128(greater);
+            best_class = _mm_or_si128(_mm_and_si128(take, _mm_set1_epi32(c)),
+                                      _mm_andnot_si128(take, best_class));
+        }
+
+        int mask = _mm_movemask_ps(_mm_cmpge_ps(best, v_threshold));
+        if (mask) {
+            float lanes[4];
+            int32_t lane_class[4];
+            _mm_storeu_ps(lanes, best);
+            _mm_storeu_si128((__m128i*)lane_class, best_class);
+            hits = append_hits(mask, i, lanes, lane_class, index, score, class_id, hits);
+        }
+    }
+
+    int tail = postprocess_filter_scalar(scores + i, stride, classes, count - i, threshold,
+                                         index + hits, score + hits, class_id + hits);
+    for (int n = hits; n < hits + tail; ++n) {
+        index[n] += i;
+    }
+    return hits + tail;
+}
+
+float postprocess_row_max_sse2(const float* row, int count) {
+    if (count < 4) {
+        return postprocess_row_max_scalar(row, count);
+    }
+
+    __m128 best = _mm_loadu_ps(row);
+    int i = 4;
+    for (; i + 4 <= count; i += 4) {
+        best = _mm_max_ps(best, _mm_loadu_ps(row + i));
+    }
+    best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+    best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+    float result = _mm_cvtss_f32(best);
+    for (; i < count; ++i) {
+        result = row[i] > result ? row[i] : result;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET int postprocess_filter_avx2(const float* scores, size_t stride, int classes,
+                                        int count, float threshold, int32_t* index, float* score,
+                                        int32_t* class_id) {
+    const __m256 v_threshold = _mm256_set1_ps(threshold);
+    int hits = 0;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 best = _mm256_loadu_ps(scores + i);
+        __m256i best_class = _mm256_setzero_si256();
+        for (int c = 1; c < classes; ++c) {
+            __m256 value = _mm256_loadu_ps(scores + (size_t)c * stride + i);
+            __m256 greater = _mm256_cmp_ps(value, best, _CMP_GT_OQ);
+            best = _mm256_blendv_ps(best, value, greater);
+            best_class = _mm256_blendv_epi8(best_class, _mm256_set1_epi32(c),
+                                            _mm256_castps_si256(greater));
+        }
+
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(best, v_threshold, _CMP_GE_OQ));
+        if (mask) {
+            float lanes[8];
+            int32_t lane_class[8];
+            _mm256_storeu_ps(lanes, best);
+            _mm256_storeu_si256((__m256i*)lane_class, best_class);
+            hits = append_hits(mask, i, lanes, lane_class, index, score, class_id, hits);
+        }
+    }
+
+    int tail = postprocess_filter_sse2(scores + i, stride, classes, count - i, threshold,
+                                       index + hits, score + hits, class_id + hits);
+    for (int n = hits; n < hits + tail; ++n) {
+        index[n] += i;
+    }
+    return hits + tail;
+}
+
+AVX2_TARGET float postprocess_row_max_avx2(const float* row, int count) {
+    if (count < 8) {
+        return postprocess_row_max_sse2(row, count);
+    }
+
+    __m256 best = _mm256_loadu_ps(row);
+    int i = 8;
+    for (; i + 8 <= count; i += 8) {
+        best = _mm256_max_ps(best, _mm256_loadu_ps(row + i));
+    }
+    __m128 half = _mm_max_ps(_mm256_castps256_ps128(best), _mm256_extractf128_ps(best, 1));
+    half = _mm_max_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_max_ps(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(2, 3, 0, 1)));
+    float result = _mm_cvtss_f32(half);
+    for (; i < count; ++i) {
+        result = row[i] > result ? row[i] : result;
+    }
+    return result;
+}
+
+#endif
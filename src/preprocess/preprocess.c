@@ -0,0 +1,501 @@
+#include "preprocess/preprocess.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+// Bilinear weights are 7 bit, so a horizontally resized sample is at most
+// 255 * 128 = 32640 (fits int16) and the vertical blend of two of them at
+// most 255 * 128 * 128 (fits int32). (sum + 8192) >> 14 rounds back to 8 bit.
+#define PREPROCESS_WEIGHT_BITS 7
+#define PREPROCESS_WEIGHT_ONE (1 << PREPROCESS_WEIGHT_BITS)
+#define PREPROCESS_BLEND_SHIFT (2 * PREPROCESS_WEIGHT_BITS)
+#define PREPROCESS_BLEND_ROUND (1 << (PREPROCESS_BLEND_SHIFT - 1))
+
+#define PREPROCESS_MAX_SIZE 8192
+
+static inline int preprocess_blend(int h0, int h1, int wy) {
+    return (h0 * (PREPROCESS_WEIGHT_ONE - wy) + h1 * wy + PREPROCESS_BLEND_ROUND) >>
+           PREPROCESS_BLEND_SHIFT;
+}
+
+static inline int8_t preprocess_quantize(float value) {
+    long q = lrintf(value);
+    return (int8_t)(q < -128 ? -128 : (q > 127 ? 127 : q));
+}
+
+void preprocess_vblend_f32_scalar(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                  float scale, float bias, float* dst) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = (float)preprocess_blend(h0[i], h1[i], wy) * scale + bias;
+    }
+}
+
+void preprocess_vblend_s8_scalar(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                 float scale, float bias, int8_t* dst) {
+    for (int i = 0; i < count; ++i) {
+        dst[i] = preprocess_quantize((float)preprocess_blend(h0[i], h1[i], wy) * scale + bias);
+    }
+}
+
+preprocess_vblend_f32_fn preprocess_get_vblend_f32(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return preprocess_vblend_f32_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        case COLOR_CONVERT_ISA_SSE2:
+            return preprocess_vblend_f32_sse2;
+        case COLOR_CONVERT_ISA_AVX2:
+            return preprocess_vblend_f32_avx2;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+            return preprocess_vblend_f32_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+preprocess_vblend_s8_fn preprocess_get_vblend_s8(color_convert_isa_t isa) {
+    switch (isa) {
+        case COLOR_CONVERT_ISA_SCALAR:
+            return preprocess_vblend_s8_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+        case COLOR_CONVERT_ISA_SSE2:
+            return preprocess_vblend_s8_sse2;
+        case COLOR_CONVERT_ISA_AVX2:
+            return preprocess_vblend_s8_avx2;
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case COLOR_CONVERT_ISA_NEON:
+            return preprocess_vblend_s8_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+void preprocess_config_default(preprocess_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->width = 640;
+    config->height = 640;
+    config->dtype = PREPROCESS_FLOAT32;
+    for (int c = 0; c < 3; ++c) {
+        config->mean[c] = 0.0f;
+        config->std[c] = 255.0f;
+    }
+    config->int8_scale = 1.0f / 255.0f;
+    config->int8_zero_point = -128;
+    config->pad_value = 114;
+    config->bgr = false;
+}
+
+static int preprocess_check_config(const preprocess_config_t* config) {
+    if (config->width < 1 || config->width > PREPROCESS_MAX_SIZE ||
+        config->height < 1 || config->height > PREPROCESS_MAX_SIZE) {
+        RCUTILS_LOG_ERROR("Invalid tensor size %dx%d", config->width, config->height);
+        return -1;
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (!(config->std[c] != 0.0f)) {
+            RCUTILS_LOG_ERROR("Invalid std for channel %d", c);
+            return -1;
+        }
+    }
+    if (config->dtype == PREPROCESS_INT8 && !(config->int8_scale > 0.0f)) {
+        RCUTILS_LOG_ERROR("Invalid int8 scale");
+        return -1;
+    }
+    return 0;
+}
+
+size_t preprocess_tensor_size(const preprocess_config_t* config) {
+    size_t element = config->dtype == PREPROCESS_INT8 ? sizeof(int8_t) : sizeof(float);
+    return 3 * (size_t)config->width * (size_t)config->height * element;
+}
+
+void preprocess_compute_letterbox(const preprocess_config_t* config, int src_width, int src_height,
+                                  preprocess_letterbox_t* letterbox) {
+    double scale_x = (double)config->width / src_width;
+    double scale_y = (double)config->height / src_height;
+    double scale = scale_x < scale_y ? scale_x : scale_y;
+
+    int resized_width = (int)lround(src_width * scale);
+    int resized_height = (int)lround(src_height * scale);
+    if (resized_width < 1) {
+        resized_width = 1;
+    }
+    if (resized_width > config->width) {
+        resized_width = config->width;
+    }
+    if (resized_height < 1) {
+        resized_height = 1;
+    }
+    if (resized_height > config->height) {
+        resized_height = config->height;
+    }
+
+    letterbox->scale = (float)scale;
+    letterbox->resized_width = resized_width;
+    letterbox->resized_height = resized_height;
+    letterbox->pad_x = (config->width - resized_width) / 2;
+    letterbox->pad_y = (config->height - resized_height) / 2;
+}
+
+void preprocess_to_source(const preprocess_letterbox_t* letterbox, float x, float y,
+                          float* src_x, float* src_y) {
+    *src_x = (x - (float)letterbox->pad_x) / letterbox->scale;
+    *src_y = (y - (float)letterbox->pad_y) / letterbox->scale;
+}
+
+// Left/top source index and right/bottom weight for each resized position,
+// sampling at half-pixel centers. The index is clamped to size - 2 so that
+// index + 1 is always a valid neighbor.
+static void preprocess_build_axis(int src_size, int dst_size, int32_t* index, int16_t* weight) {
+    double ratio = (double)src_size / dst_size;
+    for (int i = 0; i < dst_size; ++i) {
+        double s = (i + 0.5) * ratio - 0.5;
+        if (s < 0.0) {
+            s = 0.0;
+        }
+        int i0 = (int)s;
+        if (i0 > src_size - 2) {
+            i0 = src_size - 2;
+        }
+        double frac = s - i0;
+        if (frac > 1.0) {
+            frac = 1.0;
+        }
+        index[i] = i0;
+        weight[i] = (int16_t)lround(frac * PREPROCESS_WEIGHT_ONE);
+    }
+}
+
+// Per-channel v * scale + bias equivalent of the configured normalization
+static void preprocess_fold_normalization(const preprocess_config_t* config,
+                                          float scale[3], float bias[3]) {
+    for (int c = 0; c < 3; ++c) {
+        float inv = 1.0f / config->std[c];
+        if (config->dtype == PREPROCESS_INT8) {
+            inv /= config->int8_scale;
+        }
+        scale[c] = inv;
+        bias[c] = -config->mean[c] * inv;
+        if (config->dtype == PREPROCESS_INT8) {
+            bias[c] += (float)config->int8_zero_point;
+        }
+    }
+}
+
+// Tensor plane for source channel c (R, G, B)
+static inline int preprocess_plane(const preprocess_config_t* config, int c) {
+    return config->bgr ? 2 - c : c;
+}
+
+// Horizontal resize of one RGB24 row into three int16 planes
+static void preprocess_hresize_row(const uint8_t* rgb, const int32_t* x_index,
+                                   const int16_t* x_weight, int count, int16_t* dst) {
+    int16_t* dst_r = dst;
+    int16_t* dst_g = dst + count;
+    int16_t* dst_b = dst + 2 * count;
+    for (int i = 0; i < count; ++i) {
+        const uint8_t* p = rgb + (size_t)x_index[i] * 3;
+        int w1 = x_weight[i];
+        int w0 = PREPROCESS_WEIGHT_ONE - w1;
+        dst_r[i] = (int16_t)(p[0] * w0 + p[3] * w1);
+        dst_g[i] = (int16_t)(p[1] * w0 + p[4] * w1);
+        dst_b[i] = (int16_t)(p[2] * w0 + p[5] * w1);
+    }
+}
+
+// Normalized letterbox fill
+static void preprocess_fill(const preprocess_config_t* config, const float scale[3],
+                            const float bias[3], int c, void* plane, size_t offset, size_t count) {
+    float value = (float)config->pad_value * scale[c] + bias[c];
+    if (config->dtype == PREPROCESS_INT8) {
+        memset((int8_t*)plane + offset, preprocess_quantize(value), count);
+        return;
+    }
+    float* p = (float*)plane + offset;
+    for (size_t i = 0; i < count; ++i) {
+        p[i] = value;
+    }
+}
+
+// Fill everything outside the resized rectangle
+static void preprocess_fill_borders(const preprocess_config_t* config,
+                                    const preprocess_letterbox_t* lb,
+                                    const float scale[3], const float bias[3], void* dst) {
+    size_t width = (size_t)config->width;
+    size_t plane_size = width * (size_t)config->height;
+    size_t element = config->dtype == PREPROCESS_INT8 ? 1 : sizeof(float);
+    int right = config->width - lb->pad_x - lb->resized_width;
+    int bottom_row = lb->pad_y + lb->resized_height;
+
+    for (int c = 0; c < 3; ++c) {
+        void* plane = (uint8_t*)dst + (size_t)preprocess_plane(config, c) * plane_size * element;
+
+        preprocess_fill(config, scale, bias, c, plane, 0, (size_t)lb->pad_y * width);
+        preprocess_fill(config, scale, bias, c, plane, (size_t)bottom_row * width,
+                        (size_t)(config->height - bottom_row) * width);
+        if (lb->pad_x == 0 && right == 0) {
+            continue;
+        }
+        for (int y = lb->pad_y; y < bottom_row; ++y) {
+            size_t row = (size_t)y * width;
+            preprocess_fill(config, scale, bias, c, plane, row, (size_t)lb->pad_x);
+            preprocess_fill(config, scale, bias, c, plane,
+                            row + (size_t)(lb->pad_x + lb->resized_width), (size_t)right);
+        }
+    }
+}
+
+int preprocess_init(preprocess_t* pp, const preprocess_config_t* config) {
+    memset(pp, 0, sizeof(*pp));
+    if (preprocess_check_config(config) != 0) {
+        return -1;
+    }
+    pp->config = *config;
+
+    size_t width = (size_t)config->width;
+    size_t height = (size_t)config->height;
+    pp->x_index = malloc(width * sizeof(int32_t));
+    pp->x_weight = malloc(width * sizeof(int16_t));
+    pp->y_index = malloc(height * sizeof(int32_t));
+    pp->y_weight = malloc(height * sizeof(int16_t));
+    pp->cache[0] = malloc(3 * width * sizeof(int16_t));
+    pp->cache[1] = malloc(3 * width * sizeof(int16_t));
+    if (!pp->x_index || !pp->x_weight || !pp->y_index || !pp->y_weight ||
+        !pp->cache[0] || !pp->cache[1]) {
+        RCUTILS_LOG_ERROR("Out of memory");
+        preprocess_fini(pp);
+        return -1;
+    }
+
+    preprocess_fold_normalization(config, pp->scale, pp->bias);
+
+    // Follow the color_convert kernel selection so one environment
+    // override (COLOR_CONVERT_ISA) controls both
+    pp->isa = color_convert_active_isa();
+    pp->vblend_f32 = preprocess_get_vblend_f32(pp->isa);
+    pp->vblend_s8 = preprocess_get_vblend_s8(pp->isa);
+    if (!pp->vblend_f32 || !pp->vblend_s8) {
+        pp->vblend_f32 = preprocess_vblend_f32_scalar;
+        pp->vblend_s8 = preprocess_vblend_s8_scalar;
+    }
+    return 0;
+}
+
+void preprocess_fini(preprocess_t* pp) {
+    free(pp->x_index);
+    free(pp->x_weight);
+    free(pp->y_index);
+    free(pp->y_weight);
+    free(pp->rgb_row);
+    free(pp->cache[0]);
+    free(pp->cache[1]);
+    memset(pp, 0, sizeof(*pp));
+}
+
+// Rebuild the tables when the source size changes
+static int preprocess_prepare(preprocess_t* pp, int src_width, int src_height) {
+    if (pp->src_width == src_width && pp->src_height == src_height) {
+        return 0;
+    }
+
+    if (src_width > pp->src_width) {
+        uint8_t* rgb_row = realloc(pp->rgb_row, (size_t)src_width * 3);
+        if (!rgb_row) {
+            RCUTILS_LOG_ERROR("Out of memory");
+            return -1;
+        }
+        pp->rgb_row = rgb_row;
+    }
+
+    preprocess_compute_letterbox(&pp->config, src_width, src_height, &pp->letterbox);
+    preprocess_build_axis(src_width, pp->letterbox.resized_width, pp->x_index, pp->x_weight);
+    preprocess_build_axis(src_height, pp->letterbox.resized_height, pp->y_index, pp->y_weight);
+    pp->src_width = src_width;
+    pp->src_height = src_height;
+    return 0;
+}
+
+// Cache slot holding the horizontally resized source row y; `keep` is the
+// slot that must not be evicted (or -1)
+static int preprocess_fetch_row(preprocess_t* pp, const uint8_t* src, int src_stride,
+                                int y, int keep) {
+    if (pp->cache_row[0] == y) {
+        return 0;
+    }
+    if (pp->cache_row[1] == y) {
+        return 1;
+    }
+
+    int slot = keep == 0 ? 1 : 0;
+    yuyv_to_rgb24_strided(src + (size_t)y * src_stride, src_stride, pp->rgb_row, 0,
+                          pp->src_width, 1);
+    preprocess_hresize_row(pp->rgb_row, pp->x_index, pp->x_weight,
+                           pp->letterbox.resized_width, pp->cache[slot]);
+    pp->cache_row[slot] = y;
+    return slot;
+}
+
+int preprocess_yuyv(preprocess_t* pp, const uint8_t* src, int src_stride,
+                    int src_width, int src_height, void* dst) {
+    if (!src || !dst || src_width < 2 || src_height < 2 || src_stride < src_width * 2) {
+        return -1;
+    }
+    if (preprocess_prepare(pp, src_width, src_height) != 0) {
+        return -1;
+    }
+
+    const preprocess_config_t* config = &pp->config;
+    const preprocess_letterbox_t* lb = &pp->letterbox;
+    size_t plane_size = (size_t)config->width * (size_t)config->height;
+    int count = lb->resized_width;
+
+    preprocess_fill_borders(config, lb, pp->scale, pp->bias, dst);
+
+    // The cache only lives for one frame
+    pp->cache_row[0] = -1;
+    pp->cache_row[1] = -1;
+
+    for (int j = 0; j < lb->resized_height; ++j) {
+        int y0 = pp->y_index[j];
+        int wy = pp->y_weight[j];
+        int s0 = preprocess_fetch_row(pp, src, src_stride, y0, -1);
+        int s1 = wy ? preprocess_fetch_row(pp, src, src_stride, y0 + 1, s0) : s0;
+        size_t offset = (size_t)(lb->pad_y + j) * (size_t)config->width + (size_t)lb->pad_x;
+
+        for (int c = 0; c < 3; ++c) {
+            const int16_t* h0 = pp->cache[s0] + (size_t)c * count;
+            const int16_t* h1 = pp->cache[s1] + (size_t)c * count;
+            size_t plane = (size_t)preprocess_plane(config, c) * plane_size;
+            if (config->dtype == PREPROCESS_INT8) {
+                pp->vblend_s8(h0, h1, wy, count, pp->scale[c], pp->bias[c],
+                              (int8_t*)dst + plane + offset);
+            } else {
+                pp->vblend_f32(h0, h1, wy, count, pp->scale[c], pp->bias[c],
+                               (float*)dst + plane + offset);
+            }
+        }
+    }
+    return 0;
+}
+
+// Scratch buffers of the multi-pass reference
+typedef struct {
+    uint8_t* rgb;               // src_width x src_height RGB24
+    int16_t* hresized;          // resized_width x src_height, horizontal pass
+    uint8_t* resized;           // resized_width x resized_height RGB24
+    uint8_t* canvas;            // width x height RGB24 letterboxed
+    int32_t* x_index;
+    int16_t* x_weight;
+    int32_t* y_index;
+    int16_t* y_weight;
+} preprocess_reference_buffers_t;
+
+static void preprocess_reference_passes(const preprocess_config_t* config,
+                                        const preprocess_letterbox_t* lb,
+                                        const preprocess_reference_buffers_t* b,
+                                        const uint8_t* src, int src_stride,
+                                        int src_width, int src_height, void* dst) {
+    int rw = lb->resized_width;
+    int rh = lb->resized_height;
+    size_t width = (size_t)config->width;
+    size_t height = (size_t)config->height;
+
+    // 1. YUYV -> RGB24
+    yuyv_to_rgb24_strided(src, src_stride, b->rgb, src_width * 3, src_width, src_height);
+
+    // 2. Bilinear resize, horizontal then vertical
+    preprocess_build_axis(src_width, rw, b->x_index, b->x_weight);
+    preprocess_build_axis(src_height, rh, b->y_index, b->y_weight);
+    for (int y = 0; y < src_height; ++y) {
+        const uint8_t* row = b->rgb + (size_t)y * src_width * 3;
+        int16_t* out = b->hresized + (size_t)y * rw * 3;
+        for (int x = 0; x < rw; ++x) {
+            const uint8_t* p = row + (size_t)b->x_index[x] * 3;
+            int w1 = b->x_weight[x];
+            int w0 = PREPROCESS_WEIGHT_ONE - w1;
+            for (int c = 0; c < 3; ++c) {
+                out[x * 3 + c] = (int16_t)(p[c] * w0 + p[c + 3] * w1);
+            }
+        }
+    }
+    for (int y = 0; y < rh; ++y) {
+        const int16_t* top = b->hresized + (size_t)b->y_index[y] * rw * 3;
+        const int16_t* bottom = top + (size_t)rw * 3;
+        uint8_t* out = b->resized + (size_t)y * rw * 3;
+        for (int i = 0; i < rw * 3; ++i) {
+            out[i] = (uint8_t)preprocess_blend(top[i], bottom[i], b->y_weight[y]);
+        }
+    }
+
+    // 3. Letterbox onto a padded canvas
+    memset(b->canvas, config->pad_value, width * height * 3);
+    for (int y = 0; y < rh; ++y) {
+        memcpy(b->canvas + ((size_t)(lb->pad_y + y) * width + (size_t)lb->pad_x) * 3,
+               b->resized + (size_t)y * rw * 3, (size_t)rw * 3);
+    }
+
+    // 4. Normalize and transpose HWC -> CHW
+    float scale[3];
+    float bias[3];
+    preprocess_fold_normalization(config, scale, bias);
+    size_t plane_size = width * height;
+    for (int c = 0; c < 3; ++c) {
+        size_t plane = (size_t)preprocess_plane(config, c) * plane_size;
+        for (size_t i = 0; i < plane_size; ++i) {
+            float value = (float)b->canvas[i * 3 + c] * scale[c] + bias[c];
+            if (config->dtype == PREPROCESS_INT8) {
+                ((int8_t*)dst)[plane + i] = preprocess_quantize(value);
+            } else {
+                ((float*)dst)[plane + i] = value;
+            }
+        }
+    }
+}
+
+int preprocess_yuyv_reference(const preprocess_config_t* config, const uint8_t* src, int src_stride,
+                              int src_width, int src_height, void* dst) {
+    if (!src || !dst || src_width < 2 || src_height < 2 || src_stride < src_width * 2 ||
+        preprocess_check_config(config) != 0) {
+        return -1;
+    }
+
+    preprocess_letterbox_t lb;
+    preprocess_compute_letterbox(config, src_width, src_height, &lb);
+    size_t rw = (size_t)lb.resized_width;
+    size_t rh = (size_t)lb.resized_height;
+
+    preprocess_reference_buffers_t b;
+    b.rgb = malloc((size_t)src_width * src_height * 3);
+    b.hresized = malloc(rw * src_height * 3 * sizeof(int16_t));
+    b.resized = malloc(rw * rh * 3);
+    b.canvas = malloc((size_t)config->width * config->height * 3);
+    b.x_index = malloc(rw * sizeof(int32_t));
+    b.x_weight = malloc(rw * sizeof(int16_t));
+    b.y_index = malloc(rh * sizeof(int32_t));
+    b.y_weight = malloc(rh * sizeof(int16_t));
+
+    int result = -1;
+    if (b.rgb && b.hresized && b.resized && b.canvas &&
+        b.x_index && b.x_weight && b.y_index && b.y_weight) {
+        preprocess_reference_passes(config, &lb, &b, src, src_stride, src_width, src_height, dst);
+        result = 0;
+    } else {
+        RCUTILS_LOG_ERROR("Out of memory");
+    }
+
+    free(b.rgb);
+    free(b.hresized);
+    free(b.resized);
+    free(b.canvas);
+    free(b.x_index);
+    free(b.x_weight);
+    free(b.y_index);
+    free(b.y_weight);
+    return result;
+}
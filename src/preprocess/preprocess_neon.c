@@ -0,0 +1,65 @@
+#include "preprocess/preprocess.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <stddef.h>
+#include <arm_neon.h>
+
+// Same fixed-point blend as the scalar kernel: vmull/vmlal accumulate
+// h0 * (128 - wy) + h1 * wy in 32-bit lanes and vrshrq_n_s32 adds the 8192
+// rounding term before the shift. Normalization is a separate mul + add.
+
+// Eight blended samples -> two float vectors
+static inline void neon_blend8(const int16_t* h0, const int16_t* h1, int16_t w0, int16_t w1,
+                               float32x4_t scale, float32x4_t bias,
+                               float32x4_t* lo, float32x4_t* hi) {
+    int16x8_t a = vld1q_s16(h0);
+    int16x8_t b = vld1q_s16(h1);
+    int32x4_t sum_lo = vmlal_n_s16(vmull_n_s16(vget_low_s16(a), w0), vget_low_s16(b), w1);
+    int32x4_t sum_hi = vmlal_n_s16(vmull_n_s16(vget_high_s16(a), w0), vget_high_s16(b), w1);
+    sum_lo = vrshrq_n_s32(sum_lo, 14);
+    sum_hi = vrshrq_n_s32(sum_hi, 14);
+
+    *lo = vaddq_f32(vmulq_f32(vcvtq_f32_s32(sum_lo), scale), bias);
+    *hi = vaddq_f32(vmulq_f32(vcvtq_f32_s32(sum_hi), scale), bias);
+}
+
+void preprocess_vblend_f32_neon(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                float scale, float bias, float* dst) {
+    const float32x4_t v_scale = vdupq_n_f32(scale);
+    const float32x4_t v_bias = vdupq_n_f32(bias);
+    const int16_t w0 = (int16_t)(128 - wy);
+    const int16_t w1 = (int16_t)wy;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t lo, hi;
+        neon_blend8(h0 + i, h1 + i, w0, w1, v_scale, v_bias, &lo, &hi);
+        vst1q_f32(dst + i, lo);
+        vst1q_f32(dst + i + 4, hi);
+    }
+    preprocess_vblend_f32_scalar(h0 + i, h1 + i, wy, count - i, scale, bias, dst + i);
+}
+
+void preprocess_vblend_s8_neon(const int16_t* h0, const int16_t* h1, int wy, int count,
+                               float scale, float bias, int8_t* dst) {
+    int i = 0;
+#if defined(__aarch64__)
+    // vcvtnq (round to nearest even) only exists on AArch64; 32-bit NEON
+    // would truncate, so it keeps the scalar loop
+    const float32x4_t v_scale = vdupq_n_f32(scale);
+    const float32x4_t v_bias = vdupq_n_f32(bias);
+    const int16_t w0 = (int16_t)(128 - wy);
+    const int16_t w1 = (int16_t)wy;
+
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t lo, hi;
+        neon_blend8(h0 + i, h1 + i, w0, w1, v_scale, v_bias, &lo, &hi);
+        int16x8_t q = vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)), vqmovn_s32(vcvtnq_s32_f32(hi)));
+        vst1_s8(dst + i, vqmovn_s16(q));
+    }
+#endif
+    preprocess_vblend_s8_scalar(h0 + i, h1 + i, wy, count - i, scale, bias, dst + i);
+}
+
+#endif
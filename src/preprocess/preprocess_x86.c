@@ -0,0 +1,136 @@
+#include "preprocess/preprocess.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <stddef.h>
+#include <immintrin.h>
+
+// Vertical blend: interleaving the two cached rows and multiplying with
+// (128 - wy, wy) pairs in pmaddwd gives h0 * (128 - wy) + h1 * wy per
+// 32-bit lane, the same sum as the scalar kernel. Normalization is a
+// separate mul + add (no FMA), so results match the scalar code exactly.
+// int8 rounding uses cvtps2dq (round to nearest even, like lrintf) and the
+// packssdw + packsswb saturation performs the [-128, 127] clamp.
+
+#define BLEND_ROUND 8192
+#define BLEND_SHIFT 14
+
+// 16-bit pair (lo, hi) replicated across a vector, as pmaddwd coefficients
+#define WEIGHT_PAIR(wy) ((int)(((uint32_t)(uint16_t)(wy) << 16) | (uint16_t)(128 - (wy))))
+
+// ---------------------------------------------------------------------------
+// SSE2
+// ---------------------------------------------------------------------------
+
+// Eight blended samples -> two float vectors
+static inline void sse2_blend8(const int16_t* h0, const int16_t* h1, __m128i weights,
+                               __m128 scale, __m128 bias, __m128* lo, __m128* hi) {
+    const __m128i round = _mm_set1_epi32(BLEND_ROUND);
+
+    __m128i a = _mm_loadu_si128((const __m128i*)h0);
+    __m128i b = _mm_loadu_si128((const __m128i*)h1);
+    __m128i sum_lo = _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights);
+    __m128i sum_hi = _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights);
+    sum_lo = _mm_srai_epi32(_mm_add_epi32(sum_lo, round), BLEND_SHIFT);
+    sum_hi = _mm_srai_epi32(_mm_add_epi32(sum_hi, round), BLEND_SHIFT);
+
+    *lo = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum_lo), scale), bias);
+    *hi = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum_hi), scale), bias);
+}
+
+void preprocess_vblend_f32_sse2(const int16_t* h0, const int16_t* h1, int wy, int count,
+                                float scale, float bias, float* dst) {
+    const __m128i weights = _mm_set1_epi32(WEIGHT_PAIR(wy));
+    const __m128 v_scale = _mm_set1_ps(scale);
+    const __m128 v_bias = _mm_set1_ps(bias);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 lo, hi;
+        sse2_blend8(h0 + i, h1 + i, weights, v_scale, v_bias, &lo, &hi);
+        _mm_storeu_ps(dst + i, lo);
+        _mm_storeu_ps(dst + i + 4, hi);
+    }
+    preprocess_vblend_f32_scalar(h0 + i, h1 + i, wy, count - i, scale, bias, dst + i);
+}
+
+void preprocess_vblend_s8_sse2(const int16_t* h0, const int16_t* h1, int wy, int count,
+                               float scale, float bias, int8_t* dst) {
+    const __m128i weights = _mm_set1_epi32(WEIGHT_PAIR(wy));
+    const __m128 v_scale = _mm_set1_ps(scale);
+    const __m128 v_bias = _mm_set1_ps(bias);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128 f0, f1, f2, f3;
+        sse2_blend8(h0 + i, h1 + i, weights, v_scale, v_bias, &f0, &f1);
+        sse2_blend8(h0 + i + 8, h1 + i + 8, weights, v_scale, v_bias, &f2, &f3);
+
+        __m128i lo = _mm_packs_epi32(_mm_cvtps_epi32(f0), _mm_cvtps_epi32(f1));
+        __m128i hi = _mm_packs_epi32(_mm_cvtps_epi32(f2), _mm_cvtps_epi32(f3));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi16(lo, hi));
+    }
+    preprocess_vblend_s8_scalar(h0 + i, h1 + i, wy, count - i, scale, bias, dst + i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2
+// ---------------------------------------------------------------------------
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+// Sixteen blended samples -> two float vectors. The in-lane unpack leaves
+// lo = [0-3 | 8-11] and hi = [4-7 | 12-15].
+static inline AVX2_TARGET void avx2_blend16(const int16_t* h0, const int16_t* h1,
+                                            __m256i weights, __m256 scale, __m256 bias,
+                                            __m256* lo, __m256* hi) {
+    const __m256i round = _mm256_set1_epi32(BLEND_ROUND);
+
+    __m256i a = _mm256_loadu_si256((const __m256i*)h0);
+    __m256i b = _mm256_loadu_si256((const __m256i*)h1);
+    __m256i sum_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), weights);
+    __m256i sum_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), weights);
+    sum_lo = _mm256_srai_epi32(_mm256_add_epi32(sum_lo, round), BLEND_SHIFT);
+    sum_hi = _mm256_srai_epi32(_mm256_add_epi32(sum_hi, round), BLEND_SHIFT);
+
+    *lo = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(sum_lo), scale), bias);
+    *hi = _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(sum_hi), scale), bias);
+}
+
+AVX2_TARGET void preprocess_vblend_f32_avx2(const int16_t* h0, const int16_t* h1, int wy,
+                                            int count, float scale, float bias, float* dst) {
+    const __m256i weights = _mm256_set1_epi32(WEIGHT_PAIR(wy));
+    const __m256 v_scale = _mm256_set1_ps(scale);
+    const __m256 v_bias = _mm256_set1_ps(bias);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 lo, hi;
+        avx2_blend16(h0 + i, h1 + i, weights, v_scale, v_bias, &lo, &hi);
+        _mm256_storeu_ps(dst + i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(dst + i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    preprocess_vblend_f32_sse2(h0 + i, h1 + i, wy, count - i, scale, bias, dst + i);
+}
+
+AVX2_TARGET void preprocess_vblend_s8_avx2(const int16_t* h0, const int16_t* h1, int wy,
+                                           int count, float scale, float bias, int8_t* dst) {
+    const __m256i weights = _mm256_set1_epi32(WEIGHT_PAIR(wy));
+    const __m256 v_scale = _mm256_set1_ps(scale);
+    const __m256 v_bias = _mm256_set1_ps(bias);
+
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 lo, hi;
+        avx2_blend16(h0 + i, h1 + i, weights, v_scale, v_bias, &lo, &hi);
+
+        // The in-lane pack puts [0-3 | 8-11] and [4-7 | 12-15] back in order
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(lo), _mm256_cvtps_epi32(hi));
+        __m128i bytes = _mm_packs_epi16(_mm256_castsi256_si128(packed),
+                                        _mm256_extracti128_si256(packed, 1));
+        _mm_storeu_si128((__m128i*)(dst + i), bytes);
+    }
+    preprocess_vblend_s8_scalar(h0 + i, h1 + i, wy, count - i, scale, bias, dst + i);
+}
+
+#endif
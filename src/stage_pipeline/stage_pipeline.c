@@ -0,0 +1,295 @@
+#include "stage_pipeline/stage_pipeline.h"
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <rcutils/logging_macros.h>
+
+static int64_t stage_pipeline_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void stage_pipeline_config_default(stage_pipeline_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->max_in_flight = 3;
+    config->queue_depth = 1;
+    config->policy = STAGE_PIPELINE_DROP_OLDEST;
+    config->max_age_ns = 0;
+}
+
+int stage_pipeline_parse_policy(const char* name, stage_pipeline_policy_t* policy) {
+    if (strcasecmp(name, "oldest") == 0) {
+        *policy = STAGE_PIPELINE_DROP_OLDEST;
+        return 0;
+    }
+    if (strcasecmp(name, "newest") == 0) {
+        *policy = STAGE_PIPELINE_DROP_NEWEST;
+        return 0;
+    }
+    return -1;
+}
+
+const char* stage_pipeline_policy_name(stage_pipeline_policy_t policy) {
+    return policy == STAGE_PIPELINE_DROP_NEWEST ? "drop newest" : "drop oldest";
+}
+
+// Queue and slot helpers; all called with the mutex held
+
+static void stage_pipeline_push(stage_pipeline_queue_t* queue, int slot) {
+    queue->slots[(queue->head + queue->count) % STAGE_PIPELINE_MAX_SLOTS] = slot;
+    queue->count++;
+    pthread_cond_signal(&queue->ready);
+}
+
+static int stage_pipeline_pop(stage_pipeline_queue_t* queue) {
+    int slot = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % STAGE_PIPELINE_MAX_SLOTS;
+    queue->count--;
+    pthread_cond_signal(&queue->space);
+    return slot;
+}
+
+static void stage_pipeline_release(stage_pipeline_t* pipeline, int slot) {
+    pipeline->free_slots[pipeline->free_count++] = slot;
+    pthread_cond_broadcast(&pipeline->slot_freed);
+}
+
+static void stage_pipeline_record_max(int64_t* max, int64_t value) {
+    if (value > *max) {
+        *max = value;
+    }
+}
+
+// One stage: take the oldest queued frame, run it, pass it on. Only the
+// stage function runs without the mutex.
+static void* stage_pipeline_thread(void* arg) {
+    stage_pipeline_start_t* start = (stage_pipeline_start_t*)arg;
+    stage_pipeline_t* pipeline = start->pipeline;
+    const int index = start->index;
+    const stage_pipeline_stage_t* stage = &pipeline->stages[index];
+    stage_pipeline_queue_t* queue = &pipeline->queues[index];
+    stage_pipeline_queue_t* next = index + 1 < pipeline->stage_count ? &pipeline->queues[index + 1] : NULL;
+    stage_pipeline_stage_stats_t* stats = &pipeline->stats.stages[index];
+
+    pthread_mutex_lock(&pipeline->mutex);
+    for (;;) {
+        while (pipeline->running && queue->count == 0) {
+            pthread_cond_wait(&queue->ready, &pipeline->mutex);
+        }
+        if (!pipeline->running) {
+            break;
+        }
+
+        int slot = stage_pipeline_pop(queue);
+        int64_t now_ns = stage_pipeline_now_ns();
+        int64_t wait_ns = now_ns - pipeline->queued_ns[slot];
+        stats->wait_sum_ns += wait_ns;
+        stage_pipeline_record_max(&stats->wait_max_ns, wait_ns);
+        if (pipeline->config.max_age_ns > 0 &&
+            now_ns - pipeline->submit_ns[slot] > pipeline->config.max_age_ns) {
+            stats->stale++;
+            stage_pipeline_release(pipeline, slot);
+            continue;
+        }
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        int rc = stage->run(pipeline->context, slot);
+        int64_t done_ns = stage_pipeline_now_ns();
+
+        pthread_mutex_lock(&pipeline->mutex);
+        stats->frames++;
+        stats->busy_ns += done_ns - now_ns;
+        if (rc != 0) {
+            stats->failed++;
+            stage_pipeline_release(pipeline, slot);
+            continue;
+        }
+        if (!next) {
+            int64_t latency_ns = done_ns - pipeline->submit_ns[slot];
+            pipeline->stats.completed++;
+            pipeline->stats.latency_sum_ns += latency_ns;
+            stage_pipeline_record_max(&pipeline->stats.latency_max_ns, latency_ns);
+            stage_pipeline_release(pipeline, slot);
+            continue;
+        }
+
+        // Back-pressure: hold the frame until the next stage has room
+        while (pipeline->running && next->count >= pipeline->config.queue_depth) {
+            pthread_cond_wait(&next->space, &pipeline->mutex);
+        }
+        stats->blocked_ns += stage_pipeline_now_ns() - done_ns;
+        if (!pipeline->running) {
+            stage_pipeline_release(pipeline, slot);
+            break;
+        }
+        pipeline->queued_ns[slot] = stage_pipeline_now_ns();
+        stage_pipeline_push(next, slot);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    return NULL;
+}
+
+int stage_pipeline_init(stage_pipeline_t* pipeline, const stage_pipeline_config_t* config,
+                        const stage_pipeline_stage_t* stages, int stage_count, void* context) {
+    memset(pipeline, 0, sizeof(*pipeline));
+
+    if (stage_count < 1 || stage_count > STAGE_PIPELINE_MAX_STAGES ||
+        config->max_in_flight < 1 || config->max_in_flight > STAGE_PIPELINE_MAX_SLOTS ||
+        config->queue_depth < 1 || config->queue_depth > STAGE_PIPELINE_MAX_SLOTS) {
+        RCUTILS_LOG_ERROR("Invalid pipeline: %d stages, %d frames in flight, queues of %d",
+            stage_count, config->max_in_flight, config->queue_depth);
+        return -1;
+    }
+
+    pipeline->config = *config;
+    memcpy(pipeline->stages, stages, (size_t)stage_count * sizeof(stages[0]));
+    pipeline->stage_count = stage_count;
+    pipeline->context = context;
+
+    // Lowest slot on top, so a lightly loaded pipeline keeps reusing it
+    for (int i = 0; i < config->max_in_flight; ++i) {
+        pipeline->free_slots[i] = config->max_in_flight - 1 - i;
+    }
+    pipeline->free_count = config->max_in_flight;
+    pipeline->running = true;
+    pipeline->stats_start_ns = stage_pipeline_now_ns();
+
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->slot_freed, NULL);
+    for (int i = 0; i < stage_count; ++i) {
+        pthread_cond_init(&pipeline->queues[i].ready, NULL);
+        pthread_cond_init(&pipeline->queues[i].space, NULL);
+    }
+
+    for (int i = 0; i < stage_count; ++i) {
+        stage_pipeline_start_t* start = &pipeline->starts[i];
+        start->pipeline = pipeline;
+        start->index = i;
+        if (pthread_create(&pipeline->threads[i], NULL, stage_pipeline_thread, start) != 0) {
+            RCUTILS_LOG_ERROR("Failed to start %s thread", stages[i].name);
+            stage_pipeline_fini(pipeline);
+            return -1;
+        }
+        pipeline->started++;
+    }
+    return 0;
+}
+
+void stage_pipeline_fini(stage_pipeline_t* pipeline) {
+    if (pipeline->stage_count == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->running = false;
+    pthread_cond_broadcast(&pipeline->slot_freed);
+    for (int i = 0; i < pipeline->stage_count; ++i) {
+        pthread_cond_broadcast(&pipeline->queues[i].ready);
+        pthread_cond_broadcast(&pipeline->queues[i].space);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    for (int i = 0; i < pipeline->started; ++i) {
+        pthread_join(pipeline->threads[i], NULL);
+    }
+
+    for (int i = 0; i < pipeline->stage_count; ++i) {
+        pthread_cond_destroy(&pipeline->queues[i].ready);
+        pthread_cond_destroy(&pipeline->queues[i].space);
+    }
+    pthread_cond_destroy(&pipeline->slot_freed);
+    pthread_mutex_destroy(&pipeline->mutex);
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+int stage_pipeline_acquire(stage_pipeline_t* pipeline, bool wait) {
+    int slot = -1;
+    pthread_mutex_lock(&pipeline->mutex);
+    for (;;) {
+        // With wait, also hold off until the entry queue has room, so the
+        // submit that follows never drops (only this thread adds to it)
+        bool room = !wait || pipeline->queues[0].count < pipeline->config.queue_depth;
+        if (pipeline->free_count > 0 && room) {
+            slot = pipeline->free_slots[--pipeline->free_count];
+            break;
+        }
+        if (!pipeline->running) {
+            break;
+        }
+        if (wait) {
+            pthread_cond_wait(pipeline->free_count > 0 ? &pipeline->queues[0].space :
+                                                         &pipeline->slot_freed,
+                              &pipeline->mutex);
+            continue;
+        }
+
+        // Every slot is busy: recycle a frame no stage has started yet,
+        // or give up on the new one
+        if (pipeline->config.policy == STAGE_PIPELINE_DROP_OLDEST && pipeline->queues[0].count > 0) {
+            slot = stage_pipeline_pop(&pipeline->queues[0]);
+            pipeline->stats.dropped_oldest++;
+        } else {
+            pipeline->stats.dropped_newest++;
+        }
+        break;
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    return slot;
+}
+
+void stage_pipeline_submit(stage_pipeline_t* pipeline, int slot) {
+    pthread_mutex_lock(&pipeline->mutex);
+    int64_t now_ns = stage_pipeline_now_ns();
+    pipeline->submit_ns[slot] = now_ns;
+    pipeline->queued_ns[slot] = now_ns;
+    pipeline->stats.submitted++;
+
+    stage_pipeline_queue_t* queue = &pipeline->queues[0];
+    bool queued = true;
+    if (queue->count >= pipeline->config.queue_depth) {
+        if (pipeline->config.policy == STAGE_PIPELINE_DROP_OLDEST) {
+            stage_pipeline_release(pipeline, stage_pipeline_pop(queue));
+            pipeline->stats.dropped_oldest++;
+        } else {
+            stage_pipeline_release(pipeline, slot);
+            pipeline->stats.dropped_newest++;
+            queued = false;
+        }
+    }
+    if (queued) {
+        stage_pipeline_push(queue, slot);
+    }
+
+    int in_flight = pipeline->config.max_in_flight - pipeline->free_count;
+    if (in_flight > pipeline->stats.in_flight_max) {
+        pipeline->stats.in_flight_max = in_flight;
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+void stage_pipeline_cancel(stage_pipeline_t* pipeline, int slot) {
+    pthread_mutex_lock(&pipeline->mutex);
+    stage_pipeline_release(pipeline, slot);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+void stage_pipeline_wait_idle(stage_pipeline_t* pipeline) {
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->running && pipeline->free_count < pipeline->config.max_in_flight) {
+        pthread_cond_wait(&pipeline->slot_freed, &pipeline->mutex);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+void stage_pipeline_take_stats(stage_pipeline_t* pipeline, stage_pipeline_stats_t* stats) {
+    pthread_mutex_lock(&pipeline->mutex);
+    int64_t now_ns = stage_pipeline_now_ns();
+    *stats = pipeline->stats;
+    stats->interval_ns = now_ns - pipeline->stats_start_ns;
+
+    memset(&pipeline->stats, 0, sizeof(pipeline->stats));
+    pipeline->stats.in_flight_max = pipeline->config.max_in_flight - pipeline->free_count;
+    pipeline->stats_start_ns = now_ns;
+    pthread_mutex_unlock(&pipeline->mutex);
+}
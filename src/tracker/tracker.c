@@ -0,0 +1,398 @@
+#include "tracker/tracker.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <rcutils/logging_macros.h>
+
+// SORT's noise settings, in pixels and frames
+#define TRACKER_R_CENTER 1.0f       // Measurement noise
+#define TRACKER_R_SHAPE 10.0f       // Area and aspect
+#define TRACKER_P_VALUE 10.0f       // Initial uncertainty
+#define TRACKER_P_RATE 10000.0f     // Velocity is unknown at first
+#define TRACKER_Q_VALUE 1.0f        // Process noise
+#define TRACKER_Q_RATE 0.01f
+#define TRACKER_Q_AREA_RATE 0.0001f
+
+void tracker_config_default(tracker_config_t* config) {
+    memset(config, 0, sizeof(*config));
+    config->iou_threshold = 0.3f;
+    config->min_hits = 2;
+    config->max_missed = 1;
+    config->confidence_decay = 0.95f;
+    config->class_aware = true;
+}
+
+int tracker_init(tracker_t* tracker, const tracker_config_t* config) {
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->config = *config;
+    tracker->state.next_id = 1;
+
+    const size_t n = TRACKER_MAX_DETECTIONS;
+    tracker->cost = malloc(n * n * sizeof(float));
+    tracker->row_potential = malloc((n + 1) * sizeof(double));
+    tracker->col_potential = malloc((n + 1) * sizeof(double));
+    tracker->min_slack = malloc((n + 1) * sizeof(double));
+    tracker->col_row = malloc((n + 1) * sizeof(int));
+    tracker->way = malloc((n + 1) * sizeof(int));
+    tracker->used = malloc((n + 1) * sizeof(bool));
+    tracker->assignment = malloc(n * sizeof(int));
+    if (!tracker->cost || !tracker->row_potential || !tracker->col_potential ||
+        !tracker->min_slack || !tracker->col_row || !tracker->way || !tracker->used ||
+        !tracker->assignment) {
+        RCUTILS_LOG_ERROR("Out of memory for the tracker");
+        tracker_fini(tracker);
+        return -1;
+    }
+    return 0;
+}
+
+void tracker_fini(tracker_t* tracker) {
+    free(tracker->cost);
+    free(tracker->row_potential);
+    free(tracker->col_potential);
+    free(tracker->min_slack);
+    free(tracker->col_row);
+    free(tracker->way);
+    free(tracker->used);
+    free(tracker->assignment);
+    memset(tracker, 0, sizeof(*tracker));
+}
+
+// ---------------------------------------------------------------------------
+// Kalman filter, one coordinate: x' = x + rate, rate' = rate
+// ---------------------------------------------------------------------------
+
+static void tracker_kf_init(tracker_kf_t* kf, float value) {
+    kf->value = value;
+    kf->rate = 0.0f;
+    kf->p00 = TRACKER_P_VALUE;
+    kf->p01 = 0.0f;
+    kf->p11 = TRACKER_P_RATE;
+}
+
+static void tracker_kf_predict(tracker_kf_t* kf, float q_rate) {
+    kf->value += kf->rate;
+    kf->p00 += 2.0f * kf->p01 + kf->p11 + TRACKER_Q_VALUE;
+    kf->p01 += kf->p11;
+    kf->p11 += q_rate;
+}
+
+static void tracker_kf_update(tracker_kf_t* kf, float measured, float r) {
+    float innovation = measured - kf->value;
+    float s = kf->p00 + r;
+    float k0 = kf->p00 / s;
+    float k1 = kf->p01 / s;
+    kf->value += k0 * innovation;
+    kf->rate += k1 * innovation;
+    kf->p11 -= k1 * kf->p01;
+    kf->p01 *= 1.0f - k0;
+    kf->p00 *= 1.0f - k0;
+}
+
+// ---------------------------------------------------------------------------
+// Boxes
+// ---------------------------------------------------------------------------
+
+static void tracker_track_box(const tracker_track_t* track, float* x1, float* y1, float* x2, float* y2) {
+    float area = track->area.value > 1.0f ? track->area.value : 1.0f;
+    float aspect = track->aspect > 1e-3f ? track->aspect : 1e-3f;
+    float w = sqrtf(area * aspect);
+    float h = area / w;
+    *x1 = track->cx.value - 0.5f * w;
+    *y1 = track->cy.value - 0.5f * h;
+    *x2 = track->cx.value + 0.5f * w;
+    *y2 = track->cy.value + 0.5f * h;
+}
+
+static float tracker_iou(float ax1, float ay1, float ax2, float ay2,
+                         float bx1, float by1, float bx2, float by2) {
+    float w = fminf(ax2, bx2) - fmaxf(ax1, bx1);
+    float h = fminf(ay2, by2) - fmaxf(ay1, by1);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = w * h;
+    float uni = (ax2 - ax1) * (ay2 - ay1) + (bx2 - bx1) * (by2 - by1) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+static float tracker_track_iou(const tracker_track_t* track, const postprocess_detection_t* det) {
+    float x1, y1, x2, y2;
+    tracker_track_box(track, &x1, &y1, &x2, &y2);
+    return tracker_iou(x1, y1, x2, y2, det->x1, det->y1, det->x2, det->y2);
+}
+
+static void tracker_track_correct(tracker_track_t* track, const postprocess_detection_t* det) {
+    float w = det->x2 - det->x1;
+    float h = det->y2 - det->y1;
+    tracker_kf_update(&track->cx, det->x1 + 0.5f * w, TRACKER_R_CENTER);
+    tracker_kf_update(&track->cy, det->y1 + 0.5f * h, TRACKER_R_CENTER);
+    tracker_kf_update(&track->area, w * h, TRACKER_R_SHAPE);
+
+    float gain = track->aspect_var / (track->aspect_var + TRACKER_R_SHAPE);
+    track->aspect += gain * (w / (h > 1e-3f ? h : 1e-3f) - track->aspect);
+    track->aspect_var *= 1.0f - gain;
+
+    track->confidence = det->score;
+    track->hits++;
+    track->missed = 0;
+}
+
+// ---------------------------------------------------------------------------
+// Hungarian algorithm (shortest augmenting paths with row/column
+// potentials), O(size^3)
+// ---------------------------------------------------------------------------
+
+double tracker_assign(tracker_t* tracker, const float* cost, int size, int* assignment) {
+    double* u = tracker->row_potential;
+    double* v = tracker->col_potential;
+    double* min_slack = tracker->min_slack;
+    int* col_row = tracker->col_row;
+    int* way = tracker->way;
+    bool* used = tracker->used;
+
+    // 1-based; column 0 is the virtual start of each augmenting path
+    for (int j = 0; j <= size; ++j) {
+        u[j] = 0.0;
+        v[j] = 0.0;
+        col_row[j] = 0;
+        way[j] = 0;
+    }
+
+    for (int i = 1; i <= size; ++i) {
+        col_row[0] = i;
+        int j0 = 0;
+        for (int j = 0; j <= size; ++j) {
+            min_slack[j] = DBL_MAX;
+            used[j] = false;
+        }
+
+        // Grow the alternating tree from row i until it reaches a free column
+        do {
+            used[j0] = true;
+            int i0 = col_row[j0];
+            const float* row = cost + (size_t)(i0 - 1) * size;
+            double delta = DBL_MAX;
+            int j1 = 0;
+            for (int j = 1; j <= size; ++j) {
+                if (used[j]) {
+                    continue;
+                }
+                double slack = row[j - 1] - u[i0] - v[j];
+                if (slack < min_slack[j]) {
+                    min_slack[j] = slack;
+                    way[j] = j0;
+                }
+                if (min_slack[j] < delta) {
+                    delta = min_slack[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= size; ++j) {
+                if (used[j]) {
+                    u[col_row[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_slack[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (col_row[j0] != 0);
+
+        // Flip the path
+        do {
+            int j1 = way[j0];
+            col_row[j0] = col_row[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    double total = 0.0;
+    for (int j = 1; j <= size; ++j) {
+        int row = col_row[j] - 1;
+        assignment[row] = j - 1;
+        total += cost[(size_t)row * size + (j - 1)];
+    }
+    return total;
+}
+
+// ---------------------------------------------------------------------------
+// Track lifecycle
+// ---------------------------------------------------------------------------
+
+static void tracker_end_track(tracker_state_t* state, int index) {
+    tracker_track_t* track = &state->tracks[index];
+    tracker_lost_t* lost = &state->lost[state->lost_next];
+    tracker_track_box(track, &lost->x1, &lost->y1, &lost->x2, &lost->y2);
+    lost->class_id = track->class_id;
+    lost->frame = state->frame;
+    state->lost_next = (state->lost_next + 1) % TRACKER_MAX_LOST;
+    state->ended++;
+
+    state->tracks[index] = state->tracks[--state->count];
+}
+
+// A new track where a recently lost or still coasting track of the same
+// class was means the object most likely changed identity
+static bool tracker_is_id_switch(tracker_t* tracker, const postprocess_detection_t* det) {
+    tracker_state_t* state = &tracker->state;
+    float threshold = tracker->config.iou_threshold;
+
+    for (int i = 0; i < TRACKER_MAX_LOST; ++i) {
+        tracker_lost_t* lost = &state->lost[i];
+        if (lost->frame == 0 || state->frame - lost->frame > TRACKER_SWITCH_WINDOW ||
+            lost->class_id != det->class_id) {
+            continue;
+        }
+        if (tracker_iou(lost->x1, lost->y1, lost->x2, lost->y2,
+                        det->x1, det->y1, det->x2, det->y2) >= threshold) {
+            lost->frame = 0; // Count each lost track once
+            return true;
+        }
+    }
+    for (int i = 0; i < state->count; ++i) {
+        const tracker_track_t* track = &state->tracks[i];
+        if (track->missed > 0 && track->class_id == det->class_id &&
+            tracker_track_iou(track, det) >= threshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void tracker_start_track(tracker_t* tracker, const postprocess_detection_t* det) {
+    tracker_state_t* state = &tracker->state;
+    if (state->count >= TRACKER_MAX_TRACKS) {
+        return;
+    }
+    if (tracker_is_id_switch(tracker, det)) {
+        state->id_switches++;
+    }
+
+    tracker_track_t* track = &state->tracks[state->count++];
+    memset(track, 0, sizeof(*track));
+    float w = det->x2 - det->x1;
+    float h = det->y2 - det->y1;
+    track->id = state->next_id++;
+    track->class_id = det->class_id;
+    tracker_kf_init(&track->cx, det->x1 + 0.5f * w);
+    tracker_kf_init(&track->cy, det->y1 + 0.5f * h);
+    tracker_kf_init(&track->area, w * h);
+    track->aspect = w / (h > 1e-3f ? h : 1e-3f);
+    track->aspect_var = TRACKER_P_VALUE;
+    track->confidence = det->score;
+    track->hits = 1;
+    state->started++;
+}
+
+void tracker_predict(tracker_t* tracker) {
+    tracker_state_t* state = &tracker->state;
+    for (int i = 0; i < state->count; ++i) {
+        tracker_track_t* track = &state->tracks[i];
+
+        // Never shrink a box below nothing (as SORT does)
+        if (track->area.value + track->area.rate <= 0.0f) {
+            track->area.rate = 0.0f;
+        }
+        tracker_kf_predict(&track->cx, TRACKER_Q_RATE);
+        tracker_kf_predict(&track->cy, TRACKER_Q_RATE);
+        tracker_kf_predict(&track->area, TRACKER_Q_AREA_RATE);
+        track->aspect_var += TRACKER_Q_VALUE;
+        track->confidence *= tracker->config.confidence_decay;
+        track->age++;
+    }
+    state->frame++;
+}
+
+void tracker_update(tracker_t* tracker, const postprocess_detection_t* detections, int count) {
+    tracker_state_t* state = &tracker->state;
+    const tracker_config_t* config = &tracker->config;
+    if (count > TRACKER_MAX_DETECTIONS) {
+        count = TRACKER_MAX_DETECTIONS;
+    }
+
+    // Square cost matrix, tracks x detections padded with "no match" (1)
+    int tracks = state->count;
+    int size = tracks > count ? tracks : count;
+    int* assignment = tracker->assignment;
+    for (int i = 0; i < tracks; ++i) {
+        assignment[i] = -1;
+    }
+    if (tracks > 0 && count > 0) {
+        for (int i = 0; i < size; ++i) {
+            float* row = tracker->cost + (size_t)i * size;
+            for (int j = 0; j < size; ++j) {
+                row[j] = 1.0f;
+                if (i < tracks && j < count &&
+                    (!config->class_aware || state->tracks[i].class_id == detections[j].class_id)) {
+                    row[j] = 1.0f - tracker_track_iou(&state->tracks[i], &detections[j]);
+                }
+            }
+        }
+        tracker_assign(tracker, tracker->cost, size, assignment);
+    }
+
+    // Keep pairs that overlap enough; used[] marks matched detections
+    bool* matched = tracker->used;
+    for (int j = 0; j < count; ++j) {
+        matched[j] = false;
+    }
+    for (int i = 0; i < tracks; ++i) {
+        int j = assignment[i];
+        if (j >= 0 && j < count &&
+            1.0f - tracker->cost[(size_t)i * size + j] >= config->iou_threshold) {
+            tracker_track_correct(&state->tracks[i], &detections[j]);
+            matched[j] = true;
+        } else {
+            state->tracks[i].missed++;
+        }
+    }
+
+    // End tracks that missed too often; walk backwards since ending one
+    // moves the last track into its place
+    for (int i = tracks - 1; i >= 0; --i) {
+        if (state->tracks[i].missed > (uint32_t)config->max_missed) {
+            tracker_end_track(state, i);
+        }
+    }
+
+    for (int j = 0; j < count; ++j) {
+        if (!matched[j]) {
+            tracker_start_track(tracker, &detections[j]);
+        }
+    }
+}
+
+static bool tracker_is_reported(const tracker_t* tracker, const tracker_track_t* track) {
+    return track->missed == 0 && track->hits >= (uint32_t)tracker->config.min_hits;
+}
+
+int tracker_output(const tracker_t* tracker, tracker_output_t* out, int max) {
+    const tracker_state_t* state = &tracker->state;
+    int written = 0;
+    for (int i = 0; i < state->count && written < max; ++i) {
+        const tracker_track_t* track = &state->tracks[i];
+        if (!tracker_is_reported(tracker, track)) {
+            continue;
+        }
+        tracker_output_t* o = &out[written++];
+        tracker_track_box(track, &o->x1, &o->y1, &o->x2, &o->y2);
+        o->score = track->confidence;
+        o->class_id = track->class_id;
+        o->id = track->id;
+    }
+    return written;
+}
+
+float tracker_min_confidence(const tracker_t* tracker) {
+    const tracker_state_t* state = &tracker->state;
+    float lowest = 1.0f;
+    for (int i = 0; i < state->count; ++i) {
+        const tracker_track_t* track = &state->tracks[i];
+        if (tracker_is_reported(tracker, track) && track->confidence < lowest) {
+            lowest = track->confidence;
+        }
+    }
+    return lowest;
+}
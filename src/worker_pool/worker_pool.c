@@ -0,0 +1,236 @@
+#define _GNU_SOURCE
+#include "worker_pool/worker_pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <rcutils/logging_macros.h>
+
+#define WORKER_POOL_DEFAULT_L2 (512u * 1024u)
+
+// Pull tasks until the job is exhausted
+static void worker_pool_drain(worker_pool_t* pool) {
+    for (;;) {
+        int task = __atomic_fetch_add(&pool->next_task, 1, __ATOMIC_RELAXED);
+        if (task >= pool->task_count) {
+            return;
+        }
+        pool->fn(pool->ctx, task);
+    }
+}
+
+static void* worker_pool_thread(void* arg) {
+    worker_pool_start_t* start = (worker_pool_start_t*)arg;
+    worker_pool_t* pool = start->pool;
+
+    if (start->pin) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        // Worker i runs on CPU i; CPU 0 is left to the calling thread
+        CPU_SET(cpus > 0 ? start->index % cpus : 0, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+            RCUTILS_LOG_WARN("Failed to pin worker %d", start->index);
+        }
+    }
+
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->job_cond, &pool->mutex);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        worker_pool_drain(pool);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (++pool->workers_done == pool->started) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+int worker_pool_init(worker_pool_t* pool, int thread_count, bool pin_threads) {
+    memset(pool, 0, sizeof(*pool));
+
+    if (thread_count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        thread_count = cpus > 0 ? (int)cpus : 1;
+    }
+    if (thread_count > WORKER_POOL_MAX_THREADS) {
+        thread_count = WORKER_POOL_MAX_THREADS;
+    }
+    pool->thread_count = thread_count;
+
+    if (thread_count == 1) {
+        return 0; // Inline mode
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->job_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    for (int i = 1; i < thread_count; ++i) {
+        worker_pool_start_t* start = &pool->starts[i];
+        start->pool = pool;
+        start->index = i;
+        start->pin = pin_threads;
+        if (pthread_create(&pool->threads[i], NULL, worker_pool_thread, start) != 0) {
+            RCUTILS_LOG_ERROR("Failed to start worker thread %d", i);
+            worker_pool_fini(pool);
+            return -1;
+        }
+        pool->started++;
+    }
+
+    return 0;
+}
+
+void worker_pool_fini(worker_pool_t* pool) {
+    if (pool->thread_count <= 1) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 1; i <= pool->started; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->started = 0;
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->job_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    pool->thread_count = 0;
+}
+
+void worker_pool_run(worker_pool_t* pool, int task_count, worker_pool_task_fn fn, void* ctx) {
+    if (task_count <= 0) {
+        return;
+    }
+
+    if (pool->thread_count <= 1 || task_count == 1) {
+        for (int i = 0; i < task_count; ++i) {
+            fn(ctx, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->task_count = task_count;
+    pool->next_task = 0;
+    pool->workers_done = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    // The caller works too instead of just waiting
+    worker_pool_drain(pool);
+
+    // Wait until every worker is done with this job, including ones that
+    // woke up too late to get a task, before the job state can change
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->workers_done < pool->started) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+int worker_pool_thread_count(const worker_pool_t* pool) {
+    return pool->thread_count;
+}
+
+size_t worker_pool_l2_cache_size(void) {
+    static size_t cached = 0;
+    if (cached) {
+        return cached;
+    }
+
+    size_t size = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (l2 > 0) {
+        size = (size_t)l2;
+    }
+#endif
+
+    // glibc reports 0 on many ARM cores; ask sysfs instead
+    if (size == 0) {
+        FILE* f = fopen("/sys/devices/system/cpu/cpu0/cache/index2/size", "r");
+        if (f) {
+            unsigned long value = 0;
+            char unit = 0;
+            if (fscanf(f, "%lu%c", &value, &unit) >= 1) {
+                size = value * (unit == 'K' ? 1024u : (unit == 'M' ? 1024u * 1024u : 1u));
+            }
+            fclose(f);
+        }
+    }
+
+    cached = size ? size : WORKER_POOL_DEFAULT_L2;
+    return cached;
+}
+
+int worker_pool_band_rows(size_t bytes_per_row, int height) {
+    if (bytes_per_row == 0) {
+        return height;
+    }
+    size_t rows = (worker_pool_l2_cache_size() / 2) / bytes_per_row;
+    if (rows < 1) {
+        rows = 1;
+    }
+    return rows > (size_t)height ? height : (int)rows;
+}
+
+typedef struct {
+    worker_pool_band_fn fn;
+    void* ctx;
+    int height;
+    int band_rows;
+} worker_pool_bands_t;
+
+static void worker_pool_band_task(void* ctx, int task_index) {
+    worker_pool_bands_t* bands = (worker_pool_bands_t*)ctx;
+    int begin = task_index * bands->band_rows;
+    int end = begin + bands->band_rows;
+    bands->fn(bands->ctx, begin, end < bands->height ? end : bands->height);
+}
+
+void worker_pool_run_bands(worker_pool_t* pool, int height, size_t bytes_per_row,
+                           worker_pool_band_fn fn, void* ctx) {
+    if (height <= 0) {
+        return;
+    }
+
+    if (pool->thread_count <= 1) {
+        fn(ctx, 0, height);
+        return;
+    }
+
+    // Cache-sized bands, but small enough that every thread gets several
+    int rows = worker_pool_band_rows(bytes_per_row, height);
+    int balanced = (height + pool->thread_count * WORKER_POOL_BANDS_PER_THREAD - 1) /
+                   (pool->thread_count * WORKER_POOL_BANDS_PER_THREAD);
+    if (balanced < WORKER_POOL_MIN_BAND_ROWS) {
+        balanced = WORKER_POOL_MIN_BAND_ROWS;
+    }
+    if (rows > balanced) {
+        rows = balanced;
+    }
+
+    worker_pool_bands_t bands = { fn, ctx, height, rows };
+    worker_pool_run(pool, (height + rows - 1) / rows, worker_pool_band_task, &bands);
+}
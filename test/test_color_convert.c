@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_convert/color_convert.h"
+#include "worker_pool/worker_pool.h"
+
+#include "test_util.h"
+
+// Byte-exact checks of every kernel against the formula in color_convert.h
+// (not against the scalar kernel, so a shared mistake shows up too): every
+// width up to TEST_CONVERT_EXACT_WIDTH, odd ones included, with packed and
+// padded source and destination strides, on random bytes and extreme Y, U
+// and V values, then one frame holding every combination of the extremes.
+// Padding and the rows around the frame must be left alone.
+#define TEST_CONVERT_EXACT_WIDTH 130
+#define TEST_CONVERT_EXACT_HEIGHT 5
+#define TEST_CONVERT_CANARY 0xA5
+#define TEST_CONVERT_EXTREMES 12
+#define TEST_CONVERT_ALL_WIDTH 128     // Every combination: 12^4 macropixels
+#define TEST_CONVERT_ALL_HEIGHT (TEST_CONVERT_EXTREMES * TEST_CONVERT_EXTREMES * \
+                                  TEST_CONVERT_EXTREMES * TEST_CONVERT_EXTREMES / (TEST_CONVERT_ALL_WIDTH / 2))
+
+static uint8_t test_convert_clamp(int value) {
+    return (uint8_t)(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+static void test_convert_reference(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+                                    int width, int height) {
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = src + (size_t)y * src_stride;
+        for (int x = 0; x < width; ++x) {
+            const uint8_t* pair = row + (x / 2) * 4;
+            int c = 298 * (pair[(x & 1) * 2] - 16);
+            int d = pair[1] - 128;
+            int e = pair[3] - 128;
+            uint8_t* out = dst + (size_t)y * dst_stride + (size_t)x * 3;
+            out[0] = test_convert_clamp((c + 409 * e + 128) >> 8);
+            out[1] = test_convert_clamp((c - 100 * d - 208 * e + 128) >> 8);
+            out[2] = test_convert_clamp((c + 516 * d + 128) >> 8);
+        }
+    }
+}
+
+// Macropixels cycling through every combination of these Y0, U, Y1, V
+static void test_convert_fill_extremes(uint8_t* data, size_t size) {
+    static const uint8_t values[TEST_CONVERT_EXTREMES] = {
+        0, 1, 16, 17, 127, 128, 129, 235, 236, 240, 254, 255,
+    };
+    const size_t n = sizeof(values);
+    for (size_t i = 0; i < size; ++i) {
+        size_t macropixel = i / 4;
+        size_t digit = i % 4;
+        size_t combination = macropixel;
+        for (size_t k = 0; k < digit; ++k) {
+            combination /= n;
+        }
+        data[i] = values[combination % n];
+    }
+}
+
+// Convert width x height from src (rows src_stride apart) into canary
+// filled buffers with a guard row around the frame and compare with the
+// formula. Returns 0 if every byte, including the guards, matches.
+static int test_convert_compare(yuyv_to_rgb24_fn convert, const char* name, const char* content,
+                                 const uint8_t* src, int src_stride, int dst_stride,
+                                 int width, int height, uint8_t* dst, uint8_t* expected) {
+    size_t dst_size = (size_t)dst_stride * (height + 2);
+    memset(dst, TEST_CONVERT_CANARY, dst_size);
+    memset(expected, TEST_CONVERT_CANARY, dst_size);
+    test_convert_reference(src, src_stride, expected + dst_stride, dst_stride, width, height);
+    convert(src, src_stride, dst + dst_stride, dst_stride, width, height);
+    if (memcmp(dst, expected, dst_size) == 0) {
+        return 0;
+    }
+    size_t at = 0;
+    while (dst[at] == expected[at]) {
+        at++;
+    }
+    fprintf(stderr, "convert: %s wrong on %s input, width %d, strides %d/%d: "
+            "byte %zu of row %zu is %u, expected %u\n", name, content, width, src_stride, dst_stride,
+            at % (size_t)dst_stride, at / (size_t)dst_stride, dst[at], expected[at]);
+    return -1;
+}
+
+static int test_convert_exact(void) {
+    const int src_pads[] = { 0, 4, 14 };    // Bytes past the last macropixel
+    const int dst_pads[] = { 0, 1, 7 };     // Bytes past the last pixel
+    const int rows = TEST_CONVERT_EXACT_HEIGHT + 2;    // Guard row above and below
+    size_t src_max = (size_t)((TEST_CONVERT_EXACT_WIDTH + 1) / 2 * 4 + 14) * rows;
+    size_t dst_max = (size_t)(TEST_CONVERT_EXACT_WIDTH * 3 + 7) * rows;
+    uint8_t* src = malloc(src_max);
+    uint8_t* dst = malloc(dst_max);
+    uint8_t* expected = malloc(dst_max);
+    if (!src || !dst || !expected) {
+        free(src);
+        free(dst);
+        free(expected);
+        return -1;
+    }
+
+    int result = 0;
+    long long frames = 0;
+    for (int isa = 0; isa < COLOR_CONVERT_ISA_COUNT && result == 0; ++isa) {
+        yuyv_to_rgb24_fn convert = color_convert_get_yuyv_to_rgb24((color_convert_isa_t)isa);
+        if (!convert || color_convert_detect_isa() < (color_convert_isa_t)isa) {
+            continue;
+        }
+        const char* name = color_convert_isa_name((color_convert_isa_t)isa);
+        for (int content = 0; content < 2 && result == 0; ++content) {
+            if (content == 0) {
+                test_fill_random(src, src_max, 5);
+            } else {
+                test_convert_fill_extremes(src, src_max);
+            }
+            for (int width = 1; width <= TEST_CONVERT_EXACT_WIDTH && result == 0; ++width) {
+                for (size_t sp = 0; sp < sizeof(src_pads) / sizeof(src_pads[0]) && result == 0; ++sp) {
+                    for (size_t dp = 0; dp < sizeof(dst_pads) / sizeof(dst_pads[0]) && result == 0; ++dp) {
+                        int src_stride = (width + 1) / 2 * 4 + src_pads[sp];
+                        int dst_stride = width * 3 + dst_pads[dp];
+                        result = test_convert_compare(convert, name, content ? "extreme" : "random",
+                                                       src + src_stride, src_stride, dst_stride, width,
+                                                       TEST_CONVERT_EXACT_HEIGHT, dst, expected);
+                        frames++;
+                    }
+                }
+            }
+        }
+    }
+    free(src);
+    free(dst);
+    free(expected);
+
+    // Every combination of extremes at once, even and odd width, padded
+    size_t all_src = (size_t)TEST_CONVERT_ALL_WIDTH * 2 * TEST_CONVERT_ALL_HEIGHT;
+    size_t all_dst = (size_t)(TEST_CONVERT_ALL_WIDTH * 3 + 7) * (TEST_CONVERT_ALL_HEIGHT + 2);
+    src = malloc(all_src);
+    dst = malloc(all_dst);
+    expected = malloc(all_dst);
+    if (!src || !dst || !expected) {
+        result = -1;
+    } else {
+        test_convert_fill_extremes(src, all_src);
+    }
+    for (int isa = 0; isa < COLOR_CONVERT_ISA_COUNT && result == 0; ++isa) {
+        yuyv_to_rgb24_fn convert = color_convert_get_yuyv_to_rgb24((color_convert_isa_t)isa);
+        if (!convert || color_convert_detect_isa() < (color_convert_isa_t)isa) {
+            continue;
+        }
+        const char* name = color_convert_isa_name((color_convert_isa_t)isa);
+        for (int odd = 0; odd < 2 && result == 0; ++odd) {
+            int width = TEST_CONVERT_ALL_WIDTH - odd;
+            result = test_convert_compare(convert, name, "all extremes", src, TEST_CONVERT_ALL_WIDTH * 2,
+                                           width * 3 + odd * 7, width, TEST_CONVERT_ALL_HEIGHT,
+                                           dst, expected);
+            frames++;
+        }
+    }
+    if (result == 0) {
+        printf("  exact: %lld frames match the formula (widths 1-%d, padded strides, random "
+               "and extreme YUV, all %d^4 extreme macropixels)\n", frames, TEST_CONVERT_EXACT_WIDTH,
+               TEST_CONVERT_EXTREMES);
+    }
+
+    free(src);
+    free(dst);
+    free(expected);
+    return result;
+}
+
+// The band-parallel conversion must give the scalar kernel's bytes whatever
+// the thread count and however the rows split into bands
+#define TEST_PARALLEL_WIDTH 642
+#define TEST_PARALLEL_HEIGHT 481
+
+static int test_convert_parallel(void) {
+    size_t src_size = (size_t)TEST_PARALLEL_WIDTH * 2 * TEST_PARALLEL_HEIGHT;
+    size_t dst_size = (size_t)TEST_PARALLEL_WIDTH * 3 * TEST_PARALLEL_HEIGHT;
+    uint8_t* src = malloc(src_size);
+    uint8_t* dst = malloc(dst_size);
+    uint8_t* expected = malloc(dst_size);
+    int result = src && dst && expected ? 0 : -1;
+    if (result == 0) {
+        test_fill_random(src, src_size, 1);
+        yuyv_to_rgb24_scalar(src, TEST_PARALLEL_WIDTH * 2, expected, TEST_PARALLEL_WIDTH * 3,
+                             TEST_PARALLEL_WIDTH, TEST_PARALLEL_HEIGHT);
+    }
+
+    for (int threads = 1; threads <= 4 && result == 0; ++threads) {
+        worker_pool_t pool;
+        if (worker_pool_init(&pool, threads, false) != 0) {
+            result = -1;
+            break;
+        }
+        memset(dst, 0, dst_size);
+        yuyv_to_rgb24_parallel(&pool, src, TEST_PARALLEL_WIDTH * 2, dst, TEST_PARALLEL_WIDTH * 3,
+                               TEST_PARALLEL_WIDTH, TEST_PARALLEL_HEIGHT);
+        if (memcmp(dst, expected, dst_size) != 0) {
+            fprintf(stderr, "convert: %d threads differ from the scalar kernel\n", threads);
+            result = -1;
+        }
+        worker_pool_fini(&pool);
+    }
+    if (result == 0) {
+        printf("  parallel: 1-4 threads match the scalar kernel\n");
+    }
+
+    free(src);
+    free(dst);
+    free(expected);
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "convert_exact", test_convert_exact },
+    { "convert_parallel", test_convert_parallel },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
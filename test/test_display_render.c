@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "display_render/display_intake.h"
+#include "display_render/display_render.h"
+#include "image_message/image_message.h"
+#include "latency_diagnostics/latency_diagnostics.h"
+
+#include "test_util.h"
+
+#define TEST_RENDER_WIDTH 8
+#define TEST_RENDER_HEIGHT 16
+
+// One stream's mailbox and its three frames, filled like the intake thread
+typedef struct {
+    frame_mailbox_t mailbox;
+    display_frame_t frames[FRAME_MAILBOX_BUFFERS];
+    uint64_t intake_index;
+} test_render_stream_t;
+
+// What the last upload was asked to do
+typedef struct {
+    int calls;
+    int stream;
+    bool partial;
+    int dirty_y;
+    int dirty_height;
+    bool fail;
+} test_render_uploads_t;
+
+static int test_render_upload(void* ctx, int stream, const sensor_msgs__msg__Image* image,
+                              bool partial, int dirty_y, int dirty_height) {
+    test_render_uploads_t* uploads = (test_render_uploads_t*)ctx;
+    uploads->calls++;
+    uploads->stream = stream;
+    uploads->partial = partial;
+    uploads->dirty_y = dirty_y;
+    uploads->dirty_height = dirty_height;
+    return uploads->fail || image->height != TEST_RENDER_HEIGHT ? -1 : 0;
+}
+
+static int test_render_open(test_render_stream_t* stream) {
+    static const uint8_t pixels[TEST_RENDER_WIDTH * 2 * TEST_RENDER_HEIGHT];
+    void* buffers[FRAME_MAILBOX_BUFFERS];
+    memset(stream, 0, sizeof(*stream));
+    for (int b = 0; b < FRAME_MAILBOX_BUFFERS; ++b) {
+        display_frame_t* frame = &stream->frames[b];
+        if (!sensor_msgs__msg__Image__init(&frame->image) ||
+            image_message_fill(&frame->image, pixels, sizeof(pixels), TEST_RENDER_WIDTH,
+                               TEST_RENDER_HEIGHT, TEST_RENDER_WIDTH * 2, "yuv422_yuy2") != 0) {
+            return -1;
+        }
+        buffers[b] = frame;
+    }
+    return frame_mailbox_init(&stream->mailbox, buffers);
+}
+
+static void test_render_close(test_render_stream_t* stream) {
+    frame_mailbox_fini(&stream->mailbox);
+    for (int b = 0; b < FRAME_MAILBOX_BUFFERS; ++b) {
+        sensor_msgs__msg__Image__fini(&stream->frames[b].image);
+    }
+}
+
+// Hand the next frame over with rows [dirty_y, dirty_y + dirty_height) changed
+static void test_render_post(test_render_stream_t* stream, int dirty_y, int dirty_height) {
+    display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&stream->mailbox);
+    frame->index = ++stream->intake_index;
+    frame->dirty_y = dirty_y;
+    frame->dirty_height = dirty_height;
+    frame_mailbox_publish(&stream->mailbox);
+}
+
+// Take once; the upload must be (partial, dirty_y, dirty_height)
+static int test_render_expect(display_render_t* render, test_render_uploads_t* uploads,
+                              const char* what, bool partial, int dirty_y, int dirty_height) {
+    display_frame_t* shown[DISPLAY_MAX_STREAMS];
+    int calls = uploads->calls;
+    int count = display_render_take(render, shown);
+    if (count != 1 || uploads->calls != calls + 1 || uploads->partial != partial ||
+        (partial && (uploads->dirty_y != dirty_y || uploads->dirty_height != dirty_height))) {
+        fprintf(stderr, "display_render: %s: %d shown, %s upload of rows %d+%d "
+                "(expected %s of %d+%d)\n", what, count, uploads->partial ? "partial" : "full",
+                uploads->dirty_y, uploads->dirty_height, partial ? "partial" : "full",
+                dirty_y, dirty_height);
+        return -1;
+    }
+    return 0;
+}
+
+// A frame right after the one in the texture uploads its dirty rows and
+// the texture frame's; a frame after one the renderer never saw, or after
+// a failed upload, uploads everything
+static int test_render_rows(void) {
+    test_render_stream_t stream;
+    if (test_render_open(&stream) != 0) {
+        return -1;
+    }
+    test_render_uploads_t uploads = { 0 };
+    display_render_t render;
+    display_render_init(&render, test_render_upload, &uploads);
+    display_render_add_stream(&render, &stream.mailbox);
+
+    int result = 0;
+    display_frame_t* shown[DISPLAY_MAX_STREAMS];
+    test_render_post(&stream, 0, TEST_RENDER_HEIGHT);
+    result |= display_render_take(&render, shown) != 1;
+    test_render_post(&stream, 4, 2);
+    result |= test_render_expect(&render, &uploads, "after a whole frame", true, 0, TEST_RENDER_HEIGHT);
+    test_render_post(&stream, 8, 2);
+    result |= test_render_expect(&render, &uploads, "moving rows", true, 4, 6);
+    test_render_post(&stream, 8, 2);
+    test_render_post(&stream, 10, 2);   // Overwrites the one before
+    result |= test_render_expect(&render, &uploads, "after an overwritten frame", false, 0, 0);
+
+    // Nothing new: nothing uploaded
+    int calls = uploads.calls;
+    result |= display_render_take(&render, shown) != 0 || uploads.calls != calls;
+
+    uploads.fail = true;
+    test_render_post(&stream, 12, 2);
+    result |= display_render_take(&render, shown) != 0;
+    uploads.fail = false;
+    test_render_post(&stream, 12, 2);
+    result |= test_render_expect(&render, &uploads, "after a failed upload", false, 0, 0);
+    result |= render.streams[0].frames_displayed != 5;
+    if (result) {
+        fprintf(stderr, "display_render: %llu frames counted as shown (expected 5)\n",
+                (unsigned long long)render.streams[0].frames_displayed);
+    } else {
+        printf("  partial uploads cover both frames' rows, gaps and failures upload all\n");
+    }
+    test_render_close(&stream);
+    return result ? -1 : 0;
+}
+
+// Partial uploads never run longer than DISPLAY_FULL_REFRESH frames
+static int test_render_full_refresh(void) {
+    test_render_stream_t stream;
+    if (test_render_open(&stream) != 0) {
+        return -1;
+    }
+    test_render_uploads_t uploads = { 0 };
+    display_render_t render;
+    display_render_init(&render, test_render_upload, &uploads);
+    display_render_add_stream(&render, &stream.mailbox);
+
+    int result = 0, run = 0, longest = 0, full = 0;
+    display_frame_t* shown[DISPLAY_MAX_STREAMS];
+    for (int f = 0; f < 3 * (DISPLAY_FULL_REFRESH + 1) && result == 0; ++f) {
+        test_render_post(&stream, 3, 1);
+        result = display_render_take(&render, shown) == 1 ? 0 : -1;
+        if (f > 0 && uploads.partial) {
+            run++;
+        } else {
+            full++;
+            run = 0;
+        }
+        longest = run > longest ? run : longest;
+    }
+    printf("  %d frames: %llu partial uploads, longest run %d, %d full\n",
+           3 * (DISPLAY_FULL_REFRESH + 1), (unsigned long long)render.streams[0].partial_uploads,
+           longest, full);
+    if (result == 0 && (longest != DISPLAY_FULL_REFRESH || full < 3)) {
+        fprintf(stderr, "display_render: partial uploads ran %d frames (expected %d)\n",
+                longest, DISPLAY_FULL_REFRESH);
+        result = -1;
+    }
+    test_render_close(&stream);
+    return result;
+}
+
+// Only streams with a new frame are uploaded, each into its own index; a
+// pool frame is released once uploaded
+static int test_render_streams(void) {
+    test_render_stream_t streams[2];
+    if (test_render_open(&streams[0]) != 0 || test_render_open(&streams[1]) != 0) {
+        return -1;
+    }
+    frame_pool_t pool;
+    if (frame_pool_init(&pool, 1, 64) != 0) {
+        test_render_close(&streams[0]);
+        test_render_close(&streams[1]);
+        return -1;
+    }
+    test_render_uploads_t uploads = { 0 };
+    display_render_t render;
+    display_render_init(&render, test_render_upload, &uploads);
+    display_render_add_stream(&render, &streams[0].mailbox);
+    display_render_add_stream(&render, &streams[1].mailbox);
+
+    display_frame_t* frame = (display_frame_t*)frame_mailbox_write_buffer(&streams[1].mailbox);
+    frame->pooled = frame_pool_acquire(&pool);
+    test_render_post(&streams[1], 0, TEST_RENDER_HEIGHT);
+
+    display_frame_t* shown[DISPLAY_MAX_STREAMS];
+    int count = display_render_take(&render, shown);
+    frame_pool_frame_t* again = frame_pool_acquire(&pool);
+    int result = count != 1 || shown[0] != frame || uploads.stream != 1 ||
+                 frame->pooled != NULL || again == NULL ? -1 : 0;
+    if (again) {
+        frame_pool_release(again);
+    }
+    if (result) {
+        fprintf(stderr, "display_render: %d streams shown, upload into stream %d, "
+                "pool frame %s\n", count, uploads.stream, again ? "released" : "still held");
+    } else {
+        printf("  only the stream with a frame uploaded, its pool frame released\n");
+    }
+    frame_pool_fini(&pool);
+    test_render_close(&streams[0]);
+    test_render_close(&streams[1]);
+    return result;
+}
+
+// A ring slot is copied out with the descriptor's dirty rows and capture
+// time (the stamp round-trips through the wall clock, so to within 1 ms),
+// and released; a recycled slot is refused
+static int test_intake_ring(void) {
+    static uint8_t pixels[TEST_RENDER_WIDTH * 2 * TEST_RENDER_HEIGHT];
+    char name[64];
+    snprintf(name, sizeof(name), "/test_display_render_%d", (int)getpid());
+    frame_ring_t writer, ring;
+    if (frame_ring_create(&writer, name, 2, sizeof(pixels)) != 0) {
+        return -1;
+    }
+    if (frame_ring_open(&ring, name) != 0) {
+        frame_ring_close(&writer);
+        return -1;
+    }
+    for (size_t i = 0; i < sizeof(pixels); ++i) {
+        pixels[i] = (uint8_t)i;
+    }
+    int slot = frame_ring_begin_write(&writer);
+    memcpy(frame_ring_slot_data(&writer, slot), pixels, sizeof(pixels));
+    frame_ring_frame_info_t info = {
+        .size = sizeof(pixels),
+        .width = TEST_RENDER_WIDTH,
+        .height = TEST_RENDER_HEIGHT,
+        .step = TEST_RENDER_WIDTH * 2,
+        .stamp_ns = 5000000000LL,
+        .encoding = "yuv422_yuy2",
+    };
+    embedded_object_detection_pi5__msg__FrameDescriptor desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.slot = (uint32_t)slot;
+    desc.sequence = frame_ring_commit_write(&writer, slot, &info);
+    latency_stamp_from_monotonic(&desc.header.stamp, info.stamp_ns);
+    desc.dirty_y = 4;
+    desc.dirty_height = 3;
+
+    display_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    int result = sensor_msgs__msg__Image__init(&frame.image) ? 0 : -1;
+    result |= display_intake_copy_ring(&frame, &ring, &desc);
+    const sensor_msgs__msg__Image* image = display_frame_image(&frame);
+    if (result == 0 && (image->height != TEST_RENDER_HEIGHT ||
+                        memcmp(image->data.data, pixels, sizeof(pixels)) != 0 ||
+                        frame.dirty_y != 4 || frame.dirty_height != 3 ||
+                        llabs(frame.capture_ns - info.stamp_ns) > 1000000)) {
+        fprintf(stderr, "display_intake: ring copy of %ux%u, rows %d+%d, captured at %lld\n",
+                image->width, image->height, frame.dirty_y, frame.dirty_height,
+                (long long)frame.capture_ns);
+        result = -1;
+    }
+
+    // Still frames redraw everything
+    desc.still = true;
+    result |= display_intake_copy_ring(&frame, &ring, &desc);
+    result |= frame.dirty_y != 0 || frame.dirty_height != TEST_RENDER_HEIGHT;
+
+    desc.sequence++;
+    if (result == 0 && display_intake_copy_ring(&frame, &ring, &desc) != -1) {
+        fprintf(stderr, "display_intake: a recycled slot was copied\n");
+        result = -1;
+    }
+    if (result == 0) {
+        printf("  slot copied with its dirty rows and capture time, recycled slot refused\n");
+    }
+    sensor_msgs__msg__Image__fini(&frame.image);
+    frame_ring_close(&ring);
+    frame_ring_close(&writer);
+    return result ? -1 : 0;
+}
+
+// A pool frame is shown by pointer with one reference held, and a frame
+// the buffer still held is released
+static int test_intake_pool(void) {
+    frame_pool_t pool;
+    if (frame_pool_init(&pool, 2, 64) != 0) {
+        return -1;
+    }
+    frame_pool_frame_t* first = frame_pool_acquire(&pool);
+    frame_pool_frame_t* second = frame_pool_acquire(&pool);
+    first->width = second->width = 8;
+    first->height = second->height = 4;
+    first->step = second->step = 16;
+    first->size = second->size = 64;
+    first->encoding = second->encoding = "yuv422_yuy2";
+    first->stamp_ns = 1000;
+    second->stamp_ns = 2000;
+    second->dirty_y = 1;
+    second->dirty_height = 2;
+
+    display_frame_t frame;
+    memset(&frame, 0, sizeof(frame));
+    display_intake_pool(&frame, first);
+    frame_pool_release(first);
+    display_intake_pool(&frame, second);
+    frame_pool_release(second);
+
+    // Only second is still held: one frame can be acquired again
+    const sensor_msgs__msg__Image* image = display_frame_image(&frame);
+    frame_pool_frame_t* again = frame_pool_acquire(&pool);
+    int result = image->data.data != second->data || frame.capture_ns != 2000 ||
+                 frame.dirty_y != 1 || frame.dirty_height != 2 || again != first ? -1 : 0;
+    if (result) {
+        fprintf(stderr, "display_intake: pool view %s, rows %d+%d, first frame %s\n",
+                image->data.data == second->data ? "right" : "wrong", frame.dirty_y,
+                frame.dirty_height, again == first ? "released" : "still held");
+    } else {
+        printf("  pool frame shown by pointer, the one it replaced released\n");
+    }
+    if (again) {
+        frame_pool_release(again);
+    }
+    frame_pool_release(frame.pooled);
+    frame_pool_fini(&pool);
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "render_rows", test_render_rows },
+    { "render_full_refresh", test_render_full_refresh },
+    { "render_streams", test_render_streams },
+    { "intake_ring", test_intake_ring },
+    { "intake_pool", test_intake_pool },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
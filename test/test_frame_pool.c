@@ -0,0 +1,120 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "frame_pool/frame_pool.h"
+
+#include "test_util.h"
+
+#define TEST_POOL_THREADS 4
+#define TEST_POOL_ROUNDS 100000
+
+// Every frame acquired is released exactly once and never handed out
+// twice while held; an extra reference keeps a frame out of the pool
+static int test_pool_refs(void) {
+    frame_pool_t pool;
+    if (frame_pool_init(&pool, 4, 64) != 0) {
+        return -1;
+    }
+    frame_pool_frame_t* held[4];
+    int result = 0;
+    for (int i = 0; i < 4; ++i) {
+        held[i] = frame_pool_acquire(&pool);
+        result |= held[i] == NULL;
+    }
+    result |= frame_pool_acquire(&pool) != NULL;
+    frame_pool_ref(held[1]);
+    frame_pool_release(held[1]);
+    result |= frame_pool_acquire(&pool) != NULL;   // Still one reference left
+    frame_pool_release(held[1]);
+    frame_pool_frame_t* again = frame_pool_acquire(&pool);
+    result |= again != held[1];
+    for (int i = 0; i < 4; ++i) {
+        frame_pool_release(held[i]);
+    }
+    uint64_t acquired, exhausted;
+    frame_pool_get_counts(&pool, &acquired, &exhausted);
+    result |= acquired != 5 || exhausted != 2;
+    frame_pool_fini(&pool);
+    if (result) {
+        fprintf(stderr, "frame_pool: reference counting is wrong\n");
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    frame_pool_t* pool;
+    int index;
+    int errors;
+} test_pool_worker_t;
+
+// Hold each frame briefly with an extra reference, like a producer handing
+// it to two consumers; a frame held by this thread must still carry its
+// stamp when released
+static void* test_pool_work(void* arg) {
+    test_pool_worker_t* worker = (test_pool_worker_t*)arg;
+    for (int i = 0; i < TEST_POOL_ROUNDS; ++i) {
+        frame_pool_frame_t* frame = frame_pool_acquire(worker->pool);
+        if (!frame) {
+            continue;
+        }
+        frame->sequence = (uint32_t)(worker->index << 24 | i);
+        frame->data[0] = (uint8_t)worker->index;
+        frame_pool_ref(frame);
+        frame_pool_release(frame);
+        if (frame->sequence != (uint32_t)(worker->index << 24 | i) ||
+            frame->data[0] != (uint8_t)worker->index) {
+            worker->errors++;
+        }
+        frame_pool_release(frame);
+    }
+    return NULL;
+}
+
+// Reference counts under contention: no frame is handed to two threads at
+// once, and every frame is back in the pool at the end
+static int test_pool_threads(void) {
+    frame_pool_t pool;
+    if (frame_pool_init(&pool, 2, 64) != 0) {
+        return -1;
+    }
+    pthread_t threads[TEST_POOL_THREADS];
+    test_pool_worker_t workers[TEST_POOL_THREADS];
+    int started = 0;
+    for (int i = 0; i < TEST_POOL_THREADS; ++i) {
+        workers[i] = (test_pool_worker_t){ &pool, i, 0 };
+        if (pthread_create(&threads[i], NULL, test_pool_work, &workers[i]) == 0) {
+            started++;
+        }
+    }
+    int errors = started == TEST_POOL_THREADS ? 0 : 1;
+    for (int i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+        errors += workers[i].errors;
+    }
+    frame_pool_frame_t* a = frame_pool_acquire(&pool);
+    frame_pool_frame_t* b = frame_pool_acquire(&pool);
+    errors += !a || !b || a == b;
+    uint64_t acquired, exhausted;
+    frame_pool_get_counts(&pool, &acquired, &exhausted);
+    printf("  %d threads: %llu acquired, %llu found the pool exhausted, %d frames shared\n",
+           TEST_POOL_THREADS, (unsigned long long)acquired, (unsigned long long)exhausted, errors);
+    if (a) {
+        frame_pool_release(a);
+    }
+    if (b) {
+        frame_pool_release(b);
+    }
+    frame_pool_fini(&pool);
+    return errors ? -1 : 0;
+}
+
+static const test_case_t g_cases[] = {
+    { "pool_refs", test_pool_refs },
+    { "pool_threads", test_pool_threads },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
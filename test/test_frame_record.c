@@ -0,0 +1,281 @@
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <linux/videodev2.h>
+
+#include "camera_config/camera_config.h"
+#include "frame_record/frame_record.h"
+#include "frame_source/frame_source.h"
+#include "latency_trace/latency_trace.h"
+
+#include "test_util.h"
+
+#define TEST_RECORD_WIDTH 1280
+#define TEST_RECORD_HEIGHT 720
+#define TEST_RECORD_PATTERNS 8      // Distinct frame contents, by sequence
+#define TEST_RECORD_QUEUE_DEPTH 16
+#define TEST_RECORD_FPS 60
+#define TEST_RECORD_FRAMES 30
+
+typedef struct {
+    char dir[200];
+    size_t frame_size;
+    uint8_t* patterns[TEST_RECORD_PATTERNS];
+} test_record_t;
+
+static void test_sleep_us(int us) {
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+static int test_record_init(test_record_t* t) {
+    const char* dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    snprintf(t->dir, sizeof(t->dir), "%s", dir);
+    t->frame_size = (size_t)TEST_RECORD_WIDTH * TEST_RECORD_HEIGHT * 2;
+    int result = 0;
+    for (int i = 0; i < TEST_RECORD_PATTERNS; ++i) {
+        t->patterns[i] = malloc(t->frame_size);
+        if (!t->patterns[i]) {
+            result = -1;
+        } else {
+            test_fill_random(t->patterns[i], t->frame_size, (unsigned)i + 1);
+        }
+    }
+    return result;
+}
+
+static void test_record_fini(test_record_t* t) {
+    for (int i = 0; i < TEST_RECORD_PATTERNS; ++i) {
+        free(t->patterns[i]);
+    }
+}
+
+// Write frames through the recorder at a camera rate and close it
+static int test_record_write(const test_record_t* t, const char* path, frame_recorder_stats_t* stats) {
+    frame_recorder_t recorder;
+    if (frame_recorder_open(&recorder, path, V4L2_PIX_FMT_YUYV, TEST_RECORD_WIDTH, TEST_RECORD_HEIGHT,
+                            TEST_RECORD_WIDTH * 2, TEST_RECORD_FPS, t->frame_size,
+                            TEST_RECORD_QUEUE_DEPTH) != 0) {
+        return -1;
+    }
+    long long start = test_now_ns();
+    for (int i = 0; i < TEST_RECORD_FRAMES; ++i) {
+        long long due = start + (long long)i * 1000000000LL / TEST_RECORD_FPS;
+        long long now = test_now_ns();
+        if (due > now) {
+            test_sleep_us((int)((due - now) / 1000));
+        }
+        frame_recorder_write(&recorder, t->patterns[i % TEST_RECORD_PATTERNS], t->frame_size,
+                             (uint32_t)i, latency_monotonic_ns());
+    }
+    return frame_recorder_close(&recorder, stats);
+}
+
+// Every recorded frame must be the pattern its sequence selects, in order
+static int test_record_check_player(const frame_record_player_t* player, uint8_t* const* patterns,
+                                     size_t frame_size, size_t expected) {
+    if (player->view.count != expected) {
+        fprintf(stderr, "record: %zu frames in the recording, %zu written\n", player->view.count, expected);
+        return -1;
+    }
+    for (size_t i = 0; i < player->view.count; ++i) {
+        const frame_record_entry_t* entry;
+        const uint8_t* data = frame_record_player_frame(player, i, &entry);
+        if (entry->size != frame_size || entry->fourcc != V4L2_PIX_FMT_YUYV ||
+            (i > 0 && entry->sequence <= player->view.index[i - 1].sequence) ||
+            ((uintptr_t)data & (FRAME_RECORD_FRAME_ALIGN - 1)) != 0 ||
+            memcmp(data, patterns[entry->sequence % TEST_RECORD_PATTERNS], frame_size) != 0) {
+            fprintf(stderr, "record: frame %zu (sequence %u) differs from what was written\n",
+                    i, entry->sequence);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Binary search against a linear scan at random times around the recording
+static int test_record_check_seek(const frame_record_player_t* player) {
+    const frame_record_view_t* view = &player->view;
+    int64_t first = view->index[0].stamp_ns;
+    int64_t span = view->index[view->count - 1].stamp_ns - first;
+    int64_t stamps[256];
+    unsigned seed = 7;
+    for (int i = 0; i < 256; ++i) {
+        stamps[i] = first - span / 10 + (int64_t)(test_random_unit(&seed) * span * 1.2);
+    }
+    for (int i = 0; i < 256; ++i) {
+        size_t linear = 0;
+        while (linear < view->count && view->index[linear].stamp_ns < stamps[i]) {
+            linear++;
+        }
+        if (frame_record_player_seek(player, stamps[i]) != linear) {
+            fprintf(stderr, "record: seek to %lld lands on the wrong frame\n", (long long)stamps[i]);
+            return -1;
+        }
+    }
+
+    printf("  seek: 256 times around the recording land where a linear scan does\n");
+    return 0;
+}
+
+// Clear the index offset as if the recorder never closed the file
+static int test_record_drop_index(const char* path) {
+    int fd = open(path, O_WRONLY);
+    if (fd == -1) {
+        return -1;
+    }
+    uint64_t zero = 0;
+    ssize_t n = pwrite(fd, &zero, sizeof(zero), offsetof(frame_record_header_t, index_offset));
+    close(fd);
+    return n == (ssize_t)sizeof(zero) ? 0 : -1;
+}
+
+// Open a recording while its writer is still busy, as a crash would leave
+// it: one chunk on disk, the frame that straddles it cut off. Only whole
+// frames may be recovered; space reserved ahead of the data must not pass
+// for frames.
+static int test_record_unclosed(void) {
+    test_record_t t;
+    if (test_record_init(&t) != 0) {
+        test_record_fini(&t);
+        return -1;
+    }
+    uint8_t* const* patterns = t.patterns;
+    size_t frame_size = t.frame_size;
+    char path[256];
+    snprintf(path, sizeof(path), "%s/test_record_%d_cut.rec", t.dir, (int)getpid());
+    frame_recorder_t recorder;
+    if (frame_recorder_open(&recorder, path, V4L2_PIX_FMT_YUYV, TEST_RECORD_WIDTH, TEST_RECORD_HEIGHT,
+                            TEST_RECORD_WIDTH * 2, TEST_RECORD_FPS, frame_size,
+                            TEST_RECORD_QUEUE_DEPTH) != 0) {
+        test_record_fini(&t);
+        return -1;
+    }
+    size_t stride = sizeof(frame_record_frame_t) + frame_size;
+    int frames = (int)((FRAME_RECORD_CHUNK_SIZE - FRAME_RECORD_ALIGN) / stride) + 1;
+    for (int i = 0; i < frames; ++i) {
+        frame_recorder_write(&recorder, patterns[i % TEST_RECORD_PATTERNS], frame_size,
+                             (uint32_t)i, latency_monotonic_ns());
+    }
+    long long deadline = test_now_ns() + 2000000000LL;
+    while (__atomic_load_n(&recorder.bytes, __ATOMIC_RELAXED) < FRAME_RECORD_CHUNK_SIZE &&
+           test_now_ns() < deadline) {
+        test_sleep_us(1000);
+    }
+
+    struct stat st;
+    frame_record_player_t player;
+    int result = stat(path, &st) == 0 && frame_record_player_open(&player, path) == 0 ? 0 : -1;
+    if (result == 0) {
+        printf("  while recording: %lld bytes on disk, %zu of %d frames recovered\n",
+               (long long)st.st_size, player.view.count, frames);
+        result = test_record_check_player(&player, patterns, frame_size, (size_t)frames - 1);
+        frame_record_player_close(&player);
+    }
+    frame_recorder_stats_t stats;
+    if (frame_recorder_close(&recorder, &stats) != 0) {
+        result = -1;
+    }
+    unlink(path);
+    if (result != 0) {
+        fprintf(stderr, "record: unfinished recording recovered a frame that was not written\n");
+    }
+    test_record_fini(&t);
+    return result;
+}
+
+
+// A closed recording plays back frame for frame and seeks by time; with its
+// index cleared, as if the recorder never closed it, it still plays by
+// scanning; camera_node's file source replays it as captured
+static int test_record_playback(void) {
+    test_record_t t;
+    if (test_record_init(&t) != 0) {
+        test_record_fini(&t);
+        return -1;
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s/test_record_%d.rec", t.dir, (int)getpid());
+
+    frame_recorder_stats_t stats;
+    frame_record_player_t player;
+    int result = test_record_write(&t, path, &stats);
+    if (result == 0) {
+        printf("  recorded %llu of %d frames at %d fps\n", (unsigned long long)stats.frames,
+               TEST_RECORD_FRAMES, TEST_RECORD_FPS);
+        result = frame_record_player_open(&player, path);
+        if (result == 0) {
+            result = test_record_check_player(&player, t.patterns, t.frame_size, stats.frames);
+            if (result == 0) {
+                result = test_record_check_seek(&player);
+            }
+            frame_record_player_close(&player);
+        }
+    }
+
+    if (result == 0) {
+        result = test_record_drop_index(path) == 0 ? frame_record_player_open(&player, path) : -1;
+        if (result == 0) {
+            result = test_record_check_player(&player, t.patterns, t.frame_size, stats.frames);
+            if (result == 0 && !player.view.recovered) {
+                result = -1;
+            }
+            printf("  without index: %zu frames recovered by scanning\n", player.view.count);
+            frame_record_player_close(&player);
+        }
+        if (result != 0) {
+            fprintf(stderr, "record: recording without index did not play back\n");
+        }
+    }
+
+    if (result == 0) {
+        camera_config_t config;
+        camera_config_init(&config, "", 0, 0, TEST_RECORD_FPS, 80, 15);
+        config.source = CAMERA_SOURCE_FILE;
+        config.realtime = false;
+        snprintf(config.file, sizeof(config.file), "%s", path);
+        frame_source_t source;
+        result = frame_record_player_open(&player, path);
+        if (result == 0) {
+            result = frame_source_open(&source, &config);
+            if (result == 0) {
+                if (source.mode.format->fourcc != V4L2_PIX_FMT_YUYV ||
+                    source.mode.width != TEST_RECORD_WIDTH || source.mode.height != TEST_RECORD_HEIGHT ||
+                    source.mode.sizeimage != t.frame_size) {
+                    result = -1;
+                }
+                for (size_t i = 0; i < player.view.count && result == 0; ++i) {
+                    frame_source_frame_t frame;
+                    if (frame_source_next(&source, &frame) != 1 || frame.size != t.frame_size ||
+                        memcmp(frame.data, frame_record_player_frame(&player, i, NULL),
+                               t.frame_size) != 0) {
+                        result = -1;
+                    }
+                }
+                frame_source_close(&source);
+            }
+            frame_record_player_close(&player);
+        }
+        if (result != 0) {
+            fprintf(stderr, "record: the file source does not replay the recording\n");
+        }
+    }
+
+    unlink(path);
+    test_record_fini(&t);
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "record_playback", test_record_playback },
+    { "record_unclosed", test_record_unclosed },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
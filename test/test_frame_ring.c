@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "frame_ring/frame_ring.h"
+
+#include "test_util.h"
+
+#define TEST_RING_SLOTS 4
+#define TEST_RING_SLOT_SIZE 4096
+
+static void test_ring_name(char* name, size_t size, const char* what) {
+    snprintf(name, size, "/test_frame_ring_%d_%s", (int)getpid(), what);
+}
+
+// Write one frame whose first byte is its sequence; returns the slot or -1
+static int test_ring_write(frame_ring_t* ring, uint64_t* sequence) {
+    static const frame_ring_frame_info_t info = { 16, 4, 2, 8, 0, "yuyv" };
+    int slot = frame_ring_begin_write(ring);
+    if (slot < 0) {
+        return -1;
+    }
+    uint8_t* data = frame_ring_slot_data(ring, slot);
+    memset(data, 0, info.size);
+    data[0] = (uint8_t)ring->header->next_sequence;
+    *sequence = frame_ring_commit_write(ring, slot, &info);
+    return slot;
+}
+
+// A reader sees what was committed; once the slot is recycled its old
+// sequence no longer acquires
+static int test_ring_read(void) {
+    char name[64];
+    test_ring_name(name, sizeof(name), "read");
+    frame_ring_t writer, reader;
+    if (frame_ring_create(&writer, name, TEST_RING_SLOTS, TEST_RING_SLOT_SIZE) != 0) {
+        return -1;
+    }
+    if (frame_ring_open(&reader, name) != 0) {
+        frame_ring_close(&writer);
+        return -1;
+    }
+
+    int result = 0;
+    uint64_t sequence;
+    int slot = test_ring_write(&writer, &sequence);
+    frame_ring_view_t view;
+    if (slot < 0 || frame_ring_acquire(&reader, (uint32_t)slot, sequence, &view) != 0 ||
+        view.size != 16 || view.width != 4 || view.height != 2 || view.step != 8 ||
+        strcmp(view.encoding, "yuyv") != 0 || view.data[0] != (uint8_t)sequence) {
+        fprintf(stderr, "frame_ring: committed frame reads back wrong\n");
+        result = -1;
+    } else {
+        frame_ring_release(&reader, (uint32_t)slot);
+    }
+
+    // Go round the ring once: the first slot now holds a newer frame
+    for (int i = 0; i < TEST_RING_SLOTS && result == 0; ++i) {
+        uint64_t newer;
+        result = test_ring_write(&writer, &newer) < 0 ? -1 : 0;
+    }
+    if (result == 0 && frame_ring_acquire(&reader, (uint32_t)slot, sequence, &view) == 0) {
+        fprintf(stderr, "frame_ring: recycled slot acquired with its old sequence\n");
+        result = -1;
+    }
+    if (result == 0) {
+        printf("  committed frame read in place, recycled slot refused\n");
+    }
+
+    frame_ring_close(&reader);
+    frame_ring_close(&writer);
+    return result;
+}
+
+// A live reader's pin is respected: the writer skips the slot, and drops
+// frames rather than wait when every slot is pinned
+static int test_ring_pins(void) {
+    char name[64];
+    test_ring_name(name, sizeof(name), "pins");
+    frame_ring_t writer, reader;
+    if (frame_ring_create(&writer, name, TEST_RING_SLOTS, TEST_RING_SLOT_SIZE) != 0) {
+        return -1;
+    }
+    if (frame_ring_open(&reader, name) != 0) {
+        frame_ring_close(&writer);
+        return -1;
+    }
+
+    int result = 0;
+    int slots[TEST_RING_SLOTS];
+    uint64_t sequences[TEST_RING_SLOTS];
+    frame_ring_view_t view;
+    for (int i = 0; i < TEST_RING_SLOTS && result == 0; ++i) {
+        slots[i] = test_ring_write(&writer, &sequences[i]);
+        if (slots[i] < 0 || frame_ring_acquire(&reader, (uint32_t)slots[i], sequences[i], &view) != 0) {
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        // Everything pinned: the write is dropped, nothing is reclaimed
+        uint64_t sequence;
+        if (test_ring_write(&writer, &sequence) >= 0 || writer.reclaimed != 0) {
+            fprintf(stderr, "frame_ring: a live reader's pin was overwritten\n");
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        // One slot free again: every write lands there
+        frame_ring_release(&reader, (uint32_t)slots[1]);
+        for (int i = 0; i < 2 * FRAME_RING_RECLAIM_INTERVAL && result == 0; ++i) {
+            uint64_t sequence;
+            if (test_ring_write(&writer, &sequence) != slots[1]) {
+                fprintf(stderr, "frame_ring: write went to a pinned slot\n");
+                result = -1;
+            }
+        }
+    }
+    if (result == 0) {
+        printf("  pinned slots skipped, frame dropped while all are pinned\n");
+    }
+
+    frame_ring_close(&reader);
+    frame_ring_close(&writer);
+    return result;
+}
+
+// Readers killed while they hold slots must not take them away for good:
+// the writer clears their leases and writes on
+static int test_ring_dead_readers(void) {
+    char name[64];
+    test_ring_name(name, sizeof(name), "dead");
+    frame_ring_t writer, reader;
+    if (frame_ring_create(&writer, name, TEST_RING_SLOTS, TEST_RING_SLOT_SIZE) != 0) {
+        return -1;
+    }
+    if (frame_ring_open(&reader, name) != 0) {
+        frame_ring_close(&writer);
+        return -1;
+    }
+
+    // This process pins one slot, three children pin one each and exit
+    int result = 0;
+    uint64_t sequence;
+    frame_ring_view_t view;
+    int live = test_ring_write(&writer, &sequence);
+    if (live < 0 || frame_ring_acquire(&reader, (uint32_t)live, sequence, &view) != 0) {
+        result = -1;
+    }
+    for (int c = 0; c < TEST_RING_SLOTS - 1 && result == 0; ++c) {
+        int slot = test_ring_write(&writer, &sequence);
+        pid_t pid = slot < 0 ? -1 : fork();
+        if (pid == 0) {
+            frame_ring_t child;
+            _exit(frame_ring_open(&child, name) != 0 ||
+                  frame_ring_acquire(&child, (uint32_t)slot, sequence, &view) != 0);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+            result = -1;
+        }
+    }
+
+    int dropped = 0, on_live = 0;
+    for (int i = 0; i < 100 && result == 0; ++i) {
+        int slot = test_ring_write(&writer, &sequence);
+        dropped += slot < 0;
+        on_live += slot == live;
+    }
+    printf("  %d dead readers: %llu leases reclaimed, %d of 100 writes dropped\n",
+           TEST_RING_SLOTS - 1, (unsigned long long)writer.reclaimed, dropped);
+    if (result == 0 && (dropped || on_live || writer.reclaimed != TEST_RING_SLOTS - 1)) {
+        fprintf(stderr, "frame_ring: dead readers' slots were not reclaimed correctly\n");
+        result = -1;
+    }
+
+    frame_ring_close(&reader);
+    frame_ring_close(&writer);
+    return result;
+}
+
+// More readers than leases: a reader that died frees its lease for the
+// next one to open
+static int test_ring_leases(void) {
+    char name[64];
+    test_ring_name(name, sizeof(name), "leases");
+    frame_ring_t writer;
+    if (frame_ring_create(&writer, name, TEST_RING_SLOTS, TEST_RING_SLOT_SIZE) != 0) {
+        return -1;
+    }
+
+    // Children take every lease and exit without closing
+    int result = 0;
+    for (int c = 0; c < FRAME_RING_MAX_READERS && result == 0; ++c) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            frame_ring_t child;
+            _exit(frame_ring_open(&child, name) != 0);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != 0) {
+            result = -1;
+        }
+    }
+
+    frame_ring_t readers[FRAME_RING_MAX_READERS];
+    int opened = 0;
+    while (result == 0 && opened < FRAME_RING_MAX_READERS) {
+        if (frame_ring_open(&readers[opened], name) != 0) {
+            break;
+        }
+        opened++;
+    }
+    frame_ring_t extra;
+    bool refused = opened == FRAME_RING_MAX_READERS && frame_ring_open(&extra, name) != 0;
+    printf("  %d leases of dead readers reused, reader %d refused\n", opened,
+           FRAME_RING_MAX_READERS + 1);
+    if (result == 0 && (opened != FRAME_RING_MAX_READERS || !refused)) {
+        fprintf(stderr, "frame_ring: leases of dead readers were not reused\n");
+        result = -1;
+    }
+
+    for (int i = 0; i < opened; ++i) {
+        frame_ring_close(&readers[i]);
+    }
+    frame_ring_close(&writer);
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "ring_read", test_ring_read },
+    { "ring_pins", test_ring_pins },
+    { "ring_dead_readers", test_ring_dead_readers },
+    { "ring_leases", test_ring_leases },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
@@ -0,0 +1,215 @@
+#include <math.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include "camera_config/camera_config.h"
+#include "frame_source/frame_source.h"
+#include "jpeg_encoder/jpeg_encoder.h"
+
+#include "test_util.h"
+
+#define TEST_SOURCE_FILE_FRAMES 30
+#define TEST_SOURCE_PACED_FPS 200
+#define TEST_SOURCE_PACED_MS 300
+#define TEST_SOURCE_WIDTH 640
+#define TEST_SOURCE_HEIGHT 480
+
+// Test file frame i: random bytes, or the same JPEG every time
+static void test_source_expected(int i, uint8_t* data, size_t size) {
+    test_fill_random(data, size, (unsigned)i + 1);
+}
+
+static int test_source_write_files(const char* y4m, const char* raw, const char* mjpeg,
+                                    int width, int height, const uint8_t* jpeg, size_t jpeg_size) {
+    size_t i420_size = (size_t)width * height * 3 / 2;
+    size_t yuyv_size = (size_t)width * height * 2;
+    uint8_t* frame = malloc(yuyv_size);
+    FILE* y4m_file = fopen(y4m, "wb");
+    FILE* raw_file = fopen(raw, "wb");
+    FILE* mjpeg_file = fopen(mjpeg, "wb");
+    int result = frame && y4m_file && raw_file && mjpeg_file ? 0 : -1;
+
+    if (result == 0) {
+        fprintf(y4m_file, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg\n", width, height);
+        for (int i = 0; i < TEST_SOURCE_FILE_FRAMES; ++i) {
+            test_source_expected(i, frame, i420_size);
+            fprintf(y4m_file, i % 2 ? "FRAME Ixyz\n" : "FRAME\n");  // Parameters are skipped
+            fwrite(frame, 1, i420_size, y4m_file);
+            test_source_expected(i, frame, yuyv_size);
+            fwrite(frame, 1, yuyv_size, raw_file);
+            fwrite(jpeg, 1, jpeg_size, mjpeg_file);
+        }
+    }
+    if (y4m_file && fclose(y4m_file) != 0) {
+        result = -1;
+    }
+    if (raw_file && fclose(raw_file) != 0) {
+        result = -1;
+    }
+    if (mjpeg_file && fclose(mjpeg_file) != 0) {
+        result = -1;
+    }
+    free(frame);
+    return result;
+}
+
+// Replay the file twice over and compare every frame with what was written;
+// the second pass must hand out the same mapped bytes as the first
+static int test_source_check_file(const camera_config_t* config, const char* label,
+                                   const uint8_t* jpeg, size_t jpeg_size) {
+    frame_source_t source;
+    if (frame_source_open(&source, config) != 0 || frame_source_start(&source) != 0) {
+        fprintf(stderr, "frame_source: cannot replay %s\n", label);
+        return -1;
+    }
+    uint8_t* expected = malloc(source.mode.sizeimage);
+    const uint8_t* first_pass[TEST_SOURCE_FILE_FRAMES];
+    int result = expected ? 0 : -1;
+    for (int i = 0; i < 2 * TEST_SOURCE_FILE_FRAMES && result == 0; ++i) {
+        frame_source_frame_t frame;
+        if (frame_source_next(&source, &frame) != 1 || !frame.borrowed || frame.sequence != (uint32_t)i) {
+            result = -1;
+            break;
+        }
+        int n = i % TEST_SOURCE_FILE_FRAMES;
+        if (jpeg) {
+            if (frame.size != jpeg_size || memcmp(frame.data, jpeg, jpeg_size) != 0) {
+                result = -1;
+            }
+        } else {
+            test_source_expected(n, expected, source.mode.sizeimage);
+            if (frame.size != source.mode.sizeimage || memcmp(frame.data, expected, frame.size) != 0) {
+                result = -1;
+            }
+        }
+        if (i < TEST_SOURCE_FILE_FRAMES) {
+            first_pass[n] = frame.data;
+        } else if (first_pass[n] != frame.data) {
+            result = -1;
+        }
+    }
+    if (result != 0) {
+        fprintf(stderr, "frame_source: %s replay differs from the file\n", label);
+    }
+    free(expected);
+    frame_source_close(&source);
+    return result;
+}
+
+// One JPEG for every frame of the MJPEG file, from the encoder the
+// compressed topic uses
+static uint8_t* test_source_make_jpeg(int width, int height, size_t* size) {
+    jpeg_encoder_t encoder;
+    uint8_t* rgb = malloc((size_t)width * height * 3);
+    uint8_t* copy = NULL;
+    if (rgb && jpeg_encoder_init(&encoder, 80) == 0) {
+        test_fill_random(rgb, (size_t)width * height * 3, 3);
+        const uint8_t* jpeg;
+        if (jpeg_encoder_encode(&encoder, rgb, "rgb8", (uint32_t)width, (uint32_t)height,
+                                (uint32_t)width * 3, &jpeg, size) == 0 &&
+            (copy = malloc(*size)) != NULL) {
+            memcpy(copy, jpeg, *size);
+        }
+        jpeg_encoder_fini(&encoder);
+    }
+    free(rgb);
+    return copy;
+}
+
+// A recording in every container replays frame for frame, twice over
+static int test_source_files(void) {
+    const int width = TEST_SOURCE_WIDTH, height = TEST_SOURCE_HEIGHT;
+    const char* dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    char y4m[256], raw[256], mjpeg[256];
+    snprintf(y4m, sizeof(y4m), "%s/test_source_%d.y4m", dir, (int)getpid());
+    snprintf(raw, sizeof(raw), "%s/test_source_%d.yuyv", dir, (int)getpid());
+    snprintf(mjpeg, sizeof(mjpeg), "%s/test_source_%d.mjpeg", dir, (int)getpid());
+    size_t jpeg_size = 0;
+    uint8_t* jpeg = test_source_make_jpeg(width, height, &jpeg_size);
+    int result = 0;
+    if (!jpeg || test_source_write_files(y4m, raw, mjpeg, width, height, jpeg, jpeg_size) != 0) {
+        fprintf(stderr, "frame_source: cannot write test files to %s\n", dir);
+        result = -1;
+    }
+
+    const struct {
+        const char* label;
+        const char* path;
+        uint32_t format;        // Needed for raw files only
+        bool jpeg;
+    } files[] = {
+        { "y4m", y4m, 0, false },
+        { "raw-yuyv", raw, V4L2_PIX_FMT_YUYV, false },
+        { "mjpeg", mjpeg, 0, true },
+    };
+    for (size_t f = 0; f < sizeof(files) / sizeof(files[0]) && result == 0; ++f) {
+        camera_config_t config;
+        camera_config_init(&config, "", (uint32_t)width, (uint32_t)height, 30, 80, 15);
+        config.source = CAMERA_SOURCE_FILE;
+        config.realtime = false;
+        config.pixel_format = files[f].format;
+        snprintf(config.file, sizeof(config.file), "%s", files[f].path);
+        result = test_source_check_file(&config, files[f].label,
+                                        files[f].jpeg ? jpeg : NULL, jpeg_size);
+        if (result == 0) {
+            printf("  %s: %d frames replayed twice, mapped bytes reused\n", files[f].label,
+                   TEST_SOURCE_FILE_FRAMES);
+        }
+    }
+    unlink(y4m);
+    unlink(raw);
+    unlink(mjpeg);
+    free(jpeg);
+    return result;
+}
+
+// Realtime synthetic source: sequence numbers must follow the clock, even
+// if this thread falls behind and frames are skipped
+static int test_source_pacing(void) {
+    camera_config_t config;
+    camera_config_init(&config, "", 320, 240, TEST_SOURCE_PACED_FPS, 80, 15);
+    config.source = CAMERA_SOURCE_SYNTHETIC;
+    frame_source_t source;
+    if (frame_source_open(&source, &config) != 0 || frame_source_start(&source) != 0) {
+        return -1;
+    }
+
+    struct pollfd pfd = { .fd = source.fd, .events = POLLIN };
+    long long start = test_now_ns();
+    int received = 0;
+    uint32_t last = 0;
+    while (test_now_ns() - start < TEST_SOURCE_PACED_MS * 1000000LL) {
+        poll(&pfd, 1, 100);
+        frame_source_frame_t frame;
+        while (frame_source_next(&source, &frame) == 1) {
+            last = frame.sequence;
+            received++;
+        }
+    }
+    double elapsed = (test_now_ns() - start) / 1e9;
+    double expected = elapsed * TEST_SOURCE_PACED_FPS;
+    double drift = (double)last + 1.0 - expected;
+    printf("  realtime %d fps: %d frames in %.3f s, sequence %+.1f frames off the clock, %llu skipped\n",
+           TEST_SOURCE_PACED_FPS, received, elapsed, drift, (unsigned long long)source.drops);
+    frame_source_close(&source);
+
+    if (received == 0 || fabs(drift) > 3.0) {
+        fprintf(stderr, "frame_source: realtime pacing is off by %.1f frames\n", drift);
+        return -1;
+    }
+    return 0;
+}
+
+static const test_case_t g_cases[] = {
+    { "source_files", test_source_files },
+    { "source_pacing", test_source_pacing },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
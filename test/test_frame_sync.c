@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "frame_sync/frame_sync.h"
+
+#include "test_util.h"
+
+#define TEST_SYNC_CAMERAS 4
+#define TEST_SYNC_FPS 30
+#define TEST_SYNC_FRAMES 300
+#define TEST_SYNC_DROP_EVERY 10   // Camera 2 drops every Nth frame
+
+// Feed frames captured at f * interval + offsets[c] +- jitter, camera
+// 2 missing every TEST_SYNC_DROP_EVERY-th; every set must hold frame f
+// of each camera. Returns the sets formed, -1 if one was mixed up.
+static long long test_sync_feed(frame_sync_t* sync, const int64_t* offsets, bool drops) {
+    const int64_t interval = 1000000000LL / TEST_SYNC_FPS;
+    unsigned seed = 11;
+    for (int f = 0; f < TEST_SYNC_FRAMES; ++f) {
+        for (int c = 0; c < TEST_SYNC_CAMERAS; ++c) {
+            if (drops && c == 2 && f % TEST_SYNC_DROP_EVERY == TEST_SYNC_DROP_EVERY - 1) {
+                continue;
+            }
+            int64_t jitter = (int64_t)((test_random_unit(&seed) - 0.5f) * 2e6f);
+            frame_sync_set_t set;
+            if (!frame_sync_add(sync, c, (uint32_t)f, f * interval + offsets[c] + jitter, &set)) {
+                continue;
+            }
+            for (int k = 0; k < TEST_SYNC_CAMERAS; ++k) {
+                if (set.frames[k].sequence != (uint32_t)f) {
+                    fprintf(stderr, "frame_sync: set of frame %d holds frame %u of camera %d\n",
+                            f, set.frames[k].sequence, k);
+                    return -1;
+                }
+            }
+        }
+    }
+    return (long long)sync->sets;
+}
+
+// Phase offsets and jitter within the tolerance still pair frame f with
+// frame f; a set with a camera's frame missing is never formed
+static int test_sync_sets(void) {
+    const int64_t interval = 1000000000LL / TEST_SYNC_FPS;
+    const int64_t in_step[TEST_SYNC_CAMERAS] = { 0, 3000000, 7000000, 11000000 };
+    long long expected = TEST_SYNC_FRAMES - TEST_SYNC_FRAMES / TEST_SYNC_DROP_EVERY;
+
+    frame_sync_t sync;
+    if (frame_sync_init(&sync, TEST_SYNC_CAMERAS, interval / 2) != 0) {
+        return -1;
+    }
+    long long sets = test_sync_feed(&sync, in_step, true);
+    printf("  %lld sets of %d frames, camera 2 dropping every %dth, widest spread %.1f ms\n",
+           sets, TEST_SYNC_FRAMES, TEST_SYNC_DROP_EVERY, sync.max_spread_ns / 1e6);
+    if (sets != expected) {
+        fprintf(stderr, "frame_sync: %lld sets (expected %lld)\n", sets, expected);
+        return -1;
+    }
+    return 0;
+}
+
+// A 5 ms tolerance cannot pair a camera 20 ms behind the others
+static int test_sync_out_of_step(void) {
+    const int64_t out_of_step[TEST_SYNC_CAMERAS] = { 0, 1000000, 2000000, 20000000 };
+
+    frame_sync_t sync;
+    if (frame_sync_init(&sync, TEST_SYNC_CAMERAS, 5000000) != 0) {
+        return -1;
+    }
+    long long stray = test_sync_feed(&sync, out_of_step, false);
+    printf("  %lld sets with one camera out of step\n", stray);
+    if (stray != 0) {
+        fprintf(stderr, "frame_sync: %lld sets formed with a camera out of step\n", stray);
+        return -1;
+    }
+    return 0;
+}
+
+static const test_case_t g_cases[] = {
+    { "sync_sets", test_sync_sets },
+    { "sync_out_of_step", test_sync_out_of_step },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
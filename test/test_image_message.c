@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rcl/rcl.h>
+#include <rmw/rmw.h>
+#include <rmw/serialized_message.h>
+#include <rosidl_runtime_c/primitives_sequence_functions.h>
+#include <rosidl_runtime_c/string_functions.h>
+#include <sensor_msgs/msg/image.h>
+#include <embedded_object_detection_pi5/msg/frame_descriptor.h>
+
+#include "image_message/image_message.h"
+#include "image_message/image_message_cdr.h"
+
+#include "test_util.h"
+
+// Refilling the camera's message in place must leave exactly the new frame
+// and its geometry, also when frames shrink and grow again
+static int test_message_fill(void) {
+    static const struct {
+        uint32_t width;
+        uint32_t height;
+    } sizes[] = { { 640, 480 }, { 320, 240 }, { 1280, 720 }, { 640, 480 } };
+    sensor_msgs__msg__Image* msg = sensor_msgs__msg__Image__create();
+    uint8_t* frame = malloc((size_t)1280 * 720 * 2);
+    int result = msg && frame ? 0 : -1;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && result == 0; ++i) {
+        uint32_t step = sizes[i].width * 2;
+        size_t size = (size_t)step * sizes[i].height;
+        test_fill_random(frame, size, (unsigned)i + 5);
+        if (image_message_fill(msg, frame, size, sizes[i].width, sizes[i].height, step,
+                               "yuv422_yuy2") != 0 ||
+            msg->width != sizes[i].width || msg->height != sizes[i].height || msg->step != step ||
+            strcmp(msg->encoding.data, "yuv422_yuy2") != 0 ||
+            msg->data.size != size || memcmp(msg->data.data, frame, size) != 0) {
+            fprintf(stderr, "image_message: fill %zu (%ux%u) is wrong\n", i, sizes[i].width,
+                    sizes[i].height);
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        printf("  refilled %zu frames of changing size\n", sizeof(sizes) / sizeof(sizes[0]));
+    }
+    free(frame);
+    if (msg) {
+        sensor_msgs__msg__Image__destroy(msg);
+    }
+    return result;
+}
+
+// The hand-written CDR reader against what the middleware really writes:
+// rmw_serialize an Image and a FrameDescriptor, read them back with
+// image_message_cdr_view / _read_descriptor and compare every field.
+// String lengths and frame sizes vary so each field lands at every
+// alignment the padding rules produce.
+#define TEST_CDR_VARIANTS 8
+#define TEST_CDR_CUT 4         // More than the RMW's tail padding, so a field is cut
+
+static int test_cdr_check_image(rmw_serialized_message_t* serialized, int variant) {
+    static const char* const frame_ids[] = { "", "c", "cam", "camera", "camera_frame_7" };
+    static const char* const encodings[] = { "yuv422_yuy2", "rgb8", "mono8", "bgr8a", "yuyv" };
+    const size_t id_count = sizeof(frame_ids) / sizeof(frame_ids[0]);
+    const size_t encoding_count = sizeof(encodings) / sizeof(encodings[0]);
+    sensor_msgs__msg__Image* msg = sensor_msgs__msg__Image__create();
+    if (!msg) {
+        return -1;
+    }
+
+    int result = -1;
+    uint32_t width = 17 + (uint32_t)variant * 3;
+    uint32_t height = 5 + (uint32_t)variant;
+    uint32_t step = width * 2 + (uint32_t)(variant % 3);
+    size_t size = (size_t)step * height;
+    if (rosidl_runtime_c__String__assign(&msg->header.frame_id, frame_ids[variant % id_count]) &&
+        rosidl_runtime_c__String__assign(&msg->encoding, encodings[variant % encoding_count]) &&
+        rosidl_runtime_c__uint8__Sequence__init(&msg->data, size)) {
+        msg->header.stamp.sec = 1000 + variant;
+        msg->header.stamp.nanosec = 999999000u + (uint32_t)variant;
+        msg->width = width;
+        msg->height = height;
+        msg->step = step;
+        msg->is_bigendian = (uint8_t)(variant & 1);
+        test_fill_random(msg->data.data, size, 29 + variant);
+
+        sensor_msgs__msg__Image view;
+        if (rmw_serialize(msg, ROSIDL_GET_MSG_TYPE_SUPPORT(sensor_msgs, msg, Image),
+                          serialized) != RMW_RET_OK) {
+            fprintf(stderr, "cdr: rmw_serialize failed for an image\n");
+        } else if (image_message_cdr_view(serialized->buffer, serialized->buffer_length, &view) != 0 ||
+                   view.header.stamp.sec != msg->header.stamp.sec ||
+                   view.header.stamp.nanosec != msg->header.stamp.nanosec ||
+                   strcmp(view.header.frame_id.data, msg->header.frame_id.data) != 0 ||
+                   view.width != width || view.height != height || view.step != step ||
+                   view.is_bigendian != msg->is_bigendian ||
+                   strcmp(view.encoding.data, msg->encoding.data) != 0 ||
+                   view.data.size != size || memcmp(view.data.data, msg->data.data, size) != 0) {
+            fprintf(stderr, "cdr: serialized image %d read back wrong\n", variant);
+        } else if (image_message_cdr_view(serialized->buffer,
+                                          serialized->buffer_length - TEST_CDR_CUT, &view) == 0) {
+            fprintf(stderr, "cdr: truncated image %d accepted\n", variant);
+        } else {
+            result = 0;
+        }
+    }
+    sensor_msgs__msg__Image__destroy(msg);
+    return result;
+}
+
+static int test_cdr_check_descriptor(rmw_serialized_message_t* serialized, int variant,
+                                          embedded_object_detection_pi5__msg__FrameDescriptor* read) {
+    static const char* const ring_names[] = { "/r", "/camera_frames", "/cam0", "/test_ring" };
+    static const char* const encodings[] = { "yuv422_yuy2", "rgb8", "mono8", "yuyv", "" };
+    const size_t ring_count = sizeof(ring_names) / sizeof(ring_names[0]);
+    const size_t encoding_count = sizeof(encodings) / sizeof(encodings[0]);
+    embedded_object_detection_pi5__msg__FrameDescriptor* msg =
+        embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    if (!msg) {
+        return -1;
+    }
+
+    int result = -1;
+    if (rosidl_runtime_c__String__assign(&msg->header.frame_id, variant & 1 ? "camera_frame" : "") &&
+        rosidl_runtime_c__String__assign(&msg->ring_name, ring_names[variant % ring_count]) &&
+        rosidl_runtime_c__String__assign(&msg->encoding, encodings[variant % encoding_count])) {
+        msg->header.stamp.sec = -3 - variant;
+        msg->header.stamp.nanosec = 123456789u;
+        msg->slot = 3 + (uint32_t)variant;
+        msg->sequence = 0x0123456789abcdefULL + (uint64_t)variant;
+        msg->capture_sequence = 0xfedcba98u - (uint32_t)variant;
+        msg->size = 614400 + (uint32_t)variant;
+        msg->width = 640 + (uint32_t)variant;
+        msg->height = 480 - (uint32_t)variant;
+        msg->step = 1280 + (uint32_t)variant * 2;
+        msg->still = (variant & 2) != 0;
+        msg->motion_score = 0.125f * (float)(variant + 1);
+        msg->dirty_x = 8 + (uint32_t)variant;
+        msg->dirty_y = 16 + (uint32_t)variant;
+        msg->dirty_width = 320 - (uint32_t)variant;
+        msg->dirty_height = 240 - (uint32_t)variant;
+
+        if (rmw_serialize(msg, ROSIDL_GET_MSG_TYPE_SUPPORT(embedded_object_detection_pi5, msg,
+                                                           FrameDescriptor),
+                          serialized) != RMW_RET_OK) {
+            fprintf(stderr, "cdr: rmw_serialize failed for a frame descriptor\n");
+        } else if (image_message_cdr_read_descriptor(serialized->buffer, serialized->buffer_length,
+                                                     read) != 0 ||
+                   read->header.stamp.sec != msg->header.stamp.sec ||
+                   read->header.stamp.nanosec != msg->header.stamp.nanosec ||
+                   strcmp(read->header.frame_id.data, msg->header.frame_id.data) != 0 ||
+                   strcmp(read->ring_name.data, msg->ring_name.data) != 0 ||
+                   read->slot != msg->slot || read->sequence != msg->sequence ||
+                   read->capture_sequence != msg->capture_sequence || read->size != msg->size ||
+                   read->width != msg->width || read->height != msg->height ||
+                   read->step != msg->step || strcmp(read->encoding.data, msg->encoding.data) != 0 ||
+                   read->still != msg->still || read->motion_score != msg->motion_score ||
+                   read->dirty_x != msg->dirty_x || read->dirty_y != msg->dirty_y ||
+                   read->dirty_width != msg->dirty_width || read->dirty_height != msg->dirty_height) {
+            fprintf(stderr, "cdr: serialized frame descriptor %d read back wrong\n", variant);
+        } else if (image_message_cdr_read_descriptor(serialized->buffer,
+                                                     serialized->buffer_length - TEST_CDR_CUT,
+                                                     read) == 0) {
+            fprintf(stderr, "cdr: truncated frame descriptor %d accepted\n", variant);
+        } else {
+            result = 0;
+        }
+    }
+    embedded_object_detection_pi5__msg__FrameDescriptor__destroy(msg);
+    return result;
+}
+
+static int test_cdr_rmw(void) {
+    rmw_serialized_message_t serialized = rmw_get_zero_initialized_serialized_message();
+    rcl_allocator_t allocator = rcl_get_default_allocator();
+    embedded_object_detection_pi5__msg__FrameDescriptor* read =
+        embedded_object_detection_pi5__msg__FrameDescriptor__create();
+    if (!read || rmw_serialized_message_init(&serialized, 0, &allocator) != RMW_RET_OK) {
+        if (read) {
+            embedded_object_detection_pi5__msg__FrameDescriptor__destroy(read);
+        }
+        return -1;
+    }
+
+    int result = 0;
+    for (int variant = 0; variant < TEST_CDR_VARIANTS && result == 0; ++variant) {
+        if (test_cdr_check_image(&serialized, variant) != 0 ||
+            test_cdr_check_descriptor(&serialized, variant, read) != 0) {
+            result = -1;
+        }
+    }
+    if (result == 0) {
+        printf("cdr: %d rmw_serialize'd images and frame descriptors read back exactly\n",
+               TEST_CDR_VARIANTS);
+    }
+    rmw_serialized_message_fini(&serialized);
+    embedded_object_detection_pi5__msg__FrameDescriptor__destroy(read);
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "message_fill", test_message_fill },
+    { "cdr_rmw", test_cdr_rmw },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
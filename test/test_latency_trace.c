@@ -0,0 +1,125 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "latency_trace/latency_trace.h"
+
+#include "test_util.h"
+
+#define TEST_LATENCY_SAMPLES 100000
+#define TEST_LATENCY_OFFSET_READS 1000
+
+typedef enum {
+    TEST_LATENCY_UNIFORM,              // 1-50 ms
+    TEST_LATENCY_LOGNORMAL,            // Around 20 ms, long tail
+    TEST_LATENCY_BIMODAL,              // 5 ms, 2% stalls around 80 ms
+    TEST_LATENCY_MICRO,                // 0-40 us, mostly exact buckets
+    TEST_LATENCY_DIST_COUNT
+} test_latency_dist_t;
+
+static const char* const g_latency_dist_names[TEST_LATENCY_DIST_COUNT] = {
+    "uniform", "lognormal", "bimodal", "micro",
+};
+
+static int64_t test_latency_sample(test_latency_dist_t dist, unsigned* seed) {
+    double u = test_random_unit(seed);
+    switch (dist) {
+        case TEST_LATENCY_UNIFORM:
+            return (int64_t)(1e6 + u * 49e6);
+        case TEST_LATENCY_LOGNORMAL: {
+            // Box-Muller
+            double v = test_random_unit(seed);
+            double z = sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);
+            return (int64_t)(20e6 * exp(0.5 * z));
+        }
+        case TEST_LATENCY_BIMODAL:
+            return u < 0.02 ? (int64_t)(70e6 + test_random_unit(seed) * 10e6) :
+                              (int64_t)(5e6 + test_random_unit(seed) * 0.5e6);
+        default:
+            return (int64_t)(u * 40e3);
+    }
+}
+
+static int test_compare_i64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Exact percentile with the histogram's rank rule (ceil, 1-based)
+static int64_t test_latency_exact(const int64_t* sorted, size_t count, double percentile) {
+    double exact = percentile / 100.0 * (double)count;
+    size_t rank = (size_t)exact;
+    if ((double)rank < exact || rank == 0) {
+        rank++;
+    }
+    return sorted[rank - 1];
+}
+
+// Histogram percentiles within 1/32 of the exact ones (or 1 us where the
+// buckets are 1 us wide), exact count and max, for each distribution
+static int test_latency_percentiles(void) {
+    static const double percentiles[] = { 50.0, 95.0, 99.0, 99.9 };
+    const size_t percentile_count = sizeof(percentiles) / sizeof(percentiles[0]);
+    int64_t* samples = malloc(TEST_LATENCY_SAMPLES * sizeof(int64_t));
+    latency_histogram_t* histogram = malloc(sizeof(latency_histogram_t));
+    if (!samples || !histogram) {
+        free(samples);
+        free(histogram);
+        return -1;
+    }
+
+    int result = 0;
+    for (int d = 0; d < TEST_LATENCY_DIST_COUNT; ++d) {
+        unsigned seed = 1234u + (unsigned)d;
+        latency_histogram_reset(histogram);
+        for (int i = 0; i < TEST_LATENCY_SAMPLES; ++i) {
+            samples[i] = test_latency_sample((test_latency_dist_t)d, &seed);
+            latency_histogram_record(histogram, samples[i]);
+        }
+
+        qsort(samples, TEST_LATENCY_SAMPLES, sizeof(int64_t), test_compare_i64);
+        double worst = 0.0;
+        for (size_t p = 0; p < percentile_count; ++p) {
+            int64_t exact = test_latency_exact(samples, TEST_LATENCY_SAMPLES, percentiles[p]);
+            int64_t estimate = latency_histogram_percentile(histogram, percentiles[p]);
+            double error = fabs((double)(estimate - exact)) / (exact > 32000 ? (double)exact : 32000.0);
+            worst = error > worst ? error : worst;
+        }
+        bool max_ok = histogram->max_ns == samples[TEST_LATENCY_SAMPLES - 1];
+        bool ok = worst <= 1.0 / 32.0 + 1e-9 && max_ok && histogram->count == TEST_LATENCY_SAMPLES;
+        printf("  %-10s max error %.2f%%%s %s\n", g_latency_dist_names[d], 100.0 * worst,
+               max_ok ? "" : ", wrong max", ok ? "ok" : "FAILED");
+        if (!ok) {
+            result = -1;
+        }
+    }
+
+    free(samples);
+    free(histogram);
+    return result;
+}
+
+// Header stamps go through realtime and back: the offset between the
+// clocks must not wobble by more than the latencies being measured
+static int test_latency_clock_offset(void) {
+    int64_t lowest = INT64_MAX, highest = INT64_MIN;
+    for (int i = 0; i < TEST_LATENCY_OFFSET_READS; ++i) {
+        int64_t offset = latency_realtime_offset_ns();
+        lowest = offset < lowest ? offset : lowest;
+        highest = offset > highest ? offset : highest;
+    }
+    printf("  realtime - monotonic offset: %.1f us spread over %d reads\n",
+           (highest - lowest) / 1e3, TEST_LATENCY_OFFSET_READS);
+    return highest - lowest > 100000 ? -1 : 0;
+}
+
+static const test_case_t g_cases[] = {
+    { "latency_percentiles", test_latency_percentiles },
+    { "latency_clock_offset", test_latency_clock_offset },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
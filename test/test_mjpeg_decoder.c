@@ -0,0 +1,161 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jpeglib.h>
+
+#include "mjpeg_decoder/mjpeg_decoder.h"
+
+#include "test_util.h"
+
+#define TEST_JPEG_WIDTH 640
+#define TEST_JPEG_HEIGHT 480
+
+// A 4:2:2 JPEG like a UVC camera's: smooth gradients plus some noise
+static uint8_t* test_make_jpeg(int width, int height, size_t* size) {
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    unsigned char* out = NULL;
+    unsigned long out_size = 0;
+    uint8_t* row = malloc((size_t)width * 3);
+    if (!row) {
+        return NULL;
+    }
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &out, &out_size);
+    cinfo.image_width = (JDIMENSION)width;
+    cinfo.image_height = (JDIMENSION)height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 80, TRUE);
+    cinfo.comp_info[0].h_samp_factor = 2;
+    cinfo.comp_info[0].v_samp_factor = 1;
+    jpeg_start_compress(&cinfo, TRUE);
+
+    while (cinfo.next_scanline < cinfo.image_height) {
+        int y = (int)cinfo.next_scanline;
+        test_fill_random(row, (size_t)width * 3, (unsigned)y);
+        for (int x = 0; x < width; ++x) {
+            row[3 * x + 0] = (uint8_t)(x * 255 / width + (row[3 * x + 0] >> 4));
+            row[3 * x + 1] = (uint8_t)(y * 255 / height + (row[3 * x + 1] >> 4));
+            row[3 * x + 2] = (uint8_t)((x + y) & 0xff);
+        }
+        JSAMPROW rows[1] = { row };
+        jpeg_write_scanlines(&cinfo, rows, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+    free(row);
+    *size = out_size;
+    return out;
+}
+
+// Frames cut short or missing a USB packet's worth of data in the middle
+// must be rejected, and the decoder must still decode the next good frame
+static int test_mjpeg_check_corrupt(const uint8_t* jpeg, size_t jpeg_size, int width, int height) {
+    mjpeg_decoder_t decoder;
+    if (mjpeg_decoder_init(&decoder, MJPEG_OUTPUT_YUYV, 1) != 0) {
+        return -1;
+    }
+    uint32_t out_width, out_height, out_step;
+    size_t out_size;
+    mjpeg_decoder_output_size(&decoder, (uint32_t)width, (uint32_t)height,
+                              &out_width, &out_height, &out_step, &out_size);
+    uint8_t* dst = malloc(out_size);
+    uint8_t* damaged = malloc(jpeg_size);
+    int result = -1;
+    if (dst && damaged && jpeg_size > 8192) {
+        size_t cut = jpeg_size / 2;
+        size_t gap = 3072;
+        memcpy(damaged, jpeg, cut);
+        memcpy(damaged + cut, jpeg + cut + gap, jpeg_size - cut - gap);
+
+        bool truncated_rejected =
+            mjpeg_decoder_decode(&decoder, jpeg, jpeg_size / 2, 0, 0, dst, out_size) != 0;
+        bool gap_rejected =
+            mjpeg_decoder_decode(&decoder, damaged, jpeg_size - gap, 0, 0, dst, out_size) != 0;
+        bool recovered = mjpeg_decoder_decode(&decoder, jpeg, jpeg_size, 0, 0, dst, out_size) == 0;
+        printf("  corrupt frames: truncated %s, missing data %s, next good frame %s\n",
+               truncated_rejected ? "rejected" : "ACCEPTED",
+               gap_rejected ? "rejected" : "ACCEPTED",
+               recovered ? "decoded" : "FAILED");
+        result = truncated_rejected && gap_rejected && recovered ? 0 : -1;
+    }
+    free(dst);
+    free(damaged);
+    mjpeg_decoder_fini(&decoder);
+    return result;
+}
+
+
+static int test_mjpeg_corrupt(void) {
+    size_t jpeg_size;
+    uint8_t* jpeg = test_make_jpeg(TEST_JPEG_WIDTH, TEST_JPEG_HEIGHT, &jpeg_size);
+    if (!jpeg) {
+        return -1;
+    }
+    int result = test_mjpeg_check_corrupt(jpeg, jpeg_size, TEST_JPEG_WIDTH, TEST_JPEG_HEIGHT);
+    free(jpeg);
+    return result;
+}
+
+// Every output at every scale decodes a good frame, the header peek reports
+// the stream's size and the counters see each frame once
+static int test_mjpeg_outputs(void) {
+    static const mjpeg_output_t outputs[] = { MJPEG_OUTPUT_YUYV, MJPEG_OUTPUT_I420, MJPEG_OUTPUT_RGB24 };
+    static const int scales[] = { 1, 2, 4 };
+    size_t jpeg_size;
+    uint8_t* jpeg = test_make_jpeg(TEST_JPEG_WIDTH, TEST_JPEG_HEIGHT, &jpeg_size);
+    if (!jpeg) {
+        return -1;
+    }
+
+    int result = 0;
+    for (size_t o = 0; o < sizeof(outputs) / sizeof(outputs[0]) && result == 0; ++o) {
+        for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]) && result == 0; ++s) {
+            mjpeg_decoder_t decoder;
+            if (mjpeg_decoder_init(&decoder, outputs[o], scales[s]) != 0) {
+                result = -1;
+                break;
+            }
+            uint32_t width = 0, height = 0;
+            uint32_t out_width, out_height, out_step;
+            size_t out_size;
+            mjpeg_decoder_output_size(&decoder, TEST_JPEG_WIDTH, TEST_JPEG_HEIGHT,
+                                      &out_width, &out_height, &out_step, &out_size);
+            uint8_t* dst = malloc(out_size);
+            if (!dst ||
+                mjpeg_decoder_peek_size(&decoder, jpeg, jpeg_size, &width, &height) != 0 ||
+                width != TEST_JPEG_WIDTH || height != TEST_JPEG_HEIGHT ||
+                out_width != (uint32_t)(TEST_JPEG_WIDTH / scales[s]) ||
+                out_height != (uint32_t)(TEST_JPEG_HEIGHT / scales[s]) ||
+                mjpeg_decoder_decode(&decoder, jpeg, jpeg_size, width, height, dst, out_size) != 0 ||
+                decoder.decoded != 1 || decoder.corrupt != 0) {
+                fprintf(stderr, "mjpeg: %s at 1/%d failed (header %ux%u, output %ux%u)\n",
+                        mjpeg_output_encoding(outputs[o]), scales[s], width, height,
+                        out_width, out_height);
+                result = -1;
+            }
+            free(dst);
+            mjpeg_decoder_fini(&decoder);
+        }
+    }
+    if (result == 0) {
+        printf("  outputs: yuyv, i420 and rgb24 decode at 1/1, 1/2 and 1/4\n");
+    }
+    free(jpeg);
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "mjpeg_outputs", test_mjpeg_outputs },
+    { "mjpeg_corrupt", test_mjpeg_corrupt },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
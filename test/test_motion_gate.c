@@ -0,0 +1,294 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_convert/color_convert.h"
+#include "motion_gate/motion_gate.h"
+
+#include "test_util.h"
+
+#define TEST_MOTION_FRAMES 150
+#define TEST_MOTION_START 30           // A square starts moving here...
+#define TEST_MOTION_STOP 90            // ...and leaves the scene here
+#define TEST_MOTION_SQUARE 48
+#define TEST_MOTION_NOISE 2            // Y jitter per frame, +-levels
+
+static const int g_motion_decimations[] = { 1, 2, 4 };
+#define TEST_MOTION_DECIMATION_COUNT (sizeof(g_motion_decimations) / sizeof(g_motion_decimations[0]))
+
+// Every kernel against the scalar one: SAD sums and updated background,
+// for full chunks, a scalar tail and a row shorter than one chunk
+static int test_motion_kernels(void) {
+    static const int widths[] = { 640, 634, 38 };
+    const size_t bytes = 640 * 2;
+    uint8_t* yuyv = malloc(bytes);
+    uint8_t* expected_bg = malloc(640);
+    uint8_t* actual_bg = malloc(640);
+    uint32_t expected_sad[40], actual_sad[40];
+    if (!yuyv || !expected_bg || !actual_bg) {
+        free(yuyv);
+        free(expected_bg);
+        free(actual_bg);
+        return -1;
+    }
+    test_fill_random(yuyv, bytes, 11);
+
+    int failures = 0;
+    for (int isa = 1; isa < COLOR_CONVERT_ISA_COUNT; ++isa) {
+        motion_gate_row_fn row = motion_gate_get_row((color_convert_isa_t)isa);
+        if (!row || color_convert_detect_isa() < (color_convert_isa_t)isa) {
+            continue;
+        }
+        for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+            for (size_t k = 0; k < TEST_MOTION_DECIMATION_COUNT; ++k) {
+                for (int shift = 0; shift <= 4; shift += 2) {
+                    int d = g_motion_decimations[k];
+                    int samples = widths[w] / d;
+                    test_fill_random(expected_bg, 640, 23);
+                    memcpy(actual_bg, expected_bg, 640);
+                    memset(expected_sad, 0, sizeof(expected_sad));
+                    memset(actual_sad, 0, sizeof(actual_sad));
+                    motion_gate_row_scalar(yuyv, d, expected_bg, samples, shift, expected_sad);
+                    row(yuyv, d, actual_bg, samples, shift, actual_sad);
+                    if (memcmp(expected_bg, actual_bg, (size_t)samples) != 0 ||
+                        memcmp(expected_sad, actual_sad, sizeof(expected_sad)) != 0) {
+                        fprintf(stderr, "motion_gate: %s kernel differs (width %d, decimation %d, "
+                                "shift %d)\n", color_convert_isa_name((color_convert_isa_t)isa),
+                                widths[w], d, shift);
+                        failures++;
+                    }
+                }
+            }
+        }
+    }
+    free(yuyv);
+    free(expected_bg);
+    free(actual_bg);
+    printf("  kernels vs scalar: %s\n", failures ? "FAILED" : "ok");
+    return failures ? -1 : 0;
+}
+
+// Textured background, noise on every frame and, between START and STOP,
+// a bright square crossing the frame
+static void test_motion_frame(const uint8_t* texture, uint8_t* yuyv, int width, int height,
+                               int frame, unsigned* seed, int* square_x, int* square_y) {
+    memcpy(yuyv, texture, (size_t)width * height * 2);
+    for (size_t i = 0; i < (size_t)width * height; ++i) {
+        *seed = *seed * 1103515245u + 12345u;
+        int y = yuyv[i * 2] + (int)((*seed >> 16) % (2 * TEST_MOTION_NOISE + 1)) - TEST_MOTION_NOISE;
+        yuyv[i * 2] = (uint8_t)(y < 0 ? 0 : (y > 255 ? 255 : y));
+    }
+
+    *square_x = -1;
+    if (frame < TEST_MOTION_START || frame >= TEST_MOTION_STOP) {
+        return;
+    }
+    *square_x = 40 + (frame - TEST_MOTION_START) * 8;
+    *square_y = height / 3;
+    for (int y = *square_y; y < *square_y + TEST_MOTION_SQUARE; ++y) {
+        for (int x = *square_x; x < *square_x + TEST_MOTION_SQUARE; ++x) {
+            yuyv[((size_t)y * width + x) * 2] = 235;
+        }
+    }
+}
+
+// Still frames must settle, the moving square must be inside the dirty box
+static int test_motion_check_scene(int decimation) {
+    const int width = 640, height = 480;
+    uint8_t* texture = malloc((size_t)width * height * 2);
+    uint8_t* yuyv = malloc((size_t)width * height * 2);
+    if (!texture || !yuyv) {
+        free(texture);
+        free(yuyv);
+        return -1;
+    }
+    test_fill_random(texture, (size_t)width * height * 2, 5);
+    for (size_t i = 0; i < (size_t)width * height; ++i) {
+        texture[i * 2] = (uint8_t)(64 + texture[i * 2] / 2);
+    }
+
+    motion_gate_config_t config;
+    motion_gate_config_default(&config);
+    config.decimation = decimation;
+    motion_gate_t gate;
+    if (motion_gate_init(&gate, &config) != 0) {
+        free(texture);
+        free(yuyv);
+        return -1;
+    }
+
+    unsigned seed = 99u;
+    int false_alarms = 0, misses = 0, outside = 0, moving_frames = 0;
+    for (int frame = 0; frame < TEST_MOTION_FRAMES; ++frame) {
+        int sx, sy;
+        test_motion_frame(texture, yuyv, width, height, frame, &seed, &sx, &sy);
+        motion_gate_result_t r;
+        motion_gate_run(&gate, yuyv, width * 2, width, height, &r);
+
+        // Settled: once the first frame's hold ran out, and once the
+        // background caught up with the square's last spots and the hold
+        // after that ran out as well
+        bool settled = (frame > config.hold_frames && frame < TEST_MOTION_START) ||
+                       frame >= TEST_MOTION_STOP + 3 * config.hold_frames;
+        if (settled && r.motion) {
+            false_alarms++;
+        }
+        if (sx >= 0) {
+            moving_frames++;
+            if (!r.motion || r.changed_blocks == 0) {
+                misses++;
+            } else if (sx < r.x || sy < r.y || sx + TEST_MOTION_SQUARE > r.x + r.width ||
+                       sy + TEST_MOTION_SQUARE > r.y + r.height) {
+                outside++;
+            }
+        }
+    }
+    motion_gate_fini(&gate);
+    free(texture);
+    free(yuyv);
+
+    printf("  decimation %d: %d/%d moving frames detected, %d dirty boxes missing the square, "
+           "%d false alarms on still frames\n", decimation, moving_frames - misses, moving_frames,
+           outside, false_alarms);
+    return misses || outside || false_alarms ? -1 : 0;
+}
+
+#define TEST_UPLOAD_SQUARE 64
+#define TEST_UPLOAD_STEP 70            // Rows the square moves per frame
+#define TEST_UPLOAD_STILL_REFRESH 30   // As DISPLAY_STILL_REFRESH
+#define TEST_UPLOAD_CONTRAST 56        // Square over the background, faint trail behind
+
+// The display's partial uploads: a texture that only gets the dirty rows,
+// unioned with the previous handed-over frame's as display_node does, must
+// match a full upload after every frame it is shown. A square crosses the
+// frame top to bottom and leaves, and still frames are skipped between
+// refreshes. The square lifts the background by only 1/8 of its contrast,
+// under the gate's threshold, so the rows it leaves are not in the next
+// frame's dirty box: the same run with only each frame's own rows shows
+// the ghost rows the union prevents.
+static int test_motion_check_upload(int decimation) {
+    const int width = 640, height = 480;
+    const size_t stride = (size_t)width * 2;
+    const size_t size = stride * height;
+    uint8_t* background = malloc(size);
+    uint8_t* yuyv = malloc(size);
+    uint8_t* merged = malloc(size);     // Union of this and the previous band
+    uint8_t* own = malloc(size);        // This band only
+    if (!background || !yuyv || !merged || !own) {
+        free(background);
+        free(yuyv);
+        free(merged);
+        free(own);
+        return -1;
+    }
+    test_fill_random(background, size, 17);
+    for (size_t i = 0; i < (size_t)width * height; ++i) {
+        background[i * 2] = (uint8_t)(64 + background[i * 2] / 2);
+    }
+
+    motion_gate_config_t config;
+    motion_gate_config_default(&config);
+    config.decimation = decimation;
+    motion_gate_t gate;
+    if (motion_gate_init(&gate, &config) != 0) {
+        free(background);
+        free(yuyv);
+        free(merged);
+        free(own);
+        return -1;
+    }
+
+    const int start = config.hold_frames + 2;
+    const int steps = (height - TEST_UPLOAD_SQUARE) / TEST_UPLOAD_STEP + 1;
+    const int frames = start + steps + 3 * config.hold_frames + 2 * TEST_UPLOAD_STILL_REFRESH;
+    int shown = 0, partial = 0, still_run = 0;
+    int prev_y = 0, prev_height = 0;
+    int ghost_rows = 0, own_ghost_rows = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        memcpy(yuyv, background, size);
+        int k = frame - start;
+        if (k >= 0 && k < steps) {
+            int top = 20 + k * TEST_UPLOAD_STEP;
+            int bottom = top + TEST_UPLOAD_SQUARE < height ? top + TEST_UPLOAD_SQUARE : height;
+            for (int y = top; y < bottom; ++y) {
+                for (int x = 200; x < 200 + TEST_UPLOAD_SQUARE; ++x) {
+                    uint8_t* sample = &yuyv[y * stride + (size_t)x * 2];
+                    *sample = (uint8_t)(*sample + TEST_UPLOAD_CONTRAST);
+                }
+            }
+        }
+        motion_gate_result_t r;
+        motion_gate_run(&gate, yuyv, (int)stride, width, height, &r);
+
+        // Intake: skip still frames but every Nth; shown ones redraw all
+        bool still = !r.motion;
+        if (still && shown > 0 && ++still_run < TEST_UPLOAD_STILL_REFRESH) {
+            continue;
+        }
+        still_run = 0;
+        int dirty_y = still ? 0 : r.y;
+        int dirty_height = still ? height : r.height;
+
+        // Renderer
+        int y = dirty_y, rows = dirty_height;
+        if (shown == 0) {
+            y = 0;
+            rows = height;
+            memcpy(own, yuyv, size);
+        } else {
+            memcpy(own + dirty_y * stride, yuyv + dirty_y * stride, (size_t)dirty_height * stride);
+            motion_gate_union_rows(&y, &rows, prev_y, prev_height);
+            partial += rows < height;
+        }
+        memcpy(merged + y * stride, yuyv + y * stride, (size_t)rows * stride);
+        prev_y = dirty_y;
+        prev_height = dirty_height;
+        shown++;
+
+        for (int row = 0; row < height; ++row) {
+            ghost_rows += memcmp(merged + row * stride, yuyv + row * stride, stride) != 0;
+            own_ghost_rows += memcmp(own + row * stride, yuyv + row * stride, stride) != 0;
+        }
+    }
+    motion_gate_fini(&gate);
+    free(background);
+    free(yuyv);
+    free(merged);
+    free(own);
+
+    printf("  decimation %d: %d frames shown, %d partial uploads, %d rows differ from a full "
+           "upload (%d with each frame's own rows only)\n", decimation, shown, partial, ghost_rows,
+           own_ghost_rows);
+    return ghost_rows || partial == 0 ? -1 : 0;
+}
+
+static int test_motion_scene(void) {
+    int result = 0;
+    for (size_t k = 0; k < TEST_MOTION_DECIMATION_COUNT; ++k) {
+        if (test_motion_check_scene(g_motion_decimations[k]) != 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+static int test_motion_upload(void) {
+    int result = 0;
+    for (size_t k = 0; k < TEST_MOTION_DECIMATION_COUNT; ++k) {
+        if (test_motion_check_upload(g_motion_decimations[k]) != 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "motion_kernels", test_motion_kernels },
+    { "motion_scene", test_motion_scene },
+    { "motion_upload", test_motion_upload },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
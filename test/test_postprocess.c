@@ -0,0 +1,182 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_convert/color_convert.h"
+#include "postprocess/postprocess.h"
+
+#include "test_util.h"
+
+#define TEST_POSTPROCESS_CLASSES 80
+#define TEST_POSTPROCESS_OBJECTS 20        // Objects in a synthetic output
+#define TEST_POSTPROCESS_OBJECT_SHARE 10   // 1 in N candidates sits on an object
+
+static const int g_candidate_counts[] = { 1000, 8000, 25000 };
+#define TEST_CANDIDATE_COUNT (sizeof(g_candidate_counts) / sizeof(g_candidate_counts[0]))
+
+// Deployment threshold and the low one used for mAP evaluation, where
+// nearly every candidate passes and the top k selection does the work
+static const float g_conf_thresholds[] = { 0.25f, 0.001f };
+#define TEST_CONF_THRESHOLD_COUNT (sizeof(g_conf_thresholds) / sizeof(g_conf_thresholds[0]))
+
+// attribute: 0-3 box, 4 objectness (YOLOv5 only), then classes
+static void test_yolo_set(postprocess_layout_t layout, float* output, int candidates,
+                           int attributes, int candidate, int attribute, float value) {
+    if (layout == POSTPROCESS_LAYOUT_YOLOV8) {
+        output[(size_t)attribute * candidates + candidate] = value;
+    } else {
+        output[(size_t)candidate * attributes + attribute] = value;
+    }
+}
+
+// Clusters of boxes around a few objects over low-score background, with
+// scores quantized to 1/256 like an int8 model's, so ties are common
+static float* test_make_yolo_output(postprocess_layout_t layout, int candidates, int classes) {
+    int v5 = layout == POSTPROCESS_LAYOUT_YOLOV5;
+    int first_class = v5 ? 5 : 4;
+    int attributes = first_class + classes;
+    float* output = malloc((size_t)candidates * attributes * sizeof(float));
+    if (!output) {
+        return NULL;
+    }
+
+    unsigned seed = 1234u;
+    float objects[TEST_POSTPROCESS_OBJECTS][5];     // cx, cy, w, h, class
+    for (int o = 0; o < TEST_POSTPROCESS_OBJECTS; ++o) {
+        objects[o][0] = test_random_unit(&seed) * 640.0f;
+        objects[o][1] = test_random_unit(&seed) * 640.0f;
+        objects[o][2] = 20.0f + test_random_unit(&seed) * 180.0f;
+        objects[o][3] = 20.0f + test_random_unit(&seed) * 180.0f;
+        objects[o][4] = (float)(int)(test_random_unit(&seed) * classes);
+    }
+
+    for (int i = 0; i < candidates; ++i) {
+        bool on_object = (i % TEST_POSTPROCESS_OBJECT_SHARE) == 0;
+        const float* object = objects[(i / TEST_POSTPROCESS_OBJECT_SHARE) % TEST_POSTPROCESS_OBJECTS];
+        float box[4];
+        for (int k = 0; k < 4; ++k) {
+            float jitter = test_random_unit(&seed) - 0.5f;
+            box[k] = on_object ? object[k] + jitter * 0.2f * object[k < 2 ? k + 2 : k]
+                               : (k < 2 ? 640.0f : 120.0f) * test_random_unit(&seed) + 4.0f;
+        }
+        for (int k = 0; k < 4; ++k) {
+            test_yolo_set(layout, output, candidates, attributes, i, k, box[k]);
+        }
+        if (v5) {
+            float objectness = on_object ? 0.5f + 0.5f * test_random_unit(&seed)
+                                         : 0.1f * test_random_unit(&seed);
+            test_yolo_set(layout, output, candidates, attributes, i, 4,
+                           floorf(objectness * 256.0f) / 256.0f);
+        }
+        for (int c = 0; c < classes; ++c) {
+            float value = 0.05f * test_random_unit(&seed);
+            if (on_object && c == (int)object[4]) {
+                value = 0.3f + 0.7f * test_random_unit(&seed);
+            }
+            test_yolo_set(layout, output, candidates, attributes, i, first_class + c,
+                           floorf(value * 256.0f) / 256.0f);
+        }
+    }
+    return output;
+}
+
+static int test_postprocess_init(postprocess_t* pp, postprocess_layout_t layout, int candidates,
+                                  float threshold, bool class_agnostic, int top_k) {
+    int attributes = TEST_POSTPROCESS_CLASSES + (layout == POSTPROCESS_LAYOUT_YOLOV5 ? 5 : 4);
+    int64_t dims[3] = { 1, 0, 0 };
+    dims[1] = layout == POSTPROCESS_LAYOUT_YOLOV8 ? attributes : candidates;
+    dims[2] = layout == POSTPROCESS_LAYOUT_YOLOV8 ? candidates : attributes;
+
+    postprocess_config_t config;
+    postprocess_config_default(&config);
+    config.layout = layout;
+    config.conf_threshold = threshold;
+    config.class_agnostic = class_agnostic;
+    config.pre_nms_top_k = top_k;
+    return postprocess_init(pp, &config, dims, 3);
+}
+
+// Exact agreement (same boxes, same order, same bits) with the reference
+static int test_postprocess_check(postprocess_t* pp, const float* output, const char* label) {
+    int capacity = pp->config.max_detections;
+    postprocess_detection_t* fast = calloc((size_t)capacity, sizeof(*fast));
+    postprocess_detection_t* reference = calloc((size_t)capacity, sizeof(*reference));
+    if (!fast || !reference) {
+        free(fast);
+        free(reference);
+        return -1;
+    }
+
+    int result = 0;
+    int expected = postprocess_run_reference(pp, output, reference, capacity);
+    for (int isa = 0; isa < COLOR_CONVERT_ISA_COUNT && expected >= 0; ++isa) {
+        postprocess_filter_fn filter = postprocess_get_filter((color_convert_isa_t)isa);
+        postprocess_row_max_fn row_max = postprocess_get_row_max((color_convert_isa_t)isa);
+        if (!filter || !row_max || color_convert_detect_isa() < (color_convert_isa_t)isa) {
+            continue;
+        }
+        pp->filter = filter;
+        pp->row_max = row_max;
+        int count = postprocess_run(pp, output, fast, capacity);
+        bool ok = count == expected &&
+                  memcmp(fast, reference, (size_t)count * sizeof(*fast)) == 0;
+        printf("  %-22s %-6s vs brute force: %d/%d detections %s\n", label,
+               color_convert_isa_name((color_convert_isa_t)isa), count, expected,
+               ok ? "ok" : "FAILED");
+        if (!ok) {
+            result = -1;
+        }
+    }
+
+    pp->filter = postprocess_get_filter(pp->isa);
+    pp->row_max = postprocess_get_row_max(pp->isa);
+    free(fast);
+    free(reference);
+    return expected < 0 ? -1 : result;
+}
+
+// Every available kernel against the full-sort reference for both layouts,
+// every candidate count and threshold, with per-class NMS after top k and
+// class-agnostic NMS over every candidate
+static int test_postprocess_exact(void) {
+    static const postprocess_layout_t layouts[] = { POSTPROCESS_LAYOUT_YOLOV8,
+                                                    POSTPROCESS_LAYOUT_YOLOV5 };
+    int result = 0;
+    for (size_t l = 0; l < 2 && result == 0; ++l) {
+        for (size_t n = 0; n < TEST_CANDIDATE_COUNT && result == 0; ++n) {
+            int candidates = g_candidate_counts[n];
+            float* output = test_make_yolo_output(layouts[l], candidates, TEST_POSTPROCESS_CLASSES);
+            if (!output) {
+                return -1;
+            }
+            for (size_t t = 0; t < TEST_CONF_THRESHOLD_COUNT && result == 0; ++t) {
+                float threshold = g_conf_thresholds[t];
+                for (int agnostic = 0; agnostic < 2 && result == 0; ++agnostic) {
+                    postprocess_t pp;
+                    if (test_postprocess_init(&pp, layouts[l], candidates, threshold, agnostic,
+                                              agnostic ? 0 : POSTPROCESS_PRE_NMS_TOP_K) != 0) {
+                        result = -1;
+                        break;
+                    }
+                    char label[32];
+                    snprintf(label, sizeof(label), "%s %d @%.3f%s", postprocess_layout_name(layouts[l]),
+                             candidates, threshold, agnostic ? " any" : "");
+                    result = test_postprocess_check(&pp, output, label);
+                    postprocess_fini(&pp);
+                }
+            }
+            free(output);
+        }
+    }
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "postprocess_exact", test_postprocess_exact },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
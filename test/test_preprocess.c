@@ -0,0 +1,256 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_convert/color_convert.h"
+#include "preprocess/preprocess.h"
+
+#include "test_util.h"
+
+#define TEST_PREPROCESS_MAX_DIFF 1e-4      // Fused vs. reference, float32
+#define TEST_PREPROCESS_MAX_ERROR 2.5      // Fused vs. ideal, in 8-bit levels
+
+typedef struct {
+    int width;
+    int height;
+    const char* name;
+} test_resolution_t;
+
+static const test_resolution_t g_resolutions[] = {
+    { 640, 480, "640x480" },
+    { 1280, 720, "1280x720" },
+    { 1920, 1080, "1920x1080" },
+};
+#define TEST_RESOLUTION_COUNT (sizeof(g_resolutions) / sizeof(g_resolutions[0]))
+
+static const int g_tensor_sizes[] = { 320, 416, 640 };
+#define TEST_TENSOR_SIZE_COUNT (sizeof(g_tensor_sizes) / sizeof(g_tensor_sizes[0]))
+
+// The same picture as rgb8 and as yuv422_yuy2 (BT.601), so only the
+// input path differs
+static void test_make_rgb_yuyv(uint8_t* rgb, uint8_t* yuyv, int width, int height) {
+    test_fill_random(rgb, (size_t)width * height * 3, 3);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t* p = rgb + ((size_t)y * width + x) * 3;
+            p[0] = (uint8_t)(x * 200 / width + (p[0] >> 5));
+            p[1] = (uint8_t)(y * 200 / height + (p[1] >> 5));
+            p[2] = (uint8_t)(((x + y) & 0x7f) + (p[2] >> 5));
+        }
+        for (int x = 0; x + 1 < width; x += 2) {
+            const uint8_t* p = rgb + ((size_t)y * width + x) * 3;
+            uint8_t* d = yuyv + (size_t)y * width * 2 + (size_t)x * 2;
+            int r = p[0], g = p[1], b = p[2];
+            d[0] = (uint8_t)((66 * r + 129 * g + 25 * b + 128) / 256 + 16);
+            d[1] = (uint8_t)((-38 * r - 74 * g + 112 * b + 128) / 256 + 128);
+            d[2] = (uint8_t)((66 * p[3] + 129 * p[4] + 25 * p[5] + 128) / 256 + 16);
+            d[3] = (uint8_t)((112 * r - 94 * g - 18 * b + 128) / 256 + 128);
+        }
+    }
+}
+
+// ImageNet normalization, the common case for float32 models
+static void test_preprocess_config(preprocess_config_t* config, int size, preprocess_dtype_t dtype) {
+    static const float mean[3] = { 123.675f, 116.28f, 103.53f };
+    static const float std[3] = { 58.395f, 57.12f, 57.375f };
+
+    preprocess_config_default(config);
+    config->width = size;
+    config->height = size;
+    config->dtype = dtype;
+    if (dtype == PREPROCESS_FLOAT32) {
+        memcpy(config->mean, mean, sizeof(mean));
+        memcpy(config->std, std, sizeof(std));
+    }
+}
+
+// Largest difference between fused and reference output with the given kernel
+static double test_preprocess_diff(const preprocess_config_t* config, color_convert_isa_t isa,
+                                    const uint8_t* src, int width, int height,
+                                    void* fused, void* reference) {
+    preprocess_t pp;
+    if (preprocess_init(&pp, config) != 0) {
+        return INFINITY;
+    }
+    pp.vblend_f32 = preprocess_get_vblend_f32(isa);
+    pp.vblend_s8 = preprocess_get_vblend_s8(isa);
+
+    double max_diff = INFINITY;
+    if (preprocess_yuyv(&pp, src, width * 2, width, height, fused) == 0 &&
+        preprocess_yuyv_reference(config, src, width * 2, width, height, reference) == 0) {
+        size_t count = preprocess_tensor_size(config);
+        max_diff = 0.0;
+        if (config->dtype == PREPROCESS_INT8) {
+            for (size_t i = 0; i < count; ++i) {
+                double diff = fabs((double)((int8_t*)fused)[i] - ((int8_t*)reference)[i]);
+                max_diff = diff > max_diff ? diff : max_diff;
+            }
+        } else {
+            for (size_t i = 0; i < count / sizeof(float); ++i) {
+                double diff = fabs((double)((float*)fused)[i] - ((float*)reference)[i]);
+                max_diff = diff > max_diff ? diff : max_diff;
+            }
+        }
+    }
+    preprocess_fini(&pp);
+    return max_diff;
+}
+
+// Largest error of the fused output (identity normalization) against a
+// double-precision bilinear resize of the same RGB frame; pad pixels must
+// hold the pad value exactly
+static double test_preprocess_error(const uint8_t* src, int width, int height, int size) {
+    preprocess_config_t config;
+    preprocess_config_default(&config);
+    config.width = size;
+    config.height = size;
+    for (int c = 0; c < 3; ++c) {
+        config.std[c] = 1.0f;
+    }
+
+    preprocess_t pp;
+    uint8_t* rgb = malloc((size_t)width * height * 3);
+    float* tensor = malloc(preprocess_tensor_size(&config));
+    double max_error = INFINITY;
+    if (!rgb || !tensor || preprocess_init(&pp, &config) != 0) {
+        free(rgb);
+        free(tensor);
+        return max_error;
+    }
+
+    yuyv_to_rgb24(src, rgb, width, height);
+    if (preprocess_yuyv(&pp, src, width * 2, width, height, tensor) == 0) {
+        const preprocess_letterbox_t* lb = &pp.letterbox;
+        double ratio_x = (double)width / lb->resized_width;
+        double ratio_y = (double)height / lb->resized_height;
+        size_t plane_size = (size_t)size * size;
+        max_error = 0.0;
+
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                int rx = x - lb->pad_x;
+                int ry = y - lb->pad_y;
+                bool inside = rx >= 0 && rx < lb->resized_width && ry >= 0 && ry < lb->resized_height;
+                double sx = fmin(fmax((rx + 0.5) * ratio_x - 0.5, 0.0), width - 1.0);
+                double sy = fmin(fmax((ry + 0.5) * ratio_y - 0.5, 0.0), height - 1.0);
+                int x0 = sx < width - 1 ? (int)sx : width - 2;
+                int y0 = sy < height - 1 ? (int)sy : height - 2;
+                double fx = sx - x0;
+                double fy = sy - y0;
+
+                for (int c = 0; c < 3; ++c) {
+                    double expected = config.pad_value;
+                    if (inside) {
+                        const uint8_t* p = rgb + ((size_t)y0 * width + x0) * 3 + c;
+                        const uint8_t* q = p + (size_t)width * 3;
+                        double top = p[0] * (1.0 - fx) + p[3] * fx;
+                        double bottom = q[0] * (1.0 - fx) + q[3] * fx;
+                        expected = top * (1.0 - fy) + bottom * fy;
+                    }
+                    double error = fabs(tensor[c * plane_size + (size_t)y * size + x] - expected);
+                    if (!inside && error != 0.0) {
+                        error = INFINITY;
+                    }
+                    max_error = error > max_error ? error : max_error;
+                }
+            }
+        }
+    }
+
+    preprocess_fini(&pp);
+    free(rgb);
+    free(tensor);
+    return max_error;
+}
+
+// The same frame as YUYV for each resolution, or NULL
+static uint8_t* test_preprocess_frame(const test_resolution_t* res) {
+    uint8_t* rgb = malloc((size_t)res->width * res->height * 3);
+    uint8_t* yuyv = malloc((size_t)res->width * res->height * 2);
+    if (rgb && yuyv) {
+        test_make_rgb_yuyv(rgb, yuyv, res->width, res->height);
+    } else {
+        free(yuyv);
+        yuyv = NULL;
+    }
+    free(rgb);
+    return yuyv;
+}
+
+// Every available kernel's fused output against the multi-pass reference
+static int test_preprocess_kernels(void) {
+    preprocess_config_t config;
+    test_preprocess_config(&config, 640, PREPROCESS_FLOAT32);
+    preprocess_config_t config_s8;
+    test_preprocess_config(&config_s8, 416, PREPROCESS_INT8);
+    config_s8.bgr = true;
+
+    void* fused = malloc(preprocess_tensor_size(&config));
+    void* reference = malloc(preprocess_tensor_size(&config));
+    int result = fused && reference ? 0 : -1;
+
+    for (size_t r = 0; r < TEST_RESOLUTION_COUNT && result == 0; ++r) {
+        const test_resolution_t* res = &g_resolutions[r];
+        uint8_t* src = test_preprocess_frame(res);
+        if (!src) {
+            result = -1;
+            break;
+        }
+        for (int isa = 0; isa < COLOR_CONVERT_ISA_COUNT; ++isa) {
+            if (!preprocess_get_vblend_f32((color_convert_isa_t)isa) ||
+                color_convert_detect_isa() < (color_convert_isa_t)isa) {
+                continue;
+            }
+            double diff = test_preprocess_diff(&config, (color_convert_isa_t)isa, src,
+                                               res->width, res->height, fused, reference);
+            double diff_s8 = test_preprocess_diff(&config_s8, (color_convert_isa_t)isa, src,
+                                                  res->width, res->height, fused, reference);
+            bool ok = diff <= TEST_PREPROCESS_MAX_DIFF && diff_s8 <= 1.0;
+            printf("  %-10s %-6s vs multi-pass: float32 max diff %.2g, int8 max diff %.0f %s\n",
+                   res->name, color_convert_isa_name((color_convert_isa_t)isa), diff, diff_s8,
+                   ok ? "ok" : "FAILED");
+            if (!ok) {
+                result = -1;
+            }
+        }
+        free(src);
+    }
+
+    free(fused);
+    free(reference);
+    return result;
+}
+
+// The fused output against an ideal bilinear resize at every tensor size
+static int test_preprocess_bilinear(void) {
+    int result = 0;
+    for (size_t r = 0; r < TEST_RESOLUTION_COUNT && result == 0; ++r) {
+        const test_resolution_t* res = &g_resolutions[r];
+        uint8_t* src = test_preprocess_frame(res);
+        if (!src) {
+            return -1;
+        }
+        for (size_t s = 0; s < TEST_TENSOR_SIZE_COUNT; ++s) {
+            double error = test_preprocess_error(src, res->width, res->height, g_tensor_sizes[s]);
+            bool ok = error <= TEST_PREPROCESS_MAX_ERROR;
+            printf("  %-10s %-6d vs ideal bilinear: max error %.2f levels %s\n",
+                   res->name, g_tensor_sizes[s], error, ok ? "ok" : "FAILED");
+            if (!ok) {
+                result = -1;
+            }
+        }
+        free(src);
+    }
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "preprocess_kernels", test_preprocess_kernels },
+    { "preprocess_bilinear", test_preprocess_bilinear },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
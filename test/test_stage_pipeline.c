@@ -0,0 +1,143 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "stage_pipeline/stage_pipeline.h"
+
+#include "test_util.h"
+
+// Three sleeping stages shaped like preprocess -> inference -> postprocess;
+// the last one records the order frames leave in
+
+#define TEST_PIPELINE_FRAMES 40
+#define TEST_PIPELINE_STAGES 3
+#define TEST_PIPELINE_PERIOD_US 1500    // Live frames arrive faster than inference
+
+static const int g_pipeline_stage_us[TEST_PIPELINE_STAGES] = { 1000, 3000, 1000 };
+
+typedef struct {
+    uint32_t sequence[STAGE_PIPELINE_MAX_SLOTS];  // Frame number held by each slot
+    uint32_t last_sequence;                         // Last stage only
+    int out_of_order;
+} test_pipeline_ctx_t;
+
+static void test_sleep_us(int us) {
+    struct timespec ts = { .tv_sec = 0, .tv_nsec = (long)us * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+static int test_pipeline_stage(void* context, int slot, int stage) {
+    test_pipeline_ctx_t* ctx = (test_pipeline_ctx_t*)context;
+    test_sleep_us(g_pipeline_stage_us[stage]);
+    if (stage == TEST_PIPELINE_STAGES - 1) {
+        if (ctx->sequence[slot] <= ctx->last_sequence) {
+            ctx->out_of_order++;
+        }
+        ctx->last_sequence = ctx->sequence[slot];
+    }
+    return 0;
+}
+
+static int test_pipeline_stage0(void* context, int slot) {
+    return test_pipeline_stage(context, slot, 0);
+}
+
+static int test_pipeline_stage1(void* context, int slot) {
+    return test_pipeline_stage(context, slot, 1);
+}
+
+static int test_pipeline_stage2(void* context, int slot) {
+    return test_pipeline_stage(context, slot, 2);
+}
+
+// Frames leave in submit order; offline (period 0, acquire waits) every
+// frame gets through, live no frame waits for more than the frames ahead
+// of it in flight
+static int test_pipeline_run(const char* mode, int in_flight, stage_pipeline_policy_t policy,
+                             int period_us) {
+    static const stage_pipeline_stage_t stages[TEST_PIPELINE_STAGES] = {
+        { "preprocess", test_pipeline_stage0 },
+        { "inference", test_pipeline_stage1 },
+        { "postprocess", test_pipeline_stage2 },
+    };
+    test_pipeline_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    stage_pipeline_config_t config;
+    stage_pipeline_config_default(&config);
+    config.max_in_flight = in_flight;
+    config.policy = policy;
+    stage_pipeline_t pipeline;
+    if (stage_pipeline_init(&pipeline, &config, stages, TEST_PIPELINE_STAGES, &ctx) != 0) {
+        return -1;
+    }
+
+    bool offline = period_us == 0;
+    for (uint32_t frame = 1; frame <= TEST_PIPELINE_FRAMES; ++frame) {
+        int slot = stage_pipeline_acquire(&pipeline, offline);
+        if (slot >= 0) {
+            ctx.sequence[slot] = frame;
+            stage_pipeline_submit(&pipeline, slot);
+        }
+        if (!offline) {
+            test_sleep_us(period_us);
+        }
+    }
+    stage_pipeline_wait_idle(&pipeline);
+
+    stage_pipeline_stats_t stats;
+    stage_pipeline_take_stats(&pipeline, &stats);
+    stage_pipeline_fini(&pipeline);
+
+    printf("  %-8s %d in flight, %-12s %llu done, %llu dropped, latency max %.1f ms\n", mode,
+           in_flight, stage_pipeline_policy_name(policy), (unsigned long long)stats.completed,
+           (unsigned long long)(stats.dropped_oldest + stats.dropped_newest),
+           stats.latency_max_ns / 1e6);
+
+    int stage_sum_us = 0;
+    for (int i = 0; i < TEST_PIPELINE_STAGES; ++i) {
+        stage_sum_us += g_pipeline_stage_us[i];
+    }
+    if (ctx.out_of_order) {
+        fprintf(stderr, "%s: %d frames completed out of order\n", mode, ctx.out_of_order);
+        return -1;
+    }
+    if (offline && stats.completed != TEST_PIPELINE_FRAMES) {
+        fprintf(stderr, "%s: %llu of %d frames completed\n", mode,
+                (unsigned long long)stats.completed, TEST_PIPELINE_FRAMES);
+        return -1;
+    }
+    if (!offline && stats.latency_max_ns > (long long)(in_flight + 1) * stage_sum_us * 1000LL) {
+        fprintf(stderr, "%s: latency %.1f ms is not bounded by %d frames in flight\n", mode,
+                stats.latency_max_ns / 1e6, in_flight);
+        return -1;
+    }
+    return 0;
+}
+
+static int test_pipeline_offline(void) {
+    if (test_pipeline_run("offline", 1, STAGE_PIPELINE_DROP_OLDEST, 0) != 0 ||
+        test_pipeline_run("offline", 3, STAGE_PIPELINE_DROP_OLDEST, 0) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int test_pipeline_live(void) {
+    if (test_pipeline_run("live", 3, STAGE_PIPELINE_DROP_OLDEST, TEST_PIPELINE_PERIOD_US) != 0 ||
+        test_pipeline_run("live", 3, STAGE_PIPELINE_DROP_NEWEST, TEST_PIPELINE_PERIOD_US) != 0 ||
+        test_pipeline_run("live", 1, STAGE_PIPELINE_DROP_OLDEST, TEST_PIPELINE_PERIOD_US) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static const test_case_t g_cases[] = {
+    { "pipeline_offline", test_pipeline_offline },
+    { "pipeline_live", test_pipeline_live },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
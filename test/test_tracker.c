@@ -0,0 +1,325 @@
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "postprocess/postprocess.h"
+#include "tracker/tracker.h"
+
+#include "test_util.h"
+
+#define TEST_TRACK_OBJECTS 8
+#define TEST_TRACK_FRAMES 900          // 30 s at 30 fps
+#define TEST_TRACK_MISS_RATE 0.05f     // Detections the detector misses
+#define TEST_TRACK_FALSE_RATE 0.05f    // False detections per detector run
+#define TEST_TRACK_NOISE_PX 2.0f       // Edge jitter of detected boxes
+
+#define TEST_TRACK_PENDING 16
+
+// Detector every N frames, its result L frames later
+static const struct {
+    int interval;
+    int latency;
+} g_track_runs[] = { { 1, 0 }, { 3, 0 }, { 6, 0 }, { 10, 0 }, { 3, 4 }, { 6, 4 } };
+#define TEST_TRACK_RUN_COUNT (sizeof(g_track_runs) / sizeof(g_track_runs[0]))
+
+typedef struct {
+    float x, y, w, h;           // Top-left corner and size
+    float vx, vy;               // Pixels per frame
+} test_object_t;
+
+static float test_box_iou(float ax1, float ay1, float ax2, float ay2,
+                           float bx1, float by1, float bx2, float by2) {
+    float w = fminf(ax2, bx2) - fmaxf(ax1, bx1);
+    float h = fminf(ay2, by2) - fmaxf(ay1, by1);
+    if (w <= 0.0f || h <= 0.0f) {
+        return 0.0f;
+    }
+    float inter = w * h;
+    return inter / ((ax2 - ax1) * (ay2 - ay1) + (bx2 - bx1) * (by2 - by1) - inter);
+}
+
+static int test_compare_score(const void* a, const void* b) {
+    float x = ((const postprocess_detection_t*)a)->score;
+    float y = ((const postprocess_detection_t*)b)->score;
+    return (x < y) - (x > y);
+}
+
+// Slow objects bouncing inside a 640x480 frame
+static void test_scene_init(test_object_t* objects, unsigned* seed) {
+    for (int i = 0; i < TEST_TRACK_OBJECTS; ++i) {
+        test_object_t* o = &objects[i];
+        o->w = 40.0f + 80.0f * test_random_unit(seed);
+        o->h = 40.0f + 80.0f * test_random_unit(seed);
+        o->x = (640.0f - o->w) * test_random_unit(seed);
+        o->y = (480.0f - o->h) * test_random_unit(seed);
+        o->vx = 4.0f * test_random_unit(seed) - 2.0f;
+        o->vy = 4.0f * test_random_unit(seed) - 2.0f;
+    }
+}
+
+static void test_scene_step(test_object_t* objects) {
+    for (int i = 0; i < TEST_TRACK_OBJECTS; ++i) {
+        test_object_t* o = &objects[i];
+        o->x += o->vx;
+        o->y += o->vy;
+        if (o->x < 0.0f || o->x + o->w > 640.0f) {
+            o->vx = -o->vx;
+        }
+        if (o->y < 0.0f || o->y + o->h > 480.0f) {
+            o->vy = -o->vy;
+        }
+    }
+}
+
+static int test_scene_detect(const test_object_t* objects, postprocess_detection_t* dets,
+                              unsigned* seed) {
+    int count = 0;
+    for (int i = 0; i < TEST_TRACK_OBJECTS; ++i) {
+        if (test_random_unit(seed) < TEST_TRACK_MISS_RATE) {
+            continue;
+        }
+        const test_object_t* o = &objects[i];
+        postprocess_detection_t* d = &dets[count++];
+        d->x1 = o->x + TEST_TRACK_NOISE_PX * (2.0f * test_random_unit(seed) - 1.0f);
+        d->y1 = o->y + TEST_TRACK_NOISE_PX * (2.0f * test_random_unit(seed) - 1.0f);
+        d->x2 = o->x + o->w + TEST_TRACK_NOISE_PX * (2.0f * test_random_unit(seed) - 1.0f);
+        d->y2 = o->y + o->h + TEST_TRACK_NOISE_PX * (2.0f * test_random_unit(seed) - 1.0f);
+        d->score = 0.5f + 0.45f * test_random_unit(seed);
+        d->class_id = i % 3;
+    }
+    if (test_random_unit(seed) < TEST_TRACK_FALSE_RATE) {
+        postprocess_detection_t* d = &dets[count++];
+        d->x1 = 600.0f * test_random_unit(seed);
+        d->y1 = 440.0f * test_random_unit(seed);
+        d->x2 = d->x1 + 40.0f;
+        d->y2 = d->y1 + 40.0f;
+        d->score = 0.3f;
+        d->class_id = 0;
+    }
+    qsort(dets, (size_t)count, sizeof(dets[0]), test_compare_score);
+    return count;
+}
+
+// A detector run whose result has not arrived yet, as inference_node keeps it
+typedef struct {
+    int frame;
+    tracker_state_t state;
+    postprocess_detection_t dets[TEST_TRACK_OBJECTS + 1];
+    int count;
+} test_track_pending_t;
+
+typedef struct {
+    double recall;              // Object-frames covered by a reported track
+    double precision;           // Reported tracks that cover an object
+    double mean_iou;            // Of the covering tracks
+    int id_switches;            // Track id under an object changed
+    uint64_t tracker_switches;  // The tracker's own estimate
+    double us_per_frame;
+} test_track_result_t;
+
+// Every frame: move, predict, detect on every interval-th frame, then
+// match the reported tracks to the objects (IoU >= 0.5, greedy). A result
+// that arrives latency frames late is applied like inference_node does:
+// rewind to its frame, update, and predict forward again.
+static int test_track_run(int interval, int latency, test_track_result_t* result) {
+    tracker_config_t config;
+    tracker_config_default(&config);
+    tracker_t tracker;
+    if (tracker_init(&tracker, &config) != 0) {
+        return -1;
+    }
+
+    unsigned seed = 12345u;
+    test_object_t objects[TEST_TRACK_OBJECTS];
+    test_scene_init(objects, &seed);
+    test_track_pending_t* pending = calloc(TEST_TRACK_PENDING, sizeof(*pending));
+    if (!pending) {
+        tracker_fini(&tracker);
+        return -1;
+    }
+    int pending_count = 0;
+    tracker_output_t out[TRACKER_MAX_TRACKS];
+    uint32_t last_id[TEST_TRACK_OBJECTS] = { 0 };
+
+    long long covered = 0, reported = 0, matched = 0, tracker_ns = 0;
+    double iou_sum = 0.0;
+    memset(result, 0, sizeof(*result));
+    for (int frame = 0; frame < TEST_TRACK_FRAMES; ++frame) {
+        test_scene_step(objects);
+        long long t0 = test_now_ns();
+        tracker_predict(&tracker);
+        if (frame % interval == 0 && pending_count < TEST_TRACK_PENDING) {
+            test_track_pending_t* p = &pending[pending_count++];
+            p->frame = frame;
+            p->state = tracker.state;
+            tracker_ns += test_now_ns() - t0;
+            p->count = test_scene_detect(objects, p->dets, &seed);
+            t0 = test_now_ns();
+        }
+        while (pending_count > 0 && pending[0].frame + latency <= frame) {
+            int detected = pending[0].frame;
+            tracker.state = pending[0].state;
+            tracker_update(&tracker, pending[0].dets, pending[0].count);
+            memmove(&pending[0], &pending[1], (size_t)--pending_count * sizeof(pending[0]));
+            int next = 0;
+            for (int f = detected + 1; f <= frame; ++f) {
+                tracker_predict(&tracker);
+                if (next < pending_count && pending[next].frame == f) {
+                    pending[next++].state = tracker.state;
+                }
+            }
+        }
+        int n = tracker_output(&tracker, out, TRACKER_MAX_TRACKS);
+        tracker_ns += test_now_ns() - t0;
+
+        // The first second is warm-up: tracks need min_hits detections
+        if (frame < 30) {
+            continue;
+        }
+        bool taken[TRACKER_MAX_TRACKS] = { false };
+        for (int i = 0; i < TEST_TRACK_OBJECTS; ++i) {
+            const test_object_t* o = &objects[i];
+            int best = -1;
+            float best_iou = 0.5f;
+            for (int k = 0; k < n; ++k) {
+                float iou = test_box_iou(o->x, o->y, o->x + o->w, o->y + o->h,
+                                          out[k].x1, out[k].y1, out[k].x2, out[k].y2);
+                if (!taken[k] && iou >= best_iou) {
+                    best = k;
+                    best_iou = iou;
+                }
+            }
+            if (best < 0) {
+                continue;
+            }
+            taken[best] = true;
+            covered++;
+            iou_sum += best_iou;
+            if (last_id[i] && last_id[i] != out[best].id) {
+                result->id_switches++;
+            }
+            last_id[i] = out[best].id;
+        }
+        for (int k = 0; k < n; ++k) {
+            matched += taken[k];
+        }
+        reported += n;
+    }
+
+    long long object_frames = (long long)(TEST_TRACK_FRAMES - 30) * TEST_TRACK_OBJECTS;
+    result->recall = (double)covered / object_frames;
+    result->precision = reported ? (double)matched / reported : 0.0;
+    result->mean_iou = covered ? iou_sum / covered : 0.0;
+    result->tracker_switches = tracker.state.id_switches;
+    result->us_per_frame = tracker_ns / 1e3 / TEST_TRACK_FRAMES;
+    free(pending);
+    tracker_fini(&tracker);
+    return 0;
+}
+
+// Hungarian result against every permutation of small random matrices
+static int test_track_assign(void) {
+    tracker_config_t config;
+    tracker_config_default(&config);
+    tracker_t tracker;
+    if (tracker_init(&tracker, &config) != 0) {
+        return -1;
+    }
+
+    unsigned seed = 777u;
+    float cost[7 * 7];
+    int assignment[7];
+    int failures = 0;
+    for (int trial = 0; trial < 300; ++trial) {
+        int size = 1 + trial % 7;
+        for (int i = 0; i < size * size; ++i) {
+            // Coarse values so ties are common, like padded IoU costs
+            cost[i] = (float)(int)(test_random_unit(&seed) * 8.0f) / 8.0f;
+        }
+        double total = tracker_assign(&tracker, cost, size, assignment);
+
+        int perm[7];
+        for (int i = 0; i < size; ++i) {
+            perm[i] = i;
+        }
+        double best = DBL_MAX;
+        for (;;) {
+            double sum = 0.0;
+            for (int i = 0; i < size; ++i) {
+                sum += cost[i * size + perm[i]];
+            }
+            best = sum < best ? sum : best;
+
+            // Next permutation in lexicographic order
+            int k = size - 2;
+            while (k >= 0 && perm[k] > perm[k + 1]) {
+                k--;
+            }
+            if (k < 0) {
+                break;
+            }
+            int l = size - 1;
+            while (perm[l] < perm[k]) {
+                l--;
+            }
+            int t = perm[k];
+            perm[k] = perm[l];
+            perm[l] = t;
+            for (int a = k + 1, b = size - 1; a < b; ++a, --b) {
+                t = perm[a];
+                perm[a] = perm[b];
+                perm[b] = t;
+            }
+        }
+
+        bool seen[7] = { false };
+        for (int i = 0; i < size; ++i) {
+            if (assignment[i] < 0 || assignment[i] >= size || seen[assignment[i]]) {
+                best = -1.0;
+            } else {
+                seen[assignment[i]] = true;
+            }
+        }
+        if (fabs(total - best) > 1e-6) {
+            failures++;
+        }
+    }
+    tracker_fini(&tracker);
+
+    printf("  assignment vs brute force: %s (300 matrices up to 7x7)\n", failures ? "FAILED" : "ok");
+    return failures ? -1 : 0;
+}
+
+// Coasting between detector runs must keep slow objects covered, also when
+// the detector's results arrive late
+static int test_track_coverage(void) {
+    int result = 0;
+    for (size_t i = 0; i < TEST_TRACK_RUN_COUNT; ++i) {
+        int interval = g_track_runs[i].interval;
+        int latency = g_track_runs[i].latency;
+        test_track_result_t r;
+        if (test_track_run(interval, latency, &r) != 0) {
+            return -1;
+        }
+        bool ok = interval > 6 || (r.recall >= 0.9 && r.precision >= 0.9);
+        printf("  N=%-2d latency %d: recall %.3f, precision %.3f, mean IoU %.3f, %d id switches %s\n",
+               interval, latency, r.recall, r.precision, r.mean_iou, r.id_switches,
+               ok ? "ok" : "FAILED");
+        if (!ok) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+static const test_case_t g_cases[] = {
+    { "track_assign", test_track_assign },
+    { "track_coverage", test_track_coverage },
+};
+
+int main(void) {
+    return TEST_RUN(g_cases);
+}
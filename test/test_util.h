@@ -0,0 +1,54 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Shared by the unit tests: each test executable is a table of cases, every
+// case returns 0 on success and -1 (after printing why) on failure. The
+// executable fails if any case did, so CTest reports it.
+
+typedef struct {
+    const char* name;
+    int (*run)(void);
+} test_case_t;
+
+// Deterministic noise, the same bytes for the same seed on every run
+static inline void test_fill_random(uint8_t* data, size_t size, unsigned seed) {
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        data[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+// Uniform in [0, 1) from the same generator
+static inline float test_random_unit(unsigned* seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return (float)((*seed >> 8) & 0xffff) / 65536.0f;
+}
+
+static inline long long test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline int test_run(const test_case_t* cases, size_t count) {
+    size_t failed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        printf("%s\n", cases[i].name);
+        fflush(stdout);
+        if (cases[i].run() != 0) {
+            fprintf(stderr, "%s failed\n", cases[i].name);
+            failed++;
+        }
+    }
+    printf("%zu of %zu passed\n", count - failed, count);
+    return failed ? 1 : 0;
+}
+
+#define TEST_RUN(cases) test_run(cases, sizeof(cases) / sizeof(cases[0]))
+
+#endif // TEST_UTIL_H